@@ -0,0 +1,309 @@
+/**
+ * @file llskinning_bench.cpp
+ * @brief Times the software avatar skinning functions against each other
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+
+// viewer includes
+#include "llviewerskinning.h"
+
+// linden library includes
+#include "llendianswizzle.h"
+#include "llfile.h"
+#include "llmath.h"
+#include "llprocessor.h"
+#include "llquaternion.h"
+#include "llrand.h"
+#include "lltimer.h"
+#include "m3math.h"
+#include "m4math.h"
+#include "v3math.h"
+#include "v4math.h"
+
+#include <iostream>
+#include <vector>
+
+// Usage: llskinning_bench [character directory] [iterations]
+//
+// Skins each avatar base mesh (the .llm files in newview/character) with
+// every skinning function this CPU can run, checks the results against
+// ll_skin_original() and prints the time per mesh.  Joint matrices are made
+// up, the time only depends on the mesh.  Returns non-zero if a function
+// disagrees with the original.
+
+// The base meshes LLVOAvatar skins every frame, lower LODs have fewer vertices
+static const char* MESH_FILES[] =
+{
+	"avatar_upper_body.llm",
+	"avatar_lower_body.llm",
+	"avatar_head.llm",
+	"avatar_skirt.llm",
+	"avatar_hair.llm",
+	"avatar_eyelashes.llm"
+};
+
+// Same layout as LLDrawPoolAvatar::VERTEX_DATA_MASK: position, normal,
+// texcoord, weight and cloth weight
+static const S32 AVATAR_VERTEX_STRIDE = 12 + 12 + 8 + 4 + 16;
+
+static const F32 MAX_ERROR = 0.0001f;
+
+struct BenchMesh
+{
+	std::string mName;
+	std::vector<LLVector3> mCoords;
+	std::vector<LLVector3> mNormals;
+	std::vector<F32> mWeights;
+	std::vector<LLMatrix4> mWorldMatrices;
+	std::vector<LLVector3> mPivots;
+};
+
+struct BenchFunc
+{
+	const char* mName;
+	skinning_func_t mFunc;
+	bool mSupported;
+};
+
+// Reads the vertex data of a binary .llm file the way
+// LLPolyMeshSharedData::loadMesh() does.  Returns false for meshes without
+// weights.
+static bool load_mesh(const std::string& filename, BenchMesh& mesh)
+{
+	LLFILE* fp = LLFile::fopen(filename, "rb");	/* Flawfinder: ignore */
+	if (!fp)
+	{
+		std::cerr << "Can't open " << filename << std::endl;
+		return false;
+	}
+	std::vector<U8> data;
+	U8 buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + read);
+	}
+	fclose(fp);
+
+	// Header, has weights, has detail texcoords, position, rotation,
+	// rotation order, scale, vertex count
+	const size_t vertex_count_offset = 24 + 1 + 1 + 12 + 12 + 1 + 12;
+	if (data.size() < vertex_count_offset + 2 || !data[24])
+	{
+		return false;
+	}
+	bool has_detail_texcoords = data[25] != 0;
+	U16 num_vertices;
+	memcpy(&num_vertices, &data[vertex_count_offset], sizeof(U16));	/* Flawfinder: ignore */
+	llendianswizzle(&num_vertices, sizeof(U16), 1);
+
+	size_t offset = vertex_count_offset + 2;
+	size_t coords_offset = offset;
+	offset += num_vertices * sizeof(LLVector3);
+	size_t normals_offset = offset;
+	offset += num_vertices * sizeof(LLVector3);
+	offset += num_vertices * sizeof(LLVector3);		// binormals
+	offset += num_vertices * 2 * sizeof(F32);		// texcoords
+	if (has_detail_texcoords)
+	{
+		offset += num_vertices * 2 * sizeof(F32);
+	}
+	size_t weights_offset = offset;
+	offset += num_vertices * sizeof(F32);
+	if (data.size() < offset)
+	{
+		std::cerr << filename << " is truncated" << std::endl;
+		return false;
+	}
+
+	mesh.mCoords.resize(num_vertices);
+	mesh.mNormals.resize(num_vertices);
+	mesh.mWeights.resize(num_vertices);
+	memcpy(&mesh.mCoords[0], &data[coords_offset], num_vertices * sizeof(LLVector3));	/* Flawfinder: ignore */
+	memcpy(&mesh.mNormals[0], &data[normals_offset], num_vertices * sizeof(LLVector3));	/* Flawfinder: ignore */
+	memcpy(&mesh.mWeights[0], &data[weights_offset], num_vertices * sizeof(F32));	/* Flawfinder: ignore */
+	llendianswizzle(&mesh.mCoords[0], sizeof(F32), 3 * num_vertices);
+	llendianswizzle(&mesh.mNormals[0], sizeof(F32), 3 * num_vertices);
+	llendianswizzle(&mesh.mWeights[0], sizeof(F32), num_vertices);
+
+	// Enough joint entries for the highest weight and the one after it
+	F32 max_weight = 0.f;
+	for (U32 i = 0; i < num_vertices; ++i)
+	{
+		max_weight = llmax(max_weight, mesh.mWeights[i]);
+	}
+	S32 num_joints = llmin(llfloor(max_weight) + 2, LL_MAX_SKIN_JOINT_ENTRIES);
+	for (S32 j = 0; j < num_joints; ++j)
+	{
+		LLQuaternion rot;
+		rot.setAngleAxis(ll_frand(F_TWO_PI), ll_frand() - 0.5f, ll_frand() - 0.5f, ll_frand() - 0.5f);
+		LLVector4 pos(ll_frand() - 0.5f, ll_frand() - 0.5f, ll_frand(2.f), 1.f);
+		mesh.mWorldMatrices.push_back(LLMatrix4(rot, pos));
+		mesh.mPivots.push_back(LLVector3(ll_frand() - 0.5f, ll_frand() - 0.5f, ll_frand() - 0.5f));
+	}
+	return true;
+}
+
+static void setup_data(BenchMesh& mesh, std::vector<U8>& out, S32 stride, LLSkinningData& data)
+{
+	data.mNumJoints = (S32)mesh.mWorldMatrices.size();
+	for (S32 j = 0; j < data.mNumJoints; ++j)
+	{
+		data.mWorldMatrices[j] = &mesh.mWorldMatrices[j];
+		data.mPivots[j] = mesh.mPivots[j];
+	}
+	data.mNumVertices = (U32)mesh.mCoords.size();
+	data.mWeights = &mesh.mWeights[0];
+	data.mCoords = &mesh.mCoords[0];
+	data.mNormals = &mesh.mNormals[0];
+
+	// Positions and normals interleaved like a vertex buffer, or packed
+	// when the stride is just a position
+	out.assign(data.mNumVertices * stride * 2, 0);
+	data.mOutVertices = (LLVector3*)&out[0];
+	data.mOutVertices.setStride(stride);
+	if (stride > (S32)sizeof(LLVector3))
+	{
+		data.mOutNormals = (LLVector3*)&out[sizeof(LLVector3)];
+	}
+	else
+	{
+		data.mOutNormals = (LLVector3*)&out[data.mNumVertices * stride];
+	}
+	data.mOutNormals.setStride(stride);
+}
+
+static F32 max_difference(LLSkinningData& a, LLSkinningData& b)
+{
+	F32 max_diff = 0.f;
+	for (U32 i = 0; i < a.mNumVertices; ++i)
+	{
+		for (S32 axis = 0; axis < 3; ++axis)
+		{
+			max_diff = llmax(max_diff, fabsf(a.mOutVertices[i].mV[axis] - b.mOutVertices[i].mV[axis]));
+			max_diff = llmax(max_diff, fabsf(a.mOutNormals[i].mV[axis] - b.mOutNormals[i].mV[axis]));
+		}
+	}
+	return max_diff;
+}
+
+int main(int argc, char** argv)
+{
+	std::string dir = argc > 1 ? argv[1] : "character";
+	S32 iterations = argc > 2 ? atoi(argv[2]) : 1000;
+	iterations = llmax(iterations, 1);
+
+	LLProcessorInfo proc;
+	BenchFunc funcs[] =
+	{
+		{ "original",	&ll_skin_original,		true },
+		{ "vectorized",	&ll_skin_vectorized,	true },
+		{ "sse",		&ll_skin_sse,			proc.hasSSE() },
+		{ "sse2",		&ll_skin_sse2,			proc.hasSSE2() },
+		{ "avx2",		&ll_skin_avx2,			proc.hasAVX2() && proc.hasFMA() }
+	};
+	const S32 num_funcs = sizeof(funcs) / sizeof(funcs[0]);
+
+	std::vector<BenchMesh> meshes;
+	for (size_t i = 0; i < sizeof(MESH_FILES) / sizeof(MESH_FILES[0]); ++i)
+	{
+		BenchMesh mesh;
+		mesh.mName = MESH_FILES[i];
+		if (load_mesh(dir + "/" + mesh.mName, mesh))
+		{
+			meshes.push_back(mesh);
+		}
+	}
+	if (meshes.empty())
+	{
+		std::cerr << "No avatar meshes found in " << dir << std::endl;
+		return 1;
+	}
+
+	bool ok = true;
+	const S32 strides[] = { AVATAR_VERTEX_STRIDE, sizeof(LLVector3) };
+	for (S32 s = 0; s < 2; ++s)
+	{
+		std::cout << (s == 0 ? "Interleaved" : "Packed") << " output, microseconds per mesh, "
+				  << iterations << " iterations" << std::endl;
+
+		std::vector<F64> totals(num_funcs, 0.0);
+		for (size_t m = 0; m < meshes.size(); ++m)
+		{
+			BenchMesh& mesh = meshes[m];
+			std::cout << "  " << mesh.mName << " (" << mesh.mCoords.size() << " vertices)";
+
+			std::vector<U8> reference_out;
+			LLSkinningData reference;
+			setup_data(mesh, reference_out, strides[s], reference);
+			ll_skin_original(reference);
+
+			for (S32 f = 0; f < num_funcs; ++f)
+			{
+				if (!funcs[f].mSupported)
+				{
+					continue;
+				}
+
+				std::vector<U8> out;
+				LLSkinningData data;
+				setup_data(mesh, out, strides[s], data);
+
+				LLTimer timer;
+				for (S32 i = 0; i < iterations; ++i)
+				{
+					funcs[f].mFunc(data);
+				}
+				F64 elapsed = timer.getElapsedTimeF64() * 1000000.0 / iterations;
+				totals[f] += elapsed;
+
+				F32 diff = max_difference(reference, data);
+				std::cout << "  " << funcs[f].mName << " " << elapsed;
+				if (diff > MAX_ERROR)
+				{
+					std::cout << " (off by " << diff << ")";
+					ok = false;
+				}
+			}
+			std::cout << std::endl;
+		}
+
+		std::cout << "  all meshes";
+		for (S32 f = 0; f < num_funcs; ++f)
+		{
+			if (funcs[f].mSupported)
+			{
+				std::cout << "  " << funcs[f].mName << " " << totals[f];
+			}
+		}
+		std::cout << std::endl;
+	}
+
+	if (!ok)
+	{
+		std::cerr << "Skinning results differ from ll_skin_original()" << std::endl;
+		return 1;
+	}
+	return 0;
+}
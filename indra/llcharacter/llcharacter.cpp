@@ -187,16 +187,41 @@ void LLCharacter::updateMotions(e_update_t update_type)
 	else
 	{
 		LLFastTimer t(FTM_UPDATE_ANIMATION);
-		// unpause if the number of outstanding pause requests has dropped to the initial one
-		if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
+		if (startMotionUpdate())
 		{
-			mMotionController.unpauseAllMotions();
+			evaluateMotions(update_type);
 		}
-		bool force_update = (update_type == FORCE_UPDATE);
-		mMotionController.updateMotions(force_update);
 	}
 }
 
+//-----------------------------------------------------------------------------
+// prepareMotions()
+//-----------------------------------------------------------------------------
+bool LLCharacter::prepareMotions()
+{
+	LLFastTimer t(FTM_UPDATE_ANIMATION);
+	return startMotionUpdate();
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLCharacter::evaluateMotions(e_update_t update_type)
+{
+	bool force_update = (update_type == FORCE_UPDATE);
+	mMotionController.evaluateMotions(force_update);
+}
+
+bool LLCharacter::startMotionUpdate()
+{
+	// unpause if the number of outstanding pause requests has dropped to the initial one
+	if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
+	{
+		mMotionController.unpauseAllMotions();
+	}
+	return mMotionController.prepareMotions();
+}
+
 
 //-----------------------------------------------------------------------------
 // deactivateAllMotions()
@@ -162,6 +162,13 @@ public:
 	enum e_update_t { NORMAL_UPDATE, HIDDEN_UPDATE, FORCE_UPDATE };
 	void updateMotions(e_update_t update_type);
 
+	// updateMotions() for NORMAL_UPDATE or FORCE_UPDATE in two steps, see
+	// LLMotionController::prepareMotions().  prepareMotions() must be called
+	// on the main thread; evaluateMotions() has no fast timers, so it may
+	// run on a worker thread if updateVisualParams() is deferred meanwhile.
+	bool prepareMotions();
+	void evaluateMotions(e_update_t update_type);
+
 	LLAnimPauseRequest requestPause();
 	BOOL areAnimationsPaused() const { return mMotionController.isPaused(); }
 	void setAnimTimeFactor(F32 factor) { mMotionController.setTimeFactor(factor); }
@@ -281,6 +288,8 @@ protected:
 
 
 private:
+	bool startMotionUpdate();
+
 	// visual parameter stuff
 	typedef std::map<S32, LLVisualParam *> 		visual_param_index_map_t;
 	typedef std::map<char *, LLVisualParam *> 	visual_param_name_map_t;
@@ -269,7 +269,7 @@ void LLHeadRotMotion::onDeactivate()
 // LLEyeMotion()
 // Class Constructor
 //-----------------------------------------------------------------------------
-LLEyeMotion::LLEyeMotion(const LLUUID &id) : LLMotion(id)
+LLEyeMotion::LLEyeMotion(const LLUUID &id) : LLMotion(id), mRandom(ll_rand())
 {
 	mCharacter = NULL;
 	mEyeJitterTime = 0.f;
@@ -360,31 +360,31 @@ BOOL LLEyeMotion::onUpdate(F32 time, U8* joint_mask)
 	//calculate jitter
 	if (mEyeJitterTimer.getElapsedTimeF32() > mEyeJitterTime)
 	{
-		mEyeJitterTime = EYE_JITTER_MIN_TIME + ll_frand(EYE_JITTER_MAX_TIME - EYE_JITTER_MIN_TIME);
-		mEyeJitterYaw = (ll_frand(2.f) - 1.f) * EYE_JITTER_MAX_YAW;
-		mEyeJitterPitch = (ll_frand(2.f) - 1.f) * EYE_JITTER_MAX_PITCH;
+		mEyeJitterTime = EYE_JITTER_MIN_TIME + randFloat(EYE_JITTER_MAX_TIME - EYE_JITTER_MIN_TIME);
+		mEyeJitterYaw = (randFloat(2.f) - 1.f) * EYE_JITTER_MAX_YAW;
+		mEyeJitterPitch = (randFloat(2.f) - 1.f) * EYE_JITTER_MAX_PITCH;
 		// make sure lookaway time count gets updated, because we're resetting the timer
 		mEyeLookAwayTime -= llmax(0.f, mEyeJitterTimer.getElapsedTimeF32());
 		mEyeJitterTimer.reset();
 	} 
 	else if (mEyeJitterTimer.getElapsedTimeF32() > mEyeLookAwayTime)
 	{
-		if (ll_frand() > 0.1f)
+		if (randFloat() > 0.1f)
 		{
 			// blink while moving eyes some percentage of the time
 			mEyeBlinkTime = mEyeBlinkTimer.getElapsedTimeF32();
 		}
 		if (mEyeLookAwayYaw == 0.f && mEyeLookAwayPitch == 0.f)
 		{
-			mEyeLookAwayYaw = (ll_frand(2.f) - 1.f) * EYE_LOOK_AWAY_MAX_YAW;
-			mEyeLookAwayPitch = (ll_frand(2.f) - 1.f) * EYE_LOOK_AWAY_MAX_PITCH;
-			mEyeLookAwayTime = EYE_LOOK_BACK_MIN_TIME + ll_frand(EYE_LOOK_BACK_MAX_TIME - EYE_LOOK_BACK_MIN_TIME);
+			mEyeLookAwayYaw = (randFloat(2.f) - 1.f) * EYE_LOOK_AWAY_MAX_YAW;
+			mEyeLookAwayPitch = (randFloat(2.f) - 1.f) * EYE_LOOK_AWAY_MAX_PITCH;
+			mEyeLookAwayTime = EYE_LOOK_BACK_MIN_TIME + randFloat(EYE_LOOK_BACK_MAX_TIME - EYE_LOOK_BACK_MIN_TIME);
 		}
 		else
 		{
 			mEyeLookAwayYaw = 0.f;
 			mEyeLookAwayPitch = 0.f;
-			mEyeLookAwayTime = EYE_LOOK_AWAY_MIN_TIME + ll_frand(EYE_LOOK_AWAY_MAX_TIME - EYE_LOOK_AWAY_MIN_TIME);
+			mEyeLookAwayTime = EYE_LOOK_AWAY_MIN_TIME + randFloat(EYE_LOOK_AWAY_MAX_TIME - EYE_LOOK_AWAY_MIN_TIME);
 		}
 	}
 
@@ -423,7 +423,7 @@ BOOL LLEyeMotion::onUpdate(F32 time, U8* joint_mask)
 			if (rightEyeBlinkMorph == 0.f)
 			{
 				mEyesClosed = FALSE;
-				mEyeBlinkTime = EYE_BLINK_MIN_TIME + ll_frand(EYE_BLINK_MAX_TIME - EYE_BLINK_MIN_TIME);
+				mEyeBlinkTime = EYE_BLINK_MIN_TIME + randFloat(EYE_BLINK_MAX_TIME - EYE_BLINK_MIN_TIME);
 				mEyeBlinkTimer.reset();
 			}
 		}
@@ -511,6 +511,19 @@ BOOL LLEyeMotion::onUpdate(F32 time, U8* joint_mask)
 }
 
 
+//-----------------------------------------------------------------------------
+// LLEyeMotion::randFloat()
+//-----------------------------------------------------------------------------
+F32 LLEyeMotion::randFloat(F32 val)
+{
+	// Same clamping as ll_frand(val)
+	F32 rv = (F32)mRandom();
+	if (!((rv >= 0.f) && (rv < 1.f))) rv = fmod(rv, 1.f);
+	rv *= val;
+	if (rv >= val) return 0.f;
+	return rv;
+}
+
 //-----------------------------------------------------------------------------
 // LLEyeMotion::onDeactivate()
 //-----------------------------------------------------------------------------
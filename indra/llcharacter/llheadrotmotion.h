@@ -32,6 +32,7 @@
 //-----------------------------------------------------------------------------
 #include "llmotion.h"
 #include "llframetimer.h"
+#include "llrand.h"
 
 #define MIN_REQUIRED_PIXEL_AREA_HEAD_ROT 500.f;
 #define MIN_REQUIRED_PIXEL_AREA_EYE 25000.f;
@@ -184,6 +185,11 @@ public:
 	// called when a motion is deactivated
 	virtual void onDeactivate();
 
+private:
+	// Like ll_frand(), from mRandom, since motions may be updated on
+	// worker threads and the global generator isn't thread safe
+	F32 randFloat(F32 val = 1.f);
+
 public:
 	//-------------------------------------------------------------------------
 	// joint states to be animated
@@ -206,6 +212,8 @@ public:
 	LLFrameTimer		mEyeBlinkTimer;
 	F32					mEyeBlinkTime;
 	BOOL				mEyesClosed;
+
+	LLRandLagFib607		mRandom;
 };
 
 #endif // LL_LLHEADROTMOTION_H
@@ -94,7 +94,7 @@ public:
 	typedef std::list<LLJoint*> child_list_t;
 	child_list_t mChildren;
 
-	// debug statics
+	// debug statics, approximate when avatars are animated on worker threads
 	static S32		sNumTouches;
 	static S32		sNumUpdates;
 
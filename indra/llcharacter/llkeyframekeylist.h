@@ -0,0 +1,117 @@
+/**
+ * @file llkeyframekeylist.h
+ * @brief Sorted key storage for LLKeyframeMotion curves.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLKEYFRAMEKEYLIST_H
+#define LL_LLKEYFRAMEKEYLIST_H
+
+#include <algorithm>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// class LLKeyframeKeyList
+//
+// The keys of one animation curve, in one array sorted by time.  KEY needs
+// an F32 mTime.  Keys are add()ed in file order, then sort() puts them in
+// time order, keeping the last one added for any time.
+//
+// Curves are shared by every motion playing the same animation, so the
+// lookup state lives with the caller: find() takes a cursor, the key index
+// it found last time.  Animations are played forward a frame at a time, so
+// the answer is nearly always at the cursor or just after it, and the
+// binary search is only needed after a loop or a jump.
+//-----------------------------------------------------------------------------
+template <class KEY>
+class LLKeyframeKeyList
+{
+public:
+	typedef typename std::vector<KEY>::const_iterator const_iterator;
+
+	void add(const KEY& key)		{ mKeys.push_back(key); }
+	void clear()					{ mKeys.clear(); }
+
+	void sort()
+	{
+		std::stable_sort(mKeys.begin(), mKeys.end(), timeLess);
+
+		// Keep the last key for each time
+		typename std::vector<KEY>::iterator out = mKeys.begin();
+		for (typename std::vector<KEY>::iterator it = mKeys.begin(); it != mKeys.end(); ++it)
+		{
+			if (it + 1 != mKeys.end() && (it + 1)->mTime == it->mTime)
+			{
+				continue;
+			}
+			*out++ = *it;
+		}
+		mKeys.erase(out, mKeys.end());
+	}
+
+	bool empty() const						{ return mKeys.empty(); }
+	S32 size() const						{ return (S32)mKeys.size(); }
+	const KEY& operator[](S32 i) const		{ return mKeys[i]; }
+	const KEY& back() const					{ return mKeys.back(); }
+	const_iterator begin() const			{ return mKeys.begin(); }
+	const_iterator end() const				{ return mKeys.end(); }
+
+	// Index of the first key at or after time, size() if there is none.
+	S32 find(F32 time) const
+	{
+		return (S32)(std::lower_bound(mKeys.begin(), mKeys.end(), time, keyBefore) - mKeys.begin());
+	}
+
+	// Same as find(time), checking the cursor and the key after it first.
+	// cursor is set to the result.
+	S32 find(F32 time, S32& cursor) const
+	{
+		const S32 count = size();
+		for (S32 i = llmax(cursor, 0), last = llmin(cursor + 1, count); i <= last; ++i)
+		{
+			if ((i == count || !(mKeys[i].mTime < time))
+				&& (i == 0 || mKeys[i - 1].mTime < time))
+			{
+				cursor = i;
+				return i;
+			}
+		}
+		cursor = find(time);
+		return cursor;
+	}
+
+private:
+	static bool timeLess(const KEY& a, const KEY& b)
+	{
+		return a.mTime < b.mTime;
+	}
+
+	static bool keyBefore(const KEY& key, F32 time)
+	{
+		return key.mTime < time;
+	}
+
+	std::vector<KEY> mKeys;
+};
+
+#endif // LL_LLKEYFRAMEKEYLIST_H
@@ -139,16 +139,25 @@ LLKeyframeMotion::ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
 // ScaleCurve::~ScaleCurve()
 //-----------------------------------------------------------------------------
-LLKeyframeMotion::ScaleCurve::~ScaleCurve() 
+LLKeyframeMotion::ScaleCurve::~ScaleCurve()
 {
 	mKeys.clear();
 	mNumKeys = 0;
 }
 
 //-----------------------------------------------------------------------------
-// getValue()
+// ScaleCurve::getValue()
 //-----------------------------------------------------------------------------
 LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = mKeys.find(time);
+	return getValue(time, duration, cursor);
+}
+
+//-----------------------------------------------------------------------------
+// ScaleCurve::getValue()
+//-----------------------------------------------------------------------------
+LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLVector3 value;
 
@@ -158,33 +167,24 @@ LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
 		return value;
 	}
 	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+	S32 right = mKeys.find(time, cursor);
+	if (right == mKeys.size())
 	{
 		// Past last key
-		--right;
-		value = right->second.mScale;
+		value = mKeys.back().mScale;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+	else if (right == 0 || mKeys[right].mTime == time)
 	{
 		// Before first key or exactly on a key
-		value = right->second.mScale;
+		value = mKeys[right].mScale;
 	}
 	else
 	{
 		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		ScaleKey& scale_before = left->second;
-		ScaleKey& scale_after = right->second;
-		if (right == mKeys.end())
-		{
-			scale_after = mLoopInKey;
-			index_after = duration;
-		}
+		const ScaleKey& scale_before = mKeys[right - 1];
+		const ScaleKey& scale_after = mKeys[right];
 
-		F32 u = (time - index_before) / (index_after - index_before);
+		F32 u = (time - scale_before.mTime) / (scale_after.mTime - scale_before.mTime);
 		value = interp(u, scale_before, scale_after);
 	}
 	return value;
@@ -193,7 +193,7 @@ LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey& after)
+LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, const ScaleKey& before, const ScaleKey& after)
 {
 	switch (mInterpolationType)
 	{
@@ -229,6 +229,15 @@ LLKeyframeMotion::RotationCurve::~RotationCurve()
 // RotationCurve::getValue()
 //-----------------------------------------------------------------------------
 LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = mKeys.find(time);
+	return getValue(time, duration, cursor);
+}
+
+//-----------------------------------------------------------------------------
+// RotationCurve::getValue()
+//-----------------------------------------------------------------------------
+LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLQuaternion value;
 
@@ -238,33 +247,24 @@ LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
 		return value;
 	}
 	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+	S32 right = mKeys.find(time, cursor);
+	if (right == mKeys.size())
 	{
 		// Past last key
-		--right;
-		value = right->second.mRotation;
+		value = mKeys.back().mRotation;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+	else if (right == 0 || mKeys[right].mTime == time)
 	{
 		// Before first key or exactly on a key
-		value = right->second.mRotation;
+		value = mKeys[right].mRotation;
 	}
 	else
 	{
 		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		RotationKey& rot_before = left->second;
-		RotationKey& rot_after = right->second;
-		if (right == mKeys.end())
-		{
-			rot_after = mLoopInKey;
-			index_after = duration;
-		}
+		const RotationKey& rot_before = mKeys[right - 1];
+		const RotationKey& rot_after = mKeys[right];
 
-		F32 u = (time - index_before) / (index_after - index_before);
+		F32 u = (time - rot_before.mTime) / (rot_after.mTime - rot_before.mTime);
 		value = interp(u, rot_before, rot_after);
 	}
 	return value;
@@ -273,7 +273,7 @@ LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before, RotationKey& after)
+LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, const RotationKey& before, const RotationKey& after)
 {
 	switch (mInterpolationType)
 	{
@@ -310,6 +310,15 @@ LLKeyframeMotion::PositionCurve::~PositionCurve()
 // PositionCurve::getValue()
 //-----------------------------------------------------------------------------
 LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = mKeys.find(time);
+	return getValue(time, duration, cursor);
+}
+
+//-----------------------------------------------------------------------------
+// PositionCurve::getValue()
+//-----------------------------------------------------------------------------
+LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLVector3 value;
 
@@ -319,33 +328,24 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 		return value;
 	}
 	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+	S32 right = mKeys.find(time, cursor);
+	if (right == mKeys.size())
 	{
 		// Past last key
-		--right;
-		value = right->second.mPosition;
+		value = mKeys.back().mPosition;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+	else if (right == 0 || mKeys[right].mTime == time)
 	{
 		// Before first key or exactly on a key
-		value = right->second.mPosition;
+		value = mKeys[right].mPosition;
 	}
 	else
 	{
 		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		PositionKey& pos_before = left->second;
-		PositionKey& pos_after = right->second;
-		if (right == mKeys.end())
-		{
-			pos_after = mLoopInKey;
-			index_after = duration;
-		}
+		const PositionKey& pos_before = mKeys[right - 1];
+		const PositionKey& pos_after = mKeys[right];
 
-		F32 u = (time - index_before) / (index_after - index_before);
+		F32 u = (time - pos_before.mTime) / (pos_after.mTime - pos_before.mTime);
 		value = interp(u, pos_before, pos_after);
 	}
 
@@ -357,7 +357,7 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, PositionKey& after)
+LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, const PositionKey& before, const PositionKey& after)
 {
 	switch (mInterpolationType)
 	{
@@ -380,7 +380,7 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
 //-----------------------------------------------------------------------------
 // JointMotion::update()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
+void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration, KeyCursors& cursors)
 {
 	// this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't 
 	// managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
@@ -396,7 +396,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
 	{
-		joint_state->setScale( mScaleCurve.getValue( time, duration ) );
+		joint_state->setScale( mScaleCurve.getValue( time, duration, cursors.mScale ) );
 	}
 
 	//-------------------------------------------------------------------------
@@ -404,7 +404,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
 	{
-		joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+		joint_state->setRotation( mRotationCurve.getValue( time, duration, cursors.mRotation ) );
 	}
 
 	//-------------------------------------------------------------------------
@@ -412,7 +412,20 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
 	{
-		joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+		joint_state->setPosition( mPositionCurve.getValue( time, duration, cursors.mPosition ) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+// JointMotionList::update()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::JointMotionList::update(LLPointer<LLJointState>* joint_states, KeyCursors* cursors, F32 time)
+{
+	const S32 count = (S32)mJointMotionArray.size();
+	JointMotion* const* joint_motions = count ? &mJointMotionArray[0] : NULL;
+	for (S32 i = 0; i < count; ++i)
+	{
+		joint_motions[i]->update(joint_states[i], time, mDuration, cursors[i]);
 	}
 }
 
@@ -721,11 +734,13 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
 	llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
-	for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
+	if (mKeyCursors.size() != mJointMotionList->getNumJointMotions())
+	{
+		mKeyCursors.resize(mJointMotionList->getNumJointMotions());
+	}
+	if (!mKeyCursors.empty())
 	{
-		mJointMotionList->getJointMotion(i)->update(mJointStates[i],
-													  time, 
-													  mJointMotionList->mDuration );
+		mJointMotionList->update(&mJointStates[0], &mKeyCursors[0], time);
 	}
 
 	LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
@@ -1497,8 +1512,9 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 
-			rCurve->mKeys[time] = rot_key;
+			rCurve->mKeys.add(rot_key);
 		}
+		rCurve->mKeys.sort();
 
 		//---------------------------------------------------------------------
 		// scan position curve header
@@ -1576,13 +1592,14 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 			
-			pCurve->mKeys[pos_key.mTime] = pos_key;
+			pCurve->mKeys.add(pos_key);
 
 			if (is_pelvis)
 			{
 				mJointMotionList->mPelvisBBox.addPoint(pos_key.mPosition);
 			}
 		}
+		pCurve->mKeys.sort();
 
 		joint_motion->mUsage = joint_state->getUsage();
 	}
@@ -1827,10 +1844,10 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		success &= dp.packS32(joint_motionp->mPriority, "joint_priority");
 		success &= dp.packS32(joint_motionp->mRotationCurve.mNumKeys, "num_rot_keys");
 
-		for (RotationCurve::key_map_t::iterator iter = joint_motionp->mRotationCurve.mKeys.begin();
+		for (RotationCurve::key_list_t::const_iterator iter = joint_motionp->mRotationCurve.mKeys.begin();
 			 iter != joint_motionp->mRotationCurve.mKeys.end(); ++iter)
 		{
-			RotationKey& rot_key = iter->second;
+			const RotationKey& rot_key = *iter;
 			U16 time_short = F32_to_U16(rot_key.mTime, 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
@@ -1847,10 +1864,10 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		}
 
 		success &= dp.packS32(joint_motionp->mPositionCurve.mNumKeys, "num_pos_keys");
-		for (PositionCurve::key_map_t::iterator iter = joint_motionp->mPositionCurve.mKeys.begin();
+		for (PositionCurve::key_list_t::const_iterator iter = joint_motionp->mPositionCurve.mKeys.begin();
 			 iter != joint_motionp->mPositionCurve.mKeys.end(); ++iter)
 		{
-			PositionKey& pos_key = iter->second;
+			PositionKey pos_key = *iter;
 			U16 time_short = F32_to_U16(pos_key.mTime, 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
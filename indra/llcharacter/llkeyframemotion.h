@@ -36,6 +36,7 @@
 #include "llassetstorage.h"
 #include "llbboxlocal.h"
 #include "llhandmotion.h"
+#include "llkeyframekeylist.h"
 #include "lljointstate.h"
 #include "llmotion.h"
 #include "llquaternion.h"
@@ -320,12 +321,14 @@ public:
 		ScaleCurve();
 		~ScaleCurve();
 		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
+		// cursor is the key index found by the last call, see LLKeyframeKeyList
+		LLVector3 getValue(F32 time, F32 duration, S32& cursor);
+		LLVector3 interp(F32 u, const ScaleKey& before, const ScaleKey& after);
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, ScaleKey> key_map_t;
-		key_map_t 			mKeys;
+		typedef LLKeyframeKeyList<ScaleKey> key_list_t;
+		key_list_t 			mKeys;
 		ScaleKey			mLoopInKey;
 		ScaleKey			mLoopOutKey;
 	};
@@ -339,12 +342,14 @@ public:
 		RotationCurve();
 		~RotationCurve();
 		LLQuaternion getValue(F32 time, F32 duration);
-		LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
+		// cursor is the key index found by the last call, see LLKeyframeKeyList
+		LLQuaternion getValue(F32 time, F32 duration, S32& cursor);
+		LLQuaternion interp(F32 u, const RotationKey& before, const RotationKey& after);
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, RotationKey> key_map_t;
-		key_map_t		mKeys;
+		typedef LLKeyframeKeyList<RotationKey> key_list_t;
+		key_list_t		mKeys;
 		RotationKey		mLoopInKey;
 		RotationKey		mLoopOutKey;
 	};
@@ -358,16 +363,32 @@ public:
 		PositionCurve();
 		~PositionCurve();
 		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
+		// cursor is the key index found by the last call, see LLKeyframeKeyList
+		LLVector3 getValue(F32 time, F32 duration, S32& cursor);
+		LLVector3 interp(F32 u, const PositionKey& before, const PositionKey& after);
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, PositionKey> key_map_t;
-		key_map_t		mKeys;
+		typedef LLKeyframeKeyList<PositionKey> key_list_t;
+		key_list_t		mKeys;
 		PositionKey		mLoopInKey;
 		PositionKey		mLoopOutKey;
 	};
 
+	//-------------------------------------------------------------------------
+	// KeyCursors
+	// Where one playing motion is in the curves of one joint
+	//-------------------------------------------------------------------------
+	class KeyCursors
+	{
+	public:
+		KeyCursors() : mScale(0), mRotation(0), mPosition(0) {}
+
+		S32		mScale;
+		S32		mRotation;
+		S32		mPosition;
+	};
+
 	//-------------------------------------------------------------------------
 	// JointMotion
 	//-------------------------------------------------------------------------
@@ -381,7 +402,7 @@ public:
 		U32				mUsage;
 		LLJoint::JointPriority	mPriority;
 
-		void update(LLJointState* joint_state, F32 time, F32 duration);
+		void update(LLJointState* joint_state, F32 time, F32 duration, KeyCursors& cursors);
 	};
 	
 	//-------------------------------------------------------------------------
@@ -413,6 +434,10 @@ public:
 		U32 dumpDiagInfo();
 		JointMotion* getJointMotion(U32 index) const { llassert(index < mJointMotionArray.size()); return mJointMotionArray[index]; }
 		U32 getNumJointMotions() const { return mJointMotionArray.size(); }
+
+		// Updates the joint states of all joint motions at once.  Both
+		// arrays have getNumJointMotions() entries.
+		void update(LLPointer<LLJointState>* joint_states, KeyCursors* cursors, F32 time);
 	};
 
 
@@ -424,6 +449,7 @@ protected:
 	//-------------------------------------------------------------------------
 	JointMotionList*				mJointMotionList;
 	std::vector<LLPointer<LLJointState> > mJointStates;
+	std::vector<KeyCursors>			mKeyCursors;
 	LLJoint*						mPelvisp;
 	LLCharacter*					mCharacter;
 	typedef std::list<JointConstraint*>	constraint_list_t;
@@ -799,6 +799,17 @@ void LLMotionController::updateLoadingMotions()
 // updateMotion()
 //-----------------------------------------------------------------------------
 void LLMotionController::updateMotions(bool force_update)
+{
+	if (prepareMotions())
+	{
+		evaluateMotions(force_update);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// prepareMotions()
+//-----------------------------------------------------------------------------
+bool LLMotionController::prepareMotions()
 {
 	BOOL use_quantum = (mTimeStep != 0.f);
 
@@ -832,7 +843,7 @@ void LLMotionController::updateMotions(bool force_update)
 				}
 
 				updateLoadingMotions();
-				return;
+				return false;
 			}
 			
 			// is calculating a new keyframe pose, make sure the last one gets applied
@@ -851,6 +862,14 @@ void LLMotionController::updateMotions(bool force_update)
 
 	updateLoadingMotions();
 
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::evaluateMotions(bool force_update)
+{
 	resetJointSignatures();
 
 	if (mPaused && !force_update)
@@ -866,7 +885,7 @@ void LLMotionController::updateMotions(bool force_update)
 		// update all regular motions
 		updateRegularMotions();
 
-		if (use_quantum)
+		if (mTimeStep != 0.f)
 		{
 			mPoseBlender.blendAndCache(TRUE);
 		}
@@ -133,6 +133,17 @@ public:
 	// deactivates terminated motions`
 	void updateMotions(bool force_update = false);
 
+	// updateMotions() in two steps, for callers evaluating motions off the
+	// main thread.  prepareMotions() advances the animation time and
+	// finishes loading motions, and returns false if there is nothing left
+	// to evaluate.  Otherwise evaluateMotions() must follow.  It may run on
+	// a worker thread if the character defers what the motions ask of it
+	// beyond their joints, such as LLCharacter::updateVisualParams(), to the
+	// main thread, and the motions keep off shared state (LLEyeMotion has
+	// its own random generator for that reason).
+	bool prepareMotions();
+	void evaluateMotions(bool force_update = false);
+
 	// minimal update (e.g. while hidden)
 	void updateMotionsMinimal();
 
@@ -0,0 +1,358 @@
+/**
+ * @file llkeyframekeylist_test.cpp
+ * @brief LLKeyframeKeyList tests and keyframe lookup benchmark
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llkeyframekeylist.h"
+
+#include <map>
+
+#include "llfile.h"
+#include "llmath.h"
+#include "llquantize.h"
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	// Same layout as LLKeyframeMotion::RotationKey
+	struct TestKey
+	{
+		TestKey() : mTime(0.f), mValue(0.f) {}
+		TestKey(F32 time, F32 value) : mTime(time), mValue(value) {}
+
+		F32 mTime;
+		F32 mValue;
+		F32 mPad[3];
+	};
+
+	typedef LLKeyframeKeyList<TestKey> key_list_t;
+	typedef std::map<F32, TestKey> key_map_t;
+
+	// The key times of one joint curve
+	typedef std::vector<F32> curve_times_t;
+
+	struct keyframe_key_list_data
+	{
+		static void makeCurve(const curve_times_t& times, key_list_t& list, key_map_t& map)
+		{
+			for (size_t i = 0; i < times.size(); ++i)
+			{
+				TestKey key(times[i], (F32)i);
+				list.add(key);
+				map[key.mTime] = key;
+			}
+			list.sort();
+		}
+
+		static S32 mapIndex(const key_map_t& map, F32 time)
+		{
+			return (S32)std::distance(map.begin(), map.lower_bound(time));
+		}
+
+		static F32 readF32(const U8*& p)
+		{
+			F32 value;
+			memcpy(&value, p, sizeof(value));	/* Flawfinder: ignore */
+			p += sizeof(value);
+			return value;
+		}
+
+		static U32 readU32(const U8*& p)
+		{
+			U32 value;
+			memcpy(&value, p, sizeof(value));	/* Flawfinder: ignore */
+			p += sizeof(value);
+			return value;
+		}
+
+		static U16 readU16(const U8*& p)
+		{
+			U16 value;
+			memcpy(&value, p, sizeof(value));	/* Flawfinder: ignore */
+			p += sizeof(value);
+			return value;
+		}
+
+		// Reads the rotation and position key times of a version 1 .anim
+		// file, the way LLKeyframeMotion::deserialize() does.  Returns the
+		// duration, or 0 if the file can't be used.
+		static F32 readAnimation(const std::string& filename, std::vector<curve_times_t>& curves)
+		{
+			LLFILE* fp = LLFile::fopen(filename, "rb");	/* Flawfinder: ignore */
+			if (!fp)
+			{
+				return 0.f;
+			}
+			std::vector<U8> data;
+			U8 buffer[4096];
+			size_t read;
+			while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+			{
+				data.insert(data.end(), buffer, buffer + read);
+			}
+			fclose(fp);
+			data.resize(data.size() + 16, 0);	// no bounds checks on the last key
+
+			const U8* p = &data[0];
+			const U8* end = p + data.size() - 16;
+			if (readU16(p) != 1)
+			{
+				return 0.f;
+			}
+			readU16(p);				// sub_version
+			readU32(p);				// base_priority
+			F32 duration = readF32(p);
+			p += strlen((const char*)p) + 1;	/* Flawfinder: ignore */ // emote_name
+			p += 5 * 4 + 4;			// loop and ease points, hand_pose
+			U32 num_joints = readU32(p);
+			for (U32 j = 0; j < num_joints && p < end; ++j)
+			{
+				p += strlen((const char*)p) + 1;	/* Flawfinder: ignore */ // joint_name
+				readU32(p);			// joint_priority
+				for (S32 curve = 0; curve < 2 && p < end; ++curve)
+				{
+					curve_times_t times;
+					S32 num_keys = (S32)readU32(p);
+					for (S32 k = 0; k < num_keys && p < end; ++k)
+					{
+						times.push_back(U16_to_F32(readU16(p), 0.f, duration));
+						p += 3 * sizeof(U16);
+					}
+					if (!times.empty())
+					{
+						curves.push_back(times);
+					}
+				}
+			}
+			return p <= end ? duration : 0.f;
+		}
+
+		// Something like a 5 second dance: 20 joints, about a key every
+		// 1/15 second with some gaps
+		static F32 makeAnimation(std::vector<curve_times_t>& curves)
+		{
+			const F32 duration = 5.f;
+			for (S32 j = 0; j < 20; ++j)
+			{
+				curve_times_t times;
+				for (F32 time = 0.f; time <= duration; time += (1 + ll_rand(3)) / 30.f)
+				{
+					times.push_back(time);
+				}
+				curves.push_back(times);
+			}
+			return duration;
+		}
+	};
+	typedef test_group<keyframe_key_list_data> keyframe_key_list_test;
+	typedef keyframe_key_list_test::object keyframe_key_list_object;
+	tut::keyframe_key_list_test keyframe_key_list_testcase("LLKeyframeKeyList");
+
+	template<> template<>
+	void keyframe_key_list_object::test<1>()
+	{
+		// Sorting keeps the last key added for a time, like the std::map did
+		key_list_t keys;
+		keys.add(TestKey(0.5f, 1.f));
+		keys.add(TestKey(0.f, 2.f));
+		keys.add(TestKey(0.5f, 3.f));
+		keys.add(TestKey(1.f, 4.f));
+		keys.add(TestKey(0.5f, 5.f));
+		keys.sort();
+
+		ensure_equals("size", keys.size(), 3);
+		ensure_equals("first", keys[0].mValue, 2.f);
+		ensure_equals("duplicate", keys[1].mValue, 5.f);
+		ensure_equals("last", keys.back().mValue, 4.f);
+
+		ensure_equals("before first", keys.find(-1.f), 0);
+		ensure_equals("on key", keys.find(0.5f), 1);
+		ensure_equals("between", keys.find(0.75f), 2);
+		ensure_equals("past last", keys.find(2.f), 3);
+
+		key_list_t empty_keys;
+		S32 cursor = 5;
+		ensure_equals("empty", empty_keys.find(1.f, cursor), 0);
+		ensure_equals("empty cursor", cursor, 0);
+	}
+
+	template<> template<>
+	void keyframe_key_list_object::test<2>()
+	{
+		// The cursor lookup agrees with std::map::lower_bound() when
+		// playing forward, looping, jumping around and landing on keys
+		std::vector<curve_times_t> curves;
+		makeAnimation(curves);
+		for (size_t c = 0; c < curves.size(); ++c)
+		{
+			key_list_t keys;
+			key_map_t map;
+			makeCurve(curves[c], keys, map);
+			ensure_equals("size", keys.size(), (S32)map.size());
+
+			S32 cursor = 0;
+			F32 time = -0.1f;
+			for (S32 i = 0; i < 2000; ++i)
+			{
+				S32 r = ll_rand(20);
+				if (r == 0)
+				{
+					time = ll_frand(6.f) - 0.5f;
+				}
+				else if (r == 1)
+				{
+					time = keys[ll_rand(keys.size())].mTime;
+				}
+				else
+				{
+					time += ll_frand(0.1f);
+					if (time > 5.2f)
+					{
+						time = 0.f;
+					}
+				}
+				S32 expected = mapIndex(map, time);
+				ensure_equals("find", keys.find(time), expected);
+				ensure_equals("find with cursor", keys.find(time, cursor), expected);
+				ensure_equals("cursor", cursor, expected);
+			}
+		}
+	}
+
+	template<> template<>
+	void keyframe_key_list_object::test<3>()
+	{
+		// Benchmark: 60 avatars playing the same animation at 45 fps for a
+		// minute, looking up every curve, with the old std::map and with
+		// the cursors.  Set LL_ANIM_FILES to ';' separated version 1 .anim
+		// files to replay those, otherwise a made up animation is used.
+		// Informational only, timings vary too much between machines to
+		// assert on.
+		std::vector<std::vector<curve_times_t> > animations;
+		std::vector<F32> durations;
+		const char* files = getenv("LL_ANIM_FILES");	/* Flawfinder: ignore */
+		if (files)
+		{
+			std::string list(files);
+			size_t start = 0;
+			while (start < list.size())
+			{
+				size_t sep = list.find(';', start);
+				if (sep == std::string::npos)
+				{
+					sep = list.size();
+				}
+				std::vector<curve_times_t> curves;
+				F32 duration = readAnimation(list.substr(start, sep - start), curves);
+				if (duration > 0.f && !curves.empty())
+				{
+					animations.push_back(curves);
+					durations.push_back(duration);
+				}
+				else
+				{
+					llwarns << "Can't replay " << list.substr(start, sep - start) << llendl;
+				}
+				start = sep + 1;
+			}
+		}
+		if (animations.empty())
+		{
+			animations.resize(1);
+			durations.push_back(makeAnimation(animations[0]));
+		}
+
+		const S32 avatars = 60;
+		const S32 frames = 45 * 60;
+		for (size_t a = 0; a < animations.size(); ++a)
+		{
+			const std::vector<curve_times_t>& curves = animations[a];
+			const F32 duration = durations[a];
+
+			std::vector<key_list_t> lists(curves.size());
+			std::vector<key_map_t> maps(curves.size());
+			S32 total_keys = 0;
+			for (size_t c = 0; c < curves.size(); ++c)
+			{
+				makeCurve(curves[c], lists[c], maps[c]);
+				total_keys += lists[c].size();
+			}
+			std::vector<F32> phases(avatars);
+			for (S32 i = 0; i < avatars; ++i)
+			{
+				phases[i] = ll_frand(duration);
+			}
+
+			F32 map_sum = 0.f;
+			LLTimer timer;
+			for (S32 f = 0; f < frames; ++f)
+			{
+				for (S32 i = 0; i < avatars; ++i)
+				{
+					F32 time = fmodf(phases[i] + f / 45.f, duration);
+					for (size_t c = 0; c < maps.size(); ++c)
+					{
+						key_map_t::iterator it = maps[c].lower_bound(time);
+						if (it != maps[c].end())
+						{
+							map_sum += it->second.mValue;
+						}
+					}
+				}
+			}
+			F64 map_time = timer.getElapsedTimeF64();
+
+			std::vector<S32> cursors(avatars * lists.size());
+			F32 list_sum = 0.f;
+			timer.reset();
+			for (S32 f = 0; f < frames; ++f)
+			{
+				for (S32 i = 0; i < avatars; ++i)
+				{
+					F32 time = fmodf(phases[i] + f / 45.f, duration);
+					S32* avatar_cursors = &cursors[i * lists.size()];
+					for (size_t c = 0; c < lists.size(); ++c)
+					{
+						S32 k = lists[c].find(time, avatar_cursors[c]);
+						if (k < lists[c].size())
+						{
+							list_sum += lists[c][k].mValue;
+						}
+					}
+				}
+			}
+			F64 list_time = timer.getElapsedTimeF64();
+
+			ensure_equals("same keys found", list_sum, map_sum);
+			llinfos << "Keyframe lookups, " << curves.size() << " curves, " << total_keys
+					<< " keys: std::map " << map_time * 1000.0 << " ms, cursors "
+					<< list_time * 1000.0 << " ms" << llendl;
+		}
+	}
+}
@@ -33,6 +33,7 @@ apr_pool_t *gAPRPoolp = NULL; // Global APR memory pool
 LLVolatileAPRPool *LLAPRFile::sAPRFilePoolp = NULL ; //global volatile APR memory pool.
 apr_thread_mutex_t *gLogMutexp = NULL;
 apr_thread_mutex_t *gCallStacksLogMutexp = NULL;
+apr_thread_rwlock_t *gStringTableLockp = NULL;
 
 const S32 FULL_VOLATILE_APR_POOL = 1024 ; //number of references to LLVolatileAPRPool
 
@@ -47,6 +48,9 @@ void ll_init_apr()
 		// Initialize the logging mutex
 		apr_thread_mutex_create(&gLogMutexp, APR_THREAD_MUTEX_UNNESTED, gAPRPoolp);
 		apr_thread_mutex_create(&gCallStacksLogMutexp, APR_THREAD_MUTEX_UNNESTED, gAPRPoolp);
+
+		// Shared by all the LLStringTables
+		apr_thread_rwlock_create(&gStringTableLockp, gAPRPoolp);
 	}
 
 	if(!LLAPRFile::sAPRFilePoolp)
@@ -76,6 +80,11 @@ void ll_cleanup_apr()
 		apr_thread_mutex_destroy(gCallStacksLogMutexp);
 		gCallStacksLogMutexp = NULL;
 	}
+	if (gStringTableLockp)
+	{
+		apr_thread_rwlock_destroy(gStringTableLockp);
+		gStringTableLockp = NULL;
+	}
 	if (gAPRPoolp)
 	{
 		apr_pool_destroy(gAPRPoolp);
@@ -45,6 +45,7 @@
 
 #include "apr_thread_proc.h"
 #include "apr_thread_mutex.h"
+#include "apr_thread_rwlock.h"
 #include "apr_getopt.h"
 #include "apr_signal.h"
 #include "apr_atomic.h"
@@ -52,6 +53,7 @@
 
 extern LL_COMMON_API apr_thread_mutex_t* gLogMutexp;
 extern apr_thread_mutex_t* gCallStacksLogMutexp;
+extern LL_COMMON_API apr_thread_rwlock_t* gStringTableLockp;
 
 /** 
  * @brief initialize the common apr constructs -- apr itself, the
@@ -0,0 +1,244 @@
+/** 
+ * @file llmappedfile.cpp
+ * @brief Memory mapped file of a fixed size.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#if LL_WINDOWS
+#include <windows.h>
+#endif
+
+#include "linden_common.h"
+#include "llmappedfile.h"
+
+#if !LL_WINDOWS
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+LLMappedFile::LLMappedFile()
+	: mData(NULL),
+	  mSize(0),
+	  mMode(READ_ONLY),
+#if LL_WINDOWS
+	  mFileHandle(INVALID_HANDLE_VALUE),
+	  mMappingHandle(NULL)
+#else
+	  mFileDesc(-1)
+#endif
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+	close();
+}
+
+#if LL_WINDOWS
+
+bool LLMappedFile::open(const std::string& filename, S64 size, EMapMode mode)
+{
+	close();
+
+	llutf16string utf16filename = utf8str_to_utf16str(filename);
+	DWORD access = (mode == READ_WRITE) ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+	DWORD creation = (mode == READ_WRITE) ? OPEN_ALWAYS : OPEN_EXISTING;
+	HANDLE file = CreateFileW(utf16filename.c_str(), access, FILE_SHARE_READ, NULL,
+							  creation, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	if (size == 0)
+	{
+		size = (S64)file_size.QuadPart;
+	}
+	else if (size != (S64)file_size.QuadPart && mode != READ_WRITE)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	if (size <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// CreateFileMapping() grows the file to the requested size, but will not shrink it
+	if (mode == READ_WRITE && size < (S64)file_size.QuadPart)
+	{
+		LARGE_INTEGER new_size;
+		new_size.QuadPart = size;
+		if (!SetFilePointerEx(file, new_size, NULL, FILE_BEGIN) || !SetEndOfFile(file))
+		{
+			CloseHandle(file);
+			return false;
+		}
+	}
+
+	DWORD protect = (mode == READ_WRITE) ? PAGE_READWRITE : (mode == COPY_ON_WRITE ? PAGE_WRITECOPY : PAGE_READONLY);
+	HANDLE mapping = CreateFileMappingW(file, NULL, protect, (DWORD)(size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	DWORD view_access = (mode == READ_WRITE) ? FILE_MAP_WRITE : (mode == COPY_ON_WRITE ? FILE_MAP_COPY : FILE_MAP_READ);
+	void* data = MapViewOfFile(mapping, view_access, 0, 0, (SIZE_T)size);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mFileHandle = file;
+	mMappingHandle = mapping;
+	mData = (U8*)data;
+	mSize = size;
+	mMode = mode;
+	return true;
+}
+
+void LLMappedFile::close()
+{
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+		mData = NULL;
+	}
+	if (mMappingHandle)
+	{
+		CloseHandle((HANDLE)mMappingHandle);
+		mMappingHandle = NULL;
+	}
+	if (mFileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle((HANDLE)mFileHandle);
+		mFileHandle = INVALID_HANDLE_VALUE;
+	}
+	mSize = 0;
+}
+
+bool LLMappedFile::flush(bool wait)
+{
+	if (!mData || mMode != READ_WRITE)
+	{
+		return false;
+	}
+	if (!FlushViewOfFile(mData, (SIZE_T)mSize))
+	{
+		return false;
+	}
+	return !wait || FlushFileBuffers((HANDLE)mFileHandle);
+}
+
+#else // LL_WINDOWS
+
+bool LLMappedFile::open(const std::string& filename, S64 size, EMapMode mode)
+{
+	close();
+
+	int flags = (mode == READ_WRITE) ? O_RDWR | O_CREAT : O_RDONLY;
+	int fd = ::open(filename.c_str(), flags, 0600);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	off_t file_size = lseek(fd, 0, SEEK_END);
+	if (file_size < 0)
+	{
+		::close(fd);
+		return false;
+	}
+	if (size == 0)
+	{
+		size = (S64)file_size;
+	}
+	else if (size != (S64)file_size)
+	{
+		if (mode != READ_WRITE || ftruncate(fd, (off_t)size) != 0)
+		{
+			::close(fd);
+			return false;
+		}
+	}
+	if (size <= 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	int prot = (mode == READ_ONLY) ? PROT_READ : PROT_READ | PROT_WRITE;
+	int map_flags = (mode == READ_WRITE) ? MAP_SHARED : MAP_PRIVATE;
+	void* data = mmap(NULL, (size_t)size, prot, map_flags, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+
+	mFileDesc = fd;
+	mData = (U8*)data;
+	mSize = size;
+	mMode = mode;
+	return true;
+}
+
+void LLMappedFile::close()
+{
+	if (mData)
+	{
+		munmap(mData, (size_t)mSize);
+		mData = NULL;
+	}
+	if (mFileDesc >= 0)
+	{
+		::close(mFileDesc);
+		mFileDesc = -1;
+	}
+	mSize = 0;
+}
+
+bool LLMappedFile::flush(bool wait)
+{
+	if (!mData || mMode != READ_WRITE)
+	{
+		return false;
+	}
+	return msync(mData, (size_t)mSize, wait ? MS_SYNC : MS_ASYNC) == 0;
+}
+
+#endif // LL_WINDOWS
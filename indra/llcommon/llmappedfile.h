@@ -0,0 +1,77 @@
+/** 
+ * @file llmappedfile.h
+ * @brief Memory mapped file of a fixed size.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMAPPEDFILE_H
+#define LL_LLMAPPEDFILE_H
+
+#include <boost/noncopyable.hpp>
+
+// Maps a whole file into memory.
+// READ_WRITE mappings write changes back to the file (call flush() to force it),
+// COPY_ON_WRITE mappings can be modified but the changes are never written back.
+// Takes a UTF8 filename.
+
+class LL_COMMON_API LLMappedFile : private boost::noncopyable
+{
+public:
+	typedef enum e_map_mode
+	{
+		READ_ONLY = 0,
+		READ_WRITE = 1,
+		COPY_ON_WRITE = 2
+	} EMapMode;
+
+	LLMappedFile();
+	~LLMappedFile();
+
+	// Maps filename. In READ_WRITE mode a missing file is created and the
+	// file is resized to size bytes (new bytes are zero). size == 0 maps
+	// the file at its current size, which must not be 0.
+	bool open(const std::string& filename, S64 size, EMapMode mode);
+	void close();
+
+	// Writes dirty pages back to disk, returns false on failure or if not READ_WRITE.
+	// With wait == false the write back is only scheduled.
+	bool flush(bool wait = true);
+
+	bool isOpen() const { return mData != NULL; }
+	U8* getData() const { return mData; }
+	S64 getSize() const { return mSize; }
+	EMapMode getMode() const { return mMode; }
+
+private:
+	U8* mData;
+	S64 mSize;
+	EMapMode mMode;
+#if LL_WINDOWS
+	void* mFileHandle;
+	void* mMappingHandle;
+#else
+	int mFileDesc;
+#endif
+};
+
+#endif // LL_LLMAPPEDFILE_H
@@ -132,7 +132,11 @@ namespace
 		eMONTIOR_MWAIT=33,
 		eCPLDebugStore=34,
 		eThermalMonitor2=35,
-		eAltivec=36
+		eAltivec=36,
+		eSSSE3_Features=37,
+		eFMA_Features=38,
+		eAVX_Features=39,
+		eAVX2_Features=40
 	};
 
 	const char* cpu_feature_names[] =
@@ -175,7 +179,11 @@ namespace
 		"CPL Qualified Debug Store",
 		"Thermal Monitor 2",
 
-		"Altivec"
+		"Altivec",
+		"SSSE3 New Instructions",
+		"FMA3 Instructions",
+		"AVX Instructions",
+		"AVX2 Instructions"
 	};
 
 	std::string intel_CPUFamilyName(int composed_family) 
@@ -270,6 +278,21 @@ public:
 		return hasExtension(cpu_feature_names[eSSE2_Ext]);
 	}
 
+	bool hasSSSE3() const
+	{
+		return hasExtension(cpu_feature_names[eSSSE3_Features]);
+	}
+
+	bool hasAVX2() const
+	{
+		return hasExtension(cpu_feature_names[eAVX2_Features]);
+	}
+
+	bool hasFMA() const
+	{
+		return hasExtension(cpu_feature_names[eFMA_Features]);
+	}
+
 	bool hasAltivec() const 
 	{
 		return hasExtension("Altivec"); 
@@ -536,6 +559,26 @@ private:
 				{
 					setExtension(cpu_feature_names[eThermalMonitor2]);
 				}
+
+				if(cpu_info[2] & 0x200)
+				{
+					setExtension(cpu_feature_names[eSSSE3_Features]);
+				}
+
+				if(cpu_info[2] & 0x1000)
+				{
+					setExtension(cpu_feature_names[eFMA_Features]);
+				}
+
+#if _MSC_FULL_VER >= 160040219
+				// AVX needs the OS to save the YMM registers (OSXSAVE and
+				// XCR0 bits 1 and 2) as well as the CPU bit
+				if((cpu_info[2] & 0x18000000) == 0x18000000
+					&& (_xgetbv(0) & 0x6) == 0x6)
+				{
+					setExtension(cpu_feature_names[eAVX_Features]);
+				}
+#endif
 						
 				unsigned int feature_info = (unsigned int) cpu_info[3];
 				for(unsigned int index = 0, bit = 1; index < eSSE3_Features; ++index, bit <<= 1)
@@ -546,6 +589,16 @@ private:
 					}
 				}
 			}
+			else if (i == 7)
+			{
+#if _MSC_FULL_VER >= 160040219
+				__cpuidex(cpu_info, 7, 0);
+				if((cpu_info[1] & 0x20) && hasExtension(cpu_feature_names[eAVX_Features]))
+				{
+					setExtension(cpu_feature_names[eAVX2_Features]);
+				}
+#endif
+			}
 		}
 
 		// Calling __cpuid with 0x80000000 as the InfoType argument
@@ -680,6 +733,28 @@ private:
 			}
 		}
 
+		// The high word holds the cpuid ecx bits
+		if(feature_info & (((uint64_t)0x200) << 32))
+		{
+			setExtension(cpu_feature_names[eSSSE3_Features]);
+		}
+
+		if(feature_info & (((uint64_t)0x1000) << 32))
+		{
+			setExtension(cpu_feature_names[eFMA_Features]);
+		}
+
+		// The AVX bit is only reported when the OS saves the YMM registers
+		if(feature_info & (((uint64_t)0x10000000) << 32))
+		{
+			setExtension(cpu_feature_names[eAVX_Features]);
+
+			if(getSysctlInt64("machdep.cpu.leaf7_feature_bits") & 0x20)
+			{
+				setExtension(cpu_feature_names[eAVX2_Features]);
+			}
+		}
+
 		// *NOTE:Mani - I didn't find any docs that assure me that machdep.cpu.feature_bits will always be
 		// The feature bits I think it is. Here's a test:
 #ifndef LL_RELEASE_FOR_DOWNLOAD
@@ -820,6 +895,27 @@ private:
 		{
 			setExtension(cpu_feature_names[eSSE2_Ext]);
 		}
+
+		if( flags.find( " ssse3 " ) != std::string::npos )
+		{
+			setExtension(cpu_feature_names[eSSSE3_Features]);
+		}
+
+		if( flags.find( " fma " ) != std::string::npos )
+		{
+			setExtension(cpu_feature_names[eFMA_Features]);
+		}
+
+		// The kernel leaves these out when it doesn't save the YMM registers
+		if( flags.find( " avx " ) != std::string::npos )
+		{
+			setExtension(cpu_feature_names[eAVX_Features]);
+		}
+
+		if( flags.find( " avx2 " ) != std::string::npos )
+		{
+			setExtension(cpu_feature_names[eAVX2_Features]);
+		}
 	
 # endif // LL_X86
 	}
@@ -880,6 +976,9 @@ LLProcessorInfo::~LLProcessorInfo() {}
 F64 LLProcessorInfo::getCPUFrequency() const { return mImpl->getCPUFrequency(); }
 bool LLProcessorInfo::hasSSE() const { return mImpl->hasSSE(); }
 bool LLProcessorInfo::hasSSE2() const { return mImpl->hasSSE2(); }
+bool LLProcessorInfo::hasSSSE3() const { return mImpl->hasSSSE3(); }
+bool LLProcessorInfo::hasAVX2() const { return mImpl->hasAVX2(); }
+bool LLProcessorInfo::hasFMA() const { return mImpl->hasFMA(); }
 bool LLProcessorInfo::hasAltivec() const { return mImpl->hasAltivec(); }
 std::string LLProcessorInfo::getCPUFamilyName() const { return mImpl->getCPUFamilyName(); }
 std::string LLProcessorInfo::getCPUBrandName() const { return mImpl->getCPUBrandName(); }
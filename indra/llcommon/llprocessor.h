@@ -38,6 +38,9 @@ public:
 	F64 getCPUFrequency() const;
 	bool hasSSE() const;
 	bool hasSSE2() const;
+	bool hasSSSE3() const;
+	bool hasAVX2() const;
+	bool hasFMA() const;
 	bool hasAltivec() const;
 	std::string getCPUFamilyName() const;
 	std::string getCPUBrandName() const;
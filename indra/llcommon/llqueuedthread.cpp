@@ -29,19 +29,57 @@
 #include "llstl.h"
 #include "lltimer.h"	// ms_sleep()
 
+//============================================================================
+// Additional workers for a multi-worker LLQueuedThread.
+// They share the owner's request queue and run condition and only ever call
+// processNextRequest(); see the note in llqueuedthread.h.
+
+class LLQueuedThread::QueueWorker : public LLThread
+{
+public:
+	QueueWorker(const std::string& name, LLQueuedThread* owner) :
+		LLThread(name),
+		mOwner(owner)
+	{
+	}
+
+protected:
+	/*virtual*/ void run()
+	{
+		while (1)
+		{
+			mOwner->waitForWork();
+			if (mOwner->isQuitting() || mOwner->isStopped() || isQuitting())
+			{
+				break;
+			}
+			mOwner->processNextRequest();
+		}
+		llinfos << "LLQueuedThread worker " << mName << " EXITING." << llendl;
+	}
+
+private:
+	LLQueuedThread* mOwner;
+};
+
 //============================================================================
 
 // MAIN THREAD
-LLQueuedThread::LLQueuedThread(const std::string& name, bool threaded) :
+LLQueuedThread::LLQueuedThread(const std::string& name, bool threaded, U32 num_workers) :
 	LLThread(name),
 	mThreaded(threaded),
 	mIdleThread(TRUE),
+	mPending(0),
+	mInProgress(0),
+	mNumWorkers(1),
 	mNextHandle(0),
 	mStarted(FALSE)
 {
 	if (mThreaded)
 	{
+		mNumWorkers = llclamp(num_workers, (U32)1, (U32)MAX_WORKERS);
 		start();
+		startWorkers();
 	}
 }
 
@@ -61,6 +99,7 @@ void LLQueuedThread::shutdown()
 	setQuitting();
 
 	unpause(); // MAIN THREAD
+	stopWorkers();
 	if (mThreaded)
 	{
 		S32 timeout = 100;
@@ -83,6 +122,9 @@ void LLQueuedThread::shutdown()
 		mStatus = STOPPED;
 	}
 
+	mRequestQueue = request_queue_t();
+	mPending = 0;
+
 	QueuedRequest* req;
 	S32 active_count = 0;
 	while ( (req = (QueuedRequest*)mRequestHash.pop_element()) )
@@ -102,6 +144,75 @@ void LLQueuedThread::shutdown()
 
 //----------------------------------------------------------------------------
 
+// MAIN THREAD
+void LLQueuedThread::startWorkers()
+{
+	for (U32 i = 1; i < mNumWorkers; ++i)
+	{
+		QueueWorker* worker = new QueueWorker(llformat("%s.%d", mName.c_str(), i), this);
+		mWorkers.push_back(worker);
+		worker->start();
+	}
+}
+
+// MAIN THREAD
+void LLQueuedThread::stopWorkers()
+{
+	if (mWorkers.empty())
+	{
+		return;
+	}
+	wakeWorkers(); // so they see QUITTING
+
+	for (worker_list_t::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+	{
+		QueueWorker* worker = *iter;
+		S32 timeout = 100;
+		for ( ; timeout>0; timeout--)
+		{
+			if (worker->isStopped())
+			{
+				break;
+			}
+			ms_sleep(100);
+			LLThread::yield();
+		}
+		if (timeout == 0)
+		{
+			llwarns << "~LLQueuedThread (" << mName << ") worker timed out!" << llendl;
+		}
+		delete worker; // ~LLThread() handles a worker that did not stop
+	}
+	mWorkers.clear();
+}
+
+// Any thread
+void LLQueuedThread::wakeWorkers()
+{
+	if (!mWorkers.empty())
+	{
+		// all workers wait on mRunCondition, wake() would only signal one of them
+		lockData();
+		mRunCondition->broadcast();
+		unlockData();
+	}
+}
+
+// WORKER THREAD
+void LLQueuedThread::waitForWork()
+{
+	// Like checkPause(), but the additional workers only care about queued requests,
+	// so they do not spin while worker 0 is busy with threadedUpdate() work.
+	lockData();
+	while (mStatus == RUNNING && (isPaused() || mRequestQueue.empty()))
+	{
+		mRunCondition->wait(); // unlocks mRunCondition
+	}
+	unlockData();
+}
+
+//----------------------------------------------------------------------------
+
 // MAIN THREAD
 // virtual
 S32 LLQueuedThread::update(U32 max_time_ms)
@@ -130,6 +241,7 @@ S32 LLQueuedThread::updateQueue(U32 max_time_ms)
 		if(pending > 0)
 		{
 		unpause();
+			wakeWorkers();
 	}
 	}
 	else
@@ -152,6 +264,7 @@ void LLQueuedThread::incQueue()
 		if (mThreaded)
 		{
 			wake(); // Wake the thread up if necessary.
+			wakeWorkers();
 		}
 	}
 }
@@ -160,11 +273,7 @@ void LLQueuedThread::incQueue()
 // May be called from any thread
 S32 LLQueuedThread::getPending()
 {
-	S32 res;
-	lockData();
-	res = mRequestQueue.size();
-	unlockData();
-	return res;
+	return mPending;
 }
 
 // MAIN thread
@@ -174,7 +283,13 @@ void LLQueuedThread::waitOnPending()
 	{
 		update(0);
 
-		if (mIdleThread)
+		// processNextRequest() updates both counts under the data lock, so
+		// read them under it too or a request that has been taken off the
+		// queue but not yet marked in progress looks like no work at all.
+		lockData();
+		bool done = mPending == 0 && mInProgress == 0;
+		unlockData();
+		if (mIdleThread && done)
 		{
 			break;
 		}
@@ -192,7 +307,7 @@ void LLQueuedThread::printQueueStats()
 	lockData();
 	if (!mRequestQueue.empty())
 	{
-		QueuedRequest *req = *mRequestQueue.begin();
+		QueuedRequest *req = mRequestQueue.front();
 		llinfos << llformat("Pending Requests:%d Current status:%d", mRequestQueue.size(), req->getStatus()) << llendl;
 	}
 	else
@@ -226,6 +341,7 @@ bool LLQueuedThread::addRequest(QueuedRequest* req)
 	lockData();
 	req->setStatus(STATUS_QUEUED);
 	mRequestQueue.insert(req);
+	mPending = mRequestQueue.size();
 	mRequestHash.insert(req);
 #if _DEBUG
 // 	llinfos << llformat("LLQueuedThread::Added req [%08d]",handle) << llendl;
@@ -340,10 +456,8 @@ void LLQueuedThread::setPriority(handle_t handle, U32 priority)
 		}
 		else if(req->getStatus() == STATUS_QUEUED)
 		{
-			// remove from list then re-insert
-			llverify(mRequestQueue.erase(req) == 1);
-			req->setPriority(priority);
-			mRequestQueue.insert(req);
+			// re-sort in place
+			mRequestQueue.reprioritize(req, priority);
 		}
 	}
 	unlockData();
@@ -405,8 +519,8 @@ S32 LLQueuedThread::processNextRequest()
 		{
 			break;
 		}
-		req = *mRequestQueue.begin();
-		mRequestQueue.erase(mRequestQueue.begin());
+		req = mRequestQueue.pop();
+		mPending = mRequestQueue.size();
 		if ((req->getFlags() & FLAG_ABORT) || (mStatus == QUITTING))
 		{
 			req->setStatus(STATUS_ABORTED);
@@ -427,6 +541,7 @@ S32 LLQueuedThread::processNextRequest()
 	{
 		req->setStatus(STATUS_INPROGRESS);
 		start_priority = req->getPriority();
+		mInProgress++;
 	}
 	unlockData();
 
@@ -449,6 +564,7 @@ S32 LLQueuedThread::processNextRequest()
 				req->deleteRequest();
 // 				check();
 			}
+			mInProgress--;
 			unlockData();
 		}
 		else
@@ -456,6 +572,8 @@ S32 LLQueuedThread::processNextRequest()
 			lockData();
 			req->setStatus(STATUS_QUEUED);
 			mRequestQueue.insert(req);
+			mPending = mRequestQueue.size();
+			mInProgress--;
 			unlockData();
 			if (mThreaded && start_priority < PRIORITY_NORMAL)
 			{
@@ -530,11 +648,112 @@ void LLQueuedThread::threadedUpdate()
 
 //============================================================================
 
+void LLQueuedThread::RequestQueue::insert(QueuedRequest* req)
+{
+	llassert(req->mQueueIndex < 0);
+	mHeap.push_back(req);
+	S32 index = (S32)mHeap.size() - 1;
+	req->mQueueIndex = index;
+	siftUp(index);
+}
+
+LLQueuedThread::QueuedRequest* LLQueuedThread::RequestQueue::pop()
+{
+	QueuedRequest* res = mHeap.front();
+	QueuedRequest* last = mHeap.back();
+	mHeap.pop_back();
+	if (!mHeap.empty())
+	{
+		place(last, 0);
+		siftDown(0);
+	}
+	res->mQueueIndex = -1;
+	return res;
+}
+
+bool LLQueuedThread::RequestQueue::erase(QueuedRequest* req)
+{
+	S32 index = req->mQueueIndex;
+	if (index < 0 || index >= (S32)mHeap.size() || mHeap[index] != req)
+	{
+		return false;
+	}
+	QueuedRequest* last = mHeap.back();
+	mHeap.pop_back();
+	if (last != req)
+	{
+		place(last, index);
+		siftUp(index);
+		siftDown(last->mQueueIndex);
+	}
+	req->mQueueIndex = -1;
+	return true;
+}
+
+void LLQueuedThread::RequestQueue::reprioritize(QueuedRequest* req, U32 priority)
+{
+	llassert(req->mQueueIndex >= 0 && mHeap[req->mQueueIndex] == req);
+	U32 old_priority = req->getPriority();
+	req->setPriority(priority);
+	if (priority > old_priority)
+	{
+		siftUp(req->mQueueIndex);
+	}
+	else if (priority < old_priority)
+	{
+		siftDown(req->mQueueIndex);
+	}
+}
+
+void LLQueuedThread::RequestQueue::siftUp(S32 index)
+{
+	QueuedRequest* req = mHeap[index];
+	while (index > 0)
+	{
+		S32 parent = (index - 1) >> 1;
+		if (!req->higherPriority(*mHeap[parent]))
+		{
+			break;
+		}
+		place(mHeap[parent], index);
+		index = parent;
+	}
+	place(req, index);
+}
+
+void LLQueuedThread::RequestQueue::siftDown(S32 index)
+{
+	QueuedRequest* req = mHeap[index];
+	const S32 count = (S32)mHeap.size();
+	while (1)
+	{
+		S32 child = (index << 1) + 1;
+		if (child >= count)
+		{
+			break;
+		}
+		if (child + 1 < count && mHeap[child + 1]->higherPriority(*mHeap[child]))
+		{
+			child++;
+		}
+		if (!mHeap[child]->higherPriority(*req))
+		{
+			break;
+		}
+		place(mHeap[child], index);
+		index = child;
+	}
+	place(req, index);
+}
+
+//============================================================================
+
 LLQueuedThread::QueuedRequest::QueuedRequest(LLQueuedThread::handle_t handle, U32 priority, U32 flags) :
 	LLSimpleHashEntry<LLQueuedThread::handle_t>(handle),
 	mStatus(STATUS_UNKNOWN),
 	mPriority(priority),
-	mFlags(flags)
+	mFlags(flags),
+	mQueueIndex(-1)
 {
 }
 
@@ -31,6 +31,7 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "llapr.h"
 
@@ -40,6 +41,13 @@
 //============================================================================
 // Note: ~LLQueuedThread is O(N) N=# of queued threads, assumed to be small
 //   It is assumed that LLQueuedThreads are rarely created/destroyed.
+//
+// A threaded LLQueuedThread may service its queue with more than one worker
+//   (see num_workers in the constructor). The LLQueuedThread itself is always
+//   worker 0 and is the only one that calls startThread(), endThread() and
+//   threadedUpdate(); the additional workers only call processNextRequest().
+//   Requests must not rely on getLocalAPRFilePool() when num_workers > 1,
+//   since that pool belongs to worker 0.
 
 class LL_COMMON_API LLQueuedThread : public LLThread
 {
@@ -72,11 +80,15 @@ public:
 	typedef U32 handle_t;
 	
 	//------------------------------------------------------------------------
+protected:
+	class RequestQueue;
+
 public:
 
 	class LL_COMMON_API QueuedRequest : public LLSimpleHashEntry<handle_t>
 	{
 		friend class LLQueuedThread;
+		friend class LLQueuedThread::RequestQueue;
 		
 	protected:
 		virtual ~QueuedRequest(); // use deleteRequest()
@@ -131,25 +143,61 @@ public:
 		LLAtomic32<status_t> mStatus;
 		U32 mPriority;
 		U32 mFlags;
+
+	private:
+		S32 mQueueIndex; // slot in RequestQueue, -1 when not queued
 	};
 
 protected:
-	struct queued_request_less
+	//------------------------------------------------------------------------
+	// Indexed binary heap of queued requests, highest priority at the front.
+	// Each request remembers its slot so that a priority change is an
+	// in-place sift (O(log N), no allocation) instead of erase + insert.
+	// Not thread safe; all access is made with lockData() held.
+	
+	class LL_COMMON_API RequestQueue
 	{
-		bool operator()(const QueuedRequest* lhs, const QueuedRequest* rhs) const
+	public:
+		typedef std::vector<QueuedRequest*>::iterator iterator;
+
+		bool empty() const { return mHeap.empty(); }
+		S32 size() const { return (S32)mHeap.size(); }
+		QueuedRequest* front() const { return mHeap.front(); }
+		// NOTE: iteration is in heap order, not in priority order
+		iterator begin() { return mHeap.begin(); }
+		iterator end() { return mHeap.end(); }
+
+		void insert(QueuedRequest* req);
+		QueuedRequest* pop();
+		bool erase(QueuedRequest* req);
+		void reprioritize(QueuedRequest* req, U32 priority);
+
+	private:
+		void place(QueuedRequest* req, S32 index)
 		{
-			return lhs->higherPriority(*rhs); // higher priority in front of queue (set)
+			mHeap[index] = req;
+			req->mQueueIndex = index;
 		}
+		void siftUp(S32 index);
+		void siftDown(S32 index);
+
+	private:
+		std::vector<QueuedRequest*> mHeap;
 	};
 
+	class QueueWorker;
+	friend class QueueWorker;
+
 
 	//------------------------------------------------------------------------
 	
 public:
 	static handle_t nullHandle() { return handle_t(0); }
+	enum { MAX_WORKERS = 32 };
 	
 public:
-	LLQueuedThread(const std::string& name, bool threaded = true);
+	// num_workers is only meaningful when threaded; it is clamped to [1, MAX_WORKERS]
+	LLQueuedThread(const std::string& name, bool threaded = true, U32 num_workers = 1);
 	virtual ~LLQueuedThread();	
 	virtual void shutdown();
 	
@@ -164,6 +212,11 @@ private:
 	virtual void endThread(void);
 	virtual void threadedUpdate(void);
 
+	void startWorkers();
+	void stopWorkers();
+	void wakeWorkers();
+	void waitForWork(); // called from the additional workers, see QueueWorker::run()
+
 protected:
 	handle_t generateHandle();
 	bool addRequest(QueuedRequest* req);
@@ -181,6 +234,7 @@ public:
 
 	S32 getPending();
 	bool getThreaded() { return mThreaded ? true : false; }
+	U32 getNumWorkers() const { return mNumWorkers; }
 
 	// Request accessors
 	status_t getRequestStatus(handle_t handle);
@@ -200,8 +254,14 @@ protected:
 	BOOL mStarted;  // required when mThreaded is false to call startThread() from update()
 	LLAtomic32<BOOL> mIdleThread; // request queue is empty (or we are quitting) and the thread is idle
 	
-	typedef std::set<QueuedRequest*, queued_request_less> request_queue_t;
+	typedef RequestQueue request_queue_t;
 	request_queue_t mRequestQueue;
+	LLAtomic32<S32> mPending; // mirrors mRequestQueue.size() so getPending() does not need the lock
+	LLAtomic32<S32> mInProgress; // requests currently being processed by any worker
+
+	U32 mNumWorkers;
+	typedef std::vector<QueueWorker*> worker_list_t;
+	worker_list_t mWorkers; // workers 1..N-1; worker 0 is this thread
 
 	enum { REQUEST_HASH_SIZE = 512 }; // must be power of 2
 	typedef LLSimpleHash<handle_t, REQUEST_HASH_SIZE> request_hash_t;
@@ -0,0 +1,611 @@
+/**
+ * @file llsddocument.cpp
+ * @brief Flat, arena backed, read only LLSD document.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llsddocument.h"
+
+#include <algorithm>
+
+// mKey of values that are not in a map
+static const U32 NO_KEY = 0xffffffff;
+
+//============================================================================
+
+static int compare_keys(const char* a, U32 a_len, const char* b, U32 b_len)
+{
+	// Same ordering as std::string, and therefore as the LLSD map
+	int res = memcmp(a, b, llmin(a_len, b_len));
+	if (res == 0)
+	{
+		res = (a_len < b_len) ? -1 : ((a_len > b_len) ? 1 : 0);
+	}
+	return res;
+}
+
+struct LLSDDocument::KeyLess
+{
+	KeyLess(const LLSDDocument* doc) : mDocument(doc) {}
+	bool operator()(U32 a, U32 b) const
+	{
+		const Node& na = mDocument->mNodes[a];
+		const Node& nb = mDocument->mNodes[b];
+		return compare_keys(mDocument->arena(na.mKey), na.mKeyLength, mDocument->arena(nb.mKey), nb.mKeyLength) < 0;
+	}
+	const LLSDDocument* mDocument;
+};
+
+//============================================================================
+// Value
+
+LLSD::Boolean LLSDDocument::Value::asBoolean() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeBoolean:
+		return node().mBoolean;
+	  case LLSD::TypeInteger:
+		return node().mInteger != 0;
+	  case LLSD::TypeString:
+		return node().mSize != 0;
+	  case LLSD::TypeMap:
+	  case LLSD::TypeArray:
+		return false;
+	  default:
+		return scalarToLLSD().asBoolean();
+	}
+}
+
+LLSD::Integer LLSDDocument::Value::asInteger() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeBoolean:
+		return node().mBoolean ? 1 : 0;
+	  case LLSD::TypeInteger:
+		return node().mInteger;
+	  case LLSD::TypeMap:
+	  case LLSD::TypeArray:
+		return 0;
+	  default:
+		return scalarToLLSD().asInteger();
+	}
+}
+
+LLSD::Real LLSDDocument::Value::asReal() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeInteger:
+		return (LLSD::Real)node().mInteger;
+	  case LLSD::TypeReal:
+		return node().mReal;
+	  case LLSD::TypeMap:
+	  case LLSD::TypeArray:
+		return 0.0;
+	  default:
+		return scalarToLLSD().asReal();
+	}
+}
+
+LLSD::String LLSDDocument::Value::asString() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeString:
+	  case LLSD::TypeURI:
+		return LLSD::String(getCString(), node().mSize);
+	  case LLSD::TypeMap:
+	  case LLSD::TypeArray:
+		return LLSD::String();
+	  default:
+		return scalarToLLSD().asString();
+	}
+}
+
+LLSD::UUID LLSDDocument::Value::asUUID() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeUUID:
+	  {
+		LLUUID id;
+		memcpy(id.mData, mDocument->arena(node().mOffset), UUID_BYTES);	/* Flawfinder: ignore */
+		return id;
+	  }
+	  case LLSD::TypeString:
+		return LLUUID(asString());
+	  default:
+		return LLUUID::null;
+	}
+}
+
+LLSD::Date LLSDDocument::Value::asDate() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeDate:
+		return LLDate(node().mReal);
+	  case LLSD::TypeString:
+		return LLDate(asString());
+	  default:
+		return LLDate();
+	}
+}
+
+LLSD::URI LLSDDocument::Value::asURI() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeString:
+	  case LLSD::TypeURI:
+		return LLURI(asString());
+	  default:
+		return LLURI();
+	}
+}
+
+LLSD::Binary LLSDDocument::Value::asBinary() const
+{
+	if (isBinary())
+	{
+		const U8* data = getBinaryData();
+		return LLSD::Binary(data, data + node().mSize);
+	}
+	return LLSD::Binary();
+}
+
+const char* LLSDDocument::Value::getCString() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeString:
+	  case LLSD::TypeURI:
+	  case LLSD::TypeBinary:
+		return mDocument->arena(node().mOffset);
+	  default:
+		return NULL;
+	}
+}
+
+S32 LLSDDocument::Value::getDataSize() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeString:
+	  case LLSD::TypeURI:
+	  case LLSD::TypeBinary:
+		return (S32)node().mSize;
+	  default:
+		return 0;
+	}
+}
+
+LLSD::String LLSDDocument::Value::getKey() const
+{
+	const char* key = getKeyCString();
+	return key ? LLSD::String(key, node().mKeyLength) : LLSD::String();
+}
+
+const char* LLSDDocument::Value::getKeyCString() const
+{
+	if (!mDocument || node().mKey == NO_KEY)
+	{
+		return NULL;
+	}
+	return mDocument->arena(node().mKey);
+}
+
+LLSDDocument::Value LLSDDocument::Value::get(const char* key, size_t length) const
+{
+	if (!isMap())
+	{
+		return Value();
+	}
+	const Node& map = node();
+	const U32* first = &mDocument->mChildren[0] + map.mOffset;
+	const U32* last = first + map.mSize;
+	while (first < last)
+	{
+		const U32* mid = first + (last - first) / 2;
+		const Node& child = mDocument->mNodes[*mid];
+		int res = compare_keys(mDocument->arena(child.mKey), child.mKeyLength, key, (U32)length);
+		if (res == 0)
+		{
+			return Value(mDocument, *mid);
+		}
+		if (res < 0)
+		{
+			first = mid + 1;
+		}
+		else
+		{
+			last = mid;
+		}
+	}
+	return Value();
+}
+
+LLSDDocument::Value LLSDDocument::Value::get(LLSD::Integer index) const
+{
+	if (!isArray() || index < 0 || index >= (S32)node().mSize)
+	{
+		return Value();
+	}
+	return Value(mDocument, mDocument->mChildren[node().mOffset + index]);
+}
+
+LLSDDocument::Value::const_iterator LLSDDocument::Value::begin() const
+{
+	if (node().mSize == 0)
+	{
+		return const_iterator();
+	}
+	return const_iterator(mDocument, &mDocument->mChildren[0] + node().mOffset);
+}
+
+LLSDDocument::Value::const_iterator LLSDDocument::Value::end() const
+{
+	if (node().mSize == 0)
+	{
+		return const_iterator();
+	}
+	return const_iterator(mDocument, &mDocument->mChildren[0] + node().mOffset + node().mSize);
+}
+
+LLSD LLSDDocument::Value::scalarToLLSD() const
+{
+	switch (type())
+	{
+	  case LLSD::TypeBoolean:	return LLSD(node().mBoolean);
+	  case LLSD::TypeInteger:	return LLSD(node().mInteger);
+	  case LLSD::TypeReal:		return LLSD(node().mReal);
+	  case LLSD::TypeString:	return LLSD(asString());
+	  case LLSD::TypeUUID:		return LLSD(asUUID());
+	  case LLSD::TypeDate:		return LLSD(asDate());
+	  case LLSD::TypeURI:		return LLSD(asURI());
+	  case LLSD::TypeBinary:	return LLSD(asBinary());
+	  default:					return LLSD();
+	}
+}
+
+LLSD LLSDDocument::Value::toLLSD() const
+{
+	if (isMap())
+	{
+		LLSD map = LLSD::emptyMap();
+		for (const_iterator it = begin(); it != end(); ++it)
+		{
+			Value child = *it;
+			map.insert(child.getKey(), child.toLLSD());
+		}
+		return map;
+	}
+	if (isArray())
+	{
+		LLSD array = LLSD::emptyArray();
+		for (const_iterator it = begin(); it != end(); ++it)
+		{
+			array.append((*it).toLLSD());
+		}
+		return array;
+	}
+	return scalarToLLSD();
+}
+
+//============================================================================
+// LLSDDocument
+
+LLSDDocument::LLSDDocument()
+{
+	clear();
+}
+
+LLSDDocument::~LLSDDocument()
+{
+}
+
+void LLSDDocument::clear()
+{
+	mNodes.clear();
+	mArena.clear();
+	mChildren.clear();
+	mOpen.clear();
+	mPendingKey = 0;
+	mPendingKeyLength = 0;
+	mHasPendingKey = false;
+	mError = false;
+	mFinished = false;
+}
+
+size_t LLSDDocument::getMemoryUsage() const
+{
+	return sizeof(*this)
+		+ mNodes.capacity() * sizeof(Node)
+		+ mArena.capacity()
+		+ mChildren.capacity() * sizeof(U32)
+		+ mOpen.capacity() * sizeof(U32);
+}
+
+void LLSDDocument::reserve(S32 nodes, size_t arena_bytes)
+{
+	mNodes.reserve(nodes);
+	mChildren.reserve(nodes);
+	mArena.reserve(arena_bytes);
+}
+
+void LLSDDocument::assign(const LLSD& sd)
+{
+	clear();
+	assignValue(sd);
+	finish();
+}
+
+void LLSDDocument::assignValue(const LLSD& sd)
+{
+	switch (sd.type())
+	{
+	  case LLSD::TypeMap:
+		beginMap(sd.size());
+		for (LLSD::map_const_iterator it = sd.beginMap(); it != sd.endMap(); ++it)
+		{
+			key(it->first);
+			assignValue(it->second);
+		}
+		end();
+		break;
+	  case LLSD::TypeArray:
+		beginArray(sd.size());
+		for (LLSD::array_const_iterator it = sd.beginArray(); it != sd.endArray(); ++it)
+		{
+			assignValue(*it);
+		}
+		end();
+		break;
+	  case LLSD::TypeBoolean:	addBoolean(sd.asBoolean()); break;
+	  case LLSD::TypeInteger:	addInteger(sd.asInteger()); break;
+	  case LLSD::TypeReal:		addReal(sd.asReal()); break;
+	  case LLSD::TypeString:	addString(sd.asString()); break;
+	  case LLSD::TypeUUID:		addUUID(sd.asUUID()); break;
+	  case LLSD::TypeDate:		addDate(sd.asDate()); break;
+	  case LLSD::TypeURI:		addURI(sd.asURI()); break;
+	  case LLSD::TypeBinary:
+	  {
+		const LLSD::Binary& data = sd.asBinary();
+		addBinary(data.empty() ? NULL : &data[0], data.size());
+		break;
+	  }
+	  default:
+		addUndefined();
+		break;
+	}
+}
+
+U32 LLSDDocument::addToArena(const void* data, size_t length, bool terminate)
+{
+	U32 offset = (U32)mArena.size();
+	mArena.resize(offset + length + (terminate ? 1 : 0));
+	if (length && data)
+	{
+		memcpy(&mArena[offset], data, length);	/* Flawfinder: ignore */
+	}
+	if (terminate)
+	{
+		mArena[offset + length] = '\0';
+	}
+	return offset;
+}
+
+LLSDDocument::Node& LLSDDocument::addNode(LLSD::Type type)
+{
+	if (mFinished)
+	{
+		mError = true;
+	}
+	if (mOpen.empty())
+	{
+		if (!mNodes.empty())
+		{
+			// only one top level value
+			mError = true;
+		}
+	}
+	else if (mNodes[mOpen.back()].mType == LLSD::TypeMap && !mHasPendingKey)
+	{
+		mError = true;
+	}
+	U32 index = (U32)mNodes.size();
+	mNodes.resize(index + 1);
+	Node& node = mNodes[index];
+	node.mType = (U8)type;
+	node.mKey = mHasPendingKey ? mPendingKey : NO_KEY;
+	node.mKeyLength = mPendingKeyLength;
+	node.mSize = 0;
+	node.mNext = index + 1;
+	node.mReal = 0.0;
+	mPendingKey = 0;
+	mPendingKeyLength = 0;
+	mHasPendingKey = false;
+	return node;
+}
+
+void LLSDDocument::beginContainer(LLSD::Type type, S32 size_hint)
+{
+	addNode(type);
+	mOpen.push_back((U32)mNodes.size() - 1);
+	if (size_hint > 0 && mNodes.capacity() < mNodes.size() + size_hint)
+	{
+		mNodes.reserve(llmax(mNodes.size() + size_hint, mNodes.capacity() * 2));
+	}
+}
+
+void LLSDDocument::beginMap(S32 size_hint)
+{
+	beginContainer(LLSD::TypeMap, size_hint);
+}
+
+void LLSDDocument::beginArray(S32 size_hint)
+{
+	beginContainer(LLSD::TypeArray, size_hint);
+}
+
+void LLSDDocument::key(const char* key, size_t length)
+{
+	if (!isInMap() || mHasPendingKey)
+	{
+		mError = true;
+		return;
+	}
+	mPendingKey = addToArena(key, length, true);
+	mPendingKeyLength = (U32)length;
+	mHasPendingKey = true;
+}
+
+void LLSDDocument::end()
+{
+	if (mOpen.empty() || mHasPendingKey)
+	{
+		mError = true;
+		return;
+	}
+	U32 index = mOpen.back();
+	mOpen.pop_back();
+
+	// Collect the children, then sort and dedupe map keys
+	U32 first_slot = (U32)mChildren.size();
+	U32 last = (U32)mNodes.size();
+	for (U32 child = index + 1; child < last; child = mNodes[child].mNext)
+	{
+		mChildren.push_back(child);
+	}
+	U32 count = (U32)mChildren.size() - first_slot;
+	if (count && mNodes[index].mType == LLSD::TypeMap)
+	{
+		std::vector<U32>::iterator begin = mChildren.begin() + first_slot;
+		KeyLess less(this);
+		std::stable_sort(begin, mChildren.end(), less);
+		std::vector<U32>::iterator out = begin;
+		for (std::vector<U32>::iterator it = begin + 1; it != mChildren.end(); ++it)
+		{
+			if (less(*out, *it))
+			{
+				*(++out) = *it;
+			}
+		}
+		count = (U32)(out - begin) + 1;
+		mChildren.resize(first_slot + count);
+	}
+
+	Node& node = mNodes[index];
+	node.mOffset = first_slot;
+	node.mSize = count;
+	node.mNext = last;
+}
+
+void LLSDDocument::addUndefined()
+{
+	addNode(LLSD::TypeUndefined);
+}
+
+void LLSDDocument::addBoolean(LLSD::Boolean value)
+{
+	addNode(LLSD::TypeBoolean).mBoolean = value;
+}
+
+void LLSDDocument::addInteger(LLSD::Integer value)
+{
+	addNode(LLSD::TypeInteger).mInteger = value;
+}
+
+void LLSDDocument::addReal(LLSD::Real value)
+{
+	addNode(LLSD::TypeReal).mReal = value;
+}
+
+void LLSDDocument::addString(const char* value, size_t length)
+{
+	U32 offset = addToArena(value, length, true);
+	Node& node = addNode(LLSD::TypeString);
+	node.mOffset = offset;
+	node.mSize = (U32)length;
+}
+
+void LLSDDocument::addUUID(const LLSD::UUID& value)
+{
+	U32 offset = addToArena(value.mData, UUID_BYTES, false);
+	addNode(LLSD::TypeUUID).mOffset = offset;
+}
+
+void LLSDDocument::addDate(const LLSD::Date& value)
+{
+	addNode(LLSD::TypeDate).mReal = value.secondsSinceEpoch();
+}
+
+void LLSDDocument::addURI(const char* value, size_t length)
+{
+	U32 offset = addToArena(value, length, true);
+	Node& node = addNode(LLSD::TypeURI);
+	node.mOffset = offset;
+	node.mSize = (U32)length;
+}
+
+void LLSDDocument::addURI(const LLSD::URI& value)
+{
+	std::string uri = value.asString();
+	addURI(uri.data(), uri.size());
+}
+
+void LLSDDocument::addBinary(const U8* data, size_t length)
+{
+	U32 offset = addToArena(data, length, true);
+	Node& node = addNode(LLSD::TypeBinary);
+	node.mOffset = offset;
+	node.mSize = (U32)length;
+}
+
+char* LLSDDocument::allocateString(size_t length)
+{
+	addString(NULL, length);
+	return &mArena[0] + mNodes.back().mOffset;
+}
+
+U8* LLSDDocument::allocateBinary(size_t length)
+{
+	addBinary(NULL, length);
+	return (U8*)&mArena[0] + mNodes.back().mOffset;
+}
+
+bool LLSDDocument::finish()
+{
+	if (mError || !mOpen.empty() || mHasPendingKey || mNodes.empty())
+	{
+		llwarns << "Incomplete or invalid LLSD document, " << mNodes.size() << " nodes" << llendl;
+		mFinished = false;
+		return false;
+	}
+	mFinished = true;
+	return true;
+}
@@ -0,0 +1,247 @@
+/**
+ * @file llsddocument.h
+ * @brief Flat, arena backed, read only LLSD document.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSDDOCUMENT_H
+#define LL_LLSDDOCUMENT_H
+
+#include <boost/noncopyable.hpp>
+
+#include "llsd.h"
+#include "llsdserialize.h"
+
+// LLSDDocument holds a whole LLSD tree in two flat buffers: one vector of
+// fixed size nodes in document order and one byte arena for keys, strings,
+// uuids and binary data. Parsing a large payload into it costs a handful of
+// allocations instead of one (or more) per LLSD node.
+//
+// A document is built once, either by LLSDParser::parse(istr, doc, max_bytes),
+// as the LLSDParseHandler of LLSDBinaryStreamParser, or by hand with the
+// begin/key/add/end calls, followed by finish(). It is read only
+// afterwards. Read it through root(), which returns a Value with the same
+// read API as LLSD. Map children are iterated in key order, like LLSD. If
+// a map has the same key twice the first one wins, like LLSD::insert().
+//
+// Values only point into the document; they are invalidated when the
+// document is cleared or destroyed.
+//
+// Example:
+//	LLSDDocument doc;
+//	LLPointer<LLSDParser> parser = new LLSDBinaryParser;
+//	if (parser->parse(istr, doc, size) > 0)
+//	{
+//		LLSDDocument::Value items = doc.root()["items"];
+//		for (LLSDDocument::Value::const_iterator it = items.beginArray(); it != items.endArray(); ++it)
+//		{
+//			LLUUID id = (*it)["item_id"].asUUID();
+//		}
+//	}
+
+class LL_COMMON_API LLSDDocument : public LLSDParseHandler, private boost::noncopyable
+{
+private:
+	struct Node
+	{
+		U8 mType; // LLSD::Type
+		U32 mKey; // arena offset of the key when the parent is a map, NO_KEY otherwise
+		U32 mKeyLength;
+		U32 mSize; // children for containers, bytes for strings, uris and binaries
+		U32 mNext; // index of the next sibling
+		union
+		{
+			LLSD::Boolean mBoolean;
+			LLSD::Integer mInteger;
+			LLSD::Real mReal; // reals and dates (seconds since epoch)
+			U32 mOffset; // arena offset for strings, uris, uuids and binaries,
+						 // first slot in mChildren for containers
+		};
+	};
+
+public:
+	class Value;
+	friend class Value;
+
+	class LL_COMMON_API Value
+	{
+	public:
+		class const_iterator
+		{
+		public:
+			const_iterator() : mDocument(NULL), mSlot(NULL) {}
+			Value operator*() const { return Value(mDocument, *mSlot); }
+			const_iterator& operator++() { ++mSlot; return *this; }
+			bool operator==(const const_iterator& rhs) const { return mSlot == rhs.mSlot; }
+			bool operator!=(const const_iterator& rhs) const { return mSlot != rhs.mSlot; }
+		private:
+			friend class Value;
+			const_iterator(const LLSDDocument* doc, const U32* slot) : mDocument(doc), mSlot(slot) {}
+			const LLSDDocument* mDocument;
+			const U32* mSlot;
+		};
+
+		Value() : mDocument(NULL), mIndex(0) {}
+
+		LLSD::Type type() const { return mDocument ? (LLSD::Type)node().mType : LLSD::TypeUndefined; }
+		bool isUndefined() const	{ return type() == LLSD::TypeUndefined; }
+		bool isDefined() const		{ return type() != LLSD::TypeUndefined; }
+		bool isBoolean() const		{ return type() == LLSD::TypeBoolean; }
+		bool isInteger() const		{ return type() == LLSD::TypeInteger; }
+		bool isReal() const			{ return type() == LLSD::TypeReal; }
+		bool isString() const		{ return type() == LLSD::TypeString; }
+		bool isUUID() const			{ return type() == LLSD::TypeUUID; }
+		bool isDate() const			{ return type() == LLSD::TypeDate; }
+		bool isURI() const			{ return type() == LLSD::TypeURI; }
+		bool isBinary() const		{ return type() == LLSD::TypeBinary; }
+		bool isMap() const			{ return type() == LLSD::TypeMap; }
+		bool isArray() const		{ return type() == LLSD::TypeArray; }
+
+		// Conversions follow the LLSD rules, containers convert to the default value.
+		LLSD::Boolean	asBoolean() const;
+		LLSD::Integer	asInteger() const;
+		LLSD::Real		asReal() const;
+		LLSD::String	asString() const;
+		LLSD::UUID		asUUID() const;
+		LLSD::Date		asDate() const;
+		LLSD::URI		asURI() const;
+		LLSD::Binary	asBinary() const;
+
+		// Direct access to the arena, no copy. The string is NUL terminated.
+		// Returns NULL (and 0) unless the value is a string, uri or binary.
+		const char* getCString() const;
+		const U8* getBinaryData() const { return (const U8*)getCString(); }
+		S32 getDataSize() const;
+
+		// Key of this value in its parent map, empty otherwise.
+		LLSD::String getKey() const;
+		const char* getKeyCString() const;
+
+		// Containers
+		S32 size() const { return (isMap() || isArray()) ? (S32)node().mSize : 0; }
+		// A key whose value is undefined is still there, like LLSD::has()
+		bool has(const LLSD::String& key) const { return get(key.data(), key.size()).mDocument != NULL; }
+		bool has(const char* key) const { return get(key, strlen(key)).mDocument != NULL; } /* Flawfinder: ignore */
+		Value get(const LLSD::String& key) const { return get(key.data(), key.size()); }
+		Value get(const char* key, size_t length) const;
+		Value get(LLSD::Integer index) const;
+		Value operator[](const LLSD::String& key) const { return get(key.data(), key.size()); }
+		Value operator[](const char* key) const { return get(key, strlen(key)); } /* Flawfinder: ignore */
+		Value operator[](LLSD::Integer index) const { return get(index); }
+
+		const_iterator beginMap() const { return isMap() ? begin() : const_iterator(); }
+		const_iterator endMap() const { return isMap() ? end() : const_iterator(); }
+		const_iterator beginArray() const { return isArray() ? begin() : const_iterator(); }
+		const_iterator endArray() const { return isArray() ? end() : const_iterator(); }
+
+		// Deep copy into a regular LLSD
+		LLSD toLLSD() const;
+
+	private:
+		friend class LLSDDocument;
+		Value(const LLSDDocument* doc, U32 index) : mDocument(doc), mIndex(index) {}
+		const Node& node() const { return mDocument->mNodes[mIndex]; }
+		const_iterator begin() const;
+		const_iterator end() const;
+		LLSD scalarToLLSD() const;
+
+		const LLSDDocument* mDocument;
+		U32 mIndex;
+	};
+
+public:
+	LLSDDocument();
+	~LLSDDocument();
+
+	void clear();
+	bool isEmpty() const { return mNodes.empty(); }
+	bool isFinished() const { return mFinished; }
+
+	// Undefined unless the document is finished
+	Value root() const { return mFinished ? Value(this, 0) : Value(); }
+	LLSD toLLSD() const { return root().toLLSD(); }
+
+	// Replaces the contents with a copy of sd
+	void assign(const LLSD& sd);
+
+	S32 getNodeCount() const { return (S32)mNodes.size(); }
+	size_t getArenaSize() const { return mArena.size(); }
+	size_t getMemoryUsage() const;
+
+	// Building. Values are added in document order: every value inside a
+	// map must be preceded by a call to key(). Misuse is not fatal but makes
+	// finish() fail.
+	void reserve(S32 nodes, size_t arena_bytes);
+	/*virtual*/ void beginMap(S32 size_hint = 0);
+	/*virtual*/ void beginArray(S32 size_hint = 0);
+	/*virtual*/ void key(const char* key, size_t length);
+	void key(const LLSD::String& key) { this->key(key.data(), key.size()); }
+	/*virtual*/ void end();
+	/*virtual*/ void addUndefined();
+	/*virtual*/ void addBoolean(LLSD::Boolean value);
+	/*virtual*/ void addInteger(LLSD::Integer value);
+	/*virtual*/ void addReal(LLSD::Real value);
+	/*virtual*/ void addString(const char* value, size_t length);
+	void addString(const LLSD::String& value) { addString(value.data(), value.size()); }
+	/*virtual*/ void addUUID(const LLSD::UUID& value);
+	/*virtual*/ void addDate(const LLSD::Date& value);
+	/*virtual*/ void addURI(const char* value, size_t length);
+	void addURI(const LLSD::URI& value);
+	/*virtual*/ void addBinary(const U8* data, size_t length);
+
+	// Add a string (or binary) of length bytes and return the arena space for
+	// it so a parser can read straight into the document. The pointer is only
+	// valid until the next call that adds to the document.
+	char* allocateString(size_t length);
+	U8* allocateBinary(size_t length);
+
+	// Closes the build, returns false if the structure is incomplete or invalid.
+	bool finish();
+
+	// Build state, for parsers
+	S32 getDepth() const { return (S32)mOpen.size(); }
+	bool isInMap() const { return !mOpen.empty() && mNodes[mOpen.back()].mType == LLSD::TypeMap; }
+
+private:
+	Node& addNode(LLSD::Type type);
+	U32 addToArena(const void* data, size_t length, bool terminate);
+	void beginContainer(LLSD::Type type, S32 size_hint);
+	void assignValue(const LLSD& sd);
+	const char* arena(U32 offset) const { return &mArena[0] + offset; }
+
+	struct KeyLess;
+
+	std::vector<Node> mNodes;
+	std::vector<char> mArena;
+	std::vector<U32> mChildren; // child node indices of every container, map children sorted by key
+
+	// Build state
+	std::vector<U32> mOpen; // open containers
+	U32 mPendingKey;
+	U32 mPendingKeyLength;
+	bool mHasPendingKey;
+	bool mError;
+	bool mFinished;
+};
+
+#endif // LL_LLSDDOCUMENT_H
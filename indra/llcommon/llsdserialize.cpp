@@ -40,6 +40,7 @@
 
 #include "lldate.h"
 #include "llsd.h"
+#include "llsddocument.h"
 #include "llstring.h"
 #include "lluri.h"
 
@@ -294,6 +295,46 @@ static const std::string NOTATION_FALSE_SERIAL("false");
 static const char BINARY_TRUE_SERIAL = '1';
 static const char BINARY_FALSE_SERIAL = '0';
 
+// A binary array element takes at least one byte and a map entry at least
+// three (an empty quoted key and a one byte value), so a container size
+// read off the wire can only be believed as far as the bytes left allow.
+// Without a byte limit nothing bounds it and no hint is given.
+static S32 container_size_hint(S32 size, bool map, bool check_limits, S32 bytes_left)
+{
+	if(!check_limits || size <= 0 || bytes_left <= 0)
+	{
+		return 0;
+	}
+	return llmin(size, bytes_left / (map ? 3 : 1));
+}
+
+
+// static
+S32 LLSDSerialize::fromBinary(LLSD& sd, const U8* data, S32 length)
+{
+	sd.clear();
+	LLSDBuilder builder(sd);
+	S32 parse_count = LLSDBinaryStreamParser::parse(data, length, builder);
+	if(parse_count <= 0)
+	{
+		sd.clear();
+	}
+	return parse_count;
+}
+
+// static
+S32 LLSDSerialize::fromBinary(LLSDDocument& doc, const U8* data, S32 length)
+{
+	doc.clear();
+	doc.reserve(length / 32, length);
+	S32 parse_count = LLSDBinaryStreamParser::parse(data, length, doc);
+	if((parse_count <= 0) || !doc.finish())
+	{
+		doc.clear();
+		return LLSDParser::PARSE_FAILURE;
+	}
+	return parse_count;
+}
 
 /**
  * LLSDParser
@@ -314,6 +355,29 @@ S32 LLSDParser::parse(std::istream& istr, LLSD& data, S32 max_bytes)
 	return doParse(istr, data);
 }
 
+S32 LLSDParser::parse(std::istream& istr, LLSDDocument& doc, S32 max_bytes)
+{
+	mCheckLimits = (LLSDSerialize::SIZE_UNLIMITED == max_bytes) ? false : true;
+	mMaxBytesLeft = max_bytes;
+	return doParseDocument(istr, doc);
+}
+
+// virtual
+S32 LLSDParser::doParseDocument(std::istream& istr, LLSDDocument& doc) const
+{
+	LLSD data;
+	S32 parse_count = doParse(istr, data);
+	if(parse_count > 0)
+	{
+		doc.assign(data);
+	}
+	else
+	{
+		doc.clear();
+	}
+	return parse_count;
+}
+
 
 // Parse using routine to get() lines, faster than parse()
 S32 LLSDParser::parseLines(std::istream& istr, LLSD& data)
@@ -1201,135 +1265,920 @@ bool LLSDBinaryParser::parseString(
 }
 
 
-/**
- * LLSDFormatter
- */
-LLSDFormatter::LLSDFormatter() :
-	mBoolAlpha(false)
-{
-}
-
 // virtual
-LLSDFormatter::~LLSDFormatter()
-{ }
-
-void LLSDFormatter::boolalpha(bool alpha)
+S32 LLSDBinaryParser::doParseDocument(std::istream& istr, LLSDDocument& doc) const
 {
-	mBoolAlpha = alpha;
+	doc.clear();
+	if(mCheckLimits && mMaxBytesLeft > 0)
+	{
+		// Strings can not be bigger than the stream, so this bounds the
+		// arena. The node guess is a typical value size, it grows if needed.
+		doc.reserve(mMaxBytesLeft / 32, mMaxBytesLeft);
+	}
+	S32 parse_count = parseDocumentValue(istr, doc);
+	if(parse_count > 0 && !doc.finish())
+	{
+		parse_count = PARSE_FAILURE;
+	}
+	if(parse_count <= 0)
+	{
+		doc.clear();
+	}
+	return parse_count;
 }
 
-void LLSDFormatter::realFormat(const std::string& format)
+S32 LLSDBinaryParser::parseDocumentValue(std::istream& istr, LLSDDocument& doc) const
 {
-	mRealFormat = format;
-}
+	// Same format and error handling as doParse(), see there.
+	char c;
+	c = get(istr);
+	if(!istr.good())
+	{
+		return 0;
+	}
+	S32 parse_count = 1;
+	switch(c)
+	{
+	case '{':
+	{
+		U32 value_nbo = 0;
+		read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+		S32 size = (S32)ntohl(value_nbo);
+		doc.beginMap(container_size_hint(size, true, mCheckLimits, mMaxBytesLeft));
+		S32 count = 0;
+		std::string name;
+		c = get(istr);
+		while(c != '}' && (count < size) && istr.good())
+		{
+			name.clear();
+			switch(c)
+			{
+			case 'k':
+				if(!parseString(istr, name))
+				{
+					return PARSE_FAILURE;
+				}
+				break;
+			case '\'':
+			case '"':
+			{
+				int cnt = deserialize_string_delim(istr, name, c);
+				if(PARSE_FAILURE == cnt) return PARSE_FAILURE;
+				account(cnt);
+				break;
+			}
+			}
+			doc.key(name);
+			S32 child_count = parseDocumentValue(istr, doc);
+			if(child_count <= 0)
+			{
+				// There must be a value for every key.
+				return PARSE_FAILURE;
+			}
+			parse_count += child_count;
+			++count;
+			c = get(istr);
+		}
+		if((c != '}') || (count < size))
+		{
+			return PARSE_FAILURE;
+		}
+		doc.end();
+		if(istr.fail())
+		{
+			llinfos << "STREAM FAILURE reading binary map." << llendl;
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
 
-void LLSDFormatter::formatReal(LLSD::Real real, std::ostream& ostr) const
-{
-	std::string buffer = llformat(mRealFormat.c_str(), real);
-	ostr << buffer;
-}
+	case '[':
+	{
+		U32 value_nbo = 0;
+		read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+		S32 size = (S32)ntohl(value_nbo);
+		doc.beginArray(container_size_hint(size, false, mCheckLimits, mMaxBytesLeft));
+		S32 count = 0;
+		c = istr.peek();
+		while((c != ']') && (count < size) && istr.good())
+		{
+			S32 child_count = parseDocumentValue(istr, doc);
+			if(PARSE_FAILURE == child_count)
+			{
+				return PARSE_FAILURE;
+			}
+			parse_count += child_count;
+			++count;
+			c = istr.peek();
+		}
+		c = get(istr);
+		if((c != ']') || (count < size))
+		{
+			return PARSE_FAILURE;
+		}
+		doc.end();
+		if(istr.fail())
+		{
+			llinfos << "STREAM FAILURE reading binary array." << llendl;
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
 
-/**
- * LLSDNotationFormatter
- */
-LLSDNotationFormatter::LLSDNotationFormatter()
-{
-}
+	case '!':
+		doc.addUndefined();
+		break;
 
-// virtual
-LLSDNotationFormatter::~LLSDNotationFormatter()
-{ }
+	case '0':
+		doc.addBoolean(false);
+		break;
 
-// static
-std::string LLSDNotationFormatter::escapeString(const std::string& in)
-{
-	std::ostringstream ostr;
-	serialize_string(in, ostr);
-	return ostr.str();
-}
+	case '1':
+		doc.addBoolean(true);
+		break;
 
-// virtual
-S32 LLSDNotationFormatter::format(const LLSD& data, std::ostream& ostr, U32 options) const
-{
-	S32 format_count = 1;
-	switch(data.type())
-	{
-	case LLSD::TypeMap:
+	case 'i':
 	{
-		ostr << "{";
-		bool need_comma = false;
-		LLSD::map_const_iterator iter = data.beginMap();
-		LLSD::map_const_iterator end = data.endMap();
-		for(; iter != end; ++iter)
+		U32 value_nbo = 0;
+		read(istr, (char*)&value_nbo, sizeof(U32));	 /*Flawfinder: ignore*/
+		doc.addInteger((S32)ntohl(value_nbo));
+		if(istr.fail())
 		{
-			if(need_comma) ostr << ",";
-			need_comma = true;
-			ostr << '\'';
-			serialize_string((*iter).first, ostr);
-			ostr << "':";
-			format_count += format((*iter).second, ostr);
+			llinfos << "STREAM FAILURE reading binary integer." << llendl;
 		}
-		ostr << "}";
 		break;
 	}
 
-	case LLSD::TypeArray:
+	case 'r':
 	{
-		ostr << "[";
-		bool need_comma = false;
-		LLSD::array_const_iterator iter = data.beginArray();
-		LLSD::array_const_iterator end = data.endArray();
-		for(; iter != end; ++iter)
+		F64 real_nbo = 0.0;
+		read(istr, (char*)&real_nbo, sizeof(F64));	 /*Flawfinder: ignore*/
+		doc.addReal(ll_ntohd(real_nbo));
+		if(istr.fail())
 		{
-			if(need_comma) ostr << ",";
-			need_comma = true;
-			format_count += format(*iter, ostr);
+			llinfos << "STREAM FAILURE reading binary real." << llendl;
 		}
-		ostr << "]";
 		break;
 	}
 
-	case LLSD::TypeUndefined:
-		ostr << "!";
+	case 'u':
+	{
+		LLUUID id;
+		read(istr, (char*)(&id.mData), UUID_BYTES);	 /*Flawfinder: ignore*/
+		doc.addUUID(id);
+		if(istr.fail())
+		{
+			llinfos << "STREAM FAILURE reading binary uuid." << llendl;
+		}
 		break;
+	}
 
-	case LLSD::TypeBoolean:
-		if(mBoolAlpha ||
-#if( LL_WINDOWS || __GNUC__ > 2)
-		   (ostr.flags() & std::ios::boolalpha)
-#else
-		   (ostr.flags() & 0x0100)
-#endif
-			)
+	case '\'':
+	case '"':
+	{
+		std::string value;
+		int cnt = deserialize_string_delim(istr, value, c);
+		if(PARSE_FAILURE == cnt)
 		{
-			ostr << (data.asBoolean()
-					 ? NOTATION_TRUE_SERIAL : NOTATION_FALSE_SERIAL);
+			parse_count = PARSE_FAILURE;
 		}
 		else
 		{
-			ostr << (data.asBoolean() ? 1 : 0);
+			doc.addString(value);
+			account(cnt);
+		}
+		if(istr.fail())
+		{
+			llinfos << "STREAM FAILURE reading binary (notation-style) string."
+				<< llendl;
+			parse_count = PARSE_FAILURE;
 		}
 		break;
+	}
 
-	case LLSD::TypeInteger:
-		ostr << "i" << data.asInteger();
+	case 's':
+	{
+		if(!parseDocumentString(istr, doc, LLSD::TypeString))
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		if(istr.fail())
+		{
+			llinfos << "STREAM FAILURE reading binary string." << llendl;
+			parse_count = PARSE_FAILURE;
+		}
 		break;
+	}
 
-	case LLSD::TypeReal:
-		ostr << "r";
-		if(mRealFormat.empty())
+	case 'l':
+	{
+		std::string value;
+		if(parseString(istr, value))
 		{
-			ostr << data.asReal();
+			doc.addURI(LLURI(value));
 		}
 		else
 		{
-			formatReal(data.asReal(), ostr);
+			parse_count = PARSE_FAILURE;
+		}
+		if(istr.fail())
+		{
+			llinfos << "STREAM FAILURE reading binary link." << llendl;
+			parse_count = PARSE_FAILURE;
 		}
 		break;
+	}
 
-	case LLSD::TypeUUID:
-		ostr << "u" << data.asUUID();
-		break;
+	case 'd':
+	{
+		F64 real = 0.0;
+		read(istr, (char*)&real, sizeof(F64));	 /*Flawfinder: ignore*/
+		doc.addDate(LLDate(real));
+		if(istr.fail())
+		{
+			llinfos << "STREAM FAILURE reading binary date." << llendl;
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'b':
+	{
+		if(!parseDocumentString(istr, doc, LLSD::TypeBinary))
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		if(istr.fail())
+		{
+			llinfos << "STREAM FAILURE reading binary." << llendl;
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	default:
+		parse_count = PARSE_FAILURE;
+		llinfos << "Unrecognized character while parsing: int(" << (int)c
+			<< ")" << llendl;
+		break;
+	}
+	return parse_count;
+}
+
+bool LLSDBinaryParser::parseDocumentString(
+	std::istream& istr,
+	LLSDDocument& doc,
+	LLSD::Type type) const
+{
+	U32 value_nbo = 0;
+	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	S32 size = (S32)ntohl(value_nbo);
+	if(size < 0 || (mCheckLimits && (size > mMaxBytesLeft))) return false;
+	char* buf = (type == LLSD::TypeBinary)
+		? (char*)doc.allocateBinary(size)
+		: doc.allocateString(size);
+	if(size)
+	{
+		account(fullread(istr, buf, size));
+	}
+	return true;
+}
+
+
+/**
+ * LLSDBuilder
+ */
+LLSDBuilder::LLSDBuilder(LLSD& result) :
+	mResult(result)
+{
+}
+
+LLSD& LLSDBuilder::add()
+{
+	if(mStack.empty())
+	{
+		return mResult;
+	}
+	LLSD& container = *mStack.back();
+	if(container.isArray())
+	{
+		container.append(LLSD());
+		return container[container.size() - 1];
+	}
+	if(container.has(mKey))
+	{
+		mDiscarded.push_back(LLSD());
+		return mDiscarded.back();
+	}
+	return container[mKey];
+}
+
+// virtual
+void LLSDBuilder::beginMap(S32 size_hint)
+{
+	LLSD& value = add();
+	value = LLSD::emptyMap();
+	mStack.push_back(&value);
+}
+
+// virtual
+void LLSDBuilder::beginArray(S32 size_hint)
+{
+	LLSD& value = add();
+	value = LLSD::emptyArray();
+	mStack.push_back(&value);
+}
+
+// virtual
+void LLSDBuilder::key(const char* key, size_t length)
+{
+	mKey.assign(key, length);
+}
+
+// virtual
+void LLSDBuilder::end()
+{
+	if(!mStack.empty())
+	{
+		mStack.pop_back();
+	}
+}
+
+// virtual
+void LLSDBuilder::addUndefined()
+{
+	add().clear();
+}
+
+// virtual
+void LLSDBuilder::addBoolean(LLSD::Boolean value)
+{
+	add() = value;
+}
+
+// virtual
+void LLSDBuilder::addInteger(LLSD::Integer value)
+{
+	add() = value;
+}
+
+// virtual
+void LLSDBuilder::addReal(LLSD::Real value)
+{
+	add() = value;
+}
+
+// virtual
+void LLSDBuilder::addString(const char* value, size_t length)
+{
+	add() = LLSD::String(value, length);
+}
+
+// virtual
+void LLSDBuilder::addUUID(const LLSD::UUID& value)
+{
+	add() = value;
+}
+
+// virtual
+void LLSDBuilder::addDate(const LLSD::Date& value)
+{
+	add() = value;
+}
+
+// virtual
+void LLSDBuilder::addURI(const char* value, size_t length)
+{
+	add() = LLURI(LLSD::String(value, length));
+}
+
+// virtual
+void LLSDBuilder::addBinary(const U8* data, size_t length)
+{
+	add() = LLSD::Binary(data, data + length);
+}
+
+
+/**
+ * LLSDBinaryStreamParser
+ */
+LLSDBinaryStreamParser::LLSDBinaryStreamParser(LLSDParseHandler& handler, S32 max_bytes) :
+	mHandler(handler),
+	mCur(NULL),
+	mEnd(NULL)
+{
+	reset(max_bytes);
+}
+
+void LLSDBinaryStreamParser::reset(S32 max_bytes)
+{
+	mStatus = STATUS_NEED_MORE;
+	mState = STATE_TYPE;
+	mToken = 0;
+	mDelimiter = 0;
+	mNeed = 0;
+	mEscaped = false;
+	mCheckLimits = (LLSDSerialize::SIZE_UNLIMITED != max_bytes);
+	mMaxBytesLeft = max_bytes;
+	mParseCount = 0;
+	mBytesUsed = 0;
+	mStack.clear();
+	mPending.clear();
+}
+
+LLSDBinaryStreamParser::EStatus LLSDBinaryStreamParser::feed(const U8* data, S32 length)
+{
+	mBytesUsed = 0;
+	if(mStatus != STATUS_NEED_MORE)
+	{
+		return mStatus;
+	}
+	mCur = data;
+	mEnd = data + length;
+	while(mStatus == STATUS_NEED_MORE && step())
+	{
+	}
+	mBytesUsed = (S32)(mCur - data);
+	mCur = NULL;
+	mEnd = NULL;
+	return mStatus;
+}
+
+// static
+S32 LLSDBinaryStreamParser::parse(const U8* data, S32 length, LLSDParseHandler& handler)
+{
+	LLSDBinaryStreamParser parser(handler, length);
+	if(parser.feed(data, length) != STATUS_DONE)
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
+	return parser.getParseCount();
+}
+
+void LLSDBinaryStreamParser::fail(const char* reason)
+{
+	llinfos << "Binary LLSD stream parse failure: " << reason << llendl;
+	mStatus = STATUS_ERROR;
+}
+
+// Returns the next bytes of input, in place when the current piece holds
+// all of them, otherwise collected in mPending. Returns NULL when the piece
+// runs out first or on error. Callers clear mPending once the data is used.
+const U8* LLSDBinaryStreamParser::need(S32 bytes)
+{
+	if(bytes == 0)
+	{
+		return (const U8*)"";
+	}
+	const U8* data = NULL;
+	S32 available = (S32)(mEnd - mCur);
+	S32 taken = 0;
+	if(mPending.empty() && available >= bytes)
+	{
+		data = mCur;
+		taken = bytes;
+	}
+	else
+	{
+		taken = llmin(bytes - (S32)mPending.size(), available);
+		mPending.insert(mPending.end(), mCur, mCur + taken);
+		if((S32)mPending.size() == bytes)
+		{
+			data = &mPending[0];
+		}
+	}
+	mCur += taken;
+	if(mCheckLimits)
+	{
+		mMaxBytesLeft -= taken;
+		if(mMaxBytesLeft < 0)
+		{
+			fail("exceeded the byte limit");
+			return NULL;
+		}
+	}
+	return data;
+}
+
+bool LLSDBinaryStreamParser::closeContainer(bool terminated)
+{
+	// Same rule as LLSDBinaryParser: correctly terminated and as many
+	// children as were said to be there.
+	if(!terminated || (mStack.back().mCount < mStack.back().mSize))
+	{
+		fail("bad container");
+		return false;
+	}
+	mStack.pop_back();
+	mHandler.end();
+	valueDone();
+	return true;
+}
+
+void LLSDBinaryStreamParser::valueDone()
+{
+	mState = STATE_TYPE;
+	if(mStack.empty())
+	{
+		mStatus = STATUS_DONE;
+		return;
+	}
+	Frame& frame = mStack.back();
+	++frame.mCount;
+	frame.mHaveKey = false;
+}
+
+bool LLSDBinaryStreamParser::step()
+{
+	switch(mState)
+	{
+	case STATE_TYPE:
+	{
+		const U8* data = need(1);
+		if(!data) return false;
+		char c = (char)*data;
+		mPending.clear();
+		if(!mStack.empty())
+		{
+			Frame& frame = mStack.back();
+			if(frame.mMap && !frame.mHaveKey)
+			{
+				if((c == '}') || (frame.mCount >= frame.mSize))
+				{
+					return closeContainer(c == '}');
+				}
+				switch(c)
+				{
+				case 'k':
+					mToken = 'k';
+					mState = STATE_LENGTH;
+					break;
+				case '\'':
+				case '"':
+					mToken = 'k';
+					mDelimiter = c;
+					mEscaped = false;
+					mState = STATE_DELIMITED;
+					break;
+				default:
+					// LLSDBinaryParser skips the byte and uses an empty key
+					mHandler.key("", 0);
+					frame.mHaveKey = true;
+					break;
+				}
+				return true;
+			}
+			if(!frame.mMap && ((c == ']') || (frame.mCount >= frame.mSize)))
+			{
+				return closeContainer(c == ']');
+			}
+		}
+
+		++mParseCount;
+		mToken = c;
+		switch(c)
+		{
+		case '{':
+		case '[':
+		case 'i':
+			mNeed = sizeof(U32);
+			mState = STATE_FIXED;
+			break;
+		case 'r':
+		case 'd':
+			mNeed = sizeof(F64);
+			mState = STATE_FIXED;
+			break;
+		case 'u':
+			mNeed = UUID_BYTES;
+			mState = STATE_FIXED;
+			break;
+		case 's':
+		case 'l':
+		case 'b':
+			mState = STATE_LENGTH;
+			break;
+		case '\'':
+		case '"':
+			mDelimiter = c;
+			mEscaped = false;
+			mState = STATE_DELIMITED;
+			break;
+		case '!':
+			mHandler.addUndefined();
+			valueDone();
+			break;
+		case '0':
+			mHandler.addBoolean(false);
+			valueDone();
+			break;
+		case '1':
+			mHandler.addBoolean(true);
+			valueDone();
+			break;
+		default:
+			fail("unrecognized character");
+			return false;
+		}
+		return true;
+	}
+
+	case STATE_FIXED:
+	{
+		const U8* data = need(mNeed);
+		if(!data) return false;
+		switch(mToken)
+		{
+		case '{':
+		case '[':
+		{
+			U32 size_nbo = 0;
+			memcpy(&size_nbo, data, sizeof(U32));		/* Flawfinder: ignore */
+			S32 size = (S32)ntohl(size_nbo);
+			if(size < 0)
+			{
+				fail("bad container size");
+				return false;
+			}
+			Frame frame;
+			frame.mMap = (mToken == '{');
+			frame.mHaveKey = false;
+			frame.mSize = size;
+			frame.mCount = 0;
+			mStack.push_back(frame);
+			S32 size_hint = container_size_hint(size, frame.mMap, mCheckLimits, mMaxBytesLeft);
+			if(frame.mMap)
+			{
+				mHandler.beginMap(size_hint);
+			}
+			else
+			{
+				mHandler.beginArray(size_hint);
+			}
+			mPending.clear();
+			mState = STATE_TYPE;
+			return true;
+		}
+		case 'i':
+		{
+			U32 value_nbo = 0;
+			memcpy(&value_nbo, data, sizeof(U32));		/* Flawfinder: ignore */
+			mHandler.addInteger((S32)ntohl(value_nbo));
+			break;
+		}
+		case 'r':
+		{
+			F64 real_nbo = 0.0;
+			memcpy(&real_nbo, data, sizeof(F64));		/* Flawfinder: ignore */
+			mHandler.addReal(ll_ntohd(real_nbo));
+			break;
+		}
+		case 'd':
+		{
+			F64 real = 0.0;
+			memcpy(&real, data, sizeof(F64));			/* Flawfinder: ignore */
+			mHandler.addDate(LLDate(real));
+			break;
+		}
+		case 'u':
+		{
+			LLUUID id;
+			memcpy(id.mData, data, UUID_BYTES);			/* Flawfinder: ignore */
+			mHandler.addUUID(id);
+			break;
+		}
+		}
+		mPending.clear();
+		valueDone();
+		return true;
+	}
+
+	case STATE_LENGTH:
+	{
+		const U8* data = need(sizeof(U32));
+		if(!data) return false;
+		U32 size_nbo = 0;
+		memcpy(&size_nbo, data, sizeof(U32));			/* Flawfinder: ignore */
+		mPending.clear();
+		S32 size = (S32)ntohl(size_nbo);
+		if((size < 0) || (mCheckLimits && (size > mMaxBytesLeft)))
+		{
+			fail("bad string size");
+			return false;
+		}
+		mNeed = size;
+		mState = STATE_BODY;
+		return true;
+	}
+
+	case STATE_BODY:
+	{
+		const U8* data = need(mNeed);
+		if(!data) return false;
+		switch(mToken)
+		{
+		case 'k':
+			mHandler.key((const char*)data, mNeed);
+			mStack.back().mHaveKey = true;
+			mPending.clear();
+			mState = STATE_TYPE;
+			return true;
+		case 's':
+			mHandler.addString((const char*)data, mNeed);
+			break;
+		case 'l':
+			mHandler.addURI((const char*)data, mNeed);
+			break;
+		case 'b':
+			mHandler.addBinary(data, mNeed);
+			break;
+		}
+		mPending.clear();
+		valueDone();
+		return true;
+	}
+
+	case STATE_DELIMITED:
+	{
+		// Find the closing delimiter, then let deserialize_string_delim()
+		// do the unescaping. Only hand written LLSD uses these.
+		while(mCur < mEnd)
+		{
+			char c = (char)*mCur++;
+			if(mCheckLimits && (--mMaxBytesLeft < 0))
+			{
+				fail("exceeded the byte limit");
+				return false;
+			}
+			mPending.push_back(c);
+			if(mEscaped)
+			{
+				mEscaped = false;
+			}
+			else if(c == '\\')
+			{
+				mEscaped = true;
+			}
+			else if(c == mDelimiter)
+			{
+				std::string value;
+				std::istringstream istr(std::string(mPending.begin(), mPending.end()));
+				mPending.clear();
+				if(LLSDParser::PARSE_FAILURE == deserialize_string_delim(istr, value, mDelimiter))
+				{
+					fail("bad delimited string");
+					return false;
+				}
+				if(mToken == 'k')
+				{
+					mHandler.key(value.data(), value.size());
+					mStack.back().mHaveKey = true;
+					mState = STATE_TYPE;
+				}
+				else
+				{
+					mHandler.addString(value.data(), value.size());
+					valueDone();
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+	}
+	return false;
+}
+
+
+/**
+ * LLSDFormatter
+ */
+LLSDFormatter::LLSDFormatter() :
+	mBoolAlpha(false)
+{
+}
+
+// virtual
+LLSDFormatter::~LLSDFormatter()
+{ }
+
+void LLSDFormatter::boolalpha(bool alpha)
+{
+	mBoolAlpha = alpha;
+}
+
+void LLSDFormatter::realFormat(const std::string& format)
+{
+	mRealFormat = format;
+}
+
+void LLSDFormatter::formatReal(LLSD::Real real, std::ostream& ostr) const
+{
+	std::string buffer = llformat(mRealFormat.c_str(), real);
+	ostr << buffer;
+}
+
+/**
+ * LLSDNotationFormatter
+ */
+LLSDNotationFormatter::LLSDNotationFormatter()
+{
+}
+
+// virtual
+LLSDNotationFormatter::~LLSDNotationFormatter()
+{ }
+
+// static
+std::string LLSDNotationFormatter::escapeString(const std::string& in)
+{
+	std::ostringstream ostr;
+	serialize_string(in, ostr);
+	return ostr.str();
+}
+
+// virtual
+S32 LLSDNotationFormatter::format(const LLSD& data, std::ostream& ostr, U32 options) const
+{
+	S32 format_count = 1;
+	switch(data.type())
+	{
+	case LLSD::TypeMap:
+	{
+		ostr << "{";
+		bool need_comma = false;
+		LLSD::map_const_iterator iter = data.beginMap();
+		LLSD::map_const_iterator end = data.endMap();
+		for(; iter != end; ++iter)
+		{
+			if(need_comma) ostr << ",";
+			need_comma = true;
+			ostr << '\'';
+			serialize_string((*iter).first, ostr);
+			ostr << "':";
+			format_count += format((*iter).second, ostr);
+		}
+		ostr << "}";
+		break;
+	}
+
+	case LLSD::TypeArray:
+	{
+		ostr << "[";
+		bool need_comma = false;
+		LLSD::array_const_iterator iter = data.beginArray();
+		LLSD::array_const_iterator end = data.endArray();
+		for(; iter != end; ++iter)
+		{
+			if(need_comma) ostr << ",";
+			need_comma = true;
+			format_count += format(*iter, ostr);
+		}
+		ostr << "]";
+		break;
+	}
+
+	case LLSD::TypeUndefined:
+		ostr << "!";
+		break;
+
+	case LLSD::TypeBoolean:
+		if(mBoolAlpha ||
+#if( LL_WINDOWS || __GNUC__ > 2)
+		   (ostr.flags() & std::ios::boolalpha)
+#else
+		   (ostr.flags() & 0x0100)
+#endif
+			)
+		{
+			ostr << (data.asBoolean()
+					 ? NOTATION_TRUE_SERIAL : NOTATION_FALSE_SERIAL);
+		}
+		else
+		{
+			ostr << (data.asBoolean() ? 1 : 0);
+		}
+		break;
+
+	case LLSD::TypeInteger:
+		ostr << "i" << data.asInteger();
+		break;
+
+	case LLSD::TypeReal:
+		ostr << "r";
+		if(mRealFormat.empty())
+		{
+			ostr << data.asReal();
+		}
+		else
+		{
+			formatReal(data.asReal(), ostr);
+		}
+		break;
+
+	case LLSD::TypeUUID:
+		ostr << "u" << data.asUUID();
+		break;
 
 	case LLSD::TypeString:
 		ostr << '\'';
@@ -1491,6 +2340,172 @@ void LLSDBinaryFormatter::formatString(
 	ostr.write(string.c_str(), string.size());
 }
 
+static U8* put_u32(U8* out, U32 value)
+{
+	U32 value_nbo = htonl(value);
+	memcpy(out, &value_nbo, sizeof(U32));		/* Flawfinder: ignore */
+	return out + sizeof(U32);
+}
+
+static U8* put_string(U8* out, const std::string& string)
+{
+	out = put_u32(out, string.size());
+	if(!string.empty())
+	{
+		memcpy(out, string.data(), string.size());	/* Flawfinder: ignore */
+	}
+	return out + string.size();
+}
+
+// static
+S32 LLSDBinaryFormatter::getFormattedSize(const LLSD& data)
+{
+	// Keep in sync with format()
+	switch(data.type())
+	{
+	case LLSD::TypeMap:
+	{
+		S32 size = 1 + sizeof(U32) + 1;
+		LLSD::map_const_iterator iter = data.beginMap();
+		LLSD::map_const_iterator end = data.endMap();
+		for(; iter != end; ++iter)
+		{
+			size += 1 + sizeof(U32) + (*iter).first.size();
+			size += getFormattedSize((*iter).second);
+		}
+		return size;
+	}
+	case LLSD::TypeArray:
+	{
+		S32 size = 1 + sizeof(U32) + 1;
+		LLSD::array_const_iterator iter = data.beginArray();
+		LLSD::array_const_iterator end = data.endArray();
+		for(; iter != end; ++iter)
+		{
+			size += getFormattedSize(*iter);
+		}
+		return size;
+	}
+	case LLSD::TypeInteger:
+		return 1 + sizeof(U32);
+	case LLSD::TypeReal:
+	case LLSD::TypeDate:
+		return 1 + sizeof(F64);
+	case LLSD::TypeUUID:
+		return 1 + UUID_BYTES;
+	case LLSD::TypeString:
+	case LLSD::TypeURI:
+		return 1 + sizeof(U32) + data.asString().size();
+	case LLSD::TypeBinary:
+		return 1 + sizeof(U32) + data.asBinary().size();
+	default:
+		return 1;
+	}
+}
+
+// static
+U8* LLSDBinaryFormatter::formatBuffer(const LLSD& data, U8* out)
+{
+	// Keep in sync with format()
+	switch(data.type())
+	{
+	case LLSD::TypeMap:
+	{
+		*out++ = '{';
+		out = put_u32(out, data.size());
+		LLSD::map_const_iterator iter = data.beginMap();
+		LLSD::map_const_iterator end = data.endMap();
+		for(; iter != end; ++iter)
+		{
+			*out++ = 'k';
+			out = put_string(out, (*iter).first);
+			out = formatBuffer((*iter).second, out);
+		}
+		*out++ = '}';
+		break;
+	}
+
+	case LLSD::TypeArray:
+	{
+		*out++ = '[';
+		out = put_u32(out, data.size());
+		LLSD::array_const_iterator iter = data.beginArray();
+		LLSD::array_const_iterator end = data.endArray();
+		for(; iter != end; ++iter)
+		{
+			out = formatBuffer(*iter, out);
+		}
+		*out++ = ']';
+		break;
+	}
+
+	case LLSD::TypeBoolean:
+		*out++ = data.asBoolean() ? BINARY_TRUE_SERIAL : BINARY_FALSE_SERIAL;
+		break;
+
+	case LLSD::TypeInteger:
+		*out++ = 'i';
+		out = put_u32(out, data.asInteger());
+		break;
+
+	case LLSD::TypeReal:
+	{
+		*out++ = 'r';
+		F64 value_nbo = ll_htond(data.asReal());
+		memcpy(out, &value_nbo, sizeof(F64));		/* Flawfinder: ignore */
+		out += sizeof(F64);
+		break;
+	}
+
+	case LLSD::TypeUUID:
+	{
+		*out++ = 'u';
+		LLUUID id = data.asUUID();
+		memcpy(out, id.mData, UUID_BYTES);		/* Flawfinder: ignore */
+		out += UUID_BYTES;
+		break;
+	}
+
+	case LLSD::TypeString:
+		*out++ = 's';
+		out = put_string(out, data.asString());
+		break;
+
+	case LLSD::TypeDate:
+	{
+		*out++ = 'd';
+		F64 value = data.asReal();
+		memcpy(out, &value, sizeof(F64));		/* Flawfinder: ignore */
+		out += sizeof(F64);
+		break;
+	}
+
+	case LLSD::TypeURI:
+		*out++ = 'l';
+		out = put_string(out, data.asString());
+		break;
+
+	case LLSD::TypeBinary:
+	{
+		*out++ = 'b';
+		const std::vector<U8> buffer = data.asBinary();
+		out = put_u32(out, buffer.size());
+		if(!buffer.empty())
+		{
+			memcpy(out, &buffer[0], buffer.size());	/* Flawfinder: ignore */
+			out += buffer.size();
+		}
+		break;
+	}
+
+	default:
+		// TypeUndefined
+		*out++ = '!';
+		break;
+	}
+	return out;
+}
+
 /**
  * local functions
  */
@@ -30,10 +30,13 @@
 #define LL_LLSDSERIALIZE_H
 
 #include <iosfwd>
+#include <list>
 #include "llpointer.h"
 #include "llrefcount.h"
 #include "llsd.h"
 
+class LLSDDocument;
+
 /** 
  * @class LLSDParser
  * @brief Abstract base class for LLSD parsers.
@@ -79,6 +82,21 @@ public:
 	 */
 	S32 parse(std::istream& istr, LLSD& data, S32 max_bytes);
 
+	/** 
+	 * @brief Call this method to parse a stream into a flat LLSDDocument.
+	 *
+	 * Same as parse() above, but builds the arena backed document
+	 * directly, which is much cheaper than an LLSD for large payloads.
+	 * @param istr The input stream.
+	 * @param doc[out] The newly parsed, finished document. Cleared on failure.
+	 * @param max_bytes The maximum number of bytes that will be in
+	 * the stream. Pass in LLSDSerialize::SIZE_UNLIMITED (-1) to set no
+	 * byte limit.
+	 * @return Returns the number of LLSD objects parsed into
+	 * doc. Returns PARSE_FAILURE (-1) on parse failure.
+	 */
+	S32 parse(std::istream& istr, LLSDDocument& doc, S32 max_bytes);
+
 	/** Like parse(), but uses a different call (istream.getline()) to read by lines
 	 *  This API is better suited for XML, where the parse cannot tell
 	 *  where the document actually ends.
@@ -108,6 +126,18 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data) const = 0;
 
+	/** 
+	 * @brief Virtual default function for parsing into a document.
+	 *
+	 * The default parses into an LLSD and copies it into doc. Parsers
+	 * that can build the document directly override this.
+	 * @param istr The input stream.
+	 * @param doc[out] The newly parsed, finished document.
+	 * @return Returns the number of LLSD objects parsed into
+	 * doc. Returns PARSE_FAILURE (-1) on parse failure.
+	 */
+	virtual S32 doParseDocument(std::istream& istr, LLSDDocument& doc) const;
+
 	/** 
 	 * @brief Virtual default function for resetting the parser
 	 */
@@ -319,6 +349,11 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data) const;
 
+	/** 
+	 * @brief Parse a stream straight into an LLSDDocument.
+	 */
+	virtual S32 doParseDocument(std::istream& istr, LLSDDocument& doc) const;
+
 	/** 
 	 * @brief Virtual default function for resetting the parser
 	 */
@@ -367,7 +402,33 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data) const;
 
+	/** 
+	 * @brief Parse a stream straight into an LLSDDocument.
+	 *
+	 * Strings and binaries are read directly into the document arena.
+	 */
+	virtual S32 doParseDocument(std::istream& istr, LLSDDocument& doc) const;
+
 private:
+	/** 
+	 * @brief Parse one value, and its children, into doc.
+	 *
+	 * @param istr The input stream.
+	 * @param doc The document to add the parsed value to.
+	 * @return Returns The number of LLSD objects parsed or PARSE_FAILURE.
+	 */
+	S32 parseDocumentValue(std::istream& istr, LLSDDocument& doc) const;
+
+	/** 
+	 * @brief Read a size prefixed string into the document arena.
+	 *
+	 * @param istr The input stream.
+	 * @param doc The document to add the string to.
+	 * @param type TypeString or TypeBinary.
+	 * @return Retuns true if a complete string was parsed.
+	 */
+	bool parseDocumentString(std::istream& istr, LLSDDocument& doc, LLSD::Type type) const;
+
 	/** 
 	 * @brief Parse a map from the istream
 	 *
@@ -605,6 +666,21 @@ public:
 	 */
 	virtual S32 format(const LLSD& data, std::ostream& ostr, U32 options = LLSDFormatter::OPTIONS_NONE) const;
 
+	/** 
+	 * @brief Returns the exact number of bytes format() writes for data.
+	 */
+	static S32 getFormattedSize(const LLSD& data);
+
+	/** 
+	 * @brief Format data straight into memory.
+	 *
+	 * Writes the same bytes as format() without going through a stream.
+	 * @param data The data to write.
+	 * @param out The destination, at least getFormattedSize(data) bytes.
+	 * @return Returns the end of the written data.
+	 */
+	static U8* formatBuffer(const LLSD& data, U8* out);
+
 protected:
 	/** 
 	 * @brief Helper method to serialize strings
@@ -788,6 +864,178 @@ public:
 		(void)p->parse(str, sd, max_bytes);
 		return sd;
 	}
+
+	/*
+	 * Binary memory span methods, no streams and no copies of the input
+	 */
+	static S32 fromBinary(LLSD& sd, const U8* data, S32 length);
+	static S32 fromBinary(LLSDDocument& doc, const U8* data, S32 length);
+	static void toBinary(const LLSD& sd, std::vector<U8>& out)
+	{
+		out.resize(LLSDBinaryFormatter::getFormattedSize(sd));
+		LLSDBinaryFormatter::formatBuffer(sd, &out[0]);
+	}
+};
+
+
+/** 
+ * @class LLSDParseHandler
+ * @brief Receives the values of LLSD as they are parsed, SAX style.
+ *
+ * Values arrive in document order. Containers are opened with
+ * beginMap() or beginArray() and closed with end(), and every value
+ * in a map is preceded by key(). Key, string, uri and binary data may
+ * point into the parser input and is only valid during the call.
+ * The container size hints are bounded by the bytes the parser still
+ * allows itself to read, and are zero when it has no limit.
+ */
+class LL_COMMON_API LLSDParseHandler
+{
+public:
+	virtual ~LLSDParseHandler() {}
+
+	virtual void beginMap(S32 size_hint) = 0;
+	virtual void beginArray(S32 size_hint) = 0;
+	virtual void key(const char* key, size_t length) = 0;
+	virtual void end() = 0;
+	virtual void addUndefined() = 0;
+	virtual void addBoolean(LLSD::Boolean value) = 0;
+	virtual void addInteger(LLSD::Integer value) = 0;
+	virtual void addReal(LLSD::Real value) = 0;
+	virtual void addString(const char* value, size_t length) = 0;
+	virtual void addUUID(const LLSD::UUID& value) = 0;
+	virtual void addDate(const LLSD::Date& value) = 0;
+	virtual void addURI(const char* value, size_t length) = 0;
+	virtual void addBinary(const U8* data, size_t length) = 0;
+};
+
+/** 
+ * @class LLSDBuilder
+ * @brief LLSDParseHandler which builds an LLSD.
+ *
+ * Like LLSD::insert(), the first of two equal keys in a map wins.
+ */
+class LL_COMMON_API LLSDBuilder : public LLSDParseHandler
+{
+public:
+	LLSDBuilder(LLSD& result);
+
+	/*virtual*/ void beginMap(S32 size_hint);
+	/*virtual*/ void beginArray(S32 size_hint);
+	/*virtual*/ void key(const char* key, size_t length);
+	/*virtual*/ void end();
+	/*virtual*/ void addUndefined();
+	/*virtual*/ void addBoolean(LLSD::Boolean value);
+	/*virtual*/ void addInteger(LLSD::Integer value);
+	/*virtual*/ void addReal(LLSD::Real value);
+	/*virtual*/ void addString(const char* value, size_t length);
+	/*virtual*/ void addUUID(const LLSD::UUID& value);
+	/*virtual*/ void addDate(const LLSD::Date& value);
+	/*virtual*/ void addURI(const char* value, size_t length);
+	/*virtual*/ void addBinary(const U8* data, size_t length);
+
+private:
+	LLSD& add();
+
+	LLSD& mResult;
+	std::vector<LLSD*> mStack;
+	std::string mKey;
+	std::list<LLSD> mDiscarded; // values with a duplicate key
+};
+
+/** 
+ * @class LLSDBinaryStreamParser
+ * @brief Incremental parser for binary LLSD held in memory.
+ *
+ * Feed the input in as many pieces as it arrives, for example the
+ * segments of an LLBufferArray channel, and the handler gets each
+ * value as soon as it is complete. Strings and binaries which lie
+ * entirely in one piece are handed over in place; only values split
+ * between two pieces are copied. Parsing stops at the end of the
+ * first complete value.
+ */
+class LL_COMMON_API LLSDBinaryStreamParser
+{
+public:
+	typedef enum e_status
+	{
+		STATUS_NEED_MORE,	// feed more input
+		STATUS_DONE,		// a complete value was parsed
+		STATUS_ERROR
+	} EStatus;
+
+	LLSDBinaryStreamParser(LLSDParseHandler& handler, S32 max_bytes = LLSDSerialize::SIZE_UNLIMITED);
+
+	/** 
+	 * @brief Start over for a new value.
+	 */
+	void reset(S32 max_bytes = LLSDSerialize::SIZE_UNLIMITED);
+
+	/** 
+	 * @brief Parse the next piece of input.
+	 *
+	 * @param data The input. Only needs to stay valid during the call.
+	 * @param length The number of bytes at data.
+	 * @return Returns the parser status after the piece.
+	 */
+	EStatus feed(const U8* data, S32 length);
+
+	EStatus getStatus() const { return mStatus; }
+
+	// Bytes of the last feed() that were used, less than the length when
+	// the value ended inside the piece.
+	S32 getBytesUsed() const { return mBytesUsed; }
+
+	// Number of LLSD objects parsed so far
+	S32 getParseCount() const { return mParseCount; }
+
+	/** 
+	 * @brief Parse one value out of a memory span.
+	 *
+	 * @return Returns the number of LLSD objects parsed or
+	 * LLSDParser::PARSE_FAILURE.
+	 */
+	static S32 parse(const U8* data, S32 length, LLSDParseHandler& handler);
+
+private:
+	typedef enum e_state
+	{
+		STATE_TYPE,			// next byte is a value type, a key or a container end
+		STATE_FIXED,		// mNeed bytes of payload for mToken
+		STATE_LENGTH,		// 4 byte size of a string, uri, binary or key
+		STATE_BODY,			// mNeed bytes of string, uri, binary or key
+		STATE_DELIMITED		// notation style quoted string
+	} EState;
+
+	struct Frame
+	{
+		bool mMap;
+		bool mHaveKey;
+		S32 mSize;
+		S32 mCount;
+	};
+
+	bool step();
+	const U8* need(S32 bytes);
+	bool closeContainer(bool terminated);
+	void valueDone();
+	void fail(const char* reason);
+
+	LLSDParseHandler& mHandler;
+	EStatus mStatus;
+	EState mState;
+	char mToken;
+	char mDelimiter;
+	S32 mNeed;
+	bool mEscaped;
+	bool mCheckLimits;
+	S32 mMaxBytesLeft;
+	S32 mParseCount;
+	S32 mBytesUsed;
+	std::vector<Frame> mStack;
+	std::vector<U8> mPending; // partial token carried over between pieces
+	const U8* mCur;
+	const U8* mEnd;
 };
 
 #endif // LL_LLSDSERIALIZE_H
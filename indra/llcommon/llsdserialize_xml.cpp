@@ -30,6 +30,8 @@
 #include <iostream>
 #include <deque>
 
+#include "llsddocument.h"
+
 #include "apr_base64.h"
 #include <boost/regex.hpp>
 
@@ -254,6 +256,7 @@ public:
 	~Impl();
 	
 	S32 parse(std::istream& input, LLSD& data);
+	S32 parse(std::istream& input, LLSDDocument& doc);
 	S32 parseLines(std::istream& input, LLSD& data);
 
 	void parsePart(const char *buf, int len);
@@ -272,6 +275,7 @@ private:
 	static void sCharacterDataHandler(
 		void* userData, const XML_Char* data, int length);
 
+	bool parseStream(std::istream& input);
 	void startSkipping();
 	
 	enum Element {
@@ -294,6 +298,9 @@ private:
 	
 	static const XML_Char* findAttribute(const XML_Char* name, const XML_Char** pairs);
 	
+	void startDocumentValue(Element element);
+	void endDocumentValue(Element element);
+
 
 	XML_Parser	mParser;
 
@@ -312,10 +319,14 @@ private:
 	
 	std::string mCurrentKey;		// Current XML <tag>
 	std::string mCurrentContent;	// String data between <tag> and </tag>
+
+	LLSDDocument* mDocument;		// Set while parsing into a document instead of mResult
+	std::vector<Element> mDocumentStack;	// Open value elements when building mDocument
 };
 
 
 LLSDXMLParser::Impl::Impl()
+:	mDocument(NULL)
 {
 	mParser = XML_ParserCreate(NULL);
 	reset();
@@ -355,6 +366,32 @@ static unsigned get_till_eol(std::istream& input, char *buf, unsigned bufsize)
 }
 
 S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
+{
+	if (!parseStream(input))
+	{
+		data = LLSD();
+		return LLSDParser::PARSE_FAILURE;
+	}
+	data = mResult;
+	return mParseCount;
+}
+
+S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSDDocument& doc)
+{
+	doc.clear();
+	mDocument = &doc;
+	mDocumentStack.clear();
+	bool success = parseStream(input);
+	mDocument = NULL;
+	if (!success || doc.isEmpty() || !doc.finish())
+	{
+		doc.clear();
+		return LLSDParser::PARSE_FAILURE;
+	}
+	return mParseCount;
+}
+
+bool LLSDXMLParser::Impl::parseStream(std::istream& input)
 {
 	XML_Status status;
 	
@@ -400,13 +437,11 @@ S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
 			((char*) buffer)[count ? count - 1 : 0] = '\0';
 		}
 		llinfos << "LLSDXMLParser::Impl::parse: XML_STATUS_ERROR parsing:" << (char*) buffer << llendl;
-		data = LLSD();
-		return LLSDParser::PARSE_FAILURE;
+		return false;
 	}
 
 	clear_eol(input);
-	data = mResult;
-	return mParseCount;
+	return true;
 }
 
 
@@ -498,6 +533,7 @@ void LLSDXMLParser::Impl::reset()
 	mGracefullStop = false;
 
 	mStack.clear();
+	mDocumentStack.clear();
 	
 	mSkipping = false;
 	
@@ -572,6 +608,44 @@ public:
 };
 #endif // XML_PARSER_PERFORMANCE_TESTS
 
+static S32 content_to_integer(const std::string& content)
+{
+	S32 i;
+	if ( sscanf(content.c_str(), "%d", &i ) == 1 )
+	{	// See if sscanf works - it's faster
+		return i;
+	}
+	return LLSD(content).asInteger();
+}
+
+static F64 content_to_real(const std::string& content)
+{
+	F64 r;
+	if ( sscanf(content.c_str(), "%lf", &r ) == 1 )
+	{	// See if sscanf works - it's faster
+		return r;
+	}
+	return LLSD(content).asReal();
+}
+
+static void content_to_binary(const std::string& content, std::vector<U8>& data)
+{
+	// Regex is expensive, but only fix for whitespace in base64,
+	// created by python and other non-linden systems - DEV-39358
+	// Fortunately we have very little binary passing now,
+	// so performance impact shold be negligible. + poppy 2009-09-04
+	boost::regex r;
+	r.assign("\\s");
+	std::string stripped = boost::regex_replace(content, r, "");
+	S32 len = apr_base64_decode_len(stripped.c_str());
+	data.resize(len);
+	if (len > 0)
+	{
+		len = apr_base64_decode_binary(&data[0], stripped.c_str());
+		data.resize(len);
+	}
+}
+
 void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Char** attributes)
 {
 	#ifdef XML_PARSER_PERFORMANCE_TESTS
@@ -596,6 +670,14 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 			return;
 	
 		case ELEMENT_KEY:
+			if (mDocument)
+			{
+				if (mDocumentStack.empty() || mDocumentStack.back() != ELEMENT_MAP)
+				{
+					return startSkipping();
+				}
+				return;
+			}
 			if (mStack.empty()  ||  !(mStack.back()->isMap()))
 			{
 				return startSkipping();
@@ -616,6 +698,8 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 	
 
 	if (!mInLLSDElement) { return startSkipping(); }
+
+	if (mDocument) { return startDocumentValue(element); }
 	
 	if (mStack.empty())
 	{
@@ -700,6 +784,13 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 	
 	if (!mInLLSDElement) { return; }
 
+	if (mDocument)
+	{
+		endDocumentValue(element);
+		mCurrentContent.clear();
+		return;
+	}
+
 	LLSD& value = *mStack.back();
 	mStack.pop_back();
 	
@@ -714,31 +805,11 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 			break;
 		
 		case ELEMENT_INTEGER:
-			{
-				S32 i;
-				if ( sscanf(mCurrentContent.c_str(), "%d", &i ) == 1 )
-				{	// See if sscanf works - it's faster
-					value = i;
-				}
-				else
-				{
-					value = LLSD(mCurrentContent).asInteger();
-				}
-			}
+			value = content_to_integer(mCurrentContent);
 			break;
 		
 		case ELEMENT_REAL:
-			{
-				F64 r;
-				if ( sscanf(mCurrentContent.c_str(), "%lf", &r ) == 1 )
-				{	// See if sscanf works - it's faster
-					value = r;
-				}
-				else
-				{
-					value = LLSD(mCurrentContent).asReal();
-				}
-			}
+			value = content_to_real(mCurrentContent);
 			break;
 		
 		case ELEMENT_STRING:
@@ -759,18 +830,8 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 		
 		case ELEMENT_BINARY:
 		{
-			// Regex is expensive, but only fix for whitespace in base64,
-			// created by python and other non-linden systems - DEV-39358
-			// Fortunately we have very little binary passing now,
-			// so performance impact shold be negligible. + poppy 2009-09-04
-			boost::regex r;
-			r.assign("\\s");
-			std::string stripped = boost::regex_replace(mCurrentContent, r, "");
-			S32 len = apr_base64_decode_len(stripped.c_str());
 			std::vector<U8> data;
-			data.resize(len);
-			len = apr_base64_decode_binary(&data[0], stripped.c_str());
-			data.resize(len);
+			content_to_binary(mCurrentContent, data);
 			value = data;
 			break;
 		}
@@ -787,6 +848,102 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 	mCurrentContent.clear();
 }
 
+// Document mode counterparts of the value handling in startElementHandler()
+// and endElementHandler(). mDocumentStack tracks the open value elements the
+// way mStack does for LLSD, containers are begun and ended in the document,
+// scalars are added when their element closes.
+void LLSDXMLParser::Impl::startDocumentValue(Element element)
+{
+	if (mDocumentStack.empty())
+	{
+		// only one top level value
+		if (!mDocument->isEmpty()) { return startSkipping(); }
+	}
+	else if (mDocumentStack.back() == ELEMENT_MAP)
+	{
+		if (mCurrentKey.empty()) { return startSkipping(); }
+		mDocument->key(mCurrentKey);
+		mCurrentKey.clear();
+	}
+	else if (mDocumentStack.back() != ELEMENT_ARRAY)
+	{
+		// improperly nested value in a non-structure
+		return startSkipping();
+	}
+
+	++mParseCount;
+	mDocumentStack.push_back(element);
+	switch (element)
+	{
+		case ELEMENT_MAP:
+			mDocument->beginMap();
+			break;
+
+		case ELEMENT_ARRAY:
+			mDocument->beginArray();
+			break;
+
+		default:
+			// all the other values are added in endDocumentValue()
+			;
+	}
+}
+
+void LLSDXMLParser::Impl::endDocumentValue(Element element)
+{
+	if (mDocumentStack.empty()) { return; }
+	mDocumentStack.pop_back();
+
+	switch (element)
+	{
+		case ELEMENT_MAP:
+		case ELEMENT_ARRAY:
+			mDocument->end();
+			break;
+
+		case ELEMENT_BOOL:
+			mDocument->addBoolean(mCurrentContent == "true" || mCurrentContent == "1");
+			break;
+
+		case ELEMENT_INTEGER:
+			mDocument->addInteger(content_to_integer(mCurrentContent));
+			break;
+
+		case ELEMENT_REAL:
+			mDocument->addReal(content_to_real(mCurrentContent));
+			break;
+
+		case ELEMENT_STRING:
+			mDocument->addString(mCurrentContent);
+			break;
+
+		case ELEMENT_UUID:
+			mDocument->addUUID(LLSD(mCurrentContent).asUUID());
+			break;
+
+		case ELEMENT_DATE:
+			mDocument->addDate(LLSD(mCurrentContent).asDate());
+			break;
+
+		case ELEMENT_URI:
+			mDocument->addURI(LLSD(mCurrentContent).asURI());
+			break;
+
+		case ELEMENT_BINARY:
+		{
+			std::vector<U8> data;
+			content_to_binary(mCurrentContent, data);
+			mDocument->addBinary(data.empty() ? NULL : &data[0], data.size());
+			break;
+		}
+
+		default:
+			// ELEMENT_UNDEF and ELEMENT_UNKNOWN
+			mDocument->addUndefined();
+			break;
+	}
+}
+
 void LLSDXMLParser::Impl::characterDataHandler(const XML_Char* data, int length)
 {
 	#ifdef XML_PARSER_PERFORMANCE_TESTS
@@ -919,6 +1076,12 @@ S32 LLSDXMLParser::doParse(std::istream& input, LLSD& data) const
 	return impl.parse(input, data);
 }
 
+// virtual
+S32 LLSDXMLParser::doParseDocument(std::istream& input, LLSDDocument& doc) const
+{
+	return impl.parse(input, doc);
+}
+
 //	virtual 
 void LLSDXMLParser::doReset()
 {
@@ -28,10 +28,49 @@
 #include "linden_common.h"
 
 #include "llstringtable.h"
+#include "llapr.h"
 #include "llstl.h"
 
 LLStringTable gStringTable(32768);
 
+namespace
+{
+	// Marks a slot whose entry was removed
+	char sRemovedMarker;
+	LLStringTableEntry* const REMOVED_ENTRY = (LLStringTableEntry*)&sRemovedMarker;
+
+	// Holds gStringTableLockp. Before ll_init_apr() creates it there is only
+	// the main thread, so tables built during static initialization don't lock.
+	class LLStringTableLock
+	{
+	public:
+		LLStringTableLock(bool exclusive)
+		:	mLockp(gStringTableLockp)
+		{
+			if (mLockp)
+			{
+				if (exclusive)
+				{
+					apr_thread_rwlock_wrlock(mLockp);
+				}
+				else
+				{
+					apr_thread_rwlock_rdlock(mLockp);
+				}
+			}
+		}
+		~LLStringTableLock()
+		{
+			if (mLockp)
+			{
+				apr_thread_rwlock_unlock(mLockp);
+			}
+		}
+	private:
+		apr_thread_rwlock_t* mLockp;
+	};
+}
+
 LLStringTableEntry::LLStringTableEntry(const char *str)
 : mString(NULL), mCount(1)
 {
@@ -50,7 +89,10 @@ LLStringTableEntry::~LLStringTableEntry()
 }
 
 LLStringTable::LLStringTable(int tablesize)
-: mUniqueEntries(0)
+:	mMaxEntries(0),
+	mUniqueEntries(0),
+	mSlots(NULL),
+	mNumRemoved(0)
 {
 	S32 i;
 	if (!tablesize)
@@ -67,65 +109,84 @@ LLStringTable::LLStringTable(int tablesize)
 			break;
 		}
 	}
-	mMaxEntries = tablesize;
+	resize(llmax(tablesize, 2));
+}
 
-#if !STRING_TABLE_HASH_MAP
-	// ALlocate strings
-	mStringList = new string_list_ptr_t[mMaxEntries];
-	// Clear strings
-	for (i = 0; i < mMaxEntries; i++)
+LLStringTable::~LLStringTable()
+{
+	for (S32 i = 0; i < mMaxEntries; i++)
 	{
-		mStringList[i] = NULL;
+		if (mSlots[i].mEntry && mSlots[i].mEntry != REMOVED_ENTRY)
+		{
+			delete mSlots[i].mEntry;
+		}
 	}
-#endif
+	delete [] mSlots;
+	mSlots = NULL;
 }
 
-LLStringTable::~LLStringTable()
+//static
+U32 LLStringTable::hashString(const char *str)
+{
+	// FNV-1a, the low bits are good enough to index the table with
+	U32 hash = 2166136261U;
+	while (*str)
+	{
+		hash ^= (U8)*str++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+LLStringTable::Slot* LLStringTable::findSlot(const char *str, U32 hash) const
 {
-#if !STRING_TABLE_HASH_MAP
-	if (mStringList)
+	// There is always an unused slot to end the probe
+	const U32 mask = (U32)mMaxEntries - 1;
+	for (U32 i = hash & mask; ; i = (i + 1) & mask)
 	{
-		for (S32 i = 0; i < mMaxEntries; i++)
+		Slot* slot = &mSlots[i];
+		if (!slot->mEntry)
 		{
-			if (mStringList[i])
-			{
-				string_list_t::iterator iter;
-				for (iter = mStringList[i]->begin(); iter != mStringList[i]->end(); iter++)
-					delete *iter; // *iter = (LLStringTableEntry*)
-			}
-			delete mStringList[i];
+			return NULL;
+		}
+		if (slot->mHash == hash
+			&& slot->mEntry != REMOVED_ENTRY
+			&& !strncmp(slot->mEntry->mString, str, MAX_STRINGS_LENGTH))
+		{
+			return slot;
 		}
-		delete [] mStringList;
-		mStringList = NULL;
 	}
-#else
-	// Need to clean up the string hash
-	for_each(mStringHash.begin(), mStringHash.end(), DeletePairedPointer());
-	mStringHash.clear();
-#endif
 }
 
-
-static U32 hash_my_string(const char *str, int max_entries)
+void LLStringTable::resize(S32 size)
 {
-	U32 retval = 0;
-#if 0
-	while (*str)
+	Slot* old_slots = mSlots;
+	const S32 old_size = mMaxEntries;
+
+	mSlots = new Slot[size];
+	for (S32 i = 0; i < size; i++)
 	{
-		retval <<= 1;
-		retval += *str++;
+		mSlots[i].mHash = 0;
+		mSlots[i].mEntry = NULL;
 	}
-#else
-	while (*str)
+	mMaxEntries = size;
+	mNumRemoved = 0;
+
+	const U32 mask = (U32)size - 1;
+	for (S32 i = 0; i < old_size; i++)
 	{
-		retval = (retval<<4) + *str;
-		U32 x = (retval & 0xf0000000);
-		if (x) retval = retval ^ (x>>24);
-		retval = retval & (~x);
-		str++;
+		const Slot& old_slot = old_slots[i];
+		if (old_slot.mEntry && old_slot.mEntry != REMOVED_ENTRY)
+		{
+			U32 j = old_slot.mHash & mask;
+			while (mSlots[j].mEntry)
+			{
+				j = (j + 1) & mask;
+			}
+			mSlots[j] = old_slot;
+		}
 	}
-#endif
-	return (retval & (max_entries-1)); // max_entries is gauranteed to be power of 2
+	delete [] old_slots;
 }
 
 char* LLStringTable::checkString(const std::string& str)
@@ -155,43 +216,13 @@ LLStringTableEntry* LLStringTable::checkStringEntry(const char *str)
 {
 	if (str)
 	{
-		char *ret_val;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-#if 1 // Microsoft
-		string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-		string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-		std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-		string_hash_t::iterator lower = P.first;
-		string_hash_t::iterator upper = P.second;
-#endif
-		for (string_hash_t::iterator iter = lower; iter != upper; iter++)
+		U32 hash_value = hashString(str);
+		LLStringTableLock lock(false);
+		Slot* slot = findSlot(str, hash_value);
+		if (slot)
 		{
-			entry = iter->second;
-			ret_val = entry->mString;
-			if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-			{
-				return entry;
-			}
+			return slot->mEntry;
 		}
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-		if (strlist)
-		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); iter++)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					return entry;
-				}
-			}
-		}
-#endif
 	}
 	return NULL;
 }
@@ -225,61 +256,40 @@ LLStringTableEntry* LLStringTable::addStringEntry(const char *str)
 {
 	if (str)
 	{
-		char *ret_val = NULL;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-#if 1 // Microsoft
-		string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-		string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-		std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-		string_hash_t::iterator lower = P.first;
-		string_hash_t::iterator upper = P.second;
-#endif
-		for (string_hash_t::iterator iter = lower; iter != upper; iter++)
+		U32 hash_value = hashString(str);
+		LLStringTableLock lock(true);
+		Slot* slot = findSlot(str, hash_value);
+		if (slot)
 		{
-			entry = iter->second;
-			ret_val = entry->mString;
-			if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-			{
-				entry->incCount();
-				return entry;
-			}
+			slot->mEntry->incCount();
+			return slot->mEntry;
 		}
 
-		// not found, so add!
-		LLStringTableEntry* newentry = new LLStringTableEntry(str);
-		ret_val = newentry->mString;
-		mStringHash.insert(string_hash_t::value_type(hash_value, newentry));
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-
-		if (strlist)
+		// Keep at most half the slots live, and a quarter never used so
+		// probes stay short
+		if ((mUniqueEntries + 1) * 2 > mMaxEntries)
 		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); iter++)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					entry->incCount();
-					return entry;
-				}
-			}
+			resize(mMaxEntries * 2);
 		}
-		else
+		else if ((mUniqueEntries + mNumRemoved + 1) * 4 > mMaxEntries * 3)
 		{
-			mStringList[hash_value] = new string_list_t;
-			strlist = mStringList[hash_value];
+			resize(mMaxEntries);
 		}
 
 		// not found, so add!
-		LLStringTableEntry *newentry = new LLStringTableEntry(str);
-		//ret_val = newentry->mString;
-		strlist->push_front(newentry);
-#endif
+		const U32 mask = (U32)mMaxEntries - 1;
+		U32 i = hash_value & mask;
+		while (mSlots[i].mEntry && mSlots[i].mEntry != REMOVED_ENTRY)
+		{
+			i = (i + 1) & mask;
+		}
+		if (mSlots[i].mEntry == REMOVED_ENTRY)
+		{
+			mNumRemoved--;
+		}
+		LLStringTableEntry* newentry = new LLStringTableEntry(str);
+		mSlots[i].mHash = hash_value;
+		mSlots[i].mEntry = newentry;
 		mUniqueEntries++;
 		return newentry;
 	}
@@ -293,66 +303,19 @@ void LLStringTable::removeString(const char *str)
 {
 	if (str)
 	{
-		char *ret_val;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-		{
-#if 1 // Microsoft
-			string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-			string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-			std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-			string_hash_t::iterator lower = P.first;
-			string_hash_t::iterator upper = P.second;
-#endif
-			for (string_hash_t::iterator iter = lower; iter != upper; iter++)
-			{
-				entry = iter->second;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					if (!entry->decCount())
-					{
-						mUniqueEntries--;
-						if (mUniqueEntries < 0)
-						{
-							llerror("LLStringTable:removeString trying to remove too many strings!", 0);
-						}
-						delete iter->second;
-						mStringHash.erase(iter);
-					}
-					return;
-				}
-			}
-		}
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-
-		if (strlist)
+		U32 hash_value = hashString(str);
+		LLStringTableLock lock(true);
+		Slot* slot = findSlot(str, hash_value);
+		if (slot && !slot->mEntry->decCount())
 		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); iter++)
+			mUniqueEntries--;
+			if (mUniqueEntries < 0)
 			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					if (!entry->decCount())
-					{
-						mUniqueEntries--;
-						if (mUniqueEntries < 0)
-						{
-							llerror("LLStringTable:removeString trying to remove too many strings!", 0);
-						}
-						strlist->remove(entry);
-						delete entry;
-					}
-					return;
-				}
+				llerror("LLStringTable:removeString trying to remove too many strings!", 0);
 			}
+			delete slot->mEntry;
+			slot->mEntry = REMOVED_ENTRY;
+			mNumRemoved++;
 		}
-#endif
 	}
 }
-
@@ -31,25 +31,8 @@
 #include "lldefs.h"
 #include "llformat.h"
 #include "llstl.h"
-#include <list>
 #include <set>
 
-#if LL_WINDOWS
-# if (_MSC_VER >= 1300 && _MSC_VER < 1400)
-#  define STRING_TABLE_HASH_MAP 1
-# endif
-#else
-//# define STRING_TABLE_HASH_MAP 1
-#endif
-
-#if STRING_TABLE_HASH_MAP
-# if LL_WINDOWS
-#  include <hash_map>
-# else
-#  include <ext/hash_map>
-# endif
-#endif
-
 const U32 MAX_STRINGS_LENGTH = 256;
 
 class LL_COMMON_API LLStringTableEntry
@@ -65,6 +48,11 @@ public:
 	S32  mCount;
 };
 
+// Interns strings with a reference count. Once APR is up, the table can be
+// used from any thread: lookups share a read lock, adds and removes take it
+// exclusively. The entries live in an open addressed table that stores each
+// string's hash next to it, so a probe only touches the strings whose hash
+// matches.
 class LL_COMMON_API LLStringTable
 {
 public:
@@ -82,21 +70,25 @@ public:
 	LLStringTableEntry *addStringEntry(const std::string& str);
 	void  removeString(const char *str);
 
+	// Size of the table, grows to keep it at most half full
 	S32 mMaxEntries;
 	S32 mUniqueEntries;
-	
-#if STRING_TABLE_HASH_MAP
-#if LL_WINDOWS
-	typedef std::hash_multimap<U32, LLStringTableEntry *> string_hash_t;
-#else
-	typedef __gnu_cxx::hash_multimap<U32, LLStringTableEntry *> string_hash_t;
-#endif
-	string_hash_t mStringHash;
-#else
-	typedef std::list<LLStringTableEntry *> string_list_t;
-	typedef string_list_t * string_list_ptr_t;
-	string_list_ptr_t	*mStringList;
-#endif	
+
+private:
+	struct Slot
+	{
+		U32 mHash;
+		LLStringTableEntry* mEntry;	// NULL if never used
+	};
+
+	static U32 hashString(const char *str);
+	// The slot holding str, or NULL
+	Slot* findSlot(const char *str, U32 hash) const;
+	void resize(S32 size);
+
+	Slot* mSlots;
+	// Slots whose entry was removed, they don't end a probe
+	S32 mNumRemoved;
 };
 
 extern LL_COMMON_API LLStringTable gStringTable;
@@ -510,11 +510,33 @@ LLCPUInfo::LLCPUInfo()
 	// proc.WriteInfoTextFile("procInfo.txt");
 	mHasSSE = proc.hasSSE();
 	mHasSSE2 = proc.hasSSE2();
+	mHasAVX2 = proc.hasAVX2();
+	mHasFMA = proc.hasFMA();
 	mHasAltivec = proc.hasAltivec();
 	mCPUMHz = (F64)proc.getCPUFrequency();
 	mFamily = proc.getCPUFamilyName();
 	mCPUString = "Unknown";
 
+	mNumCores = 1;
+#if LL_WINDOWS
+	SYSTEM_INFO sys_info;
+	GetSystemInfo(&sys_info);
+	mNumCores = llmax((U32)sys_info.dwNumberOfProcessors, (U32)1);
+#elif LL_DARWIN
+	int ncpu = 0;
+	size_t len = sizeof(ncpu);
+	if (sysctlbyname("hw.activecpu", &ncpu, &len, NULL, 0) == 0 && ncpu > 0)
+	{
+		mNumCores = (U32)ncpu;
+	}
+#elif LL_LINUX || LL_SOLARIS
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu > 0)
+	{
+		mNumCores = (U32)ncpu;
+	}
+#endif
+
 	out << proc.getCPUBrandName();
 	if (200 < mCPUMHz && mCPUMHz < 10000)           // *NOTE: cpu speed is often way wrong, do a sanity check
 	{
@@ -538,6 +560,16 @@ bool LLCPUInfo::hasSSE2() const
 	return mHasSSE2;
 }
 
+bool LLCPUInfo::hasAVX2() const
+{
+	return mHasAVX2;
+}
+
+bool LLCPUInfo::hasFMA() const
+{
+	return mHasFMA;
+}
+
 F64 LLCPUInfo::getMHz() const
 {
 	return mCPUMHz;
@@ -557,8 +589,11 @@ void LLCPUInfo::stream(std::ostream& s) const
 	// CPU's attributes regardless of platform
 	s << "->mHasSSE:     " << (U32)mHasSSE << std::endl;
 	s << "->mHasSSE2:    " << (U32)mHasSSE2 << std::endl;
+	s << "->mHasAVX2:    " << (U32)mHasAVX2 << std::endl;
+	s << "->mHasFMA:     " << (U32)mHasFMA << std::endl;
 	s << "->mHasAltivec: " << (U32)mHasAltivec << std::endl;
 	s << "->mCPUMHz:     " << mCPUMHz << std::endl;
+	s << "->mNumCores:   " << mNumCores << std::endl;
 	s << "->mCPUString:  " << mCPUString << std::endl;
 }
 
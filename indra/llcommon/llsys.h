@@ -75,7 +75,10 @@ public:
 	bool hasAltivec() const;
 	bool hasSSE() const;
 	bool hasSSE2() const;
+	bool hasAVX2() const;
+	bool hasFMA() const;
 	F64 getMHz() const;
+	U32 getNumCores() const { return mNumCores; } // logical processors available to the process, at least 1
 
 	// Family is "AMD Duron" or "Intel Pentium Pro"
 	const std::string& getFamily() const { return mFamily; }
@@ -83,8 +86,11 @@ public:
 private:
 	bool mHasSSE;
 	bool mHasSSE2;
+	bool mHasAVX2;
+	bool mHasFMA;
 	bool mHasAltivec;
 	F64 mCPUMHz;
+	U32 mNumCores;
 	std::string mFamily;
 	std::string mCPUString;
 };
@@ -0,0 +1,255 @@
+/**
+ * @file lluuidindex.h
+ * @brief Open addressed hash map keyed by LLUUID.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUUIDINDEX_H
+#define LL_LLUUIDINDEX_H
+
+#include <utility>
+#include <vector>
+
+#include "lluuid.h"
+
+// Maps LLUUIDs to DATA in one flat array with linear probing, for large
+// tables of ids that are looked up far more often than they change. Has
+// the parts of the std::map interface that such tables use, so it can
+// stand in for one, but iterates in no particular order.
+//
+// Inserting may move every element, erasing may move the elements after
+// the erased one: both invalidate iterators and pointers into the index.
+// Erasing releases what the element held right away.
+template <class DATA>
+class LLUUIDIndex
+{
+public:
+	typedef LLUUID key_type;
+	typedef DATA mapped_type;
+	typedef std::pair<LLUUID, DATA> value_type;
+
+	template <class INDEX, class VALUE>
+	class iterator_base
+	{
+	public:
+		iterator_base() : mIndex(NULL), mSlot(0) {}
+		iterator_base(INDEX* index, size_t slot) : mIndex(index), mSlot(slot) { skipEmpty(); }
+		// iterator converts to const_iterator
+		template <class OTHER_INDEX, class OTHER_VALUE>
+		iterator_base(const iterator_base<OTHER_INDEX, OTHER_VALUE>& other)
+			: mIndex(other.mIndex), mSlot(other.mSlot) {}
+
+		VALUE& operator*() const { return mIndex->mSlots[mSlot]; }
+		VALUE* operator->() const { return &mIndex->mSlots[mSlot]; }
+		iterator_base& operator++() { ++mSlot; skipEmpty(); return *this; }
+		iterator_base operator++(int) { iterator_base tmp(*this); ++*this; return tmp; }
+		template <class OTHER_INDEX, class OTHER_VALUE>
+		bool operator==(const iterator_base<OTHER_INDEX, OTHER_VALUE>& other) const { return mSlot == other.mSlot; }
+		template <class OTHER_INDEX, class OTHER_VALUE>
+		bool operator!=(const iterator_base<OTHER_INDEX, OTHER_VALUE>& other) const { return mSlot != other.mSlot; }
+
+	private:
+		template <class OTHER_INDEX, class OTHER_VALUE> friend class iterator_base;
+
+		void skipEmpty()
+		{
+			const size_t capacity = mIndex->mUsed.size();
+			while (mSlot < capacity && !mIndex->mUsed[mSlot])
+			{
+				++mSlot;
+			}
+		}
+
+		INDEX* mIndex;
+		size_t mSlot;
+	};
+	typedef iterator_base<LLUUIDIndex, value_type> iterator;
+	typedef iterator_base<const LLUUIDIndex, const value_type> const_iterator;
+
+	LLUUIDIndex() : mSize(0) {}
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, mUsed.size()); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, mUsed.size()); }
+
+	size_t size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+	size_t capacity() const { return mUsed.size(); }
+
+	iterator find(const LLUUID& key)
+	{
+		const size_t slot = findSlot(key);
+		return mUsed.empty() || !mUsed[slot] ? end() : iterator(this, slot);
+	}
+	const_iterator find(const LLUUID& key) const
+	{
+		const size_t slot = findSlot(key);
+		return mUsed.empty() || !mUsed[slot] ? end() : const_iterator(this, slot);
+	}
+	size_t count(const LLUUID& key) const
+	{
+		return (!mUsed.empty() && mUsed[findSlot(key)]) ? 1 : 0;
+	}
+
+	// The data for key, or NULL
+	DATA* getPtr(const LLUUID& key)
+	{
+		const size_t slot = findSlot(key);
+		return (!mUsed.empty() && mUsed[slot]) ? &mSlots[slot].second : NULL;
+	}
+	const DATA* getPtr(const LLUUID& key) const
+	{
+		const size_t slot = findSlot(key);
+		return (!mUsed.empty() && mUsed[slot]) ? &mSlots[slot].second : NULL;
+	}
+
+	DATA& operator[](const LLUUID& key)
+	{
+		// Keep the load under 3/4 so that probe runs stay short
+		if ((mSize + 1) * 4 > mUsed.size() * 3)
+		{
+			rehash(mUsed.empty() ? MIN_CAPACITY : mUsed.size() * 2);
+		}
+		const size_t slot = findSlot(key);
+		if (!mUsed[slot])
+		{
+			mUsed[slot] = 1;
+			mSlots[slot].first = key;
+			++mSize;
+		}
+		return mSlots[slot].second;
+	}
+
+	size_t erase(const LLUUID& key)
+	{
+		if (mUsed.empty())
+		{
+			return 0;
+		}
+		size_t hole = findSlot(key);
+		if (!mUsed[hole])
+		{
+			return 0;
+		}
+
+		// Shift the rest of the probe run back over the hole, so that no
+		// tombstones are left to slow down later lookups
+		const size_t mask = mUsed.size() - 1;
+		mSlots[hole].second = DATA();
+		mUsed[hole] = 0;
+		for (size_t slot = (hole + 1) & mask; mUsed[slot]; slot = (slot + 1) & mask)
+		{
+			const size_t home = hash(mSlots[slot].first) & mask;
+			// Leave the element if its home is cyclically in (hole, slot]
+			const bool in_place = (hole <= slot) ? (hole < home && home <= slot) : (hole < home || home <= slot);
+			if (!in_place)
+			{
+				mSlots[hole] = mSlots[slot];
+				mUsed[hole] = 1;
+				mSlots[slot].second = DATA();
+				mUsed[slot] = 0;
+				hole = slot;
+			}
+		}
+		--mSize;
+		return 1;
+	}
+
+	void clear()
+	{
+		mSlots.clear();
+		mUsed.clear();
+		mSize = 0;
+	}
+
+	// Makes room for count elements without rehashing
+	void reserve(size_t count)
+	{
+		size_t capacity = MIN_CAPACITY;
+		while (capacity * 3 < count * 4)
+		{
+			capacity *= 2;
+		}
+		if (capacity > mUsed.size())
+		{
+			rehash(capacity);
+		}
+	}
+
+	void swap(LLUUIDIndex& other)
+	{
+		mSlots.swap(other.mSlots);
+		mUsed.swap(other.mUsed);
+		std::swap(mSize, other.mSize);
+	}
+
+	static U32 hash(const LLUUID& key)
+	{
+		// Most ids are random, but not all of them: mix the words
+		U32 h = key.getCRC32() * 0x9e3779b1;
+		return h ^ (h >> 16);
+	}
+
+private:
+	enum { MIN_CAPACITY = 16 };
+
+	// The slot holding key, or the empty slot where it would go
+	size_t findSlot(const LLUUID& key) const
+	{
+		if (mUsed.empty())
+		{
+			return 0;
+		}
+		const size_t mask = mUsed.size() - 1;
+		size_t slot = hash(key) & mask;
+		while (mUsed[slot] && mSlots[slot].first != key)
+		{
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<value_type> slots(capacity);
+		std::vector<U8> used(capacity, 0);
+		mSlots.swap(slots);
+		mUsed.swap(used);
+		for (size_t i = 0; i < used.size(); ++i)
+		{
+			if (used[i])
+			{
+				const size_t slot = findSlot(slots[i].first);
+				mUsed[slot] = 1;
+				mSlots[slot] = slots[i];
+			}
+		}
+	}
+
+	std::vector<value_type> mSlots;
+	std::vector<U8> mUsed;
+	size_t mSize;
+};
+
+#endif // LL_LLUUIDINDEX_H
@@ -34,8 +34,8 @@
 //============================================================================
 // Run on MAIN thread
 
-LLWorkerThread::LLWorkerThread(const std::string& name, bool threaded) :
-	LLQueuedThread(name, threaded)
+LLWorkerThread::LLWorkerThread(const std::string& name, bool threaded, U32 num_workers) :
+	LLQueuedThread(name, threaded, num_workers)
 {
 	mDeleteMutex = new LLMutex(NULL);
 
@@ -0,0 +1,175 @@
+/** 
+ * @file llqueuedthread_test.cpp
+ * @brief Tests for LLQueuedThread request ordering and multi-worker mode
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llqueuedthread.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	std::vector<U32> sProcessed;
+	LLAtomic32<S32> sProcessedCount(0);
+
+	class TestRequest : public LLQueuedThread::QueuedRequest
+	{
+	public:
+		TestRequest(LLQueuedThread::handle_t handle, U32 priority, U32 id)
+			: LLQueuedThread::QueuedRequest(handle, priority, LLQueuedThread::FLAG_AUTO_COMPLETE),
+			  mID(id)
+		{
+		}
+
+		/*virtual*/ bool processRequest()
+		{
+			sProcessed.push_back(mID);
+			return true;
+		}
+
+	private:
+		U32 mID;
+	};
+
+	class CountRequest : public LLQueuedThread::QueuedRequest
+	{
+	public:
+		CountRequest(LLQueuedThread::handle_t handle)
+			: LLQueuedThread::QueuedRequest(handle, LLQueuedThread::PRIORITY_NORMAL, LLQueuedThread::FLAG_AUTO_COMPLETE)
+		{
+		}
+
+		/*virtual*/ bool processRequest()
+		{
+			sProcessedCount++;
+			return true;
+		}
+	};
+
+	class TestThread : public LLQueuedThread
+	{
+	public:
+		TestThread(bool threaded, U32 num_workers = 1)
+			: LLQueuedThread("test", threaded, num_workers)
+		{
+		}
+
+		handle_t add(U32 priority, U32 id)
+		{
+			handle_t handle = generateHandle();
+			addRequest(new TestRequest(handle, priority, id));
+			return handle;
+		}
+
+		void addCount()
+		{
+			addRequest(new CountRequest(generateHandle()));
+		}
+	};
+}
+
+namespace tut
+{
+	struct queuedthread_test
+	{
+		queuedthread_test()
+		{
+			sProcessed.clear();
+			sProcessedCount = 0;
+		}
+	};
+	typedef test_group<queuedthread_test> queuedthread_group_t;
+	typedef queuedthread_group_t::object queuedthread_object_t;
+	tut::queuedthread_group_t queuedthread_instance("LLQueuedThread");
+
+	template<> template<>
+	void queuedthread_object_t::test<1>()
+	{
+		// requests are processed highest priority first
+		TestThread thread(false);
+		thread.add(LLQueuedThread::PRIORITY_LOW, 1);
+		thread.add(LLQueuedThread::PRIORITY_HIGH, 2);
+		thread.add(LLQueuedThread::PRIORITY_NORMAL, 3);
+		thread.add(LLQueuedThread::PRIORITY_URGENT, 4);
+		ensure_equals("pending", thread.getPending(), 4);
+		thread.update(0);
+		ensure_equals("processed", sProcessed.size(), 4U);
+		ensure_equals("first", sProcessed[0], 4U);
+		ensure_equals("second", sProcessed[1], 2U);
+		ensure_equals("third", sProcessed[2], 3U);
+		ensure_equals("fourth", sProcessed[3], 1U);
+		ensure_equals("none pending", thread.getPending(), 0);
+	}
+
+	template<> template<>
+	void queuedthread_object_t::test<2>()
+	{
+		// setPriority() re-sorts queued requests in place
+		TestThread thread(false);
+		LLQueuedThread::handle_t low = thread.add(LLQueuedThread::PRIORITY_LOW, 1);
+		LLQueuedThread::handle_t normal = thread.add(LLQueuedThread::PRIORITY_NORMAL, 2);
+		thread.add(LLQueuedThread::PRIORITY_HIGH, 3);
+		thread.setPriority(low, LLQueuedThread::PRIORITY_URGENT);
+		thread.setPriority(normal, LLQueuedThread::PRIORITY_LOW);
+		thread.update(0);
+		ensure_equals("processed", sProcessed.size(), 3U);
+		ensure_equals("raised", sProcessed[0], 1U);
+		ensure_equals("unchanged", sProcessed[1], 3U);
+		ensure_equals("lowered", sProcessed[2], 2U);
+	}
+
+	template<> template<>
+	void queuedthread_object_t::test<3>()
+	{
+		// aborted requests are dropped without being processed
+		TestThread thread(false);
+		thread.add(LLQueuedThread::PRIORITY_NORMAL, 1);
+		LLQueuedThread::handle_t aborted = thread.add(LLQueuedThread::PRIORITY_HIGH, 2);
+		thread.add(LLQueuedThread::PRIORITY_LOW, 3);
+		thread.abortRequest(aborted, true);
+		thread.update(0);
+		ensure_equals("processed", sProcessed.size(), 2U);
+		ensure_equals("first", sProcessed[0], 1U);
+		ensure_equals("second", sProcessed[1], 3U);
+		ensure_equals("aborted request removed", thread.getRequest(aborted) == NULL, true);
+	}
+
+	template<> template<>
+	void queuedthread_object_t::test<4>()
+	{
+		// every request is processed exactly once with several workers
+		const S32 COUNT = 1000;
+		TestThread thread(true, 4);
+		ensure_equals("workers", thread.getNumWorkers(), 4U);
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			thread.addCount();
+		}
+		thread.waitOnPending();
+		ensure_equals("processed", (S32)sProcessedCount, COUNT);
+		ensure_equals("none pending", thread.getPending(), 0);
+	}
+}
@@ -0,0 +1,250 @@
+/**
+ * @file llsddocument_test.cpp
+ * @brief LLSDDocument unit tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include <sstream>
+
+#include "../llsd.h"
+#include "../llsddocument.h"
+#include "../llsdserialize.h"
+#include "../llsdutil.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct sd_document_data
+	{
+		sd_document_data()
+		{
+			LLSD item = LLSD::emptyMap();
+			item["item_id"] = LLUUID("6b5b7f39-9e0d-4b0c-86a9-c3e8a8a6b0f1");
+			item["name"] = "Shirt";
+			item["flags"] = 42;
+			item["price"] = 12.5;
+			item["created"] = LLDate(1234567890.0);
+			item["link"] = LLURI("http://secondlife.com/");
+			LLSD::Binary bin;
+			bin.push_back(0);
+			bin.push_back(0xff);
+			bin.push_back('a');
+			item["data"] = bin;
+			item["for_sale"] = true;
+			item["nothing"] = LLSD();
+
+			mSD = LLSD::emptyMap();
+			mSD["items"] = LLSD::emptyArray();
+			for (S32 i = 0; i < 20; ++i)
+			{
+				item["flags"] = i;
+				mSD["items"].append(item);
+			}
+			mSD["empty_map"] = LLSD::emptyMap();
+			mSD["empty_array"] = LLSD::emptyArray();
+		}
+
+		void checkDocument(const LLSDDocument& doc)
+		{
+			LLSDDocument::Value root = doc.root();
+			ensure("root is map", root.isMap());
+			ensure_equals("root size", root.size(), mSD.size());
+			ensure("round trip", llsd_equals(doc.toLLSD(), mSD));
+
+			LLSDDocument::Value items = root["items"];
+			ensure_equals("items size", items.size(), 20);
+			S32 i = 0;
+			for (LLSDDocument::Value::const_iterator it = items.beginArray(); it != items.endArray(); ++it, ++i)
+			{
+				LLSDDocument::Value item = *it;
+				ensure_equals("flags", item["flags"].asInteger(), i);
+				ensure_equals("name", item["name"].asString(), std::string("Shirt"));
+				ensure_equals("name cstring", std::string(item["name"].getCString()), std::string("Shirt"));
+				ensure_equals("id", item["item_id"].asUUID(), mSD["items"][0]["item_id"].asUUID());
+				ensure_equals("price", item["price"].asReal(), 12.5);
+				ensure_equals("created", item["created"].asDate().secondsSinceEpoch(), 1234567890.0);
+				ensure_equals("link", item["link"].asURI().asString(), std::string("http://secondlife.com/"));
+				ensure("data", item["data"].asBinary() == mSD["items"][0]["data"].asBinary());
+				ensure("for_sale", item["for_sale"].asBoolean());
+				ensure("nothing", item.has("nothing") && item["nothing"].isUndefined());
+				ensure("missing", !item.has("missing") && item["missing"].isUndefined());
+			}
+			ensure("indexed", items[19]["flags"].asInteger() == 19);
+			ensure("out of range", items[20].isUndefined());
+			ensure("empty map", root["empty_map"].isMap() && root["empty_map"].size() == 0);
+			ensure("empty array", root["empty_array"].isArray() && root["empty_array"].beginArray() == root["empty_array"].endArray());
+		}
+
+		LLSD mSD;
+	};
+
+	typedef test_group<sd_document_data> sd_document_test;
+	typedef sd_document_test::object sd_document_object;
+	tut::sd_document_test sd_document("LLSDDocument");
+
+	template<> template<>
+	void sd_document_object::test<1>()
+	{
+		// built from an LLSD
+		LLSDDocument doc;
+		doc.assign(mSD);
+		ensure("finished", doc.isFinished());
+		checkDocument(doc);
+
+		// map children are in key order, like LLSD
+		LLSDDocument::Value item = doc.root()["items"][0];
+		LLSD::map_const_iterator sd_it = mSD["items"][0].beginMap();
+		for (LLSDDocument::Value::const_iterator it = item.beginMap(); it != item.endMap(); ++it, ++sd_it)
+		{
+			ensure_equals("key order", (*it).getKey(), sd_it->first);
+		}
+
+		// conversions follow LLSD
+		ensure_equals("int as string", item["flags"].asString(), std::string("0"));
+		ensure_equals("real as int", item["price"].asInteger(), 12);
+		ensure_equals("uuid as string", item["item_id"].asString(), mSD["items"][0]["item_id"].asString());
+		ensure("map as int", doc.root().asInteger() == 0);
+	}
+
+	template<> template<>
+	void sd_document_object::test<2>()
+	{
+		// binary parse
+		std::stringstream stream;
+		LLSDSerialize::toBinary(mSD, stream);
+		std::string str = stream.str();
+
+		std::istringstream istr(str);
+		LLSD sd;
+		LLPointer<LLSDParser> parser = new LLSDBinaryParser;
+		S32 sd_count = parser->parse(istr, sd, str.size());
+
+		std::istringstream doc_istr(str);
+		LLSDDocument doc;
+		parser = new LLSDBinaryParser;
+		S32 doc_count = parser->parse(doc_istr, doc, str.size());
+		ensure_equals("parse count", doc_count, sd_count);
+		checkDocument(doc);
+
+		// truncated input fails and leaves the document empty
+		std::istringstream short_istr(str.substr(0, str.size() / 2));
+		parser = new LLSDBinaryParser;
+		ensure_equals("truncated", parser->parse(short_istr, doc, str.size() / 2), (S32)LLSDParser::PARSE_FAILURE);
+		ensure("cleared", doc.isEmpty() && doc.root().isUndefined());
+	}
+
+	template<> template<>
+	void sd_document_object::test<3>()
+	{
+		// xml parse
+		std::stringstream stream;
+		LLSDSerialize::toXML(mSD, stream);
+		std::string str = stream.str();
+
+		std::istringstream istr(str);
+		LLSD sd;
+		LLPointer<LLSDParser> parser = new LLSDXMLParser;
+		S32 sd_count = parser->parse(istr, sd, str.size());
+
+		std::istringstream doc_istr(str);
+		LLSDDocument doc;
+		parser = new LLSDXMLParser;
+		S32 doc_count = parser->parse(doc_istr, doc, str.size());
+		ensure_equals("parse count", doc_count, sd_count);
+		checkDocument(doc);
+
+		// notation goes through the LLSD fallback
+		std::stringstream notation;
+		LLSDSerialize::toNotation(mSD, notation);
+		parser = new LLSDNotationParser;
+		ensure("notation", parser->parse(notation, doc, LLSDSerialize::SIZE_UNLIMITED) > 0);
+		checkDocument(doc);
+	}
+
+	template<> template<>
+	void sd_document_object::test<4>()
+	{
+		// building by hand
+		LLSDDocument doc;
+		doc.beginMap();
+		doc.key("b");
+		doc.addInteger(2);
+		doc.key("a");
+		doc.beginArray();
+		doc.addString("x");
+		doc.addBoolean(false);
+		doc.end();
+		doc.key("b");
+		doc.addInteger(3);
+		doc.key("");
+		doc.addString("empty key");
+		doc.end();
+		ensure("finish", doc.finish());
+
+		LLSDDocument::Value root = doc.root();
+		ensure_equals("dupe removed", root.size(), 3);
+		ensure_equals("empty key", root[""].asString(), std::string("empty key"));
+		ensure_equals("first wins", root["b"].asInteger(), 2);
+		ensure_equals("a[0]", root["a"][0].asString(), std::string("x"));
+		ensure_equals("key", root["a"].getKey(), std::string("a"));
+		ensure("no key", root["a"][0].getKeyCString() == NULL);
+
+		// a value in a map without a key
+		doc.clear();
+		doc.beginMap();
+		doc.addInteger(1);
+		doc.end();
+		ensure("no key fails", !doc.finish());
+
+		// unbalanced
+		doc.clear();
+		doc.beginArray();
+		ensure("unbalanced fails", !doc.finish());
+		ensure("not finished", doc.root().isUndefined());
+	}
+
+	template<> template<>
+	void sd_document_object::test<5>()
+	{
+		// a container size off the wire is not trusted for allocation
+		const char huge_array[] = { '[', 0x7f, (char)0xff, (char)0xff, (char)0xff };
+		const S32 huge_size = sizeof(huge_array);
+
+		LLSDDocument doc;
+		LLSDBinaryStreamParser stream_parser(doc);
+		ensure("stream needs more",
+			   stream_parser.feed((const U8*)huge_array, huge_size) == LLSDBinaryStreamParser::STATUS_NEED_MORE);
+		ensure("stream did not reserve", doc.getMemoryUsage() < 64 * 1024);
+
+		ensure("buffer fails",
+			   LLSDSerialize::fromBinary(doc, (const U8*)huge_array, huge_size) == LLSDParser::PARSE_FAILURE);
+
+		std::istringstream istr(std::string(huge_array, huge_size));
+		LLPointer<LLSDParser> parser = new LLSDBinaryParser;
+		ensure("istream fails", parser->parse(istr, doc, LLSDSerialize::SIZE_UNLIMITED) <= 0);
+		ensure("istream did not reserve", doc.getMemoryUsage() < 64 * 1024);
+	}
+}
@@ -1494,5 +1494,128 @@ namespace tut
 		ensureBinaryAndNotation("map", test);
 		ensureBinaryAndXML("map", test);
 	}
-}
 
+	/**
+	 * @class TestLLSDBinaryStream
+	 * @brief Span formatting and incremental binary parsing
+	 */
+	class TestLLSDBinaryStream
+	{
+	public:
+		TestLLSDBinaryStream()
+		{
+			mSD = LLSD::emptyMap();
+			mSD["int"] = 42;
+			mSD["real"] = 3.25;
+			mSD["string"] = "hello world";
+			mSD["uuid"] = LLUUID("d7f4aeca-88f1-42a1-b385-b9db18abb255");
+			mSD["date"] = LLDate(1234567890.0);
+			mSD["uri"] = LLURI("http://example.com/");
+			mSD["binary"] = string_to_vector("binary data");
+			mSD["bool"] = true;
+			mSD["undef"] = LLSD();
+			mSD["array"] = LLSD::emptyArray();
+			mSD["array"].append(1);
+			mSD["array"].append(LLSD::emptyMap());
+			mSD["array"].append(LLSD::emptyArray());
+			mSD["array"].append("two");
+		}
+
+		// feeds the bytes in pieces of piece_size
+		LLSDBinaryStreamParser::EStatus feed(
+			const std::vector<U8>& data,
+			S32 piece_size,
+			LLSD& result)
+		{
+			LLSDBuilder builder(result);
+			LLSDBinaryStreamParser parser(builder);
+			for(S32 offset = 0; offset < (S32)data.size(); offset += piece_size)
+			{
+				S32 length = llmin(piece_size, (S32)data.size() - offset);
+				if(parser.feed(&data[offset], length) != LLSDBinaryStreamParser::STATUS_NEED_MORE)
+				{
+					break;
+				}
+			}
+			return parser.getStatus();
+		}
+
+		LLSD mSD;
+	};
+
+	typedef tut::test_group<TestLLSDBinaryStream> TestLLSDBinaryStreamGroup;
+	typedef TestLLSDBinaryStreamGroup::object TestLLSDBinaryStreamObject;
+	TestLLSDBinaryStreamGroup gTestLLSDBinaryStreamGroup(
+		"llsd binary stream");
+
+	template<> template<> 
+	void TestLLSDBinaryStreamObject::test<1>()
+	{
+		// formatBuffer() writes the same bytes as format()
+		std::ostringstream ostr;
+		LLSDSerialize::toBinary(mSD, ostr);
+		std::string expected = ostr.str();
+		ensure_equals("size", LLSDBinaryFormatter::getFormattedSize(mSD), (S32)expected.size());
+
+		std::vector<U8> out;
+		LLSDSerialize::toBinary(mSD, out);
+		ensure("same bytes", std::string((char*)&out[0], out.size()) == expected);
+	}
+
+	template<> template<> 
+	void TestLLSDBinaryStreamObject::test<2>()
+	{
+		std::vector<U8> data;
+		LLSDSerialize::toBinary(mSD, data);
+
+		LLSD whole;
+		ensure("whole span", LLSDSerialize::fromBinary(whole, &data[0], data.size()) > 0);
+		ensure_equals("whole value", whole, mSD);
+
+		// values split between pieces are put back together
+		S32 pieces[] = { 1, 3, 7, 16 };
+		for(S32 i = 0; i < 4; ++i)
+		{
+			LLSD result;
+			ensure("pieces status", feed(data, pieces[i], result) == LLSDBinaryStreamParser::STATUS_DONE);
+			ensure_equals("pieces value", result, mSD);
+		}
+
+		// truncated input wants more
+		LLSD result;
+		std::vector<U8> truncated(data.begin(), data.end() - 1);
+		ensure("truncated", feed(truncated, 5, result) == LLSDBinaryStreamParser::STATUS_NEED_MORE);
+	}
+
+	template<> template<> 
+	void TestLLSDBinaryStreamObject::test<3>()
+	{
+		// parsing stops after the first value
+		std::vector<U8> data;
+		LLSDSerialize::toBinary(LLSD(7), data);
+		S32 value_size = data.size();
+		data.push_back('!');
+
+		LLSD result;
+		LLSDBuilder builder(result);
+		LLSDBinaryStreamParser parser(builder);
+		ensure("done", parser.feed(&data[0], data.size()) == LLSDBinaryStreamParser::STATUS_DONE);
+		ensure_equals("used", parser.getBytesUsed(), value_size);
+		ensure_equals("value", result.asInteger(), 7);
+
+		// notation style strings, fed in small pieces
+		std::string quoted("['it\\'s'\"x\"]");
+		std::vector<U8> bytes(quoted.begin(), quoted.end());
+		U8 size_nbo[] = { 0, 0, 0, 2 };
+		bytes.insert(bytes.begin() + 1, size_nbo, size_nbo + 4);
+		LLSD array;
+		ensure("quoted", feed(bytes, 4, array) == LLSDBinaryStreamParser::STATUS_DONE);
+		ensure_equals("quoted size", array.size(), 2);
+		ensure_equals("escaped", array[0].asString(), std::string("it's"));
+		ensure_equals("double", array[1].asString(), std::string("x"));
+
+		// garbage
+		std::vector<U8> bad(1, 'z');
+		ensure("bad", feed(bad, 1, result) == LLSDBinaryStreamParser::STATUS_ERROR);
+	}
+}
@@ -0,0 +1,112 @@
+/**
+ * @file llstringtable_test.cpp
+ * @brief LLStringTable unit tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llstringtable.h"
+#include "../llformat.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct string_table
+	{
+		string_table() : mTable(16) {}
+
+		LLStringTable mTable;
+	};
+
+	typedef test_group<string_table> string_table_test;
+	typedef string_table_test::object string_table_t;
+	string_table_test tut_string_table("LLStringTable");
+
+	// equal strings share one entry until the last reference goes
+	template<> template<>
+	void string_table_t::test<1>()
+	{
+		std::string hello("hello");
+		char* first = mTable.addString("hello");
+		ensure("copied", first != hello.c_str());
+		ensure_equals("value", std::string(first), hello);
+		ensure("shared", mTable.addString(hello) == first);
+		ensure("found", mTable.checkString("hello") == first);
+		ensure("not found", mTable.checkString("world") == NULL);
+		ensure_equals("count", mTable.checkStringEntry(hello)->mCount, 2);
+		ensure_equals("unique", mTable.mUniqueEntries, 1);
+
+		mTable.removeString("hello");
+		ensure("still referenced", mTable.checkString("hello") == first);
+		mTable.removeString("hello");
+		ensure("removed", mTable.checkString("hello") == NULL);
+		ensure_equals("none", mTable.mUniqueEntries, 0);
+	}
+
+	// the table grows past its initial size and keeps every string
+	template<> template<>
+	void string_table_t::test<2>()
+	{
+		const S32 NUM_STRINGS = 5000;
+		std::vector<char*> strings;
+		for (S32 i = 0; i < NUM_STRINGS; ++i)
+		{
+			strings.push_back(mTable.addString(llformat("string %d", i)));
+		}
+		ensure_equals("unique", mTable.mUniqueEntries, NUM_STRINGS);
+		ensure("grown", mTable.mMaxEntries >= NUM_STRINGS * 2);
+		for (S32 i = 0; i < NUM_STRINGS; ++i)
+		{
+			ensure("same entry", mTable.checkString(llformat("string %d", i)) == strings[i]);
+		}
+	}
+
+	// removed strings don't hide the ones added after them
+	template<> template<>
+	void string_table_t::test<3>()
+	{
+		const S32 NUM_STRINGS = 200;
+		for (S32 round = 0; round < 20; ++round)
+		{
+			for (S32 i = 0; i < NUM_STRINGS; ++i)
+			{
+				mTable.addString(llformat("string %d %d", round, i));
+			}
+			for (S32 i = 0; i < NUM_STRINGS; i += 2)
+			{
+				mTable.removeString(llformat("string %d %d", round, i).c_str());
+			}
+		}
+		ensure_equals("unique", mTable.mUniqueEntries, 20 * NUM_STRINGS / 2);
+		for (S32 round = 0; round < 20; ++round)
+		{
+			for (S32 i = 0; i < NUM_STRINGS; ++i)
+			{
+				bool found = mTable.checkString(llformat("string %d %d", round, i)) != NULL;
+				ensure_equals("found", found, (i % 2) != 0);
+			}
+		}
+	}
+}
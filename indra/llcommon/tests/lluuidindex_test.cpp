@@ -0,0 +1,179 @@
+/**
+ * @file lluuidindex_test.cpp
+ * @brief Tests for LLUUIDIndex
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include <map>
+
+#include "../lluuidindex.h"
+#include "../llpointer.h"
+#include "../llrefcount.h"
+#include "../lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	class Counted : public LLRefCount
+	{
+	public:
+		Counted() { ++sLive; }
+		static S32 sLive;
+	protected:
+		~Counted() { --sLive; }
+	};
+	S32 Counted::sLive = 0;
+
+	// Ids that differ in one byte, like the ones made up for special folders
+	LLUUID make_id(U32 i)
+	{
+		LLUUID id;
+		memcpy(id.mData + 12, &i, sizeof(i));		/* Flawfinder: ignore */
+		return id;
+	}
+}
+
+namespace tut
+{
+	struct uuidindex_data
+	{
+	};
+	typedef test_group<uuidindex_data> uuidindex_test;
+	typedef uuidindex_test::object uuidindex_object;
+	tut::uuidindex_test uuidindex("LLUUIDIndex");
+
+	template<> template<>
+	void uuidindex_object::test<1>()
+	{
+		// Behaves like a std::map, through growth and erasure
+		LLUUIDIndex<S32> index;
+		std::map<LLUUID, S32> expected;
+		ensure("empty", index.empty());
+		ensure("nothing found", index.find(LLUUID::null) == index.end());
+		ensure_equals("nothing erased", index.erase(LLUUID::null), (size_t)0);
+
+		const U32 count = 5000;
+		for (U32 i = 0; i < count; ++i)
+		{
+			LLUUID id = (i & 1) ? make_id(i) : LLUUID::generateNewID();
+			index[id] = i;
+			expected[id] = i;
+		}
+		ensure_equals("size", index.size(), expected.size());
+
+		// Erase every third one
+		S32 n = 0;
+		for (std::map<LLUUID, S32>::iterator it = expected.begin(); it != expected.end(); ++n)
+		{
+			if (n % 3 == 0)
+			{
+				ensure_equals("erased", index.erase(it->first), (size_t)1);
+				expected.erase(it++);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		ensure_equals("size after erase", index.size(), expected.size());
+
+		for (std::map<LLUUID, S32>::iterator it = expected.begin(); it != expected.end(); ++it)
+		{
+			LLUUIDIndex<S32>::const_iterator found = index.find(it->first);
+			ensure("found", found != index.end());
+			ensure_equals("value", found->second, it->second);
+			ensure_equals("ptr", *index.getPtr(it->first), it->second);
+		}
+
+		size_t iterated = 0;
+		for (LLUUIDIndex<S32>::iterator it = index.begin(); it != index.end(); ++it)
+		{
+			ensure("iterated", expected.count(it->first) == 1);
+			++iterated;
+		}
+		ensure_equals("iterated all", iterated, expected.size());
+
+		index.clear();
+		ensure("cleared", index.empty() && index.begin() == index.end());
+	}
+
+	template<> template<>
+	void uuidindex_object::test<2>()
+	{
+		// Erasing releases the element, and keeps the others reachable
+		LLUUIDIndex<LLPointer<Counted> > index;
+		index.reserve(4);
+		const size_t capacity = index.capacity();
+		for (U32 i = 0; i < 10; ++i)
+		{
+			index[make_id(i)] = new Counted;
+		}
+		ensure_equals("live", Counted::sLive, 10);
+		ensure_equals("no rehash", index.capacity(), capacity);
+
+		index.erase(make_id(3));
+		ensure_equals("released", Counted::sLive, 9);
+		for (U32 i = 0; i < 10; ++i)
+		{
+			ensure_equals("reachable", index.count(make_id(i)), (size_t)(i != 3));
+		}
+		index.clear();
+		ensure_equals("all released", Counted::sLive, 0);
+	}
+
+	template<> template<>
+	void uuidindex_object::test<3>()
+	{
+		// Benchmark: lookups in 100k ids against std::map. Informational only.
+		const U32 count = 100000;
+		std::vector<LLUUID> ids(count);
+		LLUUIDIndex<U32> index;
+		std::map<LLUUID, U32> map;
+		for (U32 i = 0; i < count; ++i)
+		{
+			ids[i].generate();
+			index[ids[i]] = i;
+			map[ids[i]] = i;
+		}
+
+		U32 sum = 0;
+		LLTimer timer;
+		for (U32 i = 0; i < count; ++i)
+		{
+			sum += map.find(ids[(i * 7919) % count])->second;
+		}
+		const F64 map_time = timer.getElapsedTimeF64();
+		timer.reset();
+		for (U32 i = 0; i < count; ++i)
+		{
+			sum -= *index.getPtr(ids[(i * 7919) % count]);
+		}
+		const F64 index_time = timer.getElapsedTimeF64();
+		ensure_equals("same values", sum, 0U);
+		llinfos << "100k lookups: std::map " << map_time * 1000.0 << " ms, LLUUIDIndex "
+				<< index_time * 1000.0 << " ms" << llendl;
+	}
+}
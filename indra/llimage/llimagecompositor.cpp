@@ -0,0 +1,201 @@
+/**
+ * @file llimagecompositor.cpp
+ * @brief LLImageCompositor class, composites avatar bake layers without GL.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagecompositor.h"
+
+static const LLColor4U COMPOSITE_WHITE(255, 255, 255, 255);
+
+LLImageCompositor::LLImageCompositor(LLImageRaw* target)
+	: mTarget(target),
+	  mBlend(LLImageKernels::BLEND_ALPHA),
+	  mAlphaOnly(false)
+{
+	if (mTarget->getComponents() != 4)
+	{
+		llerrs << "LLImageCompositor needs an RGBA target, not " << (S32)mTarget->getComponents()
+			   << " components" << llendl;
+	}
+}
+
+void LLImageCompositor::fill(const LLColor4U& color)
+{
+	// The rows are contiguous, blend them in one go
+	LLImageKernels::sBlend(NULL, color.mV, mTarget->getData(),
+						   mTarget->getWidth() * mTarget->getHeight(), mBlend, mAlphaOnly);
+}
+
+BOOL LLImageCompositor::draw(const LLImageRaw* image, const LLColor4U& color, bool is_mask)
+{
+	if (!image || !image->getData())
+	{
+		return FALSE;
+	}
+
+	const S32 width = mTarget->getWidth();
+	const S32 height = mTarget->getHeight();
+	LLPointer<LLImageRaw> scaled;
+	if (image->getWidth() != width || image->getHeight() != height)
+	{
+		scaled = new LLImageRaw(const_cast<U8*>(image->getData()), image->getWidth(), image->getHeight(),
+								image->getComponents());
+		if (!scaled->scale(width, height))
+		{
+			return FALSE;
+		}
+		image = scaled;
+	}
+
+	mRow.resize(width * 4);
+	U8* dst = mTarget->getData();
+	for (S32 y = 0; y < height; ++y)
+	{
+		LLImageKernels::sBlend(getImageRow(image, y, is_mask), color.mV, dst + y * width * 4, width,
+							   mBlend, mAlphaOnly);
+	}
+	return TRUE;
+}
+
+const U8* LLImageCompositor::getImageRow(const LLImageRaw* image, S32 y, bool is_mask)
+{
+	const S32 width = image->getWidth();
+	const S32 components = image->getComponents();
+	const U8* src = image->getData() + y * width * components;
+	U8* row = &mRow[0];
+	switch (components)
+	{
+	case 4:
+		return src;
+	case 3:
+		LLImageKernels::sCopy3onto4(src, row, width);
+		break;
+	case 2:
+		// GL_LUMINANCE_ALPHA
+		for (S32 x = 0; x < width; ++x, src += 2, row += 4)
+		{
+			row[0] = row[1] = row[2] = src[0];
+			row[3] = src[1];
+		}
+		break;
+	default:
+		// GL_ALPHA leaves the color to the vertex color, GL_LUMINANCE is opaque
+		for (S32 x = 0; x < width; ++x, ++src, row += 4)
+		{
+			if (is_mask)
+			{
+				row[0] = row[1] = row[2] = 255;
+				row[3] = src[0];
+			}
+			else
+			{
+				row[0] = row[1] = row[2] = src[0];
+				row[3] = 255;
+			}
+		}
+		break;
+	}
+	return &mRow[0];
+}
+
+void LLImageCompositor::compositeLayer(const Layer& layer)
+{
+	// If you can't see the layer, don't render it.
+	if (!layer.mColor.mV[VW])
+	{
+		return;
+	}
+
+	LLImageKernels::EBlend blend = LLImageKernels::BLEND_ALPHA;
+	if (!layer.mAlphaMasks.empty())
+	{
+		// LLTexLayer::renderMorphMasks(): accumulate the masks in the alpha
+		// channel, then draw the layer through it
+		setAlphaOnly(true);
+
+		// If the first mask is a multiply, multiply against the current alpha
+		if (!layer.mAlphaMasks.front().mMultiply)
+		{
+			setBlend(LLImageKernels::BLEND_REPLACE);
+			fill(LLColor4U(0, 0, 0, 0));
+		}
+
+		for (std::vector<AlphaMask>::const_iterator iter = layer.mAlphaMasks.begin();
+			 iter != layer.mAlphaMasks.end(); ++iter)
+		{
+			// Multiplication approximates a min() function, addition a max()
+			setBlend(iter->mMultiply ? LLImageKernels::BLEND_MULT_ALPHA : LLImageKernels::BLEND_ADD);
+			if (iter->mImage.notNull())
+			{
+				draw(iter->mImage, COMPOSITE_WHITE, true);
+			}
+			else
+			{
+				fill(LLColor4U(0, 0, 0, iter->mWeight));
+			}
+		}
+
+		// Multiply by the alpha of the layer's texture and color
+		setBlend(LLImageKernels::BLEND_MULT_ALPHA);
+		const LLImageRaw* image = layer.mImage;
+		if (image && (image->getComponents() == 4 || (image->getComponents() == 1 && layer.mImageIsMask)))
+		{
+			draw(image, COMPOSITE_WHITE, layer.mImageIsMask);
+		}
+		if (layer.mColor.mV[VW] != 255)
+		{
+			fill(layer.mColor);
+		}
+
+		setAlphaOnly(false);
+		blend = LLImageKernels::BLEND_DEST_ALPHA;
+	}
+
+	if (layer.mWriteAllChannels)
+	{
+		blend = LLImageKernels::BLEND_REPLACE;
+	}
+	setBlend(blend);
+	if (layer.mImage.notNull())
+	{
+		draw(layer.mImage, layer.mColor, layer.mImageIsMask);
+	}
+	else
+	{
+		fill(layer.mColor);
+	}
+	setBlend(LLImageKernels::BLEND_ALPHA);
+}
+
+void LLImageCompositor::readAlpha(U8* alpha) const
+{
+	const U8* src = mTarget->getData() + 3;
+	const S32 pixels = mTarget->getWidth() * mTarget->getHeight();
+	for (S32 i = 0; i < pixels; ++i, src += 4)
+	{
+		alpha[i] = *src;
+	}
+}
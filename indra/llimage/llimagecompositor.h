@@ -0,0 +1,116 @@
+/**
+ * @file llimagecompositor.h
+ * @brief LLImageCompositor class, composites avatar bake layers without GL.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGECOMPOSITOR_H
+#define LL_LLIMAGECOMPOSITOR_H
+
+#include <vector>
+
+#include "llimage.h"
+#include "llimagekernels.h"
+#include "llpointer.h"
+#include "v4coloru.h"
+
+// Composites avatar bake layers into an RGBA LLImageRaw the way
+// LLTexLayerSet::render() does with GL: the same rectangles, blend
+// functions and color masks, with 8 bit math in LLImageKernels. Needs no
+// GL context and no globals beyond the kernels, so it can run on any
+// thread, one compositor per thread.
+//
+// Images are stretched over the whole target like a textured rectangle.
+// Ones of another size are box filtered to the target size first, where GL
+// would sample them bilinearly.
+class LLImageCompositor
+{
+public:
+	// One LLTexLayerParamAlpha of a layer
+	struct AlphaMask
+	{
+		AlphaMask() : mWeight(0), mMultiply(false) {}
+
+		// The processed single channel mask, or NULL for a mask that is
+		// only a weight
+		LLPointer<LLImageRaw> mImage;
+		U8 mWeight;
+		// Multiplied into the accumulated alpha, otherwise added
+		bool mMultiply;
+	};
+
+	// One LLTexLayer
+	struct Layer
+	{
+		Layer() : mImageIsMask(false), mColor(255, 255, 255, 255), mWriteAllChannels(false) {}
+
+		// The local or static texture, or NULL to fill the layer with mColor
+		LLPointer<LLImageRaw> mImage;
+		// A single channel mImage is alpha rather than luminance
+		bool mImageIsMask;
+		// The net color of the layer
+		LLColor4U mColor;
+		// Replaces what is under the layer instead of blending over it
+		bool mWriteAllChannels;
+		// The layer only shows where its masks accumulate alpha
+		std::vector<AlphaMask> mAlphaMasks;
+	};
+
+	// target must have 4 components
+	LLImageCompositor(LLImageRaw* target);
+
+	LLImageRaw* getTarget() const { return mTarget; }
+
+	void setBlend(LLImageKernels::EBlend mode) { mBlend = mode; }
+	LLImageKernels::EBlend getBlend() const { return mBlend; }
+	// Only write the alpha channel, glColorMask(false, false, false, true)
+	void setAlphaOnly(bool alpha_only) { mAlphaOnly = alpha_only; }
+
+	// gl_rect_2d_simple() over the whole target in color
+	void fill(const LLColor4U& color);
+	// gl_rect_2d_simple_tex() over the whole target with image, modulated
+	// by color. Single channel images are luminance, or alpha if is_mask,
+	// like the GL_ALPHA textures of masks. Returns false if image has no
+	// data.
+	BOOL draw(const LLImageRaw* image, const LLColor4U& color, bool is_mask = false);
+
+	// LLTexLayer::render(), including the morph masks of the layer. Leaves
+	// the blend at BLEND_ALPHA.
+	void compositeLayer(const Layer& layer);
+
+	// Copies the alpha channel of the target to alpha, glReadPixels(GL_ALPHA)
+	void readAlpha(U8* alpha) const;
+
+private:
+	// Row y of image, which has the width of the target, as RGBA texels
+	const U8* getImageRow(const LLImageRaw* image, S32 y, bool is_mask);
+
+	LLPointer<LLImageRaw> mTarget;
+	LLImageKernels::EBlend mBlend;
+	bool mAlphaOnly;
+
+	// One row of the current image as RGBA
+	std::vector<U8> mRow;
+};
+
+#endif // LL_LLIMAGECOMPOSITOR_H
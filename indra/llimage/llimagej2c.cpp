@@ -179,7 +179,8 @@ LLImageJ2C::LLImageJ2C() : 	LLImageFormatted(IMG_CODEC_J2C),
 							mRawDiscardLevel(-1),
 							mRate(0.0f),
 							mReversible(FALSE),
-							mAreaUsedForDataSizeCalcs(0)
+							mAreaUsedForDataSizeCalcs(0),
+							mDataGeneration(0)
 {
 	//We assume here that if we wanted to create via
 	//a dynamic library that the approriate open calls were made
@@ -236,6 +237,28 @@ LLImageJ2C::~LLImageJ2C()
 	}
 }
 
+// virtual
+void LLImageJ2C::deleteData()
+{
+	++mDataGeneration;
+	LLImageFormatted::deleteData();
+}
+
+// virtual
+U8* LLImageJ2C::allocateData(S32 size)
+{
+	// May hand back the same buffer for new data
+	++mDataGeneration;
+	return LLImageFormatted::allocateData(size);
+}
+
+// virtual
+U8* LLImageJ2C::reallocateData(S32 size)
+{
+	++mDataGeneration;
+	return LLImageFormatted::reallocateData(size);
+}
+
 // virtual
 void LLImageJ2C::resetLastError()
 {
@@ -594,7 +617,7 @@ LLImageJ2CImpl::~LLImageJ2CImpl()
 //----------------------------------------------------------------------------------------------
 // Start of LLImageCompressionTester
 //----------------------------------------------------------------------------------------------
-LLImageCompressionTester::LLImageCompressionTester() : LLMetricPerformanceTesterBasic(sTesterName) 
+LLImageCompressionTester::LLImageCompressionTester() : LLMetricPerformanceTesterBasic(sTesterName), mMutex(NULL)
 {
 	addMetric("Time Decompression (s)");
 	addMetric("Volume In Decompression (kB)");
@@ -672,11 +695,13 @@ void LLImageCompressionTester::outputTestRecord(LLSD *sd)
 
 void LLImageCompressionTester::updateCompressionStats(const F32 deltaTime) 
 {
+	LLMutexLock lock(&mMutex);
 	mTotalTimeCompression += deltaTime;
 }
 
 void LLImageCompressionTester::updateCompressionStats(const S32 bytesCompress, const S32 bytesRaw) 
 {
+	LLMutexLock lock(&mMutex);
 	mTotalBytesInCompression += bytesRaw;
 	mRunBytesInCompression += bytesRaw;
 	mTotalBytesOutCompression += bytesCompress;
@@ -691,11 +716,13 @@ void LLImageCompressionTester::updateCompressionStats(const S32 bytesCompress, c
 
 void LLImageCompressionTester::updateDecompressionStats(const F32 deltaTime) 
 {
+	LLMutexLock lock(&mMutex);
 	mTotalTimeDecompression += deltaTime;
 }
 
 void LLImageCompressionTester::updateDecompressionStats(const S32 bytesIn, const S32 bytesOut) 
 {
+	LLMutexLock lock(&mMutex);
 	mTotalBytesInDecompression += bytesIn;
 	mRunBytesInDecompression += bytesIn;
 	mTotalBytesOutDecompression += bytesOut;
@@ -43,6 +43,9 @@ public:
 	LLImageJ2C();
 
 	// Base class overrides
+	/*virtual*/ void deleteData();
+	/*virtual*/ U8* allocateData(S32 size = -1);
+	/*virtual*/ U8* reallocateData(S32 size);
 	/*virtual*/ std::string getExtension() { return std::string("j2c"); }
 	/*virtual*/ BOOL updateData();
 	/*virtual*/ BOOL decode(LLImageRaw *raw_imagep, F32 decode_time);
@@ -60,6 +63,10 @@ public:
 	// Encode with comment text 
 	BOOL encode(const LLImageRaw *raw_imagep, const char* comment_text, F32 encode_time=0.0);
 
+	// Changes whenever the data is allocated, reallocated or deleted, so
+	// that an LLImageJ2CImpl can tell its codestream was replaced
+	U32 getDataGeneration() const { return mDataGeneration; }
+
 	BOOL validate(U8 *data, U32 file_size);
 	BOOL loadAndValidate(const std::string &filename);
 
@@ -94,6 +101,7 @@ protected:
 	BOOL mReversible;
 	LLImageJ2CImpl *mImpl;
 	std::string mLastError;
+	U32 mDataGeneration;
 
     // Image compression/decompression tester
 	static LLImageCompressionTester* sTesterp;
@@ -154,6 +162,7 @@ class LLImageCompressionTester : public LLMetricPerformanceTesterBasic
         U32 mTotalBytesOutCompression;      // Total bytes produced by compressor
 		U32 mRunBytesInDecompression;		// Bytes fed to decompressor in this run
 		U32 mRunBytesInCompression;			// Bytes fed to compressor in this run
+		LLMutex mMutex;						// images are decoded on several threads
         //
         // Time
         //
@@ -0,0 +1,467 @@
+/**
+ * @file llimagekernels.cpp
+ * @brief Portable image kernels and kernel dispatch.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagekernels.h"
+
+#include "llmath.h"
+#include "llprocessor.h"
+
+//static
+LLImageKernels::ELevel LLImageKernels::sLevel = LLImageKernels::LEVEL_GENERIC;
+LLImageKernels::scale_rows_func_t LLImageKernels::sScaleRows = LLImageKernels::scaleRows;
+LLImageKernels::scale_pixels_func_t LLImageKernels::sScalePixels = LLImageKernels::scalePixels;
+LLImageKernels::composite_scaled_func_t LLImageKernels::sCompositeScaled4onto3 = LLImageKernels::compositeScaled4onto3;
+LLImageKernels::convert_func_t LLImageKernels::sComposite4onto3 = LLImageKernels::composite4onto3;
+LLImageKernels::convert_func_t LLImageKernels::sCopy3onto4 = LLImageKernels::copy3onto4;
+LLImageKernels::convert_func_t LLImageKernels::sCopy4onto3 = LLImageKernels::copy4onto3;
+LLImageKernels::blend_func_t LLImageKernels::sBlend = LLImageKernels::blend;
+LLImageKernels::mask_func_t LLImageKernels::sMultiplyMask = LLImageKernels::multiplyMask;
+
+//static
+void LLImageKernels::initClass()
+{
+	ELevel level = setLevel(LEVEL_SSSE3);
+	llinfos << "Using " << getLevelName(level) << " image kernels" << llendl;
+}
+
+//static
+LLImageKernels::ELevel LLImageKernels::setLevel(ELevel level)
+{
+	LLProcessorInfo proc;
+
+	bindGeneric();
+	sLevel = LEVEL_GENERIC;
+	if (level >= LEVEL_SSE2 && proc.hasSSE2() && bindSSE2())
+	{
+		sLevel = LEVEL_SSE2;
+		if (level >= LEVEL_SSSE3 && proc.hasSSSE3() && bindSSSE3())
+		{
+			sLevel = LEVEL_SSSE3;
+		}
+	}
+	return sLevel;
+}
+
+//static
+const char* LLImageKernels::getLevelName(ELevel level)
+{
+	switch (level)
+	{
+	case LEVEL_SSE2:
+		return "SSE2";
+	case LEVEL_SSSE3:
+		return "SSSE3";
+	default:
+		return "generic";
+	}
+}
+
+//static
+void LLImageKernels::bindGeneric()
+{
+	sScaleRows = scaleRows;
+	sScalePixels = scalePixels;
+	sCompositeScaled4onto3 = compositeScaled4onto3;
+	sComposite4onto3 = composite4onto3;
+	sCopy3onto4 = copy3onto4;
+	sCopy4onto3 = copy4onto3;
+	sBlend = blend;
+	sMultiplyMask = multiplyMask;
+}
+
+//static
+void LLImageKernels::scaleRows(const U8* first, S32 stride, S32 count, const U8* last,
+							   F32 fract0, F32 fract1, F32 norm, U8* out, S32 bytes)
+{
+	for (S32 i = 0; i < bytes; ++i)
+	{
+		F32 v = first[i] * fract0;
+		const U8* row = first;
+		for (S32 u = 0; u < count; ++u)
+		{
+			row += stride;
+			v += row[i];
+		}
+		if (last)
+		{
+			v += last[i] * fract1;
+		}
+		v *= norm;
+		out[i] = U8(llround(v));
+	}
+}
+
+//static
+void LLImageKernels::scalePixels(const U8* in, U8* out, S32 in_len, S32 out_len, S32 components)
+{
+	scaleLine(in, out, in_len, out_len, 1, 1, components);
+}
+
+//static
+void LLImageKernels::scaleLine(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step, S32 components)
+{
+	llassert( components >= 1 && components <= 4 );
+
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+
+	S32 goff = components >= 2 ? 1 : 0;
+	S32 boff = components >= 3 ? 2 : 0;
+	for( S32 x = 0; x < out_pixel_len; x++ )
+	{
+		// Sample input pixels in range from sample0 to sample1.
+		// Avoid floating point accumulation error... don't just add ratio each time.  JC
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = llfloor(sample0);			// left integer (floor)
+		const S32 index1 = llfloor(sample1);			// right integer (floor)
+		const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
+		const F32 fract1 = sample1 - F32(index1);			// spill-over on right
+
+		if( index0 == index1 )
+		{
+			// Interval is embedded in one input pixel
+			S32 t0 = x * out_pixel_step * components;
+			S32 t1 = index0 * in_pixel_step * components;
+			U8* outp = out + t0;
+			const U8* inp = in + t1;
+			for (S32 i = 0; i < components; ++i)
+			{
+				*outp = *inp;
+				++outp;
+				++inp;
+			}
+		}
+		else
+		{
+			// Left straddle
+			S32 t1 = index0 * in_pixel_step * components;
+			F32 r = in[t1 + 0] * fract0;
+			F32 g = in[t1 + goff] * fract0;
+			F32 b = in[t1 + boff] * fract0;
+			F32 a = 0;
+			if( components == 4)
+			{
+				a = in[t1 + 3] * fract0;
+			}
+
+			// Central interval
+			if (components < 4)
+			{
+				for( S32 u = index0 + 1; u < index1; u++ )
+				{
+					S32 t2 = u * in_pixel_step * components;
+					r += in[t2 + 0];
+					g += in[t2 + goff];
+					b += in[t2 + boff];
+				}
+			}
+			else
+			{
+				for( S32 u = index0 + 1; u < index1; u++ )
+				{
+					S32 t2 = u * in_pixel_step * components;
+					r += in[t2 + 0];
+					g += in[t2 + 1];
+					b += in[t2 + 2];
+					a += in[t2 + 3];
+				}
+			}
+
+			// right straddle
+			// Watch out for reading off of end of input array.
+			if( fract1 && index1 < in_pixel_len )
+			{
+				S32 t3 = index1 * in_pixel_step * components;
+				if (components < 4)
+				{
+					U8 in0 = in[t3 + 0];
+					U8 in1 = in[t3 + goff];
+					U8 in2 = in[t3 + boff];
+					r += in0 * fract1;
+					g += in1 * fract1;
+					b += in2 * fract1;
+				}
+				else
+				{
+					U8 in0 = in[t3 + 0];
+					U8 in1 = in[t3 + 1];
+					U8 in2 = in[t3 + 2];
+					U8 in3 = in[t3 + 3];
+					r += in0 * fract1;
+					g += in1 * fract1;
+					b += in2 * fract1;
+					a += in3 * fract1;
+				}
+			}
+
+			r *= norm_factor;
+			g *= norm_factor;
+			b *= norm_factor;
+			a *= norm_factor;  // skip conditional
+
+			S32 t4 = x * out_pixel_step * components;
+			out[t4 + 0] = U8(llround(r));
+			if (components >= 2)
+				out[t4 + 1] = U8(llround(g));
+			if (components >= 3)
+				out[t4 + 2] = U8(llround(b));
+			if( components == 4)
+				out[t4 + 3] = U8(llround(a));
+		}
+	}
+}
+
+//static
+void LLImageKernels::compositeScaled4onto3(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len)
+{
+	const S32 IN_COMPONENTS = 4;
+	const S32 OUT_COMPONENTS = 3;
+
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+
+	for( S32 x = 0; x < out_pixel_len; x++ )
+	{
+		// Sample input pixels in range from sample0 to sample1.
+		// Avoid floating point accumulation error... don't just add ratio each time.  JC
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = S32(sample0);			// left integer (floor)
+		const S32 index1 = S32(sample1);			// right integer (floor)
+		const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
+		const F32 fract1 = sample1 - F32(index1);			// spill-over on right
+
+		U8 in_scaled_r;
+		U8 in_scaled_g;
+		U8 in_scaled_b;
+		U8 in_scaled_a;
+
+		if( index0 == index1 )
+		{
+			// Interval is embedded in one input pixel
+			S32 t1 = index0 * IN_COMPONENTS;
+			in_scaled_r = in[t1 + 0];
+			in_scaled_g = in[t1 + 1];
+			in_scaled_b = in[t1 + 2];
+			in_scaled_a = in[t1 + 3];
+		}
+		else
+		{
+			// Left straddle
+			S32 t1 = index0 * IN_COMPONENTS;
+			F32 r = in[t1 + 0] * fract0;
+			F32 g = in[t1 + 1] * fract0;
+			F32 b = in[t1 + 2] * fract0;
+			F32 a = in[t1 + 3] * fract0;
+
+			// Central interval
+			for( S32 u = index0 + 1; u < index1; u++ )
+			{
+				S32 t2 = u * IN_COMPONENTS;
+				r += in[t2 + 0];
+				g += in[t2 + 1];
+				b += in[t2 + 2];
+				a += in[t2 + 3];
+			}
+
+			// right straddle
+			// Watch out for reading off of end of input array.
+			if( fract1 && index1 < in_pixel_len )
+			{
+				S32 t3 = index1 * IN_COMPONENTS;
+				r += in[t3 + 0] * fract1;
+				g += in[t3 + 1] * fract1;
+				b += in[t3 + 2] * fract1;
+				a += in[t3 + 3] * fract1;
+			}
+
+			r *= norm_factor;
+			g *= norm_factor;
+			b *= norm_factor;
+			a *= norm_factor;
+
+			in_scaled_r = U8(llround(r));
+			in_scaled_g = U8(llround(g));
+			in_scaled_b = U8(llround(b));
+			in_scaled_a = U8(llround(a));
+		}
+
+		if( in_scaled_a )
+		{
+			if( 255 == in_scaled_a )
+			{
+				out[0] = in_scaled_r;
+				out[1] = in_scaled_g;
+				out[2] = in_scaled_b;
+			}
+			else
+			{
+				U8 transparency = 255 - in_scaled_a;
+				out[0] = fractionalMult( out[0], transparency ) + fractionalMult( in_scaled_r, in_scaled_a );
+				out[1] = fractionalMult( out[1], transparency ) + fractionalMult( in_scaled_g, in_scaled_a );
+				out[2] = fractionalMult( out[2], transparency ) + fractionalMult( in_scaled_b, in_scaled_a );
+			}
+		}
+		out += OUT_COMPONENTS;
+	}
+}
+
+//static
+void LLImageKernels::composite4onto3(const U8* src_data, U8* dst_data, S32 pixels)
+{
+	while( pixels-- )
+	{
+		U8 alpha = src_data[3];
+		if( alpha )
+		{
+			if( 255 == alpha )
+			{
+				dst_data[0] = src_data[0];
+				dst_data[1] = src_data[1];
+				dst_data[2] = src_data[2];
+			}
+			else
+			{
+
+				U8 transparency = 255 - alpha;
+				dst_data[0] = fractionalMult( dst_data[0], transparency ) + fractionalMult( src_data[0], alpha );
+				dst_data[1] = fractionalMult( dst_data[1], transparency ) + fractionalMult( src_data[1], alpha );
+				dst_data[2] = fractionalMult( dst_data[2], transparency ) + fractionalMult( src_data[2], alpha );
+			}
+		}
+
+		src_data += 4;
+		dst_data += 3;
+	}
+}
+
+//static
+void LLImageKernels::copy3onto4(const U8* src_data, U8* dst_data, S32 pixels)
+{
+	for( S32 i=0; i<pixels; i++ )
+	{
+		dst_data[0] = src_data[0];
+		dst_data[1] = src_data[1];
+		dst_data[2] = src_data[2];
+		dst_data[3] = 255;
+		src_data += 3;
+		dst_data += 4;
+	}
+}
+
+//static
+void LLImageKernels::copy4onto3(const U8* src_data, U8* dst_data, S32 pixels)
+{
+	for( S32 i=0; i<pixels; i++ )
+	{
+		dst_data[0] = src_data[0];
+		dst_data[1] = src_data[1];
+		dst_data[2] = src_data[2];
+		src_data += 4;
+		dst_data += 3;
+	}
+}
+
+// One channel of LLImageKernels::blend(), s and d are the source and
+// destination values, sa and da their alphas
+template<S32 MODE>
+static inline U8 blend_channel(U8 s, U8 sa, U8 d, U8 da)
+{
+	switch (MODE)
+	{
+	case LLImageKernels::BLEND_ALPHA:
+		return (U8)llmin(255, LLImageKernels::fractionalMult(s, sa) + LLImageKernels::fractionalMult(d, 255 - sa));
+	case LLImageKernels::BLEND_ADD:
+		return (U8)llmin(255, s + d);
+	case LLImageKernels::BLEND_MULT_ALPHA:
+		return LLImageKernels::fractionalMult(s, da);
+	case LLImageKernels::BLEND_DEST_ALPHA:
+		return (U8)llmin(255, LLImageKernels::fractionalMult(s, da) + LLImageKernels::fractionalMult(d, 255 - da));
+	default:
+		return s;
+	}
+}
+
+template<S32 MODE>
+static void blend_pixels(const U8* src, const U8* tint, U8* dst, S32 pixels, bool alpha_only)
+{
+	const S32 first = alpha_only ? 3 : 0;
+	for (S32 i = 0; i < pixels; ++i)
+	{
+		U8 s[4];
+		for (S32 c = 0; c < 4; ++c)
+		{
+			s[c] = src ? LLImageKernels::fractionalMult(src[c], tint[c]) : tint[c];
+		}
+		const U8 da = dst[3];
+		for (S32 c = first; c < 4; ++c)
+		{
+			dst[c] = blend_channel<MODE>(s[c], s[3], dst[c], da);
+		}
+		if (src)
+		{
+			src += 4;
+		}
+		dst += 4;
+	}
+}
+
+//static
+void LLImageKernels::blend(const U8* src, const U8* tint, U8* dst, S32 pixels, EBlend mode, bool alpha_only)
+{
+	switch (mode)
+	{
+	case BLEND_ALPHA:
+		blend_pixels<BLEND_ALPHA>(src, tint, dst, pixels, alpha_only);
+		break;
+	case BLEND_ADD:
+		blend_pixels<BLEND_ADD>(src, tint, dst, pixels, alpha_only);
+		break;
+	case BLEND_MULT_ALPHA:
+		blend_pixels<BLEND_MULT_ALPHA>(src, tint, dst, pixels, alpha_only);
+		break;
+	case BLEND_DEST_ALPHA:
+		blend_pixels<BLEND_DEST_ALPHA>(src, tint, dst, pixels, alpha_only);
+		break;
+	default:
+		blend_pixels<BLEND_REPLACE>(src, tint, dst, pixels, alpha_only);
+		break;
+	}
+}
+
+//static
+void LLImageKernels::multiplyMask(const U8* mask, U8* dst, S32 count)
+{
+	for (S32 i = 0; i < count; ++i)
+	{
+		U16 result = dst[i];
+		result *= (mask[i] + 1);
+		dst[i] = (U8)(result >> 8);
+	}
+}
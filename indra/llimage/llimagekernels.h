@@ -0,0 +1,134 @@
+/**
+ * @file llimagekernels.h
+ * @brief Row and pixel kernels used by LLImageRaw, with SSE2/SSSE3 versions.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEKERNELS_H
+#define LL_LLIMAGEKERNELS_H
+
+// The inner loops of LLImageRaw scaling, compositing and channel conversion.
+// Every kernel has a portable version; on x86 the SSE2 and SSSE3 versions
+// are bound at startup (LLImage::initClass()) if the CPU supports them.
+// All versions produce the same bytes as the portable ones, except for the
+// last bit of float rounding on builds that use x87 math for the portable
+// versions.
+//
+// The SSE2 and SSSE3 versions live in their own files, which are the only
+// ones built with those instruction sets. Keep them free of globals that
+// need construction, see llv4math.h for why.
+class LLImageKernels
+{
+public:
+	enum ELevel
+	{
+		LEVEL_GENERIC = 0,
+		LEVEL_SSE2,
+		LEVEL_SSSE3
+	};
+
+	// Binds the best kernels this CPU and build support
+	static void initClass();
+
+	// Binds the kernels up to level, as far as the CPU and build support
+	// them. Returns the level actually bound. For tests and benchmarks.
+	static ELevel setLevel(ELevel level);
+	static ELevel getLevel() { return sLevel; }
+	static const char* getLevelName(ELevel level);
+
+	// Vertical scaling step. Each byte of out is the weighted sum of the
+	// bytes at the same offset in the rows first (weight fract0), the count
+	// rows following it, stride bytes apart (weight 1), and last (weight
+	// fract1, skipped when NULL), multiplied by norm and rounded.
+	typedef void (*scale_rows_func_t)(const U8* first, S32 stride, S32 count, const U8* last,
+									  F32 fract0, F32 fract1, F32 norm, U8* out, S32 bytes);
+
+	// Box filter a row of in_len packed pixels into out_len pixels.
+	typedef void (*scale_pixels_func_t)(const U8* in, U8* out, S32 in_len, S32 out_len, S32 components);
+
+	// Box filter a row of in_len RGBA pixels to out_len pixels and
+	// composite them onto the RGB row out.
+	typedef void (*composite_scaled_func_t)(const U8* in, U8* out, S32 in_len, S32 out_len);
+
+	// Same size conversion of pixels pixels
+	typedef void (*convert_func_t)(const U8* src, U8* dst, S32 pixels);
+
+	// The GL blend functions avatar bakes are composited with, see
+	// LLTexLayerSet::render() and LLImageCompositor
+	enum EBlend
+	{
+		BLEND_REPLACE = 0,	// BT_REPLACE: src
+		BLEND_ALPHA,		// BT_ALPHA: src * src.a + dst * (1 - src.a)
+		BLEND_ADD,			// BT_ADD: src + dst
+		BLEND_MULT_ALPHA,	// BT_MULT_ALPHA: src * dst.a
+		BLEND_DEST_ALPHA	// BF_DEST_ALPHA, BF_ONE_MINUS_DEST_ALPHA: src * dst.a + dst * (1 - dst.a)
+	};
+
+	// Blends pixels RGBA pixels of src, multiplied by the RGBA tint (the
+	// vertex color), onto the RGBA pixels of dst. A NULL src is white, a
+	// rectangle with no texture. With alpha_only only the alpha channel of
+	// dst is written, like a color mask.
+	typedef void (*blend_func_t)(const U8* src, const U8* tint, U8* dst, S32 pixels,
+								 EBlend mode, bool alpha_only);
+
+	// dst[i] = dst[i] * (mask[i] + 1) >> 8, see LLTexLayer::addAlphaMask()
+	typedef void (*mask_func_t)(const U8* mask, U8* dst, S32 count);
+
+	static scale_rows_func_t sScaleRows;
+	static scale_pixels_func_t sScalePixels;
+	static composite_scaled_func_t sCompositeScaled4onto3;
+	static convert_func_t sComposite4onto3;
+	static convert_func_t sCopy3onto4;
+	static convert_func_t sCopy4onto3;
+	static blend_func_t sBlend;
+	static mask_func_t sMultiplyMask;
+
+	// Portable versions
+	static void scaleRows(const U8* first, S32 stride, S32 count, const U8* last,
+						  F32 fract0, F32 fract1, F32 norm, U8* out, S32 bytes);
+	static void scalePixels(const U8* in, U8* out, S32 in_len, S32 out_len, S32 components);
+	static void scaleLine(const U8* in, U8* out, S32 in_len, S32 out_len, S32 in_step, S32 out_step, S32 components);
+	static void compositeScaled4onto3(const U8* in, U8* out, S32 in_len, S32 out_len);
+	static void composite4onto3(const U8* src, U8* dst, S32 pixels);
+	static void copy3onto4(const U8* src, U8* dst, S32 pixels);
+	static void copy4onto3(const U8* src, U8* dst, S32 pixels);
+	static void blend(const U8* src, const U8* tint, U8* dst, S32 pixels, EBlend mode, bool alpha_only);
+	static void multiplyMask(const U8* mask, U8* dst, S32 count);
+
+	// Calculates (U8)(255*(a/255.f)*(b/255.f) + 0.5f).  Thanks, Jim Blinn!
+	static inline U8 fractionalMult(U8 a, U8 b)
+	{
+		U32 i = a * b + 128;
+		return U8((i + (i>>8)) >> 8);
+	}
+
+private:
+	static void bindGeneric();
+	// Return false if the build has no such kernels
+	static bool bindSSE2();  // llimagekernels_sse2.cpp
+	static bool bindSSSE3(); // llimagekernels_ssse3.cpp
+
+	static ELevel sLevel;
+};
+
+#endif // LL_LLIMAGEKERNELS_H
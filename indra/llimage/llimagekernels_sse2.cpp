@@ -0,0 +1,385 @@
+/**
+ * @file llimagekernels_sse2.cpp
+ * @brief SSE2 versions of the LLImageRaw scaling kernels.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Visual Studio required settings for this file:
+// Precompiled Headers OFF
+// Code Generation: SSE2
+
+#include "linden_common.h"
+
+#include "llimagekernels.h"
+
+#include "llmath.h"
+
+#if LL_MSVC || defined(__SSE2__)
+
+#include <emmintrin.h>
+
+// The float math below is done in the same order as in the portable
+// kernels, one channel (or byte) per lane, so the results match them.
+
+// 16 bytes to 4 x 4 floats
+static inline void unpack_bytes(__m128i bytes, __m128 f[4])
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+	__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+	f[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+	f[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+	f[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+	f[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+}
+
+// Rounds non negative values like llround()
+static inline __m128i round_to_int(__m128 f)
+{
+	return _mm_cvttps_epi32(_mm_add_ps(f, _mm_set1_ps(0.5f)));
+}
+
+static inline __m128 load_pixel(const U8* p, S32 components)
+{
+	U32 v = p[0] | (p[1] << 8) | (p[2] << 16);
+	if (components == 4)
+	{
+		v |= (U32)p[3] << 24;
+	}
+	const __m128i zero = _mm_setzero_si128();
+	__m128i i = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero);
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(i, zero));
+}
+
+// Returns the pixel in the low 4 bytes
+static inline U32 pack_pixel(__m128i i)
+{
+	i = _mm_packs_epi32(i, i);
+	return _mm_cvtsi128_si32(_mm_packus_epi16(i, i));
+}
+
+static inline void store_pixel(U8* p, U32 v, S32 components)
+{
+	p[0] = U8(v);
+	p[1] = U8(v >> 8);
+	p[2] = U8(v >> 16);
+	if (components == 4)
+	{
+		p[3] = U8(v >> 24);
+	}
+}
+
+static void scale_rows_sse2(const U8* first, S32 stride, S32 count, const U8* last,
+							F32 fract0, F32 fract1, F32 norm, U8* out, S32 bytes)
+{
+	const __m128 f0 = _mm_set1_ps(fract0);
+	const __m128 f1 = _mm_set1_ps(fract1);
+	const __m128 n = _mm_set1_ps(norm);
+
+	S32 i = 0;
+	for (; i + 16 <= bytes; i += 16)
+	{
+		__m128 sum[4];
+		__m128 row[4];
+		unpack_bytes(_mm_loadu_si128((const __m128i*)(first + i)), sum);
+		for (S32 k = 0; k < 4; ++k)
+		{
+			sum[k] = _mm_mul_ps(sum[k], f0);
+		}
+
+		const U8* p = first + i;
+		for (S32 u = 0; u < count; ++u)
+		{
+			p += stride;
+			unpack_bytes(_mm_loadu_si128((const __m128i*)p), row);
+			for (S32 k = 0; k < 4; ++k)
+			{
+				sum[k] = _mm_add_ps(sum[k], row[k]);
+			}
+		}
+
+		if (last)
+		{
+			unpack_bytes(_mm_loadu_si128((const __m128i*)(last + i)), row);
+			for (S32 k = 0; k < 4; ++k)
+			{
+				sum[k] = _mm_add_ps(sum[k], _mm_mul_ps(row[k], f1));
+			}
+		}
+
+		__m128i lo = _mm_packs_epi32(round_to_int(_mm_mul_ps(sum[0], n)), round_to_int(_mm_mul_ps(sum[1], n)));
+		__m128i hi = _mm_packs_epi32(round_to_int(_mm_mul_ps(sum[2], n)), round_to_int(_mm_mul_ps(sum[3], n)));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+	}
+
+	if (i < bytes)
+	{
+		LLImageKernels::scaleRows(first + i, stride, count, last ? last + i : NULL,
+								  fract0, fract1, norm, out + i, bytes - i);
+	}
+}
+
+// Box filters the RGB(A) input pixels covering [x * ratio, (x + 1) * ratio)
+static inline __m128 scale_pixel(const U8* in, S32 in_len, S32 components, S32 index0, S32 index1,
+								 F32 fract0, F32 fract1, __m128 norm)
+{
+	__m128 sum = _mm_mul_ps(load_pixel(in + index0 * components, components), _mm_set1_ps(fract0));
+	for (S32 u = index0 + 1; u < index1; ++u)
+	{
+		sum = _mm_add_ps(sum, load_pixel(in + u * components, components));
+	}
+	// Watch out for reading off of end of input array.
+	if (fract1 && index1 < in_len)
+	{
+		sum = _mm_add_ps(sum, _mm_mul_ps(load_pixel(in + index1 * components, components), _mm_set1_ps(fract1)));
+	}
+	return _mm_mul_ps(sum, norm);
+}
+
+static void scale_pixels_sse2(const U8* in, U8* out, S32 in_len, S32 out_len, S32 components)
+{
+	if (components < 3)
+	{
+		LLImageKernels::scalePixels(in, out, in_len, out_len, components);
+		return;
+	}
+
+	const F32 ratio = F32(in_len) / out_len;
+	const __m128 norm = _mm_set1_ps(1.f / ratio);
+
+	for (S32 x = 0; x < out_len; ++x)
+	{
+		// Same sampling as LLImageKernels::scaleLine()
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = llfloor(sample0);
+		const S32 index1 = llfloor(sample1);
+		U8* outp = out + x * components;
+
+		if (index0 == index1)
+		{
+			const U8* inp = in + index0 * components;
+			for (S32 i = 0; i < components; ++i)
+			{
+				outp[i] = inp[i];
+			}
+		}
+		else
+		{
+			const F32 fract0 = 1.f - (sample0 - F32(index0));
+			const F32 fract1 = sample1 - F32(index1);
+			__m128 pixel = scale_pixel(in, in_len, components, index0, index1, fract0, fract1, norm);
+			store_pixel(outp, pack_pixel(round_to_int(pixel)), components);
+		}
+	}
+}
+
+// a * b / 255 per 16 bit lane, rounded like LLImageKernels::fractionalMult()
+static inline __m128i fractional_mult(__m128i a, __m128i b)
+{
+	__m128i i = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(i, _mm_srli_epi16(i, 8)), 8);
+}
+
+static void composite_scaled_4onto3_sse2(const U8* in, U8* out, S32 in_len, S32 out_len)
+{
+	const F32 ratio = F32(in_len) / out_len;
+	const __m128 norm = _mm_set1_ps(1.f / ratio);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(255);
+
+	for (S32 x = 0; x < out_len; ++x, out += 3)
+	{
+		// Same sampling as LLImageKernels::compositeScaled4onto3()
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = S32(sample0);
+		const S32 index1 = S32(sample1);
+
+		U32 src;
+		if (index0 == index1)
+		{
+			const U8* inp = in + index0 * 4;
+			src = inp[0] | (inp[1] << 8) | (inp[2] << 16) | ((U32)inp[3] << 24);
+		}
+		else
+		{
+			const F32 fract0 = 1.f - (sample0 - F32(index0));
+			const F32 fract1 = sample1 - F32(index1);
+			src = pack_pixel(round_to_int(scale_pixel(in, in_len, 4, index0, index1, fract0, fract1, norm)));
+		}
+
+		const U32 alpha = src >> 24;
+		if (!alpha)
+		{
+			continue;
+		}
+		if (alpha == 255)
+		{
+			store_pixel(out, src, 3);
+			continue;
+		}
+
+		// out * (255 - alpha) + src * alpha, in 16 bit lanes
+		__m128i s = _mm_unpacklo_epi8(_mm_cvtsi32_si128(src), zero);
+		__m128i d = _mm_unpacklo_epi8(_mm_cvtsi32_si128(out[0] | (out[1] << 8) | (out[2] << 16)), zero);
+		__m128i a = _mm_set1_epi16((short)alpha);
+		__m128i result = _mm_add_epi16(fractional_mult(d, _mm_sub_epi16(one, a)), fractional_mult(s, a));
+		store_pixel(out, _mm_cvtsi128_si32(_mm_packus_epi16(result, result)), 3);
+	}
+}
+
+// Broadcasts the alpha of each of the two pixels in a to its four lanes
+static inline __m128i broadcast_alpha(__m128i a)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// Two pixels in 16 bit lanes, see LLImageKernels::blend() and blend_channel()
+template<S32 MODE>
+static inline __m128i blend_two(__m128i s, __m128i d)
+{
+	const __m128i one = _mm_set1_epi16(255);
+	switch (MODE)
+	{
+	case LLImageKernels::BLEND_ALPHA:
+	{
+		__m128i sa = broadcast_alpha(s);
+		return _mm_add_epi16(fractional_mult(s, sa), fractional_mult(d, _mm_sub_epi16(one, sa)));
+	}
+	case LLImageKernels::BLEND_ADD:
+		// Saturated when packed
+		return _mm_add_epi16(s, d);
+	case LLImageKernels::BLEND_MULT_ALPHA:
+		return fractional_mult(s, broadcast_alpha(d));
+	case LLImageKernels::BLEND_DEST_ALPHA:
+	{
+		__m128i da = broadcast_alpha(d);
+		return _mm_add_epi16(fractional_mult(s, da), fractional_mult(d, _mm_sub_epi16(one, da)));
+	}
+	default:
+		return s;
+	}
+}
+
+template<S32 MODE>
+static void blend_pixels_sse2(const U8* src, const U8* tint, U8* dst, S32 pixels, bool alpha_only)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i t = _mm_set_epi16(tint[3], tint[2], tint[1], tint[0], tint[3], tint[2], tint[1], tint[0]);
+	// Lanes of dst that are written
+	const __m128i write = alpha_only ? _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0) : _mm_set1_epi16(-1);
+
+	S32 i = 0;
+	for (; i + 4 <= pixels; i += 4)
+	{
+		__m128i s_lo = t;
+		__m128i s_hi = t;
+		if (src)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + i * 4));
+			s_lo = fractional_mult(_mm_unpacklo_epi8(s, zero), t);
+			s_hi = fractional_mult(_mm_unpackhi_epi8(s, zero), t);
+		}
+		__m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+		__m128i d_lo = _mm_unpacklo_epi8(d, zero);
+		__m128i d_hi = _mm_unpackhi_epi8(d, zero);
+
+		__m128i r_lo = blend_two<MODE>(s_lo, d_lo);
+		__m128i r_hi = blend_two<MODE>(s_hi, d_hi);
+		r_lo = _mm_or_si128(_mm_and_si128(write, r_lo), _mm_andnot_si128(write, d_lo));
+		r_hi = _mm_or_si128(_mm_and_si128(write, r_hi), _mm_andnot_si128(write, d_hi));
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(r_lo, r_hi));
+	}
+
+	if (i < pixels)
+	{
+		LLImageKernels::blend(src ? src + i * 4 : NULL, tint, dst + i * 4, pixels - i,
+							  (LLImageKernels::EBlend)MODE, alpha_only);
+	}
+}
+
+static void blend_sse2(const U8* src, const U8* tint, U8* dst, S32 pixels,
+					   LLImageKernels::EBlend mode, bool alpha_only)
+{
+	switch (mode)
+	{
+	case LLImageKernels::BLEND_ALPHA:
+		blend_pixels_sse2<LLImageKernels::BLEND_ALPHA>(src, tint, dst, pixels, alpha_only);
+		break;
+	case LLImageKernels::BLEND_ADD:
+		blend_pixels_sse2<LLImageKernels::BLEND_ADD>(src, tint, dst, pixels, alpha_only);
+		break;
+	case LLImageKernels::BLEND_MULT_ALPHA:
+		blend_pixels_sse2<LLImageKernels::BLEND_MULT_ALPHA>(src, tint, dst, pixels, alpha_only);
+		break;
+	case LLImageKernels::BLEND_DEST_ALPHA:
+		blend_pixels_sse2<LLImageKernels::BLEND_DEST_ALPHA>(src, tint, dst, pixels, alpha_only);
+		break;
+	default:
+		blend_pixels_sse2<LLImageKernels::BLEND_REPLACE>(src, tint, dst, pixels, alpha_only);
+		break;
+	}
+}
+
+static void multiply_mask_sse2(const U8* mask, U8* dst, S32 count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+
+	S32 i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i m = _mm_loadu_si128((const __m128i*)(mask + i));
+		__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+		__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_add_epi16(_mm_unpacklo_epi8(m, zero), one));
+		__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_add_epi16(_mm_unpackhi_epi8(m, zero), one));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+	}
+
+	if (i < count)
+	{
+		LLImageKernels::multiplyMask(mask + i, dst + i, count - i);
+	}
+}
+
+//static
+bool LLImageKernels::bindSSE2()
+{
+	sScaleRows = scale_rows_sse2;
+	sScalePixels = scale_pixels_sse2;
+	sCompositeScaled4onto3 = composite_scaled_4onto3_sse2;
+	sBlend = blend_sse2;
+	sMultiplyMask = multiply_mask_sse2;
+	return true;
+}
+
+#else // LL_MSVC || __SSE2__
+
+//static
+bool LLImageKernels::bindSSE2()
+{
+	return false;
+}
+
+#endif // LL_MSVC || __SSE2__
@@ -0,0 +1,133 @@
+/**
+ * @file llimagekernels_ssse3.cpp
+ * @brief SSSE3 versions of the LLImageRaw channel conversion kernels.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Visual Studio required settings for this file:
+// Precompiled Headers OFF
+
+#include "linden_common.h"
+
+#include "llimagekernels.h"
+
+#if LL_MSVC || defined(__SSSE3__)
+
+#include <tmmintrin.h>
+
+// pshufb moves RGB triplets in and out of 32 bit pixels, 4 pixels at a time.
+// Every loop reads (and may write) 16 bytes from the 3 component side, so it
+// stops while at least 6 pixels are left and the rest go to the portable
+// kernels.
+
+#define EXPAND_3TO4_MASK	_mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1)
+#define PACK_4TO3_MASK		_mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1)
+
+static void copy_3onto4_ssse3(const U8* src, U8* dst, S32 pixels)
+{
+	const __m128i expand = EXPAND_3TO4_MASK;
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+
+	S32 i = 0;
+	for (; i + 6 <= pixels; i += 4)
+	{
+		__m128i rgb = _mm_loadu_si128((const __m128i*)(src + i * 3));
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, expand), alpha));
+	}
+	LLImageKernels::copy3onto4(src + i * 3, dst + i * 4, pixels - i);
+}
+
+static void copy_4onto3_ssse3(const U8* src, U8* dst, S32 pixels)
+{
+	const __m128i pack = PACK_4TO3_MASK;
+
+	S32 i = 0;
+	for (; i + 6 <= pixels; i += 4)
+	{
+		// The top 4 bytes written are garbage, the next store covers them.
+		__m128i rgba = _mm_loadu_si128((const __m128i*)(src + i * 4));
+		_mm_storeu_si128((__m128i*)(dst + i * 3), _mm_shuffle_epi8(rgba, pack));
+	}
+	LLImageKernels::copy4onto3(src + i * 4, dst + i * 3, pixels - i);
+}
+
+// a * b / 255 per 16 bit lane, rounded like LLImageKernels::fractionalMult()
+static inline __m128i fractional_mult(__m128i a, __m128i b)
+{
+	__m128i i = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(i, _mm_srli_epi16(i, 8)), 8);
+}
+
+// The blend is done without the alpha == 0 and alpha == 255 special cases
+// of the portable kernel; fractionalMult() gives the same bytes for those.
+static inline __m128i blend(__m128i dst, __m128i src, __m128i alpha)
+{
+	const __m128i one = _mm_set1_epi16(255);
+	return _mm_add_epi16(fractional_mult(dst, _mm_sub_epi16(one, alpha)), fractional_mult(src, alpha));
+}
+
+static void composite_4onto3_ssse3(const U8* src, U8* dst, S32 pixels)
+{
+	const __m128i expand = EXPAND_3TO4_MASK;
+	const __m128i pack = PACK_4TO3_MASK;
+	const __m128i spread_alpha = _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+	const __m128i keep_top = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1, -1);
+	const __m128i zero = _mm_setzero_si128();
+
+	S32 i = 0;
+	for (; i + 6 <= pixels; i += 4)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + i * 4));
+		__m128i d_rgb = _mm_loadu_si128((const __m128i*)(dst + i * 3));
+		__m128i d = _mm_shuffle_epi8(d_rgb, expand);
+		__m128i a = _mm_shuffle_epi8(s, spread_alpha);
+
+		__m128i lo = blend(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(a, zero));
+		__m128i hi = blend(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(a, zero));
+		__m128i result = _mm_shuffle_epi8(_mm_packus_epi16(lo, hi), pack);
+
+		// Put back the 4 bytes past the last pixel, they are not composited yet
+		result = _mm_or_si128(result, _mm_and_si128(d_rgb, keep_top));
+		_mm_storeu_si128((__m128i*)(dst + i * 3), result);
+	}
+	LLImageKernels::composite4onto3(src + i * 4, dst + i * 3, pixels - i);
+}
+
+//static
+bool LLImageKernels::bindSSSE3()
+{
+	sCopy3onto4 = copy_3onto4_ssse3;
+	sCopy4onto3 = copy_4onto3_ssse3;
+	sComposite4onto3 = composite_4onto3_ssse3;
+	return true;
+}
+
+#else // LL_MSVC || __SSSE3__
+
+//static
+bool LLImageKernels::bindSSSE3()
+{
+	return false;
+}
+
+#endif // LL_MSVC || __SSSE3__
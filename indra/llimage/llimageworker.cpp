@@ -32,8 +32,8 @@
 //----------------------------------------------------------------------------
 
 // MAIN THREAD
-LLImageDecodeThread::LLImageDecodeThread(bool threaded)
-	: LLQueuedThread("imagedecode", threaded)
+LLImageDecodeThread::LLImageDecodeThread(bool threaded, U32 num_workers)
+	: LLQueuedThread("imagedecode", threaded, num_workers)
 {
 	mCreationMutex = new LLMutex(getAPRPool());
 }
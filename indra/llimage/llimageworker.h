@@ -72,7 +72,8 @@ public:
 	};
 	
 public:
-	LLImageDecodeThread(bool threaded = true);
+	// num_workers > 1 decodes that many requests in parallel (see LLQueuedThread)
+	LLImageDecodeThread(bool threaded = true, U32 num_workers = 1);
 	handle_t decodeImage(LLImageFormatted* image,
 						 U32 priority, S32 discard, BOOL needs_aux,
 						 Responder* responder);
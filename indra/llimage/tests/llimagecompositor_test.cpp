@@ -0,0 +1,250 @@
+/**
+ * @file llimagecompositor_test.cpp
+ * @brief Tests for LLImageCompositor, the GL free avatar bake compositor
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llimagecompositor.h"
+
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	LLPointer<LLImageRaw> make_image(U16 width, U16 height, S8 components, U8 value)
+	{
+		LLPointer<LLImageRaw> image = new LLImageRaw(width, height, components);
+		memset(image->getData(), value, image->getDataSize());
+		return image;
+	}
+
+	LLPointer<LLImageRaw> make_random_image(U16 width, U16 height, S8 components)
+	{
+		LLPointer<LLImageRaw> image = new LLImageRaw(width, height, components);
+		U8* data = image->getData();
+		for (S32 i = 0; i < image->getDataSize(); ++i)
+		{
+			data[i] = (U8)ll_rand(256);
+		}
+		return image;
+	}
+
+	// Pixel i of an RGBA image
+	LLColor4U get_pixel(const LLImageRaw* image, S32 i)
+	{
+		const U8* p = image->getData() + i * 4;
+		return LLColor4U(p[0], p[1], p[2], p[3]);
+	}
+
+	// The layers of a made up bake: a skin color, a tattoo, a masked
+	// undershirt and a half transparent jacket
+	std::vector<LLImageCompositor::Layer> make_layers(U16 width, U16 height)
+	{
+		std::vector<LLImageCompositor::Layer> layers;
+
+		LLImageCompositor::Layer skin;
+		skin.mColor = LLColor4U(230, 180, 160, 255);
+		layers.push_back(skin);
+
+		LLImageCompositor::Layer tattoo;
+		tattoo.mImage = make_random_image(width, height, 4);
+		layers.push_back(tattoo);
+
+		LLImageCompositor::Layer shirt;
+		shirt.mImage = make_random_image(width / 2, height / 2, 3);
+		shirt.mColor = LLColor4U(40, 90, 200, 255);
+		LLImageCompositor::AlphaMask length;
+		length.mImage = make_random_image(width, height, 1);
+		shirt.mAlphaMasks.push_back(length);
+		LLImageCompositor::AlphaMask collar;
+		collar.mImage = make_random_image(width, height, 1);
+		collar.mMultiply = true;
+		shirt.mAlphaMasks.push_back(collar);
+		layers.push_back(shirt);
+
+		LLImageCompositor::Layer jacket;
+		jacket.mImage = make_random_image(width, height, 4);
+		jacket.mColor = LLColor4U(255, 255, 255, 200);
+		LLImageCompositor::AlphaMask weight;
+		weight.mWeight = 180;
+		jacket.mAlphaMasks.push_back(weight);
+		layers.push_back(jacket);
+
+		return layers;
+	}
+
+	void bake(LLImageRaw* target, const std::vector<LLImageCompositor::Layer>& layers)
+	{
+		// LLTexLayerSet::render(): clear to opaque black, then the color layers
+		LLImageCompositor compositor(target);
+		compositor.setBlend(LLImageKernels::BLEND_REPLACE);
+		compositor.fill(LLColor4U(0, 0, 0, 255));
+		compositor.setBlend(LLImageKernels::BLEND_ALPHA);
+		for (U32 i = 0; i < layers.size(); ++i)
+		{
+			compositor.compositeLayer(layers[i]);
+		}
+	}
+}
+
+namespace tut
+{
+	struct image_compositor_data
+	{
+		~image_compositor_data()
+		{
+			LLImageKernels::initClass();
+		}
+	};
+
+	typedef test_group<image_compositor_data> image_compositor_test;
+	typedef image_compositor_test::object image_compositor_object;
+	tut::image_compositor_test image_compositor("LLImageCompositor");
+
+	template<> template<>
+	void image_compositor_object::test<1>()
+	{
+		// Rectangles, textures and color masks
+		LLPointer<LLImageRaw> target = make_image(4, 4, 4, 0);
+		LLImageCompositor compositor(target);
+
+		compositor.setBlend(LLImageKernels::BLEND_REPLACE);
+		compositor.fill(LLColor4U(10, 20, 30, 40));
+		ensure("filled", get_pixel(target, 15) == LLColor4U(10, 20, 30, 40));
+
+		// A smaller opaque texture is stretched over the target
+		compositor.setBlend(LLImageKernels::BLEND_ALPHA);
+		ensure("drawn", compositor.draw(make_image(2, 2, 3, 100), LLColor4U(255, 255, 255, 255)));
+		ensure("opaque texture", get_pixel(target, 0) == LLColor4U(100, 100, 100, 255));
+		ensure("stretched", get_pixel(target, 15) == LLColor4U(100, 100, 100, 255));
+
+		// Only the alpha channel
+		compositor.setAlphaOnly(true);
+		compositor.setBlend(LLImageKernels::BLEND_REPLACE);
+		compositor.fill(LLColor4U(1, 2, 3, 77));
+		ensure("alpha only", get_pixel(target, 5) == LLColor4U(100, 100, 100, 77));
+
+		// A single channel mask is alpha, a single channel texture is luminance
+		compositor.setBlend(LLImageKernels::BLEND_MULT_ALPHA);
+		compositor.draw(make_image(4, 4, 1, 128), LLColor4U(255, 255, 255, 255), true);
+		ensure("mask", get_pixel(target, 5) == LLColor4U(100, 100, 100, 39));
+		compositor.setAlphaOnly(false);
+		compositor.setBlend(LLImageKernels::BLEND_REPLACE);
+		compositor.draw(make_image(4, 4, 1, 128), LLColor4U(255, 128, 0, 255));
+		ensure("luminance", get_pixel(target, 5) == LLColor4U(128, 64, 0, 255));
+
+		std::vector<U8> alpha(16);
+		compositor.readAlpha(&alpha[0]);
+		ensure_equals("read alpha", (S32)alpha[3], 255);
+
+		ensure("no data", !compositor.draw(new LLImageRaw(), LLColor4U(255, 255, 255, 255)));
+	}
+
+	template<> template<>
+	void image_compositor_object::test<2>()
+	{
+		// Layers composite the way LLTexLayer::render() draws them
+		LLPointer<LLImageRaw> target = make_image(8, 8, 4, 0);
+		LLImageCompositor compositor(target);
+		compositor.setBlend(LLImageKernels::BLEND_REPLACE);
+		compositor.fill(LLColor4U(0, 0, 0, 255));
+		compositor.setBlend(LLImageKernels::BLEND_ALPHA);
+
+		LLImageCompositor::Layer red;
+		red.mColor = LLColor4U(255, 0, 0, 255);
+		compositor.compositeLayer(red);
+		ensure("color layer", get_pixel(target, 0) == LLColor4U(255, 0, 0, 255));
+
+		// The masks accumulate in the alpha channel, then the layer is drawn
+		// through it with BF_DEST_ALPHA, BF_ONE_MINUS_DEST_ALPHA
+		LLImageCompositor::Layer blue;
+		blue.mColor = LLColor4U(0, 0, 255, 255);
+		LLImageCompositor::AlphaMask half;
+		half.mWeight = 128;
+		blue.mAlphaMasks.push_back(half);
+		compositor.compositeLayer(blue);
+		ensure("masked layer", get_pixel(target, 0) == LLColor4U(127, 0, 128, 192));
+		ensure_equals("blend restored", compositor.getBlend(), LLImageKernels::BLEND_ALPHA);
+
+		// Invisible layers are skipped
+		LLImageCompositor::Layer invisible;
+		invisible.mColor = LLColor4U(0, 255, 0, 0);
+		invisible.mWriteAllChannels = true;
+		compositor.compositeLayer(invisible);
+		ensure("invisible", get_pixel(target, 0) == LLColor4U(127, 0, 128, 192));
+
+		// Layers writing all channels replace what is under them
+		LLImageCompositor::Layer eyelashes;
+		eyelashes.mImage = make_image(8, 8, 4, 50);
+		eyelashes.mWriteAllChannels = true;
+		compositor.compositeLayer(eyelashes);
+		ensure("all channels", get_pixel(target, 63) == LLColor4U(50, 50, 50, 50));
+	}
+
+	template<> template<>
+	void image_compositor_object::test<3>()
+	{
+		// The vectorized kernels bake the same bytes as the portable ones
+		const std::vector<LLImageCompositor::Layer> layers = make_layers(64, 32);
+
+		LLImageKernels::setLevel(LLImageKernels::LEVEL_GENERIC);
+		LLPointer<LLImageRaw> expected = make_image(64, 32, 4, 0);
+		bake(expected, layers);
+
+		LLImageKernels::ELevel level = LLImageKernels::setLevel(LLImageKernels::LEVEL_SSSE3);
+		if (level == LLImageKernels::LEVEL_GENERIC)
+		{
+			skip("no vectorized image kernels on this CPU or build");
+		}
+		LLPointer<LLImageRaw> baked = make_image(64, 32, 4, 0);
+		bake(baked, layers);
+		ensure("same bake", memcmp(baked->getData(), expected->getData(), baked->getDataSize()) == 0);
+	}
+
+	template<> template<>
+	void image_compositor_object::test<4>()
+	{
+		// Benchmark: baking four layers at 512x512, with the portable kernels
+		// and with each level the CPU supports. Informational only.
+		const std::vector<LLImageCompositor::Layer> layers = make_layers(512, 512);
+		LLPointer<LLImageRaw> target = make_image(512, 512, 4, 0);
+		const S32 loops = 4;
+
+		const LLImageKernels::ELevel best = LLImageKernels::setLevel(LLImageKernels::LEVEL_SSSE3);
+		for (S32 l = LLImageKernels::LEVEL_GENERIC; l <= best; ++l)
+		{
+			LLImageKernels::ELevel level = LLImageKernels::setLevel((LLImageKernels::ELevel)l);
+			LLTimer timer;
+			for (S32 i = 0; i < loops; ++i)
+			{
+				bake(target, layers);
+			}
+			llinfos << "Bake compositor " << LLImageKernels::getLevelName(level)
+					<< ": " << timer.getElapsedTimeF64() * 1000.0 / loops << " ms per bake" << llendl;
+		}
+	}
+}
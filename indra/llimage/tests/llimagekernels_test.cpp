@@ -0,0 +1,311 @@
+/**
+ * @file llimagekernels_test.cpp
+ * @brief LLImageKernels tests and benchmark
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llimagekernels.h"
+
+#include "llmath.h"
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct image_kernels_data
+	{
+		image_kernels_data()
+		{
+			LLImageKernels::setLevel(LLImageKernels::LEVEL_GENERIC);
+		}
+
+		~image_kernels_data()
+		{
+			LLImageKernels::initClass();
+		}
+
+		static void randomize(std::vector<U8>& data, bool mostly_opaque = false)
+		{
+			for (size_t i = 0; i < data.size(); ++i)
+			{
+				data[i] = (U8)ll_rand(256);
+			}
+			if (mostly_opaque)
+			{
+				// Give the alpha channel the mix of 0, 255 and partial values of a bake layer
+				for (size_t i = 3; i < data.size(); i += 4)
+				{
+					S32 r = ll_rand(4);
+					data[i] = r == 0 ? 0 : (r == 1 ? data[i] : 255);
+				}
+			}
+		}
+
+		// Float kernels may differ in the last bit when the portable ones use x87 math
+		static void ensure_close(const char* msg, const std::vector<U8>& a, const std::vector<U8>& b)
+		{
+			ensure_equals(msg, a.size(), b.size());
+			for (size_t i = 0; i < a.size(); ++i)
+			{
+				if (llabs((S32)a[i] - (S32)b[i]) > 1)
+				{
+					ensure_equals(msg, (S32)a[i], (S32)b[i]);
+				}
+			}
+		}
+
+		// Runs every kernel at level and checks it against the portable version
+		void checkLevel(LLImageKernels::ELevel level)
+		{
+			const S32 lengths[] = { 1, 5, 6, 7, 31, 64, 97, 256 };
+			for (S32 l = 0; l < (S32)LL_ARRAY_SIZE(lengths); ++l)
+			{
+				const S32 pixels = lengths[l];
+
+				std::vector<U8> rgb(pixels * 3);
+				std::vector<U8> rgba(pixels * 4);
+				randomize(rgb);
+				randomize(rgba, true);
+
+				LLImageKernels::setLevel(level);
+				std::vector<U8> out4(pixels * 4);
+				LLImageKernels::sCopy3onto4(&rgb[0], &out4[0], pixels);
+				std::vector<U8> out3(pixels * 3);
+				LLImageKernels::sCopy4onto3(&rgba[0], &out3[0], pixels);
+				std::vector<U8> comp3(rgb);
+				LLImageKernels::sComposite4onto3(&rgba[0], &comp3[0], pixels);
+
+				LLImageKernels::setLevel(LLImageKernels::LEVEL_GENERIC);
+				std::vector<U8> ref4(pixels * 4);
+				LLImageKernels::copy3onto4(&rgb[0], &ref4[0], pixels);
+				std::vector<U8> ref3(pixels * 3);
+				LLImageKernels::copy4onto3(&rgba[0], &ref3[0], pixels);
+				std::vector<U8> ref_comp3(rgb);
+				LLImageKernels::composite4onto3(&rgba[0], &ref_comp3[0], pixels);
+
+				ensure("copy3onto4", out4 == ref4);
+				ensure("copy4onto3", out3 == ref3);
+				ensure("composite4onto3", comp3 == ref_comp3);
+				ensure_equals("opaque", (S32)out4[pixels * 4 - 1], 255);
+
+				// Scale up and down
+				const S32 out_lengths[] = { 1, pixels / 2 + 1, pixels * 3 / 4 + 1, pixels * 2, pixels * 3 + 5 };
+				for (S32 o = 0; o < (S32)LL_ARRAY_SIZE(out_lengths); ++o)
+				{
+					const S32 out_pixels = out_lengths[o];
+					for (S32 components = 1; components <= 4; ++components)
+					{
+						std::vector<U8> in(pixels * components);
+						randomize(in);
+						std::vector<U8> scaled(out_pixels * components);
+						std::vector<U8> ref_scaled(out_pixels * components);
+						LLImageKernels::setLevel(level);
+						LLImageKernels::sScalePixels(&in[0], &scaled[0], pixels, out_pixels, components);
+						LLImageKernels::scalePixels(&in[0], &ref_scaled[0], pixels, out_pixels, components);
+						ensure_close("scalePixels", scaled, ref_scaled);
+					}
+
+					std::vector<U8> comp_scaled(out_pixels * 3);
+					randomize(comp_scaled);
+					std::vector<U8> ref_comp_scaled(comp_scaled);
+					LLImageKernels::sCompositeScaled4onto3(&rgba[0], &comp_scaled[0], pixels, out_pixels);
+					LLImageKernels::compositeScaled4onto3(&rgba[0], &ref_comp_scaled[0], pixels, out_pixels);
+					ensure_close("compositeScaled4onto3", comp_scaled, ref_comp_scaled);
+				}
+
+				// Every blend, with and without a texture and a color mask
+				const U8 tint[] = { 200, 255, 17, 128 };
+				std::vector<U8> under(pixels * 4);
+				randomize(under, true);
+				for (S32 mode = LLImageKernels::BLEND_REPLACE; mode <= LLImageKernels::BLEND_DEST_ALPHA; ++mode)
+				{
+					for (S32 k = 0; k < 4; ++k)
+					{
+						const U8* src = (k & 1) ? NULL : &rgba[0];
+						const bool alpha_only = (k & 2) != 0;
+						std::vector<U8> blended(under);
+						std::vector<U8> ref_blended(under);
+						LLImageKernels::setLevel(level);
+						LLImageKernels::sBlend(src, tint, &blended[0], pixels, (LLImageKernels::EBlend)mode, alpha_only);
+						LLImageKernels::blend(src, tint, &ref_blended[0], pixels, (LLImageKernels::EBlend)mode, alpha_only);
+						ensure("blend", blended == ref_blended);
+					}
+				}
+
+				std::vector<U8> masked(rgba);
+				std::vector<U8> ref_masked(rgba);
+				LLImageKernels::sMultiplyMask(&under[0], &masked[0], pixels * 4);
+				LLImageKernels::multiplyMask(&under[0], &ref_masked[0], pixels * 4);
+				ensure("multiplyMask", masked == ref_masked);
+
+				// Rows of pixels * 4 bytes, 3 of them with and without the right straddle
+				std::vector<U8> rows(pixels * 4 * 4);
+				randomize(rows);
+				const S32 stride = pixels * 4;
+				std::vector<U8> row_out(stride);
+				std::vector<U8> ref_row_out(stride);
+				LLImageKernels::sScaleRows(&rows[0], stride, 2, &rows[stride * 3], 0.25f, 0.5f, 1.f / 3.25f, &row_out[0], stride);
+				LLImageKernels::scaleRows(&rows[0], stride, 2, &rows[stride * 3], 0.25f, 0.5f, 1.f / 3.25f, &ref_row_out[0], stride);
+				ensure_close("scaleRows", row_out, ref_row_out);
+				LLImageKernels::sScaleRows(&rows[0], stride, 1, NULL, 0.5f, 0.f, 1.f / 1.5f, &row_out[0], stride);
+				LLImageKernels::scaleRows(&rows[0], stride, 1, NULL, 0.5f, 0.f, 1.f / 1.5f, &ref_row_out[0], stride);
+				ensure_close("scaleRows no last", row_out, ref_row_out);
+			}
+		}
+	};
+
+	typedef test_group<image_kernels_data> image_kernels_test;
+	typedef image_kernels_test::object image_kernels_object;
+	tut::image_kernels_test image_kernels("LLImageKernels");
+
+	template<> template<>
+	void image_kernels_object::test<1>()
+	{
+		// The portable kernels
+		U8 rgb[] = { 10, 20, 30, 40, 50, 60 };
+		U8 rgba[8];
+		LLImageKernels::copy3onto4(rgb, rgba, 2);
+		U8 expected_rgba[] = { 10, 20, 30, 255, 40, 50, 60, 255 };
+		ensure("copy3onto4", memcmp(rgba, expected_rgba, sizeof(rgba)) == 0);
+
+		U8 src[] = { 200, 100, 0, 0,   200, 100, 0, 255,   200, 100, 0, 128 };
+		U8 dst[] = { 0, 50, 100,   0, 50, 100,   0, 50, 100 };
+		LLImageKernels::composite4onto3(src, dst, 3);
+		U8 expected_dst[] = { 0, 50, 100,   200, 100, 0,   100, 75, 50 };
+		ensure("composite4onto3", memcmp(dst, expected_dst, sizeof(dst)) == 0);
+
+		// 2:1 box filter
+		U8 line[] = { 0, 100, 200, 50 };
+		U8 half[2];
+		LLImageKernels::scalePixels(line, half, 4, 2, 1);
+		ensure_equals("half 0", (S32)half[0], 50);
+		ensure_equals("half 1", (S32)half[1], 125);
+
+		// Magnified alpha comes from the alpha channel
+		U8 one_pixel[] = { 255, 0, 0, 0 };
+		U8 magnified[] = { 1, 2, 3, 4, 5, 6 };
+		LLImageKernels::compositeScaled4onto3(one_pixel, magnified, 1, 2);
+		U8 expected_magnified[] = { 1, 2, 3, 4, 5, 6 };
+		ensure("transparent magnified", memcmp(magnified, expected_magnified, sizeof(magnified)) == 0);
+
+		// Half transparent texture over opaque, the alpha channel blends too
+		const U8 white[] = { 255, 255, 255, 255 };
+		U8 texel[] = { 200, 100, 0, 128 };
+		U8 under[] = { 0, 50, 100, 255 };
+		LLImageKernels::blend(texel, white, under, 1, LLImageKernels::BLEND_ALPHA, false);
+		U8 expected_under[] = { 100, 75, 50, 191 };
+		ensure("blend alpha", memcmp(under, expected_under, sizeof(under)) == 0);
+
+		// Untextured, only the alpha channel written
+		const U8 color[] = { 1, 2, 3, 128 };
+		LLImageKernels::blend(NULL, color, under, 1, LLImageKernels::BLEND_MULT_ALPHA, true);
+		U8 expected_masked[] = { 100, 75, 50, 96 };
+		ensure("blend mult alpha", memcmp(under, expected_masked, sizeof(under)) == 0);
+
+		U8 mask[] = { 255, 0, 127 };
+		U8 alpha[] = { 255, 200, 100 };
+		LLImageKernels::multiplyMask(mask, alpha, 3);
+		U8 expected_alpha[] = { 255, 0, 50 };
+		ensure("multiplyMask", memcmp(alpha, expected_alpha, sizeof(alpha)) == 0);
+	}
+
+	template<> template<>
+	void image_kernels_object::test<2>()
+	{
+		// Vectorized kernels match the portable ones
+		LLImageKernels::ELevel level = LLImageKernels::setLevel(LLImageKernels::LEVEL_SSSE3);
+		if (level == LLImageKernels::LEVEL_GENERIC)
+		{
+			skip("no vectorized image kernels on this CPU or build");
+		}
+		if (level >= LLImageKernels::LEVEL_SSSE3)
+		{
+			checkLevel(LLImageKernels::LEVEL_SSSE3);
+		}
+		checkLevel(LLImageKernels::LEVEL_SSE2);
+	}
+
+	template<> template<>
+	void image_kernels_object::test<3>()
+	{
+		// Benchmark: the work of compositing and rescaling one 512x512 bake layer,
+		// with the portable kernels and with each level the CPU supports.
+		// Informational only, timings vary too much between machines to assert on.
+		const S32 width = 512;
+		const S32 height = 512;
+		const S32 pixels = width * height;
+		const S32 loops = 4;
+
+		std::vector<U8> rgba(pixels * 4);
+		std::vector<U8> rgb(pixels * 3);
+		std::vector<U8> out(pixels * 4);
+		std::vector<U8> half(pixels);
+		randomize(rgba, true);
+		randomize(rgb);
+
+		const LLImageKernels::ELevel best = LLImageKernels::setLevel(LLImageKernels::LEVEL_SSSE3);
+		for (S32 l = LLImageKernels::LEVEL_GENERIC; l <= best; ++l)
+		{
+			LLImageKernels::ELevel level = LLImageKernels::setLevel((LLImageKernels::ELevel)l);
+			LLTimer timer;
+			F64 convert_time = 0.0;
+			F64 composite_time = 0.0;
+			F64 scale_time = 0.0;
+			for (S32 i = 0; i < loops; ++i)
+			{
+				timer.reset();
+				LLImageKernels::sCopy3onto4(&rgb[0], &out[0], pixels);
+				LLImageKernels::sCopy4onto3(&rgba[0], &out[0], pixels);
+				convert_time += timer.getElapsedTimeF64();
+
+				timer.reset();
+				LLImageKernels::sComposite4onto3(&rgba[0], &out[0], pixels);
+				for (S32 row = 0; row < height / 2; ++row)
+				{
+					LLImageKernels::sCompositeScaled4onto3(&rgba[row * width * 4], &out[row * width * 3], width / 2, width);
+				}
+				composite_time += timer.getElapsedTimeF64();
+
+				// Halve the image: vertical pass over rows, then horizontal
+				timer.reset();
+				for (S32 row = 0; row < height / 2; ++row)
+				{
+					LLImageKernels::sScaleRows(&rgba[row * 2 * width * 4], width * 4, 1, NULL, 1.f, 0.f, 0.5f, &out[row * width * 4], width * 4);
+				}
+				for (S32 row = 0; row < height / 2; ++row)
+				{
+					LLImageKernels::sScalePixels(&out[row * width * 4], &half[row * width * 2], width, width / 2, 4);
+				}
+				scale_time += timer.getElapsedTimeF64();
+			}
+			llinfos << "Image kernels " << LLImageKernels::getLevelName(level)
+					<< ": convert " << convert_time * 1000.0 / loops << " ms"
+					<< ", composite " << composite_time * 1000.0 / loops << " ms"
+					<< ", scale " << scale_time * 1000.0 / loops << " ms" << llendl;
+		}
+	}
+}
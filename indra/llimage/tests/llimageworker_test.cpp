@@ -26,6 +26,7 @@
  */
 
 // Precompiled header: almost always required for newview cpp files
+#include "linden_common.h"
 #include <list>
 #include <map>
 #include <algorithm>
@@ -232,6 +233,30 @@ namespace tut
 		ensure("LLImageDecodeThread: threaded work unit not processed", done == true);
 	}
 
+	template<> template<>
+	void imagedecodethread_object_t::test<3>()
+	{
+		// Test a *threaded* instance of the class running several decode workers
+		mThread = new LLImageDecodeThread(true, 2);
+		ensure("LLImageDecodeThread: multi worker constructor failed", mThread != NULL);
+		ensure("LLImageDecodeThread: multi worker count incorrect", mThread->getNumWorkers() == 2);
+		bool done1 = false;
+		bool done2 = false;
+		mThread->decodeImage(NULL, LLQueuedThread::PRIORITY_NORMAL, 0, FALSE, new responder_test(&done1));
+		mThread->decodeImage(NULL, LLQueuedThread::PRIORITY_HIGH, 0, FALSE, new responder_test(&done2));
+		mThread->update(1);
+		const U32 INCREMENT_TIME = 500;				// 500 milliseconds
+		const U32 MAX_TIME = 20 * INCREMENT_TIME;	// Do the loop 20 times max, i.e. wait 10 seconds but no more
+		U32 total_time = 0;
+		while ((done1 == false || done2 == false) && (total_time < MAX_TIME))
+		{
+			ms_sleep(INCREMENT_TIME);
+			total_time += INCREMENT_TIME;
+		}
+		// Verifies that both responders have been called
+		ensure("LLImageDecodeThread: multi worker work units not processed", done1 == true && done2 == true);
+	}
+
 	// ---------------------------------------------------------------------------------------
 	// Test the LLImageDecodeThread::ImageRequest interface
 	// ---------------------------------------------------------------------------------------
@@ -92,13 +92,28 @@ void info_callback(const char* msg, void*)
 
 
 LLImageJ2COJ::LLImageJ2COJ()
-	: LLImageJ2CImpl()
+	: LLImageJ2CImpl(),
+	  mDecodedImage(NULL),
+	  mDecodedGeneration(0),
+	  mDecodedDiscardLevel(-1)
 {
 }
 
 
 LLImageJ2COJ::~LLImageJ2COJ()
 {
+	releaseDecodedImage();
+}
+
+void LLImageJ2COJ::releaseDecodedImage()
+{
+	if (mDecodedImage)
+	{
+		opj_image_destroy(mDecodedImage);
+		mDecodedImage = NULL;
+	}
+	mDecodedGeneration = 0;
+	mDecodedDiscardLevel = -1;
 }
 
 
@@ -110,52 +125,20 @@ BOOL LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 
 	LLTimer decode_timer;
 
-	opj_dparameters_t parameters;	/* decompression parameters */
-	opj_event_mgr_t event_mgr;		/* event manager */
 	opj_image_t *image = NULL;
 
-	opj_dinfo_t* dinfo = NULL;	/* handle to a decompressor */
-	opj_cio_t *cio = NULL;
-
-
-	/* configure the event callbacks (not required) */
-	memset(&event_mgr, 0, sizeof(opj_event_mgr_t));
-	event_mgr.error_handler = error_callback;
-	event_mgr.warning_handler = warning_callback;
-	event_mgr.info_handler = info_callback;
-
-	/* set decoding parameters to default values */
-	opj_set_default_decoder_parameters(&parameters);
-
-	parameters.cp_reduce = base.getRawDiscardLevel();
-
-	/* decode the code-stream */
-	/* ---------------------- */
-
-	/* JPEG-2000 codestream */
-
-	/* get a decoder handle */
-	dinfo = opj_create_decompress(CODEC_J2K);
-
-	/* catch events using our callbacks and give a local context */
-	opj_set_event_mgr((opj_common_ptr)dinfo, &event_mgr, stderr);			
-
-	/* setup the decoder decoding parameters using user parameters */
-	opj_setup_decoder(dinfo, &parameters);
-
-	/* open a byte stream */
-	cio = opj_cio_open((opj_common_ptr)dinfo, base.getData(), base.getDataSize());
-
-	/* decode the stream and fill the image structure */
-	image = opj_decode(dinfo, cio);
-
-	/* close the byte stream */
-	opj_cio_close(cio);
-
-	/* free remaining structures */
-	if(dinfo)
+	if (mDecodedImage
+		&& mDecodedGeneration == base.getDataGeneration()
+		&& mDecodedDiscardLevel == base.getRawDiscardLevel())
 	{
-		opj_destroy_decompress(dinfo);
+		// Reuse the components decoded by the previous pass over this codestream
+		image = mDecodedImage;
+		mDecodedImage = NULL;
+	}
+	else
+	{
+		releaseDecodedImage();
+		image = decodeCodestream(base);
 	}
 
 	// The image decode failed if the return was NULL or the component
@@ -243,12 +226,75 @@ BOOL LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 		}
 	}
 
-	/* free image data structure */
-	opj_image_destroy(image);
+	if (first_channel + channels < img_components)
+	{
+		// More components left for a later pass (aux channel), keep them
+		mDecodedImage = image;
+		mDecodedGeneration = base.getDataGeneration();
+		mDecodedDiscardLevel = base.getRawDiscardLevel();
+	}
+	else
+	{
+		/* free image data structure */
+		opj_image_destroy(image);
+	}
 
 	return TRUE; // done
 }
 
+opj_image_t* LLImageJ2COJ::decodeCodestream(LLImageJ2C &base)
+{
+	opj_dparameters_t parameters;	/* decompression parameters */
+	opj_event_mgr_t event_mgr;		/* event manager */
+	opj_image_t *image = NULL;
+
+	opj_dinfo_t* dinfo = NULL;	/* handle to a decompressor */
+	opj_cio_t *cio = NULL;
+
+
+	/* configure the event callbacks (not required) */
+	memset(&event_mgr, 0, sizeof(opj_event_mgr_t));
+	event_mgr.error_handler = error_callback;
+	event_mgr.warning_handler = warning_callback;
+	event_mgr.info_handler = info_callback;
+
+	/* set decoding parameters to default values */
+	opj_set_default_decoder_parameters(&parameters);
+
+	parameters.cp_reduce = base.getRawDiscardLevel();
+
+	/* decode the code-stream */
+	/* ---------------------- */
+
+	/* JPEG-2000 codestream */
+
+	/* get a decoder handle */
+	dinfo = opj_create_decompress(CODEC_J2K);
+
+	/* catch events using our callbacks and give a local context */
+	opj_set_event_mgr((opj_common_ptr)dinfo, &event_mgr, stderr);			
+
+	/* setup the decoder decoding parameters using user parameters */
+	opj_setup_decoder(dinfo, &parameters);
+
+	/* open a byte stream */
+	cio = opj_cio_open((opj_common_ptr)dinfo, base.getData(), base.getDataSize());
+
+	/* decode the stream and fill the image structure */
+	image = opj_decode(dinfo, cio);
+
+	/* close the byte stream */
+	opj_cio_close(cio);
+
+	/* free remaining structures */
+	if(dinfo)
+	{
+		opj_destroy_decompress(dinfo);
+	}
+
+	return image;
+}
+
 
 BOOL LLImageJ2COJ::encodeImpl(LLImageJ2C &base, const LLImageRaw &raw_image, const char* comment_text, F32 encode_time, BOOL reversible)
 {
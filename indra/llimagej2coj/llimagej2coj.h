@@ -29,6 +29,8 @@
 
 #include "llimagej2c.h"
 
+struct opj_image;
+
 class LLImageJ2COJ : public LLImageJ2CImpl
 {	
 public:
@@ -45,6 +47,19 @@ protected:
 		// Divide a by b to the power of 2 and round upwards.
 		return (a + (1 << b) - 1) >> b;
 	}
+
+	opj_image* decodeCodestream(LLImageJ2C &base);
+	void releaseDecodedImage();
+
+private:
+	// When a decode only copies out some of the components (e.g. the color
+	// channels of an image that also has an aux channel), the decoded
+	// components are kept so that the next decodeImpl() on the same codestream
+	// at the same discard level copies from them instead of decoding again.
+	// The codestream is the same while the image's data generation is.
+	opj_image* mDecodedImage;
+	U32 mDecodedGeneration;
+	S8 mDecodedDiscardLevel;
 };
 
 #endif
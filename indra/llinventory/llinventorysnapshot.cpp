@@ -0,0 +1,756 @@
+/**
+ * @file llinventorysnapshot.cpp
+ * @brief Memory mapped binary snapshot of an inventory, and its journal.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llinventorysnapshot.h"
+
+#include "llfile.h"
+
+namespace
+{
+	const U32 SNAPSHOT_MAGIC = 0x53494c4c;		// "LLIS"
+	const U32 JOURNAL_MAGIC = 0x4a494c4c;		// "LLIJ"
+	// Bump when the layout of the records changes
+	const U32 SNAPSHOT_FILE_VERSION = 3;
+
+	struct SnapshotHeader
+	{
+		U32 mMagic;
+		U32 mFileVersion;
+		S32 mCacheVersion;
+		U32 mNumCategories;
+		U32 mNumItems;
+		U32 mStringBytes;
+	};
+
+	struct JournalHeader
+	{
+		U32 mMagic;
+		U32 mFileVersion;
+		S32 mCacheVersion;
+	};
+
+	enum EJournalEntry
+	{
+		JOURNAL_CATEGORY = 1,	// category record, name
+		JOURNAL_ITEM = 2,		// item record, name, description
+		JOURNAL_REMOVE = 3		// id
+	};
+
+	struct JournalEntry
+	{
+		U32 mType;
+		U32 mSize;				// bytes following the entry header
+	};
+
+	void make_category_record(const LLInventoryCategory* cat, S32 version, const LLUUID& owner_id,
+							  LLInventorySnapshotCategory& record)
+	{
+		memset(&record, 0, sizeof(record));
+		record.mUUID = cat->getUUID();
+		record.mParentUUID = cat->getParentUUID();
+		record.mOwnerID = owner_id;
+		record.mVersion = version;
+		record.mType = cat->getActualType();
+		record.mPreferredType = cat->getPreferredType();
+		record.mParent = -1;
+	}
+
+	// Reads the item's own fields. The viewer's accessors return what a
+	// link points to, the snapshot stores the link.
+	void make_item_record(const LLInventoryItem* item, LLInventorySnapshotItem& record)
+	{
+		memset(&record, 0, sizeof(record));
+		const LLPermissions& perm = item->LLInventoryItem::getPermissions();
+		const LLSaleInfo& sale_info = item->LLInventoryItem::getSaleInfo();
+		record.mUUID = item->getUUID();
+		record.mParentUUID = item->getParentUUID();
+		record.mAssetUUID = item->LLInventoryItem::getAssetUUID();
+		record.mCreator = perm.getCreator();
+		record.mOwner = perm.getOwner();
+		record.mLastOwner = perm.getLastOwner();
+		record.mGroup = perm.getGroup();
+		record.mMaskBase = perm.getMaskBase();
+		record.mMaskOwner = perm.getMaskOwner();
+		record.mMaskGroup = perm.getMaskGroup();
+		record.mMaskEveryone = perm.getMaskEveryone();
+		record.mMaskNextOwner = perm.getMaskNextOwner();
+		record.mType = item->getActualType();
+		record.mInventoryType = item->LLInventoryItem::getInventoryType();
+		record.mFlags = item->LLInventoryItem::getFlags();
+		record.mCreationDate = (S32)item->LLInventoryItem::getCreationDate();
+		record.mSaleType = sale_info.getSaleType();
+		record.mSalePrice = sale_info.getSalePrice();
+	}
+
+	U32 add_string(std::string& strings, const std::string& str)
+	{
+		U32 offset = (U32)strings.size();
+		strings.append(str.c_str(), str.size() + 1);
+		return offset;
+	}
+
+	// Reads a NUL terminated string from data[offset, size)
+	bool read_string(const U8* data, U32 size, U32& offset, std::string& str)
+	{
+		const U8* start = data + offset;
+		const U8* end = (const U8*)memchr(start, 0, size - offset);
+		if (!end)
+		{
+			return false;
+		}
+		str.assign((const char*)start, end - start);
+		offset += (U32)(end - start) + 1;
+		return true;
+	}
+}
+
+//----------------------------------------------------------------------------
+// LLInventorySnapshot
+//----------------------------------------------------------------------------
+
+LLInventorySnapshot::LLInventorySnapshot()
+	: mCategories(NULL),
+	  mItems(NULL),
+	  mStrings(NULL),
+	  mNumCategories(0),
+	  mNumItems(0)
+{
+}
+
+LLInventorySnapshot::~LLInventorySnapshot()
+{
+	close();
+}
+
+//static
+std::string LLInventorySnapshot::getJournalFilename(const std::string& filename)
+{
+	return filename + ".journal";
+}
+
+bool LLInventorySnapshot::open(const std::string& filename, S32 cache_version)
+{
+	close();
+	if (LLFile::isfile(getJournalFilename(filename)))
+	{
+		compact(filename, cache_version);
+	}
+	return map(filename, cache_version);
+}
+
+void LLInventorySnapshot::close()
+{
+	mFile.close();
+	mCategories = NULL;
+	mItems = NULL;
+	mStrings = NULL;
+	mNumCategories = 0;
+	mNumItems = 0;
+}
+
+bool LLInventorySnapshot::map(const std::string& filename, S32 cache_version)
+{
+	if (!LLFile::isfile(filename) || !mFile.open(filename, 0, LLMappedFile::READ_ONLY))
+	{
+		return false;
+	}
+
+	const U8* data = mFile.getData();
+	const S64 size = mFile.getSize();
+	SnapshotHeader header;
+	if (size < (S64)sizeof(header))
+	{
+		llwarns << "Inventory snapshot " << filename << " is truncated" << llendl;
+		close();
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));		/* Flawfinder: ignore */
+	if (header.mMagic != SNAPSHOT_MAGIC
+		|| header.mFileVersion != SNAPSHOT_FILE_VERSION
+		|| header.mCacheVersion != cache_version)
+	{
+		llinfos << "Inventory snapshot " << filename << " is out of date" << llendl;
+		close();
+		return false;
+	}
+	const S64 expected = (S64)sizeof(header)
+		+ (S64)header.mNumCategories * sizeof(LLInventorySnapshotCategory)
+		+ (S64)header.mNumItems * sizeof(LLInventorySnapshotItem)
+		+ (S64)header.mStringBytes;
+	if (size != expected
+		|| (header.mStringBytes && data[size - 1] != 0)
+		|| header.mNumCategories > (U32)S32_MAX
+		|| header.mNumItems > (U32)S32_MAX)
+	{
+		llwarns << "Inventory snapshot " << filename << " is damaged" << llendl;
+		close();
+		return false;
+	}
+
+	mNumCategories = (S32)header.mNumCategories;
+	mNumItems = (S32)header.mNumItems;
+	mCategories = (const LLInventorySnapshotCategory*)(data + sizeof(header));
+	mItems = (const LLInventorySnapshotItem*)(mCategories + mNumCategories);
+	mStrings = (const char*)(mItems + mNumItems);
+
+	// Check the indices once here, so that readers can trust them
+	const U32 num_categories = header.mNumCategories;
+	const U32 num_items = header.mNumItems;
+	const U32 string_bytes = header.mStringBytes;
+	bool valid = true;
+	for (S32 i = 0; valid && i < mNumCategories; ++i)
+	{
+		const LLInventorySnapshotCategory& record = mCategories[i];
+		valid = record.mName < string_bytes
+			&& record.mParent >= -1 && record.mParent < mNumCategories
+			&& record.mFirstChild <= num_categories && record.mNumChildren <= num_categories - record.mFirstChild
+			&& record.mFirstItem <= num_items && record.mNumItems <= num_items - record.mFirstItem;
+	}
+	for (S32 i = 0; valid && i < mNumItems; ++i)
+	{
+		valid = mItems[i].mName < string_bytes && mItems[i].mDescription < string_bytes;
+	}
+	if (!valid)
+	{
+		llwarns << "Inventory snapshot " << filename << " has bad indices" << llendl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void LLInventorySnapshot::getCategory(S32 index, LLInventoryCategory* cat) const
+{
+	const LLInventorySnapshotCategory& record = mCategories[index];
+	cat->setUUID(record.mUUID);
+	cat->setParent(record.mParentUUID);
+	cat->setType((LLAssetType::EType)record.mType);
+	cat->setPreferredType((LLFolderType::EType)record.mPreferredType);
+	cat->rename(getString(record.mName));
+}
+
+void LLInventorySnapshot::getItem(S32 index, LLInventoryItem* item) const
+{
+	const LLInventorySnapshotItem& record = mItems[index];
+	LLPermissions perm;
+	perm.init(record.mCreator, record.mOwner, record.mLastOwner, record.mGroup);
+	perm.initMasks(record.mMaskBase, record.mMaskOwner, record.mMaskEveryone,
+				   record.mMaskGroup, record.mMaskNextOwner);
+
+	item->setUUID(record.mUUID);
+	item->setParent(record.mParentUUID);
+	item->setType((LLAssetType::EType)record.mType);
+	item->rename(getString(record.mName));
+	item->setDescription(getString(record.mDescription));
+	item->setAssetUUID(record.mAssetUUID);
+	item->setPermissions(perm);
+	item->setInventoryType((LLInventoryType::EType)record.mInventoryType);
+	item->setFlags(record.mFlags);
+	item->setCreationDate(record.mCreationDate);
+	item->setSaleInfo(LLSaleInfo((LLSaleInfo::EForSale)record.mSaleType, record.mSalePrice));
+}
+
+//static
+void LLInventorySnapshot::compact(const std::string& filename, S32 cache_version)
+{
+	const std::string journal = getJournalFilename(filename);
+	LLInventorySnapshotWriter writer;
+	bool have_snapshot = false;
+	{
+		LLInventorySnapshot snapshot;
+		if (snapshot.map(filename, cache_version))
+		{
+			writer.addSnapshot(snapshot);
+			have_snapshot = true;
+		}
+	}
+
+	// A journal without the snapshot it was written against is useless
+	if (have_snapshot && LLInventorySnapshotJournal::replay(journal, cache_version, writer))
+	{
+		llinfos << "Folding " << journal << " into the inventory snapshot" << llendl;
+		if (writer.write(filename, cache_version))
+		{
+			return;
+		}
+	}
+	LLFile::remove(journal);
+}
+
+//----------------------------------------------------------------------------
+// LLInventorySnapshotWriter
+//----------------------------------------------------------------------------
+
+LLInventorySnapshotWriter::LLInventorySnapshotWriter()
+	: mSequence(0)
+{
+}
+
+void LLInventorySnapshotWriter::addCategory(const LLInventoryCategory* cat, S32 version, const LLUUID& owner_id)
+{
+	LLInventorySnapshotCategory record;
+	make_category_record(cat, version, owner_id, record);
+	addCategoryRecord(record, cat->LLInventoryObject::getName());
+}
+
+void LLInventorySnapshotWriter::addItem(const LLInventoryItem* item)
+{
+	LLInventorySnapshotItem record;
+	make_item_record(item, record);
+	addItemRecord(record, item->LLInventoryItem::getName(), item->LLInventoryItem::getDescription());
+}
+
+void LLInventorySnapshotWriter::addCategoryRecord(const LLInventorySnapshotCategory& record, const std::string& name)
+{
+	std::pair<std::map<LLUUID, S32>::iterator, bool> result =
+		mCategoryIndex.insert(std::make_pair(record.mUUID, (S32)mCategories.size()));
+	if (result.second)
+	{
+		mCategories.push_back(Category());
+		mCategories.back().mInvalidated = 0;
+	}
+	Category& category = mCategories[result.first->second];
+	category.mRecord = record;
+	category.mName = name;
+	category.mRemoved = false;
+	if (record.mVersion < 0)
+	{
+		category.mInvalidated = ++mSequence;
+	}
+}
+
+void LLInventorySnapshotWriter::addItemRecord(const LLInventorySnapshotItem& record,
+											  const std::string& name, const std::string& desc)
+{
+	std::pair<std::map<LLUUID, S32>::iterator, bool> result =
+		mItemIndex.insert(std::make_pair(record.mUUID, (S32)mItems.size()));
+	if (result.second)
+	{
+		mItems.push_back(Item());
+	}
+	Item& item = mItems[result.first->second];
+	item.mRecord = record;
+	item.mName = name;
+	item.mDescription = desc;
+	item.mSequence = ++mSequence;
+	item.mRemoved = false;
+}
+
+void LLInventorySnapshotWriter::removeObject(const LLUUID& id)
+{
+	std::map<LLUUID, S32>::iterator it = mItemIndex.find(id);
+	if (it != mItemIndex.end())
+	{
+		mItems[it->second].mRemoved = true;
+	}
+	it = mCategoryIndex.find(id);
+	if (it != mCategoryIndex.end())
+	{
+		mCategories[it->second].mRemoved = true;
+	}
+}
+
+void LLInventorySnapshotWriter::addSnapshot(const LLInventorySnapshot& snapshot)
+{
+	for (S32 i = 0; i < snapshot.getNumCategories(); ++i)
+	{
+		const LLInventorySnapshotCategory& record = snapshot.getCategoryRecord(i);
+		addCategoryRecord(record, snapshot.getString(record.mName));
+	}
+	for (S32 i = 0; i < snapshot.getNumItems(); ++i)
+	{
+		const LLInventorySnapshotItem& record = snapshot.getItemRecord(i);
+		addItemRecord(record, snapshot.getString(record.mName), snapshot.getString(record.mDescription));
+	}
+}
+
+bool LLInventorySnapshotWriter::write(const std::string& filename, S32 cache_version) const
+{
+	const S32 num_added = (S32)mCategories.size();
+
+	// The parent of each category that is written, or -1, and its
+	// children as a linked list in the order they were added
+	std::vector<S32> parent(num_added, -1);
+	std::vector<S32> first_child(num_added, -1);
+	std::vector<S32> last_child(num_added, -1);
+	std::vector<S32> next_sibling(num_added, -1);
+	std::vector<bool> written(num_added, false);
+	for (S32 i = 0; i < num_added; ++i)
+	{
+		written[i] = !mCategories[i].mRemoved && mCategories[i].mRecord.mVersion >= 0;
+	}
+	for (S32 i = 0; i < num_added; ++i)
+	{
+		if (!written[i])
+		{
+			continue;
+		}
+		std::map<LLUUID, S32>::const_iterator it = mCategoryIndex.find(mCategories[i].mRecord.mParentUUID);
+		if (it != mCategoryIndex.end() && written[it->second])
+		{
+			const S32 p = it->second;
+			parent[i] = p;
+			if (last_child[p] < 0)
+			{
+				first_child[p] = i;
+			}
+			else
+			{
+				next_sibling[last_child[p]] = i;
+			}
+			last_child[p] = i;
+		}
+	}
+
+	// Breadth first from the roots, so that siblings end up next to each
+	// other. Categories in a parent loop are never reached from a root and
+	// are started from as if they were one.
+	std::vector<S32> order;
+	std::vector<S32> position(num_added, -1);
+	std::vector<LLInventorySnapshotCategory> categories;
+	for (S32 i = 0; i < num_added; ++i)
+	{
+		if (written[i] && parent[i] < 0)
+		{
+			position[i] = (S32)order.size();
+			order.push_back(i);
+		}
+	}
+	S32 next_root = 0;
+	for (U32 n = 0; ; ++n)
+	{
+		if (n == order.size())
+		{
+			while (next_root < num_added && (!written[next_root] || position[next_root] >= 0))
+			{
+				++next_root;
+			}
+			if (next_root == num_added)
+			{
+				break;
+			}
+			position[next_root] = (S32)order.size();
+			order.push_back(next_root);
+		}
+		const S32 i = order[n];
+		LLInventorySnapshotCategory record = mCategories[i].mRecord;
+		record.mParent = (parent[i] >= 0 && position[parent[i]] < (S32)n) ? position[parent[i]] : -1;
+		record.mFirstChild = (U32)order.size();
+		for (S32 child = first_child[i]; child >= 0; child = next_sibling[child])
+		{
+			if (position[child] < 0)
+			{
+				position[child] = (S32)order.size();
+				order.push_back(child);
+			}
+		}
+		record.mNumChildren = (U32)order.size() - record.mFirstChild;
+		categories.push_back(record);
+	}
+
+	// Group the items by category, leaving out the ones that aren't in a
+	// written category or are older than its last invalidation
+	std::vector<S32> item_category(mItems.size(), -1);
+	std::vector<U32> counts(categories.size() + 1, 0);
+	for (U32 i = 0; i < mItems.size(); ++i)
+	{
+		const Item& item = mItems[i];
+		if (item.mRemoved)
+		{
+			continue;
+		}
+		std::map<LLUUID, S32>::const_iterator it = mCategoryIndex.find(item.mRecord.mParentUUID);
+		if (it == mCategoryIndex.end() || position[it->second] < 0
+			|| item.mSequence < mCategories[it->second].mInvalidated)
+		{
+			continue;
+		}
+		item_category[i] = position[it->second];
+		++counts[item_category[i] + 1];
+	}
+	for (U32 c = 0; c < categories.size(); ++c)
+	{
+		counts[c + 1] += counts[c];
+		categories[c].mFirstItem = counts[c];
+		categories[c].mNumItems = counts[c + 1] - counts[c];
+	}
+	std::vector<LLInventorySnapshotItem> items(counts.back());
+	std::vector<S32> item_order(counts.back());
+	for (U32 i = 0; i < mItems.size(); ++i)
+	{
+		if (item_category[i] >= 0)
+		{
+			item_order[counts[item_category[i]]++] = i;
+		}
+	}
+
+	std::string strings;
+	for (U32 c = 0; c < categories.size(); ++c)
+	{
+		categories[c].mName = add_string(strings, mCategories[order[c]].mName);
+	}
+	for (U32 i = 0; i < items.size(); ++i)
+	{
+		const Item& item = mItems[item_order[i]];
+		items[i] = item.mRecord;
+		items[i].mName = add_string(strings, item.mName);
+		items[i].mDescription = add_string(strings, item.mDescription);
+	}
+
+	SnapshotHeader header;
+	header.mMagic = SNAPSHOT_MAGIC;
+	header.mFileVersion = SNAPSHOT_FILE_VERSION;
+	header.mCacheVersion = cache_version;
+	header.mNumCategories = (U32)categories.size();
+	header.mNumItems = (U32)items.size();
+	header.mStringBytes = (U32)strings.size();
+
+	// Write next to the old snapshot and swap, so that a failed write
+	// leaves the old one alone
+	const std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");		/* Flawfinder: ignore */
+	if (!fp)
+	{
+		llwarns << "Unable to write inventory snapshot " << temp_filename << llendl;
+		return false;
+	}
+	bool success = fwrite(&header, sizeof(header), 1, fp) == 1;
+	if (success && !categories.empty())
+	{
+		success = fwrite(&categories[0], sizeof(LLInventorySnapshotCategory), categories.size(), fp) == categories.size();
+	}
+	if (success && !items.empty())
+	{
+		success = fwrite(&items[0], sizeof(LLInventorySnapshotItem), items.size(), fp) == items.size();
+	}
+	if (success && !strings.empty())
+	{
+		success = fwrite(strings.data(), 1, strings.size(), fp) == strings.size();
+	}
+	success = (fclose(fp) == 0) && success;
+
+	if (success)
+	{
+		LLFile::remove(filename);
+		success = (LLFile::rename(temp_filename, filename) == 0);
+	}
+	if (!success)
+	{
+		llwarns << "Unable to write inventory snapshot " << filename << llendl;
+		LLFile::remove(temp_filename);
+		return false;
+	}
+
+	LLFile::remove(LLInventorySnapshot::getJournalFilename(filename));
+	lldebugs << "Wrote " << categories.size() << " categories and " << items.size()
+			 << " items to " << filename << llendl;
+	return true;
+}
+
+//----------------------------------------------------------------------------
+// LLInventorySnapshotJournal
+//----------------------------------------------------------------------------
+
+LLInventorySnapshotJournal::LLInventorySnapshotJournal()
+	: mCacheVersion(0)
+{
+}
+
+void LLInventorySnapshotJournal::setSnapshot(const std::string& filename, S32 cache_version)
+{
+	mFilename = filename;
+	mCacheVersion = cache_version;
+	mBuffer.clear();
+}
+
+void LLInventorySnapshotJournal::addCategory(const LLInventoryCategory* cat, S32 version, const LLUUID& owner_id)
+{
+	LLInventorySnapshotCategory record;
+	make_category_record(cat, version, owner_id, record);
+	appendEntry(JOURNAL_CATEGORY, &record, sizeof(record), &cat->LLInventoryObject::getName(), NULL);
+}
+
+void LLInventorySnapshotJournal::addItem(const LLInventoryItem* item)
+{
+	LLInventorySnapshotItem record;
+	make_item_record(item, record);
+	appendEntry(JOURNAL_ITEM, &record, sizeof(record), &item->LLInventoryItem::getName(),
+				&item->LLInventoryItem::getDescription());
+}
+
+void LLInventorySnapshotJournal::removeObject(const LLUUID& id)
+{
+	appendEntry(JOURNAL_REMOVE, id.mData, UUID_BYTES, NULL, NULL);
+}
+
+void LLInventorySnapshotJournal::appendEntry(U32 type, const void* record, U32 record_size,
+											 const std::string* name, const std::string* desc)
+{
+	if (mFilename.empty())
+	{
+		return;
+	}
+	JournalEntry entry;
+	entry.mType = type;
+	entry.mSize = record_size;
+	if (name)
+	{
+		entry.mSize += (U32)name->size() + 1;
+	}
+	if (desc)
+	{
+		entry.mSize += (U32)desc->size() + 1;
+	}
+	mBuffer.append((const char*)&entry, sizeof(entry));
+	mBuffer.append((const char*)record, record_size);
+	if (name)
+	{
+		mBuffer.append(name->c_str(), name->size() + 1);
+	}
+	if (desc)
+	{
+		mBuffer.append(desc->c_str(), desc->size() + 1);
+	}
+}
+
+bool LLInventorySnapshotJournal::flush()
+{
+	if (mFilename.empty() || mBuffer.empty())
+	{
+		return true;
+	}
+
+	const std::string journal = LLInventorySnapshot::getJournalFilename(mFilename);
+	LLFILE* fp = LLFile::fopen(journal, "ab");		/* Flawfinder: ignore */
+	if (!fp)
+	{
+		llwarns << "Unable to append to " << journal << llendl;
+		mBuffer.clear();
+		return false;
+	}
+	bool success = true;
+	fseek(fp, 0, SEEK_END);
+	if (ftell(fp) == 0)
+	{
+		JournalHeader header;
+		header.mMagic = JOURNAL_MAGIC;
+		header.mFileVersion = SNAPSHOT_FILE_VERSION;
+		header.mCacheVersion = mCacheVersion;
+		success = fwrite(&header, sizeof(header), 1, fp) == 1;
+	}
+	success = success && fwrite(mBuffer.data(), 1, mBuffer.size(), fp) == mBuffer.size();
+	success = (fclose(fp) == 0) && success;
+	if (!success)
+	{
+		llwarns << "Unable to append to " << journal << llendl;
+	}
+	mBuffer.clear();
+	return success;
+}
+
+//static
+bool LLInventorySnapshotJournal::replay(const std::string& filename, S32 cache_version,
+										LLInventorySnapshotWriter& writer)
+{
+	LLFILE* fp = LLFile::fopen(filename, "rb");		/* Flawfinder: ignore */
+	if (!fp)
+	{
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	const long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	std::vector<U8> data(size > 0 ? size : 0);
+	const bool read = !data.empty() && fread(&data[0], 1, data.size(), fp) == data.size();
+	fclose(fp);
+
+	JournalHeader header;
+	if (!read || data.size() < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, &data[0], sizeof(header));		/* Flawfinder: ignore */
+	if (header.mMagic != JOURNAL_MAGIC
+		|| header.mFileVersion != SNAPSHOT_FILE_VERSION
+		|| header.mCacheVersion != cache_version)
+	{
+		return false;
+	}
+
+	U32 offset = sizeof(header);
+	const U32 total = (U32)data.size();
+	std::string name;
+	std::string desc;
+	while (total - offset >= sizeof(JournalEntry))
+	{
+		JournalEntry entry;
+		memcpy(&entry, &data[offset], sizeof(entry));		/* Flawfinder: ignore */
+		offset += sizeof(entry);
+		if (entry.mSize > total - offset)
+		{
+			break;
+		}
+		const U8* payload = &data[offset];
+		const U32 end = entry.mSize;
+		offset += entry.mSize;
+
+		U32 pos = 0;
+		if (entry.mType == JOURNAL_CATEGORY && end > sizeof(LLInventorySnapshotCategory))
+		{
+			LLInventorySnapshotCategory record;
+			memcpy(&record, payload, sizeof(record));		/* Flawfinder: ignore */
+			pos = sizeof(record);
+			if (read_string(payload, end, pos, name))
+			{
+				writer.addCategoryRecord(record, name);
+				continue;
+			}
+		}
+		else if (entry.mType == JOURNAL_ITEM && end > sizeof(LLInventorySnapshotItem))
+		{
+			LLInventorySnapshotItem record;
+			memcpy(&record, payload, sizeof(record));		/* Flawfinder: ignore */
+			pos = sizeof(record);
+			if (read_string(payload, end, pos, name) && pos < end && read_string(payload, end, pos, desc))
+			{
+				writer.addItemRecord(record, name, desc);
+				continue;
+			}
+		}
+		else if (entry.mType == JOURNAL_REMOVE && end == UUID_BYTES)
+		{
+			LLUUID id;
+			memcpy(id.mData, payload, UUID_BYTES);		/* Flawfinder: ignore */
+			writer.removeObject(id);
+			continue;
+		}
+		llwarns << "Bad entry in " << filename << ", ignoring the rest" << llendl;
+		break;
+	}
+	return true;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file llinventorysnapshot.h
+ * @brief Memory mapped binary snapshot of an inventory, and its journal.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSNAPSHOT_H
+#define LL_LLINVENTORYSNAPSHOT_H
+
+#include <map>
+#include <vector>
+
+#include "llinventory.h"
+#include "llmappedfile.h"
+
+// A snapshot file is a header, the category records, the item records and
+// a table of NUL terminated strings. Categories are stored breadth first,
+// so the children of a category are contiguous, and items are grouped by
+// category, so the parent/child index is read straight from the records.
+// Categories with an unknown version aren't stored, so a category can have
+// more children than its record lists.
+// Records are in native byte order; a file from another version or
+// platform fails the header check and is simply not used.
+
+struct LLInventorySnapshotCategory
+{
+	LLUUID mUUID;
+	LLUUID mParentUUID;
+	LLUUID mOwnerID;
+	S32 mVersion;
+	S32 mType;
+	S32 mPreferredType;
+	U32 mName;			// offset in the string table
+	S32 mParent;		// index of the parent category, -1 if it isn't stored
+	U32 mFirstChild;	// index of the first child category
+	U32 mNumChildren;
+	U32 mFirstItem;		// index of the first item in the category
+	U32 mNumItems;
+};
+
+struct LLInventorySnapshotItem
+{
+	LLUUID mUUID;
+	LLUUID mParentUUID;
+	LLUUID mAssetUUID;
+	LLUUID mCreator;
+	LLUUID mOwner;
+	LLUUID mLastOwner;
+	LLUUID mGroup;
+	U32 mMaskBase;
+	U32 mMaskOwner;
+	U32 mMaskGroup;
+	U32 mMaskEveryone;
+	U32 mMaskNextOwner;
+	S32 mType;
+	S32 mInventoryType;
+	U32 mFlags;
+	S32 mCreationDate;
+	S32 mSaleType;
+	S32 mSalePrice;
+	U32 mName;			// offsets in the string table
+	U32 mDescription;
+};
+
+class LLInventorySnapshotWriter;
+
+// Read only view of a snapshot file, mapped into memory.
+class LLInventorySnapshot
+{
+public:
+	LLInventorySnapshot();
+	~LLInventorySnapshot();
+
+	// Maps filename, after folding its journal into it if there is one.
+	// Returns false if the file is missing, damaged or was written for
+	// another cache_version.
+	bool open(const std::string& filename, S32 cache_version);
+	void close();
+	bool isOpen() const { return mFile.isOpen(); }
+
+	S32 getNumCategories() const { return mNumCategories; }
+	S32 getNumItems() const { return mNumItems; }
+	const LLInventorySnapshotCategory& getCategoryRecord(S32 index) const { return mCategories[index]; }
+	const LLInventorySnapshotItem& getItemRecord(S32 index) const { return mItems[index]; }
+	const char* getString(U32 offset) const { return mStrings + offset; }
+
+	// Fill in the fields the records hold. The version and owner of a
+	// category are left to the caller, LLInventoryCategory has neither.
+	void getCategory(S32 index, LLInventoryCategory* cat) const;
+	void getItem(S32 index, LLInventoryItem* item) const;
+
+	static std::string getJournalFilename(const std::string& filename);
+
+private:
+	bool map(const std::string& filename, S32 cache_version);
+	// Rewrites filename with the changes in its journal and removes the
+	// journal
+	static void compact(const std::string& filename, S32 cache_version);
+
+	LLMappedFile mFile;
+	const LLInventorySnapshotCategory* mCategories;
+	const LLInventorySnapshotItem* mItems;
+	const char* mStrings;
+	S32 mNumCategories;
+	S32 mNumItems;
+};
+
+// Builds a snapshot in memory and writes it out in one go.
+class LLInventorySnapshotWriter
+{
+public:
+	LLInventorySnapshotWriter();
+
+	// Adding an object again replaces it. A category with a negative
+	// version isn't written and drops the items added to it so far; items
+	// added after that are kept in case the category comes back with a
+	// known version.
+	void addCategory(const LLInventoryCategory* cat, S32 version, const LLUUID& owner_id);
+	void addItem(const LLInventoryItem* item);
+	void removeObject(const LLUUID& id);
+	// Adds everything in snapshot
+	void addSnapshot(const LLInventorySnapshot& snapshot);
+
+	S32 getNumCategories() const { return (S32)mCategories.size(); }
+	S32 getNumItems() const { return (S32)mItems.size(); }
+
+	// Writes the categories and the items in categories that were written
+	// to filename, through a temporary file, and removes its journal.
+	bool write(const std::string& filename, S32 cache_version) const;
+
+private:
+	friend class LLInventorySnapshotJournal;
+
+	struct Category
+	{
+		LLInventorySnapshotCategory mRecord;
+		std::string mName;
+		// The items added before this sequence number are out of date
+		U32 mInvalidated;
+		bool mRemoved;
+	};
+	struct Item
+	{
+		LLInventorySnapshotItem mRecord;
+		std::string mName;
+		std::string mDescription;
+		U32 mSequence;
+		bool mRemoved;
+	};
+
+	void addCategoryRecord(const LLInventorySnapshotCategory& record, const std::string& name);
+	void addItemRecord(const LLInventorySnapshotItem& record, const std::string& name, const std::string& desc);
+
+	std::vector<Category> mCategories;
+	std::vector<Item> mItems;
+	std::map<LLUUID, S32> mCategoryIndex;
+	std::map<LLUUID, S32> mItemIndex;
+	U32 mSequence;
+};
+
+// Changes made since a snapshot was written, appended to a file next to
+// it so that a session that doesn't end cleanly still leaves a current
+// cache. LLInventorySnapshot::open() folds the journal back in.
+class LLInventorySnapshotJournal
+{
+public:
+	LLInventorySnapshotJournal();
+
+	// Journals changes to the snapshot filename. An empty filename turns
+	// the journal off.
+	void setSnapshot(const std::string& filename, S32 cache_version);
+	bool isEnabled() const { return !mFilename.empty(); }
+
+	// Changes are buffered until flush()
+	void addCategory(const LLInventoryCategory* cat, S32 version, const LLUUID& owner_id);
+	void addItem(const LLInventoryItem* item);
+	void removeObject(const LLUUID& id);
+	// Appends the buffered changes to the journal file
+	bool flush();
+
+	// Applies the journal to writer. Stops at the first incomplete entry,
+	// what a crash during an append leaves behind. Returns false if there
+	// is no usable journal.
+	static bool replay(const std::string& filename, S32 cache_version, LLInventorySnapshotWriter& writer);
+
+private:
+	void appendEntry(U32 type, const void* record, U32 record_size,
+					 const std::string* name, const std::string* desc);
+
+	std::string mFilename;
+	S32 mCacheVersion;
+	std::string mBuffer;
+};
+
+#endif // LL_LLINVENTORYSNAPSHOT_H
@@ -0,0 +1,277 @@
+/**
+ * @file llinventorysnapshot_test.cpp
+ * @brief Tests for LLInventorySnapshot, its writer and its journal
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llinventorysnapshot.h"
+#include "llfile.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	const S32 CACHE_VERSION = 7;
+
+	LLPointer<LLInventoryCategory> make_category(const LLUUID& parent_id, const std::string& name)
+	{
+		LLUUID id;
+		id.generate();
+		return new LLInventoryCategory(id, parent_id, LLFolderType::FT_NONE, name);
+	}
+
+	LLPointer<LLInventoryItem> make_item(const LLUUID& parent_id, const std::string& name)
+	{
+		LLUUID id, creator_id, owner_id, asset_id;
+		id.generate();
+		creator_id.generate();
+		owner_id.generate();
+		asset_id.generate();
+		LLPermissions perm;
+		perm.init(creator_id, owner_id, LLUUID::null, LLUUID::null);
+		perm.initMasks(PERM_ALL, PERM_ALL, PERM_NONE, PERM_NONE, PERM_MOVE | PERM_TRANSFER);
+		return new LLInventoryItem(id, parent_id, perm, asset_id, LLAssetType::AT_NOTECARD,
+								   LLInventoryType::IT_NOTECARD, name, name + " description",
+								   LLSaleInfo(LLSaleInfo::FS_COPY, 25), 0x1234, 1280000000);
+	}
+
+	std::string get_filename()
+	{
+		return std::string(LLFile::tmpdir()) + "llinventorysnapshot_test.invs";
+	}
+
+	// Index of the category with id in snapshot, or -1
+	S32 find_category(const LLInventorySnapshot& snapshot, const LLUUID& id)
+	{
+		for (S32 i = 0; i < snapshot.getNumCategories(); ++i)
+		{
+			if (snapshot.getCategoryRecord(i).mUUID == id)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+}
+
+namespace tut
+{
+	struct inventorysnapshot_data
+	{
+		~inventorysnapshot_data()
+		{
+			LLFile::remove(get_filename());
+			LLFile::remove(LLInventorySnapshot::getJournalFilename(get_filename()));
+		}
+	};
+	typedef test_group<inventorysnapshot_data> inventorysnapshot_test;
+	typedef inventorysnapshot_test::object inventorysnapshot_object;
+	tut::inventorysnapshot_test inventorysnapshot("LLInventorySnapshot");
+
+	template<> template<>
+	void inventorysnapshot_object::test<1>()
+	{
+		// Round trip, with the children of each category next to each other
+		LLUUID owner_id;
+		owner_id.generate();
+		LLPointer<LLInventoryCategory> root = make_category(LLUUID::null, "My Inventory");
+		LLPointer<LLInventoryCategory> a = make_category(root->getUUID(), "A");
+		LLPointer<LLInventoryCategory> c = make_category(a->getUUID(), "C");
+		LLPointer<LLInventoryCategory> b = make_category(root->getUUID(), "B");
+		LLPointer<LLInventoryItem> item_a = make_item(a->getUUID(), "in A");
+		LLPointer<LLInventoryItem> item_c = make_item(c->getUUID(), "in C");
+		LLPointer<LLInventoryItem> item_a2 = make_item(a->getUUID(), "also in A");
+
+		// Children added before their parents
+		LLInventorySnapshotWriter writer;
+		writer.addCategory(c, 3, owner_id);
+		writer.addCategory(a, 2, owner_id);
+		writer.addCategory(root, 1, owner_id);
+		writer.addCategory(b, 4, owner_id);
+		writer.addItem(item_a);
+		writer.addItem(item_c);
+		writer.addItem(item_a2);
+		ensure("written", writer.write(get_filename(), CACHE_VERSION));
+
+		LLInventorySnapshot snapshot;
+		ensure("other cache version", !snapshot.open(get_filename(), CACHE_VERSION + 1));
+		ensure("opened", snapshot.open(get_filename(), CACHE_VERSION));
+		ensure_equals("categories", snapshot.getNumCategories(), 4);
+		ensure_equals("items", snapshot.getNumItems(), 3);
+
+		const LLInventorySnapshotCategory& root_record = snapshot.getCategoryRecord(0);
+		ensure("root first", root_record.mUUID == root->getUUID());
+		ensure_equals("root parent", root_record.mParent, -1);
+		ensure_equals("root children", root_record.mNumChildren, 2U);
+		ensure_equals("root items", root_record.mNumItems, 0U);
+		for (U32 i = root_record.mFirstChild; i < root_record.mFirstChild + root_record.mNumChildren; ++i)
+		{
+			ensure_equals("child parent", snapshot.getCategoryRecord(i).mParent, 0);
+		}
+
+		S32 index = find_category(snapshot, a->getUUID());
+		const LLInventorySnapshotCategory& a_record = snapshot.getCategoryRecord(index);
+		ensure_equals("version", a_record.mVersion, 2);
+		ensure("owner", a_record.mOwnerID == owner_id);
+		ensure_equals("a items", a_record.mNumItems, 2U);
+		ensure_equals("a children", a_record.mNumChildren, 1U);
+		ensure("c", snapshot.getCategoryRecord(a_record.mFirstChild).mUUID == c->getUUID());
+		const LLInventorySnapshotCategory& c_record = snapshot.getCategoryRecord(a_record.mFirstChild);
+		ensure_equals("c parent", c_record.mParent, index);
+		ensure_equals("c items", c_record.mNumItems, 1U);
+		ensure("item in c", snapshot.getItemRecord(c_record.mFirstItem).mUUID == item_c->getUUID());
+		for (U32 i = a_record.mFirstItem; i < a_record.mFirstItem + a_record.mNumItems; ++i)
+		{
+			ensure("item parent", snapshot.getItemRecord(i).mParentUUID == a->getUUID());
+		}
+
+		LLPointer<LLInventoryCategory> loaded_cat = new LLInventoryCategory;
+		snapshot.getCategory(index, loaded_cat);
+		ensure("category id", loaded_cat->getUUID() == a->getUUID());
+		ensure("category parent", loaded_cat->getParentUUID() == root->getUUID());
+		ensure_equals("category name", loaded_cat->getName(), std::string("A"));
+
+		index = find_category(snapshot, c->getUUID());
+		ensure_equals("c items", snapshot.getCategoryRecord(index).mNumItems, 1U);
+		LLPointer<LLInventoryItem> loaded = new LLInventoryItem;
+		snapshot.getItem(snapshot.getCategoryRecord(index).mFirstItem, loaded);
+		ensure("item id", loaded->getUUID() == item_c->getUUID());
+		ensure("asset", loaded->getAssetUUID() == item_c->getAssetUUID());
+		ensure("permissions", loaded->getPermissions() == item_c->getPermissions());
+		ensure_equals("name", loaded->getName(), item_c->getName());
+		ensure_equals("description", loaded->getDescription(), item_c->getDescription());
+		ensure_equals("type", loaded->getType(), item_c->getType());
+		ensure_equals("inventory type", loaded->getInventoryType(), item_c->getInventoryType());
+		ensure_equals("flags", loaded->getFlags(), item_c->getFlags());
+		ensure_equals("creation date", loaded->getCreationDate(), item_c->getCreationDate());
+		ensure("sale info", loaded->getSaleInfo() == item_c->getSaleInfo());
+		ensure_equals("crc", loaded->getCRC32(), item_c->getCRC32());
+	}
+
+	template<> template<>
+	void inventorysnapshot_object::test<2>()
+	{
+		// Categories of unknown version and items without a written category
+		// are left out, damaged files aren't opened
+		LLPointer<LLInventoryCategory> root = make_category(LLUUID::null, "root");
+		LLPointer<LLInventoryCategory> stale = make_category(root->getUUID(), "stale");
+		LLInventorySnapshotWriter writer;
+		writer.addCategory(root, 1, LLUUID::null);
+		writer.addCategory(stale, -1, LLUUID::null);
+		writer.addItem(make_item(stale->getUUID(), "in stale"));
+		writer.addItem(make_item(LLUUID::generateNewID(), "orphan"));
+		writer.addItem(make_item(root->getUUID(), "kept"));
+		ensure("written", writer.write(get_filename(), CACHE_VERSION));
+
+		LLInventorySnapshot snapshot;
+		ensure("opened", snapshot.open(get_filename(), CACHE_VERSION));
+		ensure_equals("categories", snapshot.getNumCategories(), 1);
+		ensure_equals("stale child not listed", snapshot.getCategoryRecord(0).mNumChildren, 0U);
+		ensure_equals("items", snapshot.getNumItems(), 1);
+		ensure_equals("kept", std::string(snapshot.getString(snapshot.getItemRecord(0).mName)), std::string("kept"));
+		snapshot.close();
+
+		// Chop off the end of the string table
+		llstat stat_data;
+		LLFile::stat(get_filename(), &stat_data);
+		std::vector<char> data(stat_data.st_size);
+		LLFILE* fp = LLFile::fopen(get_filename(), "rb");
+		fread(&data[0], 1, data.size(), fp);
+		fclose(fp);
+		fp = LLFile::fopen(get_filename(), "wb");
+		fwrite(&data[0], 1, data.size() - 3, fp);
+		fclose(fp);
+		ensure("truncated", !snapshot.open(get_filename(), CACHE_VERSION));
+	}
+
+	template<> template<>
+	void inventorysnapshot_object::test<3>()
+	{
+		// The journal is folded into the snapshot the next time it is opened
+		LLUUID owner_id;
+		owner_id.generate();
+		LLPointer<LLInventoryCategory> root = make_category(LLUUID::null, "root");
+		LLPointer<LLInventoryCategory> folder = make_category(root->getUUID(), "folder");
+		LLPointer<LLInventoryItem> removed = make_item(root->getUUID(), "removed");
+		LLPointer<LLInventoryItem> renamed = make_item(root->getUUID(), "renamed");
+		LLPointer<LLInventoryItem> stale = make_item(folder->getUUID(), "stale");
+		LLInventorySnapshotWriter writer;
+		writer.addCategory(root, 1, owner_id);
+		writer.addCategory(folder, 5, owner_id);
+		writer.addItem(removed);
+		writer.addItem(renamed);
+		writer.addItem(stale);
+		ensure("written", writer.write(get_filename(), CACHE_VERSION));
+
+		LLInventorySnapshotJournal journal;
+		journal.setSnapshot(get_filename(), CACHE_VERSION);
+		journal.removeObject(removed->getUUID());
+		renamed->rename("new name");
+		journal.addItem(renamed);
+		ensure("flushed", journal.flush());
+
+		// The folder went out of date and was fetched again
+		journal.addCategory(folder, -1, owner_id);
+		LLPointer<LLInventoryItem> fetched = make_item(folder->getUUID(), "fetched");
+		journal.addItem(fetched);
+		journal.addCategory(folder, 6, owner_id);
+		LLPointer<LLInventoryItem> added = make_item(root->getUUID(), "added");
+		journal.addItem(added);
+		ensure("flushed again", journal.flush());
+
+		// What a crash in the middle of an append leaves behind
+		LLFILE* fp = LLFile::fopen(LLInventorySnapshot::getJournalFilename(get_filename()), "ab");
+		U32 partial[3] = { 2, 1000, 0 };
+		fwrite(partial, sizeof(partial), 1, fp);
+		fclose(fp);
+
+		LLInventorySnapshot snapshot;
+		ensure("opened", snapshot.open(get_filename(), CACHE_VERSION));
+		ensure("journal folded in", !LLFile::isfile(LLInventorySnapshot::getJournalFilename(get_filename())));
+		ensure_equals("categories", snapshot.getNumCategories(), 2);
+		ensure_equals("items", snapshot.getNumItems(), 3);
+
+		const LLInventorySnapshotCategory& root_record = snapshot.getCategoryRecord(0);
+		ensure_equals("root items", root_record.mNumItems, 2U);
+		for (U32 i = root_record.mFirstItem; i < root_record.mFirstItem + root_record.mNumItems; ++i)
+		{
+			const LLInventorySnapshotItem& record = snapshot.getItemRecord(i);
+			ensure("not removed", record.mUUID != removed->getUUID());
+			if (record.mUUID == renamed->getUUID())
+			{
+				ensure_equals("renamed", std::string(snapshot.getString(record.mName)), std::string("new name"));
+			}
+			else
+			{
+				ensure("added", record.mUUID == added->getUUID());
+			}
+		}
+
+		const LLInventorySnapshotCategory& folder_record = snapshot.getCategoryRecord(1);
+		ensure_equals("folder version", folder_record.mVersion, 6);
+		ensure_equals("folder items", folder_record.mNumItems, 1U);
+		ensure("only what was fetched", snapshot.getItemRecord(folder_record.mFirstItem).mUUID == fetched->getUUID());
+	}
+}
@@ -1658,7 +1658,8 @@ LLProfile::~LLProfile()
 }
 
 
-S32 LLVolume::sNumMeshPoints = 0;
+//static
+LLAtomicS32 LLVolume::sNumMeshPoints; // static storage, starts out zero
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
 	: mParams(params)
@@ -1669,6 +1670,8 @@ LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL ge
 	mFaceMask = 0x0;
 	mDetail = detail;
 	mSculptLevel = -2;
+	mSculptSizeS = 0;
+	mSculptSizeT = 0;
 	
 	// set defaults
 	if (mParams.getPathParams().getCurveType() == LL_PCODE_PATH_FLEXIBLE)
@@ -1702,6 +1705,21 @@ void LLVolume::regen()
 	createVolumeFaces();
 }
 
+void LLVolume::swapGeometry(LLVolume& volume)
+{
+	llassert(volume.mParams == mParams && volume.mDetail == mDetail);
+
+	std::swap(mPathp, volume.mPathp);
+	std::swap(mProfilep, volume.mProfilep);
+	mMesh.swap(volume.mMesh);
+	mVolumeFaces.swap(volume.mVolumeFaces);
+	std::swap(mFaceMask, volume.mFaceMask);
+	std::swap(mLODScaleBias, volume.mLODScaleBias);
+	std::swap(mSculptLevel, volume.mSculptLevel);
+	std::swap(mSculptSizeS, volume.mSculptSizeS);
+	std::swap(mSculptSizeT, volume.mSculptSizeT);
+}
+
 void LLVolume::genBinormals(S32 face)
 {
 	mVolumeFaces[face].createBinormals();
@@ -1709,7 +1727,7 @@ void LLVolume::genBinormals(S32 face)
 
 LLVolume::~LLVolume()
 {
-	sNumMeshPoints -= mMesh.size();
+	sNumMeshPoints -= (S32)mMesh.size();
 	delete mPathp;
 
 	profile_delete_lock = 0 ;
@@ -1797,9 +1815,9 @@ BOOL LLVolume::generate()
 		}
 		//********************************************************************
 
-		sNumMeshPoints -= mMesh.size();
+		sNumMeshPoints -= (S32)mMesh.size();
 		mMesh.resize(sizeT * sizeS);
-		sNumMeshPoints += mMesh.size();		
+		sNumMeshPoints += (S32)mMesh.size();		
 
 		//generate vertex positions
 
@@ -2197,6 +2215,30 @@ void sculpt_calc_mesh_resolution(U16 width, U16 height, U8 type, F32 detail, S32
 	s = vertices / t;
 }
 
+// Generates path and profile for a sculpt mesh of about requested_sizeS by
+// requested_sizeT points, and makes room for the mesh
+void LLVolume::sculptResizeMesh(S32 requested_sizeS, S32 requested_sizeT)
+{
+	mSculptSizeS = requested_sizeS;
+	mSculptSizeT = requested_sizeT;
+
+	mPathp->generate(mParams.getPathParams(), mDetail, 0, TRUE, requested_sizeS);
+	mProfilep->generate(mParams.getProfileParams(), mPathp->isOpen(), mDetail, 0, TRUE, requested_sizeT);
+
+	S32 sizeS = mPathp->mPath.size();         // we requested a specific size, now see what we really got
+	S32 sizeT = mProfilep->mProfile.size();   // we requested a specific size, now see what we really got
+
+	// weird crash bug - DEV-11158 - trying to collect more data:
+	if ((sizeS == 0) || (sizeT == 0))
+	{
+		llwarns << "sculpt bad mesh size " << sizeS << " " << sizeT << llendl;
+	}
+	
+	sNumMeshPoints -= (S32)mMesh.size();
+	mMesh.resize(sizeS * sizeT);
+	sNumMeshPoints += (S32)mMesh.size();
+}
+
 // sculpt replaces generate() for sculpted surfaces
 void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, S32 sculpt_level)
 {
@@ -2215,22 +2257,7 @@ void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
 	S32 requested_sizeT = 0;
 
 	sculpt_calc_mesh_resolution(sculpt_width, sculpt_height, sculpt_type, mDetail, requested_sizeS, requested_sizeT);
-
-	mPathp->generate(mParams.getPathParams(), mDetail, 0, TRUE, requested_sizeS);
-	mProfilep->generate(mParams.getProfileParams(), mPathp->isOpen(), mDetail, 0, TRUE, requested_sizeT);
-
-	S32 sizeS = mPathp->mPath.size();         // we requested a specific size, now see what we really got
-	S32 sizeT = mProfilep->mProfile.size();   // we requested a specific size, now see what we really got
-
-	// weird crash bug - DEV-11158 - trying to collect more data:
-	if ((sizeS == 0) || (sizeT == 0))
-	{
-		llwarns << "sculpt bad mesh size " << sizeS << " " << sizeT << llendl;
-	}
-	
-	sNumMeshPoints -= mMesh.size();
-	mMesh.resize(sizeS * sizeT);
-	sNumMeshPoints += mMesh.size();
+	sculptResizeMesh(requested_sizeS, requested_sizeT);
 
 	//generate vertex positions
 	if (!data_is_empty)
@@ -37,6 +37,7 @@ class LLPath;
 class LLVolumeFace;
 class LLVolume;
 
+#include "llapr.h"		// for LLAtomicS32
 #include "lldarray.h"
 #include "lluuid.h"
 #include "v4color.h"
@@ -846,6 +847,7 @@ private:
 class LLVolume : public LLRefCount
 {
 	friend class LLVolumeLODGroup;
+	friend class LLVolumeCache;
 
 private:
 	LLVolume(const LLVolume&);  // Don't implement
@@ -931,7 +933,7 @@ public:
 	LLFaceID generateFaceMask();
 
 	BOOL isFaceMaskValid(LLFaceID face_mask);
-	static S32 sNumMeshPoints;
+	static LLAtomicS32 sNumMeshPoints; // volumes are built on LLVolumeBuildThread too
 
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);		// HACK to bypass Windoze confusion over 
@@ -942,11 +944,16 @@ public:
 	LLVector3			mLODScaleBias;		// vector for biasing LOD based on scale
 	
 	void sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, S32 sculpt_level);
+
+	// Trades path, profile, mesh and faces with a volume of the same
+	// parameters and detail, e.g. one sculpted on LLVolumeBuildThread.
+	void swapGeometry(LLVolume& volume);
 private:
 	void sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, U8 sculpt_type);
 	F32 sculptGetSurfaceArea();
 	void sculptGeneratePlaceholder();
 	void sculptCalcMeshResolution(U16 width, U16 height, U8 type, S32& s, S32& t);
+	void sculptResizeMesh(S32 requested_sizeS, S32 requested_sizeT);
 
 	
 protected:
@@ -957,6 +964,8 @@ protected:
 	BOOL mUnique;
 	F32 mDetail;
 	S32 mSculptLevel;
+	S32 mSculptSizeS;	// mesh size sculpt() asked for, to regenerate path and profile
+	S32 mSculptSizeT;
 	
 	LLVolumeParams mParams;
 	LLPath *mPathp;
@@ -0,0 +1,167 @@
+/**
+ * @file llvolumebuildthread.cpp
+ * @brief LLVolumeBuildThread class.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumebuildthread.h"
+#include "llmemtype.h"
+#include "llvolumecache.h"
+
+//----------------------------------------------------------------------------
+
+// MAIN THREAD
+LLVolumeBuildThread::LLVolumeBuildThread(bool threaded, U32 num_workers)
+	: LLQueuedThread("volumebuild", threaded, num_workers)
+{
+}
+
+// MAIN THREAD
+LLVolumeBuildThread::handle_t LLVolumeBuildThread::buildVolume(const LLVolumeParams& params, F32 detail, U32 priority)
+{
+	return addBuildRequest(new BuildRequest(generateHandle(), priority, this, params, detail,
+											0, 0, 0, NULL, -2));
+}
+
+// MAIN THREAD
+LLVolumeBuildThread::handle_t LLVolumeBuildThread::sculptVolume(const LLVolumeParams& params, F32 detail,
+																U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+																const U8* sculpt_data, S32 sculpt_level, U32 priority)
+{
+	return addBuildRequest(new BuildRequest(generateHandle(), priority, this, params, detail,
+											sculpt_width, sculpt_height, sculpt_components,
+											sculpt_data, sculpt_level));
+}
+
+// MAIN THREAD
+LLVolumeBuildThread::handle_t LLVolumeBuildThread::readCacheFile(const std::string& filename, const LLUUID& digest,
+																 const LLVolumeParams& params, F32 detail, U32 priority)
+{
+	BuildRequest* req = new BuildRequest(generateHandle(), priority, this, BuildRequest::READ_CACHE_FILE, filename);
+	req->mDigest = digest;
+	req->mParams = params;
+	req->mDetail = detail;
+	return addBuildRequest(req);
+}
+
+// MAIN THREAD
+LLVolumeBuildThread::handle_t LLVolumeBuildThread::writeCacheFile(const std::string& filename, std::string& data, U32 priority)
+{
+	BuildRequest* req = new BuildRequest(generateHandle(), priority, this, BuildRequest::WRITE_CACHE_FILE, filename);
+	req->mFileData.swap(data);
+	return addBuildRequest(req);
+}
+
+LLVolumeBuildThread::handle_t LLVolumeBuildThread::addBuildRequest(BuildRequest* req)
+{
+	handle_t handle = req->getHashKey();
+	if (!addRequest(req))
+	{
+		llerrs << "request added after LLVolumeBuildThread::shutdown()" << llendl;
+	}
+	return handle;
+}
+
+// MAIN THREAD
+void LLVolumeBuildThread::getFinishedRequests(std::vector<handle_t>& handles)
+{
+	lockData();
+	handles.swap(mFinished);
+	mFinished.clear();
+	unlockData();
+}
+
+//----------------------------------------------------------------------------
+
+LLVolumeBuildThread::BuildRequest::BuildRequest(handle_t handle, U32 priority, LLVolumeBuildThread* thread,
+												const LLVolumeParams& params, F32 detail,
+												U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+												const U8* sculpt_data, S32 sculpt_level)
+	: LLQueuedThread::QueuedRequest(handle, priority),
+	  mType(BUILD_VOLUME),
+	  mParams(params),
+	  mDetail(detail),
+	  mSculptWidth(sculpt_width),
+	  mSculptHeight(sculpt_height),
+	  mSculptComponents(sculpt_components),
+	  mSculptLevel(sculpt_level),
+	  mThread(thread)
+{
+	if (sculpt_data)
+	{
+		mSculptData.assign(sculpt_data, sculpt_data + sculpt_width * sculpt_height * sculpt_components);
+	}
+}
+
+LLVolumeBuildThread::BuildRequest::BuildRequest(handle_t handle, U32 priority, LLVolumeBuildThread* thread,
+												ERequestType type, const std::string& filename)
+	: LLQueuedThread::QueuedRequest(handle, priority),
+	  mType(type),
+	  mFilename(filename),
+	  mDetail(0.f),
+	  mSculptWidth(0),
+	  mSculptHeight(0),
+	  mSculptComponents(0),
+	  mSculptLevel(-2),
+	  mThread(thread)
+{
+}
+
+// MAIN THREAD, from completeRequest()
+LLVolumeBuildThread::BuildRequest::~BuildRequest()
+{
+	mVolume = NULL;
+}
+
+// ANY THREAD
+bool LLVolumeBuildThread::BuildRequest::processRequest()
+{
+	if (mType == READ_CACHE_FILE)
+	{
+		mVolume = LLVolumeCache::readVolumeFile(mFilename, mDigest, mParams, mDetail);
+		return true;
+	}
+	if (mType == WRITE_CACHE_FILE)
+	{
+		LLVolumeCache::writeVolumeFile(mFilename, mFileData);
+		return true;
+	}
+
+	LLMemType m1(LLMemType::MTYPE_VOLUME);
+	LLPointer<LLVolume> volume = new LLVolume(mParams, mDetail);
+	if (mSculptLevel != -2)
+	{
+		volume->sculpt(mSculptWidth, mSculptHeight, mSculptComponents,
+					   mSculptData.empty() ? NULL : &mSculptData[0], mSculptLevel);
+	}
+	mVolume = volume;
+	return true;
+}
+
+// ANY THREAD, with the thread's data locked
+void LLVolumeBuildThread::BuildRequest::finishRequest(bool completed)
+{
+	mThread->mFinished.push_back(getHashKey());
+}
@@ -0,0 +1,119 @@
+/**
+ * @file llvolumebuildthread.h
+ * @brief LLVolumeBuildThread class.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEBUILDTHREAD_H
+#define LL_LLVOLUMEBUILDTHREAD_H
+
+#include <string>
+#include <vector>
+
+#include "llpointer.h"
+#include "llqueuedthread.h"
+#include "llvolume.h"
+
+// Builds LLVolumes (path, profile, mesh and LLVolumeFaces) on worker
+// threads, and reads and writes the LLVolumeCache files.  Every volume is a
+// new one owned by its request, so the workers never touch volumes the main
+// thread can see.  LLVolumeMgr queues the requests and swaps the results in
+// on the main thread.
+class LLVolumeBuildThread : public LLQueuedThread
+{
+public:
+	class BuildRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~BuildRequest(); // use deleteRequest()
+
+	public:
+		enum ERequestType
+		{
+			BUILD_VOLUME,
+			READ_CACHE_FILE,
+			WRITE_CACHE_FILE
+		};
+
+		// sculpt_data is copied, a NULL sculpt_data builds an unsculpted volume
+		BuildRequest(handle_t handle, U32 priority, LLVolumeBuildThread* thread,
+					 const LLVolumeParams& params, F32 detail,
+					 U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+					 const U8* sculpt_data, S32 sculpt_level);
+		// READ_CACHE_FILE or WRITE_CACHE_FILE, see LLVolumeCache
+		BuildRequest(handle_t handle, U32 priority, LLVolumeBuildThread* thread,
+					 ERequestType type, const std::string& filename);
+
+		/*virtual*/ bool processRequest();
+		/*virtual*/ void finishRequest(bool completed);
+
+		// Only valid once the request is complete
+		LLVolume* getVolume() const { return mVolume; }
+
+	private:
+		friend class LLVolumeBuildThread;
+
+		// input
+		ERequestType mType;
+		std::string mFilename;
+		LLUUID mDigest;
+		std::string mFileData;
+		LLVolumeParams mParams;
+		F32 mDetail;
+		U16 mSculptWidth;
+		U16 mSculptHeight;
+		S8 mSculptComponents;
+		std::vector<U8> mSculptData;
+		S32 mSculptLevel;
+		LLVolumeBuildThread* mThread;
+		// output
+		LLPointer<LLVolume> mVolume;
+	};
+
+public:
+	LLVolumeBuildThread(bool threaded = true, U32 num_workers = 1);
+
+	// Same result as new LLVolume(params, detail)
+	handle_t buildVolume(const LLVolumeParams& params, F32 detail, U32 priority);
+	// Same result as new LLVolume(params, detail) followed by sculpt()
+	handle_t sculptVolume(const LLVolumeParams& params, F32 detail,
+						  U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+						  const U8* sculpt_data, S32 sculpt_level, U32 priority);
+	// LLVolumeCache::readVolumeFile(), the volume is NULL on a miss
+	handle_t readCacheFile(const std::string& filename, const LLUUID& digest,
+						   const LLVolumeParams& params, F32 detail, U32 priority);
+	// LLVolumeCache::writeVolumeFile(), takes data by swapping it
+	handle_t writeCacheFile(const std::string& filename, std::string& data, U32 priority);
+
+	// MAIN thread: moves the handles of the requests that completed or were
+	// aborted since the last call into handles.  Their volumes are released
+	// by completeRequest().
+	void getFinishedRequests(std::vector<handle_t>& handles);
+
+private:
+	handle_t addBuildRequest(BuildRequest* req);
+
+	std::vector<handle_t> mFinished; // protected by lockData()
+};
+
+#endif // LL_LLVOLUMEBUILDTHREAD_H
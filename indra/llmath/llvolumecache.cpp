@@ -0,0 +1,584 @@
+/**
+ * @file llvolumecache.cpp
+ * @brief LLVolumeCache class.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumecache.h"
+
+#include "llfile.h"
+#include "llformat.h"
+#include "llmd5.h"
+#include "llmemtype.h"
+#include "llsdserialize.h"
+
+//============================================================================
+
+static const U32 FILE_MAGIC = 0x4c4c5643; // "LLVC"
+static const U32 FILE_VERSION = 1;
+// Sanity limits for sizes read from files
+static const U32 MAX_FILE_MESH_POINTS = 1 << 16;
+static const U32 MAX_FILE_FACES = 16;
+static const U32 MAX_FILE_ELEMENTS = 1 << 20;
+// MAX_DISCARD_LEVEL, llimage isn't a dependency of llmath
+static const S32 MAX_FILE_SCULPT_LEVEL = 5;
+
+struct LLVolumeCacheFileHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U8 mDigest[UUID_BYTES];
+	F32 mDetail;
+	S32 mSculptLevel;
+	S32 mSculptSizeS;
+	S32 mSculptSizeT;
+	U32 mFaceMask;
+	F32 mLODScaleBias[3];
+	U32 mNumMeshPoints;
+	U32 mNumFaces;
+};
+
+struct LLVolumeCacheFileFace
+{
+	S32 mID;
+	U32 mTypeMask;
+	F32 mCenter[3];
+	S32 mHasBinormals;
+	S32 mBeginS;
+	S32 mBeginT;
+	S32 mNumS;
+	S32 mNumT;
+	F32 mExtents[6];
+	U32 mNumVertices;
+	U32 mNumIndices;
+	U32 mNumTriStrip;
+	U32 mNumEdge;
+};
+
+template<class T>
+static void append_value(std::string& data, const T& value)
+{
+	data.append((const char*)&value, sizeof(T));
+}
+
+template<class T>
+static void append_elements(std::string& data, const std::vector<T>& elements)
+{
+	if (!elements.empty())
+	{
+		data.append((const char*)&elements[0], elements.size() * sizeof(T));
+	}
+}
+
+template<class T>
+static bool read_elements(LLFILE* fp, std::vector<T>& elements, U32 count)
+{
+	if (count > MAX_FILE_ELEMENTS)
+	{
+		return false;
+	}
+	elements.resize(count);
+	return !count || fread(&elements[0], sizeof(T), count, fp) == count;
+}
+
+//============================================================================
+
+LLVolumeCache::LLVolumeCache(U32 max_bytes)
+	: mBytes(0),
+	  mMaxBytes(max_bytes),
+	  mMaxFiles(0),
+	  mHits(0),
+	  mMisses(0),
+	  mFileHits(0)
+{
+}
+
+LLVolumeCache::~LLVolumeCache()
+{
+	clear();
+}
+
+void LLVolumeCache::setCacheDir(const std::string& dir, U32 max_files)
+{
+	mCacheDir = dir;
+	mMaxFiles = dir.empty() ? 0 : max_files;
+	mSlots.clear();
+	mFileWrites.clear();
+	if (mMaxFiles)
+	{
+		LLFile::mkdir(mCacheDir);
+	}
+}
+
+void LLVolumeCache::setMaxBytes(U32 max_bytes)
+{
+	mMaxBytes = max_bytes;
+	evict(mMaxBytes);
+}
+
+void LLVolumeCache::clear()
+{
+	mEntries.clear();
+	mLRU.clear();
+	mBytes = 0;
+}
+
+//static
+bool LLVolumeCache::isCacheable(const LLVolume* volumep)
+{
+	if (volumep->isUnique() || volumep->getNumVolumeFaces() == 0)
+	{
+		return false;
+	}
+	const LLVolumeParams& params = volumep->getParams();
+	bool sculpted = params.getSculptID().notNull() || params.getSculptType() != LL_SCULPT_TYPE_NONE;
+	// A sculpt without sculpt data is only a placeholder
+	return !sculpted || volumep->getSculptLevel() >= 0;
+}
+
+void LLVolumeCache::retainVolume(LLVolume* volumep)
+{
+	if (!isCacheable(volumep) || (!mMaxBytes && !mMaxFiles))
+	{
+		return;
+	}
+
+	LLUUID digest = getDigest(volumep->getParams(), volumep->getDetail());
+	if (volumep->getSculptLevel() >= 0 && mMaxFiles)
+	{
+		queueFileWrite(digest, volumep);
+	}
+	if (!mMaxBytes)
+	{
+		return;
+	}
+
+	entry_map_t::iterator iter = mEntries.find(digest);
+	if (iter != mEntries.end())
+	{
+		// Another instance of the same geometry, keep the better sculpt
+		if (iter->second.mVolume->getSculptLevel() <= volumep->getSculptLevel())
+		{
+			return;
+		}
+		mBytes -= iter->second.mBytes;
+		mLRU.erase(iter->second.mLRU);
+		mEntries.erase(iter);
+	}
+
+	Entry& entry = mEntries[digest];
+	entry.mVolume = volumep;
+	entry.mBytes = getVolumeBytes(volumep);
+	entry.mLRU = mLRU.insert(mLRU.end(), digest);
+	mBytes += entry.mBytes;
+
+	evict(mMaxBytes);
+}
+
+LLPointer<LLVolume> LLVolumeCache::findVolume(const LLVolumeParams& params, F32 detail)
+{
+	if (!mMaxBytes && !mMaxFiles)
+	{
+		return NULL;
+	}
+
+	LLUUID digest = getDigest(params, detail);
+	entry_map_t::iterator iter = mEntries.find(digest);
+	if (iter != mEntries.end())
+	{
+		LLPointer<LLVolume> volumep = iter->second.mVolume;
+		mBytes -= iter->second.mBytes;
+		mLRU.erase(iter->second.mLRU);
+		mEntries.erase(iter);
+		if (volumep->getParams() == params && volumep->getDetail() == detail)
+		{
+			++mHits;
+			return volumep;
+		}
+		// A digest collision, vanishingly unlikely
+		llwarns << "Volume cache digest collision for " << params << llendl;
+	}
+
+	++mMisses;
+	return NULL;
+}
+
+void LLVolumeCache::evict(U32 max_bytes)
+{
+	while (mBytes > max_bytes && !mLRU.empty())
+	{
+		entry_map_t::iterator iter = mEntries.find(mLRU.front());
+		llassert(iter != mEntries.end());
+		mBytes -= iter->second.mBytes;
+		mEntries.erase(iter);
+		mLRU.pop_front();
+	}
+}
+
+//static
+U32 LLVolumeCache::getVolumeBytes(const LLVolume* volumep)
+{
+	U32 bytes = sizeof(LLVolume);
+	bytes += volumep->getMesh().size() * sizeof(LLVolume::Point);
+	bytes += volumep->getPath().mPath.size() * sizeof(LLPath::PathPt);
+	bytes += volumep->getProfile().mProfile.size() * sizeof(LLVector3);
+	for (S32 i = 0; i < volumep->getNumVolumeFaces(); ++i)
+	{
+		const LLVolumeFace& face = volumep->getVolumeFace(i);
+		bytes += sizeof(LLVolumeFace);
+		bytes += face.mVertices.size() * sizeof(LLVolumeFace::VertexData);
+		bytes += (face.mIndices.size() + face.mTriStrip.size()) * sizeof(U16);
+		bytes += face.mEdge.size() * sizeof(S32);
+	}
+	return bytes;
+}
+
+//static
+LLUUID LLVolumeCache::getDigest(const LLVolumeParams& params, F32 detail)
+{
+	// The binary LLSD format keeps reals exact.  asLLSD() leaves out the
+	// sculpt parameters.
+	std::ostringstream str;
+	LLSDSerialize::toBinary(params.asLLSD(), str);
+	str.write((const char*)params.getSculptID().mData, UUID_BYTES);
+	U8 sculpt_type = params.getSculptType();
+	str.write((const char*)&sculpt_type, sizeof(sculpt_type));
+	str.write((const char*)&detail, sizeof(detail));
+
+	std::string data = str.str();
+	LLMD5 md5;
+	md5.update((const unsigned char*)data.data(), data.size());
+	md5.finalize();
+
+	LLUUID digest;
+	md5.raw_digest(digest.mData);
+	return digest;
+}
+
+//----------------------------------------------------------------------------
+// Files
+
+U32 LLVolumeCache::getSlot(const LLUUID& digest) const
+{
+	return digest.getCRC32() % mMaxFiles;
+}
+
+std::string LLVolumeCache::getFilename(const LLUUID& digest) const
+{
+	return llformat("%s/%u.vol", mCacheDir.c_str(), getSlot(digest));
+}
+
+bool LLVolumeCache::popFileWrite(std::string& filename, std::string& data)
+{
+	if (mFileWrites.empty())
+	{
+		return false;
+	}
+	filename.swap(mFileWrites.front().first);
+	data.swap(mFileWrites.front().second);
+	mFileWrites.pop_front();
+	return true;
+}
+
+bool LLVolumeCache::getFileRead(const LLVolumeParams& params, F32 detail, std::string& filename, LLUUID& digest)
+{
+	bool sculpted = params.getSculptID().notNull() || params.getSculptType() != LL_SCULPT_TYPE_NONE;
+	if (!sculpted || !mMaxFiles)
+	{
+		return false;
+	}
+	digest = getDigest(params, detail);
+	slot_map_t::const_iterator iter = mSlots.find(getSlot(digest));
+	if (iter != mSlots.end() &&
+		(iter->second.first == digest ? iter->second.second < 0 : iter->second.second >= 0))
+	{
+		// Known not to hold it
+		return false;
+	}
+	filename = getFilename(digest);
+	return true;
+}
+
+void LLVolumeCache::setFileRead(const LLUUID& digest, S32 sculpt_level)
+{
+	if (!mMaxFiles)
+	{
+		return;
+	}
+	if (sculpt_level >= 0)
+	{
+		++mFileHits;
+	}
+	// A negative level says the slot doesn't hold digest
+	mSlots[getSlot(digest)] = std::make_pair(digest, sculpt_level);
+}
+
+void LLVolumeCache::queueFileWrite(const LLUUID& digest, const LLVolume* volumep)
+{
+	U32 slot = getSlot(digest);
+	slot_map_t::const_iterator iter = mSlots.find(slot);
+	if (iter != mSlots.end() && iter->second.first == digest &&
+		iter->second.second >= 0 && iter->second.second <= volumep->getSculptLevel())
+	{
+		// Already there, as good or better
+		return;
+	}
+
+	mFileWrites.push_back(std::make_pair(getFilename(digest), std::string()));
+	serializeVolume(digest, volumep, mFileWrites.back().second);
+	mSlots[slot] = std::make_pair(digest, volumep->getSculptLevel());
+}
+
+//static
+void LLVolumeCache::serializeVolume(const LLUUID& digest, const LLVolume* volumep, std::string& data)
+{
+	LLVolumeCacheFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = FILE_MAGIC;
+	header.mVersion = FILE_VERSION;
+	memcpy(header.mDigest, digest.mData, UUID_BYTES);	/* Flawfinder: ignore */
+	header.mDetail = volumep->mDetail;
+	header.mSculptLevel = volumep->mSculptLevel;
+	header.mSculptSizeS = volumep->mSculptSizeS;
+	header.mSculptSizeT = volumep->mSculptSizeT;
+	header.mFaceMask = volumep->mFaceMask;
+	for (S32 i = 0; i < 3; ++i)
+	{
+		header.mLODScaleBias[i] = volumep->mLODScaleBias.mV[i];
+	}
+	header.mNumMeshPoints = volumep->mMesh.size();
+	header.mNumFaces = volumep->mVolumeFaces.size();
+
+	data.clear();
+	append_value(data, header);
+	append_elements(data, volumep->mMesh);
+	for (U32 i = 0; i < header.mNumFaces; ++i)
+	{
+		const LLVolumeFace& face = volumep->mVolumeFaces[i];
+		LLVolumeCacheFileFace file_face;
+		memset(&file_face, 0, sizeof(file_face));
+		file_face.mID = face.mID;
+		file_face.mTypeMask = face.mTypeMask;
+		memcpy(file_face.mCenter, face.mCenter.mV, sizeof(file_face.mCenter));	/* Flawfinder: ignore */
+		file_face.mHasBinormals = face.mHasBinormals;
+		file_face.mBeginS = face.mBeginS;
+		file_face.mBeginT = face.mBeginT;
+		file_face.mNumS = face.mNumS;
+		file_face.mNumT = face.mNumT;
+		memcpy(file_face.mExtents, face.mExtents[0].mV, 3 * sizeof(F32));	/* Flawfinder: ignore */
+		memcpy(file_face.mExtents + 3, face.mExtents[1].mV, 3 * sizeof(F32));	/* Flawfinder: ignore */
+		file_face.mNumVertices = face.mVertices.size();
+		file_face.mNumIndices = face.mIndices.size();
+		file_face.mNumTriStrip = face.mTriStrip.size();
+		file_face.mNumEdge = face.mEdge.size();
+
+		append_value(data, file_face);
+		append_elements(data, face.mVertices);
+		append_elements(data, face.mIndices);
+		append_elements(data, face.mTriStrip);
+		append_elements(data, face.mEdge);
+	}
+}
+
+//static
+bool LLVolumeCache::writeVolumeFile(const std::string& filename, const std::string& data)
+{
+	if (data.size() < sizeof(LLVolumeCacheFileHeader))
+	{
+		return false;
+	}
+	LLVolumeCacheFileHeader header;
+	memcpy(&header, data.data(), sizeof(header));	/* Flawfinder: ignore */
+
+	LLFILE* fp = LLFile::fopen(filename, "rb");	/* Flawfinder: ignore */
+	if (fp)
+	{
+		LLVolumeCacheFileHeader old_header;
+		bool keep = fread(&old_header, sizeof(old_header), 1, fp) == 1 &&
+			old_header.mMagic == FILE_MAGIC && old_header.mVersion == FILE_VERSION &&
+			!memcmp(old_header.mDigest, header.mDigest, UUID_BYTES) &&
+			old_header.mSculptLevel >= 0 && old_header.mSculptLevel <= header.mSculptLevel;
+		fclose(fp);
+		if (keep)
+		{
+			return true;
+		}
+	}
+
+	// Unique, two workers may write the same slot
+	std::string temp_filename = filename + "." + LLUUID::generateNewID().asString() + ".tmp";
+	fp = LLFile::fopen(temp_filename, "wb");	/* Flawfinder: ignore */
+	if (!fp)
+	{
+		return false;
+	}
+	bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+	ok = (fclose(fp) == 0) && ok;
+	if (ok)
+	{
+		LLFile::remove(filename);
+		ok = LLFile::rename(temp_filename, filename) == 0;
+	}
+	if (!ok)
+	{
+		llwarns << "Failed to write volume cache file " << filename << llendl;
+		LLFile::remove(temp_filename);
+	}
+	return ok;
+}
+
+//static
+LLPointer<LLVolume> LLVolumeCache::readVolumeFile(const std::string& filename, const LLUUID& digest,
+												  const LLVolumeParams& params, F32 detail)
+{
+	LLFILE* fp = LLFile::fopen(filename, "rb");	/* Flawfinder: ignore */
+	if (!fp)
+	{
+		return NULL;
+	}
+
+	LLVolumeCacheFileHeader header;
+	bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+		header.mMagic == FILE_MAGIC && header.mVersion == FILE_VERSION;
+	if (ok && (memcmp(header.mDigest, digest.mData, UUID_BYTES) || header.mDetail != detail))
+	{
+		// The slot holds another volume
+		fclose(fp);
+		return NULL;
+	}
+
+	LLMemType m1(LLMemType::MTYPE_VOLUME);
+	LLPointer<LLVolume> volumep;
+	ok = ok &&
+		header.mNumMeshPoints <= MAX_FILE_MESH_POINTS &&
+		header.mNumFaces <= MAX_FILE_FACES &&
+		header.mSculptLevel >= 0 && header.mSculptLevel <= MAX_FILE_SCULPT_LEVEL &&
+		header.mSculptSizeS > 0 && header.mSculptSizeT > 0 &&
+		(U64)header.mSculptSizeS * (U64)header.mSculptSizeT <= MAX_FILE_MESH_POINTS;
+	if (ok)
+	{
+		// Sculpts don't get faces until sculpt()
+		volumep = new LLVolume(params, detail);
+		volumep->sculptResizeMesh(header.mSculptSizeS, header.mSculptSizeT);
+		ok = volumep->mMesh.size() == header.mNumMeshPoints &&
+			(U32)volumep->getNumFaces() == header.mNumFaces &&
+			read_elements(fp, volumep->mMesh, header.mNumMeshPoints);
+	}
+	if (ok)
+	{
+		volumep->mVolumeFaces.resize(header.mNumFaces);
+		for (U32 i = 0; ok && i < header.mNumFaces; ++i)
+		{
+			LLVolumeFace& face = volumep->mVolumeFaces[i];
+			LLVolumeCacheFileFace file_face;
+			ok = fread(&file_face, sizeof(file_face), 1, fp) == 1 &&
+				read_elements(fp, face.mVertices, file_face.mNumVertices) &&
+				read_elements(fp, face.mIndices, file_face.mNumIndices) &&
+				read_elements(fp, face.mTriStrip, file_face.mNumTriStrip) &&
+				read_elements(fp, face.mEdge, file_face.mNumEdge);
+			if (ok)
+			{
+				face.mID = file_face.mID;
+				face.mTypeMask = file_face.mTypeMask;
+				face.mCenter.setVec(file_face.mCenter);
+				face.mHasBinormals = file_face.mHasBinormals;
+				face.mBeginS = file_face.mBeginS;
+				face.mBeginT = file_face.mBeginT;
+				face.mNumS = file_face.mNumS;
+				face.mNumT = file_face.mNumT;
+				face.mExtents[0].setVec(file_face.mExtents);
+				face.mExtents[1].setVec(file_face.mExtents + 3);
+			}
+		}
+		// Nothing may follow the last face
+		ok = ok && fgetc(fp) == EOF && isValidVolume(volumep);
+	}
+	fclose(fp);
+
+	if (!ok)
+	{
+		llwarns << "Removing bad volume cache file " << filename << llendl;
+		LLFile::remove(filename);
+		return NULL;
+	}
+
+	volumep->mFaceMask = header.mFaceMask;
+	volumep->mLODScaleBias.setVec(header.mLODScaleBias);
+	volumep->mSculptLevel = header.mSculptLevel;
+	return volumep;
+}
+
+//static
+bool LLVolumeCache::isValidVolume(const LLVolume* volumep)
+{
+	for (S32 f = 0; f < (S32)volumep->mVolumeFaces.size(); ++f)
+	{
+		const LLVolumeFace& face = volumep->mVolumeFaces[f];
+		const U32 num_vertices = face.mVertices.size();
+		const U32 num_indices = face.mIndices.size();
+		if (face.mID != f || num_indices % 3 ||
+			face.mNumS < 0 || face.mNumT < 0 || face.mBeginS < 0 || face.mBeginT < 0)
+		{
+			return false;
+		}
+		// Sides are a grid of mNumS by mNumT vertices, caps aren't
+		if ((face.mTypeMask & LLVolumeFace::SIDE_MASK) &&
+			(U64)face.mNumS * (U64)face.mNumT > num_vertices)
+		{
+			return false;
+		}
+		for (U32 i = 0; i < num_indices; ++i)
+		{
+			if (face.mIndices[i] >= num_vertices)
+			{
+				return false;
+			}
+		}
+		for (U32 i = 0; i < face.mTriStrip.size(); ++i)
+		{
+			if (face.mTriStrip[i] >= num_vertices)
+			{
+				return false;
+			}
+		}
+		// Neighbor triangle of each triangle edge, or -1
+		if (!face.mEdge.empty())
+		{
+			const S32 num_triangles = (S32)(num_indices / 3);
+			if (face.mEdge.size() != num_indices)
+			{
+				return false;
+			}
+			for (U32 i = 0; i < num_indices; ++i)
+			{
+				if (face.mEdge[i] < -1 || face.mEdge[i] >= num_triangles)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
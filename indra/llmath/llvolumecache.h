@@ -0,0 +1,151 @@
+/**
+ * @file llvolumecache.h
+ * @brief LLVolumeCache class.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMECACHE_H
+#define LL_LLVOLUMECACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "llpointer.h"
+#include "lluuid.h"
+#include "llvolume.h"
+
+// Keeps the geometry of volumes nobody references any more, so building the
+// same parameters and detail again costs nothing.  Volumes are looked up by
+// a digest of their parameters and detail; for sculpts the parameters
+// include the sculpt texture, and the volume remembers the discard level it
+// was sculpted at.  The least recently retained volumes go first once the
+// cache holds more than its maximum number of bytes.
+//
+// Sculpt geometry can also be persisted in a cache directory, since it
+// can't be built before the sculpt texture is downloaded.  Files go in a
+// fixed number of slots picked by the digest, which bounds the space on
+// disk; a file whose digest doesn't match is treated as a miss.  The cache
+// itself does no file I/O: retainVolume() queues the files to write for
+// popFileWrite(), and getFileRead() says which file may hold a volume.
+// LLVolumeMgr does the I/O with the static functions below, on its build
+// thread when it has one.
+//
+// Not thread safe, LLVolumeMgr calls it with its data locked.  The static
+// file functions can be called from any thread.
+class LLVolumeCache
+{
+public:
+	LLVolumeCache(U32 max_bytes);
+	~LLVolumeCache();
+
+	// Persists sculpts in dir, in at most max_files files.  An empty dir or
+	// zero max_files keeps everything in memory.
+	void setCacheDir(const std::string& dir, U32 max_files);
+	void setMaxBytes(U32 max_bytes);
+
+	// Keeps volumep once its last LOD group reference is gone.  Unique
+	// volumes and sculpts without sculpt data are not kept.  Sculpts are
+	// queued for writing unless their slot is known to hold them already,
+	// as good or better.
+	void retainVolume(LLVolume* volumep);
+	// Hands back a volume kept in memory for params at detail (a volume
+	// scale, see LLVolumeLODGroup::getVolumeScaleFromDetail()), or NULL.
+	// The volume leaves the cache.
+	LLPointer<LLVolume> findVolume(const LLVolumeParams& params, F32 detail);
+
+	// Takes the oldest queued file write.  Returns false if there is none.
+	bool popFileWrite(std::string& filename, std::string& data);
+	// True if a persisted sculpt for params at detail may be in filename,
+	// to be read with readVolumeFile(filename, digest, ...).
+	bool getFileRead(const LLVolumeParams& params, F32 detail, std::string& filename, LLUUID& digest);
+	// Records what reading the file for digest gave: the sculpt level of the
+	// volume read, or -2 if there was none
+	void setFileRead(const LLUUID& digest, S32 sculpt_level);
+
+	// Writes data through a temporary file, so that a reader never sees
+	// half of it.  Keeps the file instead if it holds the same volume at
+	// the same or a better sculpt level.
+	static bool writeVolumeFile(const std::string& filename, const std::string& data);
+	// The volume in filename if it is the one for digest, params and detail.
+	// A file that fails its checks, such as a face index out of range, is
+	// deleted.
+	static LLPointer<LLVolume> readVolumeFile(const std::string& filename, const LLUUID& digest,
+											  const LLVolumeParams& params, F32 detail);
+
+	// Drops the volumes kept in memory, the files stay
+	void clear();
+
+	U32 getBytes() const { return mBytes; }
+	S32 getNumVolumes() const { return (S32)mEntries.size(); }
+	U32 getHits() const { return mHits; }
+	U32 getMisses() const { return mMisses; }
+	U32 getFileHits() const { return mFileHits; }
+
+	// Memory used by the geometry of volumep
+	static U32 getVolumeBytes(const LLVolume* volumep);
+	static LLUUID getDigest(const LLVolumeParams& params, F32 detail);
+
+private:
+	static bool isCacheable(const LLVolume* volumep);
+	void evict(U32 max_bytes);
+
+	U32 getSlot(const LLUUID& digest) const;
+	std::string getFilename(const LLUUID& digest) const;
+	// Queues volumep for writing unless its slot already has it at the same
+	// or a better sculpt level
+	void queueFileWrite(const LLUUID& digest, const LLVolume* volumep);
+	static void serializeVolume(const LLUUID& digest, const LLVolume* volumep, std::string& data);
+	// Checks what readVolumeFile() read before anything uses it
+	static bool isValidVolume(const LLVolume* volumep);
+
+	typedef std::list<LLUUID> lru_list_t;
+	struct Entry
+	{
+		LLPointer<LLVolume> mVolume;
+		U32 mBytes;
+		lru_list_t::iterator mLRU;
+	};
+	typedef std::map<LLUUID, Entry> entry_map_t;
+	entry_map_t mEntries;
+	lru_list_t mLRU;	// oldest first
+
+	U32 mBytes;
+	U32 mMaxBytes;
+
+	std::string mCacheDir;
+	U32 mMaxFiles;
+	// What this session wrote or read in each slot: digest and sculpt
+	// level, a negative level if the slot doesn't hold that digest
+	typedef std::map<U32, std::pair<LLUUID, S32> > slot_map_t;
+	slot_map_t mSlots;
+	// Filename and contents
+	typedef std::list<std::pair<std::string, std::string> > write_list_t;
+	write_list_t mFileWrites;
+
+	U32 mHits;
+	U32 mMisses;
+	U32 mFileHits;
+};
+
+#endif // LL_LLVOLUMECACHE_H
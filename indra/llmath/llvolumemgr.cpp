@@ -45,7 +45,9 @@ F32 LLVolumeLODGroup::mDetailScales[NUM_LODS] = {1.f, 1.5f, 2.5f, 4.f};
 //============================================================================
 
 LLVolumeMgr::LLVolumeMgr()
-:	mDataMutex(NULL)
+:	mDataMutex(NULL),
+	mCache(NULL),
+	mBuildThread(NULL)
 {
 	// the LLMutex magic interferes with easy unit testing,
 	// so you now must manually call useMutex() to use it
@@ -56,12 +58,16 @@ LLVolumeMgr::~LLVolumeMgr()
 {
 	cleanup();
 
+	delete mCache;
+	mCache = NULL;
 	delete mDataMutex;
 	mDataMutex = NULL;
 }
 
 BOOL LLVolumeMgr::cleanup()
 {
+	stopBuildThread();
+
 	BOOL no_refs = TRUE;
 	if (mDataMutex)
 	{
@@ -79,6 +85,10 @@ BOOL LLVolumeMgr::cleanup()
  		delete volgroupp;
 	}
 	mVolumeLODGroups.clear();
+	if (mCache)
+	{
+		mCache->clear();
+	}
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
@@ -106,11 +116,129 @@ LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32
 	{
 		volgroupp = iter->second;
 	}
+	useCachedLOD(volgroupp, detail);
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+	LLVolume* volumep = volgroupp->refLOD(detail);
+	if (mBuildThread && mCache && volumep->getSculptLevel() == -2 && !isSculptPending(volumep))
+	{
+		// A new sculpt, its geometry may be on disk from another session
+		requestCacheRead(volumep);
+	}
+	return volumep;
+}
+
+// protected, with the data locked
+void LLVolumeMgr::useCachedLOD(LLVolumeLODGroup* volgroupp, const S32 detail)
+{
+	if (mCache && !volgroupp->isLODBuilt(detail))
+	{
+		LLPointer<LLVolume> volumep = mCache->findVolume(*volgroupp->getVolumeParams(),
+														 LLVolumeLODGroup::getVolumeScaleFromDetail(detail));
+		if (volumep.notNull())
+		{
+			volgroupp->setLOD(detail, volumep);
+		}
+	}
+}
+
+// protected
+void LLVolumeMgr::requestCacheRead(LLVolume* volumep)
+{
+	std::string filename;
+	LLUUID digest;
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	bool found = mCache->getFileRead(volumep->getParams(), volumep->getDetail(), filename, digest);
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+	if (found)
+	{
+		LLVolumeBuildThread::handle_t handle = mBuildThread->readCacheFile(filename, digest, volumep->getParams(),
+																		   volumep->getDetail(),
+																		   LLQueuedThread::PRIORITY_HIGH);
+		mPendingBuilds.insert(std::make_pair(handle, PendingBuild(volumep, digest)));
+		mSculptBuilds[volumep] = handle;
+	}
+}
+
+// protected
+BOOL LLVolumeMgr::readCachedSculpt(LLVolume* volumep, S32 sculpt_level)
+{
+	std::string filename;
+	LLUUID digest;
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	bool found = mCache && mCache->getFileRead(volumep->getParams(), volumep->getDetail(), filename, digest);
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+	if (!found)
+	{
+		return FALSE;
+	}
+
+	LLPointer<LLVolume> cached = LLVolumeCache::readVolumeFile(filename, digest, volumep->getParams(),
+															   volumep->getDetail());
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	mCache->setFileRead(digest, cached.notNull() ? cached->getSculptLevel() : -2);
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
 	}
-	return volgroupp->refLOD(detail);
+	if (cached.isNull() || cached->getSculptLevel() > sculpt_level)
+	{
+		return FALSE;
+	}
+	volumep->swapGeometry(*cached);
+	return TRUE;
+}
+
+// protected, MAIN thread
+void LLVolumeMgr::writeCacheFiles()
+{
+	if (!mCache)
+	{
+		return;
+	}
+	std::string filename;
+	std::string data;
+	while (true)
+	{
+		if (mDataMutex)
+		{
+			mDataMutex->lock();
+		}
+		bool found = mCache->popFileWrite(filename, data);
+		if (mDataMutex)
+		{
+			mDataMutex->unlock();
+		}
+		if (!found)
+		{
+			break;
+		}
+		if (mBuildThread)
+		{
+			mBuildThread->writeCacheFile(filename, data, LLQueuedThread::PRIORITY_LOW);
+		}
+		else
+		{
+			LLVolumeCache::writeVolumeFile(filename, data);
+		}
+	}
 }
 
 // virtual
@@ -159,7 +287,14 @@ void LLVolumeMgr::unrefVolume(LLVolume *volumep)
 	{
 		LLVolumeLODGroup* volgroupp = iter->second;
 
+		// The group may hold the last pointer to the volume
+		LLPointer<LLVolume> releasedp = volumep;
 		volgroupp->derefLOD(volumep);
+		if (mCache && !volgroupp->hasLOD(volumep))
+		{
+			// That was the last reference from the group
+			mCache->retainVolume(volumep);
+		}
 		if (volgroupp->getNumRefs() == 0)
 		{
 			mVolumeLODGroups.erase(params);
@@ -220,6 +355,237 @@ void LLVolumeMgr::useMutex()
 	}
 }
 
+void LLVolumeMgr::enableCache(U32 max_bytes, const std::string& dir, U32 max_files)
+{
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	if (!mCache)
+	{
+		mCache = new LLVolumeCache(max_bytes);
+	}
+	mCache->setMaxBytes(max_bytes);
+	mCache->setCacheDir(dir, max_files);
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+}
+
+void LLVolumeMgr::startBuildThread(bool threaded, U32 num_workers)
+{
+	if (!mBuildThread)
+	{
+		mBuildThread = new LLVolumeBuildThread(threaded, num_workers);
+	}
+}
+
+void LLVolumeMgr::stopBuildThread()
+{
+	if (mBuildThread)
+	{
+		// Deletes the requests, and with them the volumes they built
+		mBuildThread->shutdown();
+		delete mBuildThread;
+		mBuildThread = NULL;
+	}
+	for (pending_build_map_t::iterator iter = mPendingBuilds.begin();
+		 iter != mPendingBuilds.end(); ++iter)
+	{
+		swapInBuild(iter->first, iter->second, NULL);
+	}
+	mPendingBuilds.clear();
+	mSculptBuilds.clear();
+}
+
+BOOL LLVolumeMgr::requestVolume(const LLVolumeParams& volume_params, const S32 detail, U32 priority)
+{
+	if (!mBuildThread ||
+		volume_params.getSculptID().notNull() || volume_params.getSculptType() != LL_SCULPT_TYPE_NONE)
+	{
+		// LLVolume() leaves sculpts to LLVolume::sculpt(), see requestSculpt()
+		return TRUE;
+	}
+
+	BOOL built = FALSE;
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
+	if (iter != mVolumeLODGroups.end())
+	{
+		LLVolumeLODGroup* volgroupp = iter->second;
+		useCachedLOD(volgroupp, detail);
+		built = volgroupp->isLODBuilt(detail);
+		if (!built && !volgroupp->isBuildPending(detail))
+		{
+			F32 volume_detail = LLVolumeLODGroup::getVolumeScaleFromDetail(detail);
+			LLVolumeBuildThread::handle_t handle = mBuildThread->buildVolume(volume_params, volume_detail, priority);
+			mPendingBuilds.insert(std::make_pair(handle, PendingBuild(volume_params, detail)));
+			volgroupp->setBuildPending(detail, TRUE);
+		}
+	}
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+	return built;
+}
+
+void LLVolumeMgr::requestSculpt(LLVolume* volumep, U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+								const U8* sculpt_data, S32 sculpt_level, U32 priority)
+{
+	if (!mBuildThread)
+	{
+		if (!sculpt_data || sculpt_level < 0 || !readCachedSculpt(volumep, sculpt_level))
+		{
+			volumep->sculpt(sculpt_width, sculpt_height, sculpt_components, sculpt_data, sculpt_level);
+		}
+		return;
+	}
+
+	sculpt_build_map_t::iterator iter = mSculptBuilds.find(volumep);
+	if (iter != mSculptBuilds.end())
+	{
+		pending_build_map_t::iterator build_iter = mPendingBuilds.find(iter->second);
+		if (build_iter != mPendingBuilds.end() && build_iter->second.mSculptLevel == sculpt_level)
+		{
+			// Already on its way
+			return;
+		}
+		// Superseded, skip it if it hasn't started yet
+		mBuildThread->abortRequest(iter->second, false);
+	}
+
+	LLVolumeBuildThread::handle_t handle = mBuildThread->sculptVolume(volumep->getParams(), volumep->getDetail(),
+																	  sculpt_width, sculpt_height, sculpt_components,
+																	  sculpt_data, sculpt_level, priority);
+	mPendingBuilds.insert(std::make_pair(handle, PendingBuild(volumep, sculpt_level)));
+	mSculptBuilds[volumep] = handle;
+}
+
+BOOL LLVolumeMgr::isSculptPending(const LLVolume* volumep) const
+{
+	return mSculptBuilds.find(volumep) != mSculptBuilds.end();
+}
+
+BOOL LLVolumeMgr::isCacheReadPending(const LLVolume* volumep) const
+{
+	sculpt_build_map_t::const_iterator iter = mSculptBuilds.find(volumep);
+	if (iter == mSculptBuilds.end())
+	{
+		return FALSE;
+	}
+	pending_build_map_t::const_iterator build_iter = mPendingBuilds.find(iter->second);
+	return build_iter != mPendingBuilds.end() && build_iter->second.mCacheDigest.notNull();
+}
+
+S32 LLVolumeMgr::updateBuilds()
+{
+	writeCacheFiles();
+
+	if (!mBuildThread)
+	{
+		return 0;
+	}
+
+	mBuildThread->update(0); // does the work here when not threaded
+
+	std::vector<LLVolumeBuildThread::handle_t> handles;
+	mBuildThread->getFinishedRequests(handles);
+	for (std::vector<LLVolumeBuildThread::handle_t>::iterator iter = handles.begin();
+		 iter != handles.end(); ++iter)
+	{
+		LLVolumeBuildThread::handle_t handle = *iter;
+		pending_build_map_t::iterator build_iter = mPendingBuilds.find(handle);
+		if (build_iter != mPendingBuilds.end())
+		{
+			LLVolumeBuildThread::BuildRequest* req = (LLVolumeBuildThread::BuildRequest*)mBuildThread->getRequest(handle);
+			LLVolume* volumep = NULL;
+			if (req && req->getStatus() == LLQueuedThread::STATUS_COMPLETE)
+			{
+				volumep = req->getVolume();
+			}
+			swapInBuild(handle, build_iter->second, volumep);
+			mPendingBuilds.erase(build_iter);
+		}
+		mBuildThread->completeRequest(handle);
+	}
+	return (S32)handles.size();
+}
+
+// protected
+// Gives volumep (NULL if the request was aborted) to whatever build asked
+// for it.  Returns TRUE if it was used.
+BOOL LLVolumeMgr::swapInBuild(LLVolumeBuildThread::handle_t handle, const PendingBuild& build, LLVolume* volumep)
+{
+	BOOL used = FALSE;
+	if (build.mSculptTarget.notNull())
+	{
+		sculpt_build_map_t::iterator iter = mSculptBuilds.find(build.mSculptTarget);
+		if (iter == mSculptBuilds.end() || iter->second != handle)
+		{
+			// Superseded by a later request
+			return FALSE;
+		}
+		mSculptBuilds.erase(iter);
+
+		BOOL wanted;
+		if (build.mCacheDigest.notNull())
+		{
+			if (mDataMutex)
+			{
+				mDataMutex->lock();
+			}
+			if (mCache)
+			{
+				mCache->setFileRead(build.mCacheDigest, volumep ? volumep->getSculptLevel() : -2);
+			}
+			if (mDataMutex)
+			{
+				mDataMutex->unlock();
+			}
+			// Still without sculpt data
+			wanted = build.mSculptTarget->getSculptLevel() < 0;
+		}
+		else
+		{
+			wanted = build.mSculptTarget->getSculptLevel() != build.mSculptLevel;
+		}
+
+		// Nobody else holds the target any more, or it got there itself
+		if (volumep && build.mSculptTarget->getNumRefs() > 1 && wanted)
+		{
+			build.mSculptTarget->swapGeometry(*volumep);
+			used = TRUE;
+		}
+		return used;
+	}
+
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&build.mParams);
+	if (iter != mVolumeLODGroups.end())
+	{
+		// The group may have been freed and made again since, which is harmless
+		LLVolumeLODGroup* volgroupp = iter->second;
+		volgroupp->setBuildPending(build.mDetail, FALSE);
+		if (volumep)
+		{
+			used = volgroupp->setLOD(build.mDetail, volumep);
+		}
+	}
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+	return used;
+}
+
 std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 {
 	s << "{ numLODgroups=" << volume_mgr.mVolumeLODGroups.size() << ", ";
@@ -255,6 +621,7 @@ LLVolumeLODGroup::LLVolumeLODGroup(const LLVolumeParams &params)
 	{
 		mLODRefs[i] = 0;
 		mAccessCount[i] = 0;
+		mBuildPending[i] = FALSE;
 	}
 }
 
@@ -304,6 +671,29 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 detail)
 	return mVolumeLODs[detail];
 }
 
+BOOL LLVolumeLODGroup::setLOD(const S32 detail, LLVolume* volumep)
+{
+	llassert(detail >=0 && detail < NUM_LODS);
+	if (mVolumeLODs[detail].notNull())
+	{
+		return FALSE;
+	}
+	mVolumeLODs[detail] = volumep;
+	return TRUE;
+}
+
+BOOL LLVolumeLODGroup::hasLOD(const LLVolume* volumep) const
+{
+	for (S32 i = 0; i < NUM_LODS; i++)
+	{
+		if (mVolumeLODs[i] == volumep)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 BOOL LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 {
 	llassert_always(mRefs > 0);
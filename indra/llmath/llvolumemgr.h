@@ -30,6 +30,8 @@
 #include <map>
 
 #include "llvolume.h"
+#include "llvolumebuildthread.h"
+#include "llvolumecache.h"
 #include "llpointer.h"
 #include "llthread.h"
 
@@ -57,6 +59,16 @@ public:
 	LLVolume* refLOD(const S32 detail);
 	BOOL derefLOD(LLVolume *volumep);
 	S32 getNumRefs() const { return mRefs; }
+
+	// A LOD is built once refLOD() made it or LLVolumeMgr handed it in
+	// from the build thread, referenced or not.
+	BOOL isLODBuilt(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
+	BOOL isBuildPending(const S32 detail) const { return mBuildPending[detail]; }
+	void setBuildPending(const S32 detail, BOOL pending) { mBuildPending[detail] = pending; }
+	// Takes volumep for detail unless refLOD() got there first.
+	// Returns TRUE if volumep was taken.
+	BOOL setLOD(const S32 detail, LLVolume* volumep);
+	BOOL hasLOD(const LLVolume* volumep) const;
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
 
@@ -72,6 +84,7 @@ protected:
 	static F32 mDetailThresholds[NUM_LODS];
 	static F32 mDetailScales[NUM_LODS];
 	S32		mAccessCount[NUM_LODS];
+	BOOL	mBuildPending[NUM_LODS];
 };
 
 class LLVolumeMgr
@@ -94,6 +107,39 @@ public:
 	// manually call this for mutex magic
 	void useMutex();
 
+	// Keeps up to max_bytes of geometry nothing references any more, and
+	// persists sculpts in up to max_files files in dir (none if dir is empty)
+	void enableCache(U32 max_bytes, const std::string& dir, U32 max_files);
+	LLVolumeCache* getCache() const { return mCache; }
+
+	// Asynchronous building.  refVolume() still builds a missing LOD on the
+	// spot; callers that can keep using another LOD meanwhile ask
+	// requestVolume() first.  All of these are for the MAIN thread.
+	void startBuildThread(bool threaded, U32 num_workers);
+	void stopBuildThread();
+	LLVolumeBuildThread* getBuildThread() const { return mBuildThread; }
+
+	// TRUE if refVolume(volume_params, detail) has nothing to build, which
+	// is always the case without a build thread and for sculpts.  Otherwise
+	// queues the build if something already references volume_params.
+	BOOL requestVolume(const LLVolumeParams& volume_params, const S32 detail, U32 priority);
+	// Like volumep->sculpt(), but on the build thread if there is one.  The
+	// sculpt data is copied, and volumep gets the new geometry in
+	// updateBuilds() unless another request for it came in meanwhile.
+	// Without a build thread, a cache file as good as sculpt_level is
+	// used instead.
+	void requestSculpt(LLVolume* volumep, U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
+					   const U8* sculpt_data, S32 sculpt_level, U32 priority);
+	BOOL isSculptPending(const LLVolume* volumep) const;
+	// TRUE while the build thread reads the cache file for a sculpt that
+	// refVolume() handed out without geometry.  requestSculpt() cancels it.
+	BOOL isCacheReadPending(const LLVolume* volumep) const;
+	// Hands the finished builds to their LOD groups and volumes, and writes
+	// the cache files queued since the last call, on the build thread if
+	// there is one.  Returns the number of requests that finished, used or
+	// not.
+	S32 updateBuilds();
+
 	friend std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr);
 
 protected:
@@ -106,6 +152,45 @@ protected:
 	volume_lod_group_map_t mVolumeLODGroups;
 
 	LLMutex* mDataMutex;
+	LLVolumeCache* mCache;
+
+	// Gives volgroupp the cached volume for detail if it has no volume there
+	void useCachedLOD(LLVolumeLODGroup* volgroupp, const S32 detail);
+	// Queues reading the cache file that may hold the geometry of volumep
+	void requestCacheRead(LLVolume* volumep);
+	// Gives volumep the geometry of its cache file if that is as good as
+	// sculpt_level.  Reads the file on the spot.
+	BOOL readCachedSculpt(LLVolume* volumep, S32 sculpt_level);
+	void writeCacheFiles();
+
+	// A queued LLVolumeBuildThread request: a LOD of the group for mParams,
+	// or new geometry for mSculptTarget, sculpted or read from the cache
+	// file for mCacheDigest
+	struct PendingBuild
+	{
+		PendingBuild(const LLVolumeParams& params, S32 detail)
+			: mParams(params), mDetail(detail), mSculptLevel(-2) {}
+		PendingBuild(LLVolume* sculpt_target, S32 sculpt_level)
+			: mParams(sculpt_target->getParams()), mDetail(-1),
+			  mSculptTarget(sculpt_target), mSculptLevel(sculpt_level) {}
+		PendingBuild(LLVolume* sculpt_target, const LLUUID& cache_digest)
+			: mParams(sculpt_target->getParams()), mDetail(-1),
+			  mSculptTarget(sculpt_target), mSculptLevel(-2), mCacheDigest(cache_digest) {}
+
+		LLVolumeParams mParams;
+		S32 mDetail;
+		LLPointer<LLVolume> mSculptTarget;
+		S32 mSculptLevel;
+		LLUUID mCacheDigest;
+	};
+	BOOL swapInBuild(LLVolumeBuildThread::handle_t handle, const PendingBuild& build, LLVolume* volumep);
+
+	LLVolumeBuildThread* mBuildThread;
+	typedef std::map<LLVolumeBuildThread::handle_t, PendingBuild> pending_build_map_t;
+	pending_build_map_t mPendingBuilds;
+	// The latest sculpt request for each volume
+	typedef std::map<const LLVolume*, LLVolumeBuildThread::handle_t> sculpt_build_map_t;
+	sculpt_build_map_t mSculptBuilds;
 };
 
 #endif // LL_LLVOLUMEMGR_H
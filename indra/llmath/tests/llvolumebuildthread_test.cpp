@@ -0,0 +1,271 @@
+/**
+ * @file llvolumebuildthread_test.cpp
+ * @brief Tests for building volumes through LLVolumeMgr and LLVolumeBuildThread
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llvolumemgr.h"
+#include "../llvolumebuildthread.h"
+#include "llfile.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	LLVolumeParams make_params(U8 profile, U8 path)
+	{
+		LLVolumeParams params;
+		params.setType(profile, path);
+		params.setBeginAndEndS(0.f, 1.f);
+		params.setBeginAndEndT(0.f, 1.f);
+		params.setRatio(1.f);
+		params.setShear(0.f);
+		return params;
+	}
+
+	void ensure_same_geometry(const std::string& msg, const LLVolume* a, const LLVolume* b)
+	{
+		tut::ensure_equals(msg + " faces", a->getNumVolumeFaces(), b->getNumVolumeFaces());
+		tut::ensure_equals(msg + " mesh", a->getMesh().size(), b->getMesh().size());
+		for (S32 i = 0; i < a->getNumVolumeFaces(); ++i)
+		{
+			tut::ensure_equals(msg + " vertices", a->getVolumeFace(i).mVertices.size(),
+							   b->getVolumeFace(i).mVertices.size());
+		}
+	}
+}
+
+namespace tut
+{
+	struct volumebuildthread_test
+	{
+		volumebuildthread_test()
+			: mBox(make_params(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE)),
+			  mTorus(make_params(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE))
+		{
+		}
+
+		LLVolumeParams mBox;
+		LLVolumeParams mTorus;
+	};
+	typedef test_group<volumebuildthread_test> volumebuildthread_group_t;
+	typedef volumebuildthread_group_t::object volumebuildthread_object_t;
+	tut::volumebuildthread_group_t volumebuildthread_instance("LLVolumeBuildThread");
+
+	template<> template<>
+	void volumebuildthread_object_t::test<1>()
+	{
+		// without a build thread everything is built on the spot
+		LLVolumeMgr mgr;
+		ensure("no thread", mgr.requestVolume(mTorus, 3, LLQueuedThread::PRIORITY_NORMAL));
+		ensure_equals("no builds", mgr.updateBuilds(), 0);
+	}
+
+	template<> template<>
+	void volumebuildthread_object_t::test<2>()
+	{
+		// a LOD is only queued once something references the parameters
+		LLVolumeMgr mgr;
+		mgr.startBuildThread(false, 1);
+		ensure("unreferenced", !mgr.requestVolume(mTorus, 3, LLQueuedThread::PRIORITY_NORMAL));
+		ensure_equals("not queued", mgr.getBuildThread()->getPending(), 0);
+
+		LLVolume* low = mgr.refVolume(mTorus, 0);
+		ensure("low built", mgr.requestVolume(mTorus, 0, LLQueuedThread::PRIORITY_NORMAL));
+		ensure("high queued", !mgr.requestVolume(mTorus, 3, LLQueuedThread::PRIORITY_NORMAL));
+		ensure("still queued", !mgr.requestVolume(mTorus, 3, LLQueuedThread::PRIORITY_NORMAL));
+		ensure_equals("queued once", mgr.getBuildThread()->getPending(), 1);
+
+		ensure_equals("finished", mgr.updateBuilds(), 1);
+		ensure("high built", mgr.requestVolume(mTorus, 3, LLQueuedThread::PRIORITY_NORMAL));
+
+		// refVolume() hands out the built LOD, the same as one built on the spot
+		LLVolume* high = mgr.refVolume(mTorus, 3);
+		ensure_equals("detail", high->getDetail(), LLVolumeLODGroup::getVolumeScaleFromDetail(3));
+		LLPointer<LLVolume> expected = new LLVolume(mTorus, LLVolumeLODGroup::getVolumeScaleFromDetail(3));
+		ensure_same_geometry("high", high, expected);
+
+		mgr.unrefVolume(high);
+		mgr.unrefVolume(low);
+		ensure("no refs", mgr.cleanup());
+	}
+
+	template<> template<>
+	void volumebuildthread_object_t::test<3>()
+	{
+		// sculpts are built into a copy and swapped into the shared volume
+		LLVolumeMgr mgr;
+		mgr.startBuildThread(false, 1);
+		LLVolumeParams params(mBox);
+		params.setSculptID(LLUUID::generateNewID(), LL_SCULPT_TYPE_SPHERE);
+		ensure("sculpts build on the spot", mgr.requestVolume(params, 2, LLQueuedThread::PRIORITY_NORMAL));
+
+		LLVolume* volume = mgr.refVolume(params, 2);
+		ensure_equals("not sculpted", volume->getSculptLevel(), -2);
+
+		const U16 size = 16;
+		std::vector<U8> data(size * size * 3);
+		for (U32 i = 0; i < data.size(); ++i)
+		{
+			data[i] = (U8)(i * 7);
+		}
+		mgr.requestSculpt(volume, size, size, 3, &data[0], 0, LLQueuedThread::PRIORITY_NORMAL);
+		mgr.requestSculpt(volume, size, size, 3, &data[0], 0, LLQueuedThread::PRIORITY_NORMAL);
+		ensure("pending", mgr.isSculptPending(volume));
+		ensure_equals("queued once", mgr.getBuildThread()->getPending(), 1);
+		ensure_equals("untouched", volume->getSculptLevel(), -2);
+
+		// the sculpt data is copied
+		std::vector<U8> copy(data);
+		data.assign(data.size(), 0);
+
+		ensure_equals("finished", mgr.updateBuilds(), 1);
+		ensure("done", !mgr.isSculptPending(volume));
+		ensure_equals("sculpted", volume->getSculptLevel(), 0);
+
+		LLPointer<LLVolume> expected = new LLVolume(params, volume->getDetail());
+		expected->sculpt(size, size, 3, &copy[0], 0);
+		ensure_same_geometry("sculpt", volume, expected);
+		for (U32 i = 0; i < volume->getMesh().size(); ++i)
+		{
+			ensure("mesh point", volume->getMeshPt(i) == expected->getMeshPt(i));
+		}
+
+		mgr.unrefVolume(volume);
+	}
+
+	template<> template<>
+	void volumebuildthread_object_t::test<4>()
+	{
+		// a newer sculpt request supersedes one that is still queued
+		LLVolumeMgr mgr;
+		mgr.startBuildThread(false, 1);
+		LLVolumeParams params(mBox);
+		params.setSculptID(LLUUID::generateNewID(), LL_SCULPT_TYPE_SPHERE);
+		LLVolume* volume = mgr.refVolume(params, 1);
+
+		std::vector<U8> data(8 * 8 * 3, 128);
+		mgr.requestSculpt(volume, 8, 8, 3, &data[0], 2, LLQueuedThread::PRIORITY_NORMAL);
+		mgr.requestSculpt(volume, 8, 8, 3, &data[0], 1, LLQueuedThread::PRIORITY_NORMAL);
+		mgr.updateBuilds();
+		ensure("done", !mgr.isSculptPending(volume));
+		ensure_equals("latest", volume->getSculptLevel(), 1);
+
+		mgr.unrefVolume(volume);
+	}
+
+	template<> template<>
+	void volumebuildthread_object_t::test<5>()
+	{
+		// several workers, results come back on the calling thread
+		LLVolumeMgr mgr;
+		mgr.useMutex();
+		mgr.startBuildThread(true, 3);
+
+		std::vector<LLVolumeParams> params;
+		std::vector<LLVolume*> low;
+		for (S32 i = 0; i < 8; ++i)
+		{
+			LLVolumeParams p(mTorus);
+			p.setHollow(0.1f * i);
+			params.push_back(p);
+			low.push_back(mgr.refVolume(p, 0));
+			mgr.requestVolume(p, 3, LLQueuedThread::PRIORITY_NORMAL);
+		}
+
+		LLTimer timer;
+		bool built = false;
+		while (!built && timer.getElapsedTimeF32() < 10.f)
+		{
+			mgr.updateBuilds();
+			built = true;
+			for (U32 i = 0; i < params.size(); ++i)
+			{
+				built = built && mgr.requestVolume(params[i], 3, LLQueuedThread::PRIORITY_NORMAL);
+			}
+			ms_sleep(1);
+		}
+		ensure("built", built);
+
+		for (U32 i = 0; i < params.size(); ++i)
+		{
+			LLVolume* high = mgr.refVolume(params[i], 3);
+			LLPointer<LLVolume> expected = new LLVolume(params[i], LLVolumeLODGroup::getVolumeScaleFromDetail(3));
+			ensure_same_geometry("high", high, expected);
+			mgr.unrefVolume(high);
+			mgr.unrefVolume(low[i]);
+		}
+		ensure("no refs", mgr.cleanup());
+	}
+
+	template<> template<>
+	void volumebuildthread_object_t::test<6>()
+	{
+		// the volume cache files are written and read on the build thread
+		std::string dir = std::string(LLFile::tmpdir()) + "llvolumebuildthread_test";
+		LLVolumeParams params(mBox);
+		params.setSculptID(LLUUID::generateNewID(), LL_SCULPT_TYPE_SPHERE);
+		std::vector<U8> data(8 * 8 * 3);
+		for (U32 i = 0; i < data.size(); ++i)
+		{
+			data[i] = (U8)(i * 7);
+		}
+		{
+			LLVolumeMgr mgr;
+			mgr.enableCache(0, dir, 1);
+			mgr.startBuildThread(false, 1);
+			LLVolume* volume = mgr.refVolume(params, 1);
+			ensure("reading", mgr.isCacheReadPending(volume));
+			mgr.updateBuilds();
+			ensure("no file yet", !mgr.isSculptPending(volume));
+			ensure_equals("not sculpted", volume->getSculptLevel(), -2);
+
+			mgr.requestSculpt(volume, 8, 8, 3, &data[0], 1, LLQueuedThread::PRIORITY_NORMAL);
+			mgr.updateBuilds();
+			ensure_equals("sculpted", volume->getSculptLevel(), 1);
+			mgr.unrefVolume(volume);
+			ensure_equals("written", mgr.updateBuilds(), 1);
+		}
+
+		LLVolumeMgr mgr;
+		mgr.enableCache(0, dir, 1);
+		mgr.startBuildThread(false, 1);
+		LLVolume* volume = mgr.refVolume(params, 1);
+		ensure("reading again", mgr.isCacheReadPending(volume));
+		mgr.updateBuilds();
+		ensure("read", !mgr.isSculptPending(volume));
+		ensure_equals("file hit", mgr.getCache()->getFileHits(), 1U);
+		ensure_equals("level", volume->getSculptLevel(), 1);
+
+		LLPointer<LLVolume> expected = new LLVolume(params, volume->getDetail());
+		expected->sculpt(8, 8, 3, &data[0], 1);
+		ensure_same_geometry("read", volume, expected);
+		mgr.unrefVolume(volume);
+
+		LLFile::remove(dir + "/0.vol");
+		LLFile::rmdir(dir);
+	}
+}
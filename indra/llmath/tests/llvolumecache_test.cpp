@@ -0,0 +1,310 @@
+/**
+ * @file llvolumecache_test.cpp
+ * @brief Tests for LLVolumeCache and its use by LLVolumeMgr
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llvolumecache.h"
+#include "../llvolumemgr.h"
+#include "llfile.h"
+#include "llformat.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	const U32 NUM_FILES = 4;
+
+	LLVolumeParams make_params(F32 hollow)
+	{
+		LLVolumeParams params;
+		params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+		params.setBeginAndEndS(0.f, 1.f);
+		params.setBeginAndEndT(0.f, 1.f);
+		params.setRatio(1.f);
+		params.setShear(0.f);
+		params.setHollow(hollow);
+		return params;
+	}
+
+	LLVolumeParams make_sculpt_params()
+	{
+		LLVolumeParams params = make_params(0.f);
+		params.setSculptID(LLUUID("8f1d3ac4-5a1b-4c36-9e7f-0b2a6d5c4e3f"), LL_SCULPT_TYPE_SPHERE);
+		return params;
+	}
+
+	LLPointer<LLVolume> make_sculpt(F32 detail, S32 level)
+	{
+		const U16 size = 32;
+		std::vector<U8> data(size * size * 3);
+		for (U32 i = 0; i < data.size(); ++i)
+		{
+			data[i] = (U8)((i * 13) ^ (i >> 5));
+		}
+		LLPointer<LLVolume> volumep = new LLVolume(make_sculpt_params(), detail);
+		volumep->sculpt(size, size, 3, &data[0], level);
+		return volumep;
+	}
+
+	std::string get_cache_dir()
+	{
+		return std::string(LLFile::tmpdir()) + "llvolumecache_test";
+	}
+
+	// What LLVolumeMgr does with the files, without a build thread
+	S32 write_files(LLVolumeCache& cache)
+	{
+		S32 count = 0;
+		std::string filename;
+		std::string data;
+		while (cache.popFileWrite(filename, data))
+		{
+			LLVolumeCache::writeVolumeFile(filename, data);
+			++count;
+		}
+		return count;
+	}
+
+	LLPointer<LLVolume> read_file(LLVolumeCache& cache, F32 detail)
+	{
+		std::string filename;
+		LLUUID digest;
+		if (!cache.getFileRead(make_sculpt_params(), detail, filename, digest))
+		{
+			return NULL;
+		}
+		LLPointer<LLVolume> volumep = LLVolumeCache::readVolumeFile(filename, digest, make_sculpt_params(), detail);
+		cache.setFileRead(digest, volumep.notNull() ? volumep->getSculptLevel() : -2);
+		return volumep;
+	}
+}
+
+namespace tut
+{
+	struct volumecache_test
+	{
+		~volumecache_test()
+		{
+			std::string dir = get_cache_dir();
+			for (U32 i = 0; i < NUM_FILES; ++i)
+			{
+				LLFile::remove(llformat("%s/%u.vol", dir.c_str(), i));
+			}
+			LLFile::rmdir(dir);
+		}
+	};
+	typedef test_group<volumecache_test> volumecache_group_t;
+	typedef volumecache_group_t::object volumecache_object_t;
+	tut::volumecache_group_t volumecache_instance("LLVolumeCache");
+
+	template<> template<>
+	void volumecache_object_t::test<1>()
+	{
+		// the digest covers the parameters and the detail
+		LLVolumeParams a = make_params(0.f);
+		LLVolumeParams b = make_params(0.5f);
+		ensure_equals("same", LLVolumeCache::getDigest(a, 1.f), LLVolumeCache::getDigest(make_params(0.f), 1.f));
+		ensure("params", LLVolumeCache::getDigest(a, 1.f) != LLVolumeCache::getDigest(b, 1.f));
+		ensure("detail", LLVolumeCache::getDigest(a, 1.f) != LLVolumeCache::getDigest(a, 2.5f));
+		ensure("sculpt", LLVolumeCache::getDigest(a, 1.f) != LLVolumeCache::getDigest(make_sculpt_params(), 1.f));
+	}
+
+	template<> template<>
+	void volumecache_object_t::test<2>()
+	{
+		// LLVolumeMgr hands back the same volume after its last user let go
+		LLVolumeMgr mgr;
+		mgr.enableCache(1 << 20, "", 0);
+		LLVolumeParams params = make_params(0.f);
+
+		LLPointer<LLVolume> first = mgr.refVolume(params, 2);
+		mgr.unrefVolume(first);
+		ensure_equals("kept", mgr.getCache()->getNumVolumes(), 1);
+		ensure_equals("bytes", mgr.getCache()->getBytes(), LLVolumeCache::getVolumeBytes(first));
+		ensure("no group", mgr.getGroup(params) == NULL);
+
+		LLVolume* second = mgr.refVolume(params, 2);
+		ensure("same volume", second == first.get());
+		ensure_equals("hit", mgr.getCache()->getHits(), 1U);
+		ensure_equals("taken", mgr.getCache()->getNumVolumes(), 0);
+		ensure_equals("no bytes", mgr.getCache()->getBytes(), 0U);
+
+		// other LODs are still built
+		LLVolume* other = mgr.refVolume(params, 1);
+		ensure("other detail", other != first.get());
+		ensure_equals("miss", mgr.getCache()->getMisses(), 2U);
+
+		mgr.unrefVolume(other);
+		mgr.unrefVolume(second);
+		ensure_equals("both kept", mgr.getCache()->getNumVolumes(), 2);
+		ensure("no refs", mgr.cleanup());
+		ensure_equals("cleared", mgr.getCache()->getNumVolumes(), 0);
+	}
+
+	template<> template<>
+	void volumecache_object_t::test<3>()
+	{
+		// the least recently kept volumes go first
+		std::vector<LLPointer<LLVolume> > volumes;
+		for (S32 i = 0; i < 4; ++i)
+		{
+			volumes.push_back(new LLVolume(make_params(0.1f * i), 2.5f));
+		}
+		U32 bytes = LLVolumeCache::getVolumeBytes(volumes[0]);
+		LLVolumeCache cache(bytes * 2 + bytes / 2);
+		for (S32 i = 0; i < 4; ++i)
+		{
+			cache.retainVolume(volumes[i]);
+		}
+		ensure("within budget", cache.getBytes() <= bytes * 2 + bytes / 2);
+		ensure("evicted", cache.getNumVolumes() < 4);
+		ensure("oldest gone", cache.findVolume(make_params(0.f), 2.5f).isNull());
+		ensure("newest kept", cache.findVolume(make_params(0.3f), 2.5f) == volumes[3]);
+
+		cache.setMaxBytes(0);
+		ensure_equals("emptied", cache.getNumVolumes(), 0);
+		ensure_equals("no bytes", cache.getBytes(), 0U);
+	}
+
+	template<> template<>
+	void volumecache_object_t::test<4>()
+	{
+		// sculpts are kept once they have sculpt data, the better one wins
+		LLVolumeCache cache(1 << 20);
+		LLPointer<LLVolume> unsculpted = new LLVolume(make_sculpt_params(), 2.5f);
+		cache.retainVolume(unsculpted);
+		ensure_equals("not sculpted", cache.getNumVolumes(), 0);
+
+		LLPointer<LLVolume> coarse = make_sculpt(2.5f, 2);
+		LLPointer<LLVolume> fine = make_sculpt(2.5f, 0);
+		cache.retainVolume(fine);
+		cache.retainVolume(coarse);
+		ensure_equals("one entry", cache.getNumVolumes(), 1);
+		ensure("better sculpt", cache.findVolume(make_sculpt_params(), 2.5f) == fine);
+	}
+
+	template<> template<>
+	void volumecache_object_t::test<5>()
+	{
+		// sculpt geometry comes back from disk in a new session
+		LLPointer<LLVolume> original = make_sculpt(4.f, 1);
+		{
+			LLVolumeCache cache(0);
+			cache.setCacheDir(get_cache_dir(), NUM_FILES);
+			cache.retainVolume(original);
+			ensure_equals("memory off", cache.getNumVolumes(), 0);
+			write_files(cache);
+		}
+
+		LLVolumeCache cache(1 << 20);
+		cache.setCacheDir(get_cache_dir(), NUM_FILES);
+		ensure("not in memory", cache.findVolume(make_sculpt_params(), 4.f).isNull());
+		ensure("other detail", read_file(cache, 2.5f).isNull());
+		LLPointer<LLVolume> loaded = read_file(cache, 4.f);
+		ensure("loaded", loaded.notNull());
+		ensure_equals("file hit", cache.getFileHits(), 1U);
+		ensure_equals("level", loaded->getSculptLevel(), 1);
+		ensure_equals("faces", loaded->getNumVolumeFaces(), original->getNumVolumeFaces());
+		ensure_equals("profile faces", loaded->getNumFaces(), original->getNumFaces());
+		ensure_equals("mesh", loaded->getMesh().size(), original->getMesh().size());
+		ensure_equals("face mask", loaded->mFaceMask, original->mFaceMask);
+		for (U32 i = 0; i < loaded->getMesh().size(); ++i)
+		{
+			ensure("mesh point", loaded->getMeshPt(i) == original->getMeshPt(i));
+		}
+		for (S32 f = 0; f < loaded->getNumVolumeFaces(); ++f)
+		{
+			const LLVolumeFace& a = loaded->getVolumeFace(f);
+			const LLVolumeFace& b = original->getVolumeFace(f);
+			ensure_equals("type", a.mTypeMask, b.mTypeMask);
+			ensure_equals("vertices", a.mVertices.size(), b.mVertices.size());
+			ensure("indices", a.mIndices == b.mIndices);
+			ensure("edges", a.mEdge == b.mEdge);
+			ensure("extents", a.mExtents[0] == b.mExtents[0] && a.mExtents[1] == b.mExtents[1]);
+			for (U32 i = 0; i < a.mVertices.size(); ++i)
+			{
+				ensure("position", a.mVertices[i].mPosition == b.mVertices[i].mPosition);
+				ensure("normal", a.mVertices[i].mNormal == b.mVertices[i].mNormal);
+				ensure("texcoord", a.mVertices[i].mTexCoord == b.mVertices[i].mTexCoord);
+			}
+		}
+
+		// a worse sculpt doesn't replace the file, whether the session read
+		// it or not
+		cache.retainVolume(make_sculpt(4.f, 3));
+		ensure_equals("not queued", write_files(cache), 0);
+		LLVolumeCache writer(0);
+		writer.setCacheDir(get_cache_dir(), NUM_FILES);
+		writer.retainVolume(make_sculpt(4.f, 3));
+		ensure_equals("queued", write_files(writer), 1);
+		LLVolumeCache reader(0);
+		reader.setCacheDir(get_cache_dir(), NUM_FILES);
+		LLPointer<LLVolume> reloaded = read_file(reader, 4.f);
+		ensure("reloaded", reloaded.notNull());
+		ensure_equals("kept the better file", reloaded->getSculptLevel(), 1);
+	}
+
+	template<> template<>
+	void volumecache_object_t::test<6>()
+	{
+		// a file with an index out of range is deleted, not used
+		LLPointer<LLVolume> original = make_sculpt(4.f, 1);
+		std::string filename;
+		std::string data;
+		{
+			LLVolumeCache cache(0);
+			cache.setCacheDir(get_cache_dir(), NUM_FILES);
+			cache.retainVolume(original);
+			ensure("queued", cache.popFileWrite(filename, data));
+		}
+
+		// the last index of the last face, which ends the file
+		const LLVolumeFace& face = original->getVolumeFace(original->getNumVolumeFaces() - 1);
+		ensure("has indices", !face.mIndices.empty());
+		U32 offset = data.size() - face.mEdge.size() * sizeof(S32) - face.mTriStrip.size() * sizeof(U16) -
+			sizeof(U16);
+		U16 index = (U16)face.mVertices.size();
+		memcpy(&data[offset], &index, sizeof(index));
+		ensure("written", LLVolumeCache::writeVolumeFile(filename, data));
+
+		LLVolumeCache cache(0);
+		cache.setCacheDir(get_cache_dir(), NUM_FILES);
+		ensure("rejected", read_file(cache, 4.f).isNull());
+		ensure_equals("no file hit", cache.getFileHits(), 0U);
+		ensure("deleted", !LLFile::isfile(filename));
+
+		// so is a truncated one
+		data.resize(data.size() / 2);
+		LLFILE* fp = LLFile::fopen(filename, "wb");
+		ensure("opened", fp != NULL);
+		fwrite(data.data(), 1, data.size(), fp);
+		fclose(fp);
+		LLVolumeCache other(0);
+		other.setCacheDir(get_cache_dir(), NUM_FILES);
+		ensure("truncated", read_file(other, 4.f).isNull());
+		ensure("deleted again", !LLFile::isfile(filename));
+	}
+}
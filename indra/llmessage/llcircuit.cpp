@@ -61,8 +61,6 @@ const S32 PING_START_BLOCK = 3;		// How many pings behind we have to be to consi
 const S32 PING_RELEASE_BLOCK = 2;	// How many pings behind we have to be to consider ourself unblocked.
 
 const F32 TARGET_PERIOD_LENGTH = 5.f;	// seconds
-const F32 LL_DUPLICATE_SUPPRESSION_TIMEOUT = 60.f; //seconds - this can be long, as time-based cleanup is
-													// only done when wrapping packetids, now...
 
 LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id, 
 							 const F32 circuit_heartbeat_interval, const F32 circuit_timeout)
@@ -85,6 +83,8 @@ LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id,
 	mLastPingID(0),
 	mPingDelay(INITIAL_PING_VALUE_MSEC), 
 	mPingDelayAveraged((F32)INITIAL_PING_VALUE_MSEC), 
+	mPotentialLostPackets(64, LL_MAX_RECEIVED_ID_SPAN),
+	mRecentlyReceivedReliablePackets(64, LL_MAX_RECEIVED_ID_SPAN),
 	mUnackedPacketCount(0),
 	mUnackedPacketBytes(0),
 	mLocalEndPointID(),
@@ -131,11 +131,15 @@ LLCircuitData::~LLCircuitData()
 
 	// remove all pending reliable messages on this circuit
 	std::vector<TPACKETID> doomed;
-	reliable_iter iter;
-	reliable_iter end = mUnackedPackets.end();
-	for(iter = mUnackedPackets.begin(); iter != end; ++iter)
+	TPACKETID id = mUnackedPackets.getFirstID();
+	for (U32 n = mUnackedPackets.getSpan(); n; --n, id = reliable_map::nextID(id))
 	{
-		packetp = iter->second;
+		LLReliablePacket** entry = mUnackedPackets.find(id);
+		if (!entry)
+		{
+			continue;
+		}
+		packetp = *entry;
 		gMessageSystem->mFailedResendPackets++;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -152,12 +156,18 @@ LLCircuitData::~LLCircuitData()
 
 		delete packetp;
 	}
+	mUnackedPackets.clear();
 
 	// remove all pending final retry reliable messages on this circuit
-	end = mFinalRetryPackets.end();
-	for(iter = mFinalRetryPackets.begin(); iter != end; ++iter)
+	id = mFinalRetryPackets.getFirstID();
+	for (U32 n = mFinalRetryPackets.getSpan(); n; --n, id = reliable_map::nextID(id))
 	{
-		packetp = iter->second;
+		LLReliablePacket** entry = mFinalRetryPackets.find(id);
+		if (!entry)
+		{
+			continue;
+		}
+		packetp = *entry;
 		gMessageSystem->mFailedResendPackets++;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -174,6 +184,7 @@ LLCircuitData::~LLCircuitData()
 
 		delete packetp;
 	}
+	mFinalRetryPackets.clear();
 
 	// log aborted reliable packets for this circuit.
 	if(gMessageSystem->mVerboseLog && !doomed.empty())
@@ -189,13 +200,13 @@ LLCircuitData::~LLCircuitData()
 
 void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 {
-	reliable_iter iter;
+	LLReliablePacket** entry;
 	LLReliablePacket *packetp;
 
-	iter = mUnackedPackets.find(packet_num);
-	if (iter != mUnackedPackets.end())
+	entry = mUnackedPackets.find(packet_num);
+	if (entry)
 	{
-		packetp = iter->second;
+		packetp = *entry;
 
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -222,14 +233,14 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 
 		// Cleanup
 		delete packetp;
-		mUnackedPackets.erase(iter);
+		mUnackedPackets.erase(packet_num);
 		return;
 	}
 
-	iter = mFinalRetryPackets.find(packet_num);
-	if (iter != mFinalRetryPackets.end())
+	entry = mFinalRetryPackets.find(packet_num);
+	if (entry)
 	{
-		packetp = iter->second;
+		packetp = *entry;
 		// llinfos << "Packet " << packet_num << " removed from the pending list" << llendl;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -256,7 +267,7 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 
 		// Cleanup
 		delete packetp;
-		mFinalRetryPackets.erase(iter);
+		mFinalRetryPackets.erase(packet_num);
 	}
 	else
 	{
@@ -274,17 +285,20 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 
 
 	//
-	// Theoretically we should search through the list for the packet with the oldest
-	// packet ID, as otherwise when we WRAP we will resend reliable packets out of order.
-	// Since resends are ALREADY out of order, and wrapping is highly rare (16+million packets),
-	// I'm not going to worry about this for now - djs
+	// The unacked list is kept in packet ID order, wrapping included, so this
+	// resends the oldest packets first.
 	//
 
-	reliable_iter iter;
+	TPACKETID id = mUnackedPackets.getFirstID();
 	BOOL have_resend_overflow = FALSE;
-	for (iter = mUnackedPackets.begin(); iter != mUnackedPackets.end();)
+	for (U32 n = mUnackedPackets.getSpan(); n; --n, id = reliable_map::nextID(id))
 	{
-		packetp = iter->second;
+		LLReliablePacket** entry = mUnackedPackets.find(id);
+		if (!entry)
+		{
+			continue;
+		}
+		packetp = *entry;
 
 		// Only check overflow if we haven't had one yet.
 		if (!have_resend_overflow)
@@ -305,12 +319,8 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 					// This circuit has overflowed.  Do not retry.  Do not pass go.
 					packetp->mRetries = 0;
 					// Remove it from this list and add it to the final list.
-					mUnackedPackets.erase(iter++);
-					mFinalRetryPackets[packetp->mPacketID] = packetp;
-				}
-				else
-				{
-					++iter;
+					mUnackedPackets.erase(id);
+					mFinalRetryPackets.set(packetp->mPacketID, packetp);
 				}
 				// Move on to the next unacked packet.
 				continue;
@@ -365,27 +375,24 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 			if (!packetp->mRetries)
 			{
 				// Last resend, remove it from this list and add it to the final list.
-				mUnackedPackets.erase(iter++);
-				mFinalRetryPackets[packetp->mPacketID] = packetp;
-			}
-			else
-			{
-				// Don't remove it yet, it still gets to try to resend at least once.
-				++iter;
+				// Otherwise it still gets to try to resend at least once.
+				mUnackedPackets.erase(id);
+				mFinalRetryPackets.set(packetp->mPacketID, packetp);
 			}
 			resent_packets++;
 		}
-		else
-		{
-			// Don't need to do anything with this packet, keep iterating.
-			++iter;
-		}
 	}
 
 
-	for (iter = mFinalRetryPackets.begin(); iter != mFinalRetryPackets.end();)
+	id = mFinalRetryPackets.getFirstID();
+	for (U32 n = mFinalRetryPackets.getSpan(); n; --n, id = reliable_map::nextID(id))
 	{
-		packetp = iter->second;
+		LLReliablePacket** entry = mFinalRetryPackets.find(id);
+		if (!entry)
+		{
+			continue;
+		}
+		packetp = *entry;
 		if (now > packetp->mExpirationTime)
 		{
 			// fail (too many retries)
@@ -413,13 +420,9 @@ S32 LLCircuitData::resendUnackedPackets(const F64 now)
 			mUnackedPacketCount--;
 			mUnackedPacketBytes -= packetp->mBufferLength;
 
-			mFinalRetryPackets.erase(iter++);
+			mFinalRetryPackets.erase(id);
 			delete packetp;
 		}
-		else
-		{
-			++iter;
-		}
 	}
 
 	return mUnackedPacketCount;
@@ -572,11 +575,11 @@ void LLCircuitData::addReliablePacket(S32 mSocket, U8 *buf_ptr, S32 buf_len, LLR
 
 	if (params && params->mRetries)
 	{
-		mUnackedPackets[packet_info->mPacketID] = packet_info;
+		mUnackedPackets.set(packet_info->mPacketID, packet_info);
 	}
 	else
 	{
-		mFinalRetryPackets[packet_info->mPacketID] = packet_info;
+		mFinalRetryPackets.set(packet_info->mPacketID, packet_info);
 	}
 }
 
@@ -600,7 +603,7 @@ void LLCircuit::resendUnackedPackets(S32& unacked_list_length, S32& unacked_list
 
 BOOL LLCircuitData::isDuplicateResend(TPACKETID packetnum)
 {
-	return (mRecentlyReceivedReliablePackets.find(packetnum) != mRecentlyReceivedReliablePackets.end());
+	return mRecentlyReceivedReliablePackets.has(packetnum);
 }
 
 
@@ -711,7 +714,7 @@ void LLCircuitData::checkPacketInID(TPACKETID id, BOOL receive_resent)
 		const U8 width = 24;
 		gap = LLModularMath::subtract<width>(mPacketsInID, id);
 
-		if (mPotentialLostPackets.find(id) != mPotentialLostPackets.end())
+		if (mPotentialLostPackets.has(id))
 		{
 			if(gMessageSystem->mVerboseLog)
 			{
@@ -740,7 +743,7 @@ void LLCircuitData::checkPacketInID(TPACKETID id, BOOL receive_resent)
 					}
 
 //						llinfos << "adding potential lost: " << index << llendl;
-					mPotentialLostPackets[index] = time;
+					mPotentialLostPackets.set(index, time);
 					index++;
 					index = index % LL_MAX_OUT_PACKET_ID;
 					gap_count++;
@@ -861,92 +864,30 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 	// for the packet that it was out of order with was received BEFORE
 	// the ping was sent.
 
-	// Find the current oldest reliable packetID
-	// This is to handle the case if we actually manage to wrap our
-	// packet IDs - the oldest will actually have a higher packet ID
-	// than the current.
-	BOOL wrapped = FALSE;
-	reliable_iter iter;
-	iter = mUnackedPackets.upper_bound(getPacketOutID());
-	if (iter == mUnackedPackets.end())
+	// Find the current oldest reliable packetID.  Both lists are kept
+	// in packet ID order, wrapping included, so it is the first one of
+	// either list.
+	TPACKETID packet_id;
+	if (!mUnackedPackets.empty())
 	{
-		// Nothing AFTER this one, so we want the lowest packet ID
-		// then.
-		iter = mUnackedPackets.begin();
-		wrapped = TRUE;
-	}
-
-	TPACKETID packet_id = 0;
-
-	// Check against the "final" packets
-	BOOL wrapped_final = FALSE;
-	reliable_iter iter_final;
-	iter_final = mFinalRetryPackets.upper_bound(getPacketOutID());
-	if (iter_final == mFinalRetryPackets.end())
-	{
-		iter_final = mFinalRetryPackets.begin();
-		wrapped_final = TRUE;
-	}
-
-	//llinfos << mHost << " - unacked count " << mUnackedPackets.size() << llendl;
-	//llinfos << mHost << " - final count " << mFinalRetryPackets.size() << llendl;
-	if (wrapped != wrapped_final)
-	{
-		// One of the "unacked" or "final" lists hasn't wrapped.  Whichever one
-		// hasn't has the oldest packet.
-		if (!wrapped)
+		packet_id = mUnackedPackets.getFirstID();
+		if (!mFinalRetryPackets.empty()
+			&& reliable_map::isBefore(mFinalRetryPackets.getFirstID(), packet_id))
 		{
-			// Hasn't wrapped, so the one on the
-			// unacked packet list is older
-			packet_id = iter->first;
-			//llinfos << mHost << ": nowrapped unacked" << llendl;
-		}
-		else
-		{
-			packet_id = iter_final->first;
-			//llinfos << mHost << ": nowrapped final" << llendl;
+			packet_id = mFinalRetryPackets.getFirstID();
 		}
 	}
+	else if (!mFinalRetryPackets.empty())
+	{
+		packet_id = mFinalRetryPackets.getFirstID();
+	}
 	else
 	{
-		// They both wrapped, we can just use the minimum of the two.
-		if ((iter == mUnackedPackets.end()) && (iter_final == mFinalRetryPackets.end()))
-		{
-			// Wow!  No unacked packets at all!
-			// Send the ID of the last packet we sent out.
-			// This will flush all of the destination's
-			// unacked packets, theoretically.
-			//llinfos << mHost << ": No unacked!" << llendl;
-			packet_id = getPacketOutID();
-		}
-		else
-		{
-			BOOL had_unacked = FALSE;
-			if (iter != mUnackedPackets.end())
-			{
-				// Unacked list has the lowest so far
-				packet_id = iter->first;
-				had_unacked = TRUE;
-				//llinfos << mHost << ": Unacked" << llendl;
-			}
-
-			if (iter_final != mFinalRetryPackets.end())
-			{
-				// Use the lowest of the unacked list and the final list
-				if (had_unacked)
-				{
-					// Both had a packet, use the lowest.
-					packet_id = llmin(packet_id, iter_final->first);
-					//llinfos << mHost << ": Min of unacked/final" << llendl;
-				}
-				else
-				{
-					// Only the final had a packet, use it.
-					packet_id = iter_final->first;
-					//llinfos << mHost << ": Final!" << llendl;
-				}
-			}
-		}
+		// Wow!  No unacked packets at all!
+		// Send the ID of the last packet we sent out.
+		// This will flush all of the destination's
+		// unacked packets, theoretically.
+		packet_id = getPacketOutID();
 	}
 
 	// Send off the another ping.
@@ -961,13 +902,18 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 	// Check to see if anything on our lost list is old enough to
 	// be considered lost
 
-	LLCircuitData::packet_time_map::iterator it;
 	U64 timeout = (U64)(1000000.0*llmin(LL_MAX_LOST_TIMEOUT, getPingDelayAveraged() * LL_LOST_TIMEOUT_FACTOR));
 
 	U64 mt_usec = LLMessageSystem::getMessageTimeUsecs();
-	for (it = mPotentialLostPackets.begin(); it != mPotentialLostPackets.end(); )
+	TPACKETID id = mPotentialLostPackets.getFirstID();
+	for (U32 n = mPotentialLostPackets.getSpan(); n; --n, id = packet_time_map::nextID(id))
 	{
-		U64 delta_t_usec = mt_usec - (*it).second;
+		U64* lost_time = mPotentialLostPackets.find(id);
+		if (!lost_time)
+		{
+			continue;
+		}
+		U64 delta_t_usec = mt_usec - *lost_time;
 		if (delta_t_usec > timeout)
 		{
 			// let's call this one a loss!
@@ -977,14 +923,10 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 			{
 				std::ostringstream str;
 				str << "MSG: <- " << mHost << "\tLOST PACKET:\t"
-					<< (*it).first;
+					<< id;
 				llinfos << str.str() << llendl;
 			}
-			mPotentialLostPackets.erase(it++);
-		}
-		else
-		{
-			++it;
+			mPotentialLostPackets.erase(id);
 		}
 	}
 
@@ -1000,42 +942,11 @@ void LLCircuitData::clearDuplicateList(TPACKETID oldest_id)
 
 	//llinfos << mHost << ": clearing before oldest " << oldest_id << llendl;
 	//llinfos << "Recent list before: " << mRecentlyReceivedReliablePackets.size() << llendl;
-	if (oldest_id < mHighestPacketID)
+	if (packet_time_map::isBefore(oldest_id, mHighestPacketID))
 	{
-		// Clean up everything with a packet ID less than oldest_id.
-		packet_time_map::iterator pit_start;
-		packet_time_map::iterator pit_end;
-		pit_start = mRecentlyReceivedReliablePackets.begin();
-		pit_end = mRecentlyReceivedReliablePackets.lower_bound(oldest_id);
-		mRecentlyReceivedReliablePackets.erase(pit_start, pit_end);
-	}
-
-	// Do timeout checks on everything with an ID > mHighestPacketID.
-	// This should be empty except for wrapping IDs.  Thus, this should be
-	// highly rare.
-	U64 mt_usec = LLMessageSystem::getMessageTimeUsecs();
-
-	packet_time_map::iterator pit;
-	for(pit = mRecentlyReceivedReliablePackets.upper_bound(mHighestPacketID);
-		pit != mRecentlyReceivedReliablePackets.end(); )
-	{
-		// Validate that the packet ID seems far enough away
-		if ((pit->first - mHighestPacketID) < 100)
-		{
-			llwarns << "Probably incorrectly timing out non-wrapped packets!" << llendl;
-		}
-		U64 delta_t_usec = mt_usec - (*pit).second;
-		F64 delta_t_sec = delta_t_usec * SEC_PER_USEC;
-		if (delta_t_sec > LL_DUPLICATE_SUPPRESSION_TIMEOUT)
-		{
-			// enough time has elapsed we're not likely to get a duplicate on this one
-			llinfos << "Clearing " << pit->first << " from recent list" << llendl;
-			mRecentlyReceivedReliablePackets.erase(pit++);
-		}
-		else
-		{
-			++pit;
-		}
+		// Clean up everything with a packet ID before oldest_id.  The list
+		// is in packet ID order, so IDs from before a wrap go too.
+		mRecentlyReceivedReliablePackets.eraseBefore(oldest_id);
 	}
 	//llinfos << "Recent list after: " << mRecentlyReceivedReliablePackets.size() << llendl;
 }
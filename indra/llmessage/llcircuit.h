@@ -38,6 +38,7 @@
 #include "net.h"
 #include "llhost.h"
 #include "llpacketack.h"
+#include "llpacketidring.h"
 #include "lluuid.h"
 #include "llthrottle.h"
 #include "llstat.h"
@@ -61,6 +62,10 @@ const U8 LL_PACKET_ID_SIZE = 6;
 const S32 LL_MAX_RESENT_PACKETS_PER_FRAME = 100;
 const S32 LL_MAX_ACKED_PACKETS_PER_FRAME = 200;
 
+// How many packet IDs the duplicate suppression and lost packet lists of a
+// circuit can cover.  Anything older is dropped from them to make room.
+const U32 LL_MAX_RECEIVED_ID_SPAN = 65536;
+
 //
 // Prototypes and Predefines
 //
@@ -233,14 +238,13 @@ protected:
 	U32		mPingDelay;             // raw ping delay
 	F32		mPingDelayAveraged;     // averaged ping delay (fast attack/slow decay)
 
-	typedef std::map<TPACKETID, U64> packet_time_map;
+	typedef LLPacketIDRing<U64> packet_time_map;
 
 	packet_time_map							mPotentialLostPackets;
 	packet_time_map							mRecentlyReceivedReliablePackets;
 	std::vector<TPACKETID> mAcks;
 
-	typedef std::map<TPACKETID, LLReliablePacket *> reliable_map;
-	typedef reliable_map::iterator					reliable_iter;
+	typedef LLPacketIDRing<LLReliablePacket *> reliable_map;
 
 	reliable_map							mUnackedPackets;
 	reliable_map							mFinalRetryPackets;
@@ -41,6 +41,7 @@
 #include "llmemorystream.h"
 #include "llpumpio.h"
 #include "llsd.h"
+#include "llsdbufferserialize.h"
 #include "llsdserialize_xml.h"
 #include "llstat.h"
 #include "llstl.h"
@@ -61,6 +62,8 @@ const std::string HTTP_VERB_POST("POST");
 const std::string HTTP_VERB_DELETE("DELETE");
 const std::string HTTP_VERB_OPTIONS("OPTIONS");
 
+static const std::string LLSD_BINARY_CONTENT_TYPE("application/llsd+binary");
+
 static LLIOHTTPServer::timing_callback_t sTimingCallback = NULL;
 static void* sTimingCallbackData = NULL;
 
@@ -165,10 +168,12 @@ LLIOPipe::EStatus LLHTTPPipe::process_impl(
 		mResponse = Response::create(this);
 
 		// *TODO: Babbage: Parameterize parser?
-		// *TODO: We should look at content-type and do the right
-		// thing. Phoenix 2007-12-31
 		LLBufferStream istr(channels, buffer.get());
 
+		// Binary LLSD bodies are parsed straight out of the buffer segments.
+		const LLSD& request_headers = context[CONTEXT_REQUEST][CONTEXT_HEADERS];
+		bool binary_input = (request_headers["content-type"].asString() == LLSD_BINARY_CONTENT_TYPE);
+
 		static LLTimer timer;
 		timer.reset();
 
@@ -184,7 +189,14 @@ LLIOPipe::EStatus LLHTTPPipe::process_impl(
 			LLSD input;
 			if (mNode.getContentType() == LLHTTPNode::CONTENT_TYPE_LLSD)
 			{
-				LLSDSerialize::fromXML(input, istr);
+				if (binary_input)
+				{
+					LLSDBufferSerialize::fromBinary(input, channels.in(), buffer.get());
+				}
+				else
+				{
+					LLSDSerialize::fromXML(input, istr);
+				}
 			}
 			else if (mNode.getContentType() == LLHTTPNode::CONTENT_TYPE_TEXT)
 			{
@@ -200,7 +212,14 @@ LLIOPipe::EStatus LLHTTPPipe::process_impl(
 			LLSD input;
 			if (mNode.getContentType() == LLHTTPNode::CONTENT_TYPE_LLSD)
 			{
-				LLSDSerialize::fromXML(input, istr);
+				if (binary_input)
+				{
+					LLSDBufferSerialize::fromBinary(input, channels.in(), buffer.get());
+				}
+				else
+				{
+					LLSDSerialize::fromXML(input, istr);
+				}
 			}
 			else if (mNode.getContentType() == LLHTTPNode::CONTENT_TYPE_TEXT)
 			{
@@ -266,6 +285,14 @@ LLIOPipe::EStatus LLHTTPPipe::process_impl(
 		case STATE_GOOD_RESULT:
 		{
 			LLSD headers = mHeaders;
+			const LLSD& request_headers = context[CONTEXT_REQUEST][CONTEXT_HEADERS];
+			if (request_headers["accept"].asString().find(LLSD_BINARY_CONTENT_TYPE) != std::string::npos)
+			{
+				headers["Content-Type"] = LLSD_BINARY_CONTENT_TYPE;
+				context[CONTEXT_RESPONSE][CONTEXT_HEADERS] = headers;
+				LLSDBufferSerialize::toBinary(mGoodResult, channels.out(), buffer.get());
+				return STATUS_DONE;
+			}
 			headers["Content-Type"] = "application/llsd+xml";
 			context[CONTEXT_RESPONSE][CONTEXT_HEADERS] = headers;
 			LLBufferStream ostr(channels, buffer.get());
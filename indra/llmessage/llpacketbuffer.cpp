@@ -59,6 +59,10 @@ LLPacketBuffer::LLPacketBuffer (S32 hSocket)
 	init(hSocket);
 }
 
+LLPacketBuffer::LLPacketBuffer () : mSize(0)
+{
+}
+
 ///////////////////////////////////////////////////////////
 
 LLPacketBuffer::~LLPacketBuffer ()
@@ -74,3 +78,26 @@ void LLPacketBuffer::init (S32 hSocket)
 	mReceivingIF = ::get_receiving_interface();
 }
 
+//static
+S32 LLPacketBuffer::receiveBatch(S32 hSocket, LLPacketBuffer* packets, S32 count)
+{
+	char* buffers[MAX_RECEIVE_BATCH];
+	S32 sizes[MAX_RECEIVE_BATCH];
+	LLHost senders[MAX_RECEIVE_BATCH];
+	LLHost receiving_ifs[MAX_RECEIVE_BATCH];
+
+	count = llmin(count, MAX_RECEIVE_BATCH);
+	for (S32 i = 0; i < count; ++i)
+	{
+		buffers[i] = packets[i].mData;
+	}
+
+	S32 received = receive_packets(hSocket, buffers, sizes, senders, receiving_ifs, count);
+	for (S32 i = 0; i < received; ++i)
+	{
+		packets[i].mSize = sizes[i];
+		packets[i].mHost = senders[i];
+		packets[i].mReceivingIF = receiving_ifs[i];
+	}
+	return received;
+}
@@ -36,8 +36,13 @@ class LLPacketBuffer
 public:
 	LLPacketBuffer(const LLHost &host, const char *datap, const S32 size);
 	LLPacketBuffer(S32 hSocket);           // receive a packet
+	LLPacketBuffer();                      // empty, see receiveBatch()
 	~LLPacketBuffer();
 
+	// Receives up to count packets into the consecutive buffers at packets,
+	// without blocking. Returns the number received.
+	static S32 receiveBatch(S32 hSocket, LLPacketBuffer* packets, S32 count);
+
 	S32			getSize() const					{ return mSize; }
 	const char	*getData() const				{ return mData; }
 	LLHost		getHost() const					{ return mHost; }
@@ -0,0 +1,286 @@
+/**
+ * @file llpacketidring.h
+ * @brief Packet ID indexed ring used for reliable packet bookkeeping.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETIDRING_H
+#define LL_LLPACKETIDRING_H
+
+#include <vector>
+
+#include "llmodularmath.h"
+
+// Map from packet ID to T for the per circuit reliable packet lists.
+//
+// Packet IDs are 24 bit sequence numbers which wrap.  Entries are kept in a
+// power of 2 array at (id & mask), and the ring covers the IDs from the
+// oldest entry (getFirstID()) to the newest one, in sequence order.  Insert,
+// find and erase are O(1), and walking the entries oldest first is a scan
+// of one array:
+//
+//	TPACKETID id = ring.getFirstID();
+//	for (U32 n = ring.getSpan(); n; --n, id = ring.nextID(id))
+//	{
+//		T* entry = ring.find(id);
+//		...
+//	}
+//
+// Entries may be erased during such a walk.  The array doubles whenever
+// the ring needs to cover more IDs than it can hold, and never shrinks, so
+// a busy circuit stops allocating after its first burst.
+template <class T>
+class LLPacketIDRing
+{
+public:
+	enum
+	{
+		ID_BITS = 24,
+		ID_MASK = (1 << ID_BITS) - 1,
+		// IDs farther apart than this are taken to have wrapped
+		HALF_ID_RANGE = 1 << (ID_BITS - 1)
+	};
+
+	// capacity must be a power of 2.  When max_span is given, setting an
+	// ID more than max_span past the oldest entry pushes the oldest entries
+	// out, so only use it for rings whose entries need no cleanup.
+	LLPacketIDRing(U32 capacity = 64, U32 max_span = HALF_ID_RANGE)
+	:	mSlots(capacity),
+		mMask(capacity - 1),
+		mFirst(0),
+		mSpan(0),
+		mCount(0),
+		mMaxSpan(max_span)
+	{
+		llassert(capacity && !(capacity & mMask));
+	}
+
+	bool empty() const			{ return mCount == 0; }
+	S32 size() const			{ return mCount; }
+	U32 getCapacity() const		{ return (U32)mSlots.size(); }
+
+	// Oldest ID held, and how many IDs from there to the newest one
+	TPACKETID getFirstID() const	{ return mFirst; }
+	U32 getSpan() const				{ return mSpan; }
+
+	static TPACKETID nextID(TPACKETID id)
+	{
+		return (id + 1) & ID_MASK;
+	}
+
+	// How many IDs to is past from, with wrapping
+	static U32 distance(TPACKETID from, TPACKETID to)
+	{
+		return LLModularMath::subtract<ID_BITS>(to, from);
+	}
+
+	// True if id comes before other in the wrapping sequence
+	static bool isBefore(TPACKETID id, TPACKETID other)
+	{
+		U32 d = distance(id, other);
+		return d && d < HALF_ID_RANGE;
+	}
+
+	T* find(TPACKETID id)
+	{
+		id &= ID_MASK;
+		if (distance(mFirst, id) >= mSpan)
+		{
+			return NULL;
+		}
+		Slot& slot = mSlots[id & mMask];
+		return slot.mID == id ? &slot.mValue : NULL;
+	}
+
+	bool has(TPACKETID id)
+	{
+		return find(id) != NULL;
+	}
+
+	// Adds or replaces the entry for id.  Returns false if id is too far
+	// before the oldest entry to fit in max_span, and nothing was stored.
+	bool set(TPACKETID id, const T& value)
+	{
+		id &= ID_MASK;
+		if (mCount && distance(mFirst, id) < HALF_ID_RANGE)
+		{
+			// At or past the oldest entry, make room if it is too far
+			while (mCount && distance(mFirst, id) >= mMaxSpan)
+			{
+				erase(mFirst);
+			}
+		}
+
+		if (!mCount)
+		{
+			mFirst = id;
+			mSpan = 1;
+		}
+		else
+		{
+			U32 ahead = distance(mFirst, id);
+			if (ahead < HALF_ID_RANGE)
+			{
+				if (ahead >= mSpan)
+				{
+					grow(ahead + 1);
+					mSpan = ahead + 1;
+				}
+			}
+			else
+			{
+				U32 span = mSpan + distance(id, mFirst);
+				if (span > mMaxSpan)
+				{
+					return false;
+				}
+				grow(span);
+				mFirst = id;
+				mSpan = span;
+			}
+		}
+
+		Slot& slot = mSlots[id & mMask];
+		if (slot.mID != id)
+		{
+			slot.mID = id;
+			++mCount;
+		}
+		slot.mValue = value;
+		return true;
+	}
+
+	bool erase(TPACKETID id)
+	{
+		id &= ID_MASK;
+		U32 offset = distance(mFirst, id);
+		if (offset >= mSpan)
+		{
+			return false;
+		}
+		Slot& slot = mSlots[id & mMask];
+		if (slot.mID != id)
+		{
+			return false;
+		}
+		slot.mID = EMPTY_ID;
+		slot.mValue = T();
+
+		if (!--mCount)
+		{
+			mSpan = 0;
+		}
+		else if (!offset)
+		{
+			// Move up to the next oldest entry
+			do
+			{
+				mFirst = nextID(mFirst);
+				--mSpan;
+			}
+			while (mSlots[mFirst & mMask].mID == EMPTY_ID);
+		}
+		else if (offset == mSpan - 1)
+		{
+			// Move back to the next newest entry
+			do
+			{
+				--mSpan;
+			}
+			while (mSlots[(mFirst + mSpan - 1) & mMask].mID == EMPTY_ID);
+		}
+		return true;
+	}
+
+	// Erases every entry before id
+	void eraseBefore(TPACKETID id)
+	{
+		while (mCount && isBefore(mFirst, id))
+		{
+			erase(mFirst);
+		}
+	}
+
+	// Keeps the array for reuse
+	void clear()
+	{
+		TPACKETID id = mFirst;
+		for (U32 n = mSpan; n; --n, id = nextID(id))
+		{
+			Slot& slot = mSlots[id & mMask];
+			slot.mID = EMPTY_ID;
+			slot.mValue = T();
+		}
+		mSpan = 0;
+		mCount = 0;
+	}
+
+private:
+	// No valid ID has the top bits set
+	static const TPACKETID EMPTY_ID = 0xffffffff;
+
+	struct Slot
+	{
+		Slot() : mID(EMPTY_ID), mValue() {}
+
+		TPACKETID mID;
+		T mValue;
+	};
+
+	// Makes room for span IDs
+	void grow(U32 span)
+	{
+		U32 capacity = (U32)mSlots.size();
+		if (span <= capacity)
+		{
+			return;
+		}
+		while (capacity < span)
+		{
+			capacity <<= 1;
+		}
+
+		std::vector<Slot> slots(capacity);
+		U32 mask = capacity - 1;
+		TPACKETID id = mFirst;
+		for (U32 n = mSpan; n; --n, id = nextID(id))
+		{
+			const Slot& slot = mSlots[id & mMask];
+			if (slot.mID != EMPTY_ID)
+			{
+				slots[id & mask] = slot;
+			}
+		}
+		mSlots.swap(slots);
+		mMask = mask;
+	}
+
+	std::vector<Slot> mSlots;
+	U32 mMask;
+	TPACKETID mFirst;
+	U32 mSpan;
+	S32 mCount;
+	U32 mMaxSpan;
+};
+
+#endif // LL_LLPACKETIDRING_H
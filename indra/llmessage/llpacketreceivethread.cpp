@@ -0,0 +1,124 @@
+/** 
+ * @file llpacketreceivethread.cpp
+ * @brief Background thread draining the message system socket into a
+ * ring of packet buffers.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketreceivethread.h"
+
+#include "llpacketbuffer.h"
+#include "lltimer.h"
+#include "net.h"
+
+// How long the thread waits for a packet before checking whether it
+// should quit
+const S32 RECEIVE_WAIT_MS = 100;
+
+LLPacketReceiveThread::LLPacketReceiveThread(S32 socket, U32 ring_size) :
+	LLThread("Packet receive"),
+	mSocket(socket),
+	mPackets(NULL),
+	mRingSize(ring_size),
+	mHead(0),
+	mTail(0),
+	mRingFullCount(0)
+{
+	if (!mRingSize || (mRingSize & (mRingSize - 1)))
+	{
+		llerrs << "Packet receive ring size " << mRingSize << " is not a power of 2" << llendl;
+	}
+	mPackets = new LLPacketBuffer[mRingSize];
+}
+
+LLPacketReceiveThread::~LLPacketReceiveThread()
+{
+	shutdown();
+	delete[] mPackets;
+	mPackets = NULL;
+}
+
+const LLPacketBuffer* LLPacketReceiveThread::getPacket()
+{
+	U32 tail = mTail;
+	if (tail == (U32)mHead)
+	{
+		return NULL;
+	}
+	return &mPackets[tail & (mRingSize - 1)];
+}
+
+void LLPacketReceiveThread::popPacket()
+{
+	if ((U32)mTail != (U32)mHead)
+	{
+		// the increment publishes the slot back to the receive thread
+		mTail++;
+	}
+}
+
+U32 LLPacketReceiveThread::getPendingCount()
+{
+	return (U32)mHead - (U32)mTail;
+}
+
+//virtual
+void LLPacketReceiveThread::run()
+{
+	while (!isQuitting())
+	{
+		const U32 head = mHead;
+		const U32 free_slots = mRingSize - (head - (U32)mTail);
+		if (!free_slots)
+		{
+			// The main thread is behind, leave the packets in the socket
+			// until it catches up
+			mRingFullCount++;
+			ms_sleep(1);
+			continue;
+		}
+
+		if (!wait_for_packet(mSocket, RECEIVE_WAIT_MS))
+		{
+			continue;
+		}
+
+		// Receive into the free slots up to the end of the array, the
+		// next batch starts over at the beginning
+		const U32 index = head & (mRingSize - 1);
+		const U32 contiguous = llmin(free_slots, mRingSize - index);
+		S32 received = LLPacketBuffer::receiveBatch(mSocket, &mPackets[index], (S32)contiguous);
+		if (received > 0)
+		{
+			// the increment publishes the packets to the main thread
+			mHead += (U32)received;
+		}
+	}
+
+	if (mRingFullCount)
+	{
+		llinfos << "Packet receive ring was full " << mRingFullCount << " times" << llendl;
+	}
+}
@@ -0,0 +1,71 @@
+/** 
+ * @file llpacketreceivethread.h
+ * @brief Background thread draining the message system socket into a
+ * ring of packet buffers.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETRECEIVETHREAD_H
+#define LL_LLPACKETRECEIVETHREAD_H
+
+#include "llapr.h"
+#include "llthread.h"
+
+class LLPacketBuffer;
+
+// Receives from the socket on its own thread, in batches, so packets that
+// arrive while the main thread is busy with a frame wait in user space
+// instead of overflowing the socket buffer. LLPacketRing consumes them in
+// arrival order on the main thread.
+//
+// The receive thread is the only writer of mHead and the main thread the
+// only writer of mTail, so the ring of preallocated LLPacketBuffers needs
+// no lock. When the ring is full the thread stops receiving and the
+// packets queue in the socket, as they did without the thread.
+class LLPacketReceiveThread : public LLThread
+{
+public:
+	enum { DEFAULT_RING_SIZE = 256 };	// packets, a power of 2
+
+	LLPacketReceiveThread(S32 socket, U32 ring_size = DEFAULT_RING_SIZE);
+	virtual ~LLPacketReceiveThread();
+
+	// Main thread only.
+	// Oldest packet not yet consumed, or NULL. Valid until popPacket().
+	const LLPacketBuffer* getPacket();
+	void popPacket();
+	U32 getPendingCount();
+
+protected:
+	/*virtual*/ void run();
+
+private:
+	S32 mSocket;
+	LLPacketBuffer* mPackets;
+	U32 mRingSize;
+	LLAtomicU32 mHead;	// packets received
+	LLAtomicU32 mTail;	// packets consumed
+	U32 mRingFullCount;	// receive thread only, reported on exit
+};
+
+#endif // LL_LLPACKETRECEIVETHREAD_H
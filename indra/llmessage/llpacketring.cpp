@@ -29,6 +29,8 @@
 #include "llpacketring.h"
 
 // linden library includes
+#include "llpacketreceivethread.h"
+
 #include "llerror.h"
 #include "lltimer.h"
 #include "timing.h"
@@ -47,7 +49,8 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mReceiveThread(NULL)
 {
 }
 
@@ -62,6 +65,8 @@ void LLPacketRing::cleanup ()
 {
 	LLPacketBuffer *packetp;
 
+	stopReceiveThread();
+
 	while (!mReceiveQueue.empty())
 	{
 		packetp = mReceiveQueue.front();
@@ -108,6 +113,47 @@ void LLPacketRing::setOutBandwidth(const F32 bps)
 {
 	mOutThrottle.setRate(bps);
 }
+///////////////////////////////////////////////////////////
+void LLPacketRing::startReceiveThread(S32 socket)
+{
+	if (!mReceiveThread)
+	{
+		llinfos << "Starting packet receive thread" << llendl;
+		mReceiveThread = new LLPacketReceiveThread(socket);
+		mReceiveThread->start();
+	}
+}
+
+void LLPacketRing::stopReceiveThread()
+{
+	if (mReceiveThread)
+	{
+		delete mReceiveThread; // shuts it down
+		mReceiveThread = NULL;
+	}
+}
+
+bool LLPacketRing::hasReceivedPackets()
+{
+	return mReceiveThread && mReceiveThread->getPacket() != NULL;
+}
+
+S32 LLPacketRing::receiveFromThread(char *datap)
+{
+	const LLPacketBuffer *packetp = mReceiveThread->getPacket();
+	if (!packetp)
+	{
+		return 0;
+	}
+
+	S32 packet_size = packetp->getSize();
+	memcpy(datap, packetp->getData(), packet_size);	/*Flawfinder: ignore*/
+	mLastSender = packetp->getHost();
+	mLastReceivingIF = packetp->getReceivingInterface();
+	mReceiveThread->popPacket();
+	return packet_size;
+}
+
 ///////////////////////////////////////////////////////////
 S32 LLPacketRing::receiveFromRing (S32 socket, char *datap)
 {
@@ -159,7 +205,23 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 		while (!done)
 		{
 			LLPacketBuffer *packetp;
-			packetp = new LLPacketBuffer(socket);
+			if (mReceiveThread)
+			{
+				const LLPacketBuffer *receivedp = mReceiveThread->getPacket();
+				if (receivedp)
+				{
+					packetp = new LLPacketBuffer(*receivedp);
+					mReceiveThread->popPacket();
+				}
+				else
+				{
+					packetp = new LLPacketBuffer();
+				}
+			}
+			else
+			{
+				packetp = new LLPacketBuffer(socket);
+			}
 
 			if (packetp->getSize())
 			{
@@ -215,10 +277,17 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 	}
 	else
 	{
-		// no delay, pull straight from net
-		packet_size = receive_packet(socket, datap);		
-		mLastSender = ::get_sender();
-		mLastReceivingIF = ::get_receiving_interface();
+		if (mReceiveThread)
+		{
+			packet_size = receiveFromThread(datap);
+		}
+		else
+		{
+			// no delay, pull straight from net
+			packet_size = receive_packet(socket, datap);		
+			mLastSender = ::get_sender();
+			mLastReceivingIF = ::get_receiving_interface();
+		}
 
 		if (packet_size)  // did we actually get a packet?
 		{
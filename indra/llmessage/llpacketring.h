@@ -35,6 +35,7 @@
 #include "net.h"
 #include "llthrottle.h"
 
+class LLPacketReceiveThread;
 
 class LLPacketRing
 {
@@ -53,6 +54,14 @@ public:
 	S32  receivePacket (S32 socket, char *datap);
 	S32  receiveFromRing (S32 socket, char *datap);
 
+	// Receive on a background thread instead of from socket directly,
+	// see LLPacketReceiveThread. Packets the thread received but
+	// receivePacket() has not returned yet are lost when it stops.
+	void startReceiveThread(S32 socket);
+	void stopReceiveThread();
+	bool hasReceiveThread() const				{ return mReceiveThread != NULL; }
+	bool hasReceivedPackets();
+
 	BOOL sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
 
 	inline LLHost getLastSender();
@@ -82,6 +91,12 @@ protected:
 
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
+
+private:
+	// The next packet from the receive thread, 0 if there is none
+	S32 receiveFromThread(char *datap);
+
+	LLPacketReceiveThread* mReceiveThread;
 };
 
 
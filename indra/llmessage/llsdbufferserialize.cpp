@@ -0,0 +1,142 @@
+/** 
+ * @file llsdbufferserialize.cpp
+ * @brief Binary LLSD straight to and from LLBufferArray channels.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llsdbufferserialize.h"
+
+#include "llbuffer.h"
+#include "llmemtype.h"
+#include "llsddocument.h"
+
+// static
+S32 LLSDBufferSerialize::parseBinary(
+	LLSDParseHandler& handler,
+	S32 channel,
+	LLBufferArray* buffer,
+	S32 max_bytes)
+{
+	// All of the input is already here, so it bounds the parse even when
+	// the caller set no limit, which keeps container size hints honest.
+	S32 size = buffer->count(channel);
+	if((max_bytes < 0) || (max_bytes > size))
+	{
+		max_bytes = size;
+	}
+	LLSDBinaryStreamParser parser(handler, max_bytes);
+	LLBufferArray::segment_iterator_t it = buffer->beginSegment();
+	LLBufferArray::segment_iterator_t end = buffer->endSegment();
+	for( ; it != end; ++it)
+	{
+		if(!(*it).isOnChannel(channel))
+		{
+			continue;
+		}
+		if(parser.feed((*it).data(), (*it).size()) != LLSDBinaryStreamParser::STATUS_NEED_MORE)
+		{
+			break;
+		}
+	}
+	if(parser.getStatus() != LLSDBinaryStreamParser::STATUS_DONE)
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
+	return parser.getParseCount();
+}
+
+// static
+S32 LLSDBufferSerialize::fromBinary(
+	LLSD& sd,
+	S32 channel,
+	LLBufferArray* buffer,
+	S32 max_bytes)
+{
+	sd.clear();
+	LLSDBuilder builder(sd);
+	S32 parse_count = parseBinary(builder, channel, buffer, max_bytes);
+	if(parse_count <= 0)
+	{
+		sd.clear();
+	}
+	return parse_count;
+}
+
+// static
+S32 LLSDBufferSerialize::fromBinary(
+	LLSDDocument& doc,
+	S32 channel,
+	LLBufferArray* buffer,
+	S32 max_bytes)
+{
+	doc.clear();
+	S32 size = buffer->count(channel);
+	doc.reserve(size / 32, size);
+	S32 parse_count = parseBinary(doc, channel, buffer, max_bytes);
+	if((parse_count <= 0) || !doc.finish())
+	{
+		doc.clear();
+		return LLSDParser::PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+// static
+bool LLSDBufferSerialize::toBinary(const LLSD& sd, S32 channel, LLBufferArray* buffer)
+{
+	LLMemType m1(LLMemType::MTYPE_IO_BUFFER);
+	S32 size = LLSDBinaryFormatter::getFormattedSize(sd);
+	LLBufferArray::segment_iterator_t it = buffer->makeSegment(channel, size);
+	if(it == buffer->endSegment())
+	{
+		return false;
+	}
+	if((*it).size() == size)
+	{
+		// The usual case, format right into the segment.
+		LLSDBinaryFormatter::formatBuffer(sd, (*it).data());
+		return true;
+	}
+
+	// The buffer array could not give one segment that big, so format
+	// once and spread the bytes over as many segments as it takes.
+	std::vector<U8> data(size);
+	LLSDBinaryFormatter::formatBuffer(sd, &data[0]);
+	S32 written = 0;
+	while(true)
+	{
+		S32 bytes = llmin((*it).size(), size - written);
+		memcpy((*it).data(), &data[written], bytes);	/* Flawfinder: ignore */
+		written += bytes;
+		if(written == size)
+		{
+			return true;
+		}
+		it = buffer->makeSegment(channel, size - written);
+		if(it == buffer->endSegment())
+		{
+			return false;
+		}
+	}
+}
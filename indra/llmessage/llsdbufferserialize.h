@@ -0,0 +1,83 @@
+/** 
+ * @file llsdbufferserialize.h
+ * @brief Binary LLSD straight to and from LLBufferArray channels.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSDBUFFERSERIALIZE_H
+#define LL_LLSDBUFFERSERIALIZE_H
+
+#include "llsdserialize.h"
+
+class LLBufferArray;
+class LLSDDocument;
+
+/** 
+ * @class LLSDBufferSerialize
+ * @brief Binary LLSD serialization over LLBufferArray channels.
+ *
+ * Unlike going through an LLBufferStream, the parser reads the
+ * segments of the channel in place and the formatter writes into new
+ * segments directly, so there is no byte by byte stream access and no
+ * intermediate copy of the body.
+ */
+class LLSDBufferSerialize
+{
+public:
+	/** 
+	 * @brief Parse one binary LLSD value from the segments of a channel.
+	 *
+	 * @param handler Receives the values as they are parsed.
+	 * @param channel The channel to read.
+	 * @param buffer The buffer array holding the channel.
+	 * @param max_bytes The maximum number of bytes to parse.
+	 * @return Returns the number of LLSD objects parsed or
+	 * LLSDParser::PARSE_FAILURE.
+	 */
+	static S32 parseBinary(
+		LLSDParseHandler& handler,
+		S32 channel,
+		LLBufferArray* buffer,
+		S32 max_bytes = LLSDSerialize::SIZE_UNLIMITED);
+
+	static S32 fromBinary(
+		LLSD& sd,
+		S32 channel,
+		LLBufferArray* buffer,
+		S32 max_bytes = LLSDSerialize::SIZE_UNLIMITED);
+
+	static S32 fromBinary(
+		LLSDDocument& doc,
+		S32 channel,
+		LLBufferArray* buffer,
+		S32 max_bytes = LLSDSerialize::SIZE_UNLIMITED);
+
+	/** 
+	 * @brief Append sd in binary format to a channel.
+	 *
+	 * @return Returns true on success.
+	 */
+	static bool toBinary(const LLSD& sd, S32 channel, LLBufferArray* buffer);
+};
+
+#endif // LL_LLSDBUFFERSERIALIZE_H
@@ -41,7 +41,7 @@ LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
 												 number_template_map) :
 	mReceiveSize(0),
 	mCurrentRMessageTemplate(NULL),
-	mCurrentRMessageData(NULL),
+	mReceiveBuffer(NULL),
 	mMessageNumbers(number_template_map)
 {
 }
@@ -49,8 +49,6 @@ LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
 //virtual 
 LLTemplateMessageReader::~LLTemplateMessageReader()
 {
-	delete mCurrentRMessageData;
-	mCurrentRMessageData = NULL;
 }
 
 //virtual
@@ -58,8 +56,41 @@ void LLTemplateMessageReader::clearMessage()
 {
 	mReceiveSize = -1;
 	mCurrentRMessageTemplate = NULL;
-	delete mCurrentRMessageData;
-	mCurrentRMessageData = NULL;
+	mReceiveBuffer = NULL;
+	// clear() keeps the capacity, so decoding allocates only for the
+	// largest message seen so far
+	mBlockSpans.clear();
+	mVarSpans.clear();
+}
+
+S32 LLTemplateMessageReader::findBlock(const char *blockname) const
+{
+	const LLMessageTemplate::message_block_map_t& blocks = mCurrentRMessageTemplate->mMemberBlocks;
+	LLMessageTemplate::message_block_map_t::const_iterator iter = blocks.find((char *)blockname);
+	if (iter == blocks.end())
+	{
+		return -1;
+	}
+	S32 block = (S32)(iter - blocks.begin());
+	// blocks past the one decodeData() gave up on were never decoded
+	return block < (S32)mBlockSpans.size() ? block : -1;
+}
+
+S32 LLTemplateMessageReader::findVariable(S32 block, const char *varname) const
+{
+	const LLMessageBlock* mbci = *(mCurrentRMessageTemplate->mMemberBlocks.begin() + block);
+	LLMessageBlock::message_variable_map_t::const_iterator iter = mbci->mMemberVariables.find(varname);
+	if (iter == mbci->mMemberVariables.end())
+	{
+		return -1;
+	}
+	return (S32)(iter - mbci->mMemberVariables.begin());
+}
+
+S32 LLTemplateMessageReader::getVarIndex(S32 block, S32 blocknum, S32 var) const
+{
+	const LLMessageBlock* mbci = *(mCurrentRMessageTemplate->mMemberBlocks.begin() + block);
+	return mBlockSpans[block].mFirstVar + blocknum * (S32)mbci->mMemberVariables.size() + var;
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -71,77 +102,83 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
 		return;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!mReceiveBuffer)
 	{
-		llerrs << "Invalid mCurrentMessageData in getData!" << llendl;
+		llerrs << "Invalid mReceiveBuffer in getData!" << llendl;
 		return;
 	}
 
-	char *bnamep = (char *)blockname + blocknum; // this works because it's just a hash.  The bnamep is never derefference
-	char *vnamep = (char *)varname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	S32 block = findBlock(blockname);
+	if (block < 0 || blocknum < 0 || blocknum >= mBlockSpans[block].mCount)
 	{
 		llerrs << "Block " << blockname << " #" << blocknum
-			<< " not in message " << mCurrentRMessageData->mName << llendl;
+			<< " not in message " << mCurrentRMessageTemplate->mName << llendl;
 		return;
 	}
 
-	LLMsgBlkData *msg_block_data = iter->second;
-	LLMsgVarData& vardata = msg_block_data->mMemberVarData[vnamep];
-
-	if (!vardata.getName())
+	S32 var = findVariable(block, varname);
+	if (var < 0)
 	{
-		llerrs << "Variable "<< vnamep << " not in message "
-			<< mCurrentRMessageData->mName<< " block " << bnamep << llendl;
+		llerrs << "Variable "<< varname << " not in message "
+			<< mCurrentRMessageTemplate->mName << " block " << blockname << llendl;
 		return;
 	}
 
-	if (size && size != vardata.getSize())
+	const VarSpan& span = mVarSpans[getVarIndex(block, blocknum, var)];
+	if (size && size != span.mSize)
 	{
-		llerrs << "Msg " << mCurrentRMessageData->mName 
-			<< " variable " << vnamep
-			<< " is size " << vardata.getSize()
+		llerrs << "Msg " << mCurrentRMessageTemplate->mName 
+			<< " variable " << varname
+			<< " is size " << span.mSize
 			<< " but copying into buffer of size " << size
 			<< llendl;
 		return;
 	}
 
-
-	const S32 vardata_size = vardata.getSize();
-	if( max_size >= vardata_size )
-	{   
-		switch( vardata_size )
-		{ 
-		case 1:
-			*((U8*)datap) = *((U8*)vardata.getData());
-			break;
-		case 2:
-			*((U16*)datap) = *((U16*)vardata.getData());
-			break;
-		case 4:
-			*((U32*)datap) = *((U32*)vardata.getData());
-			break;
-		case 8:
-			((U32*)datap)[0] = ((U32*)vardata.getData())[0];
-			((U32*)datap)[1] = ((U32*)vardata.getData())[1];
-			break;
-		default:
-			memcpy(datap, vardata.getData(), vardata_size);
-			break;
-		}
-	}
-	else
+	if (max_size < span.mSize)
 	{
-		llwarns << "Msg " << mCurrentRMessageData->mName 
-			<< " variable " << vnamep
-			<< " is size " << vardata.getSize()
+		llwarns << "Msg " << mCurrentRMessageTemplate->mName 
+			<< " variable " << varname
+			<< " is size " << span.mSize
 			<< " but truncated to max size of " << max_size
 			<< llendl;
+	}
+	const S32 copy_size = max_size < span.mSize ? max_size : span.mSize;
+
+	if (span.mOffset < 0)
+	{
+		memset(datap, 0, copy_size);
+		return;
+	}
 
-		memcpy(datap, vardata.getData(), max_size);
+	const U8* src = mReceiveBuffer + span.mOffset;
+#ifdef LL_BIG_ENDIAN
+	if (copy_size == span.mSize)
+	{
+		const LLMessageBlock* mbci = *(mCurrentRMessageTemplate->mMemberBlocks.begin() + block);
+		const LLMessageVariable* mvci = *(mbci->mMemberVariables.begin() + var);
+		htonmemcpy(datap, src, mvci->getType(), copy_size);
+		return;
+	}
+#endif
+	// Fixed size copies of the common sizes, the buffer may be unaligned
+	switch( copy_size )
+	{ 
+	case 1:
+		*((U8*)datap) = *src;
+		break;
+	case 2:
+		memcpy(datap, src, 2);		/* Flawfinder: ignore */
+		break;
+	case 4:
+		memcpy(datap, src, 4);		/* Flawfinder: ignore */
+		break;
+	case 8:
+		memcpy(datap, src, 8);		/* Flawfinder: ignore */
+		break;
+	default:
+		memcpy(datap, src, copy_size);		/* Flawfinder: ignore */
+		break;
 	}
 }
 
@@ -154,22 +191,19 @@ S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
 		return -1;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!mReceiveBuffer)
 	{
-		llerrs << "Invalid mCurrentRMessageData in getData!" << llendl;
+		llerrs << "Invalid mReceiveBuffer in getNumberOfBlocks!" << llendl;
 		return -1;
 	}
 
-	char *bnamep = (char *)blockname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	S32 block = findBlock(blockname);
+	if (block < 0)
 	{
 		return 0;
 	}
 
-	return (iter->second)->mBlockNumber;
+	return mBlockSpans[block].mCount;
 }
 
 S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
@@ -181,43 +215,36 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
 		return LL_MESSAGE_ERROR;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!mReceiveBuffer)
 	{	// This is a serious error - crash
-		llerrs << "Invalid mCurrentRMessageData in getData!" << llendl;
+		llerrs << "Invalid mReceiveBuffer in getSize!" << llendl;
 		return LL_MESSAGE_ERROR;
 	}
 
-	char *bnamep = (char *)blockname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	S32 block = findBlock(blockname);
+	if (block < 0 || !mBlockSpans[block].mCount)
 	{	// don't crash
-		llinfos << "Block " << bnamep << " not in message "
-			<< mCurrentRMessageData->mName << llendl;
+		llinfos << "Block " << blockname << " not in message "
+			<< mCurrentRMessageTemplate->mName << llendl;
 		return LL_BLOCK_NOT_IN_MESSAGE;
 	}
 
-	char *vnamep = (char *)varname; 
-
-	LLMsgBlkData* msg_data = iter->second;
-	LLMsgVarData& vardata = msg_data->mMemberVarData[vnamep];
-	
-	if (!vardata.getName())
+	S32 var = findVariable(block, varname);
+	if (var < 0)
 	{	// don't crash
 		llinfos << "Variable " << varname << " not in message "
-			<< mCurrentRMessageData->mName << " block " << bnamep << llendl;
+			<< mCurrentRMessageTemplate->mName << " block " << blockname << llendl;
 		return LL_VARIABLE_NOT_IN_BLOCK;
 	}
 
-	if (mCurrentRMessageTemplate->mMemberBlocks[bnamep]->mType != MBT_SINGLE)
+	if ((*(mCurrentRMessageTemplate->mMemberBlocks.begin() + block))->mType != MBT_SINGLE)
 	{	// This is a serious error - crash
-		llerrs << "Block " << bnamep << " isn't type MBT_SINGLE,"
+		llerrs << "Block " << blockname << " isn't type MBT_SINGLE,"
 			" use getSize with blocknum argument!" << llendl;
 		return LL_MESSAGE_ERROR;
 	}
 
-	return vardata.getSize();
+	return mVarSpans[getVarIndex(block, 0, var)].mSize;
 }
 
 S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const char *varname)
@@ -229,35 +256,29 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const
 		return LL_MESSAGE_ERROR;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!mReceiveBuffer)
 	{	// This is a serious error - crash
-		llerrs << "Invalid mCurrentRMessageData in getData!" << llendl;
+		llerrs << "Invalid mReceiveBuffer in getSize!" << llendl;
 		return LL_MESSAGE_ERROR;
 	}
 
-	char *bnamep = (char *)blockname + blocknum; 
-	char *vnamep = (char *)varname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	S32 block = findBlock(blockname);
+	if (block < 0 || blocknum < 0 || blocknum >= mBlockSpans[block].mCount)
 	{	// don't crash
-		llinfos << "Block " << bnamep << " not in message " 
-			<< mCurrentRMessageData->mName << llendl;
+		llinfos << "Block " << blockname << " #" << blocknum << " not in message " 
+			<< mCurrentRMessageTemplate->mName << llendl;
 		return LL_BLOCK_NOT_IN_MESSAGE;
 	}
 
-	LLMsgBlkData* msg_data = iter->second;
-	LLMsgVarData& vardata = msg_data->mMemberVarData[vnamep];
-	
-	if (!vardata.getName())
+	S32 var = findVariable(block, varname);
+	if (var < 0)
 	{	// don't crash
-		llinfos << "Variable " << vnamep << " not in message "
-			<<  mCurrentRMessageData->mName << " block " << bnamep << llendl;
+		llinfos << "Variable " << varname << " not in message "
+			<<  mCurrentRMessageTemplate->mName << " block " << blockname << llendl;
 		return LL_VARIABLE_NOT_IN_BLOCK;
 	}
 
-	return vardata.getSize();
+	return mVarSpans[getVarIndex(block, blocknum, var)].mSize;
 }
 
 void LLTemplateMessageReader::getBinaryData(const char *blockname, 
@@ -531,18 +552,21 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 {
 	llassert( mReceiveSize >= 0 );
 	llassert( mCurrentRMessageTemplate);
-	llassert( !mCurrentRMessageData );
-	delete mCurrentRMessageData; // just to make sure
+	llassert( !mReceiveBuffer );
 
 	// The offset tells us how may bytes to skip after the end of the
 	// message name.
 	U8 offset = buffer[PHL_OFFSET];
 	S32 decode_pos = LL_PACKET_ID_SIZE + (S32)(mCurrentRMessageTemplate->mFrequency) + offset;
 
-	// create base working data set
-	mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
+	// Only record where each variable is, the getters read from buffer
+	mReceiveBuffer = buffer;
+	mBlockSpans.clear();
+	mVarSpans.clear();
+	mBlockSpans.reserve(mCurrentRMessageTemplate->mMemberBlocks.size());
+	S32 total_blocks = 0;
 	
-	// loop through the template building the data structure as we go
+	// loop through the template recording the spans as we go
 	LLMessageTemplate::message_block_map_t::const_iterator iter;
 	for(iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
 		iter != mCurrentRMessageTemplate->mMemberBlocks.end();
@@ -589,36 +613,22 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 			return FALSE;
 		}
 
-		LLMsgBlkData* cur_data_block = NULL;
+		BlockSpans block_spans;
+		block_spans.mFirstVar = (S32)mVarSpans.size();
+		block_spans.mCount = repeat_number;
+		mBlockSpans.push_back(block_spans);
+		total_blocks += repeat_number;
 
 		// now loop through the block
 		for (i = 0; i < repeat_number; i++)
 		{
-			if (i)
-			{
-				// build new name to prevent collisions
-				// TODO: This should really change to a vector
-				cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-				cur_data_block->mName = mbci->mName + i;
-			}
-			else
-			{
-				cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-			}
-
-			// add the block to the message
-			mCurrentRMessageData->addBlock(cur_data_block);
-
 			// now read the variables
 			for (LLMessageBlock::message_variable_map_t::const_iterator iter = 
 					 mbci->mMemberVariables.begin();
 				 iter != mbci->mMemberVariables.end(); iter++)
 			{
 				const LLMessageVariable& mvci = **iter;
-
-				// ok, build out the variables
-				// add variable block
-				cur_data_block->addVariable(mvci.getName(), mvci.getType());
+				VarSpan span;
 
 				// what type of variable?
 				if (mvci.getType() == MVT_VARIABLE)
@@ -658,37 +668,43 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 					}
 					decode_pos += data_size;
 
-					cur_data_block->addData(mvci.getName(), &buffer[decode_pos], tsize, mvci.getType());
+					// the data is read in place, so it has to be in the packet
+					if (tsize && (decode_pos + (S32)tsize) > mReceiveSize)
+					{
+						logRanOffEndOfPacket(sender, decode_pos, tsize);
+
+						// default to 0 length variable blocks
+						tsize = 0;
+					}
+
+					span.mOffset = decode_pos;
+					span.mSize = tsize;
 					decode_pos += tsize;
 				}
 				else
 				{
 					// fixed!
-					// so, copy data pointer and set data size to fixed size
+					// so, point at the data and set data size to fixed size
+					span.mSize = mvci.getSize();
 					if ((decode_pos + mvci.getSize()) > mReceiveSize)
 					{
 						logRanOffEndOfPacket(sender, decode_pos, mvci.getSize());
 
 						// default to 0s.
-						U32 size = mvci.getSize();
-						std::vector<U8> data(size, 0);
-						cur_data_block->addData(mvci.getName(), &(data[0]), 
-												size, mvci.getType());
+						span.mOffset = -1;
 					}
 					else
 					{
-						cur_data_block->addData(mvci.getName(), 
-												&buffer[decode_pos], 
-												mvci.getSize(), 
-												mvci.getType());
+						span.mOffset = decode_pos;
 					}
 					decode_pos += mvci.getSize();
 				}
+				mVarSpans.push_back(span);
 			}
 		}
 	}
 
-	if (mCurrentRMessageData->mMemberBlocks.empty()
+	if (!total_blocks
 		&& !mCurrentRMessageTemplate->mMemberBlocks.empty())
 	{
 		lldebugs << "Empty message '" << mCurrentRMessageTemplate->mName << "' (no blocks)" << llendl;
@@ -819,9 +835,56 @@ bool LLTemplateMessageReader::isUdpBanned() const
 //virtual 
 void LLTemplateMessageReader::copyToBuilder(LLMessageBuilder& builder) const
 {
-	if(NULL == mCurrentRMessageTemplate)
+	if(NULL == mCurrentRMessageTemplate || NULL == mReceiveBuffer)
     {
         return;
     }
-	builder.copyFromMessageData(*mCurrentRMessageData);
+	LLMsgData* data = createMessageData();
+	builder.copyFromMessageData(*data);
+	delete data;
+}
+
+LLMsgData* LLTemplateMessageReader::createMessageData() const
+{
+	LLMsgData* data = new LLMsgData(mCurrentRMessageTemplate->mName);
+
+	S32 block = 0;
+	LLMessageTemplate::message_block_map_t::const_iterator iter;
+	for(iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
+		iter != mCurrentRMessageTemplate->mMemberBlocks.end() && block < (S32)mBlockSpans.size();
+		++iter, ++block)
+	{
+		const LLMessageBlock* mbci = *iter;
+		const BlockSpans& block_spans = mBlockSpans[block];
+		S32 var_index = block_spans.mFirstVar;
+
+		for (S32 i = 0; i < block_spans.mCount; i++)
+		{
+			LLMsgBlkData* cur_data_block = new LLMsgBlkData(mbci->mName, block_spans.mCount);
+			// build new name to prevent collisions
+			cur_data_block->mName = mbci->mName + i;
+			data->addBlock(cur_data_block);
+
+			for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = 
+					 mbci->mMemberVariables.begin();
+				 var_iter != mbci->mMemberVariables.end(); ++var_iter, ++var_index)
+			{
+				const LLMessageVariable& mvci = **var_iter;
+				const VarSpan& span = mVarSpans[var_index];
+
+				cur_data_block->addVariable(mvci.getName(), mvci.getType());
+				if (span.mOffset < 0)
+				{
+					std::vector<U8> zeros(span.mSize, 0);
+					cur_data_block->addData(mvci.getName(), &zeros[0], span.mSize, mvci.getType());
+				}
+				else
+				{
+					cur_data_block->addData(mvci.getName(), &mReceiveBuffer[span.mOffset], 
+											span.mSize, mvci.getType());
+				}
+			}
+		}
+	}
+	return data;
 }
@@ -30,10 +30,17 @@
 #include "llmessagereader.h"
 
 #include <map>
+#include <vector>
 
 class LLMessageTemplate;
 class LLMsgData;
 
+// Decoding a message does not copy its variables: the reader keeps the
+// offset and size of each one in the receive buffer and the getters copy
+// straight out of it. The buffer passed to readMessage() must therefore
+// stay untouched until the message is cleared, which holds for the
+// message system's own receive buffers and for anything that reads a
+// message within the handler call.
 class LLTemplateMessageReader : public LLMessageReader
 {
 public:
@@ -111,6 +118,13 @@ private:
 	void getData(const char *blockname, const char *varname, void *datap, 
 				 S32 size = 0, S32 blocknum = 0, S32 max_size = S32_MAX);
 
+	// Index of blockname in the current template, or -1
+	S32 findBlock(const char *blockname) const;
+	// Index of varname in the block of the current template, or -1
+	S32 findVariable(S32 block, const char *varname) const;
+	// Where variable var of instance blocknum of block was decoded
+	S32 getVarIndex(S32 block, S32 blocknum, S32 var) const;
+
 	BOOL decodeTemplate(const U8* buffer, S32 buffer_size,  // inputs
 						LLMessageTemplate** msg_template ); // outputs
 
@@ -118,9 +132,31 @@ private:
 
 	BOOL decodeData(const U8* buffer, const LLHost& sender );
 
+	// Rebuilds the copied form of the current message
+	LLMsgData* createMessageData() const;
+
+	// A variable of the current message. mOffset is the start of its data
+	// in mReceiveBuffer, or -1 if it ran off the end of the packet and
+	// reads as zeros.
+	struct VarSpan
+	{
+		S32 mOffset;
+		S32 mSize;
+	};
+
+	// The instances of one template block. Instance i has its variables,
+	// in template order, from mVarSpans[mFirstVar + i * variable count].
+	struct BlockSpans
+	{
+		S32 mFirstVar;
+		S32 mCount;
+	};
+
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
-	LLMsgData* mCurrentRMessageData;
+	const U8* mReceiveBuffer;
+	std::vector<BlockSpans> mBlockSpans;
+	std::vector<VarSpan> mVarSpans;
 	message_template_number_map_t& mMessageNumbers;
 };
 
@@ -319,6 +319,7 @@ LLMessageSystem::LLMessageSystem(const std::string& filename, U32 port,
 	mMaxMessageTime   = 1.f;
 
 	mTrueReceiveSize = 0;
+	mPacketCaptureFile = NULL;
 
 	mReceiveTime = 0.f;
 }
@@ -361,10 +362,15 @@ void LLMessageSystem::loadTemplateFile(const std::string& filename, bool failure
 
 LLMessageSystem::~LLMessageSystem()
 {
+	stopPacketCapture();
+
 	mMessageTemplates.clear(); // don't delete templates.
 	for_each(mMessageNumbers.begin(), mMessageNumbers.end(), DeletePairedPointer());
 	mMessageNumbers.clear();
 	
+	// the receive thread has to be done with the socket before it closes
+	mPacketRing.stopReceiveThread();
+
 	if (!mbError)
 	{
 		end_net(mSocket);
@@ -405,6 +411,17 @@ void LLMessageSystem::clearReceiveState()
 
 BOOL LLMessageSystem::poll(F32 seconds)
 {
+	if (mPacketRing.hasReceiveThread())
+	{
+		// The socket belongs to the receive thread, wait on its ring
+		LLTimer timer;
+		while (!mPacketRing.hasReceivedPackets() && timer.getElapsedTimeF32() < seconds)
+		{
+			ms_sleep(1);
+		}
+		return mPacketRing.hasReceivedPackets();
+	}
+
 	S32 num_socks;
 	apr_status_t status;
 	status = apr_poll(&(mPollInfop->mPollFD), 1, &num_socks,(U64)(seconds*1000000.f));
@@ -556,6 +573,16 @@ BOOL LLMessageSystem::checkMessages( S64 frame_count )
 		mTrueReceiveSize = mPacketRing.receivePacket(mSocket, (char *)mTrueReceiveBuffer);
 		// If you want to dump all received packets into SecondLife.log, uncomment this
 		//dumpPacketToLog();
+		if (mPacketCaptureFile && mTrueReceiveSize > 0)
+		{
+			U32 size = htonl((U32)mTrueReceiveSize);
+			if (fwrite(&size, sizeof(size), 1, mPacketCaptureFile) != 1
+				|| fwrite(mTrueReceiveBuffer, mTrueReceiveSize, 1, mPacketCaptureFile) != 1)
+			{
+				LL_WARNS("Messaging") << "Packet capture write failed, stopping capture" << llendl;
+				stopPacketCapture();
+			}
+		}
 		
 		receive_size = mTrueReceiveSize;
 		mLastSender = mPacketRing.getLastSender();
@@ -740,7 +767,7 @@ BOOL LLMessageSystem::checkMessages( S64 frame_count )
 				if (cdp && recv_reliable)
 				{
 					// Add to the recently received list for duplicate suppression
-					cdp->mRecentlyReceivedReliablePackets[mCurrentRecvPacketID] = getMessageTimeUsecs();
+					cdp->mRecentlyReceivedReliablePackets.set(mCurrentRecvPacketID, getMessageTimeUsecs());
 
 					// Put it onto the list of packets to be acked
 					cdp->collectRAck(mCurrentRecvPacketID);
@@ -2869,6 +2896,89 @@ S32 LLMessageSystem::zeroCodeAdjustCurrentSendTotal()
 
 
 
+// Index of the first zero byte of p, or len if there is none. Looks at a
+// word at a time, packets are mostly runs of non zero bytes.
+static inline S32 find_zero_byte(const U8* p, S32 len)
+{
+	const U64 low_bits = U64L(0x0101010101010101);
+	const U64 high_bits = U64L(0x8080808080808080);
+
+	S32 i = 0;
+	for (; i + 8 <= len; i += 8)
+	{
+		U64 word;
+		memcpy(&word, p + i, sizeof(word));		/* Flawfinder: ignore */
+		if ((word - low_bits) & ~word & high_bits)
+		{
+			break;
+		}
+	}
+	while (i < len && p[i])
+	{
+		++i;
+	}
+	return i;
+}
+
+//static
+S32 LLMessageSystem::zeroCodeExpandBuffer(const U8* in, S32 in_size, U8* out, S32 out_size)
+{
+	if (in_size < LL_PACKET_ID_SIZE || out_size < LL_PACKET_ID_SIZE)
+	{
+		return -1;
+	}
+
+	// skip the packet id field
+	memcpy(out, in, LL_PACKET_ID_SIZE);		/* Flawfinder: ignore */
+	const U8* inptr = in + LL_PACKET_ID_SIZE;
+	const U8* inend = in + in_size;
+	U8* outptr = out + LL_PACKET_ID_SIZE;
+	U8* outend = out + out_size;
+
+	// sequential zero bytes are encoded as 0 [U8 count] 
+	// with 0 0 [count] representing wrap (>256 zeroes)
+
+	while (inptr < inend)
+	{
+		// copy up to the next zero as one block
+		S32 literal = find_zero_byte(inptr, (S32)(inend - inptr));
+		if (literal > outend - outptr)
+		{
+			return -1;
+		}
+		memcpy(outptr, inptr, literal);		/* Flawfinder: ignore */
+		inptr += literal;
+		outptr += literal;
+		if (inptr == inend)
+		{
+			break;
+		}
+
+		// 0, then a 0 for every 256 zeroes, then the count. A 0 at the
+		// end of the packet stands for itself.
+		++inptr;
+		S32 zeroes = 1;
+		while (inptr < inend && !*inptr)
+		{
+			zeroes += 256;
+			++inptr;
+		}
+		if (inptr < inend)
+		{
+			zeroes += *inptr - 1;
+			++inptr;
+		}
+		if (zeroes > outend - outptr)
+		{
+			return -1;
+		}
+		memset(outptr, 0, zeroes);
+		outptr += zeroes;
+	}
+
+	return (S32)(outptr - out);
+}
+
 S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 {
 	if ((*data_size ) < LL_MINIMUM_VALID_PACKET_SIZE)
@@ -2891,72 +3001,16 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 	
 	*data[0] &= (~LL_ZERO_CODE_FLAG);
 
-	S32 count = (*data_size);  
-	
-	U8 *inptr = (U8 *)*data;
-	U8 *outptr = (U8 *)mEncodedRecvBuffer;
-
-// skip the packet id field
-
-	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+	S32 out_size = zeroCodeExpandBuffer(*data, in_size, mEncodedRecvBuffer, MAX_BUFFER_SIZE);
+	if (out_size < 0)
 	{
-		count--;
-		*outptr++ = *inptr++;
-	}
-
-// reconstruct encoded packet, keeping track of net size gain
-
-// sequential zero bytes are encoded as 0 [U8 count] 
-// with 0 0 [count] representing wrap (>256 zeroes)
-
-	while (count--)
-	{
-		if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-1]))
-		{
-			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << llendl;
-			callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-			outptr = mEncodedRecvBuffer;					
-			break;
-		}
-		if (!((*outptr++ = *inptr++)))
-		{
-			while (((count--)) && (!(*inptr)))
-			{
-				*outptr++ = *inptr++;
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-256]))
-  				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << llendl;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;
-					count = -1;
-					break;
-  				}
-				memset(outptr,0,255);
-				outptr += 255;
-			}
-			
-			if (count < 0)
-			{
-				break;
-			}
-
-			else
-			{
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-(*inptr)]))
-				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << llendl;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;					
-				}
-				memset(outptr,0,(*inptr) - 1);
-				outptr += ((*inptr) - 1);
-				inptr++;
-			}
-		}		
+		LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size" << llendl;
+		callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
+		out_size = 0;
 	}
 	
 	*data = mEncodedRecvBuffer;
-	*data_size = (S32)(outptr - mEncodedRecvBuffer);
+	*data_size = out_size;
 	mUncompressedBytesIn += *data_size;
 
 	return(in_size);
@@ -3364,6 +3418,46 @@ void LLMessageSystem::establishBidirectionalTrust(const LLHost &host, S64 frame_
 }
 
 
+bool LLMessageSystem::startPacketCapture(const std::string& filename)
+{
+	stopPacketCapture();
+	mPacketCaptureFile = LLFile::fopen(filename, "wb");	/* Flawfinder: ignore */
+	if (!mPacketCaptureFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet capture " << filename << llendl;
+		return false;
+	}
+	LL_INFOS("Messaging") << "Capturing received packets to " << filename << llendl;
+	return true;
+}
+
+void LLMessageSystem::stopPacketCapture()
+{
+	if (mPacketCaptureFile)
+	{
+		fclose(mPacketCaptureFile);
+		mPacketCaptureFile = NULL;
+	}
+}
+
+//static
+bool LLMessageSystem::readCapturedPacket(LLFILE* fp, std::vector<U8>& packet)
+{
+	U32 size = 0;
+	if (fread(&size, sizeof(size), 1, fp) != 1)
+	{
+		return false;
+	}
+	size = ntohl(size);
+	if (!size || size > (U32)MAX_BUFFER_SIZE)
+	{
+		LL_WARNS("Messaging") << "Bad packet size " << size << " in capture" << llendl;
+		return false;
+	}
+	packet.resize(size);
+	return fread(&packet[0], size, 1, fp) == 1;
+}
+
 void LLMessageSystem::dumpPacketToLog()
 {
 	LL_WARNS("Messaging") << "Packet Dump from:" << mPacketRing.getLastSender() << llendl;
@@ -335,6 +335,8 @@ public:
 	bool addCircuitCode(U32 code, const LLUUID& session_id);
 
 	BOOL	poll(F32 seconds); // Number of seconds that we want to block waiting for data, returns if data was received
+	// Receive packets on a background thread, see LLPacketReceiveThread
+	void	startReceiveThread()	{ mPacketRing.startReceiveThread(mSocket); }
 	BOOL	checkMessages( S64 frame_count = 0 );
 	void	processAcks();
 
@@ -346,6 +348,14 @@ public:
 
 	void dumpPacketToLog();
 
+	// Appends every received packet, as it came off the wire, to filename:
+	// a 4 byte size in network byte order followed by the packet. The
+	// captures feed the decoding tests and benchmarks.
+	bool startPacketCapture(const std::string& filename);
+	void stopPacketCapture();
+	// Reads the next packet of a capture, returns false at its end
+	static bool readCapturedPacket(LLFILE* fp, std::vector<U8>& packet);
+
 	char	*getMessageName();
 
 	const LLHost& getSender() const;
@@ -458,6 +468,9 @@ public:
 
 	S32     zeroCode(U8 **data, S32 *data_size);
 	S32		zeroCodeExpand(U8 **data, S32 *data_size);
+	// Expands the zero coded packet in into out, copying the packet header
+	// as is. Returns the expanded size, or -1 if it does not fit in out_size.
+	static S32 zeroCodeExpandBuffer(const U8* in, S32 in_size, U8* out, S32 out_size);
 	S32		zeroCodeAdjustCurrentSendTotal();
 
 	// Uses ping-based retry
@@ -779,6 +792,8 @@ private:
 	U8	mTrueReceiveBuffer[MAX_BUFFER_SIZE];
 	S32	mTrueReceiveSize;
 
+	LLFILE*	mPacketCaptureFile;
+
 	// Must be valid during decode
 	
 	BOOL	mbError;
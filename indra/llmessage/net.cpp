@@ -42,6 +42,7 @@
 	#include <arpa/inet.h>
 	#include <fcntl.h>
 	#include <errno.h>
+	#include <sys/select.h>
 #endif
 
 // linden library includes
@@ -526,12 +527,31 @@ void end_net(S32& socket_out)
 }
 
 #if LL_LINUX
+// Destination address of a message received with IP_PKTINFO on
+static void get_destip( struct msghdr *msg, U32 *dstip )
+{
+	struct cmsghdr *cmsgptr;
+	for( cmsgptr = CMSG_FIRSTHDR(msg); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR( msg, cmsgptr ) )
+	{
+		if( cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO )
+		{
+			in_pktinfo *pktinfo = (in_pktinfo *)CMSG_DATA(cmsgptr);
+			if( pktinfo )
+			{
+				// Two choices. routed and specified. ipi_addr is routed, ipi_spec_dst is
+				// routed. We should stay with specified until we go to multiple
+				// interfaces
+				*dstip = pktinfo->ipi_spec_dst.s_addr;
+			}
+		}
+	}
+}
+
 static int recvfrom_destip( int socket, void *buf, int len, struct sockaddr *from, socklen_t *fromlen, U32 *dstip )
 {
 	int size;
 	struct iovec iov[1];
 	char cmsg[CMSG_SPACE(sizeof(struct in_pktinfo))];
-	struct cmsghdr *cmsgptr;
 	struct msghdr msg = {0};
 
 	iov[0].iov_base = buf;
@@ -552,20 +572,7 @@ static int recvfrom_destip( int socket, void *buf, int len, struct sockaddr *fro
 		return -1;
 	}
 
-	for( cmsgptr = CMSG_FIRSTHDR(&msg); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR( &msg, cmsgptr ) )
-	{
-		if( cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO )
-		{
-			in_pktinfo *pktinfo = (in_pktinfo *)CMSG_DATA(cmsgptr);
-			if( pktinfo )
-			{
-				// Two choices. routed and specified. ipi_addr is routed, ipi_spec_dst is
-				// routed. We should stay with specified until we go to multiple
-				// interfaces
-				*dstip = pktinfo->ipi_spec_dst.s_addr;
-			}
-		}
-	}
+	get_destip( &msg, dstip );
 
 	return size;
 }
@@ -663,4 +670,93 @@ BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient,
 
 #endif
 
+// The batched receive below is for the receive thread: unlike
+// receive_packet() it keeps the sender of each packet to itself instead of
+// going through the globals get_sender() reads on the main thread.
+
+BOOL wait_for_packet(int hSocket, S32 timeout_ms)
+{
+	fd_set read_set;
+	FD_ZERO(&read_set);
+	FD_SET(hSocket, &read_set);
+
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+	return select(hSocket + 1, &read_set, NULL, NULL, &timeout) > 0;
+}
+
+S32 receive_packets(int hSocket, char* const* buffers, S32* sizes, LLHost* senders, LLHost* receiving_ifs, S32 count)
+{
+	if (count > MAX_RECEIVE_BATCH)
+	{
+		count = MAX_RECEIVE_BATCH;
+	}
+
+#if LL_LINUX && defined(MSG_WAITFORONE)
+	// One system call for the whole batch
+	struct mmsghdr msgs[MAX_RECEIVE_BATCH];
+	struct iovec iovs[MAX_RECEIVE_BATCH];
+	struct sockaddr_in from[MAX_RECEIVE_BATCH];
+	char cmsgs[MAX_RECEIVE_BATCH][CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+	memset(msgs, 0, sizeof(msgs[0]) * count);
+	for (S32 i = 0; i < count; ++i)
+	{
+		iovs[i].iov_base = buffers[i];
+		iovs[i].iov_len = NET_BUFFER_SIZE;
+		msgs[i].msg_hdr.msg_name = &from[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = cmsgs[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+	}
+
+	int received = recvmmsg(hSocket, msgs, count, MSG_DONTWAIT, NULL);
+	if (received <= 0)
+	{
+		return 0;
+	}
+
+	for (S32 i = 0; i < received; ++i)
+	{
+		U32 dstip = INVALID_HOST_IP_ADDRESS;
+		get_destip(&msgs[i].msg_hdr, &dstip);
+		sizes[i] = msgs[i].msg_len;
+		senders[i] = LLHost(from[i].sin_addr.s_addr, ntohs(from[i].sin_port));
+		receiving_ifs[i] = LLHost(dstip, INVALID_PORT);
+	}
+	return received;
+#else
+	// One call per packet until the socket is drained
+	S32 received = 0;
+	for (; received < count; ++received)
+	{
+		struct sockaddr_in from;
+#if LL_WINDOWS
+		int addr_size = sizeof(from);
+#else
+		socklen_t addr_size = sizeof(from);
+#endif
+		U32 dstip = INVALID_HOST_IP_ADDRESS;
+#if LL_LINUX
+		int size = recvfrom_destip(hSocket, buffers[received], NET_BUFFER_SIZE, (struct sockaddr*)&from, &addr_size, &dstip);
+#else
+		int size = recvfrom(hSocket, buffers[received], NET_BUFFER_SIZE, 0, (struct sockaddr*)&from, &addr_size);
+#endif
+		if (size <= 0)
+		{
+			// Nothing left, or an error receive_packet() would ignore too
+			break;
+		}
+		sizes[received] = size;
+		senders[received] = LLHost(from.sin_addr.s_addr, ntohs(from.sin_port));
+		receiving_ifs[received] = LLHost(dstip, INVALID_PORT);
+	}
+	return received;
+#endif
+}
+
 //EOF
@@ -45,6 +45,16 @@ S32		receive_packet(int hSocket, char * receiveBuffer);
 
 BOOL	send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);	// Returns TRUE on success.
 
+// Waits up to timeout_ms for the socket to become readable
+BOOL	wait_for_packet(int hSocket, S32 timeout_ms);
+
+// Receives up to count packets without blocking, with a single recvmmsg() where
+// available. Each of buffers holds NET_BUFFER_SIZE bytes. Returns the number
+// received, and their sizes, senders and receiving interfaces. Safe to call
+// from a thread other than the one using receive_packet().
+const S32 MAX_RECEIVE_BATCH = 32;
+S32		receive_packets(int hSocket, char* const* buffers, S32* sizes, LLHost* senders, LLHost* receiving_ifs, S32 count);
+
 //void	get_sender(char * tmp);
 LLHost  get_sender();
 U32		get_sender_port();
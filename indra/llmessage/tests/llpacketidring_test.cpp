@@ -0,0 +1,214 @@
+/**
+ * @file llpacketidring_test.cpp
+ * @brief LLPacketIDRing tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketidring.h"
+
+#include <map>
+
+#include "llrand.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	typedef LLPacketIDRing<U32> id_ring;
+
+	struct packet_id_ring_data
+	{
+		// Walks the ring oldest first
+		static std::vector<TPACKETID> getIDs(id_ring& ring)
+		{
+			std::vector<TPACKETID> ids;
+			TPACKETID id = ring.getFirstID();
+			for (U32 n = ring.getSpan(); n; --n, id = id_ring::nextID(id))
+			{
+				if (ring.find(id))
+				{
+					ids.push_back(id);
+				}
+			}
+			return ids;
+		}
+	};
+	typedef test_group<packet_id_ring_data> packet_id_ring_test;
+	typedef packet_id_ring_test::object packet_id_ring_object;
+	tut::packet_id_ring_test packet_id_ring_testcase("LLPacketIDRing");
+
+	template<> template<>
+	void packet_id_ring_object::test<1>()
+	{
+		// Set, find and erase
+		id_ring ring(4);
+		ensure("empty", ring.empty());
+		ensure("find on empty", ring.find(0) == NULL);
+
+		for (U32 id = 10; id < 20; ++id)
+		{
+			ensure("set", ring.set(id, id * 2));
+		}
+		ensure_equals("size", ring.size(), 10);
+		ensure_equals("first", ring.getFirstID(), (TPACKETID)10);
+		ensure_equals("span", ring.getSpan(), (U32)10);
+		ensure("grown", ring.getCapacity() >= 10);
+		ensure_equals("value", *ring.find(15), (U32)30);
+		ensure("before first", !ring.has(9));
+		ensure("after last", !ring.has(20));
+
+		ring.set(15, 7);
+		ensure_equals("replaced", *ring.find(15), (U32)7);
+		ensure_equals("size after replace", ring.size(), 10);
+
+		// Erasing from the middle keeps the span, the ends shrink it
+		ensure("erase middle", ring.erase(12));
+		ensure("erased", !ring.has(12));
+		ensure("erase twice", !ring.erase(12));
+		ensure_equals("span after middle", ring.getSpan(), (U32)10);
+		ensure("erase first", ring.erase(10));
+		ensure("erase second", ring.erase(11));
+		ensure_equals("first after erase", ring.getFirstID(), (TPACKETID)13);
+		ensure("erase last", ring.erase(19));
+		ensure_equals("span after erase", ring.getSpan(), (U32)6);
+
+		// Earlier IDs extend the ring backwards
+		ensure("set earlier", ring.set(5, 1));
+		ensure_equals("first after earlier", ring.getFirstID(), (TPACKETID)5);
+		ensure_equals("span after earlier", ring.getSpan(), (U32)14);
+		ensure_equals("value after grow", *ring.find(15), (U32)7);
+
+		U32 capacity = ring.getCapacity();
+		ring.clear();
+		ensure("clear", ring.empty());
+		ensure("cleared", !ring.has(15));
+		ensure_equals("clear keeps capacity", ring.getCapacity(), capacity);
+	}
+
+	template<> template<>
+	void packet_id_ring_object::test<2>()
+	{
+		// Packet IDs wrap at 24 bits
+		const TPACKETID last_id = id_ring::ID_MASK;
+		id_ring ring;
+		ring.set(last_id - 1, 1);
+		ring.set(last_id, 2);
+		ring.set(0, 3);
+		ring.set(1, 4);
+
+		ensure("wrapped order", id_ring::isBefore(last_id, 0));
+		ensure("not before", !id_ring::isBefore(0, last_id));
+		ensure_equals("first", ring.getFirstID(), last_id - 1);
+		ensure_equals("span", ring.getSpan(), (U32)4);
+		std::vector<TPACKETID> ids = getIDs(ring);
+		ensure_equals("count", ids.size(), (size_t)4);
+		ensure_equals("oldest", ids[0], last_id - 1);
+		ensure_equals("newest", ids[3], (TPACKETID)1);
+
+		ring.eraseBefore(0);
+		ensure_equals("size after eraseBefore", ring.size(), 2);
+		ensure_equals("first after eraseBefore", ring.getFirstID(), (TPACKETID)0);
+		ensure_equals("value", *ring.find(1), (U32)4);
+	}
+
+	template<> template<>
+	void packet_id_ring_object::test<3>()
+	{
+		// A limited span drops the oldest entries, and refuses older IDs
+		id_ring ring(8, 16);
+		for (U32 id = 0; id < 16; ++id)
+		{
+			ring.set(id, id);
+		}
+		ensure("set past the span", ring.set(20, 20));
+		ensure_equals("first", ring.getFirstID(), (TPACKETID)5);
+		ensure("dropped", !ring.has(4));
+		ensure("kept", ring.has(5));
+		ensure("refused", !ring.set(3, 3));
+		ensure("not stored", !ring.has(3));
+		ensure_equals("capacity", ring.getCapacity(), (U32)16);
+	}
+
+	template<> template<>
+	void packet_id_ring_object::test<4>()
+	{
+		// Random traffic matches std::map, in packet ID order across a wrap
+		typedef std::map<U32, U32> ref_map;
+		ref_map ref;
+		id_ring ring(16);
+
+		// Work in offsets from base, so the map orders like the ring
+		const TPACKETID base = id_ring::ID_MASK - 500;
+		U32 next = 0;
+		for (S32 i = 0; i < 20000; ++i)
+		{
+			S32 op = ll_rand(10);
+			if (op < 4)
+			{
+				// New packet, maybe skipping a few IDs
+				next += 1 + ll_rand(3);
+				ring.set((base + next) & id_ring::ID_MASK, i);
+				ref[next] = i;
+			}
+			else if (op < 8 && !ref.empty())
+			{
+				// Ack something still around, most likely an old one
+				ref_map::iterator it = ref.begin();
+				for (S32 skip = ll_rand(4); skip && it != ref.end(); --skip)
+				{
+					++it;
+				}
+				if (it == ref.end())
+				{
+					it = ref.begin();
+				}
+				ensure("erase", ring.erase((base + it->first) & id_ring::ID_MASK));
+				ref.erase(it);
+			}
+			else if (next > 100)
+			{
+				// Re-add something older than anything around
+				U32 offset = next - 100 + ll_rand(100);
+				if (ref.empty() || offset < ref.begin()->first)
+				{
+					ring.set((base + offset) & id_ring::ID_MASK, i);
+					ref[offset] = i;
+				}
+			}
+
+			ensure_equals("size", ring.size(), (S32)ref.size());
+		}
+
+		std::vector<TPACKETID> ids = getIDs(ring);
+		ensure_equals("walk size", ids.size(), ref.size());
+		size_t n = 0;
+		for (ref_map::iterator it = ref.begin(); it != ref.end(); ++it, ++n)
+		{
+			TPACKETID id = (base + it->first) & id_ring::ID_MASK;
+			ensure_equals("walk order", ids[n], id);
+			ensure_equals("walk value", *ring.find(id), it->second);
+		}
+	}
+}
@@ -0,0 +1,169 @@
+/**
+ * @file llpacketreceivethread_test.cpp
+ * @brief LLPacketReceiveThread tests
+ *
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketreceivethread.h"
+
+#include "../llpacketbuffer.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+#if !LL_WINDOWS
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace tut
+{
+	struct packet_receive_thread_data
+	{
+		packet_receive_thread_data() : mReceiveSocket(-1), mSendSocket(-1)
+		{
+#if !LL_WINDOWS
+			// a non blocking receiver on a free loopback port, like start_net() makes
+			mReceiveSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			memset(&mAddress, 0, sizeof(mAddress));
+			mAddress.sin_family = AF_INET;
+			mAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			mAddress.sin_port = 0;
+			bind(mReceiveSocket, (struct sockaddr*)&mAddress, sizeof(mAddress));
+			socklen_t len = sizeof(mAddress);
+			getsockname(mReceiveSocket, (struct sockaddr*)&mAddress, &len);
+			fcntl(mReceiveSocket, F_SETFL, O_NONBLOCK);
+			int rec_size = 400000;
+			setsockopt(mReceiveSocket, SOL_SOCKET, SO_RCVBUF, (char *)&rec_size, sizeof(rec_size));
+
+			mSendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#endif
+		}
+
+		~packet_receive_thread_data()
+		{
+#if !LL_WINDOWS
+			close(mReceiveSocket);
+			close(mSendSocket);
+#endif
+		}
+
+		// Sends count packets numbered from first, of varying sizes
+		void sendPackets(U32 first, U32 count)
+		{
+#if !LL_WINDOWS
+			char buffer[MTUBYTES];
+			for (U32 i = first; i < first + count; ++i)
+			{
+				S32 size = sizeof(U32) + 1 + (i % 7) * 100;
+				memset(buffer, (U8)i, size);
+				memcpy(buffer, &i, sizeof(U32));	/* Flawfinder: ignore */
+				sendto(mSendSocket, buffer, size, 0, (struct sockaddr*)&mAddress, sizeof(mAddress));
+				if (!(i % 32))
+				{
+					// let the receiver keep up, loopback drops too
+					ms_sleep(1);
+				}
+			}
+#endif
+		}
+
+		// Consumes packets until count arrived or a few seconds passed,
+		// checking they come in order and intact. Returns the count received.
+		U32 receivePackets(LLPacketReceiveThread& thread, U32 first, U32 count)
+		{
+			U32 received = 0;
+			U32 last = first - 1;
+			LLTimer timer;
+			while (received < count && timer.getElapsedTimeF32() < 5.f)
+			{
+				const LLPacketBuffer* packetp = thread.getPacket();
+				if (!packetp)
+				{
+					ms_sleep(1);
+					continue;
+				}
+				U32 number;
+				memcpy(&number, packetp->getData(), sizeof(U32));	/* Flawfinder: ignore */
+				ensure("Ensure packets in order", received == 0 || number > last);
+				ensure_equals("Ensure packet size", packetp->getSize(), (S32)(sizeof(U32) + 1 + (number % 7) * 100));
+				ensure_equals("Ensure packet data", (U8)packetp->getData()[packetp->getSize() - 1], (U8)number);
+				ensure("Ensure sender", packetp->getHost().getAddress() == htonl(INADDR_LOOPBACK));
+				last = number;
+				++received;
+				thread.popPacket();
+			}
+			return received;
+		}
+
+		S32 mReceiveSocket;
+		S32 mSendSocket;
+#if !LL_WINDOWS
+		struct sockaddr_in mAddress;
+#endif
+	};
+	typedef test_group<packet_receive_thread_data> packet_receive_thread_test;
+	typedef packet_receive_thread_test::object packet_receive_thread_object;
+	tut::packet_receive_thread_test packet_receive_thread_testcase("LLPacketReceiveThread");
+
+	template<> template<>
+	void packet_receive_thread_object::test<1>()
+	{
+#if LL_WINDOWS
+		skip("uses BSD sockets");
+#endif
+		// Batched receives in order through the ring
+		LLPacketReceiveThread thread(mReceiveSocket);
+		thread.start();
+		ensure("Ensure nothing received yet", thread.getPacket() == NULL);
+		const U32 count = 500;
+		sendPackets(1, count);
+		U32 received = receivePackets(thread, 1, count);
+		ensure_equals("Ensure all packets received", received, count);
+		ensure_equals("Ensure ring drained", thread.getPendingCount(), (U32)0);
+	}
+
+	template<> template<>
+	void packet_receive_thread_object::test<2>()
+	{
+#if LL_WINDOWS
+		skip("uses BSD sockets");
+#endif
+		// A ring smaller than the burst fills up and wraps, the rest of the
+		// packets wait in the socket until the consumer catches up
+		LLPacketReceiveThread thread(mReceiveSocket, 8);
+		thread.start();
+		const U32 count = 100;
+		sendPackets(1, count);
+		ms_sleep(50);
+		ensure("Ensure the ring stops at its size", thread.getPendingCount() <= 8);
+		U32 received = receivePackets(thread, 1, count);
+		ensure_equals("Ensure all packets received", received, count);
+	}
+}
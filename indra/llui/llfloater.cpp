@@ -253,6 +253,9 @@ LLFloater::LLFloater(const LLSD& key, const LLFloater::Params& p)
 	mHandle.bind(this);
 //	mNotificationContext = new LLFloaterNotificationContext(getHandle());
 
+	// Widgets are looked up by name all through a floater's life
+	enableNameIndex();
+
 	// Clicks stop here.
 	setMouseOpaque(TRUE);
 	
@@ -32,6 +32,10 @@
 #include "llfloater.h"
 #include "llmultifloater.h"
 #include "llfloaterreglistener.h"
+#include "llsdserialize.h"
+#include "lltimer.h"
+
+#include <algorithm>
 
 //*******************************************************
 
@@ -42,6 +46,13 @@ LLFloaterReg::build_map_t LLFloaterReg::sBuildMap;
 std::map<std::string,std::string> LLFloaterReg::sGroupMap;
 bool LLFloaterReg::sBlockShowFloaters = false;
 std::set<std::string> LLFloaterReg::sAlwaysShowableList;
+LLFloaterReg::usage_map_t LLFloaterReg::sUsageMap;
+std::list<std::string> LLFloaterReg::sPrebuildQueue;
+
+// Each session, the uses of earlier sessions count for this much less
+static const F32 USAGE_DECAY = 0.75f;
+// Below this a floater type is forgotten
+static const F32 MIN_USAGE = 0.1f;
 
 static LLFloaterRegListener sFloaterRegListener;
 
@@ -221,6 +232,11 @@ LLFloater* LLFloaterReg::showInstance(const std::string& name, const LLSD& key,
 	LLFloater* instance = getInstance(name, key); 
 	if (instance) 
 	{
+		// Only unkeyed floaters can be built ahead of time
+		if (key.isUndefined())
+		{
+			sUsageMap[name] += 1.f;
+		}
 		instance->openFloater(key);
 		if (focus)
 			instance->setFocus(TRUE);
@@ -410,6 +426,96 @@ void LLFloaterReg::registerControlVariables()
 	}
 }
 
+//static
+bool LLFloaterReg::loadUsage(const std::string& filename)
+{
+	LLSD usage;
+	llifstream file(filename);
+	if (!file.is_open() || LLSDSerialize::fromXML(usage, file) <= 0)
+	{
+		return false;
+	}
+	for (LLSD::map_const_iterator iter = usage.beginMap(); iter != usage.endMap(); ++iter)
+	{
+		F32 uses = (F32)iter->second.asReal() * USAGE_DECAY;
+		if (uses >= MIN_USAGE && sBuildMap.find(iter->first) != sBuildMap.end())
+		{
+			sUsageMap[iter->first] += uses;
+		}
+	}
+	return true;
+}
+
+//static
+bool LLFloaterReg::saveUsage(const std::string& filename)
+{
+	LLSD usage = LLSD::emptyMap();
+	for (usage_map_t::iterator iter = sUsageMap.begin(); iter != sUsageMap.end(); ++iter)
+	{
+		usage[iter->first] = iter->second;
+	}
+	llofstream file(filename);
+	if (!file.is_open())
+	{
+		llwarns << "Unable to open " << filename << " for output." << llendl;
+		return false;
+	}
+	LLSDSerialize::toPrettyXML(usage, file);
+	return true;
+}
+
+static bool more_used(const std::pair<F32, std::string>& a, const std::pair<F32, std::string>& b)
+{
+	return a.first > b.first;
+}
+
+//static
+void LLFloaterReg::queuePrebuild(U32 max_floaters, F32 min_uses)
+{
+	std::vector<std::pair<F32, std::string> > candidates;
+	for (usage_map_t::iterator iter = sUsageMap.begin(); iter != sUsageMap.end(); ++iter)
+	{
+		if (iter->second >= min_uses)
+		{
+			candidates.push_back(std::make_pair(iter->second, iter->first));
+		}
+	}
+	std::stable_sort(candidates.begin(), candidates.end(), more_used);
+	if (candidates.size() > max_floaters)
+	{
+		candidates.resize(max_floaters);
+	}
+
+	sPrebuildQueue.clear();
+	for (U32 i = 0; i < candidates.size(); ++i)
+	{
+		sPrebuildQueue.push_back(candidates[i].second);
+	}
+}
+
+//static
+bool LLFloaterReg::prebuildInstances(F32 max_time)
+{
+	LLTimer timer;
+	while (!sPrebuildQueue.empty())
+	{
+		std::string name = sPrebuildQueue.front();
+		sPrebuildQueue.pop_front();
+		// Already shown, or built by someone else
+		if (findInstance(name))
+		{
+			continue;
+		}
+		lldebugs << "Prebuilding floater " << name << llendl;
+		getInstance(name);
+		if (timer.getElapsedTimeF32() >= max_time)
+		{
+			break;
+		}
+	}
+	return !sPrebuildQueue.empty();
+}
+
 // Callbacks
 
 // static
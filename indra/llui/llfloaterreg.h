@@ -62,6 +62,8 @@ public:
 		std::string mFile;
 	};
 	typedef std::map<std::string, BuildData> build_map_t;
+	// How often each floater type has been opened, with older sessions counting for less
+	typedef std::map<std::string, F32> usage_map_t;
 	
 private:
 	friend class LLFloaterRegListener;
@@ -74,6 +76,8 @@ private:
 	 * Defines list of floater names that can be shown despite state of sBlockShowFloaters.
 	 */
 	static std::set<std::string> sAlwaysShowableList;
+	static usage_map_t sUsageMap;
+	static std::list<std::string> sPrebuildQueue;
 	
 public:
 	// Registration
@@ -126,6 +130,18 @@ public:
 
 	static void registerControlVariables();
 
+	// Usage statistics, persisted between sessions
+	static bool loadUsage(const std::string& filename);
+	static bool saveUsage(const std::string& filename);
+
+	// Prebuilding: builds the most used floaters ahead of their first show, so
+	// it doesn't hitch. Queues up to max_floaters types opened at least
+	// min_uses times (recently).
+	static void queuePrebuild(U32 max_floaters, F32 min_uses);
+	// Builds queued floaters until max_time seconds have passed, at least one.
+	// Returns false once the queue is empty.
+	static bool prebuildInstances(F32 max_time);
+
 	// Callback wrappers
 	static void initUICtrlToFloaterVisibilityControl(LLUICtrl* ctrl, const LLSD& sdname);
 	static void showFloaterInstance(const LLSD& sdname);
@@ -970,6 +970,8 @@ LLMenuItemBranchGL::LLMenuItemBranchGL(const LLMenuItemBranchGL::Params& p)
 		branch->setVisible(FALSE);
 		branch->setParentMenuItem(this);
 	}
+	// The branch menu isn't a child of this item, but findChildView() looks in it
+	setUnindexedLookup();
 }
 
 LLMenuItemBranchGL::~LLMenuItemBranchGL()
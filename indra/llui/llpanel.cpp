@@ -998,6 +998,9 @@ BOOL LLPanel::buildFromFile(const std::string& filename, LLXMLNodePtr output_nod
 
 	lldebugs << "Building panel " << filename << llendl;
 
+	// Panels with their own file look up their widgets by name
+	enableNameIndex();
+
 	LLUICtrlFactory::instance().pushFileName(filename);
 	{
 		if (!getFactoryMap().empty())
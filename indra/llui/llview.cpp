@@ -115,6 +115,8 @@ LLView::Params::Params()
 LLView::LLView(const LLView::Params& p)
 :	mName(p.name),
 	mParentView(NULL),
+	mNameIndex(NULL),
+	mNumUnindexed(0),
 	mReshapeFlags(FOLLOWS_NONE),
 	mFromXUI(p.from_xui),
 	mIsFocusRoot(FALSE),
@@ -168,6 +170,9 @@ LLView::~LLView()
 		delete mDefaultWidgets;
 		mDefaultWidgets = NULL;
 	}
+
+	delete mNameIndex;
+	mNameIndex = NULL;
 }
 
 // virtual
@@ -291,6 +296,11 @@ bool LLView::addChild(LLView* child, S32 tab_group)
 
 	// add to front of child list, as normal
 	mChildList.push_front(child);
+	updateNameIndexes(child, true);
+	for (LLView* viewp = this; viewp; viewp = viewp->mParentView)
+	{
+		viewp->mNumUnindexed += child->mNumUnindexed;
+	}
 
 	// add to ctrl list if is LLUICtrl
 	if (child->isCtrl())
@@ -320,6 +330,83 @@ bool LLView::addChildInBack(LLView* child, S32 tab_group)
 	return false;
 }
 
+void LLView::enableNameIndex()
+{
+	if (mNameIndex)
+	{
+		return;
+	}
+	mNameIndex = new name_index_t;
+	for (child_list_const_iter_t it = mChildList.begin(); it != mChildList.end(); ++it)
+	{
+		indexSubtree(*it, true);
+	}
+}
+
+void LLView::updateNameIndexes(LLView* view, bool add)
+{
+	for (LLView* viewp = this; viewp; viewp = viewp->mParentView)
+	{
+		if (viewp->mNameIndex)
+		{
+			viewp->indexSubtree(view, add);
+		}
+	}
+}
+
+void LLView::indexSubtree(LLView* view, bool add)
+{
+	if (add)
+	{
+		(*mNameIndex)[view->mName].push_back(view);
+	}
+	else
+	{
+		unindexName(view->mName, view);
+	}
+	for (child_list_const_iter_t it = view->mChildList.begin(); it != view->mChildList.end(); ++it)
+	{
+		indexSubtree(*it, add);
+	}
+}
+
+void LLView::unindexName(const std::string& name, LLView* view)
+{
+	name_index_t::iterator found_it = mNameIndex->find(name);
+	if (found_it == mNameIndex->end())
+	{
+		llassert(false);
+		return;
+	}
+	std::vector<LLView*>& views = found_it->second;
+	views.erase(std::remove(views.begin(), views.end(), view), views.end());
+	if (views.empty())
+	{
+		mNameIndex->erase(found_it);
+	}
+}
+
+void LLView::setName(std::string name)
+{
+	for (LLView* viewp = mParentView; viewp; viewp = viewp->mParentView)
+	{
+		if (viewp->mNameIndex)
+		{
+			viewp->unindexName(mName, this);
+			(*viewp->mNameIndex)[name].push_back(this);
+		}
+	}
+	mName = name;
+}
+
+void LLView::setUnindexedLookup()
+{
+	for (LLView* viewp = this; viewp; viewp = viewp->mParentView)
+	{
+		++viewp->mNumUnindexed;
+	}
+}
+
 // remove the specified child from the view, and set it's parent to NULL.
 void LLView::removeChild(LLView* child)
 {
@@ -327,7 +414,12 @@ void LLView::removeChild(LLView* child)
 	if (child->mParentView == this) 
 	{
 		mChildList.remove( child );
+		updateNameIndexes(child, false);
 		child->mParentView = NULL;
+		for (LLView* viewp = this; viewp; viewp = viewp->mParentView)
+		{
+			viewp->mNumUnindexed -= child->mNumUnindexed;
+		}
 		if (child->isCtrl())
 		{
 			child_tab_order_t::iterator found = mCtrlOrder.find(static_cast<LLUICtrl*>(child));
@@ -1704,6 +1796,11 @@ LLView* LLView::findChildView(const std::string& name, BOOL recurse) const
 	//richard: should we allow empty names?
 	//if(name.empty())
 	//	return NULL;
+	LLView* found = NULL;
+	if (findIndexedView(name, recurse, found))
+	{
+		return found;
+	}
 	child_list_const_iter_t child_it;
 	// Look for direct children *first*
 	for ( child_it = mChildList.begin(); child_it != mChildList.end(); ++child_it)
@@ -1732,6 +1829,49 @@ LLView* LLView::findChildView(const std::string& name, BOOL recurse) const
 	return NULL;
 }
 
+bool LLView::findIndexedView(const std::string& name, BOOL recurse, LLView*& found) const
+{
+	if (recurse && mNumUnindexed)
+	{
+		return false;
+	}
+	const LLView* ownerp = this;
+	while (ownerp && !ownerp->mNameIndex)
+	{
+		ownerp = ownerp->mParentView;
+	}
+	if (!ownerp)
+	{
+		return false;
+	}
+
+	// The index holds everything below ownerp, keep what is below us
+	found = NULL;
+	name_index_t::const_iterator found_it = ownerp->mNameIndex->find(name);
+	if (found_it == ownerp->mNameIndex->end())
+	{
+		return true;
+	}
+	const std::vector<LLView*>& views = found_it->second;
+	for (std::vector<LLView*>::const_iterator it = views.begin(); it != views.end(); ++it)
+	{
+		LLView* viewp = *it;
+		if (recurse ? viewp->hasAncestor(this) : viewp->mParentView == this)
+		{
+			if (found)
+			{
+				// Let the search pick the one it reaches first. Each step
+				// down comes back here, so it only enters subtrees that
+				// have the name.
+				found = NULL;
+				return false;
+			}
+			found = viewp;
+		}
+	}
+	return true;
+}
+
 BOOL LLView::parentPointInView(S32 x, S32 y, EHitTestType type) const 
 { 
 	return (getUseBoundingRect() && type == HIT_TEST_USE_BOUNDING_RECT)
@@ -49,6 +49,8 @@
 #include "llfocusmgr.h"
 
 #include <list>
+#include <vector>
+#include <boost/unordered_map.hpp>
 
 class LLSD;
 
@@ -232,7 +234,7 @@ public:
 	void		setFollowsAll()					{ mReshapeFlags |= FOLLOWS_ALL; }
 
 	void        setSoundFlags(U8 flags)			{ mSoundFlags = flags; }
-	void		setName(std::string name)			{ mName = name; }
+	void		setName(std::string name);
 	void		setUseBoundingRect( BOOL use_bounding_rect );
 	BOOL		getUseBoundingRect() const;
 
@@ -545,12 +547,35 @@ protected:
 	LLView* childrenHandleToolTip(S32 x, S32 y, MASK mask);
 
 	ECursorType mHoverCursor;
+
+	// For views whose findChildView() looks at views that aren't their
+	// children, so lookups from above can't skip them
+	void		setUnindexedLookup();
+	// Keeps an index by name of every view below this one, which answers
+	// findChildView() for this view and every view below it. Used by
+	// floaters and panels built from their own file.
+	void		enableNameIndex();
 	
 private:
+	typedef boost::unordered_map<std::string, std::vector<LLView*> > name_index_t;
+
+	// Adds or removes view and the views below it in the name index of
+	// this view and of every ancestor that keeps one
+	void		updateNameIndexes(LLView* view, bool add);
+	void		indexSubtree(LLView* view, bool add);
+	void		unindexName(const std::string& name, LLView* view);
+	// Looks name up in the closest name index, returns false if there is
+	// none or it can't tell which view the search would find first
+	bool		findIndexedView(const std::string& name, BOOL recurse, LLView*& found) const;
 
 	LLView*		mParentView;
 	child_list_t mChildList;
 
+	// See enableNameIndex(), NULL for most views
+	name_index_t* mNameIndex;
+	// Views at or below this one that set setUnindexedLookup()
+	S32			mNumUnindexed;
+
 	std::string	mName;
 	// location in pixels, relative to surrounding structure, bottom,left=0,0
 	LLRect		mRect;
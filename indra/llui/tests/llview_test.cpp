@@ -0,0 +1,297 @@
+/**
+ * @file llview_test.cpp
+ * @brief LLView name lookup tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llview.h"
+#include "llformat.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	LLView::Params params(const std::string& name)
+	{
+		LLView::Params p;
+		p.name = name;
+		return p;
+	}
+
+	// Indexed views are what LLFloater and LLPanel::buildFromFile() make
+	class TestView : public LLView
+	{
+	public:
+		TestView(const std::string& name, bool indexed = false)
+		:	LLView(params(name))
+		{
+			if (indexed)
+			{
+				enableNameIndex();
+			}
+		}
+	};
+
+	// Like LLMenuItemBranchGL, finds a view that isn't its child
+	class RedirectView : public LLView
+	{
+	public:
+		RedirectView(const LLView::Params& p, LLView* target)
+		:	LLView(p),
+			mTarget(target)
+		{
+			setUnindexedLookup();
+		}
+
+		/*virtual*/ LLView* findChildView(const std::string& name, BOOL recurse) const
+		{
+			if (mTarget->getName() == name)
+			{
+				return mTarget;
+			}
+			return LLView::findChildView(name, recurse);
+		}
+
+	private:
+		LLView* mTarget;
+	};
+}
+
+namespace tut
+{
+	struct view_test
+	{
+		// Same tree twice, mViews under an indexed root and mPlainViews
+		// under a plain one, so lookups can be checked against the
+		// unindexed search
+		std::vector<LLView*> mViews;
+		std::vector<LLView*> mPlainViews;
+
+		view_test()
+		{
+			mViews.push_back(new TestView("root", true));
+			mPlainViews.push_back(new TestView("root"));
+		}
+
+		~view_test()
+		{
+			delete mViews[0];
+			delete mPlainViews[0];
+		}
+
+		S32 add(S32 parent, const std::string& name)
+		{
+			mViews.push_back(new TestView(name));
+			mViews[parent]->addChild(mViews.back());
+			mPlainViews.push_back(new TestView(name));
+			mPlainViews[parent]->addChild(mPlainViews.back());
+			return (S32)mViews.size() - 1;
+		}
+
+		S32 indexOf(const std::vector<LLView*>& views, const LLView* view) const
+		{
+			if (!view)
+			{
+				return -1;
+			}
+			std::vector<LLView*>::const_iterator it = std::find(views.begin(), views.end(), view);
+			return it == views.end() ? -2 : (S32)(it - views.begin());
+		}
+
+		S32 find(S32 from, const std::string& name, BOOL recurse = TRUE) const
+		{
+			return indexOf(mViews, mViews[from]->findChildView(name, recurse));
+		}
+
+		// Every view finds what the plain search finds, by every name
+		void ensureSameAsPlain(const std::string& msg, const std::vector<std::string>& names) const
+		{
+			for (S32 from = 0; from < (S32)mViews.size(); ++from)
+			{
+				for (size_t n = 0; n < names.size(); ++n)
+				{
+					for (S32 recurse = 0; recurse < 2; ++recurse)
+					{
+						const S32 indexed = find(from, names[n], recurse);
+						const S32 plain = indexOf(mPlainViews, mPlainViews[from]->findChildView(names[n], recurse));
+						ensure_equals(msg + llformat(": %d finds %s", from, names[n].c_str()), indexed, plain);
+					}
+				}
+			}
+		}
+	};
+
+	typedef test_group<view_test> view_t;
+	typedef view_t::object view_object_t;
+	tut::view_t tut_view("LLView");
+
+	template<> template<>
+	void view_object_t::test<1>()
+	{
+		// Adding views, one at a time and as a subtree built beforehand
+		const S32 panel = add(0, "panel");
+		const S32 button = add(panel, "button");
+		const S32 label = add(panel, "label");
+
+		ensure_equals("recursive", find(0, "button"), button);
+		ensure_equals("from a view below the root", find(panel, "label"), label);
+		ensure_equals("not a direct child", find(0, "button", FALSE), -1);
+		ensure_equals("direct child", find(panel, "button", FALSE), button);
+		ensure_equals("missing", find(0, "missing"), -1);
+		ensure_equals("not below", find(button, "label"), -1);
+		ensure_equals("own name", find(0, "root"), -1);
+
+		LLView* group = new TestView("group");
+		LLView* check = new TestView("check");
+		group->addChild(check);
+		ensure("found before it is added", group->findChildView("check", TRUE) == check);
+		mViews[panel]->addChild(group);
+		ensure("subtree added", mViews[0]->findChildView("check", TRUE) == check);
+		ensure("subtree root added", mViews[0]->findChildView("group", TRUE) == group);
+		ensure("non-owner below the root", mViews[panel]->findChildView("check", TRUE) == check);
+	}
+
+	template<> template<>
+	void view_object_t::test<2>()
+	{
+		// Removing, moving and deleting views
+		const S32 panel = add(0, "panel");
+		const S32 group = add(panel, "group");
+		const S32 check = add(group, "check");
+		const S32 other = add(0, "other");
+
+		mViews[panel]->removeChild(mViews[group]);
+		ensure_equals("removed subtree root", find(0, "group"), -1);
+		ensure_equals("removed subtree", find(0, "check"), -1);
+		ensure_equals("removed view still finds its children", find(group, "check"), check);
+
+		mViews[other]->addChild(mViews[group]);
+		ensure_equals("moved", find(0, "check"), check);
+		ensure_equals("moved, old parent", find(panel, "check"), -1);
+		ensure_equals("moved, new parent", find(other, "check"), check);
+
+		// The destructor takes the view out of its parent
+		delete mViews[check];
+		mPlainViews[check]->getParent()->removeChild(mPlainViews[check]);
+		delete mPlainViews[check];
+		mViews[check] = mPlainViews[check] = NULL;
+		ensure_equals("deleted", find(0, "check"), -1);
+
+		// Deleting an indexed view with children
+		LLView* floater = new TestView("floater", true);
+		LLView* child = new TestView("child");
+		floater->addChild(child);
+		child->addChild(new TestView("grandchild"));
+		mViews[0]->addChild(floater);
+		ensure("nested owner", mViews[0]->findChildView("grandchild", TRUE) != NULL);
+		delete floater;
+		ensure("nested owner deleted", mViews[0]->findChildView("grandchild", TRUE) == NULL);
+		ensure("nested owner deleted, its name", mViews[0]->findChildView("floater", TRUE) == NULL);
+	}
+
+	template<> template<>
+	void view_object_t::test<3>()
+	{
+		// Renaming views, attached or not
+		const S32 panel = add(0, "panel");
+		const S32 button = add(panel, "button");
+
+		mViews[button]->setName("renamed");
+		ensure_equals("old name", find(0, "button"), -1);
+		ensure_equals("new name", find(0, "renamed"), button);
+		ensure_equals("new name, non-recursive", find(panel, "renamed", FALSE), button);
+
+		mViews[panel]->removeChild(mViews[button]);
+		mViews[button]->setName("button");
+		mViews[panel]->addChild(mViews[button]);
+		ensure_equals("renamed while detached", find(0, "button"), button);
+		ensure_equals("renamed while detached, old name", find(0, "renamed"), -1);
+
+		// Renaming an owner leaves its own index alone
+		LLView* floater = new TestView("floater", true);
+		floater->addChild(new TestView("child"));
+		mViews[panel]->addChild(floater);
+		floater->setName("other");
+		ensure("renamed owner", mViews[0]->findChildView("other", TRUE) == floater);
+		ensure("renamed owner, old name", mViews[0]->findChildView("floater", TRUE) == NULL);
+		ensure("renamed owner's children", floater->findChildView("child", TRUE) != NULL);
+	}
+
+	template<> template<>
+	void view_object_t::test<4>()
+	{
+		// With repeated names the search still finds what it always did:
+		// direct children first, then the first child's subtree
+		std::vector<std::string> names;
+		names.push_back("a");
+		names.push_back("b");
+		names.push_back("c");
+		names.push_back("missing");
+
+		for (S32 i = 0; i < 60; ++i)
+		{
+			// A deterministic mix of depths and names
+			const S32 parent = (i * 7) % (S32)mViews.size();
+			add(parent, names[(i * 5 + i / 3) % 3]);
+		}
+		ensureSameAsPlain("built", names);
+
+		for (S32 i = 1; i < (S32)mViews.size(); i += 4)
+		{
+			const std::string name = names[(i + 1) % 3];
+			mViews[i]->setName(name);
+			mPlainViews[i]->setName(name);
+		}
+		ensureSameAsPlain("renamed", names);
+
+		for (S32 i = 3; i < (S32)mViews.size(); i += 9)
+		{
+			const S32 parent = indexOf(mViews, mViews[i]->getParent());
+			mViews[parent]->removeChild(mViews[i]);
+			mPlainViews[parent]->removeChild(mPlainViews[i]);
+			mViews[0]->addChild(mViews[i]);
+			mPlainViews[0]->addChild(mPlainViews[i]);
+		}
+		ensureSameAsPlain("moved", names);
+	}
+
+	template<> template<>
+	void view_object_t::test<5>()
+	{
+		// Views that look outside their children are still searched
+		const S32 panel = add(0, "panel");
+		LLView* target = new TestView("target");
+		LLView* redirect = new RedirectView(params("redirect"), target);
+		mViews[panel]->addChild(redirect);
+		ensure("through the redirect", mViews[0]->findChildView("target", TRUE) == target);
+		ensure("redirect, non-recursive", mViews[0]->findChildView("redirect", FALSE) == NULL);
+		ensure("indexed views still found", mViews[0]->findChildView("redirect", TRUE) == redirect);
+
+		mViews[panel]->removeChild(redirect);
+		ensure("redirect removed", mViews[0]->findChildView("target", TRUE) == NULL);
+		delete redirect;
+		delete target;
+	}
+}
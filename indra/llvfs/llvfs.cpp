@@ -58,12 +58,14 @@ public:
 	{
 		mLocation = 0;
 		mLength = 0;
+		mFreeSlot = -1;
 	}
     
 	LLVFSBlock(U32 loc, S32 size)
 	{
 		mLocation = loc;
 		mLength = size;
+		mFreeSlot = -1;
 	}
     
 	static bool locationSortPredicate(
@@ -76,6 +78,7 @@ public:
 public:
 	U32 mLocation;
 	S32	mLength;		// allocated block size
+	S32 mFreeSlot;		// index in its free bin, -1 if not free
 };
     
 LLVFSFileSpecifier::LLVFSFileSpecifier()
@@ -102,6 +105,25 @@ bool LLVFSFileSpecifier::operator==(const LLVFSFileSpecifier &rhs) const
 	return (mFileID == rhs.mFileID && 
 			mFileType == rhs.mFileType);
 }
+
+LLVFSBulkItem::LLVFSBulkItem()
+:	mFileType(LLAssetType::AT_NONE),
+	mBuffer(NULL),
+	mLocation(0),
+	mLength(0),
+	mBytes(0)
+{
+}
+
+LLVFSBulkItem::LLVFSBulkItem(const LLUUID &file_id, const LLAssetType::EType file_type, U8 *buffer, S32 location, S32 length)
+:	mFileID(file_id),
+	mFileType(file_type),
+	mBuffer(buffer),
+	mLocation(location),
+	mLength(length),
+	mBytes(0)
+{
+}
     
     
 class LLVFSFileBlock : public LLVFSBlock, public LLVFSFileSpecifier
@@ -231,10 +253,13 @@ const S32 LLVFSFileBlock::SERIAL_SIZE = 34;
 
 LLVFS::LLVFS(const std::string& index_filename, const std::string& data_filename, const BOOL read_only, const U32 presize, const BOOL remove_after_crash)
 :	mRemoveAfterCrash(remove_after_crash),
+	mFreeBlockCount(0),
+	mFreeBytes(0),
 	mDataFP(NULL),
 	mIndexFP(NULL)
 {
 	mDataMutex = new LLMutex(0);
+	memset(mFreeBinMask, 0, sizeof(mFreeBinMask));
 
 	S32 i;
 	for (i = 0; i < VFSLOCK_COUNT; i++)
@@ -575,7 +600,10 @@ LLVFS::~LLVFS()
 	}
 	mFileBlocks.clear();
 	
-	mFreeBlocksByLength.clear();
+	for (S32 bin = 0; bin < FREE_BIN_COUNT; bin++)
+	{
+		mFreeBins[bin].clear();
+	}
 
 	for_each(mFreeBlocksByLocation.begin(), mFreeBlocksByLocation.end(), DeletePairedPointer());
     
@@ -743,8 +771,7 @@ BOOL LLVFS::checkAvailable(S32 max_size)
 {
 	lockData();
 	
-	blocks_length_map_t::iterator iter = mFreeBlocksByLength.lower_bound(max_size); // first entry >= size
-	const BOOL res(iter == mFreeBlocksByLength.end() ? FALSE : TRUE);
+	const BOOL res(findFreeBin(max_size) ? TRUE : FALSE);
 
 	unlockData();
 	
@@ -1200,7 +1227,193 @@ S32 LLVFS::storeData(const LLUUID &file_id, const LLAssetType::EType file_type,
 		return 0;
 	}
 }
- 
+
+S32 LLVFS::getDataBulk(vfs_bulk_items_t& items)
+{
+	if (!isValid())
+	{
+		llerrs << "Attempting to use invalid VFS!" << llendl;
+	}
+
+	// (data file location, item)
+	std::vector<std::pair<U32, S32> > reads;
+	reads.reserve(items.size());
+
+	lockData();
+
+	U32 cur_time = (U32)time(NULL);
+	for (S32 i = 0; i < (S32)items.size(); i++)
+	{
+		LLVFSBulkItem& item = items[i];
+		llassert(item.mLocation >= 0);
+		llassert(item.mLength >= 0);
+		item.mBytes = 0;
+
+		fileblock_map::iterator it = mFileBlocks.find(LLVFSFileSpecifier(item.mFileID, item.mFileType));
+		if (it == mFileBlocks.end())
+		{
+			continue;
+		}
+		LLVFSFileBlock *block = (*it).second;
+		block->mAccessTime = cur_time;
+
+		if (item.mLocation > block->mSize)
+		{
+			llwarns << "VFS: Attempt to read location " << item.mLocation << " in file " << item.mFileID << " of length " << block->mSize << llendl;
+			continue;
+		}
+		item.mBytes = llmin(item.mLength, block->mSize - item.mLocation);
+		if (item.mBytes > 0)
+		{
+			reads.push_back(std::make_pair(block->mLocation + item.mLocation, i));
+		}
+	}
+
+	// Read in file order so neighboring files don't need a seek
+	std::sort(reads.begin(), reads.end());
+
+	S32 total = 0;
+	S64 file_pos = -1;
+	for (std::vector<std::pair<U32, S32> >::iterator iter = reads.begin(); iter != reads.end(); ++iter)
+	{
+		LLVFSBulkItem& item = items[iter->second];
+		if ((S64)iter->first != file_pos)
+		{
+			fseek(mDataFP, iter->first, SEEK_SET);
+		}
+		item.mBytes = (S32)fread(item.mBuffer, 1, item.mBytes, mDataFP);
+		file_pos = (S64)iter->first + item.mBytes;
+		total += item.mBytes;
+	}
+
+	unlockData();
+
+	return total;
+}
+
+S32 LLVFS::storeDataBulk(vfs_bulk_items_t& items)
+{
+	if (!isValid())
+	{
+		llerrs << "Attempting to use invalid VFS!" << llendl;
+	}
+	if (mReadOnly)
+	{
+		llerrs << "Attempt to write to read-only VFS" << llendl;
+	}
+
+	// (data file location of the file's block, item), so that the writes to
+	// one file keep the order they were submitted in, overlapping or not
+	std::vector<std::pair<U32, S32> > writes;
+	writes.reserve(items.size());
+	std::vector<LLVFSFileBlock*> blocks(items.size(), (LLVFSFileBlock*)NULL);
+	std::vector<S32> locations(items.size(), 0);
+	// file size including the appends earlier in this batch
+	std::map<LLVFSFileBlock*, S32> append_sizes;
+
+	lockData();
+
+	U32 cur_time = (U32)time(NULL);
+	for (S32 i = 0; i < (S32)items.size(); i++)
+	{
+		LLVFSBulkItem& item = items[i];
+		llassert(item.mLength > 0);
+		item.mBytes = 0;
+
+		fileblock_map::iterator it = mFileBlocks.find(LLVFSFileSpecifier(item.mFileID, item.mFileType));
+		if (it == mFileBlocks.end())
+		{
+			continue;
+		}
+		LLVFSFileBlock *block = (*it).second;
+		block->mAccessTime = cur_time;
+
+		std::map<LLVFSFileBlock*, S32>::iterator size_it = append_sizes.find(block);
+		if (size_it == append_sizes.end())
+		{
+			size_it = append_sizes.insert(std::make_pair(block, block->mSize)).first;
+		}
+		S32 location = (item.mLocation == -1) ? size_it->second : item.mLocation;
+		llassert(location >= 0);
+
+		// same results as storeData() for the error cases
+		if (block->mLength == BLOCK_LENGTH_INVALID)
+		{
+			llwarns << "VFS: Attempt to write to invalid block"
+					<< " in file " << item.mFileID 
+					<< " location: " << item.mLocation
+					<< " bytes: " << item.mLength
+					<< llendl;
+			item.mBytes = item.mLength;
+			continue;
+		}
+		if (location > block->mLength)
+		{
+			llwarns << "VFS: Attempt to write to location " << location 
+					<< " in file " << item.mFileID 
+					<< " type " << S32(item.mFileType)
+					<< " of size " << block->mSize
+					<< " block length " << block->mLength
+					<< llendl;
+			item.mBytes = item.mLength;
+			continue;
+		}
+
+		S32 length = item.mLength;
+		if (length > block->mLength - location)
+		{
+			llwarns << "VFS: Truncating write to virtual file " << item.mFileID << " type " << S32(item.mFileType) << llendl;
+			length = block->mLength - location;
+		}
+		locations[i] = location;
+		item.mBytes = length;
+		size_it->second = llmax(size_it->second, location + length);
+		blocks[i] = block;
+		writes.push_back(std::make_pair(block->mLocation, i));
+	}
+
+	std::sort(writes.begin(), writes.end());
+
+	S32 total = 0;
+	S64 file_pos = -1;
+	std::set<LLVFSFileBlock*> grown_blocks;
+	for (std::vector<std::pair<U32, S32> >::iterator iter = writes.begin(); iter != writes.end(); ++iter)
+	{
+		LLVFSBulkItem& item = items[iter->second];
+		LLVFSFileBlock *block = blocks[iter->second];
+		S32 location = locations[iter->second];
+		U32 pos = iter->first + location;
+		if ((S64)pos != file_pos)
+		{
+			fseek(mDataFP, pos, SEEK_SET);
+		}
+		S32 length = item.mBytes;
+		item.mBytes = (S32)fwrite(item.mBuffer, 1, length, mDataFP);
+		if (item.mBytes != length)
+		{
+			llwarns << llformat("VFS Write Error: %d != %d", item.mBytes, length) << llendl;
+		}
+		file_pos = (S64)pos + item.mBytes;
+		total += item.mBytes;
+
+		if (location + item.mBytes > block->mSize)
+		{
+			block->mSize = location + item.mBytes;
+			grown_blocks.insert(block);
+		}
+	}
+
+	// one index update per file
+	for (std::set<LLVFSFileBlock*>::iterator iter = grown_blocks.begin(); iter != grown_blocks.end(); ++iter)
+	{
+		sync(*iter);
+	}
+
+	unlockData();
+
+	return total;
+}
+
 void LLVFS::incLock(const LLUUID &file_id, const LLAssetType::EType file_type, EVFSLock lock)
 {
 	lockData();
@@ -1274,31 +1487,100 @@ BOOL LLVFS::isLocked(const LLUUID &file_id, const LLAssetType::EType file_type,
 // protected
 //============================================================================
 
+//static
+S32 LLVFS::getFreeBin(S32 length)
+{
+	llassert(length > 0);
+	S32 kb = (length - 1) >> 10;
+	if (kb < FREE_BIN_EXACT)
+	{
+		return kb;
+	}
+	S32 bin = FREE_BIN_EXACT;
+	for (U32 bits = (U32)(length - 1) >> 17; bits; bits >>= 1)
+	{
+		bin++;
+	}
+	return llmin(bin, (S32)FREE_BIN_COUNT - 1);
+}
+
+void LLVFS::insertBlockLength(LLVFSBlock *block)
+{
+	S32 bin = getFreeBin(block->mLength);
+	block->mFreeSlot = (S32)mFreeBins[bin].size();
+	mFreeBins[bin].push_back(block);
+	mFreeBinMask[bin >> 5] |= (1U << (bin & 31));
+	mFreeBlockCount++;
+	mFreeBytes += block->mLength;
+}
+
 void LLVFS::eraseBlockLength(LLVFSBlock *block)
 {
-	// find the corresponding map entry in the length map and erase it
-	S32 length = block->mLength;
-	blocks_length_map_t::iterator iter = mFreeBlocksByLength.lower_bound(length);
-	blocks_length_map_t::iterator end = mFreeBlocksByLength.end();
-	bool found_block = false;
-	while(iter != end)
+	// swap the last block of the bin into our slot
+	S32 bin = getFreeBin(block->mLength);
+	std::vector<LLVFSBlock*>& free_bin = mFreeBins[bin];
+	S32 slot = block->mFreeSlot;
+	if (slot < 0 || slot >= (S32)free_bin.size() || free_bin[slot] != block)
+	{
+		llerrs << "eraseBlock could not find block" << llendl;
+	}
+	LLVFSBlock *last_block = free_bin.back();
+	free_bin[slot] = last_block;
+	last_block->mFreeSlot = slot;
+	free_bin.pop_back();
+	block->mFreeSlot = -1;
+	if (free_bin.empty())
 	{
-		LLVFSBlock *tblock = iter->second;
-		llassert(tblock->mLength == length); // there had -better- be an entry with our length!
-		if (tblock == block)
+		mFreeBinMask[bin >> 5] &= ~(1U << (bin & 31));
+	}
+	mFreeBlockCount--;
+	mFreeBytes -= block->mLength;
+}
+
+// Returns a free block of at least size bytes, NULL if there is none.
+LLVFSBlock *LLVFS::findFreeBin(S32 size)
+{
+	const S32 MAX_BIN_SCAN = 32;
+
+	// The bin for size may also hold blocks a little smaller than size
+	S32 first_bin = getFreeBin(size);
+	std::vector<LLVFSBlock*>& free_bin = mFreeBins[first_bin];
+	S32 count = (S32)free_bin.size();
+	for (S32 i = count - 1; i >= 0 && i >= count - MAX_BIN_SCAN; i--)
+	{
+		if (free_bin[i]->mLength >= size)
 		{
-			mFreeBlocksByLength.erase(iter);
-			found_block = true;
-			break;
+			return free_bin[i];
 		}
-		++iter;
 	}
-	if(!found_block)
+
+	// Every block in a larger bin fits, take the smallest non empty one
+	for (S32 bin = first_bin + 1; bin < FREE_BIN_COUNT; )
 	{
-		llerrs << "eraseBlock could not find block" << llendl;
+		U32 bits = mFreeBinMask[bin >> 5] >> (bin & 31);
+		if (!bits)
+		{
+			bin = (bin & ~31) + 32;
+			continue;
+		}
+		while (!(bits & 1))
+		{
+			bits >>= 1;
+			bin++;
+		}
+		return mFreeBins[bin].back();
 	}
-}
 
+	// Nothing larger, look at the rest of the first bin
+	for (S32 i = count - MAX_BIN_SCAN - 1; i >= 0; i--)
+	{
+		if (free_bin[i]->mLength >= size)
+		{
+			return free_bin[i];
+		}
+	}
+	return NULL;
+}
 
 // Remove block from both free lists (by location and by length).
 void LLVFS::eraseBlock(LLVFSBlock *block)
@@ -1353,7 +1635,7 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 		eraseBlockLength(prev_block);
 		eraseBlock(next_block);
 		prev_block->mLength += block->mLength + next_block->mLength;
-		mFreeBlocksByLength.insert(blocks_length_map_t::value_type(prev_block->mLength, prev_block));
+		insertBlockLength(prev_block);
 		delete block;
 		block = NULL;
 		delete next_block;
@@ -1366,7 +1648,7 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 		// therefore only need to update the length map. JC
 		eraseBlockLength(prev_block);
 		prev_block->mLength += block->mLength;
-		mFreeBlocksByLength.insert(blocks_length_map_t::value_type(prev_block->mLength, prev_block)); // multimap insert
+		insertBlockLength(prev_block);
 		delete block;
 		block = NULL;
 	}
@@ -1379,8 +1661,8 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 		next_block->mLocation = block->mLocation;
 		next_block->mLength += block->mLength;
 		// Don't hint here, next_free_it iterator may be invalid.
-		mFreeBlocksByLocation.insert(blocks_location_map_t::value_type(next_block->mLocation, next_block)); // multimap insert
-		mFreeBlocksByLength.insert(blocks_length_map_t::value_type(next_block->mLength, next_block)); // multimap insert			
+		mFreeBlocksByLocation.insert(blocks_location_map_t::value_type(next_block->mLocation, next_block));
+		insertBlockLength(next_block);
 		delete block;
 		block = NULL;
 	}
@@ -1388,8 +1670,8 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 	{
 		// Can't merge with other free blocks.
 		// Hint that insert should go near next_free_it.
- 		mFreeBlocksByLocation.insert(next_free_it, blocks_location_map_t::value_type(block->mLocation, block)); // multimap insert
- 		mFreeBlocksByLength.insert(blocks_length_map_t::value_type(block->mLength, block)); // multimap insert
+ 		mFreeBlocksByLocation.insert(next_free_it, blocks_location_map_t::value_type(block->mLocation, block));
+ 		insertBlockLength(block);
 	}
 }
 
@@ -1418,7 +1700,7 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 // 			// merge first_block with second_block, since they're adjacent
 // 			first_block->mLength += second_block->mLength;
 // 			// add the first block to the length map (with the new size)
-// 			mFreeBlocksByLength.insert(blocks_length_map_t::value_type(first_block->mLength, first_block)); // multimap insert
+// 			insertBlockLength(first_block);
 //
 // 			// erase and delete the second block
 // 			eraseBlock(second_block);
@@ -1554,9 +1836,7 @@ LLVFSBlock *LLVFS::findFreeBlock(S32 size, LLVFSFileBlock *immune)
 	while (! block)
 	{
 		// look for a suitable free block
-		blocks_length_map_t::iterator iter = mFreeBlocksByLength.lower_bound(size); // first entry >= size
-		if (iter != mFreeBlocksByLength.end())
-			block = iter->second;
+		block = findFreeBin(size);
     	
 		// no large enough free blocks, time to clean out some junk
 		if (! block)
@@ -1966,7 +2246,7 @@ void LLVFS::dumpStatistics()
 	llinfos << "Invalid blocks: " << invalid_file_count << llendl;
 	llinfos << "File blocks:    " << mFileBlocks.size() << llendl;
 
-	S32 length_list_count = (S32)mFreeBlocksByLength.size();
+	S32 length_list_count = mFreeBlockCount;
 	S32 location_list_count = (S32)mFreeBlocksByLocation.size();
 	if (length_list_count == location_list_count)
 	{
@@ -1975,7 +2255,7 @@ void LLVFS::dumpStatistics()
 	else
 	{
 		llwarns << "Free list lengths do not match!" << llendl;
-		llwarns << "By length: " << length_list_count << llendl;
+		llwarns << "By bin: " << length_list_count << llendl;
 		llwarns << "By location: " << location_list_count << llendl;
 	}
 	llinfos << "Max file: " << max_file_size/1024 << "K" << llendl;
@@ -1984,6 +2264,10 @@ void LLVFS::dumpStatistics()
 	llinfos << "Total free size: " << total_free_size/1024 << "K" << llendl;
 	llinfos << "Sum: " << (total_file_size + total_free_size) << " bytes" << llendl;
 	llinfos << llformat("%.0f%% full",((F32)(total_file_size)/(F32)(total_file_size+total_free_size))*100.f) << llendl;
+	if (total_free_size > 0)
+	{
+		llinfos << llformat("%.0f%% fragmented", (1.f - (F32)getLargestFreeBlockLocked() / (F32)total_free_size) * 100.f) << llendl;
+	}
 
 	llinfos << " " << llendl;
 	for (std::map<LLAssetType::EType, std::pair<S32,S32> >::iterator iter = filetype_counts.begin();
@@ -2014,6 +2298,54 @@ void LLVFS::dumpStatistics()
 	unlockData();
 }
 
+S32 LLVFS::getFreeBlockCount()
+{
+	LLMutexLock lock(mDataMutex);
+	return mFreeBlockCount;
+}
+
+S64 LLVFS::getFreeSpace()
+{
+	LLMutexLock lock(mDataMutex);
+	return mFreeBytes;
+}
+
+// mDataMutex must be LOCKED before calling this
+S32 LLVFS::getLargestFreeBlockLocked()
+{
+	// the largest block is in the highest non empty bin
+	for (S32 bin = FREE_BIN_COUNT - 1; bin >= 0; bin--)
+	{
+		if (mFreeBinMask[bin >> 5] & (1U << (bin & 31)))
+		{
+			S32 largest = 0;
+			std::vector<LLVFSBlock*>& free_bin = mFreeBins[bin];
+			for (std::vector<LLVFSBlock*>::iterator iter = free_bin.begin(); iter != free_bin.end(); ++iter)
+			{
+				largest = llmax(largest, (*iter)->mLength);
+			}
+			return largest;
+		}
+	}
+	return 0;
+}
+
+S32 LLVFS::getLargestFreeBlock()
+{
+	LLMutexLock lock(mDataMutex);
+	return getLargestFreeBlockLocked();
+}
+
+F32 LLVFS::getFragmentation()
+{
+	LLMutexLock lock(mDataMutex);
+	if (mFreeBytes <= 0)
+	{
+		return 0.f;
+	}
+	return 1.f - (F32)getLargestFreeBlockLocked() / (F32)mFreeBytes;
+}
+
 // Debug Only!
 std::string get_extension(LLAssetType::EType type)
 {
@@ -28,6 +28,7 @@
 #define LL_LLVFS_H
 
 #include <deque>
+#include <vector>
 #include "lluuid.h"
 #include "linked_lists.h"
 #include "llassettype.h"
@@ -69,6 +70,23 @@ public:
 	LLAssetType::EType mFileType;
 };
 
+// One file of a bulk read or write, see LLVFS::getDataBulk() and LLVFS::storeDataBulk()
+class LLVFSBulkItem
+{
+public:
+	LLVFSBulkItem();
+	LLVFSBulkItem(const LLUUID &file_id, const LLAssetType::EType file_type, U8 *buffer, S32 location, S32 length);
+
+public:
+	LLUUID mFileID;
+	LLAssetType::EType mFileType;
+	U8* mBuffer;	// dest for reads, source for writes
+	S32 mLocation;	// offset into file, -1 = append (writes only)
+	S32 mLength;	// bytes to read or write
+	S32 mBytes;		// bytes actually read or written
+};
+typedef std::vector<LLVFSBulkItem> vfs_bulk_items_t;
+
 class LLVFS
 {
 private:
@@ -109,6 +127,12 @@ public:
 	S32 getData(const LLUUID &file_id, const LLAssetType::EType file_type, U8 *buffer, S32 location, S32 length);
 	S32 storeData(const LLUUID &file_id, const LLAssetType::EType file_type, const U8 *buffer, S32 location, S32 length);
 
+	// Scatter/gather versions of getData() and storeData(): all items are done under one lock,
+	// in data file order. Writes to the same file keep their order in items, so a later
+	// overlapping write wins. Sets mBytes of each item and returns the total number of bytes.
+	S32 getDataBulk(vfs_bulk_items_t& items);
+	S32 storeDataBulk(vfs_bulk_items_t& items);
+
 	void incLock(const LLUUID &file_id, const LLAssetType::EType file_type, EVFSLock lock);
 	void decLock(const LLUUID &file_id, const LLAssetType::EType file_type, EVFSLock lock);
 	BOOL isLocked(const LLUUID &file_id, const LLAssetType::EType file_type, EVFSLock lock);
@@ -129,12 +153,21 @@ public:
 	void listFiles();
 	void dumpFiles();
 
+	// Free space statistics, fragmentation is 1 - (largest free block / total free space)
+	S32 getFreeBlockCount();
+	S64 getFreeSpace();
+	S32 getLargestFreeBlock();
+	F32 getFragmentation();
+
 protected:
 	void removeFileBlock(LLVFSFileBlock *fileblock);
 	
 	void eraseBlockLength(LLVFSBlock *block);
+	void insertBlockLength(LLVFSBlock *block);
 	void eraseBlock(LLVFSBlock *block);
 	void addFreeBlock(LLVFSBlock *block);
+	LLVFSBlock *findFreeBin(S32 size);
+	S32 getLargestFreeBlockLocked();
 	//void mergeFreeBlocks();
 	void useFreeSpace(LLVFSBlock *free_block, S32 length);
 	void sync(LLVFSFileBlock *block, BOOL remove = FALSE);
@@ -157,10 +190,16 @@ protected:
 	typedef std::map<LLVFSFileSpecifier, LLVFSFileBlock*> fileblock_map;
 	fileblock_map mFileBlocks;
 
-	typedef std::multimap<S32, LLVFSBlock*>	blocks_length_map_t;
-	blocks_length_map_t 	mFreeBlocksByLength;
-	typedef std::multimap<U32, LLVFSBlock*>	blocks_location_map_t;
-	blocks_location_map_t 	mFreeBlocksByLocation;
+	// Free blocks are kept in segregated bins, one per KB up to 64KB, then one per power of two,
+	// with a bitmap of the non empty bins. Blocks know their slot in their bin.
+	enum { FREE_BIN_EXACT = 64, FREE_BIN_COUNT = 80, FREE_BIN_MASK_WORDS = (FREE_BIN_COUNT + 31) / 32 };
+	static S32 getFreeBin(S32 length);
+	std::vector<LLVFSBlock*> mFreeBins[FREE_BIN_COUNT];
+	U32 mFreeBinMask[FREE_BIN_MASK_WORDS];
+	S32 mFreeBlockCount;
+	S64 mFreeBytes;
+	typedef std::map<U32, LLVFSBlock*>	blocks_location_map_t;
+	blocks_location_map_t 	mFreeBlocksByLocation; // used to merge neighbors
 
 	LLFILE *mDataFP;
 	LLFILE *mIndexFP;
@@ -28,6 +28,8 @@
 #include "llvfsthread.h"
 #include "llstl.h"
 
+#include <algorithm>
+
 //============================================================================
 
 /*static*/ std::string LLVFSThread::sDataPath = "";
@@ -138,6 +140,41 @@ LLVFSThread::handle_t LLVFSThread::write(LLVFS* vfs, const LLUUID &file_id, cons
 	return handle;
 }
 
+LLVFSThread::handle_t LLVFSThread::readBulk(LLVFS* vfs, const vfs_bulk_items_t& items, U32 priority, U32 flags)
+{
+	handle_t handle = generateHandle();
+
+	priority = llmax(priority, (U32)PRIORITY_LOW); // All reads are at least PRIORITY_LOW
+	BulkRequest* req = new BulkRequest(handle, priority, flags, FILE_READ, vfs, items);
+
+	bool res = addRequest(req);
+	if (!res)
+	{
+		llerrs << "LLVFSThread::readBulk called after LLVFSThread::cleanupClass()" << llendl;
+		req->deleteRequest();
+		handle = nullHandle();
+	}
+
+	return handle;
+}
+
+LLVFSThread::handle_t LLVFSThread::writeBulk(LLVFS* vfs, const vfs_bulk_items_t& items, U32 flags)
+{
+	handle_t handle = generateHandle();
+
+	BulkRequest* req = new BulkRequest(handle, 0, flags, FILE_WRITE, vfs, items);
+
+	bool res = addRequest(req);
+	if (!res)
+	{
+		llerrs << "LLVFSThread::writeBulk called after LLVFSThread::cleanupClass()" << llendl;
+		req->deleteRequest();
+		handle = nullHandle();
+	}
+	
+	return handle;
+}
+
 S32 LLVFSThread::writeImmediate(LLVFS* vfs, const LLUUID &file_id, const LLAssetType::EType file_type,
 								 U8* buffer, S32 offset, S32 numbytes)
 {
@@ -298,3 +335,71 @@ bool LLVFSThread::Request::processRequest()
 }
 
 //============================================================================
+
+LLVFSThread::BulkRequest::BulkRequest(handle_t handle, U32 priority, U32 flags,
+									  operation_t op, LLVFS* vfs, const vfs_bulk_items_t& items) :
+	QueuedRequest(handle, priority, flags),
+	mOperation(op),
+	mVFS(vfs),
+	mItems(items),
+	mBytesRead(0)
+{
+	llassert(mOperation == FILE_READ || mOperation == FILE_WRITE);
+
+	EVFSLock lock = (mOperation == FILE_WRITE) ? VFSLOCK_APPEND : VFSLOCK_READ;
+	for (vfs_bulk_items_t::iterator iter = mItems.begin(); iter != mItems.end(); ++iter)
+	{
+		llassert(iter->mBuffer);
+		mVFS->incLock(iter->mFileID, iter->mFileType, lock);
+	}
+}
+
+// dec locks as soon as a request finishes
+void LLVFSThread::BulkRequest::finishRequest(bool completed)
+{
+	EVFSLock lock = (mOperation == FILE_WRITE) ? VFSLOCK_APPEND : VFSLOCK_READ;
+	for (vfs_bulk_items_t::iterator iter = mItems.begin(); iter != mItems.end(); ++iter)
+	{
+		mVFS->decLock(iter->mFileID, iter->mFileType, lock);
+	}
+}
+
+void LLVFSThread::BulkRequest::deleteRequest()
+{
+	if (getStatus() == STATUS_QUEUED)
+	{
+		llerrs << "Attempt to delete a queued LLVFSThread::BulkRequest!" << llendl;
+	}	
+	if (mOperation == FILE_WRITE && (mFlags & FLAG_AUTO_DELETE))
+	{
+		// Items may point into the same buffer, delete each one only once
+		std::vector<U8*> buffers;
+		buffers.reserve(mItems.size());
+		for (vfs_bulk_items_t::iterator iter = mItems.begin(); iter != mItems.end(); ++iter)
+		{
+			buffers.push_back(iter->mBuffer);
+		}
+		std::sort(buffers.begin(), buffers.end());
+		buffers.erase(std::unique(buffers.begin(), buffers.end()), buffers.end());
+		for (std::vector<U8*>::iterator iter = buffers.begin(); iter != buffers.end(); ++iter)
+		{
+			delete [] *iter;
+		}
+	}
+	LLQueuedThread::QueuedRequest::deleteRequest();
+}
+
+bool LLVFSThread::BulkRequest::processRequest()
+{
+	if (mOperation == FILE_READ)
+	{
+		mBytesRead = mVFS->getDataBulk(mItems);
+	}
+	else
+	{
+		mBytesRead = mVFS->storeDataBulk(mItems);
+	}
+	return true;
+}
+
+//============================================================================
@@ -104,6 +104,41 @@ public:
 		S32	mBytesRead;	// bytes read from file
 	};
 
+	// Reads or writes many files with one LLVFS call, see LLVFS::getDataBulk()
+	class BulkRequest : public QueuedRequest
+	{
+	protected:
+		~BulkRequest() {}; // use deleteRequest()
+		
+	public:
+		BulkRequest(handle_t handle, U32 priority, U32 flags,
+					operation_t op, LLVFS* vfs, const vfs_bulk_items_t& items);
+
+		S32 getBytesRead()
+		{
+			return mBytesRead;
+		}
+		S32 getOperation()
+		{
+			return mOperation;
+		}
+		// mBytes of each item is set when the request completes
+		const vfs_bulk_items_t& getItems()
+		{
+			return mItems;
+		}
+		
+		/*virtual*/ bool processRequest();
+		/*virtual*/ void finishRequest(bool completed);
+		/*virtual*/ void deleteRequest();
+		
+	private:
+		operation_t mOperation; // FILE_READ or FILE_WRITE
+		LLVFS* mVFS;
+		vfs_bulk_items_t mItems;
+		S32	mBytesRead;	// total bytes read or written
+	};
+
 	//------------------------------------------------------------------------
 public:
 	static std::string sDataPath;
@@ -118,6 +153,11 @@ public:
 				  U8* buffer, S32 offset, S32 numbytes, U32 pri=PRIORITY_NORMAL, U32 flags = 0);
 	handle_t write(LLVFS* vfs, const LLUUID &file_id, const LLAssetType::EType file_type,
 				   U8* buffer, S32 offset, S32 numbytes, U32 flags);
+	// Bulk versions of read() and write(). Buffers are owned by the caller (unless FLAG_AUTO_DELETE
+	// is set for a write) and must stay valid until the request completes. With FLAG_AUTO_DELETE
+	// every distinct buffer is delete[]d once, so items may share a buffer but each must point to the start of a new[] array.
+	handle_t readBulk(LLVFS* vfs, const vfs_bulk_items_t& items, U32 pri=PRIORITY_NORMAL, U32 flags = 0);
+	handle_t writeBulk(LLVFS* vfs, const vfs_bulk_items_t& items, U32 flags);
 	// SJB: rename seems to have issues, especially when threaded
 // 	handle_t rename(LLVFS* vfs, const LLUUID &file_id, const LLAssetType::EType file_type,
 // 					const LLUUID &new_id, const LLAssetType::EType new_type, U32 flags);
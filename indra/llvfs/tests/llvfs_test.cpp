@@ -0,0 +1,172 @@
+/**
+ * @file llvfs_test.cpp
+ * @brief LLVFS allocator and bulk read/write test cases.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lldir.h"
+#include "../llvfs.h"
+#include "llfile.h"
+
+#include "../test/lltut.h"
+
+
+namespace tut
+{
+	struct LLVFSTest
+	{
+		LLVFSTest()
+		{
+			std::string base = gDirUtilp->getTempFilename();
+			mIndexFilename = base + ".index";
+			mDataFilename = base + ".data";
+			mVFS = LLVFS::createLLVFS(mIndexFilename, mDataFilename, FALSE, 0, FALSE);
+		}
+
+		~LLVFSTest()
+		{
+			delete mVFS;
+			LLFile::remove(mIndexFilename);
+			LLFile::remove(mDataFilename);
+		}
+
+		std::string mIndexFilename;
+		std::string mDataFilename;
+		LLVFS* mVFS;
+	};
+	typedef test_group<LLVFSTest> LLVFSTest_t;
+	typedef LLVFSTest_t::object LLVFSTest_object_t;
+	tut::LLVFSTest_t tut_LLVFSTest("LLVFS");
+
+	template<> template<>
+	void LLVFSTest_object_t::test<1>()
+		// bulk write then bulk read
+	{
+		ensure("vfs valid", mVFS && mVFS->isValid());
+
+		const S32 NUM_FILES = 16;
+		const S32 FILE_SIZE = 3000;
+		std::vector<LLUUID> ids(NUM_FILES);
+		std::vector<std::vector<U8> > data(NUM_FILES, std::vector<U8>(FILE_SIZE));
+		vfs_bulk_items_t writes;
+		for (S32 i = 0; i < NUM_FILES; i++)
+		{
+			ids[i].generate();
+			for (S32 j = 0; j < FILE_SIZE; j++)
+			{
+				data[i][j] = (U8)(i + j);
+			}
+			ensure("setMaxSize", mVFS->setMaxSize(ids[i], LLAssetType::AT_SOUND, FILE_SIZE));
+			// append in two parts to check the append offsets within a batch
+			writes.push_back(LLVFSBulkItem(ids[i], LLAssetType::AT_SOUND, &data[i][0], -1, FILE_SIZE / 2));
+			writes.push_back(LLVFSBulkItem(ids[i], LLAssetType::AT_SOUND, &data[i][FILE_SIZE / 2], -1, FILE_SIZE - FILE_SIZE / 2));
+		}
+		ensure_equals("bytes written", mVFS->storeDataBulk(writes), NUM_FILES * FILE_SIZE);
+
+		std::vector<std::vector<U8> > result(NUM_FILES, std::vector<U8>(FILE_SIZE));
+		vfs_bulk_items_t reads;
+		for (S32 i = NUM_FILES - 1; i >= 0; i--)
+		{
+			reads.push_back(LLVFSBulkItem(ids[i], LLAssetType::AT_SOUND, &result[i][0], 0, FILE_SIZE));
+		}
+		// a missing file reads nothing
+		U8 missing[16];
+		reads.push_back(LLVFSBulkItem(LLUUID::generateNewID(), LLAssetType::AT_SOUND, missing, 0, sizeof(missing)));
+
+		ensure_equals("bytes read", mVFS->getDataBulk(reads), NUM_FILES * FILE_SIZE);
+		ensure_equals("missing file", reads.back().mBytes, 0);
+		for (S32 i = 0; i < NUM_FILES; i++)
+		{
+			ensure_equals("file size", mVFS->getSize(ids[i], LLAssetType::AT_SOUND), FILE_SIZE);
+			ensure("file data", result[i] == data[i]);
+		}
+	}
+
+	template<> template<>
+	void LLVFSTest_object_t::test<2>()
+		// freed blocks are reused and merged
+	{
+		ensure("vfs valid", mVFS && mVFS->isValid());
+
+		S64 initial_free = mVFS->getFreeSpace();
+		ensure_equals("one free block", mVFS->getFreeBlockCount(), 1);
+		ensure_equals("no fragmentation", mVFS->getFragmentation(), 0.f);
+
+		const S32 NUM_FILES = 8;
+		std::vector<LLUUID> ids(NUM_FILES);
+		for (S32 i = 0; i < NUM_FILES; i++)
+		{
+			ids[i].generate();
+			ensure("setMaxSize", mVFS->setMaxSize(ids[i], LLAssetType::AT_SOUND, 4096));
+		}
+		ensure_equals("space used", mVFS->getFreeSpace(), initial_free - NUM_FILES * 4096);
+
+		// every other file leaves holes
+		for (S32 i = 0; i < NUM_FILES; i += 2)
+		{
+			mVFS->removeFile(ids[i], LLAssetType::AT_SOUND);
+		}
+		ensure_equals("holes", mVFS->getFreeBlockCount(), NUM_FILES / 2 + 1);
+		ensure("fragmented", mVFS->getFragmentation() > 0.f);
+
+		// a small file goes in a hole instead of the end
+		LLUUID small_id;
+		small_id.generate();
+		ensure("setMaxSize small", mVFS->setMaxSize(small_id, LLAssetType::AT_SOUND, 1024));
+		ensure_equals("hole reused", mVFS->getFreeBlockCount(), NUM_FILES / 2 + 1);
+		mVFS->removeFile(small_id, LLAssetType::AT_SOUND);
+
+		for (S32 i = 1; i < NUM_FILES; i += 2)
+		{
+			mVFS->removeFile(ids[i], LLAssetType::AT_SOUND);
+		}
+		ensure_equals("merged", mVFS->getFreeBlockCount(), 1);
+		ensure_equals("all free", mVFS->getFreeSpace(), initial_free);
+		ensure("checkAvailable", mVFS->checkAvailable(1024 * 1024));
+	}
+
+	template<> template<>
+	void LLVFSTest_object_t::test<3>()
+		// overlapping writes to a file land in the order they were submitted
+	{
+		ensure("vfs valid", mVFS && mVFS->isValid());
+
+		LLUUID id;
+		id.generate();
+		ensure("setMaxSize", mVFS->setMaxSize(id, LLAssetType::AT_SOUND, 16));
+		std::vector<U8> a(8, 'a');
+		std::vector<U8> b(16, 'b');
+		std::vector<U8> c(4, 'c');
+		vfs_bulk_items_t writes;
+		writes.push_back(LLVFSBulkItem(id, LLAssetType::AT_SOUND, &a[0], 4, 8));
+		writes.push_back(LLVFSBulkItem(id, LLAssetType::AT_SOUND, &b[0], 0, 16));
+		writes.push_back(LLVFSBulkItem(id, LLAssetType::AT_SOUND, &c[0], 2, 4));
+		ensure_equals("bytes written", mVFS->storeDataBulk(writes), 28);
+
+		U8 result[16];
+		ensure_equals("bytes read", mVFS->getData(id, LLAssetType::AT_SOUND, result, 0, 16), 16);
+		ensure_equals("file data", std::string((char*)result, 16), std::string("bbccccbbbbbbbbbb"));
+	}
+}
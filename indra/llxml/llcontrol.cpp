@@ -137,7 +137,8 @@ LLControlVariable::LLControlVariable(const std::string& name, eControlType type,
 	  mComment(comment),
 	  mType(type),
 	  mPersist(persist),
-	  mHideFromSettingsEditor(hidefromsettingseditor)
+	  mHideFromSettingsEditor(hidefromsettingseditor),
+	  mLookupCount(0)
 {
 	if (mPersist && mComment.empty())
 	{
@@ -288,10 +289,21 @@ LLSD LLControlVariable::getSaveValue() const
 	return mValues[0];
 }
 
+//static
+bool LLControlGroup::sCountLookups = false;
+
 LLPointer<LLControlVariable> LLControlGroup::getControl(const std::string& name)
 {
 	ctrl_name_table_t::iterator iter = mNameTable.find(name);
-	return iter == mNameTable.end() ? LLPointer<LLControlVariable>() : iter->second;
+	if (iter == mNameTable.end())
+	{
+		return LLPointer<LLControlVariable>();
+	}
+	if (sCountLookups)
+	{
+		++iter->second->mLookupCount;
+	}
+	return iter->second;
 }
 
 
@@ -938,6 +950,46 @@ void LLControlGroup::applyToAll(ApplyFunctor* func)
 	}
 }
 
+static bool more_lookups(const LLControlVariable* a, const LLControlVariable* b)
+{
+	return a->getLookupCount() > b->getLookupCount();
+}
+
+void LLControlGroup::logLookups(U32 num_frames, U32 max_controls)
+{
+	std::vector<LLControlVariable*> controls;
+	for (ctrl_name_table_t::iterator iter = mNameTable.begin();
+		 iter != mNameTable.end(); iter++)
+	{
+		if (iter->second->mLookupCount > 0)
+		{
+			controls.push_back(iter->second);
+		}
+	}
+	std::stable_sort(controls.begin(), controls.end(), more_lookups);
+	if (controls.size() > max_controls)
+	{
+		controls.resize(max_controls);
+	}
+
+	num_frames = llmax(num_frames, (U32)1);
+	llinfos << "Most looked up controls in " << getKey() << " over " << num_frames << " frames:" << llendl;
+	for (std::vector<LLControlVariable*>::iterator iter = controls.begin(); iter != controls.end(); ++iter)
+	{
+		llinfos << "  " << (*iter)->getName() << ": " << (*iter)->getLookupCount()
+				<< " (" << (F32)(*iter)->getLookupCount() / (F32)num_frames << " per frame)" << llendl;
+	}
+}
+
+void LLControlGroup::resetLookupCounts()
+{
+	for (ctrl_name_table_t::iterator iter = mNameTable.begin();
+		 iter != mNameTable.end(); iter++)
+	{
+		iter->second->mLookupCount = 0;
+	}
+}
+
 //============================================================================
 
 #ifdef TEST_HARNESS
@@ -1295,4 +1347,3 @@ void test_cached_control()
 	if((std::string)test_BrowserHomePage != "http://www.secondlife.com") llerrs << "Fail BrowserHomePage" << llendl;
 }
 #endif // TEST_CACHED_CONTROL
-
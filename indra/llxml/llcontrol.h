@@ -105,6 +105,8 @@ private:
 	bool			mPersist;
 	bool			mHideFromSettingsEditor;
 	std::vector<LLSD> mValues;
+	// Times the control was looked up by name, see LLControlGroup::logLookups()
+	U32				mLookupCount;
 	
 	commit_signal_t mCommitSignal;
 	validate_signal_t mValidateSignal;
@@ -132,6 +134,7 @@ public:
 	bool isSaveValueDefault();
 	bool isPersisted() { return mPersist; }
 	bool isHiddenFromSettingsEditor() { return mHideFromSettingsEditor; }
+	U32 getLookupCount() const { return mLookupCount; }
 	LLSD get()			const	{ return getValue(); }
 	LLSD getValue()		const	{ return mValues.back(); }
 	LLSD getDefault()	const	{ return mValues.front(); }
@@ -184,6 +187,7 @@ protected:
 	typedef std::map<std::string, LLControlVariablePtr > ctrl_name_table_t;
 	ctrl_name_table_t mNameTable;
 	std::string mTypeString[TYPE_COUNT];
+	static bool sCountLookups;
 
 	eControlType typeStringToEnum(const std::string& typestr);
 	std::string typeEnumToString(eControlType typeenum);	
@@ -291,6 +295,15 @@ public:
  	U32 saveToFile(const std::string& filename, BOOL nondefault_only);
  	U32	loadFromFile(const std::string& filename, bool default_values = false);
 	void	resetToDefaults();
+
+	// Logs the max_controls controls most looked up by name over the
+	// num_frames frames since the counts were reset. Controls read every
+	// frame should be an LLCachedControl instead. getControl() only
+	// counts lookups while setCountLookups(true) is in effect.
+	void	logLookups(U32 num_frames, U32 max_controls);
+	void	resetLookupCounts();
+	static void	setCountLookups(bool count) { sCountLookups = count; }
+	static bool	getCountLookups() { return sCountLookups; }
 };
 
 
@@ -42,6 +42,7 @@
 #include "llstring.h"
 #include "lluuid.h"
 #include "lldir.h"
+#include "llxmlnodecache.h"
 
 const S32 MAX_COLUMN_WIDTH = 80;
 
@@ -868,6 +869,32 @@ bool LLXMLNode::getLayeredXMLNode(const std::string &xui_filename, LLXMLNodePtr&
 		return false;
 	}
 
+	// The layers that exist now, to check a cached tree against
+	std::string cache_key;
+	LLXMLNodeCache::source_list_t sources;
+	bool cacheable = LLXMLNodeCache::isEnabled() && LLXMLNodeCache::addSource(full_filename, sources);
+	if (cacheable)
+	{
+		cache_key = xui_filename;
+		std::vector<std::string>::const_iterator path_it;
+		for (path_it = paths.begin(); path_it != paths.end(); ++path_it)
+		{
+			cache_key += "\n" + *path_it;
+			if (path_it != paths.begin())
+			{
+				std::string layer_filename = gDirUtilp->findSkinnedFilename(*path_it, xui_filename);
+				if (!layer_filename.empty() && !LLXMLNodeCache::addSource(layer_filename, sources))
+				{
+					cacheable = false;
+				}
+			}
+		}
+		if (cacheable && LLXMLNodeCache::read(cache_key, sources, root))
+		{
+			return true;
+		}
+	}
+
 	if (!LLXMLNode::parseFile(full_filename, root, NULL))
 	{
 		// try filename as passed in since sometimes we load an xml file from a user-supplied path
@@ -876,6 +903,7 @@ bool LLXMLNode::getLayeredXMLNode(const std::string &xui_filename, LLXMLNodePtr&
 			llwarns << "Problem reading UI description file: " << xui_filename << llendl;
 			return false;
 		}
+		cacheable = false;
 	}
 
 	LLXMLNodePtr updateRoot;
@@ -909,6 +937,11 @@ bool LLXMLNode::getLayeredXMLNode(const std::string &xui_filename, LLXMLNodePtr&
 		}
 	}
 
+	if (cacheable)
+	{
+		LLXMLNodeCache::write(cache_key, sources, root);
+	}
+
 	return true;
 }
 
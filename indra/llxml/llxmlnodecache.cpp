@@ -0,0 +1,330 @@
+/**
+ * @file llxmlnodecache.cpp
+ * @brief Binary cache of the merged XUI trees built by
+ * LLXMLNode::getLayeredXMLNode().
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llxmlnodecache.h"
+
+#include "lldir.h"
+#include "llfile.h"
+#include "llmappedfile.h"
+#include "llmd5.h"
+
+static const U32 FILE_MAGIC = 0x43495558;	// "XUIC"
+// Bump when the layout below or LLXMLNode's fields change
+static const U32 FILE_VERSION = 1;
+
+// Layout, every value native byte order, strings as a U32 length and the
+// bytes:
+//	U32 magic, U32 version
+//	U32 source count, then per source: filename, S64 size, S64 modified
+//	the root node. A node is
+//		name, value, id, U8 is attribute, U8 type, U8 encoding,
+//		U32 length, U32 precision, U32 version major, U32 version minor,
+//		S32 line number, U32 attribute count, U32 child count,
+//	followed by its attribute nodes and its child nodes, in order.
+
+namespace
+{
+	template <class T>
+	void put(std::string& data, T value)
+	{
+		data.append((const char*)&value, sizeof(value));
+	}
+
+	void put_string(std::string& data, const std::string& value)
+	{
+		put(data, (U32)value.size());
+		data.append(value);
+	}
+
+	void put_node(std::string& data, const LLXMLNode* node)
+	{
+		put_string(data, node->getName() ? std::string(node->getName()->mString) : std::string());
+		put_string(data, node->getValue());
+		put_string(data, node->mID);
+		put(data, (U8)node->mIsAttribute);
+		put(data, (U8)node->mType);
+		put(data, (U8)node->mEncoding);
+		put(data, node->mLength);
+		put(data, node->mPrecision);
+		put(data, node->mVersionMajor);
+		put(data, node->mVersionMinor);
+		put(data, node->mLineNumber);
+
+		U32 num_children = 0;
+		for (LLXMLNodePtr child = node->getFirstChild(); child.notNull(); child = child->getNextSibling())
+		{
+			++num_children;
+		}
+		put(data, (U32)node->mAttributes.size());
+		put(data, num_children);
+
+		for (LLXMLAttribList::const_iterator it = node->mAttributes.begin(); it != node->mAttributes.end(); ++it)
+		{
+			put_node(data, it->second);
+		}
+		for (LLXMLNodePtr child = node->getFirstChild(); child.notNull(); child = child->getNextSibling())
+		{
+			put_node(data, child);
+		}
+	}
+
+	// Reads values out of a buffer, failing rather than reading past it
+	class Reader
+	{
+	public:
+		Reader(const U8* data, size_t size) : mData(data), mEnd(data + size), mOK(true) {}
+
+		bool isOK() const { return mOK; }
+		bool atEnd() const { return mData == mEnd; }
+
+		template <class T>
+		T get()
+		{
+			T value = T();
+			if (mOK && (size_t)(mEnd - mData) >= sizeof(T))
+			{
+				memcpy(&value, mData, sizeof(T));	/* Flawfinder: ignore */
+				mData += sizeof(T);
+			}
+			else
+			{
+				mOK = false;
+			}
+			return value;
+		}
+
+		void getString(std::string& value)
+		{
+			U32 size = get<U32>();
+			if (mOK && (size_t)(mEnd - mData) >= size)
+			{
+				value.assign((const char*)mData, size);
+				mData += size;
+			}
+			else
+			{
+				mOK = false;
+			}
+		}
+
+	private:
+		const U8* mData;
+		const U8* mEnd;
+		bool mOK;
+	};
+
+	LLXMLNodePtr get_node(Reader& reader)
+	{
+		std::string name;
+		std::string value;
+		std::string id;
+		reader.getString(name);
+		reader.getString(value);
+		reader.getString(id);
+		const bool is_attribute = reader.get<U8>() != 0;
+		const U8 type = reader.get<U8>();
+		const U8 encoding = reader.get<U8>();
+		if (!reader.isOK())
+		{
+			return NULL;
+		}
+
+		LLXMLNodePtr node = new LLXMLNode(name.c_str(), is_attribute);
+		node->setValue(value);
+		node->mID = id;
+		node->mType = (LLXMLNode::ValueType)type;
+		node->mEncoding = (LLXMLNode::Encoding)encoding;
+		node->mLength = reader.get<U32>();
+		node->mPrecision = reader.get<U32>();
+		node->mVersionMajor = reader.get<U32>();
+		node->mVersionMinor = reader.get<U32>();
+		node->setLineNumber(reader.get<S32>());
+
+		const U32 num_attributes = reader.get<U32>();
+		const U32 num_children = reader.get<U32>();
+		for (U32 i = 0; reader.isOK() && i < num_attributes + num_children; ++i)
+		{
+			LLXMLNodePtr child = get_node(reader);
+			if (child.isNull())
+			{
+				return NULL;
+			}
+			node->addChild(child);
+		}
+		if (!reader.isOK())
+		{
+			return NULL;
+		}
+		return node;
+	}
+}
+
+std::string LLXMLNodeCache::sCacheDir;
+
+//static
+void LLXMLNodeCache::setCacheDir(const std::string& dir)
+{
+	sCacheDir = dir;
+	if (!sCacheDir.empty())
+	{
+		LLFile::mkdir(sCacheDir);
+	}
+}
+
+//static
+bool LLXMLNodeCache::addSource(const std::string& filename, source_list_t& sources)
+{
+	llstat file_status;
+	if (LLFile::stat(filename, &file_status))
+	{
+		return false;
+	}
+	Source source;
+	source.mFilename = filename;
+	source.mSize = file_status.st_size;
+	source.mModified = file_status.st_mtime;
+	sources.push_back(source);
+	return true;
+}
+
+//static
+std::string LLXMLNodeCache::getFilename(const std::string& key)
+{
+	LLMD5 md5;
+	md5.update((const unsigned char*)key.data(), key.size());
+	md5.finalize();
+	char digest[33];		/* Flawfinder: ignore */
+	md5.hex_digest(digest);
+	return sCacheDir + gDirUtilp->getDirDelimiter() + digest + ".xuic";
+}
+
+//static
+bool LLXMLNodeCache::read(const std::string& key, const source_list_t& sources, LLXMLNodePtr& root)
+{
+	if (!isEnabled())
+	{
+		return false;
+	}
+	std::string filename = getFilename(key);
+	if (!LLFile::isfile(filename))
+	{
+		return false;
+	}
+	LLMappedFile file;
+	if (!file.open(filename, 0, LLMappedFile::READ_ONLY))
+	{
+		return false;
+	}
+	return deserialize(file.getData(), (size_t)file.getSize(), sources, root);
+}
+
+//static
+bool LLXMLNodeCache::write(const std::string& key, const source_list_t& sources, LLXMLNode* root)
+{
+	if (!isEnabled())
+	{
+		return false;
+	}
+	std::string data;
+	serialize(root, sources, data);
+
+	// Through a temporary file, so that nobody maps half a tree
+	std::string filename = getFilename(key);
+	std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");	/* Flawfinder: ignore */
+	if (!fp)
+	{
+		return false;
+	}
+	bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+	ok = (fclose(fp) == 0) && ok;
+	if (ok)
+	{
+		LLFile::remove(filename);
+		ok = LLFile::rename(temp_filename, filename) == 0;
+	}
+	if (!ok)
+	{
+		llwarns << "Couldn't write UI cache file " << filename << llendl;
+		LLFile::remove(temp_filename);
+	}
+	return ok;
+}
+
+//static
+void LLXMLNodeCache::serialize(LLXMLNode* root, const source_list_t& sources, std::string& data)
+{
+	data.clear();
+	put(data, FILE_MAGIC);
+	put(data, FILE_VERSION);
+	put(data, (U32)sources.size());
+	for (source_list_t::const_iterator it = sources.begin(); it != sources.end(); ++it)
+	{
+		put_string(data, it->mFilename);
+		put(data, it->mSize);
+		put(data, it->mModified);
+	}
+	put_node(data, root);
+}
+
+//static
+bool LLXMLNodeCache::deserialize(const U8* data, size_t size, const source_list_t& sources, LLXMLNodePtr& root)
+{
+	Reader reader(data, size);
+	if (reader.get<U32>() != FILE_MAGIC || reader.get<U32>() != FILE_VERSION)
+	{
+		return false;
+	}
+
+	// Built from the same files as they are now?
+	if (reader.get<U32>() != sources.size())
+	{
+		return false;
+	}
+	std::string filename;
+	for (source_list_t::const_iterator it = sources.begin(); it != sources.end(); ++it)
+	{
+		reader.getString(filename);
+		if (!reader.isOK()
+			|| filename != it->mFilename
+			|| reader.get<S64>() != it->mSize
+			|| reader.get<S64>() != it->mModified)
+		{
+			return false;
+		}
+	}
+
+	LLXMLNodePtr node = get_node(reader);
+	if (node.isNull() || !reader.atEnd())
+	{
+		return false;
+	}
+	root = node;
+	return true;
+}
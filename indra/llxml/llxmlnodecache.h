@@ -0,0 +1,79 @@
+/**
+ * @file llxmlnodecache.h
+ * @brief Binary cache of the merged XUI trees built by
+ * LLXMLNode::getLayeredXMLNode().
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLXMLNODECACHE_H
+#define LL_LLXMLNODECACHE_H
+
+#include <string>
+#include <vector>
+
+#include "llxmlnode.h"
+
+// A layered XUI tree is the default skin file with the skin and language
+// layers merged into it. Building one parses every layer with expat and
+// then merges them; this keeps the result in a binary file per tree, which
+// is mapped and turned straight back into nodes the next time.
+//
+// A cached tree records the layer files it was built from, with their size
+// and modification time, and is only used while they are all unchanged.
+// Files are in native byte order and carry a format version, anything that
+// doesn't check out is rebuilt from the XML.
+class LLXMLNodeCache
+{
+public:
+	struct Source
+	{
+		std::string mFilename;
+		S64 mSize;
+		S64 mModified;
+	};
+	typedef std::vector<Source> source_list_t;
+
+	// Keeps trees in dir. An empty dir turns the cache off, which is the
+	// default.
+	static void setCacheDir(const std::string& dir);
+	static bool isEnabled() { return !sCacheDir.empty(); }
+
+	// Appends filename as it is now to sources. Returns false if it can't
+	// be looked at.
+	static bool addSource(const std::string& filename, source_list_t& sources);
+
+	// key names the tree, sources are what it has to have been built from
+	static bool read(const std::string& key, const source_list_t& sources, LLXMLNodePtr& root);
+	static bool write(const std::string& key, const source_list_t& sources, LLXMLNode* root);
+
+	// The file contents, outside of any file
+	static void serialize(LLXMLNode* root, const source_list_t& sources, std::string& data);
+	static bool deserialize(const U8* data, size_t size, const source_list_t& sources, LLXMLNodePtr& root);
+
+private:
+	static std::string getFilename(const std::string& key);
+
+	static std::string sCacheDir;
+};
+
+#endif // LL_LLXMLNODECACHE_H
@@ -152,4 +152,19 @@ namespace tut
 		ensure("listener fired on changed setting", mListenerFired);	   
 	}
 
+	//lookup counts
+	template<> template<>
+	void control_group_t::test<5>()
+	{
+		mCG->loadFromFile(mTestConfigFile.c_str());
+		LLControlVariablePtr control = mCG->getControl("TestSetting");
+		U32 before = control->getLookupCount();
+		mCG->getU32("TestSetting");
+		mCG->setU32("TestSetting", 14);
+		ensure_equals("string lookups counted", control->getLookupCount(), before + 2);
+		mCG->logLookups(1, 10);
+		mCG->resetLookupCounts();
+		ensure_equals("counts reset", control->getLookupCount(), (U32)0);
+	}
+
 }
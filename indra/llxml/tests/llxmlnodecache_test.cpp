@@ -0,0 +1,127 @@
+/**
+ * @file llxmlnodecache_test.cpp
+ * @brief LLXMLNodeCache unit tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include <sstream>
+
+#include "../llxmlnodecache.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct xml_node_cache
+	{
+		LLXMLNodePtr mRoot;
+		LLXMLNodeCache::source_list_t mSources;
+
+		xml_node_cache()
+		{
+			std::string xml =
+				"<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n"
+				"<floater name=\"test\" title=\"Test &amp; more\" width=\"300\">\n"
+				"  <button name=\"ok\" label=\"OK\" left=\"10\" />\n"
+				"  <text name=\"caption\">Some text</text>\n"
+				"  <panel name=\"empty\" />\n"
+				"</floater>\n";
+			LLXMLNode::parseBuffer((U8*)&xml[0], xml.size(), mRoot, NULL);
+
+			LLXMLNodeCache::Source source;
+			source.mFilename = "skins/default/xui/en/floater_test.xml";
+			source.mSize = (S64)xml.size();
+			source.mModified = 1286000000;
+			mSources.push_back(source);
+		}
+
+		static std::string toString(LLXMLNodePtr node)
+		{
+			std::ostringstream str;
+			node->writeToOstream(str);
+			return str.str();
+		}
+	};
+
+	typedef test_group<xml_node_cache> xml_node_cache_test;
+	typedef xml_node_cache_test::object xml_node_cache_t;
+	xml_node_cache_test tut_xml_node_cache("xml_node_cache");
+
+	// a tree comes back out as it went in
+	template<> template<>
+	void xml_node_cache_t::test<1>()
+	{
+		ensure("parsed", mRoot.notNull());
+		std::string data;
+		LLXMLNodeCache::serialize(mRoot, mSources, data);
+
+		LLXMLNodePtr root;
+		ensure("deserialized", LLXMLNodeCache::deserialize((const U8*)data.data(), data.size(), mSources, root));
+		ensure_equals("same tree", toString(root), toString(mRoot));
+
+		std::string title;
+		ensure("attribute", root->getAttributeString("title", title));
+		ensure_equals("attribute value", title, std::string("Test & more"));
+		LLXMLNodePtr text;
+		ensure("child", root->getChild("text", text));
+		ensure_equals("child value", text->getTextContents(), std::string("Some text"));
+	}
+
+	// a tree built from other files isn't used
+	template<> template<>
+	void xml_node_cache_t::test<2>()
+	{
+		std::string data;
+		LLXMLNodeCache::serialize(mRoot, mSources, data);
+
+		LLXMLNodeCache::source_list_t sources = mSources;
+		sources.back().mModified += 1;
+		LLXMLNodePtr root;
+		ensure("changed file", !LLXMLNodeCache::deserialize((const U8*)data.data(), data.size(), sources, root));
+
+		sources = mSources;
+		sources.push_back(mSources.back());
+		sources.back().mFilename = "skins/default/xui/de/floater_test.xml";
+		ensure("new layer", !LLXMLNodeCache::deserialize((const U8*)data.data(), data.size(), sources, root));
+		ensure("untouched", root.isNull());
+	}
+
+	// truncated or padded data isn't used
+	template<> template<>
+	void xml_node_cache_t::test<3>()
+	{
+		std::string data;
+		LLXMLNodeCache::serialize(mRoot, mSources, data);
+
+		LLXMLNodePtr root;
+		for (size_t size = 0; size < data.size(); size += 7)
+		{
+			ensure("truncated", !LLXMLNodeCache::deserialize((const U8*)data.data(), size, mSources, root));
+		}
+		data.push_back('\0');
+		ensure("padded", !LLXMLNodeCache::deserialize((const U8*)data.data(), data.size(), mSources, root));
+		ensure("untouched", root.isNull());
+	}
+}
@@ -66,6 +66,7 @@
 #include "llmutelist.h"
 #include "llviewerhelp.h"
 #include "lluicolortable.h"
+#include "llxmlnodecache.h"
 #include "llurldispatcher.h"
 #include "llurlhistory.h"
 //#include "llfirstuse.h"
@@ -119,6 +120,7 @@
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
 #include "llimageworker.h"
+#include "llavatarupdatethread.h"
 #include "llevents.h"
 
 // The files below handle dependencies from cleanup.
@@ -480,6 +482,12 @@ static void settings_modify()
 		gSavedSettings.setU32("VectorizeProcessor", 0 );
 	}
 	else
+	if (gSysCPU.hasAVX2() && gSysCPU.hasFMA())
+	{
+		gSavedSettings.setBOOL("VectorizeEnable", TRUE );
+		gSavedSettings.setU32("VectorizeProcessor", 3 );
+	}
+	else
 	if (gSysCPU.hasSSE2())
 	{
 		gSavedSettings.setBOOL("VectorizeEnable", TRUE );
@@ -560,6 +568,7 @@ const std::string LLAppViewer::sGlobalSettingsName = "Global";
 
 LLTextureCache* LLAppViewer::sTextureCache = NULL; 
 LLImageDecodeThread* LLAppViewer::sImageDecodeThread = NULL; 
+LLAvatarUpdateThread* LLAppViewer::sAvatarUpdateThread = NULL;
 LLTextureFetch* LLAppViewer::sTextureFetch = NULL; 
 
 LLAppViewer::LLAppViewer() : 
@@ -1582,6 +1591,9 @@ bool LLAppViewer::cleanup()
 	// Save URL history file
 	LLURLHistory::saveFile("url_history.xml");
 
+	// Save which floaters get used, for prebuilding them next time
+	LLViewerFloaterReg::saveUsage();
+
 	// save mute list. gMuteList used to also be deleted here too.
 	LLMuteList::getInstance()->cache(gAgent.getID());
 
@@ -1636,6 +1648,10 @@ bool LLAppViewer::cleanup()
 	sTextureCache->shutdown();
 	sTextureFetch->shutdown();
 	sImageDecodeThread->shutdown();
+	if (sAvatarUpdateThread)
+	{
+		sAvatarUpdateThread->shutdown();
+	}
 	
 	sTextureFetch->shutDownTextureCacheThread() ;
 	sTextureFetch->shutDownImageDecodeThread() ;
@@ -1646,6 +1662,8 @@ bool LLAppViewer::cleanup()
     sTextureFetch = NULL;
 	delete sImageDecodeThread;
     sImageDecodeThread = NULL;
+	delete sAvatarUpdateThread;
+	sAvatarUpdateThread = NULL;
 	delete mFastTimerLogThread;
 	mFastTimerLogThread = NULL;
 	
@@ -1766,11 +1784,31 @@ bool LLAppViewer::initThreads()
 	LLLFSThread::initClass(enable_threads && false);
 
 	// Image decoding
-	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
+	U32 decode_threads = gSavedSettings.getU32("ImageDecodeThreads");
+	if (decode_threads == 0)
+	{
+		// leave a core for the main thread
+		decode_threads = llmax(gSysCPU.getNumCores(), (U32)2) - 1;
+	}
+	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true, decode_threads);
 	LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
 	LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(), sImageDecodeThread, enable_threads && true);
 	LLImage::initClass();
 
+	// Avatar animation
+	U32 avatar_threads = gSavedSettings.getU32("AvatarUpdateThreads");
+	if (enable_threads && avatar_threads > 0)
+	{
+		LLAppViewer::sAvatarUpdateThread = new LLAvatarUpdateThread(avatar_threads);
+	}
+
+	// Volume LODs and sculpts
+	U32 volume_threads = gSavedSettings.getU32("VolumeBuildThreads");
+	if (enable_threads && volume_threads > 0)
+	{
+		LLPrimitive::getVolumeManager()->startBuildThread(true, volume_threads);
+	}
+
 	if (LLFastTimer::sLog || LLFastTimer::sMetricLog)
 	{
 		LLFastTimer::sLogLock = new LLMutex(NULL);
@@ -3270,6 +3308,21 @@ bool LLAppViewer::initCache()
 
 	LLVOCache::getInstance()->initCache(LL_PATH_CACHE, gSavedSettings.getU32("CacheNumberOfRegionsForObjects"), getObjectCacheVersion()) ;
 
+	// Volume geometry, sculpts persist unless another instance owns the cache
+	std::string volume_cache_dir;
+	if (!read_only)
+	{
+		volume_cache_dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "volumecache");
+	}
+	LLPrimitive::getVolumeManager()->enableCache(gSavedSettings.getU32("VolumeCacheMemory") * MB,
+												 volume_cache_dir, gSavedSettings.getU32("VolumeCacheFiles"));
+
+	// Merged XUI trees, checked against the skin files they were built from
+	if (!read_only)
+	{
+		LLXMLNodeCache::setCacheDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "xuicache"));
+	}
+
 	LLSplashScreen::update(LLTrans::getString("StartupInitializingVFS"));
 	
 	// Init the VFS
@@ -3434,6 +3487,8 @@ void LLAppViewer::purgeCache()
 	LLAppViewer::getTextureCache()->purgeCache(LL_PATH_CACHE);
 	LLVOCache::getInstance()->removeCache(LL_PATH_CACHE);
 	std::string mask = gDirUtilp->getDirDelimiter() + "*.*";
+	gDirUtilp->deleteFilesInDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "volumecache"), mask);
+	gDirUtilp->deleteFilesInDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "xuicache"), mask);
 	gDirUtilp->deleteFilesInDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE,""),mask);
 }
 
@@ -3767,6 +3822,20 @@ void LLAppViewer::idle()
 				gObjectList.mNumUnknownUpdates = 0;
 			}
 		}
+
+		// Settings read by name every frame should be LLCachedControls
+		static LLFrameTimer settings_lookup_timer;
+		static U32 settings_lookup_frame = gFrameCount;
+		if (settings_lookup_timer.getElapsedTimeF32() > 60.f)
+		{
+			settings_lookup_timer.reset();
+			if (LLControlGroup::getCountLookups())
+			{
+				gSavedSettings.logLookups(gFrameCount - settings_lookup_frame, 20);
+				gSavedSettings.resetLookupCounts();
+			}
+			settings_lookup_frame = gFrameCount;
+		}
 	}
 
 	if (!gDisconnected)
@@ -37,6 +37,7 @@ class LLFrameTimer;
 class LLPumpIO;
 class LLTextureCache;
 class LLImageDecodeThread;
+class LLAvatarUpdateThread;
 class LLTextureFetch;
 class LLWatchdogTimeout;
 class LLUpdaterService;
@@ -93,6 +94,7 @@ public:
 	static LLTextureCache* getTextureCache() { return sTextureCache; }
 	static LLImageDecodeThread* getImageDecodeThread() { return sImageDecodeThread; }
 	static LLTextureFetch* getTextureFetch() { return sTextureFetch; }
+	static LLAvatarUpdateThread* getAvatarUpdateThread() { return sAvatarUpdateThread; } // NULL when avatars animate on the main thread
 
 	static U32 getTextureCacheVersion() ;
 	static U32 getObjectCacheVersion() ;
@@ -233,6 +235,7 @@ private:
 	static LLTextureCache* sTextureCache; 
 	static LLImageDecodeThread* sImageDecodeThread; 
 	static LLTextureFetch* sTextureFetch;
+	static LLAvatarUpdateThread* sAvatarUpdateThread;
 
 	S32 mNumSessions;
 
@@ -0,0 +1,113 @@
+/**
+ * @file llavatarupdatethread.cpp
+ * @brief Evaluates avatar animation on worker threads.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llavatarupdatethread.h"
+
+#include "llvoavatar.h"
+
+//----------------------------------------------------------------------------
+
+// MAIN THREAD
+LLAvatarUpdateThread::LLAvatarUpdateThread(U32 num_workers)
+	: LLQueuedThread("avatarupdate", true, num_workers),
+	  mDoneCondition(NULL),
+	  mRemaining(0)
+{
+}
+
+// MAIN THREAD
+void LLAvatarUpdateThread::updateAvatars(const avatar_list_t& avatars)
+{
+	if (isQuitting())
+	{
+		for (avatar_list_t::const_iterator iter = avatars.begin();
+			 iter != avatars.end(); ++iter)
+		{
+			(*iter)->evaluateAnimation();
+		}
+		return;
+	}
+
+	mDoneCondition.lock();
+	mRemaining = (S32)avatars.size();
+	mDoneCondition.unlock();
+	for (avatar_list_t::const_iterator iter = avatars.begin();
+		 iter != avatars.end(); ++iter)
+	{
+		UpdateRequest* req = new UpdateRequest(generateHandle(), *iter, this);
+		if (!addRequest(req))
+		{
+			llerrs << "request added after LLAvatarUpdateThread::shutdown()" << llendl;
+		}
+	}
+
+	// Take requests alongside the workers until the queue is empty, then
+	// wait for the ones still running elsewhere
+	while (getPending() > 0)
+	{
+		processNextRequest();
+	}
+	mDoneCondition.lock();
+	while (mRemaining > 0)
+	{
+		mDoneCondition.wait();
+	}
+	mDoneCondition.unlock();
+}
+
+//----------------------------------------------------------------------------
+
+LLAvatarUpdateThread::UpdateRequest::UpdateRequest(handle_t handle, LLVOAvatar* avatar, LLAvatarUpdateThread* thread)
+	: LLQueuedThread::QueuedRequest(handle, LLQueuedThread::PRIORITY_NORMAL, FLAG_AUTO_COMPLETE),
+	  mAvatar(avatar),
+	  mThread(thread)
+{
+}
+
+LLAvatarUpdateThread::UpdateRequest::~UpdateRequest()
+{
+}
+
+// ANY THREAD
+bool LLAvatarUpdateThread::UpdateRequest::processRequest()
+{
+	mAvatar->evaluateAnimation();
+	return true;
+}
+
+// ANY THREAD
+void LLAvatarUpdateThread::UpdateRequest::finishRequest(bool completed)
+{
+	LLCondition& done = mThread->mDoneCondition;
+	done.lock();
+	if (--mThread->mRemaining == 0)
+	{
+		done.signal();
+	}
+	done.unlock();
+}
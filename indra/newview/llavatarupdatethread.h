@@ -0,0 +1,72 @@
+/**
+ * @file llavatarupdatethread.h
+ * @brief Evaluates avatar animation on worker threads.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLAVATARUPDATETHREAD_H
+#define LL_LLAVATARUPDATETHREAD_H
+
+#include "llqueuedthread.h"
+#include "llthread.h"
+
+class LLVOAvatar;
+
+// Runs LLVOAvatar::evaluateAnimation() for a batch of avatars on the
+// workers of a multi-worker LLQueuedThread.  The main thread works through
+// the batch alongside the workers and returns once every avatar is done,
+// so nothing else touches the avatars while their motions and joints are
+// being updated.  See LLVOAvatar::finishIdleUpdates().
+class LLAvatarUpdateThread : public LLQueuedThread
+{
+public:
+	typedef std::vector<LLVOAvatar*> avatar_list_t;
+
+	class UpdateRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~UpdateRequest(); // use deleteRequest()
+
+	public:
+		UpdateRequest(handle_t handle, LLVOAvatar* avatar, LLAvatarUpdateThread* thread);
+
+		/*virtual*/ bool processRequest();
+		/*virtual*/ void finishRequest(bool completed);
+
+	private:
+		LLVOAvatar* mAvatar;
+		LLAvatarUpdateThread* mThread;
+	};
+
+public:
+	LLAvatarUpdateThread(U32 num_workers);
+
+	// MAIN THREAD
+	void updateAvatars(const avatar_list_t& avatars);
+
+private:
+	LLCondition mDoneCondition;	// signaled when mRemaining drops to 0
+	S32 mRemaining;				// guarded by mDoneCondition
+};
+
+#endif // LL_LLAVATARUPDATETHREAD_H
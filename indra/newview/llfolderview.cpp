@@ -76,6 +76,11 @@
 const S32 RENAME_WIDTH_PAD = 4;
 const S32 RENAME_HEIGHT_PAD = 1;
 const S32 AUTO_OPEN_STACK_DEPTH = 16;
+// A couple of milliseconds worth of text measuring
+const S32 MAX_LABEL_MEASUREMENTS_PER_ARRANGE = 1000;
+// Rows of big folders that are scrolled to get their views a screenful
+// or so at a time
+const S32 MAX_PENDING_ITEM_BUILDS_PER_IDLE = 100;
 const S32 MIN_ITEM_WIDTH_VISIBLE = LLFolderViewItem::ICON_WIDTH
 			+ LLFolderViewItem::ICON_PAD 
 			+ LLFolderViewItem::ARROW_SIZE 
@@ -189,6 +194,7 @@ LLFolderView::LLFolderView(const Params& p)
 	mShowSelectionContext(FALSE),
 	mShowSingleSelection(FALSE),
 	mArrangeGeneration(0),
+	mLabelMeasurementsLeft(0),
 	mSignalSelectCallback(0),
 	mMinWidth(0),
 	mDragAndDropThisFrame(FALSE),
@@ -207,6 +213,7 @@ LLFolderView::LLFolderView(const Params& p)
 	mAutoOpenCandidate = NULL;
 	mAutoOpenTimer.stop();
 	mKeyboardSelection = FALSE;
+	mFilter->setSearchIndex(&mSearchIndex);
 	const LLFolderViewItem::Params& item_params =
 		LLUICtrlFactory::getDefaultParams<LLFolderViewItem>();
 	S32 indentation = item_params.folder_indentation();
@@ -291,7 +298,11 @@ LLFolderView::~LLFolderView( void )
 	mFolders.clear();
 
 	mItemMap.clear();
+	mPendingItemMap.clear();
+	mPendingFolders.clear();
 
+	// The items are deleted after us
+	mSearchIndex.clear();
 	delete mFilter;
 	mFilter = NULL;
 }
@@ -401,6 +412,16 @@ void LLFolderView::setOpenArrangeRecursively(BOOL openitem, ERecurseType recurse
 
 static LLFastTimer::DeclareTimer FTM_ARRANGE("Arrange");
 
+bool LLFolderView::takeLabelMeasurement()
+{
+	if (mLabelMeasurementsLeft > 0)
+	{
+		--mLabelMeasurementsLeft;
+		return true;
+	}
+	return false;
+}
+
 // This view grows and shinks to enclose all of its children items and folders.
 S32 LLFolderView::arrange( S32* unused_width, S32* unused_height, S32 filter_generation )
 {
@@ -408,6 +429,7 @@ S32 LLFolderView::arrange( S32* unused_width, S32* unused_height, S32 filter_gen
 
 	filter_generation = mFilter->getMinRequiredGeneration();
 	mMinWidth = 0;
+	mLabelMeasurementsLeft = MAX_LABEL_MEASUREMENTS_PER_ARRANGE;
 
 	mHasVisibleChildren = hasFilteredDescendants(filter_generation);
 	// arrange always finishes, so optimistically set the arrange generation to the most current
@@ -1964,6 +1986,8 @@ void LLFolderView::deleteAllChildren()
 	mRenamer = NULL;
 	mRenameItem = NULL;
 	clearSelection();
+	mPendingItemMap.clear();
+	mPendingFolders.clear();
 	LLView::deleteAllChildren();
 }
 
@@ -2077,9 +2101,87 @@ LLFolderViewItem* LLFolderView::getItemByID(const LLUUID& id)
 		return map_it->second;
 	}
 
+	LLFolderViewFolder* pending_folder = getPendingItemFolder(id);
+	if (pending_folder)
+	{
+		return pending_folder->buildPendingItem(id);
+	}
+
 	return NULL;
 }
 
+void LLFolderView::buildItemView(const LLUUID& id)
+{
+	if (mBuildItemCallback)
+	{
+		mBuildItemCallback(id);
+	}
+}
+
+void LLFolderView::addPendingItemID(const LLUUID& id, LLFolderViewFolder* folder)
+{
+	mPendingItemMap[id] = folder;
+	mPendingFolders.insert(folder);
+}
+
+void LLFolderView::removePendingItemID(const LLUUID& id)
+{
+	std::map<LLUUID, LLFolderViewFolder*>::iterator map_it = mPendingItemMap.find(id);
+	if (map_it != mPendingItemMap.end())
+	{
+		LLFolderViewFolder* folder = map_it->second;
+		mPendingItemMap.erase(map_it);
+		if (folder->getPendingItems().empty())
+		{
+			mPendingFolders.erase(folder);
+		}
+	}
+}
+
+LLFolderViewFolder* LLFolderView::getPendingItemFolder(const LLUUID& id)
+{
+	std::map<LLUUID, LLFolderViewFolder*>::iterator map_it = mPendingItemMap.find(id);
+	return map_it != mPendingItemMap.end() ? map_it->second : NULL;
+}
+
+void LLFolderView::updatePendingItems()
+{
+	if (mPendingFolders.empty() || !mScrollContainer)
+	{
+		return;
+	}
+
+	const LLRect visible_rect = getVisibleRect();
+	S32 builds_left = MAX_PENDING_ITEM_BUILDS_PER_IDLE;
+	// building the last pending row of a folder takes it out of the set
+	std::vector<LLFolderViewFolder*> folders(mPendingFolders.begin(), mPendingFolders.end());
+	for (std::vector<LLFolderViewFolder*>::iterator it = folders.begin();
+		 it != folders.end() && builds_left > 0; ++it)
+	{
+		LLFolderViewFolder* folderp = *it;
+		if (!folderp->isOpen() || !folderp->isInVisibleChain())
+		{
+			continue;
+		}
+
+		LLRect folder_rect;
+		folderp->localRectToOtherView(folderp->getLocalRect(), &folder_rect, this);
+		if (!folder_rect.overlaps(visible_rect))
+		{
+			continue;
+		}
+		builds_left -= folderp->buildVisiblePendingItems(visible_rect.mBottom - folder_rect.mBottom,
+														 visible_rect.mTop - folder_rect.mBottom,
+														 builds_left);
+	}
+
+	if (builds_left < MAX_PENDING_ITEM_BUILDS_PER_IDLE)
+	{
+		// lay the new rows out before they are drawn
+		arrangeFromRoot();
+	}
+}
+
 LLFolderViewFolder* LLFolderView::getFolderByID(const LLUUID& id)
 {
 	if (id.isNull())
@@ -2297,6 +2399,7 @@ void LLFolderView::doIdle()
 		{
 			arrangeFromRoot();
 		}
+		updatePendingItems();
 	}
 
 	if (mSelectedItems.size() && mNeedsScroll)
@@ -36,6 +36,7 @@
 #define LL_LLFOLDERVIEW_H
 
 #include "llfolderviewitem.h"	// because LLFolderView is-a LLFolderViewFolder
+#include "llinventorysearchindex.h"
 
 #include "lluictrl.h"
 #include "v4color.h"
@@ -47,6 +48,8 @@
 #include "lltooldraganddrop.h"
 #include "llviewertexture.h"
 
+#include <boost/function.hpp>
+
 class LLFolderViewEventListener;
 class LLFolderViewFolder;
 class LLFolderViewItem;
@@ -111,6 +114,8 @@ public:
 	
 	// filter is never null
 	LLInventoryFilter* getFilter();
+	// Labels of the items in this view, for the filter
+	LLInventorySearchIndex& getSearchIndex() { return mSearchIndex; }
 	const std::string getFilterSubString(BOOL trim = FALSE);
 	U32 getFilterObjectTypes() const;
 	PermissionMask getFilterPermissions() const;
@@ -135,6 +140,10 @@ public:
 
 	void arrangeAll() { mArrangeGeneration++; }
 	S32 getArrangeGeneration() { return mArrangeGeneration; }
+	// Measuring labels is most of the cost of arranging thousands of new
+	// items, so only so many are measured per arrange. Returns false once
+	// they have been.
+	bool takeLabelMeasurement();
 
 	// applies filters to control visibility of inventory items
 	virtual void filter( LLInventoryFilter& filter);
@@ -244,8 +253,17 @@ public:
 
 	void addItemID(const LLUUID& id, LLFolderViewItem* itemp);
 	void removeItemID(const LLUUID& id);
+	// Builds the view of a pending row, see LLFolderViewFolder::addPendingItem()
 	LLFolderViewItem* getItemByID(const LLUUID& id);
 	LLFolderViewFolder* getFolderByID(const LLUUID& id);
+
+	// Pending rows of big folders get their views from the owner of the view
+	typedef boost::function<void (const LLUUID& id)> build_item_callback_t;
+	void setBuildItemCallback(const build_item_callback_t& cb) { mBuildItemCallback = cb; }
+	void buildItemView(const LLUUID& id);
+	void addPendingItemID(const LLUUID& id, LLFolderViewFolder* folder);
+	void removePendingItemID(const LLUUID& id);
+	LLFolderViewFolder* getPendingItemFolder(const LLUUID& id);
 	
 	bool doToSelected(LLInventoryModel* model, const LLSD& userdata);
 	
@@ -283,6 +301,9 @@ protected:
 
 	bool selectFirstItem();
 	bool selectLastItem();
+
+	// Builds the pending rows that have been scrolled to
+	void updatePendingItems();
 	
 	BOOL addNoOptions(LLMenuGL* menu) const;
 
@@ -318,16 +339,21 @@ protected:
 	LLFrameTimer					mSearchTimer;
 	std::string						mSearchString;
 	LLInventoryFilter*				mFilter;
+	LLInventorySearchIndex			mSearchIndex;
 	BOOL							mShowSelectionContext;
 	BOOL							mShowSingleSelection;
 	LLFrameTimer					mMultiSelectionFadeTimer;
 	S32								mArrangeGeneration;
+	S32								mLabelMeasurementsLeft;
 
 	signal_t						mSelectSignal;
 	signal_t						mReshapeSignal;
 	S32								mSignalSelectCallback;
 	S32								mMinWidth;
 	std::map<LLUUID, LLFolderViewItem*> mItemMap;
+	std::map<LLUUID, LLFolderViewFolder*> mPendingItemMap;
+	std::set<LLFolderViewFolder*>	mPendingFolders;
+	build_item_callback_t			mBuildItemCallback;
 	BOOL							mDragAndDropThisFrame;
 	
 	LLUUID							mSelectThisID; // if non null, select this item
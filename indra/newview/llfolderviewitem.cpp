@@ -32,6 +32,7 @@
 #include "llfoldervieweventlistener.h"
 #include "llinventorybridge.h"	// for LLItemBridge in LLInventorySort::operator()
 #include "llinventoryfilter.h"
+#include "llinventoryfunctions.h"	// get_is_item_removable() for pending rows
 #include "llinventorymodelbackgroundfetch.h"
 #include "llpanel.h"
 #include "llviewercontrol.h"	// gSavedSettings
@@ -139,6 +140,10 @@ LLFolderViewItem::LLFolderViewItem(const LLFolderViewItem::Params& p)
 // Destroys the object
 LLFolderViewItem::~LLFolderViewItem( void )
 {
+	if (mRoot && getSearchIndexSlot() >= 0)
+	{
+		mRoot->getSearchIndex().removeItem(this);
+	}
 	delete mListener;
 	mListener = NULL;
 }
@@ -302,6 +307,10 @@ void LLFolderViewItem::refresh()
 	if (mSearchableLabel.compare(searchable_label))
 	{
 		mSearchableLabel.assign(searchable_label);
+		if (mRoot)
+		{
+			mRoot->getSearchIndex().setLabel(this, mSearchableLabel);
+		}
 		dirtyFilter();
 		// some part of label has changed, so overall width has potentially changed, and sort order too
 		if (mParentFolder)
@@ -414,8 +423,8 @@ BOOL LLFolderViewItem::addToFolder(LLFolderViewFolder* folder, LLFolderView* roo
 // makes sure that this view and it's children are the right size.
 S32 LLFolderViewItem::arrange( S32* width, S32* height, S32 filter_generation)
 {
-	const Params& p = LLUICtrlFactory::getDefaultParams<LLFolderViewItem>();
-	S32 indentation = p.folder_indentation();
+	// called for every visible item, don't look the params up each time
+	static const S32 indentation = LLUICtrlFactory::getDefaultParams<LLFolderViewItem>().folder_indentation();
 	// Only indent deeper items in hierarchy
 	mIndentation = (getParentFolder() 
 					&& getParentFolder()->getParentFolder() )
@@ -423,8 +432,16 @@ S32 LLFolderViewItem::arrange( S32* width, S32* height, S32 filter_generation)
 		: 0;
 	if (mLabelWidthDirty)
 	{
-		mLabelWidth = ARROW_SIZE + TEXT_PAD + ICON_WIDTH + ICON_PAD + getLabelFontForStyle(mLabelStyle)->getWidth(mSearchableLabel); 
-		mLabelWidthDirty = false;
+		if (getRoot()->takeLabelMeasurement())
+		{
+			mLabelWidth = ARROW_SIZE + TEXT_PAD + ICON_WIDTH + ICON_PAD + getLabelFontForStyle(mLabelStyle)->getWidth(mSearchableLabel); 
+			mLabelWidthDirty = false;
+		}
+		else if (mParentFolder)
+		{
+			// measure it on a later arrange, the old width will do until then
+			mParentFolder->requestArrange();
+		}
 	}
 
 	*width = llmax(*width, mLabelWidth + mIndentation); 
@@ -1147,11 +1164,13 @@ BOOL LLFolderViewFolder::addToFolder(LLFolderViewFolder* folder, LLFolderView* r
 // makes sure that this view and it's children are the right size.
 S32 LLFolderViewFolder::arrange( S32* width, S32* height, S32 filter_generation)
 {
-	// sort before laying out contents
-	if (mNeedsSort)
+	// sort before laying out contents, closed folders can wait until
+	// they are opened
+	if (mNeedsSort && mIsOpen)
 	{
-		mFolders.sort(mSortFunction);
-		mItems.sort(mSortFunction);
+		mSortFunction.sort(mFolders);
+		mSortFunction.sort(mItems);
+		mSortFunction.sort(mPendingItems);
 		mNeedsSort = false;
 	}
 
@@ -1207,10 +1226,28 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height, S32 filter_generation)
 					folderp->setOrigin( 0, child_top - folderp->getRect().getHeight() );
 				}
 			}
+			// Pending rows only take up space, they pass the filter while
+			// it is inactive and are built before it is applied
+			const bool show_pending = !getRoot()->getFilter()->isActive();
+			LLInventorySort::pending_items_t::iterator pit = mPendingItems.begin();
 			for(items_t::iterator iit = mItems.begin();
-				iit != mItems.end(); ++iit)
+				iit != mItems.end() || pit != mPendingItems.end(); )
 			{
+				if (pit != mPendingItems.end()
+					&& (iit == mItems.end() || mSortFunction.lessThan(*pit, *iit)))
+				{
+					pit->mTop = parent_item_height - llround(running_height);
+					if (show_pending)
+					{
+						running_height += (F32)mItemHeight;
+						target_height += (F32)mItemHeight;
+					}
+					++pit;
+					continue;
+				}
+
 				LLFolderViewItem* itemp = (*iit);
+				++iit;
 				if (getRoot()->getDebugFilters())
 				{
 					itemp->setVisible(TRUE);
@@ -1422,6 +1459,20 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 		}
 	}
 
+	if (!mPendingItems.empty())
+	{
+		if (filter.isActive())
+		{
+			// the filter needs views to look at
+			buildPendingItems(mPendingItems.begin(), mPendingItems.end());
+		}
+		else
+		{
+			// everything passes an inactive filter
+			mMostFilteredDescendantGeneration = filter_generation;
+		}
+	}
+
 	for (items_t::iterator iter = mItems.begin();
 		 iter != mItems.end();
 		 ++iter)
@@ -1621,6 +1672,34 @@ void LLFolderViewFolder::extendSelection(LLFolderViewItem* selection, LLFolderVi
 		(*fit)->extendSelection(selection, last_selected, selected_items);
 	}
 
+	// pending rows in the range need views to be selected
+	if (!mPendingItems.empty() && last_selected
+		&& selection->getParentFolder() == this && last_selected->getParentFolder() == this)
+	{
+		const bool selection_is_item = std::find(mItems.begin(), mItems.end(), selection) != mItems.end();
+		const bool last_is_item = std::find(mItems.begin(), mItems.end(), last_selected) != mItems.end();
+		if (selection_is_item || last_is_item)
+		{
+			// a folder is above all the item rows
+			const LLFolderViewItem* above = NULL;
+			const LLFolderViewItem* below = selection_is_item ? selection : last_selected;
+			if (selection_is_item && last_is_item)
+			{
+				const bool selection_first = mSortFunction(selection, last_selected);
+				above = selection_first ? selection : last_selected;
+				below = selection_first ? last_selected : selection;
+			}
+			LLInventorySort::pending_items_t::iterator begin;
+			LLInventorySort::pending_items_t::iterator end;
+			getPendingItemRange(above, below, begin, end);
+			if (begin != end)
+			{
+				buildPendingItems(begin, end);
+				mSortFunction.sort(mItems);
+			}
+		}
+	}
+
 	// handle selection of our immediate children...
 	BOOL reverse_select = FALSE;
 	BOOL found_last_selected = FALSE;
@@ -1726,6 +1805,14 @@ void LLFolderViewFolder::extendSelection(LLFolderViewItem* selection, LLFolderVi
 
 void LLFolderViewFolder::destroyView()
 {
+	LLInventorySort::pending_items_t pending_items;
+	pending_items.swap(mPendingItems);
+	for (LLInventorySort::pending_items_t::iterator it = pending_items.begin();
+		it != pending_items.end(); ++it)
+	{
+		getRoot()->removePendingItemID(it->mID);
+	}
+
 	for (items_t::iterator iter = mItems.begin();
 		iter != mItems.end();)
 	{
@@ -1843,8 +1930,9 @@ void LLFolderViewFolder::sortBy(U32 order)
 		(*fit)->sortBy(order);
 	}
 
-	mFolders.sort(mSortFunction);
-	mItems.sort(mSortFunction);
+	mSortFunction.sort(mFolders);
+	mSortFunction.sort(mItems);
+	mSortFunction.sort(mPendingItems);
 
 	if (order & LLInventoryFilter::SO_DATE)
 	{
@@ -1856,6 +1944,11 @@ void LLFolderViewFolder::sortBy(U32 order)
 			latest = item->getCreationDate();
 		}
 
+		if (!mPendingItems.empty())
+		{
+			latest = llmax(latest, mPendingItems.front().mCreationDate);
+		}
+
 		if (!mFolders.empty())
 		{
 			LLFolderViewFolder* folder = *(mFolders.begin());
@@ -1879,8 +1972,9 @@ void LLFolderViewFolder::setItemSortOrder(U32 ordering)
 			(*fit)->setItemSortOrder(ordering);
 		}
 
-		mFolders.sort(mSortFunction);
-		mItems.sort(mSortFunction);
+		mSortFunction.sort(mFolders);
+		mSortFunction.sort(mItems);
+		mSortFunction.sort(mPendingItems);
 	}
 }
 
@@ -1954,6 +2048,16 @@ BOOL LLFolderViewFolder::isRemovable()
 			}
 		}
 
+		// what the bridge of a pending row would answer
+		for (LLInventorySort::pending_items_t::const_iterator pit = mPendingItems.begin();
+			pit != mPendingItems.end(); ++pit)
+		{
+			if (!get_is_item_removable(&gInventory, pit->mID))
+			{
+				return FALSE;
+			}
+		}
+
 		for (folders_t::iterator iter = mFolders.begin();
 			iter != mFolders.end();)
 		{
@@ -2003,6 +2107,174 @@ BOOL LLFolderViewFolder::addFolder(LLFolderViewFolder* folder)
 	return TRUE;
 }
 
+void LLFolderViewFolder::addPendingItem(LLInventoryItem* item)
+{
+	if (!item)
+	{
+		return;
+	}
+
+	const LLUUID& id = item->getUUID();
+	LLInventorySort::PendingItem* pending = NULL;
+	if (getRoot()->getPendingItemFolder(id) == this)
+	{
+		for (LLInventorySort::pending_items_t::iterator it = mPendingItems.begin();
+			it != mPendingItems.end(); ++it)
+		{
+			if (it->mID == id)
+			{
+				pending = &(*it);
+				break;
+			}
+		}
+	}
+	if (!pending)
+	{
+		mPendingItems.push_back(LLInventorySort::PendingItem());
+		pending = &mPendingItems.back();
+		pending->mID = id;
+		pending->mTop = 0;
+		getRoot()->addPendingItemID(id, this);
+	}
+
+	// what LLItemBridge::buildDisplayName() will label it with
+	pending->mLabel = item->getName();
+	pending->mCreationDate = item->getCreationDate();
+
+	setCompletedFilterGeneration(-1, TRUE);
+	requestSort();
+}
+
+void LLFolderViewFolder::removePendingItem(const LLUUID& id)
+{
+	for (LLInventorySort::pending_items_t::iterator it = mPendingItems.begin();
+		it != mPendingItems.end(); ++it)
+	{
+		if (it->mID == id)
+		{
+			mPendingItems.erase(it);
+			getRoot()->removePendingItemID(id);
+			requestArrange();
+			return;
+		}
+	}
+}
+
+LLFolderViewItem* LLFolderViewFolder::buildPendingItem(const LLUUID& id)
+{
+	removePendingItem(id);
+	return buildItemView(id);
+}
+
+LLFolderViewItem* LLFolderViewFolder::buildItemView(const LLUUID& id)
+{
+	LLFolderView* root = getRoot();
+	root->buildItemView(id);
+	LLFolderViewItem* itemp = root->getItemByID(id);
+	if (itemp && !root->getFilter()->isActive())
+	{
+		// it passed the filter while it was pending, keep it in place
+		itemp->setFiltered(TRUE, root->getFilter()->getCurrentGeneration());
+	}
+	return itemp;
+}
+
+void LLFolderViewFolder::buildPendingItems(LLInventorySort::pending_items_t::iterator begin,
+										   LLInventorySort::pending_items_t::iterator end)
+{
+	uuid_vec_t ids;
+	ids.reserve(end - begin);
+	for (LLInventorySort::pending_items_t::iterator it = begin; it != end; ++it)
+	{
+		ids.push_back(it->mID);
+	}
+	// taking them all out at once, many rows may be built
+	mPendingItems.erase(begin, end);
+	requestArrange();
+
+	for (uuid_vec_t::iterator it = ids.begin(); it != ids.end(); ++it)
+	{
+		getRoot()->removePendingItemID(*it);
+		buildItemView(*it);
+	}
+}
+
+void LLFolderViewFolder::getPendingItemRange(const LLFolderViewItem* above, const LLFolderViewItem* below,
+											 LLInventorySort::pending_items_t::iterator& begin,
+											 LLInventorySort::pending_items_t::iterator& end)
+{
+	LLInventorySort::PendingItemLess less(mSortFunction);
+	begin = above ? std::upper_bound(mPendingItems.begin(), mPendingItems.end(), above, less) : mPendingItems.begin();
+	end = below ? std::lower_bound(begin, mPendingItems.end(), below, less) : mPendingItems.end();
+}
+
+LLFolderViewItem* LLFolderViewFolder::buildPendingItemBetween(const LLFolderViewItem* above, const LLFolderViewItem* below, bool nearest_top)
+{
+	if (mPendingItems.empty() || getRoot()->getFilter()->isActive())
+	{
+		return NULL;
+	}
+
+	LLInventorySort::pending_items_t::iterator begin;
+	LLInventorySort::pending_items_t::iterator end;
+	getPendingItemRange(above, below, begin, end);
+	if (begin == end)
+	{
+		return NULL;
+	}
+
+	LLFolderViewItem* itemp = buildPendingItem(nearest_top ? begin->mID : (end - 1)->mID);
+	if (itemp && itemp->getParentFolder() == this)
+	{
+		// navigation goes on from here before the next arrange, so put
+		// the row in place and don't let it be skipped as invisible
+		mItems.remove(itemp);
+		mItems.insert(std::upper_bound(mItems.begin(), mItems.end(), itemp, mSortFunction), itemp);
+		itemp->setVisible(TRUE);
+	}
+	return itemp;
+}
+
+S32 LLFolderViewFolder::buildVisiblePendingItems(S32 bottom, S32 top, S32 max_count)
+{
+	if (!mIsOpen || getRoot()->getFilter()->isActive())
+	{
+		return 0;
+	}
+
+	// rows go down the folder in order, find the first one below top
+	S32 first = 0;
+	S32 last = (S32)mPendingItems.size();
+	while (first < last)
+	{
+		S32 mid = (first + last) / 2;
+		if (mPendingItems[mid].mTop - mItemHeight >= top)
+		{
+			first = mid + 1;
+		}
+		else
+		{
+			last = mid;
+		}
+	}
+
+	uuid_vec_t ids;
+	for (S32 i = first; i < (S32)mPendingItems.size() && (S32)ids.size() < max_count; ++i)
+	{
+		if (mPendingItems[i].mTop <= bottom)
+		{
+			break;
+		}
+		ids.push_back(mPendingItems[i].mID);
+	}
+
+	for (uuid_vec_t::iterator it = ids.begin(); it != ids.end(); ++it)
+	{
+		buildPendingItem(*it);
+	}
+	return (S32)ids.size();
+}
+
 void LLFolderViewFolder::requestArrange(BOOL include_descendants)	
 { 
 	mLastArrangeGeneration = -1; 
@@ -2348,6 +2620,8 @@ BOOL	LLFolderViewFolder::potentiallyVisible()
 LLFolderViewItem* LLFolderViewFolder::getNextFromChild( LLFolderViewItem* item, BOOL include_children )
 {
 	BOOL found_item = FALSE;
+	// the item row we start from, pending rows below it come next
+	LLFolderViewItem* previous_item = NULL;
 
 	LLFolderViewItem* result = NULL;
 	// when not starting from a given item, start at beginning
@@ -2393,6 +2667,7 @@ LLFolderViewItem* LLFolderViewFolder::getNextFromChild( LLFolderViewItem* item,
 				if(item == (*iit))
 				{
 					found_item = TRUE;
+					previous_item = item;
 					// point to next item
 					++iit;
 					break;
@@ -2437,6 +2712,13 @@ LLFolderViewItem* LLFolderViewFolder::getNextFromChild( LLFolderViewItem* item,
 		{
 			result = (*iit);
 		}
+
+		// unless a pending row comes before it
+		LLFolderViewItem* pending_item = buildPendingItemBetween(previous_item, result, true);
+		if (pending_item)
+		{
+			result = pending_item;
+		}
 	}
 
 	if( !result && mParentFolder )
@@ -2453,6 +2735,9 @@ LLFolderViewItem* LLFolderViewFolder::getNextFromChild( LLFolderViewItem* item,
 LLFolderViewItem* LLFolderViewFolder::getPreviousFromChild( LLFolderViewItem* item, BOOL include_children )
 {
 	BOOL found_item = FALSE;
+	// pending rows are only looked at going up from an item row or the end
+	BOOL from_items = (item == NULL);
+	LLFolderViewItem* next_item = NULL;
 
 	LLFolderViewItem* result = NULL;
 	// when not starting from a given item, start at end
@@ -2477,6 +2762,8 @@ LLFolderViewItem* LLFolderViewFolder::getPreviousFromChild( LLFolderViewItem* it
 			if(item == (*iit))
 			{
 				found_item = TRUE;
+				from_items = TRUE;
+				next_item = item;
 				// point to next item
 				++iit;
 				break;
@@ -2522,7 +2809,18 @@ LLFolderViewItem* LLFolderViewFolder::getPreviousFromChild( LLFolderViewItem* it
 		// we found an appropriate item
 		result = (*iit);
 	}
-	else
+
+	if (from_items)
+	{
+		// a pending row may come before it
+		LLFolderViewItem* pending_item = buildPendingItemBetween(result, next_item, false);
+		if (pending_item)
+		{
+			result = pending_item;
+		}
+	}
+
+	if (!result)
 	{
 		// otherwise, scan for next visible folder
 		while(fit != fend && !(*fit)->getVisible())
@@ -2571,62 +2869,85 @@ bool LLInventorySort::updateSort(U32 order)
 
 bool LLInventorySort::operator()(const LLFolderViewItem* const& a, const LLFolderViewItem* const& b)
 {
+	SortKey a_key;
+	SortKey b_key;
+	makeKey(a, a_key);
+	makeKey(b, b_key);
+	return lessThan(a_key, b_key);
+}
+
+//static
+void LLInventorySort::makeKey(const LLFolderViewItem* item, SortKey& key)
+{
+	key.mItem = const_cast<LLFolderViewItem*>(item);
+	key.mLabel = &item->getLabel();
+	key.mCreationDate = item->getCreationDate();
+	key.mSortGroup = item->getSortGroup();
+	key.mIsFavorite = false;
+	key.mHasSortField = false;
+	key.mSortField = 0;
+
 	// ignore sort order for landmarks in the Favorites folder.
 	// they should be always sorted as in Favorites bar. See EXT-719
-	if (a->getSortGroup() == SG_ITEM && b->getSortGroup() == SG_ITEM
-		&& a->getListener()->getInventoryType() == LLInventoryType::IT_LANDMARK
-		&& b->getListener()->getInventoryType() == LLInventoryType::IT_LANDMARK)
+	if (key.mSortGroup == SG_ITEM
+		&& item->getListener()->getInventoryType() == LLInventoryType::IT_LANDMARK)
 	{
-
 		static const LLUUID& favorites_folder_id = gInventory.findCategoryUUIDForType(LLFolderType::FT_FAVORITE);
 
-		LLUUID a_uuid = a->getParentFolder()->getListener()->getUUID();
-		LLUUID b_uuid = b->getParentFolder()->getListener()->getUUID();
-
-		if ((a_uuid == favorites_folder_id && b_uuid == favorites_folder_id))
+		if (item->getParentFolder()->getListener()->getUUID() == favorites_folder_id)
 		{
+			key.mIsFavorite = true;
 			// *TODO: mantipov: probably it is better to add an appropriate method to LLFolderViewItem
 			// or to LLInvFVBridge
-			LLViewerInventoryItem* aitem = (static_cast<const LLItemBridge*>(a->getListener()))->getItem();
-			LLViewerInventoryItem* bitem = (static_cast<const LLItemBridge*>(b->getListener()))->getItem();
-			if (!aitem || !bitem)
-				return false;
-			S32 a_sort = aitem->getSortField();
-			S32 b_sort = bitem->getSortField();
-			return a_sort < b_sort;
+			LLViewerInventoryItem* inv_item = (static_cast<const LLItemBridge*>(item->getListener()))->getItem();
+			if (inv_item)
+			{
+				key.mHasSortField = true;
+				key.mSortField = inv_item->getSortField();
+			}
 		}
 	}
+}
+
+bool LLInventorySort::lessThan(const SortKey& a, const SortKey& b) const
+{
+	if (a.mIsFavorite && b.mIsFavorite)
+	{
+		if (!a.mHasSortField || !b.mHasSortField)
+			return false;
+		return a.mSortField < b.mSortField;
+	}
 
 	// We sort by name if we aren't sorting by date
 	// OR if these are folders and we are sorting folders by name.
 	bool by_name = (!mByDate 
 		|| (mFoldersByName 
-		&& (a->getSortGroup() != SG_ITEM)));
+		&& (a.mSortGroup != SG_ITEM)));
 
-	if (a->getSortGroup() != b->getSortGroup())
+	if (a.mSortGroup != b.mSortGroup)
 	{
 		if (mSystemToTop)
 		{
 			// Group order is System Folders, Trash, Normal Folders, Items
-			return (a->getSortGroup() < b->getSortGroup());
+			return (a.mSortGroup < b.mSortGroup);
 		}
 		else if (mByDate)
 		{
 			// Trash needs to go to the bottom if we are sorting by date
-			if ( (a->getSortGroup() == SG_TRASH_FOLDER)
-				|| (b->getSortGroup() == SG_TRASH_FOLDER))
+			if ( (a.mSortGroup == SG_TRASH_FOLDER)
+				|| (b.mSortGroup == SG_TRASH_FOLDER))
 			{
-				return (b->getSortGroup() == SG_TRASH_FOLDER);
+				return (b.mSortGroup == SG_TRASH_FOLDER);
 			}
 		}
 	}
 
 	if (by_name)
 	{
-		S32 compare = LLStringUtil::compareDict(a->getLabel(), b->getLabel());
+		S32 compare = LLStringUtil::compareDict(*a.mLabel, *b.mLabel);
 		if (0 == compare)
 		{
-			return (a->getCreationDate() > b->getCreationDate());
+			return (a.mCreationDate > b.mCreationDate);
 		}
 		else
 		{
@@ -2635,17 +2956,57 @@ bool LLInventorySort::operator()(const LLFolderViewItem* const& a, const LLFolde
 	}
 	else
 	{
-		// BUG: This is very very slow.  The getCreationDate() is log n in number
-		// of inventory items.
-		time_t first_create = a->getCreationDate();
-		time_t second_create = b->getCreationDate();
-		if (first_create == second_create)
+		if (a.mCreationDate == b.mCreationDate)
 		{
-			return (LLStringUtil::compareDict(a->getLabel(), b->getLabel()) < 0);
+			return (LLStringUtil::compareDict(*a.mLabel, *b.mLabel) < 0);
 		}
 		else
 		{
-			return (first_create > second_create);
+			return (a.mCreationDate > b.mCreationDate);
 		}
 	}
 }
+
+//static
+void LLInventorySort::makeKey(const PendingItem& item, SortKey& key)
+{
+	key.mItem = NULL;
+	key.mLabel = &item.mLabel;
+	key.mCreationDate = item.mCreationDate;
+	key.mSortGroup = SG_ITEM;
+	key.mIsFavorite = false;
+	key.mHasSortField = false;
+	key.mSortField = 0;
+}
+
+bool LLInventorySort::lessThan(const PendingItem& a, const PendingItem& b) const
+{
+	SortKey a_key;
+	SortKey b_key;
+	makeKey(a, a_key);
+	makeKey(b, b_key);
+	return lessThan(a_key, b_key);
+}
+
+bool LLInventorySort::lessThan(const PendingItem& a, const LLFolderViewItem* b) const
+{
+	SortKey a_key;
+	SortKey b_key;
+	makeKey(a, a_key);
+	makeKey(b, b_key);
+	return lessThan(a_key, b_key);
+}
+
+bool LLInventorySort::lessThan(const LLFolderViewItem* a, const PendingItem& b) const
+{
+	SortKey a_key;
+	SortKey b_key;
+	makeKey(a, a_key);
+	makeKey(b, b_key);
+	return lessThan(a_key, b_key);
+}
+
+void LLInventorySort::sort(pending_items_t& items)
+{
+	std::stable_sort(items.begin(), items.end(), PendingItemLess(*this));
+}
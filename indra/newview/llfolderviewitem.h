@@ -26,8 +26,13 @@
 #ifndef LLFOLDERVIEWITEM_H
 #define LLFOLDERVIEWITEM_H
 
+#include <algorithm>
+#include <vector>
+
 #include "llview.h"
 #include "lldarray.h"  // *TODO: Eliminate, forward declare
+#include "llinventorysearchindex.h"
+#include "lluuid.h"
 
 class LLFontGL;
 class LLFolderView;
@@ -37,6 +42,7 @@ class LLFolderViewFunctor;
 class LLFolderViewItem;
 class LLFolderViewListenerFunctor;
 class LLInventoryFilter;
+class LLInventoryItem;
 class LLMenuGL;
 class LLUIImage;
 class LLViewerInventoryItem;
@@ -67,7 +73,65 @@ public:
 	U32 getSort() { return mSortOrder; }
 
 	bool operator()(const LLFolderViewItem* const& a, const LLFolderViewItem* const& b);
+
+	// Sorts a list of items like list.sort(*this) would, asking each item
+	// for what the comparison needs once instead of at every comparison.
+	// Creation dates of folders in particular aren't cheap.
+	template <class LIST>
+	void sort(LIST& items);
+
+	// An item row of a big folder that has no view yet, see
+	// LLFolderViewFolder::addPendingItem(). It sorts by what its view
+	// would show.
+	struct PendingItem
+	{
+		LLUUID mID;
+		std::string mLabel;
+		time_t mCreationDate;
+		// Top of the row in its folder as of the last arrange
+		S32 mTop;
+	};
+	typedef std::vector<PendingItem> pending_items_t;
+
+	// Pending rows are items, and never in the Favorites folder
+	void sort(pending_items_t& items);
+	bool lessThan(const PendingItem& a, const PendingItem& b) const;
+	bool lessThan(const PendingItem& a, const LLFolderViewItem* b) const;
+	bool lessThan(const LLFolderViewItem* a, const PendingItem& b) const;
+
+	// For searching sorted pending rows
+	struct PendingItemLess
+	{
+		PendingItemLess(const LLInventorySort& sort) : mSort(sort) {}
+		bool operator()(const PendingItem& a, const PendingItem& b) const { return mSort.lessThan(a, b); }
+		bool operator()(const PendingItem& a, const LLFolderViewItem* b) const { return mSort.lessThan(a, b); }
+		bool operator()(const LLFolderViewItem* a, const PendingItem& b) const { return mSort.lessThan(a, b); }
+		const LLInventorySort& mSort;
+	};
+
 private:
+	struct SortKey
+	{
+		LLFolderViewItem* mItem;
+		const std::string* mLabel;
+		time_t mCreationDate;
+		EInventorySortGroup mSortGroup;
+		// Landmarks in the Favorites folder keep the order of the Favorites bar
+		bool mIsFavorite;
+		bool mHasSortField;
+		S32 mSortField;
+	};
+	struct SortKeyLess
+	{
+		SortKeyLess(const LLInventorySort& sort) : mSort(sort) {}
+		bool operator()(const SortKey& a, const SortKey& b) const { return mSort.lessThan(a, b); }
+		const LLInventorySort& mSort;
+	};
+
+	static void makeKey(const LLFolderViewItem* item, SortKey& key);
+	static void makeKey(const PendingItem& item, SortKey& key);
+	bool lessThan(const SortKey& a, const SortKey& b) const;
+
 	U32  mSortOrder;
 	bool mByDate;
 	bool mSystemToTop;
@@ -81,7 +145,7 @@ private:
 // such as an inventory item or a file.
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-class LLFolderViewItem : public LLView
+class LLFolderViewItem : public LLView, public LLInventorySearchIndex::Item
 {
 public:
 	static void initClass();
@@ -391,6 +455,21 @@ protected:
 	S32			mCompletedFilterGeneration;
 	S32			mMostFilteredDescendantGeneration;
 	bool		mNeedsSort;
+	// Item rows that have no view yet, sorted like mItems
+	LLInventorySort::pending_items_t mPendingItems;
+
+	// Pending rows below above and above below, NULL for no bound.
+	// Both are rows of this folder.
+	void getPendingItemRange(const LLFolderViewItem* above, const LLFolderViewItem* below,
+							 LLInventorySort::pending_items_t::iterator& begin,
+							 LLInventorySort::pending_items_t::iterator& end);
+	void buildPendingItems(LLInventorySort::pending_items_t::iterator begin,
+						   LLInventorySort::pending_items_t::iterator end);
+	// Builds the view of a row that is no longer pending
+	LLFolderViewItem* buildItemView(const LLUUID& id);
+	// Builds the pending row nearest to the top or bottom of the range,
+	// for keyboard navigation
+	LLFolderViewItem* buildPendingItemBetween(const LLFolderViewItem* above, const LLFolderViewItem* below, bool nearest_top);
 public:
 	typedef enum e_recurse_type
 	{
@@ -521,6 +600,18 @@ public:
 	virtual BOOL addItem(LLFolderViewItem* item);
 	virtual BOOL addFolder( LLFolderViewFolder* folder);
 
+	// Big folders leave their item rows without a view until they are
+	// scrolled to or looked up by ID. Adding a row that is already
+	// pending updates its label and date.
+	void addPendingItem(LLInventoryItem* item);
+	void removePendingItem(const LLUUID& id);
+	const LLInventorySort::pending_items_t& getPendingItems() const { return mPendingItems; }
+	// Returns the new view, NULL if the item has none
+	LLFolderViewItem* buildPendingItem(const LLUUID& id);
+	// Builds up to max_count pending rows between bottom and top, in this
+	// folder's coordinates. Returns how many were built.
+	S32 buildVisiblePendingItems(S32 bottom, S32 top, S32 max_count);
+
 	// LLView functionality
 	virtual BOOL handleHover(S32 x, S32 y, MASK mask);
 	virtual BOOL handleRightMouseDown( S32 x, S32 y, MASK mask );
@@ -552,4 +643,25 @@ public:
 	virtual void operator()(LLFolderViewEventListener* listener) = 0;
 };
 
+template <class LIST>
+void LLInventorySort::sort(LIST& items)
+{
+	std::vector<SortKey> keys;
+	keys.reserve(items.size());
+	for (typename LIST::const_iterator it = items.begin(); it != items.end(); ++it)
+	{
+		keys.push_back(SortKey());
+		makeKey(*it, keys.back());
+	}
+
+	// stable, like std::list::sort()
+	std::stable_sort(keys.begin(), keys.end(), SortKeyLess(*this));
+
+	typename LIST::iterator item_it = items.begin();
+	for (typename std::vector<SortKey>::const_iterator it = keys.begin(); it != keys.end(); ++it, ++item_it)
+	{
+		*item_it = static_cast<typename LIST::value_type>(it->mItem);
+	}
+}
+
 #endif  // LLFOLDERVIEWITEM_H
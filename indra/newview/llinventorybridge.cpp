@@ -1502,6 +1502,17 @@ BOOL LLFolderBridge::isItemRemovable() const
 		{
 			return FALSE;
 		}
+
+		// Item rows that have no view yet
+		const LLInventorySort::pending_items_t& pending_items = folderp->getPendingItems();
+		for (LLInventorySort::pending_items_t::const_iterator it = pending_items.begin();
+			 it != pending_items.end(); ++it)
+		{
+			if (!get_is_item_removable(getInventoryModel(), it->mID))
+			{
+				return FALSE;
+			}
+		}
 	}
 
 	return TRUE;
@@ -62,7 +62,11 @@ LLInventoryFilter::LLInventoryFilter(const std::string& name)
 :	mName(name),
 	mModified(FALSE),
 	mNeedTextRebuild(TRUE),
-	mEmptyLookupMessage("InventoryNoMatchingItems")
+	mEmptyLookupMessage("InventoryNoMatchingItems"),
+	mSearchIndex(NULL),
+	mMatchEpoch(0),
+	mMatchSlotsCurrent(false),
+	mMatchSlotsUsable(false)
 {
 	mOrder = SO_FOLDERS_BY_NAME; // This gets overridden by a pref immediately
 
@@ -94,7 +98,7 @@ BOOL LLInventoryFilter::check(const LLFolderViewItem* item)
 		return TRUE;
 	}
 
-	mSubStringMatchOffset = mFilterSubString.size() ? item->getSearchableLabel().find(mFilterSubString) : std::string::npos;
+	mSubStringMatchOffset = mFilterSubString.size() ? matchFilterSubString(item) : std::string::npos;
 
 	const BOOL passed_filtertype = checkAgainstFilterType(item);
 	const BOOL passed_permissions = checkAgainstPermissions(item);
@@ -107,6 +111,39 @@ BOOL LLInventoryFilter::check(const LLFolderViewItem* item)
 	return passed;
 }
 
+std::string::size_type LLInventoryFilter::matchFilterSubString(const LLFolderViewItem* item)
+{
+	// Items that took a slot after the lookup aren't in its result
+	const S32 slot = item->getSearchIndexSlot();
+	if (mSearchIndex && slot >= 0 && updateMatchSlots()
+		&& slot < (S32)mMatchSlots.size() && !mMatchSlots[slot])
+	{
+		return std::string::npos;
+	}
+	return item->getSearchableLabel().find(mFilterSubString);
+}
+
+bool LLInventoryFilter::updateMatchSlots()
+{
+	if (mMatchEpoch != mSearchIndex->getEpoch())
+	{
+		// Slots were renumbered, start over
+		mMatchSlots.clear();
+		mMatchSlotsCurrent = false;
+	}
+	if (!mMatchSlotsCurrent)
+	{
+		mMatchSlotsUsable = mSearchIndex->findMatches(mFilterSubString, mMatchSlots);
+		if (!mMatchSlotsUsable)
+		{
+			mMatchSlots.clear();
+		}
+		mMatchEpoch = mSearchIndex->getEpoch();
+		mMatchSlotsCurrent = true;
+	}
+	return mMatchSlotsUsable;
+}
+
 BOOL LLInventoryFilter::checkAgainstFilterType(const LLFolderViewItem* item) const
 {
 	const LLFolderViewEventListener* listener = item->getListener();
@@ -401,10 +438,19 @@ void LLInventoryFilter::setFilterSubString(const std::string& string)
 		// appending new characters
 		const BOOL more_restrictive = mFilterSubString.size() < string.size() && !string.substr(0, mFilterSubString.size()).compare(mFilterSubString);
 
+		const std::string old_substring = mFilterSubString;
 		mFilterSubStringOrig = string;
 		LLStringUtil::trimHead(mFilterSubStringOrig);
 		mFilterSubString = mFilterSubStringOrig;
 		LLStringUtil::toUpper(mFilterSubString);
+
+		// Typing more narrows down the last lookup, anything else starts over
+		mMatchSlotsCurrent = false;
+		if (mFilterSubString.compare(0, old_substring.size(), old_substring))
+		{
+			mMatchSlots.clear();
+		}
+
 		if (less_restrictive)
 		{
 			setModified(FILTER_LESS_RESTRICTIVE);
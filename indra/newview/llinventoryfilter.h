@@ -29,6 +29,7 @@
 
 #include "llinventorytype.h"
 #include "llpermissionsflags.h"
+#include "llinventorysearchindex.h"
 
 class LLFolderViewItem;
 
@@ -113,6 +114,10 @@ public:
 
 	std::string::size_type getStringMatchOffset() const;
 
+	// Index of the labels of the items this filter checks, lets check()
+	// skip the labels that can't contain the filter substring
+	void				setSearchIndex(const LLInventorySearchIndex* index);
+
 	// +-------------------------------------------------------------------+
 	// + Presentation
 	// +-------------------------------------------------------------------+
@@ -166,6 +171,11 @@ public:
 	void 				fromLLSD(LLSD& data);
 
 private:
+	std::string::size_type matchFilterSubString(const LLFolderViewItem* item);
+	// Looks the filter substring up in mSearchIndex if it hasn't been
+	// yet. Returns false if the index can't tell.
+	bool				updateMatchSlots();
+
 	struct FilterOps
 	{
 		FilterOps();
@@ -195,6 +205,12 @@ private:
 	std::string				mFilterSubStringOrig;
 	const std::string		mName;
 
+	const LLInventorySearchIndex*			mSearchIndex;
+	LLInventorySearchIndex::match_slots_t	mMatchSlots;
+	U32										mMatchEpoch;
+	bool									mMatchSlotsCurrent;
+	bool									mMatchSlotsUsable;
+
 	S32						mFilterGeneration;
 	S32						mMustPassGeneration;
 	S32						mMinRequiredGeneration;
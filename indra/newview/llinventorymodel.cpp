@@ -63,6 +63,7 @@ BOOL LLInventoryModel::sFirstTimeInViewer2 = TRUE;
 
 //BOOL decompress_file(const char* src_filename, const char* dst_filename);
 const char CACHE_FORMAT_STRING[] = "%s.inv"; 
+const char SNAPSHOT_FORMAT_STRING[] = "%s.invs";
 
 struct InventoryIDPtrLess
 {
@@ -71,6 +72,9 @@ struct InventoryIDPtrLess
 		return (i1->getUUID() < i2->getUUID());
 	}
 };
+typedef std::set<LLPointer<LLViewerInventoryCategory>, InventoryIDPtrLess> cat_set_t;
+
+static bool is_category_complete(LLInventoryModel* model, LLViewerInventoryCategory* cat);
 
 class LLCanCache : public LLInventoryCollectFunctor 
 {
@@ -97,30 +101,38 @@ bool LLCanCache::operator()(LLInventoryCategory* cat, LLInventoryItem* item)
 	{
 		// HACK: downcast
 		LLViewerInventoryCategory* c = (LLViewerInventoryCategory*)cat;
-		if(c->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
+		if(is_category_complete(mModel, c))
 		{
-			S32 descendents_server = c->getDescendentCount();
-			LLInventoryModel::cat_array_t* cats;
-			LLInventoryModel::item_array_t* items;
-			mModel->getDirectDescendentsOf(
-				c->getUUID(),
-				cats,
-				items);
-			S32 descendents_actual = 0;
-			if(cats && items)
-			{
-				descendents_actual = cats->count() + items->count();
-			}
-			if(descendents_server == descendents_actual)
-			{
-				mCachedCatIDs.insert(c->getUUID());
-				rv = true;
-			}
+			mCachedCatIDs.insert(c->getUUID());
+			rv = true;
 		}
 	}
 	return rv;
 }
 
+// A category may be cached with its version only if its version is known
+// and the model holds every descendent the server counts for it
+static bool is_category_complete(LLInventoryModel* model, LLViewerInventoryCategory* cat)
+{
+	if(cat->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN)
+	{
+		return false;
+	}
+	S32 descendents_server = cat->getDescendentCount();
+	LLInventoryModel::cat_array_t* cats;
+	LLInventoryModel::item_array_t* items;
+	model->getDirectDescendentsOf(
+		cat->getUUID(),
+		cats,
+		items);
+	S32 descendents_actual = 0;
+	if(cats && items)
+	{
+		descendents_actual = cats->count() + items->count();
+	}
+	return descendents_server == descendents_actual;
+}
+
 ///----------------------------------------------------------------------------
 /// Class LLInventoryModel
 ///----------------------------------------------------------------------------
@@ -134,11 +146,9 @@ LLInventoryModel::LLInventoryModel()
 	mChangedItemIDs(),
 	mCategoryMap(),
 	mItemMap(),
-	mCategoryLock(),
-	mItemLock(),
 	mLastItem(NULL),
-	mParentChildCategoryTree(),
-	mParentChildItemTree(),
+	mDescendents(),
+	mBacklinks(),
 	mObservers(),
 	mRootFolderID(),
 	mLibraryRootFolderID(),
@@ -243,10 +253,10 @@ LLViewerInventoryItem* LLInventoryModel::getItem(const LLUUID& id) const
 	}
 	else
 	{
-		item_map_t::const_iterator iter = mItemMap.find(id);
-		if (iter != mItemMap.end())
+		const LLPointer<LLViewerInventoryItem>* itemp = mItemMap.getPtr(id);
+		if (itemp)
 		{
-			item = iter->second;
+			item = *itemp;
 			mLastItem = item;
 		}
 	}
@@ -256,13 +266,8 @@ LLViewerInventoryItem* LLInventoryModel::getItem(const LLUUID& id) const
 // Get the category by id. Returns NULL if not found
 LLViewerInventoryCategory* LLInventoryModel::getCategory(const LLUUID& id) const
 {
-	LLViewerInventoryCategory* category = NULL;
-	cat_map_t::const_iterator iter = mCategoryMap.find(id);
-	if (iter != mCategoryMap.end())
-	{
-		category = iter->second;
-	}
-	return category;
+	const LLPointer<LLViewerInventoryCategory>* categoryp = mCategoryMap.getPtr(id);
+	return categoryp ? categoryp->get() : NULL;
 }
 
 S32 LLInventoryModel::getItemCount() const
@@ -284,8 +289,83 @@ void LLInventoryModel::getDirectDescendentsOf(const LLUUID& cat_id,
 											  cat_array_t*& categories,
 											  item_array_t*& items) const
 {
-	categories = get_ptr_in_map(mParentChildCategoryTree, cat_id);
-	items = get_ptr_in_map(mParentChildItemTree, cat_id);
+	Descendents* const* descendentsp = mDescendents.getPtr(cat_id);
+	if (descendentsp)
+	{
+		categories = &(*descendentsp)->mCategories;
+		items = &(*descendentsp)->mItems;
+	}
+	else
+	{
+		categories = NULL;
+		items = NULL;
+	}
+}
+
+U32 LLInventoryModel::getDescendentsChangeCount(const LLUUID& cat_id) const
+{
+	Descendents* const* descendentsp = mDescendents.getPtr(cat_id);
+	return descendentsp ? (*descendentsp)->mChangeCount : 0;
+}
+
+LLInventoryModel::Descendents* LLInventoryModel::addDescendents(const LLUUID& cat_id)
+{
+	Descendents*& descendents = mDescendents[cat_id];
+	if (!descendents)
+	{
+		descendents = new Descendents;
+	}
+	return descendents;
+}
+
+LLInventoryModel::cat_array_t* LLInventoryModel::getCatArray(const LLUUID& cat_id) const
+{
+	Descendents* const* descendentsp = mDescendents.getPtr(cat_id);
+	return descendentsp ? &(*descendentsp)->mCategories : NULL;
+}
+
+LLInventoryModel::item_array_t* LLInventoryModel::getItemArray(const LLUUID& cat_id) const
+{
+	Descendents* const* descendentsp = mDescendents.getPtr(cat_id);
+	return descendentsp ? &(*descendentsp)->mItems : NULL;
+}
+
+void LLInventoryModel::markDescendentsChanged(const LLUUID& cat_id)
+{
+	Descendents** descendentsp = mDescendents.getPtr(cat_id);
+	if (descendentsp)
+	{
+		++(*descendentsp)->mChangeCount;
+	}
+}
+
+void LLInventoryModel::addBacklink(const LLViewerInventoryItem* item)
+{
+	if (item->getIsLinkType())
+	{
+		uuid_vec_t& links = mBacklinks[item->getLinkedUUID()];
+		if (std::find(links.begin(), links.end(), item->getUUID()) == links.end())
+		{
+			links.push_back(item->getUUID());
+		}
+	}
+}
+
+void LLInventoryModel::removeBacklink(const LLViewerInventoryItem* item)
+{
+	if (item->getIsLinkType())
+	{
+		backlink_map_t::iterator it = mBacklinks.find(item->getLinkedUUID());
+		if (it != mBacklinks.end())
+		{
+			uuid_vec_t& links = it->second;
+			links.erase(std::remove(links.begin(), links.end(), item->getUUID()), links.end());
+			if (links.empty())
+			{
+				mBacklinks.erase(item->getLinkedUUID());
+			}
+		}
+	}
 }
 
 LLMD5 LLInventoryModel::hashDirectDescendentNames(const LLUUID& cat_id) const
@@ -318,20 +398,22 @@ void LLInventoryModel::lockDirectDescendentArrays(const LLUUID& cat_id,
 												  item_array_t*& items)
 {
 	getDirectDescendentsOf(cat_id, categories, items);
-	if (categories)
-	{
-		mCategoryLock[cat_id] = true;
-	}
-	if (items)
+	Descendents** descendentsp = mDescendents.getPtr(cat_id);
+	if (descendentsp)
 	{
-		mItemLock[cat_id] = true;
+		(*descendentsp)->mCategoriesLocked = true;
+		(*descendentsp)->mItemsLocked = true;
 	}
 }
 
 void LLInventoryModel::unlockDirectDescendentArrays(const LLUUID& cat_id)
 {
-	mCategoryLock[cat_id] = false;
-	mItemLock[cat_id] = false;
+	Descendents** descendentsp = mDescendents.getPtr(cat_id);
+	if (descendentsp)
+	{
+		(*descendentsp)->mCategoriesLocked = false;
+		(*descendentsp)->mItemsLocked = false;
+	}
 }
 
 // findCategoryUUIDForType() returns the uuid of the category that
@@ -352,7 +434,8 @@ const LLUUID LLInventoryModel::findCategoryUUIDForType(LLFolderType::EType prefe
 	else if (root_id.notNull())
 	{
 		cat_array_t* cats = NULL;
-		cats = get_ptr_in_map(mParentChildCategoryTree, root_id);
+		item_array_t* items = NULL;
+		getDirectDescendentsOf(root_id, cats, items);
 		if(cats)
 		{
 			S32 count = cats->count();
@@ -467,40 +550,57 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
 											LLInventoryCollectFunctor& add,
 											BOOL follow_folder_links)
 {
-	// Start with categories
+	// Look the trash up once rather than at every level
+	LLUUID trash_id;
 	if(!include_trash)
 	{
-		const LLUUID trash_id = findCategoryUUIDForType(LLFolderType::FT_TRASH);
-		if(trash_id.notNull() && (trash_id == id))
-			return;
+		trash_id = findCategoryUUIDForType(LLFolderType::FT_TRASH);
+	}
+	collectDescendentsIfExcluding(id, cats, items, trash_id, add, follow_folder_links);
+}
+
+void LLInventoryModel::collectDescendentsIfExcluding(const LLUUID& id,
+													 cat_array_t& cats,
+													 item_array_t& items,
+													 const LLUUID& excluded_id,
+													 LLInventoryCollectFunctor& add,
+													 BOOL follow_folder_links)
+{
+	// Start with categories
+	if(excluded_id.notNull() && (excluded_id == id))
+	{
+		return;
 	}
-	cat_array_t* cat_array = get_ptr_in_map(mParentChildCategoryTree, id);
-	if(cat_array)
+	Descendents* const* descendentsp = mDescendents.getPtr(id);
+	if(!descendentsp)
 	{
-		S32 count = cat_array->count();
-		for(S32 i = 0; i < count; ++i)
+		return;
+	}
+	const Descendents* descendents = *descendentsp;
+	const cat_array_t& cat_array = descendents->mCategories;
+	S32 count = cat_array.count();
+	for(S32 i = 0; i < count; ++i)
+	{
+		LLViewerInventoryCategory* cat = cat_array.get(i);
+		if(add(cat,NULL))
 		{
-			LLViewerInventoryCategory* cat = cat_array->get(i);
-			if(add(cat,NULL))
-			{
-				cats.put(cat);
-			}
-			collectDescendentsIf(cat->getUUID(), cats, items, include_trash, add);
+			cats.put(cat);
 		}
+		collectDescendentsIfExcluding(cat->getUUID(), cats, items, excluded_id, add, FALSE);
 	}
 
 	LLViewerInventoryItem* item = NULL;
-	item_array_t* item_array = get_ptr_in_map(mParentChildItemTree, id);
+	const item_array_t& item_array = descendents->mItems;
 
 	// Follow folder links recursively.  Currently never goes more
 	// than one level deep (for current outfit support)
 	// Note: if making it fully recursive, need more checking against infinite loops.
-	if (follow_folder_links && item_array)
+	if (follow_folder_links)
 	{
-		S32 count = item_array->count();
+		count = item_array.count();
 		for(S32 i = 0; i < count; ++i)
 		{
-			item = item_array->get(i);
+			item = item_array.get(i);
 			if (item && item->getActualType() == LLAssetType::AT_LINK_FOLDER)
 			{
 				LLViewerInventoryCategory *linked_cat = item->getLinkedCategory();
@@ -516,23 +616,20 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
 						// outfit traversal.
 						cats.put(LLPointer<LLViewerInventoryCategory>(linked_cat));
 					}
-					collectDescendentsIf(linked_cat->getUUID(), cats, items, include_trash, add, FALSE);
+					collectDescendentsIfExcluding(linked_cat->getUUID(), cats, items, excluded_id, add, FALSE);
 				}
 			}
 		}
 	}
 	
 	// Move onto items
-	if(item_array)
+	count = item_array.count();
+	for(S32 i = 0; i < count; ++i)
 	{
-		S32 count = item_array->count();
-		for(S32 i = 0; i < count; ++i)
+		item = item_array.get(i);
+		if(add(NULL, item))
 		{
-			item = item_array->get(i);
-			if(add(NULL, item))
-			{
-				items.put(item);
-			}
+			items.put(item);
 		}
 	}
 }
@@ -543,33 +640,26 @@ void LLInventoryModel::addChangedMaskForLinks(const LLUUID& object_id, U32 mask)
 	if (!obj || obj->getIsLinkType())
 		return;
 
-	LLInventoryModel::cat_array_t cat_array;
-	LLInventoryModel::item_array_t item_array;
-	LLLinkedItemIDMatches is_linked_item_match(object_id);
-	collectDescendentsIf(gInventory.getRootFolderID(),
-						 cat_array,
-						 item_array,
-						 LLInventoryModel::INCLUDE_TRASH,
-						 is_linked_item_match);
-	if (cat_array.empty() && item_array.empty())
+	const uuid_vec_t* linksp = mBacklinks.getPtr(object_id);
+	if (!linksp)
 	{
 		return;
 	}
-	for (LLInventoryModel::cat_array_t::iterator cat_iter = cat_array.begin();
-		 cat_iter != cat_array.end();
-		 cat_iter++)
-	{
-		LLViewerInventoryCategory *linked_cat = (*cat_iter);
-		addChangedMask(mask, linked_cat->getUUID());
-	};
-
-	for (LLInventoryModel::item_array_t::iterator iter = item_array.begin();
-		 iter != item_array.end();
-		 iter++)
+	// Copied, addChangedMask() comes back through here
+	const uuid_vec_t links(*linksp);
+	for (uuid_vec_t::const_iterator iter = links.begin();
+		 iter != links.end();
+		 ++iter)
 	{
-		LLViewerInventoryItem *linked_item = (*iter);
-		addChangedMask(mask, linked_item->getUUID());
-	};
+		// Only the links in the agent's inventory, trash included
+		const LLViewerInventoryItem* linked_item = getItem(*iter);
+		if (linked_item
+			&& linked_item->getLinkedUUID() == object_id
+			&& isObjectDescendentOf(*iter, gInventory.getRootFolderID()))
+		{
+			addChangedMask(mask, *iter);
+		}
+	}
 }
 
 const LLUUID& LLInventoryModel::getLinkedItemID(const LLUUID& object_id) const
@@ -644,12 +734,13 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 		{
 			// need to update the parent-child tree
 			item_array_t* item_array;
-			item_array = get_ptr_in_map(mParentChildItemTree, old_parent_id);
+			item_array = getItemArray(old_parent_id);
 			if(item_array)
 			{
 				item_array->removeObj(old_item);
 			}
-			item_array = get_ptr_in_map(mParentChildItemTree, new_parent_id);
+			markDescendentsChanged(old_parent_id);
+			item_array = getItemArray(new_parent_id);
 			if(item_array)
 			{
 				item_array->put(old_item);
@@ -660,7 +751,9 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 		{
 			mask |= LLInventoryObserver::LABEL;
 		}
+		removeBacklink(old_item);
 		old_item->copyViewerItem(item);
+		addBacklink(old_item);
 		mask |= LLInventoryObserver::INTERNAL;
 	}
 	else
@@ -673,7 +766,7 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 		{
 			const LLUUID category_id = findCategoryUUIDForType(LLFolderType::assetTypeToFolderType(new_item->getType()));
 			new_item->setParent(category_id);
-			item_array_t* item_array = get_ptr_in_map(mParentChildItemTree, category_id);
+			item_array_t* item_array = getItemArray(category_id);
 			if( item_array )
 			{
 				// *FIX: bit of a hack to call update server from here...
@@ -698,7 +791,7 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 				parent_id = findCategoryUUIDForType(LLFolderType::FT_LOST_AND_FOUND);
 				new_item->setParent(parent_id);
 			}
-			item_array_t* item_array = get_ptr_in_map(mParentChildItemTree, parent_id);
+			item_array_t* item_array = getItemArray(parent_id);
 			if(item_array)
 			{
 				item_array->put(new_item);
@@ -710,7 +803,7 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 						<< new_item->getName() << llendl;
 				parent_id = findCategoryUUIDForType(LLFolderType::FT_LOST_AND_FOUND);
 				new_item->setParent(parent_id);
-				item_array = get_ptr_in_map(mParentChildItemTree, parent_id);
+				item_array = getItemArray(parent_id);
 				if(item_array)
 				{
 					// *FIX: bit of a hack to call update server from
@@ -765,22 +858,27 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 
 LLInventoryModel::cat_array_t* LLInventoryModel::getUnlockedCatArray(const LLUUID& id)
 {
-	cat_array_t* cat_array = get_ptr_in_map(mParentChildCategoryTree, id);
-	if (cat_array)
+	Descendents** descendentsp = mDescendents.getPtr(id);
+	if (!descendentsp)
 	{
-		llassert_always(mCategoryLock[id] == false);
+		return NULL;
 	}
-	return cat_array;
+	llassert_always((*descendentsp)->mCategoriesLocked == false);
+	// Handed out to be changed
+	++(*descendentsp)->mChangeCount;
+	return &(*descendentsp)->mCategories;
 }
 
 LLInventoryModel::item_array_t* LLInventoryModel::getUnlockedItemArray(const LLUUID& id)
 {
-	item_array_t* item_array = get_ptr_in_map(mParentChildItemTree, id);
-	if (item_array)
+	Descendents** descendentsp = mDescendents.getPtr(id);
+	if (!descendentsp)
 	{
-		llassert_always(mItemLock[id] == false);
+		return NULL;
 	}
-	return item_array;
+	llassert_always((*descendentsp)->mItemsLocked == false);
+	++(*descendentsp)->mChangeCount;
+	return &(*descendentsp)->mItems;
 }
 
 // Calling this method with an inventory category will either change
@@ -844,12 +942,9 @@ void LLInventoryModel::updateCategory(const LLViewerInventoryCategory* cat)
 		}
 
 		// make space in the tree for this category's children.
-		llassert_always(mCategoryLock[new_cat->getUUID()] == false);
-		llassert_always(mItemLock[new_cat->getUUID()] == false);
-		cat_array_t* catsp = new cat_array_t;
-		item_array_t* itemsp = new item_array_t;
-		mParentChildCategoryTree[new_cat->getUUID()] = catsp;
-		mParentChildItemTree[new_cat->getUUID()] = itemsp;
+		Descendents* descendents = addDescendents(new_cat->getUUID());
+		llassert_always(descendents->mCategoriesLocked == false);
+		llassert_always(descendents->mItemsLocked == false);
 		addChangedMask(LLInventoryObserver::ADD, cat->getUUID());
 	}
 }
@@ -863,7 +958,7 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
 		return;
 	}
 
-	if((object_id == cat_id) || !is_in_map(mCategoryMap, cat_id))
+	if((object_id == cat_id) || !mCategoryMap.count(cat_id))
 	{
 		llwarns << "Could not move inventory object " << object_id << " to "
 				<< cat_id << llendl;
@@ -909,6 +1004,11 @@ void LLInventoryModel::deleteObject(const LLUUID& id)
 	lldebugs << "Deleting inventory object " << id << llendl;
 	mLastItem = NULL;
 	LLUUID parent_id = obj->getParentUUID();
+	LLViewerInventoryItem* old_item = getItem(id);
+	if(old_item)
+	{
+		removeBacklink(old_item);
+	}
 	mCategoryMap.erase(id);
 	mItemMap.erase(id);
 	//mInventory.erase(id);
@@ -924,17 +1024,13 @@ void LLInventoryModel::deleteObject(const LLUUID& id)
 		LLViewerInventoryCategory* cat = (LLViewerInventoryCategory*)((LLInventoryObject*)obj);
 		cat_list->removeObj(cat);
 	}
-	item_list = getUnlockedItemArray(id);
-	if(item_list)
-	{
-		delete item_list;
-		mParentChildItemTree.erase(id);
-	}
-	cat_list = getUnlockedCatArray(id);
-	if(cat_list)
+	Descendents** descendentsp = mDescendents.getPtr(id);
+	if(descendentsp)
 	{
-		delete cat_list;
-		mParentChildCategoryTree.erase(id);
+		llassert_always((*descendentsp)->mCategoriesLocked == false);
+		llassert_always((*descendentsp)->mItemsLocked == false);
+		delete *descendentsp;
+		mDescendents.erase(id);
 	}
 	addChangedMask(LLInventoryObserver::REMOVE, id);
 	obj = NULL; // delete obj
@@ -1076,6 +1172,7 @@ void LLInventoryModel::notifyObservers(const std::string service_name)
 	}
 
 	mIsNotifyObservers = TRUE;
+	journalChanges();
 	for (observer_list_t::iterator iter = mObservers.begin();
 		 iter != mObservers.end(); )
 	{
@@ -1116,6 +1213,11 @@ void LLInventoryModel::addChangedMask(U32 mask, const LLUUID& referent)
 	if (referent.notNull())
 	{
 		mChangedItemIDs.insert(referent);
+		const LLInventoryObject* obj = getObject(referent);
+		if (obj)
+		{
+			markDescendentsChanged(obj->getParentUUID());
+		}
 	}
 	
 	// Update all linked items.  Starting with just LABEL because I'm
@@ -1248,21 +1350,14 @@ void LLInventoryModel::cache(
 		INCLUDE_TRASH,
 		can_cache);
 	std::string agent_id_str;
-	std::string inventory_filename;
 	agent_id.toString(agent_id_str);
 	std::string path(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, agent_id_str));
-	inventory_filename = llformat(CACHE_FORMAT_STRING, path.c_str());
-	saveToFile(inventory_filename, categories, items);
-	std::string gzip_filename(inventory_filename);
-	gzip_filename.append(".gz");
-	if(gzip_file(inventory_filename, gzip_filename))
-	{
-		lldebugs << "Successfully compressed " << inventory_filename << llendl;
-		LLFile::remove(inventory_filename);
-	}
-	else
+	if(saveToSnapshot(llformat(SNAPSHOT_FORMAT_STRING, path.c_str()), categories, items))
 	{
-		llwarns << "Unable to compress " << inventory_filename << llendl;
+		// The legacy cache is out of date now
+		std::string gzip_filename(llformat(CACHE_FORMAT_STRING, path.c_str()));
+		gzip_filename.append(".gz");
+		LLFile::remove(gzip_filename);
 	}
 }
 
@@ -1304,6 +1399,7 @@ void LLInventoryModel::addItem(LLViewerInventoryItem* item)
 		}
 
 		mItemMap[item->getUUID()] = item;
+		addBacklink(item);
 	}
 }
 
@@ -1312,15 +1408,11 @@ void LLInventoryModel::empty()
 {
 //	llinfos << "LLInventoryModel::empty()" << llendl;
 	std::for_each(
-		mParentChildCategoryTree.begin(),
-		mParentChildCategoryTree.end(),
+		mDescendents.begin(),
+		mDescendents.end(),
 		DeletePairedPointer());
-	mParentChildCategoryTree.clear();
-	std::for_each(
-		mParentChildItemTree.begin(),
-		mParentChildItemTree.end(),
-		DeletePairedPointer());
-	mParentChildItemTree.clear();
+	mDescendents.clear();
+	mBacklinks.clear();
 	mCategoryMap.clear(); // remove all references (should delete entries)
 	mItemMap.clear(); // remove all references (should delete entries)
 	mLastItem = NULL;
@@ -1457,13 +1549,9 @@ LLInventoryModel::EHasChildren LLInventoryModel::categoryHasChildren(
 	}
 
 	// Shouldn't have to run this, but who knows.
-	parent_cat_map_t::const_iterator cat_it = mParentChildCategoryTree.find(cat->getUUID());
-	if (cat_it != mParentChildCategoryTree.end() && cat_it->second->count() > 0)
-	{
-		return CHILDREN_YES;
-	}
-	parent_item_map_t::const_iterator item_it = mParentChildItemTree.find(cat->getUUID());
-	if (item_it != mParentChildItemTree.end() && item_it->second->count() > 0)
+	Descendents* const* descendentsp = mDescendents.getPtr(cat->getUUID());
+	if (descendentsp
+		&& ((*descendentsp)->mCategories.count() > 0 || (*descendentsp)->mItems.count() > 0))
 	{
 		return CHILDREN_YES;
 	}
@@ -1493,13 +1581,56 @@ bool LLInventoryModel::isCategoryComplete(const LLUUID& cat_id) const
 	return false;
 }
 
+// Reads the categories of snapshot, and the items of the ones whose
+// cached version matches the skeleton. The items of a category are
+// contiguous in the snapshot, so the out of date ones are skipped
+// without reading them. The items of category i end up in items from
+// item_starts[i] to item_starts[i + 1].
+static void load_from_snapshot(const LLInventorySnapshot& snapshot,
+							   const cat_set_t& skeleton,
+							   LLInventoryModel::cat_array_t& categories,
+							   LLInventoryModel::item_array_t& items,
+							   std::vector<S32>& item_starts)
+{
+	LLPointer<LLViewerInventoryCategory> key = new LLViewerInventoryCategory(LLUUID::null);
+	const S32 count = snapshot.getNumCategories();
+	for(S32 i = 0; i < count; ++i)
+	{
+		const LLInventorySnapshotCategory& record = snapshot.getCategoryRecord(i);
+		LLPointer<LLViewerInventoryCategory> cat = new LLViewerInventoryCategory(record.mOwnerID);
+		snapshot.getCategory(i, cat);
+		cat->setVersion(record.mVersion);
+		categories.put(cat);
+		item_starts.push_back(items.count());
+
+		key->setUUID(record.mUUID);
+		cat_set_t::const_iterator cit = skeleton.find(key);
+		if(cit == skeleton.end() || (*cit)->getVersion() != record.mVersion)
+		{
+			continue;
+		}
+		const S32 end = record.mFirstItem + record.mNumItems;
+		for(S32 j = record.mFirstItem; j < end; ++j)
+		{
+			if(snapshot.getItemRecord(j).mUUID.isNull())
+			{
+				continue;
+			}
+			LLPointer<LLViewerInventoryItem> item = new LLViewerInventoryItem;
+			snapshot.getItem(j, item);
+			item->setComplete(FALSE);
+			items.put(item);
+		}
+	}
+	item_starts.push_back(items.count());
+}
+
 bool LLInventoryModel::loadSkeleton(
 	const LLSD& options,
 	const LLUUID& owner_id)
 {
 	lldebugs << "importing inventory skeleton for " << owner_id << llendl;
 
-	typedef std::set<LLPointer<LLViewerInventoryCategory>, InventoryIDPtrLess> cat_set_t;
 	cat_set_t temp_cats;
 	bool rv = true;
 
@@ -1544,37 +1675,53 @@ bool LLInventoryModel::loadSkeleton(
 	if(!temp_cats.empty())
 	{
 		update_map_t child_counts;
+		update_map_t subfolder_counts;
 		cat_array_t categories;
 		item_array_t items;
+		std::vector<S32> item_starts;
+		std::vector<bool> added;
 		cat_set_t invalid_categories; // Used to mark categories that weren't successfully loaded.
 		std::string owner_id_str;
 		owner_id.toString(owner_id_str);
 		std::string path(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, owner_id_str));
 		std::string inventory_filename;
 		inventory_filename = llformat(CACHE_FORMAT_STRING, path.c_str());
+		const std::string snapshot_filename = llformat(SNAPSHOT_FORMAT_STRING, path.c_str());
 		const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
 		std::string gzip_filename(inventory_filename);
 		gzip_filename.append(".gz");
-		LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
 		bool remove_inventory_file = false;
-		if(fp)
+		bool is_cache_obsolete = false;
+		bool is_cache_loaded = false;
+		LLInventorySnapshot snapshot;
+		if(snapshot.open(snapshot_filename, sCurrentInvCacheVersion))
 		{
-			fclose(fp);
-			fp = NULL;
-			if(gunzip_file(gzip_filename, inventory_filename))
-			{
-				// we only want to remove the inventory file if it was
-				// gzipped before we loaded, and we successfully
-				// gunziped it.
-				remove_inventory_file = true;
-			}
-			else
+			load_from_snapshot(snapshot, temp_cats, categories, items, item_starts);
+			is_cache_loaded = true;
+		}
+		else
+		{
+			// Fall back on the legacy cache
+			LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+			if(fp)
 			{
-				llinfos << "Unable to gunzip " << gzip_filename << llendl;
+				fclose(fp);
+				fp = NULL;
+				if(gunzip_file(gzip_filename, inventory_filename))
+				{
+					// we only want to remove the inventory file if it was
+					// gzipped before we loaded, and we successfully
+					// gunziped it.
+					remove_inventory_file = true;
+				}
+				else
+				{
+					llinfos << "Unable to gunzip " << gzip_filename << llendl;
+				}
 			}
+			is_cache_loaded = loadFromFile(inventory_filename, categories, items, is_cache_obsolete);
 		}
-		bool is_cache_obsolete = false;
-		if(loadFromFile(inventory_filename, categories, items, is_cache_obsolete))
+		if(is_cache_loaded)
 		{
 			// We were able to find a cache of files. So, use what we
 			// found to generate a set of categories we should add. We
@@ -1627,17 +1774,17 @@ bool LLInventoryModel::loadSkeleton(
 				}
 				addCategory(*it);
 				++child_counts[(*it)->getParentUUID()];
+				++subfolder_counts[(*it)->getParentUUID()];
 			}
 
 			// Add all the items loaded which are parented to a
 			// category with a correctly cached parent
 			S32 bad_link_count = 0;
 			cat_map_t::iterator unparented = mCategoryMap.end();
-			for(item_array_t::const_iterator item_iter = items.begin();
-				item_iter != items.end();
-				++item_iter)
+			added.resize(items.count(), false);
+			for(S32 i = 0; i < items.count(); ++i)
 			{
-				LLViewerInventoryItem *item = (*item_iter).get();
+				LLViewerInventoryItem *item = items[i].get();
 				const cat_map_t::iterator cit = mCategoryMap.find(item->getParentUUID());
 				
 				if(cit != unparented)
@@ -1657,6 +1804,7 @@ bool LLInventoryModel::loadSkeleton(
 							continue;
 						}
 						addItem(item);
+						added[i] = true;
 						cached_item_count += 1;
 						++child_counts[cat->getUUID()];
 					}
@@ -1692,6 +1840,24 @@ bool LLInventoryModel::loadSkeleton(
 			llinfos << "Invalidating category name: " << cat->getName() << " UUID: " << cat->getUUID() << " due to invalid descendents cache" << llendl;
 		}
 
+		// Place what the snapshot's child ranges can, and leave the rest
+		// to buildParentChildMap()
+		if(snapshot.isOpen())
+		{
+			fillDescendents(snapshot, items, item_starts, added, subfolder_counts);
+			snapshot.close();
+		}
+		else
+		{
+			for(S32 i = 0; i < items.count(); ++i)
+			{
+				if(added[i])
+				{
+					mUnplacedItems.put(items[i]);
+				}
+			}
+		}
+
 		// At this point, we need to set the known descendents for each
 		// category which successfully cached so that we do not
 		// needlessly fetch descendents for categories which we have.
@@ -1714,6 +1880,21 @@ bool LLInventoryModel::loadSkeleton(
 			}
 		}
 
+		if(owner_id == gAgent.getID())
+		{
+			// Journal the changes of this session against the snapshot,
+			// starting with the categories the cache had out of date
+			mCacheJournal.setSnapshot(snapshot_filename, sCurrentInvCacheVersion);
+			for(cat_set_t::iterator it = temp_cats.begin(); it != temp_cats.end(); ++it)
+			{
+				if((*it)->getVersion() == NO_VERSION)
+				{
+					mCacheJournal.addCategory(*it, NO_VERSION, owner_id);
+				}
+			}
+			mCacheJournal.flush();
+		}
+
 		if(remove_inventory_file)
 		{
 			// clean up the gunzipped file.
@@ -1735,9 +1916,83 @@ bool LLInventoryModel::loadSkeleton(
 	return rv;
 }
 
+void LLInventoryModel::fillDescendents(const LLInventorySnapshot& snapshot,
+									   const item_array_t& items,
+									   const std::vector<S32>& item_starts,
+									   const std::vector<bool>& added,
+									   const update_map_t& subfolder_counts)
+{
+	const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
+	std::vector<bool> placed(items.count(), false);
+	const S32 count = snapshot.getNumCategories();
+	for(S32 i = 0; i < count; ++i)
+	{
+		const LLInventorySnapshotCategory& record = snapshot.getCategoryRecord(i);
+		const LLPointer<LLViewerInventoryCategory>* catp = mCategoryMap.getPtr(record.mUUID);
+		if(!catp || (*catp)->getVersion() == NO_VERSION)
+		{
+			continue;
+		}
+
+		// The cached version matches the skeleton, so the snapshot has
+		// every item of the folder
+		Descendents* descendents = addDescendents(record.mUUID);
+		descendents->mItems.reserve(item_starts[i + 1] - item_starts[i]);
+		for(S32 j = item_starts[i]; j < item_starts[i + 1]; ++j)
+		{
+			if(added[j] && items[j]->getParentUUID() == record.mUUID)
+			{
+				descendents->mItems.put(items[j]);
+				placed[j] = true;
+			}
+		}
+
+		// Subfolders of unknown version aren't written, so the child
+		// range is only whole when the skeleton has as many subfolders
+		update_map_t::const_iterator the_count = subfolder_counts.find(record.mUUID);
+		const U32 num_subfolders = (the_count != subfolder_counts.end()) ? (U32)the_count->second.mValue : 0;
+		if(num_subfolders != record.mNumChildren)
+		{
+			continue;
+		}
+		const U32 end = record.mFirstChild + record.mNumChildren;
+		U32 j = record.mFirstChild;
+		for(; j < end; ++j)
+		{
+			const LLInventorySnapshotCategory& child = snapshot.getCategoryRecord(j);
+			const LLPointer<LLViewerInventoryCategory>* childp = mCategoryMap.getPtr(child.mUUID);
+			if(child.mParent != i || !childp || (*childp)->getParentUUID() != record.mUUID)
+			{
+				break;
+			}
+		}
+		if(j != end)
+		{
+			continue;
+		}
+		descendents->mCategories.reserve(num_subfolders);
+		for(j = record.mFirstChild; j < end; ++j)
+		{
+			descendents->mCategories.put(*mCategoryMap.getPtr(snapshot.getCategoryRecord(j).mUUID));
+		}
+		mFilledFolders.insert(record.mUUID);
+	}
+
+	for(S32 i = 0; i < items.count(); ++i)
+	{
+		if(added[i] && !placed[i])
+		{
+			mUnplacedItems.put(items[i]);
+		}
+	}
+	lldebugs << "Filled " << mFilledFolders.size() << " folders from the inventory snapshot, "
+			 << mUnplacedItems.count() << " items left to place" << llendl;
+}
+
 // This is a brute force method to rebuild the entire parent-child
 // relations. The overall operation has O(NlogN) performance, which
-// should be sufficient for our needs. 
+// should be sufficient for our needs. The folders loadSkeleton() filled
+// from the snapshot are left as they are.
 void LLInventoryModel::buildParentChildMap()
 {
 	llinfos << "LLInventoryModel::buildParentChildMap()" << llendl;
@@ -1754,43 +2009,60 @@ void LLInventoryModel::buildParentChildMap()
 	cat_array_t* catsp;
 	item_array_t* itemsp;
 	
+	cats.reserve(mCategoryMap.size());
+	mDescendents.reserve(mCategoryMap.size() + 1);
 	for(cat_map_t::iterator cit = mCategoryMap.begin(); cit != mCategoryMap.end(); ++cit)
 	{
 		LLViewerInventoryCategory* cat = cit->second;
 		cats.put(cat);
-		if (mParentChildCategoryTree.count(cat->getUUID()) == 0)
-		{
-			llassert_always(mCategoryLock[cat->getUUID()] == false);
-			catsp = new cat_array_t;
-			mParentChildCategoryTree[cat->getUUID()] = catsp;
-		}
-		if (mParentChildItemTree.count(cat->getUUID()) == 0)
-		{
-			llassert_always(mItemLock[cat->getUUID()] == false);
-			itemsp = new item_array_t;
-			mParentChildItemTree[cat->getUUID()] = itemsp;
-		}
+		Descendents* descendents = addDescendents(cat->getUUID());
+		llassert_always(descendents->mCategoriesLocked == false);
+		llassert_always(descendents->mItemsLocked == false);
 	}
 
 	// Insert a special parent for the root - so that lookups on
-	// LLUUID::null as the parent work correctly. This is kind of a
-	// blatent wastes of space since we allocate a block of memory for
-	// the array, but whatever - it's not that much space.
-	if (mParentChildCategoryTree.count(LLUUID::null) == 0)
+	// LLUUID::null as the parent work correctly. Only its categories
+	// are used, items without a parent still go to the lost and found.
+	addDescendents(LLUUID::null);
+
+	// The subfolders of the filled folders are in place already. If
+	// categories were added some other way since, place them all again.
+	S32 count = cats.count();
+	S32 i;
+	const std::set<LLUUID>::const_iterator not_filled = mFilledFolders.end();
+	S32 filled_count = 0;
+	for(std::set<LLUUID>::const_iterator it = mFilledFolders.begin(); it != not_filled; ++it)
+	{
+		filled_count += getCatArray(*it)->count();
+	}
+	for(i = 0; i < count; ++i)
+	{
+		if(mFilledFolders.find(cats.get(i)->getParentUUID()) != not_filled)
+		{
+			--filled_count;
+		}
+	}
+	if(filled_count != 0)
 	{
-		catsp = new cat_array_t;
-		mParentChildCategoryTree[LLUUID::null] = catsp;
+		llwarns << "Inventory changed since it was loaded, rebuilding all of it" << llendl;
+		for(std::set<LLUUID>::const_iterator it = mFilledFolders.begin(); it != not_filled; ++it)
+		{
+			getUnlockedCatArray(*it)->clear();
+		}
+		mFilledFolders.clear();
 	}
 
 	// Now we have a structure with all of the categories that we can
 	// iterate over and insert into the correct place in the child
 	// category tree. 
-	S32 count = cats.count();
-	S32 i;
 	S32 lost = 0;
 	for(i = 0; i < count; ++i)
 	{
 		LLViewerInventoryCategory* cat = cats.get(i);
+		if(mFilledFolders.find(cat->getParentUUID()) != not_filled)
+		{
+			continue;
+		}
 		catsp = getUnlockedCatArray(cat->getParentUUID());
 		if(catsp)
 		{
@@ -1846,10 +2118,24 @@ void LLInventoryModel::buildParentChildMap()
 
 	// Now the items. We allocated in the last step, so now all we
 	// have to do is iterate over the items and put them in the right
-	// place.
+	// place. Only the ones loadSkeleton() left are placed, unless items
+	// were added some other way since.
 	item_array_t items;
-	if(!mItemMap.empty())
+	size_t placed_count = 0;
+	for(descendents_map_t::const_iterator it = mDescendents.begin(); it != mDescendents.end(); ++it)
+	{
+		placed_count += it->second->mItems.count();
+	}
+	if(placed_count + mUnplacedItems.count() == mItemMap.size())
 	{
+		items.swap(mUnplacedItems);
+	}
+	else if(!mItemMap.empty())
+	{
+		for(descendents_map_t::iterator it = mDescendents.begin(); it != mDescendents.end(); ++it)
+		{
+			it->second->mItems.clear();
+		}
 		LLPointer<LLViewerInventoryItem> item;
 		for(item_map_t::iterator iit = mItemMap.begin(); iit != mItemMap.end(); ++iit)
 		{
@@ -1857,6 +2143,8 @@ void LLInventoryModel::buildParentChildMap()
 			items.put(item);
 		}
 	}
+	mUnplacedItems.clear();
+	mFilledFolders.clear();
 	count = items.count();
 	lost = 0;
 	uuid_vec_t lost_item_ids;
@@ -1864,7 +2152,7 @@ void LLInventoryModel::buildParentChildMap()
 	{
 		LLPointer<LLViewerInventoryItem> item;
 		item = items.get(i);
-		itemsp = getUnlockedItemArray(item->getParentUUID());
+		itemsp = item->getParentUUID().notNull() ? getUnlockedItemArray(item->getParentUUID()) : NULL;
 		if(itemsp)
 		{
 			itemsp->put(item);
@@ -1928,7 +2216,7 @@ void LLInventoryModel::buildParentChildMap()
 	const LLUUID &agent_inv_root_id = gInventory.getRootFolderID();
 	if (agent_inv_root_id.notNull())
 	{
-		cat_array_t* catsp = get_ptr_in_map(mParentChildCategoryTree, agent_inv_root_id);
+		cat_array_t* catsp = getCatArray(agent_inv_root_id);
 		if(catsp)
 		{
 			// *HACK - fix root inventory folder
@@ -1936,10 +2224,10 @@ void LLInventoryModel::buildParentChildMap()
 			
 			std::string name = "My Inventory";
 			LLUUID prev_root_id = mRootFolderID;
-			for (parent_cat_map_t::const_iterator it = mParentChildCategoryTree.begin(),
-					 it_end = mParentChildCategoryTree.end(); it != it_end; ++it)
+			for (descendents_map_t::const_iterator it = mDescendents.begin(),
+					 it_end = mDescendents.end(); it != it_end; ++it)
 			{
-				cat_array_t* cat_array = it->second;
+				const cat_array_t* cat_array = &it->second->mCategories;
 				for (cat_array_t::const_iterator cat_it = cat_array->begin(),
 						 cat_it_end = cat_array->end(); cat_it != cat_it_end; ++cat_it)
 					{
@@ -2102,24 +2390,18 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 }
 
 // static
-bool LLInventoryModel::saveToFile(const std::string& filename,
-								  const cat_array_t& categories,
-								  const item_array_t& items)
+bool LLInventoryModel::saveToSnapshot(const std::string& filename,
+									  const cat_array_t& categories,
+									  const item_array_t& items)
 {
 	if(filename.empty())
 	{
 		llerrs << "Filename is Null!" << llendl;
 		return false;
 	}
-	llinfos << "LLInventoryModel::saveToFile(" << filename << ")" << llendl;
-	LLFILE* file = LLFile::fopen(filename, "wb");		/*Flawfinder: ignore*/
-	if(!file)
-	{
-		llwarns << "unable to save inventory to: " << filename << llendl;
-		return false;
-	}
+	llinfos << "LLInventoryModel::saveToSnapshot(" << filename << ")" << llendl;
 
-	fprintf(file, "\tinv_cache_version\t%d\n",sCurrentInvCacheVersion);
+	LLInventorySnapshotWriter writer;
 	S32 count = categories.count();
 	S32 i;
 	for(i = 0; i < count; ++i)
@@ -2127,20 +2409,73 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
 		LLViewerInventoryCategory* cat = categories[i];
 		if(cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
 		{
-			cat->exportFileLocal(file);
+			writer.addCategory(cat, cat->getVersion(), cat->getOwnerID());
 		}
 	}
 
 	count = items.count();
 	for(i = 0; i < count; ++i)
 	{
-		items[i]->exportFile(file);
+		writer.addItem(items[i]);
 	}
 
-	fclose(file);
+	if(!writer.write(filename, sCurrentInvCacheVersion))
+	{
+		llwarns << "unable to save inventory to: " << filename << llendl;
+		return false;
+	}
 	return true;
 }
 
+void LLInventoryModel::journalChanges()
+{
+	if(!mCacheJournal.isEnabled() || mChangedItemIDs.empty())
+	{
+		return;
+	}
+	// The folders of changed items are journaled again too, since their
+	// contents may no longer match their descendent count
+	std::set<LLUUID> category_ids;
+	for(changed_items_t::const_iterator it = mChangedItemIDs.begin();
+		it != mChangedItemIDs.end();
+		++it)
+	{
+		const LLUUID& id = *it;
+		if(getCategory(id))
+		{
+			category_ids.insert(id);
+		}
+		else if(LLViewerInventoryItem* item = getItem(id))
+		{
+			if(isObjectDescendentOf(id, mRootFolderID))
+			{
+				mCacheJournal.addItem(item);
+				category_ids.insert(item->getParentUUID());
+			}
+		}
+		else
+		{
+			mCacheJournal.removeObject(id);
+		}
+	}
+	for(std::set<LLUUID>::const_iterator it = category_ids.begin();
+		it != category_ids.end();
+		++it)
+	{
+		LLViewerInventoryCategory* cat = getCategory(*it);
+		if(cat && isObjectDescendentOf(*it, mRootFolderID))
+		{
+			// Same rule as cache(), so that a folder whose contents are
+			// incomplete is fetched again after the journal is replayed
+			S32 version = is_category_complete(this, cat)
+				? cat->getVersion()
+				: (S32)LLViewerInventoryCategory::VERSION_UNKNOWN;
+			mCacheJournal.addCategory(cat, version, cat->getOwnerID());
+		}
+	}
+	mCacheJournal.flush();
+}
+
 // message handling functionality
 // static
 void LLInventoryModel::registerCallbacks(LLMessageSystem* msg)
@@ -32,10 +32,12 @@
 #include "lldarray.h"
 #include "llframetimer.h"
 #include "llhttpclient.h"
+#include "llinventorysnapshot.h"
 #include "lluuid.h"
 #include "llpermissionsflags.h"
 #include "llstring.h"
 #include "llmd5.h"
+#include "lluuidindex.h"
 #include <map>
 #include <set>
 #include <string>
@@ -145,15 +147,41 @@ private:
 	// the inventory using several different identifiers.
 	// mInventory member data is the 'master' list of inventory, and
 	// mCategoryMap and mItemMap store uuid->object mappings. 
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+	typedef LLUUIDIndex<LLPointer<LLViewerInventoryCategory> > cat_map_t;
+	typedef LLUUIDIndex<LLPointer<LLViewerInventoryItem> > item_map_t;
 	cat_map_t mCategoryMap;
 	item_map_t mItemMap;
-	// This last set of indices is used to map parents to children.
-	typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
-	typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
-	parent_cat_map_t mParentChildCategoryTree;
-	parent_item_map_t mParentChildItemTree;
+	// This last index maps parents to their children, both kinds in
+	// one entry so that walking the tree takes one lookup per category.
+	struct Descendents
+	{
+		Descendents() : mCategoriesLocked(false), mItemsLocked(false), mChangeCount(0) {}
+		cat_array_t mCategories;
+		item_array_t mItems;
+		bool mCategoriesLocked;
+		bool mItemsLocked;
+		// Bumped whenever a child is added, removed or changed
+		U32 mChangeCount;
+	};
+	typedef LLUUIDIndex<Descendents*> descendents_map_t;
+	descendents_map_t mDescendents;
+	// Links by the id of what they link to
+	typedef LLUUIDIndex<uuid_vec_t> backlink_map_t;
+	backlink_map_t mBacklinks;
+
+	void addBacklink(const LLViewerInventoryItem* item);
+	void removeBacklink(const LLViewerInventoryItem* item);
+	// Makes space in the tree for the children of cat_id
+	Descendents* addDescendents(const LLUUID& cat_id);
+	// The children of cat_id, NULL if it isn't in the tree
+	cat_array_t* getCatArray(const LLUUID& cat_id) const;
+	item_array_t* getItemArray(const LLUUID& cat_id) const;
+	void markDescendentsChanged(const LLUUID& cat_id);
+	// Left by loadSkeleton() for buildParentChildMap(): the folders whose
+	// subfolders it placed from the snapshot's child ranges, and the items
+	// it didn't place
+	std::set<LLUUID> mFilledFolders;
+	item_array_t mUnplacedItems;
 
 	//--------------------------------------------------------------------
 	// Login
@@ -192,6 +220,9 @@ public:
 
 	// Compute a hash of direct descendent names (for detecting child name changes)
 	LLMD5 hashDirectDescendentNames(const LLUUID& cat_id) const;
+	// Changes whenever a direct descendent of cat_id is added, removed or
+	// changed, so that observers can skip the categories that are clean.
+	U32 getDescendentsChangeCount(const LLUUID& cat_id) const;
 	
 	// Starting with the object specified, add its descendents to the
 	// array provided, but do not add the inventory object specified
@@ -213,6 +244,15 @@ public:
 							  BOOL include_trash,
 							  LLInventoryCollectFunctor& add,
 							  BOOL follow_folder_links = FALSE);
+private:
+	// Skips the descendents of excluded_id, the trash unless asked for
+	void collectDescendentsIfExcluding(const LLUUID& id,
+									   cat_array_t& categories,
+									   item_array_t& items,
+									   const LLUUID& excluded_id,
+									   LLInventoryCollectFunctor& add,
+									   BOOL follow_folder_links);
+public:
 
 	// Collect all items in inventory that are linked to item_id.
 	// Assumes item_id is itself not a linked item.
@@ -480,13 +520,27 @@ public:
 	// File I/O
 	//--------------------------------------------------------------------
 protected:
+	// Reads the legacy text cache, so that its contents survive the
+	// switch to the binary snapshot
 	static bool loadFromFile(const std::string& filename,
 							 cat_array_t& categories,
 							 item_array_t& items,
 							 bool& is_cache_obsolete); 
-	static bool saveToFile(const std::string& filename,
-						   const cat_array_t& categories,
-						   const item_array_t& items); 
+	static bool saveToSnapshot(const std::string& filename,
+							   const cat_array_t& categories,
+							   const item_array_t& items); 
+	// Fills the children of the folders that loadSkeleton() found up to
+	// date in snapshot straight from its child ranges
+	void fillDescendents(const LLInventorySnapshot& snapshot,
+						 const item_array_t& items,
+						 const std::vector<S32>& item_starts,
+						 const std::vector<bool>& added,
+						 const update_map_t& subfolder_counts);
+	// Appends the changes about to be notified to the journal of the
+	// agent's snapshot
+	void journalChanges();
+private:
+	LLInventorySnapshotJournal mCacheJournal;
 
 	//--------------------------------------------------------------------
 	// Message handling functionality
@@ -515,9 +569,6 @@ public:
 protected:
 	cat_array_t* getUnlockedCatArray(const LLUUID& id);
 	item_array_t* getUnlockedItemArray(const LLUUID& id);
-private:
-	std::map<LLUUID, bool> mCategoryLock;
-	std::map<LLUUID, bool> mItemLock;
 	
 	//--------------------------------------------------------------------
 	// Debugging
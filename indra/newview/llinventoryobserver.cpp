@@ -684,6 +684,19 @@ void LLInventoryCategoriesObserver::changed(U32 mask)
 			continue;
 		}
 
+		LLCategoryData& cat_data = (*iter).second;
+
+		// Skip the categories whose children haven't changed since the
+		// last call, most of them when a single item changes.
+		const U32 change_count = gInventory.getDescendentsChangeCount(cat_id);
+		if (cat_data.mIsNameHashInitialized
+			&& version == cat_data.mVersion
+			&& change_count == cat_data.mChangeCount)
+		{
+			continue;
+		}
+		cat_data.mChangeCount = change_count;
+
 		// Check number of known descendents to find out whether it has changed.
 		LLInventoryModel::cat_array_t* cats;
 		LLInventoryModel::item_array_t* items;
@@ -702,8 +715,6 @@ void LLInventoryCategoriesObserver::changed(U32 mask)
 		
 		const S32 current_num_known_descendents = cats->count() + items->count();
 
-		LLCategoryData& cat_data = (*iter).second;
-
 		bool cat_changed = false;
 
 		// If category version or descendents count has changed
@@ -793,6 +804,7 @@ LLInventoryCategoriesObserver::LLCategoryData::LLCategoryData(
 	, mVersion(version)
 	, mDescendentsCount(num_descendents)
 	, mIsNameHashInitialized(false)
+	, mChangeCount(gInventory.getDescendentsChangeCount(cat_id))
 {
 	mItemNameHash.finalize();
 }
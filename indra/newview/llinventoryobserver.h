@@ -296,6 +296,8 @@ protected:
 		S32			mDescendentsCount;
 		LLMD5		mItemNameHash;
 		bool		mIsNameHashInitialized;
+		// LLInventoryModel::getDescendentsChangeCount() when last checked
+		U32			mChangeCount;
 		LLUUID		mCatID;
 	};
 
@@ -53,6 +53,9 @@ const std::string LLInventoryPanel::DEFAULT_SORT_ORDER = std::string("InventoryS
 const std::string LLInventoryPanel::RECENTITEMS_SORT_ORDER = std::string("RecentItemsSortOrder");
 const std::string LLInventoryPanel::INHERIT_SORT_ORDER = std::string("");
 static const LLInventoryFVBridgeBuilder INVENTORY_BRIDGE_BUILDER;
+// Folders with this many items leave the rows that aren't scrolled to
+// without a view
+static const S32 MIN_PENDING_FOLDER_ITEMS = 200;
 
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -125,6 +128,7 @@ void LLInventoryPanel::initFromParams(const LLInventoryPanel::Params& params)
 		p.use_label_suffix = params.use_label_suffix;
 		mFolderRoot = LLUICtrlFactory::create<LLFolderView>(p);
 		mFolderRoot->setAllowMultiSelect(mAllowMultiSelect);
+		mFolderRoot->setBuildItemCallback(boost::bind(&LLInventoryPanel::buildNewViews, this, _1));
 	}
 
 	mCommitCallbackRegistrar.popScope();
@@ -289,6 +293,32 @@ void LLInventoryPanel::modelChanged(U32 mask)
 	{
 		const LLUUID& item_id = (*items_iter);
 		const LLInventoryObject* model_item = model->getObject(item_id);
+
+		// Rows of big folders that haven't been scrolled to have no view,
+		// don't build one just to update it
+		LLFolderViewFolder* pending_folder = mFolderRoot->getPendingItemFolder(item_id);
+		if (pending_folder)
+		{
+			handled = true;
+			if (model_item
+				&& model_item->getParentUUID() == pending_folder->getListener()->getUUID()
+				&& !(mask & LLInventoryObserver::REBUILD))
+			{
+				// Still in the same folder, pick up a new name or date
+				pending_folder->addPendingItem(model->getItem(item_id));
+			}
+			else
+			{
+				pending_folder->removePendingItem(item_id);
+				if (model_item)
+				{
+					// Moved, or to be rebuilt
+					buildNewViews(item_id);
+				}
+			}
+			continue;
+		}
+
 		LLFolderViewItem* view_item = mFolderRoot->getItemByID(item_id);
 
 		// LLFolderViewFolder is derived from LLFolderViewItem so dynamic_cast from item
@@ -618,12 +648,37 @@ void LLInventoryPanel::buildNewViews(const LLUUID& id)
 		
 		if(items)
 		{
+			// Big folders only build views for the item rows that are
+			// scrolled to, see LLFolderViewFolder::addPendingItem().
+			// Favorites keep the order of the Favorites bar, which the
+			// pending rows don't know.
+			LLFolderViewFolder* pending_folder = NULL;
+			if (items->count() >= MIN_PENDING_FOLDER_ITEMS)
+			{
+				const LLViewerInventoryCategory* cat = gInventory.getCategory(id);
+				if (cat && cat->getPreferredType() != LLFolderType::FT_FAVORITE)
+				{
+					pending_folder = dynamic_cast<LLFolderViewFolder*>(mFolderRoot->getItemByID(id));
+					if (pending_folder == mFolderRoot)
+					{
+						pending_folder = NULL;
+					}
+				}
+			}
+
 			for (LLViewerInventoryItem::item_array_t::const_iterator item_iter = items->begin();
 				 item_iter != items->end();
 				 ++item_iter)
 			{
-				const LLViewerInventoryItem* item = (*item_iter);
-				buildNewViews(item->getUUID());
+				LLViewerInventoryItem* item = (*item_iter);
+				if (pending_folder)
+				{
+					pending_folder->addPendingItem(item);
+				}
+				else
+				{
+					buildNewViews(item->getUUID());
+				}
 			}
 		}
 		mInventory->unlockDirectDescendentArrays(id);
@@ -0,0 +1,208 @@
+/**
+ * @file llinventorysearchindex.cpp
+ * @brief Trigram index over the labels of the items in a folder view.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearchindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+// Don't bother renumbering for fewer dead slots than this
+static const S32 MIN_DEAD_TO_COMPACT = 256;
+
+namespace
+{
+	bool shorter_postings(const std::vector<S32>* a, const std::vector<S32>* b)
+	{
+		return a->size() < b->size();
+	}
+}
+
+LLInventorySearchIndex::LLInventorySearchIndex()
+:	mNumDead(0),
+	mEpoch(0)
+{
+}
+
+LLInventorySearchIndex::~LLInventorySearchIndex()
+{
+	clear();
+}
+
+//static
+LLInventorySearchIndex::trigram_t LLInventorySearchIndex::getTrigram(const char* p)
+{
+	return ((trigram_t)(U8)p[0] << 16) | ((trigram_t)(U8)p[1] << 8) | (trigram_t)(U8)p[2];
+}
+
+void LLInventorySearchIndex::setLabel(Item* item, const std::string& label)
+{
+	const S32 old_slot = item->getSearchIndexSlot();
+	if (old_slot >= 0)
+	{
+		if (mEntries[old_slot].mLabel == label)
+		{
+			return;
+		}
+		mEntries[old_slot].mItem = NULL;
+		mEntries[old_slot].mLabel.clear();
+		++mNumDead;
+	}
+
+	const S32 slot = (S32)mEntries.size();
+	mEntries.push_back(Entry());
+	mEntries.back().mItem = item;
+	mEntries.back().mLabel = label;
+	item->setSearchIndexSlot(slot);
+	addPostings(slot);
+
+	if (mNumDead > MIN_DEAD_TO_COMPACT && mNumDead * 2 > (S32)mEntries.size())
+	{
+		compact();
+	}
+}
+
+void LLInventorySearchIndex::removeItem(Item* item)
+{
+	const S32 slot = item->getSearchIndexSlot();
+	if (slot < 0)
+	{
+		return;
+	}
+	mEntries[slot].mItem = NULL;
+	mEntries[slot].mLabel.clear();
+	++mNumDead;
+	item->setSearchIndexSlot(-1);
+}
+
+void LLInventorySearchIndex::clear()
+{
+	for (std::vector<Entry>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		if (it->mItem)
+		{
+			it->mItem->setSearchIndexSlot(-1);
+		}
+	}
+	mEntries.clear();
+	mPostings.clear();
+	mNumDead = 0;
+	++mEpoch;
+}
+
+bool LLInventorySearchIndex::findMatches(const std::string& substring, match_slots_t& slots) const
+{
+	if (substring.size() < (size_t)MIN_SUBSTRING_LENGTH)
+	{
+		return false;
+	}
+
+	// A label contains substring only if it contains all of its trigrams.
+	// Intersect their postings, shortest first.
+	std::vector<const std::vector<S32>*> postings;
+	const size_t last = substring.size() - MIN_SUBSTRING_LENGTH;
+	for (size_t i = 0; i <= last; ++i)
+	{
+		postings_map_t::const_iterator it = mPostings.find(getTrigram(substring.data() + i));
+		if (it == mPostings.end())
+		{
+			slots.assign(mEntries.size(), 0);
+			return true;
+		}
+		postings.push_back(&it->second);
+	}
+	std::sort(postings.begin(), postings.end(), shorter_postings);
+
+	std::vector<S32> candidates(*postings.front());
+	std::vector<S32> intersection;
+	for (size_t i = 1; i < postings.size() && !candidates.empty(); ++i)
+	{
+		intersection.clear();
+		std::set_intersection(candidates.begin(), candidates.end(),
+							  postings[i]->begin(), postings[i]->end(),
+							  std::back_inserter(intersection));
+		candidates.swap(intersection);
+	}
+
+	// Slots past the end of an earlier result weren't searched then
+	match_slots_t matches(mEntries.size(), 0);
+	const S32 searched = (S32)slots.size();
+	for (std::vector<S32>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+	{
+		if (slots.empty() || *it >= searched || slots[*it])
+		{
+			matches[*it] = 1;
+		}
+	}
+	slots.swap(matches);
+	return true;
+}
+
+void LLInventorySearchIndex::addPostings(S32 slot)
+{
+	const std::string& label = mEntries[slot].mLabel;
+	if (label.size() < (size_t)MIN_SUBSTRING_LENGTH)
+	{
+		return;
+	}
+	const size_t last = label.size() - MIN_SUBSTRING_LENGTH;
+	for (size_t i = 0; i <= last; ++i)
+	{
+		std::vector<S32>& slots = mPostings[getTrigram(label.data() + i)];
+		// Slots only grow, a repeated trigram is at the back
+		if (slots.empty() || slots.back() != slot)
+		{
+			slots.push_back(slot);
+		}
+	}
+}
+
+void LLInventorySearchIndex::compact()
+{
+	std::vector<Entry> entries;
+	entries.reserve(mEntries.size() - mNumDead);
+	for (std::vector<Entry>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		if (it->mItem)
+		{
+			entries.push_back(Entry());
+			entries.back().mItem = it->mItem;
+			entries.back().mLabel.swap(it->mLabel);
+		}
+	}
+	mEntries.swap(entries);
+	mPostings.clear();
+	mNumDead = 0;
+	++mEpoch;
+
+	const S32 count = (S32)mEntries.size();
+	for (S32 slot = 0; slot < count; ++slot)
+	{
+		mEntries[slot].mItem->setSearchIndexSlot(slot);
+		addPostings(slot);
+	}
+}
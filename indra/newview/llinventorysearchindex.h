@@ -0,0 +1,104 @@
+/**
+ * @file llinventorysearchindex.h
+ * @brief Trigram index over the labels of the items in a folder view.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSEARCHINDEX_H
+#define LL_LLINVENTORYSEARCHINDEX_H
+
+#include <string>
+#include <vector>
+#include "boost/unordered_map.hpp"
+
+// Indexes the searchable labels of the items in a folder view by the
+// three byte sequences they contain, so that the inventory filter only
+// has to search the labels that can contain its substring. Items keep
+// their label current through setLabel() whenever they refresh, which
+// they do on every inventory change that concerns them.
+//
+// Each label gets a slot, which the item remembers. A new label takes a
+// new slot: slots handed out after a search are past the end of its
+// result and have to be checked by hand.
+class LLInventorySearchIndex
+{
+public:
+	// Base of the indexed items (LLFolderViewItem), where the index keeps
+	// the slot of the item's label, -1 if it has none
+	class Item
+	{
+	public:
+		Item() : mSearchIndexSlot(-1) {}
+		S32 getSearchIndexSlot() const { return mSearchIndexSlot; }
+		void setSearchIndexSlot(S32 slot) { mSearchIndexSlot = slot; }
+	private:
+		S32 mSearchIndexSlot;
+	};
+
+	// One flag per slot, set for the items that may match
+	typedef std::vector<U8> match_slots_t;
+
+	// Shorter substrings can't be looked up
+	static const S32 MIN_SUBSTRING_LENGTH = 3;
+
+	LLInventorySearchIndex();
+	~LLInventorySearchIndex();
+
+	// label is upper case, like LLFolderViewItem::getSearchableLabel()
+	void setLabel(Item* item, const std::string& label);
+	void removeItem(Item* item);
+	// Forgets every item and resets their slots
+	void clear();
+
+	// Changes when the slots are renumbered, which invalidates earlier
+	// search results
+	U32 getEpoch() const { return mEpoch; }
+
+	// Clears the slots of the items whose label can't contain substring.
+	// Empty slots start out from every item, so passing the result for a
+	// prefix of substring narrows it down. Returns false, leaving slots
+	// alone, if substring is too short to look up.
+	bool findMatches(const std::string& substring, match_slots_t& slots) const;
+
+private:
+	typedef U32 trigram_t;
+	static trigram_t getTrigram(const char* p);
+
+	void addPostings(S32 slot);
+	// Drops the slots of removed labels
+	void compact();
+
+	struct Entry
+	{
+		Item* mItem;	// NULL once the label is replaced or removed
+		std::string mLabel;
+	};
+	std::vector<Entry> mEntries;
+	// Slots, in increasing order, of the labels containing each trigram
+	typedef boost::unordered_map<trigram_t, std::vector<S32> > postings_map_t;
+	postings_map_t mPostings;
+	S32 mNumDead;
+	U32 mEpoch;
+};
+
+#endif // LL_LLINVENTORYSEARCHINDEX_H
@@ -145,6 +145,7 @@
 #include "llurldispatcher.h"
 #include "llslurl.h"
 #include "llurlhistory.h"
+#include "llviewerfloaterreg.h"
 #include "llurlwhitelist.h"
 #include "llvieweraudio.h"
 #include "llviewerassetstorage.h"
@@ -610,6 +611,11 @@ bool idle_startup()
 			F32 dropPercent = gSavedSettings.getF32("PacketDropPercentage");
 			msg->mPacketRing.setDropPercentage(dropPercent);
 
+			if (gSavedSettings.getBOOL("MessageReceiveThread"))
+			{
+				msg->startReceiveThread();
+			}
+
             F32 inBandwidth = gSavedSettings.getF32("InBandwidth"); 
             F32 outBandwidth = gSavedSettings.getF32("OutBandwidth"); 
 			if (inBandwidth != 0.f)
@@ -1782,6 +1788,7 @@ bool idle_startup()
 		gSavedSettings.setBOOL("FirstLoginThisInstall", FALSE);
 
 		LLFloaterReg::showInitialVisibleInstances();
+		LLViewerFloaterReg::startPrebuild();
 
 		// based on the comments, we've successfully logged in so we can delete the 'forced'
 		// URL that the updater set in settings.ini (in a mostly paranoid fashion)
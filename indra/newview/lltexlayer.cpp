@@ -30,6 +30,7 @@
 
 #include "llagent.h"
 #include "llimagej2c.h"
+#include "llimagekernels.h"
 #include "llimagetga.h"
 #include "llnotificationsutil.h"
 #include "llvfile.h"
@@ -1949,14 +1950,7 @@ void LLTexLayer::addAlphaMask(U8 *data, S32 originX, S32 originY, S32 width, S32
 	}
 	if (alphaData)
 	{
-		for( S32 i = 0; i < size; i++ )
-		{
-			U8 curAlpha = data[i];
-			U16 resultAlpha = curAlpha;
-			resultAlpha *= (alphaData[i] + 1);
-			resultAlpha = resultAlpha >> 8;
-			data[i] = (U8)resultAlpha;
-		}
+		LLImageKernels::sMultiplyMask(alphaData, data, size);
 	}
 }
 
@@ -34,12 +34,9 @@
 #include "lllfsthread.h"
 #include "llviewercontrol.h"
 
-// Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
-#include "llappviewer.h" 
-
 // Cache organization:
 // cache/texture.entries
-//  Unordered array of Entry structs
+//  EntriesInfo, unordered array of Entry structs, then the hash index of the entries (memory mapped)
 // cache/texture.cache
 //  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
 // cache/textures/[0-F]/UUID.texture
@@ -48,7 +45,7 @@
 //note: there is no good to define 1024 for TEXTURE_CACHE_ENTRY_SIZE while FIRST_PACKET_SIZE is 600 on sim side.
 const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
 const F32 TEXTURE_CACHE_PURGE_AMOUNT = .20f; // % amount to reduce the cache by when it exceeds its limit
-const F32 TEXTURE_CACHE_LRU_SIZE = .10f; // % amount for LRU list (low overhead to regenerate)
+const S32 TEXTURE_CACHE_PURGE_PER_UPDATE = 64; // max textures evicted per update() while purging
 
 class LLTextureCacheWorker : public LLWorkerClass
 {
@@ -737,17 +734,29 @@ LLTextureCache::LLTextureCache(bool threaded)
 	  mWorkersMutex(NULL),
 	  mHeaderMutex(NULL),
 	  mListMutex(NULL),
-	  mHeaderAPRFile(NULL),
 	  mReadOnly(TRUE), //do not allow to change the texture cache until setReadOnly() is called.
+	  mEntriesInfo(NULL),
+	  mEntries(NULL),
+	  mIndex(NULL),
+	  mStripeSize(0),
+	  mPurgeHand(0),
 	  mTexturesSizeTotal(0),
 	  mDoPurge(FALSE)
 {
+	for (S32 i = 0; i < INDEX_STRIPES; i++)
+	{
+		mIndexMutex[i] = new LLMutex(NULL);
+	}
 }
 
 LLTextureCache::~LLTextureCache()
 {
 	clearDeleteList() ;
-	writeUpdatedEntries() ;
+	closeHeaderCache(true) ;
+	for (S32 i = 0; i < INDEX_STRIPES; i++)
+	{
+		delete mIndexMutex[i];
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -792,6 +801,22 @@ S32 LLTextureCache::update(U32 max_time_ms)
 		bool success = iter1->second;
 		responder->completed(success);
 	}
+
+	if (mDoPurge)
+	{
+		// Evict a few of the least recently used bodies per call until we are back under the purge size,
+		// instead of stalling on a purge of the whole cache.
+		evictEntries(TEXTURE_CACHE_PURGE_PER_UPDATE, true);
+
+		S64 purged_cache_size = (sCacheMaxTexturesSize * (S64)((1.f-TEXTURE_CACHE_PURGE_AMOUNT)*100)) / 100;
+		lockHeaders();
+		bool purged = mTexturesSizeTotal < purged_cache_size;
+		unlockHeaders();
+		if (purged)
+		{
+			mDoPurge = FALSE;
+		}
+	}
 	
 	if(!res && timer.getElapsedTimeF32() > MAX_TIME_INTERVAL)
 	{
@@ -824,10 +849,12 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 //debug
 BOOL LLTextureCache::isInCache(const LLUUID& id) 
 {
-	LLMutexLock lock(&mHeaderMutex);
-	id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-	
-	return (iter != mHeaderIDMap.end()) ;
+	if (!mEntriesInfo)
+	{
+		return FALSE;
+	}
+	LLMutexLock lock(getIndexMutex(id));
+	return (findIndexSlot(id) != NULL) ;
 }
 
 //debug
@@ -873,7 +900,7 @@ BOOL LLTextureCache::isInLocal(const LLUUID& id)
 
 //static
 const S32 MAX_REASONABLE_FILE_SIZE = 512*1024*1024; // 512 MB
-F32 LLTextureCache::sHeaderCacheVersion = 1.4f;
+F32 LLTextureCache::sHeaderCacheVersion = 1.5f;
 U32 LLTextureCache::sCacheMaxEntries = MAX_REASONABLE_FILE_SIZE / TEXTURE_CACHE_ENTRY_SIZE;
 S64 LLTextureCache::sCacheMaxTexturesSize = 0; // no limit
 const char* entries_filename = "texture.entries";
@@ -898,7 +925,6 @@ void LLTextureCache::purgeCache(ELLPath location)
 	if (!mReadOnly)
 	{
 		setDirNames(location);
-		llassert_always(mHeaderAPRFile == NULL);
 
 		//remove the legacy cache if exists
 		std::string texture_dir = mTexturesDirName ;
@@ -970,8 +996,7 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
 			LLFile::mkdir(dirname);
 		}
 	}
-	readHeaderCache();
-	purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
+	readHeaderCache(); // also calcs mTexturesSizeTotal, purging happens incrementally in update()
 
 	llassert_always(getPending() == 0) ; //should not start accessing the texture cache before initialized.
 
@@ -979,529 +1004,345 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
 }
 
 //----------------------------------------------------------------------------
-// mHeaderMutex must be locked for the following functions!
+// Header index
 
-LLAPRFile* LLTextureCache::openHeaderEntriesFile(bool readonly, S32 offset)
+//static
+S64 LLTextureCache::getHeaderCacheSize(U32 max_entries, U32 index_size)
 {
-	llassert_always(mHeaderAPRFile == NULL);
-	apr_int32_t flags = readonly ? APR_READ|APR_BINARY : APR_READ|APR_WRITE|APR_BINARY;
-	mHeaderAPRFile = new LLAPRFile(mHeaderEntriesFileName, flags, getLocalAPRFilePool());
-	if(offset > 0)
-	{
-		mHeaderAPRFile->seek(APR_SET, offset);
-	}
-	return mHeaderAPRFile;
+	return (S64)sizeof(EntriesInfo) + (S64)max_entries * (S64)sizeof(Entry) + (S64)index_size * (S64)sizeof(U32);
 }
 
-void LLTextureCache::closeHeaderEntriesFile()
+//static
+U32 LLTextureCache::hashID(const LLUUID& id)
 {
-	if(!mHeaderAPRFile)
-	{
-		return ;
-	}
-
-	delete mHeaderAPRFile;
-	mHeaderAPRFile = NULL;
+	// UUIDs are random, a couple of their words make a good enough hash
+	U32 words[2];
+	memcpy(words, id.mData, sizeof(words));
+	return words[0] ^ (words[1] * 0x9E3779B9);
 }
 
-void LLTextureCache::readEntriesHeader()
+// The index mutex of id must be locked before calling this.
+// Returns the index slot holding id or NULL.
+U32* LLTextureCache::findIndexSlot(const LLUUID& id)
 {
-	// mHeaderEntriesInfo initializes to default values so safe not to read it
-	llassert_always(mHeaderAPRFile == NULL);
-	if (LLAPRFile::isExist(mHeaderEntriesFileName, getLocalAPRFilePool()))
-	{
-		LLAPRFile::readEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
-						  getLocalAPRFilePool());
-	}
-	else //create an empty entries header.
+	U32 hash = hashID(id);
+	U32* stripe = mIndex + (hash & (INDEX_STRIPES - 1)) * mStripeSize;
+	U32 mask = mStripeSize - 1;
+	U32 pos = (hash / INDEX_STRIPES) & mask;
+	for (U32 i = 0; i < mStripeSize; i++)
 	{
-		mHeaderEntriesInfo.mVersion = sHeaderCacheVersion ;
-		mHeaderEntriesInfo.mEntries = 0 ;
-		writeEntriesHeader() ;
+		U32 value = stripe[pos];
+		if (!value)
+		{
+			return NULL;
+		}
+		if (mEntries[value - 1].mID == id)
+		{
+			return stripe + pos;
+		}
+		pos = (pos + 1) & mask;
 	}
+	return NULL;
 }
 
-void LLTextureCache::writeEntriesHeader()
+// The index mutex of id must be locked before calling this.
+// Returns false if the stripe is full.
+bool LLTextureCache::insertIndex(const LLUUID& id, S32 idx)
 {
-	llassert_always(mHeaderAPRFile == NULL);
-	if (!mReadOnly)
+	U32 hash = hashID(id);
+	U32* stripe = mIndex + (hash & (INDEX_STRIPES - 1)) * mStripeSize;
+	U32 mask = mStripeSize - 1;
+	U32 pos = (hash / INDEX_STRIPES) & mask;
+	for (U32 i = 0; i < mStripeSize; i++)
 	{
-		LLAPRFile::writeEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
-						   getLocalAPRFilePool());
+		if (!stripe[pos])
+		{
+			stripe[pos] = (U32)idx + 1;
+			return true;
+		}
+		pos = (pos + 1) & mask;
 	}
+	return false;
 }
 
-//mHeaderMutex is locked before calling this.
-S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create)
+// The index mutex of the slot must be locked before calling this.
+// Shifts the following entries of the probe sequence back so no tombstones are needed.
+void LLTextureCache::eraseIndexSlot(U32* slot)
 {
-	S32 idx = -1;
-	
-	id_map_t::iterator iter1 = mHeaderIDMap.find(id);
-	if (iter1 != mHeaderIDMap.end())
+	U32 offset = (U32)(slot - mIndex);
+	U32* stripe = mIndex + (offset / mStripeSize) * mStripeSize;
+	U32 mask = mStripeSize - 1;
+	U32 hole = offset & mask;
+	U32 pos = (hole + 1) & mask;
+	while (stripe[pos])
 	{
-		idx = iter1->second;
+		U32 home = (hashID(mEntries[stripe[pos] - 1].mID) / INDEX_STRIPES) & mask;
+		if (((pos - home) & mask) >= ((pos - hole) & mask))
+		{
+			stripe[hole] = stripe[pos];
+			hole = pos;
+		}
+		pos = (pos + 1) & mask;
 	}
+	stripe[hole] = 0;
+}
 
-	if (idx < 0)
+// Only called before the worker thread is started, no locking needed.
+void LLTextureCache::rebuildIndex()
+{
+	llinfos << "Rebuilding texture cache index." << llendl;
+	memset(mIndex, 0, mEntriesInfo->mIndexSize * sizeof(U32));
+	for (U32 idx = 0; idx < mEntriesInfo->mEntries; idx++)
 	{
-		if (create && !mReadOnly)
+		Entry& entry = mEntries[idx];
+		if (entry.mImageSize > entry.mBodySize && entry.mBodySize >= 0)
 		{
-			if (mHeaderEntriesInfo.mEntries < sCacheMaxEntries)
-			{
-				// Add an entry to the end of the list
-				idx = mHeaderEntriesInfo.mEntries++;
-
-			}
-			else if (!mFreeList.empty())
-			{
-				idx = *(mFreeList.begin());
-				mFreeList.erase(mFreeList.begin());
-			}
-			else
-			{
-				// Look for a still valid entry in the LRU
-				for (std::set<LLUUID>::iterator iter2 = mLRU.begin(); iter2 != mLRU.end();)
-				{
-					std::set<LLUUID>::iterator curiter2 = iter2++;
-					LLUUID oldid = *curiter2;
-					// Erase entry from LRU regardless
-					mLRU.erase(curiter2);
-					// Look up entry and use it if it is valid
-					id_map_t::iterator iter3 = mHeaderIDMap.find(oldid);
-					if (iter3 != mHeaderIDMap.end() && iter3->second >= 0)
-					{
-						idx = iter3->second;
-						removeCachedTexture(oldid) ;//remove the existing cached texture to release the entry index.
-						break;
-					}
-				}
-				// if (idx < 0) at this point, we will rebuild the LRU 
-				//  and retry if called from setHeaderCacheEntry(),
-				//  otherwise this shouldn't happen and will trigger an error
-			}
-			if (idx >= 0)
+			if (findIndexSlot(entry.mID) || !insertIndex(entry.mID, idx))
 			{
-				entry.mID = id ;
-				entry.mImageSize = -1 ; //mark it is a brand-new entry.					
-				entry.mBodySize = 0 ;
+				// Duplicate, or no room left for it
+				entry.init(LLUUID::null, 0);
+				entry.mImageSize = -1;
 			}
 		}
 	}
-	else
-	{
-		// Remove this entry from the LRU if it exists
-		mLRU.erase(id);
-		// Read the entry
-		idx_entry_map_t::iterator iter = mUpdatedEntryMap.find(idx) ;
-		if(iter != mUpdatedEntryMap.end())
-		{
-			entry = iter->second ;
-		}
-		else
-		{
-			readEntryFromHeaderImmediately(idx, entry) ;
-		}
-		if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
-		{
-			llwarns << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << llendl ;
-
-			//erase this entry and the cached texture from the cache.
-			std::string tex_filename = getTextureFileName(id);
-			removeEntry(idx, entry, tex_filename) ;
-			mUpdatedEntryMap.erase(idx) ;
-			idx = -1 ;
-		}
-	}
-	return idx;
 }
 
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header)
-{	
-	LLAPRFile* aprfile ;
-	S32 bytes_written ;
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	if(write_header)
-	{
-		aprfile = openHeaderEntriesFile(false, 0);		
-		bytes_written = aprfile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-		if(bytes_written != sizeof(EntriesInfo))
-		{
-			clearCorruptedCache() ; //clear the cache.
-			idx = -1 ;//mark the idx invalid.
-			return ;
-		}
-
-		mHeaderAPRFile->seek(APR_SET, offset);
-	}
-	else
+// Points mEntriesInfo, mEntries and mIndex into mHeaderMap, returns false if the file is not a valid index.
+bool LLTextureCache::mapHeaderCache()
+{
+	S64 size = mHeaderMap.getSize();
+	if (size < (S64)sizeof(EntriesInfo))
 	{
-		aprfile = openHeaderEntriesFile(false, offset);
+		return false;
 	}
-	bytes_written = aprfile->write((void*)&entry, (S32)sizeof(Entry));
-	if(bytes_written != sizeof(Entry))
+	EntriesInfo* info = (EntriesInfo*)mHeaderMap.getData();
+	if (info->mVersion != sHeaderCacheVersion ||
+		info->mEntries > info->mMaxEntries ||
+		info->mIndexSize < INDEX_STRIPES ||
+		(info->mIndexSize & (info->mIndexSize - 1)) != 0 ||
+		size != getHeaderCacheSize(info->mMaxEntries, info->mIndexSize))
 	{
-		clearCorruptedCache() ; //clear the cache.
-		idx = -1 ;//mark the idx invalid.
-
-		return ;
+		return false;
 	}
-
-	closeHeaderEntriesFile();
-	mUpdatedEntryMap.erase(idx) ;
+	mEntriesInfo = info;
+	mEntries = (Entry*)(mHeaderMap.getData() + sizeof(EntriesInfo));
+	mIndex = (U32*)(mEntries + info->mMaxEntries);
+	mStripeSize = info->mIndexSize / INDEX_STRIPES;
+	return true;
 }
 
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
+bool LLTextureCache::createHeaderCache(U32 max_entries)
 {
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	LLAPRFile* aprfile = openHeaderEntriesFile(true, offset);
-	S32 bytes_read = aprfile->read((void*)&entry, (S32)sizeof(Entry));
-	closeHeaderEntriesFile();
+	// keep the index at most half full
+	U32 index_size = 1024;
+	while (index_size < max_entries * 2)
+	{
+		index_size <<= 1;
+	}
 
-	if(bytes_read != sizeof(Entry))
+	if (LLAPRFile::isExist(mHeaderEntriesFileName, getLocalAPRFilePool()))
 	{
-		clearCorruptedCache() ; //clear the cache.
-		idx = -1 ;//mark the idx invalid.
+		LLAPRFile::remove(mHeaderEntriesFileName, getLocalAPRFilePool());
 	}
+	if (!mHeaderMap.open(mHeaderEntriesFileName, getHeaderCacheSize(max_entries, index_size), LLMappedFile::READ_WRITE))
+	{
+		llwarns << "Unable to create texture cache index: " << mHeaderEntriesFileName << llendl;
+		return false;
+	}
+
+	EntriesInfo* info = (EntriesInfo*)mHeaderMap.getData();
+	info->mVersion = sHeaderCacheVersion;
+	info->mEntries = 0;
+	info->mMaxEntries = max_entries;
+	info->mIndexSize = index_size;
+	info->mClean = TRUE;
+	return mapHeaderCache();
 }
 
-//mHeaderMutex is locked before calling this.
-//update an existing entry time stamp, delay writing.
-void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
+// Cache size was changed: keep the records which still fit, the index is rebuilt from them.
+bool LLTextureCache::resizeHeaderCache(U32 max_entries)
 {
-	static const U32 MAX_ENTRIES_WITHOUT_TIME_STAMP = (U32)(LLTextureCache::sCacheMaxEntries * 0.75f) ;
+	U32 num_entries = llmin(mEntriesInfo->mEntries, max_entries);
+	llinfos << "Texture Cache Entries: " << mEntriesInfo->mEntries << " Max: " << max_entries << " Old Max: " << mEntriesInfo->mMaxEntries << llendl;
 
-	if(mHeaderEntriesInfo.mEntries < MAX_ENTRIES_WITHOUT_TIME_STAMP)
+	std::vector<Entry> entries(mEntries, mEntries + num_entries);
+	for (U32 idx = num_entries; idx < mEntriesInfo->mEntries; idx++)
 	{
-		return ; //there are enough empty entry index space, no need to stamp time.
-	}
-
-	if (idx >= 0)
-	{
-		if (!mReadOnly)
+		if (mEntries[idx].mImageSize > 0)
 		{
-			entry.mTime = time(NULL);			
-			mUpdatedEntryMap[idx] = entry ;
+			LLAPRFile::remove(getTextureFileName(mEntries[idx].mID), getLocalAPRFilePool());
 		}
 	}
-}
 
-//update an existing entry, write to header file immediately.
-bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
-{
-	S32 new_body_size = llmax(0, new_data_size - TEXTURE_CACHE_ENTRY_SIZE) ;
-	
-	if(new_image_size == entry.mImageSize && new_body_size == entry.mBodySize)
+	closeHeaderCache(false);
+	if (!createHeaderCache(max_entries))
 	{
-		return true ; //nothing changed.
+		return false;
 	}
-	else 
+	if (num_entries)
 	{
-		bool purge = false ;
-
-		lockHeaders() ;
-
-		bool update_header = false ;
-		if(entry.mImageSize < 0) //is a brand-new entry
-		{
-			mHeaderIDMap[entry.mID] = idx;
-			mTexturesSizeMap[entry.mID] = new_body_size ;
-			mTexturesSizeTotal += new_body_size ;
-			
-			// Update Header
-			update_header = true ;
-		}				
-		else if (entry.mBodySize != new_body_size)
-		{
-			//already in mHeaderIDMap.
-			mTexturesSizeMap[entry.mID] = new_body_size ;
-			mTexturesSizeTotal -= entry.mBodySize ;
-			mTexturesSizeTotal += new_body_size ;
-		}
-		entry.mTime = time(NULL);
-		entry.mImageSize = new_image_size ; 
-		entry.mBodySize = new_body_size ;
-		
-		writeEntryToHeaderImmediately(idx, entry, update_header) ;
-	
-		if (mTexturesSizeTotal > sCacheMaxTexturesSize)
-		{
-			purge = true;
-		}
-		
-		unlockHeaders() ;
-
-		if (purge)
-		{
-			mDoPurge = TRUE;
-		}
+		memcpy(mEntries, &entries[0], num_entries * sizeof(Entry));
 	}
-
-	return false ;
+	mEntriesInfo->mEntries = num_entries;
+	mEntriesInfo->mClean = FALSE; // forces rebuildIndex()
+	return true;
 }
 
-U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
+void LLTextureCache::closeHeaderCache(bool clean)
 {
-	U32 num_entries = mHeaderEntriesInfo.mEntries;
-
-	mHeaderIDMap.clear();
-	mTexturesSizeMap.clear();
+	if (mEntriesInfo && clean && !mReadOnly)
+	{
+		mEntriesInfo->mClean = TRUE;
+		mHeaderMap.flush();
+	}
+	mHeaderMap.close();
+	mEntriesInfo = NULL;
+	mEntries = NULL;
+	mIndex = NULL;
+	mStripeSize = 0;
 	mFreeList.clear();
+	mPurgeHand = 0;
 	mTexturesSizeTotal = 0;
+}
 
-	LLAPRFile* aprfile = NULL; 
-	if(mUpdatedEntryMap.empty())
+void LLTextureCache::writeUpdatedEntries(bool wait)
+{
+	if (mEntriesInfo && !mReadOnly)
 	{
-		aprfile = openHeaderEntriesFile(true, (S32)sizeof(EntriesInfo));
+		mHeaderMap.flush(wait);
 	}
-	else //update the header file first.
+}
+
+//----------------------------------------------------------------------------
+
+// Called from the main thread before the worker thread is started
+void LLTextureCache::readHeaderCache()
+{
+	closeHeaderCache(false);
+
+	LLMappedFile::EMapMode mode = mReadOnly ? LLMappedFile::COPY_ON_WRITE : LLMappedFile::READ_WRITE;
+	bool valid = false;
+	if (LLAPRFile::isExist(mHeaderEntriesFileName, getLocalAPRFilePool()) &&
+		mHeaderMap.open(mHeaderEntriesFileName, 0, mode))
 	{
-		aprfile = openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile() ;
-		if(!aprfile)
+		valid = mapHeaderCache();
+		if (!valid)
 		{
-			return 0;
+			llinfos << "Texture cache index is out of date or damaged, clearing the cache." << llendl;
 		}
-		aprfile->seek(APR_SET, (S32)sizeof(EntriesInfo));
 	}
-	for (U32 idx=0; idx<num_entries; idx++)
+
+	if (!valid)
 	{
-		Entry entry;
-		S32 bytes_read = aprfile->read((void*)(&entry), (S32)sizeof(Entry));
-		if (bytes_read < sizeof(Entry))
+		closeHeaderCache(false);
+		if (mReadOnly)
 		{
-			llwarns << "Corrupted header entries, failed at " << idx << " / " << num_entries << llendl;
-			closeHeaderEntriesFile();
-			purgeAllTextures(false);
-			return 0;
+			return; // no cache available
 		}
-		entries.push_back(entry);
-// 		llinfos << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << llendl;
-		if(entry.mImageSize > entry.mBodySize)
-		{
-			mHeaderIDMap[entry.mID] = idx;
-			mTexturesSizeMap[entry.mID] = entry.mBodySize;
-			mTexturesSizeTotal += entry.mBodySize;
-		}
-		else
+		purgeAllTextures(false);
+		if (!createHeaderCache(sCacheMaxEntries))
 		{
-			mFreeList.insert(idx);
+			return;
 		}
 	}
-	closeHeaderEntriesFile();
-	return num_entries;
-}
-
-void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
-{
-	S32 num_entries = entries.size();
-	llassert_always(num_entries == mHeaderEntriesInfo.mEntries);
-	
-	if (!mReadOnly)
+	else if (!mReadOnly && mEntriesInfo->mMaxEntries != sCacheMaxEntries)
 	{
-		LLAPRFile* aprfile = openHeaderEntriesFile(false, (S32)sizeof(EntriesInfo));
-		for (S32 idx=0; idx<num_entries; idx++)
+		if (!resizeHeaderCache(sCacheMaxEntries))
 		{
-			S32 bytes_written = aprfile->write((void*)(&entries[idx]), (S32)sizeof(Entry));
-			if(bytes_written != sizeof(Entry))
-			{
-				clearCorruptedCache() ; //clear the cache.
-				return ;
-			}
+			return;
 		}
-		closeHeaderEntriesFile();
 	}
-}
 
-void LLTextureCache::writeUpdatedEntries()
-{
-	lockHeaders() ;
-	if (!mReadOnly && !mUpdatedEntryMap.empty())
+	// The index is only trusted if it was written out on a clean shutdown
+	if (!mEntriesInfo->mClean)
 	{
-		openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile() ;
-		closeHeaderEntriesFile();
+		rebuildIndex();
 	}
-	unlockHeaders() ;
-}
-
-//mHeaderMutex is locked and mHeaderAPRFile is created before calling this.
-void LLTextureCache::updatedHeaderEntriesFile()
-{
-	if (!mReadOnly && !mUpdatedEntryMap.empty() && mHeaderAPRFile)
+	if (!mReadOnly)
 	{
-		//entriesInfo
-		mHeaderAPRFile->seek(APR_SET, 0);
-		S32 bytes_written = mHeaderAPRFile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-		if(bytes_written != sizeof(EntriesInfo))
-		{
-			clearCorruptedCache() ; //clear the cache.
-			return ;
-		}
-		
-		//write each updated entry
-		S32 entry_size = (S32)sizeof(Entry) ;
-		S32 prev_idx = -1 ;
-		S32 delta_idx ;
-		for (idx_entry_map_t::iterator iter = mUpdatedEntryMap.begin(); iter != mUpdatedEntryMap.end(); ++iter)
-		{
-			delta_idx = iter->first - prev_idx - 1;
-			prev_idx = iter->first ;
-			if(delta_idx)
-			{
-				mHeaderAPRFile->seek(APR_CUR, delta_idx * entry_size);
-			}
-			
-			bytes_written = mHeaderAPRFile->write((void*)(&iter->second), entry_size);
-			if(bytes_written != entry_size)
-			{
-				clearCorruptedCache() ; //clear the cache.
-				return ;
-			}
-		}
-		mUpdatedEntryMap.clear() ;
+		mEntriesInfo->mClean = FALSE;
+		mHeaderMap.flush();
 	}
-}
-//----------------------------------------------------------------------------
 
-// Called from either the main thread or the worker thread
-void LLTextureCache::readHeaderCache()
-{
-	mHeaderMutex.lock();
-
-	mLRU.clear(); // always clear the LRU
-
-	readEntriesHeader();
-	
-	if (mHeaderEntriesInfo.mVersion != sHeaderCacheVersion)
+	// Validate 1/256th of the files on startup
+	U32 validate_idx = 0;
+	if (!mReadOnly)
 	{
-		if (!mReadOnly)
-		{
-			purgeAllTextures(false);
-		}
+		validate_idx = gSavedSettings.getU32("CacheValidateCounter");
+		U32 next_idx = (++validate_idx) % 256;
+		gSavedSettings.setU32("CacheValidateCounter", next_idx);
+		LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Validating: " << validate_idx << LL_ENDL;
 	}
-	else
+
+	// Rebuild the free list and the body size total
+	U32 num_entries = mEntriesInfo->mEntries;
+	S32 purge_count = 0;
+	for (U32 idx = 0; idx < num_entries; idx++)
 	{
-		std::vector<Entry> entries;
-		U32 num_entries = openAndReadEntries(entries);
-		if (num_entries)
+		Entry& entry = mEntries[idx];
+		bool purge_entry = false;
+		if (entry.mImageSize <= entry.mBodySize || entry.mBodySize < 0)
 		{
-			U32 empty_entries = 0;
-			typedef std::pair<U32, S32> lru_data_t;
-			std::set<lru_data_t> lru;
-			std::set<U32> purge_list;
-			for (U32 i=0; i<num_entries; i++)
-			{
-				Entry& entry = entries[i];
-				if (entry.mImageSize <= 0)
-				{
-					// This will be in the Free List, don't put it in the LRU
-					++empty_entries;
-				}
-				else
-				{
-					lru.insert(std::make_pair(entry.mTime, i));
-					if (entry.mBodySize > 0)
-					{
-						if (entry.mBodySize > entry.mImageSize)
-						{
-							// Shouldn't happen, failsafe only
-							llwarns << "Bad entry: " << i << ": " << entry.mID << ": BodySize: " << entry.mBodySize << llendl;
-							purge_list.insert(i);
-						}
-					}
-				}
-			}
-			if (num_entries > sCacheMaxEntries)
+			if (entry.mImageSize > 0)
 			{
-				// Special case: cache size was reduced, need to remove entries
-				// Note: After we prune entries, we will call this again and create the LRU
-				U32 entries_to_purge = (num_entries-empty_entries) - sCacheMaxEntries;
-				llinfos << "Texture Cache Entries: " << num_entries << " Max: " << sCacheMaxEntries << " Empty: " << empty_entries << " Purging: " << entries_to_purge << llendl;
-				if (entries_to_purge > 0)
-				{
-					for (std::set<lru_data_t>::iterator iter = lru.begin(); iter != lru.end(); ++iter)
-					{
-						purge_list.insert(iter->second);
-						if (purge_list.size() >= entries_to_purge)
-							break;
-					}
-				}
-				llassert_always(purge_list.size() >= entries_to_purge);
+				// Shouldn't happen, failsafe only
+				llwarns << "Bad entry: " << idx << ": " << entry.mID << ": BodySize: " << entry.mBodySize << llendl;
+				purge_entry = true;
 			}
 			else
 			{
-				S32 lru_entries = (S32)((F32)sCacheMaxEntries * TEXTURE_CACHE_LRU_SIZE);
-				for (std::set<lru_data_t>::iterator iter = lru.begin(); iter != lru.end(); ++iter)
-				{
-					mLRU.insert(entries[iter->second].mID);
-// 					llinfos << "LRU: " << iter->first << " : " << iter->second << llendl;
-					if (--lru_entries <= 0)
-						break;
-				}
+				mFreeList.push_back(idx);
+				continue;
 			}
-			
-			if (purge_list.size() > 0)
+		}
+		else if (validate_idx && entry.mBodySize > 0 && entry.mID.mData[0] == validate_idx)
+		{
+			// make sure file exists and is the correct size
+			std::string filename = getTextureFileName(entry.mID);
+ 			LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entry.mBodySize << LL_ENDL;
+			S32 bodysize = LLAPRFile::size(filename, getLocalAPRFilePool());
+			if (bodysize != entry.mBodySize)
 			{
-				for (std::set<U32>::iterator iter = purge_list.begin(); iter != purge_list.end(); ++iter)
-				{
-					std::string tex_filename = getTextureFileName(entries[*iter].mID);
-					removeEntry((S32)*iter, entries[*iter], tex_filename);
-				}
-				// If we removed any entries, we need to rebuild the entries list,
-				// write the header, and call this again
-				std::vector<Entry> new_entries;
-				for (U32 i=0; i<num_entries; i++)
-				{
-					const Entry& entry = entries[i];
-					if (entry.mImageSize > 0)
-					{
-						new_entries.push_back(entry);
-					}
-				}
-				llassert_always(new_entries.size() <= sCacheMaxEntries);
-				mHeaderEntriesInfo.mEntries = new_entries.size();
-				writeEntriesHeader();
-				writeEntriesAndClose(new_entries);
-				mHeaderMutex.unlock(); // unlock the mutex before calling again
-				readHeaderCache(); // repeat with new entries file
-				mHeaderMutex.lock();
+				LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entry.mBodySize
+						<< filename << LL_ENDL;
+				purge_entry = true;
 			}
-			else
+		}
+
+		if (purge_entry)
+		{
+			purge_count++;
+			U32* slot = findIndexSlot(entry.mID);
+			if (slot && *slot == idx + 1)
 			{
-				//entries are not changed, nothing here.
+				eraseIndexSlot(slot);
 			}
+			LLAPRFile::remove(getTextureFileName(entry.mID), getLocalAPRFilePool());
+			entry.init(LLUUID::null, 0);
+			entry.mImageSize = -1;
+			mFreeList.push_back(idx);
+		}
+		else
+		{
+			mTexturesSizeTotal += entry.mBodySize;
 		}
 	}
-	mHeaderMutex.unlock();
-}
 
-//////////////////////////////////////////////////////////////////////////////
-
-//the header mutex is locked before calling this.
-void LLTextureCache::clearCorruptedCache()
-{
-	llwarns << "the texture cache is corrupted, need to be cleared." << llendl ;
-
-	closeHeaderEntriesFile();//close possible file handler
-	purgeAllTextures(false) ; //clear the cache.
-	
-	if (!mReadOnly) //regenerate the directory tree if not exists.
+	if (mTexturesSizeTotal > sCacheMaxTexturesSize)
 	{
-		LLFile::mkdir(mTexturesDirName);
-		
-		const char* subdirs = "0123456789abcdef";
-		for (S32 i=0; i<16; i++)
-		{
-			std::string dirname = mTexturesDirName + gDirUtilp->getDirDelimiter() + subdirs[i];
-			LLFile::mkdir(dirname);
-		}
+		mDoPurge = TRUE;
 	}
 
-	return ;
+	LL_INFOS("TextureCache") << "TEXTURE CACHE:"
+			<< " PURGED: " << purge_count
+			<< " ENTRIES: " << num_entries
+			<< " FREE: " << mFreeList.size()
+			<< " CACHE SIZE: " << mTexturesSizeTotal / (1024*1024) << " MB"
+			<< LL_ENDL;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+
 void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
 	if (!mReadOnly)
@@ -1525,133 +1366,151 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 			LLFile::rmdir(mTexturesDirName);
 		}		
 	}
-	mHeaderIDMap.clear();
-	mTexturesSizeMap.clear();
-	mTexturesSizeTotal = 0;
-	mFreeList.clear();
-	mTexturesSizeTotal = 0;
-	mUpdatedEntryMap.clear();
 
-	// Info with 0 entries
-	mHeaderEntriesInfo.mVersion = sHeaderCacheVersion;
-	mHeaderEntriesInfo.mEntries = 0;
-	writeEntriesHeader();
+	closeHeaderCache(false);
+	if (!mReadOnly && LLAPRFile::isExist(mHeaderEntriesFileName, getLocalAPRFilePool()))
+	{
+		LLAPRFile::remove(mHeaderEntriesFileName, getLocalAPRFilePool());
+	}
 
 	llinfos << "The entire texture cache is cleared." << llendl ;
 }
 
-void LLTextureCache::purgeTextures(bool validate)
+// Samples a few records from the purge hand and evicts the least recently used one,
+// max_count times. Called without any mutex locked.
+S32 LLTextureCache::evictEntries(S32 max_count, bool bodies_only)
 {
-	if (mReadOnly)
+	const U32 SAMPLE_SIZE = 32;
+
+	if (!mEntriesInfo || mReadOnly)
 	{
-		return;
+		return 0;
 	}
 
-	if (!mThreaded)
+	S32 evicted = 0;
+	for (S32 i = 0; i < max_count; i++)
 	{
-		// *FIX:Mani - watchdog off.
-		LLAppViewer::instance()->pauseMainloopTimeout();
-	}
-	
-	LLMutexLock lock(&mHeaderMutex);
+		lockHeaders();
+		U32 num_entries = mEntriesInfo->mEntries;
+		U32 hand = mPurgeHand;
+		mPurgeHand = num_entries ? (hand + SAMPLE_SIZE) % num_entries : 0;
+		unlockHeaders();
+		if (!num_entries)
+		{
+			break;
+		}
 
-	llinfos << "TEXTURE CACHE: Purging." << llendl;
+		// Unlocked peek at the records, the choice is checked against the index below
+		S32 oldest = -1;
+		U32 oldest_time = U32_MAX;
+		for (U32 j = 0; j < SAMPLE_SIZE && j < num_entries; j++)
+		{
+			S32 idx = (S32)((hand + j) % num_entries);
+			const Entry& entry = mEntries[idx];
+			if (entry.mImageSize > 0 && (!bodies_only || entry.mBodySize > 0) && entry.mTime < oldest_time)
+			{
+				oldest = idx;
+				oldest_time = entry.mTime;
+			}
+		}
+		if (oldest < 0)
+		{
+			continue;
+		}
 
-	// Read the entries list
-	std::vector<Entry> entries;
-	U32 num_entries = openAndReadEntries(entries);
-	if (!num_entries)
-	{
-		return; // nothing to purge
+		LLUUID id = mEntries[oldest].mID;
+		LLMutexLock lock(getIndexMutex(id));
+		U32* slot = findIndexSlot(id);
+		if (slot && *slot == (U32)oldest + 1)
+		{
+			std::string filename = getTextureFileName(id);
+	 		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
+			eraseIndexSlot(slot);
+			removeEntry(oldest, filename);
+			evicted++;
+		}
 	}
-	
-	// Use mTexturesSizeMap to collect UUIDs of textures with bodies
-	typedef std::set<std::pair<U32,S32> > time_idx_set_t;
-	std::set<std::pair<U32,S32> > time_idx_set;
-	for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-		 iter1 != mTexturesSizeMap.end(); ++iter1)
+	return evicted;
+}
+
+// Returns a free record, evicting the least recently used one if needed.
+S32 LLTextureCache::allocateEntry()
+{
+	const S32 MAX_RETRIES = 4;
+
+	for (S32 i = 0; i <= MAX_RETRIES; i++)
 	{
-		if (iter1->second > 0)
 		{
-			id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-			if (iter2 != mHeaderIDMap.end())
+			LLMutexLock lock(&mHeaderMutex);
+			if (!mFreeList.empty())
 			{
-				S32 idx = iter2->second;
-				time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-// 				llinfos << "TIME: " << entries[idx].mTime << " TEX: " << entries[idx].mID << " IDX: " << idx << " Size: " << entries[idx].mImageSize << llendl;
+				S32 idx = mFreeList.back();
+				mFreeList.pop_back();
+				return idx;
 			}
-			else
+			if (mEntriesInfo->mEntries < mEntriesInfo->mMaxEntries)
 			{
-				llerrs << "mTexturesSizeMap / mHeaderIDMap corrupted." << llendl ;
+				return (S32)mEntriesInfo->mEntries++;
 			}
 		}
+		evictEntries(1, false);
+	}
+	return -1;
+}
+
+void LLTextureCache::freeEntry(S32 idx, S32 body_size)
+{
+	LLMutexLock lock(&mHeaderMutex);
+	mTexturesSizeTotal -= body_size;
+	mFreeList.push_back(idx);
+}
+
+void LLTextureCache::updateTexturesSize(S32 delta)
+{
+	lockHeaders();
+	mTexturesSizeTotal += delta;
+	bool purge = mTexturesSizeTotal > sCacheMaxTexturesSize;
+	unlockHeaders();
+	if (purge)
+	{
+		mDoPurge = TRUE;
 	}
+}
+
+//update an existing entry
+bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
+{
+	S32 new_body_size = llmax(0, new_data_size - TEXTURE_CACHE_ENTRY_SIZE) ;
 	
-	// Validate 1/256th of the files on startup
-	U32 validate_idx = 0;
-	if (validate)
+	if(new_image_size == entry.mImageSize && new_body_size == entry.mBodySize)
 	{
-		validate_idx = gSavedSettings.getU32("CacheValidateCounter");
-		U32 next_idx = (++validate_idx) % 256;
-		gSavedSettings.setU32("CacheValidateCounter", next_idx);
-		LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Validating: " << validate_idx << LL_ENDL;
+		return true ; //nothing changed.
 	}
 
-	S64 cache_size = mTexturesSizeTotal;
-	S64 purged_cache_size = (sCacheMaxTexturesSize * (S64)((1.f-TEXTURE_CACHE_PURGE_AMOUNT)*100)) / 100;
-	S32 purge_count = 0;
-	for (time_idx_set_t::iterator iter = time_idx_set.begin();
-		 iter != time_idx_set.end(); ++iter)
+	LLMutex* mutex = getIndexMutex(entry.mID);
+	mutex->lock();
+	U32* slot = findIndexSlot(entry.mID);
+	if (!slot || *slot != (U32)idx + 1)
 	{
-		S32 idx = iter->second;
-		bool purge_entry = false;
-		std::string filename = getTextureFileName(entries[idx].mID);
-		if (cache_size >= purged_cache_size)
-		{
-			purge_entry = true;
-		}
-		else if (validate)
-		{
-			// make sure file exists and is the correct size
-			U32 uuididx = entries[idx].mID.mData[0];
-			if (uuididx == validate_idx)
-			{
- 				LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entries[idx].mBodySize << LL_ENDL;
-				S32 bodysize = LLAPRFile::size(filename, getLocalAPRFilePool());
-				if (bodysize != entries[idx].mBodySize)
-				{
-					LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize
-							<< filename << LL_ENDL;
-					purge_entry = true;
-				}
-			}
-		}
-		else
-		{
-			break;
-		}
-		
-		if (purge_entry)
-		{
-			purge_count++;
-	 		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
-			removeEntry(idx, entries[idx], filename) ;
-			cache_size -= entries[idx].mBodySize;
-		}
+		// evicted since it was read, add it back
+		mutex->unlock();
+		idx = setHeaderCacheEntry(entry.mID, entry, new_image_size, new_data_size);
+		return false;
 	}
 
-	LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing Entries: " << num_entries << LL_ENDL;
+	Entry& cached = mEntries[idx];
+	S32 delta = new_body_size - cached.mBodySize;
+	cached.mTime = time(NULL);
+	cached.mImageSize = new_image_size;
+	cached.mBodySize = new_body_size;
+	entry = cached;
+	mutex->unlock();
 
-	writeEntriesAndClose(entries);
-	
-	// *FIX:Mani - watchdog back on.
-	LLAppViewer::instance()->resumeMainloopTimeout();
-	
-	LL_INFOS("TextureCache") << "TEXTURE CACHE:"
-			<< " PURGED: " << purge_count
-			<< " ENTRIES: " << num_entries
-			<< " CACHE SIZE: " << mTexturesSizeTotal / 1024*1024 << " MB"
-			<< llendl;
+	if (delta)
+	{
+		updateTexturesSize(delta);
+	}
+	return false ;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1685,37 +1544,82 @@ LLTextureCacheWorker* LLTextureCache::getWriter(handle_t handle)
 // Reads imagesize from the header, updates timestamp
 S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 {
-	LLMutexLock lock(&mHeaderMutex);	
-	S32 idx = openAndReadEntry(id, entry, false);
-	if (idx >= 0)
-	{		
-		updateEntryTimeStamp(idx, entry); // updates time
+	if (!mEntriesInfo)
+	{
+		return -1;
+	}
+
+	LLMutexLock lock(getIndexMutex(id));
+	U32* slot = findIndexSlot(id);
+	if (!slot)
+	{
+		return -1;
 	}
+	S32 idx = (S32)*slot - 1;
+	Entry& cached = mEntries[idx];
+	if(cached.mImageSize <= cached.mBodySize)//it happens on 64-bit systems, do not know why
+	{
+		llwarns << "corrupted entry: " << id << " entry image size: " << cached.mImageSize << " entry body size: " << cached.mBodySize << llendl ;
+
+		//erase this entry and the cached texture from the cache.
+		std::string tex_filename = getTextureFileName(id);
+		eraseIndexSlot(slot);
+		removeEntry(idx, tex_filename) ;
+		return -1;
+	}
+	if (!mReadOnly)
+	{
+		cached.mTime = time(NULL); // updates time
+	}
+	entry = cached;
 	return idx;
 }
 
 // Writes imagesize to the header, updates timestamp
 S32 LLTextureCache::setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize)
 {
-	mHeaderMutex.lock();
-	S32 idx = openAndReadEntry(id, entry, true);
-	mHeaderMutex.unlock();
+	if (!mEntriesInfo || mReadOnly)
+	{
+		return -1;
+	}
 
-	if (idx >= 0)
+	S32 idx = allocateEntry();
+	if (idx < 0)
 	{
-		updateEntry(idx, entry, imagesize, datasize);				
+		return -1;
 	}
 
-	if(idx < 0) // retry
+	LLMutex* mutex = getIndexMutex(id);
+	mutex->lock();
+	U32* slot = findIndexSlot(id);
+	if (slot)
 	{
-		readHeaderCache(); // We couldn't write an entry, so refresh the LRU
-	
-		mHeaderMutex.lock();
-		llassert_always(!mLRU.empty() || mHeaderEntriesInfo.mEntries < sCacheMaxEntries);
-		mHeaderMutex.unlock();
+		// Another request added it first, update that entry instead
+		S32 cached_idx = (S32)*slot - 1;
+		entry = mEntries[cached_idx];
+		mutex->unlock();
+		freeEntry(idx, 0);
+		idx = cached_idx;
+		updateEntry(idx, entry, imagesize, datasize);
+		return idx;
+	}
 
-		idx = setHeaderCacheEntry(id, entry, imagesize, datasize); // assert above ensures no inf. recursion
+	S32 body_size = llmax(0, datasize - TEXTURE_CACHE_ENTRY_SIZE);
+	entry.init(id, time(NULL));
+	entry.mImageSize = imagesize;
+	entry.mBodySize = body_size;
+	mEntries[idx] = entry;
+	if (!insertIndex(id, idx))
+	{
+		mEntries[idx].init(LLUUID::null, 0);
+		mEntries[idx].mImageSize = -1;
+		mutex->unlock();
+		freeEntry(idx, 0);
+		return -1;
 	}
+	mutex->unlock();
+
+	updateTexturesSize(body_size);
 	return idx;
 }
 
@@ -1790,14 +1694,6 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id, U32 prio
 		delete responder;
 		return LLWorkerThread::nullHandle();
 	}
-	if (mDoPurge)
-	{
-		// NOTE: This may cause an occasional hiccup,
-		//  but it really needs to be done on the control thread
-		//  (i.e. here)		
-		purgeTextures(false);
-		mDoPurge = FALSE;
-	}
 	LLMutexLock lock(&mWorkersMutex);
 	LLTextureCacheWorker* worker = new LLTextureCacheRemoteWorker(this, priority, id,
 																  data, datasize, 0,
@@ -1843,54 +1739,42 @@ void LLTextureCache::addCompleted(Responder* responder, bool success)
 
 //////////////////////////////////////////////////////////////////////////////
 
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeCachedTexture(const LLUUID& id)
+//called after the index mutex of the entry is locked and its index slot is erased.
+void LLTextureCache::removeEntry(S32 idx, std::string& filename)
 {
-	if(mTexturesSizeMap.find(id) != mTexturesSizeMap.end())
-	{
-		mTexturesSizeTotal -= mTexturesSizeMap[id] ;
-		mTexturesSizeMap.erase(id);
-	}
-	mHeaderIDMap.erase(id);
-	LLAPRFile::remove(getTextureFileName(id), getLocalAPRFilePool());		
-}
+	Entry& entry = mEntries[idx];
+	S32 body_size = entry.mBodySize;
+	entry.init(LLUUID::null, 0);
+	entry.mImageSize = -1;
+	freeEntry(idx, body_size);
 
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
-{
-	if(idx >= 0) //valid entry
+	if (body_size > 0)
 	{
-		entry.mImageSize = -1;
-		entry.mBodySize = 0;
-		mHeaderIDMap.erase(entry.mID);
-		mTexturesSizeMap.erase(entry.mID);
-
-		mTexturesSizeTotal -= entry.mBodySize;
-		mFreeList.insert(idx);	
+		LLAPRFile::remove(filename, getLocalAPRFilePool());
 	}
-
-	LLAPRFile::remove(filename, getLocalAPRFilePool());		
 }
 
 bool LLTextureCache::removeFromCache(const LLUUID& id)
 {
 	//llwarns << "Removing texture from cache: " << id << llendl;
 	bool ret = false ;
-	if (!mReadOnly)
+	if (!mReadOnly && mEntriesInfo)
 	{
-		lockHeaders() ;
+		LLMutexLock lock(getIndexMutex(id));
 
-		Entry entry;
-		S32 idx = openAndReadEntry(id, entry, false);
 		std::string tex_filename = getTextureFileName(id);
-		removeEntry(idx, entry, tex_filename) ;
-		if (idx >= 0)
-		{			
-			writeEntryToHeaderImmediately(idx, entry);					
+		U32* slot = findIndexSlot(id);
+		if (slot)
+		{
+			S32 idx = (S32)*slot - 1;
+			eraseIndexSlot(slot);
+			removeEntry(idx, tex_filename) ;
 			ret = true;
 		}
-
-		unlockHeaders() ;
+		else
+		{
+			LLAPRFile::remove(tex_filename, getLocalAPRFilePool());
+		}
 	}
 	return ret ;
 }
@@ -32,6 +32,7 @@
 #include "llstring.h"
 #include "lluuid.h"
 
+#include "llmappedfile.h"
 #include "llworkerthread.h"
 
 class LLImageFormatted;
@@ -45,11 +46,16 @@ class LLTextureCache : public LLWorkerThread
 
 private:
 	// Entries
+	// texture.entries is mapped into memory: EntriesInfo, then mMaxEntries Entry records,
+	// then an open addressed index of mIndexSize slots (0 = empty, otherwise record idx + 1).
+	// The index is split into INDEX_STRIPES equal sub tables, each guarded by its own mutex.
 	struct EntriesInfo
 	{
-		EntriesInfo() : mVersion(0.f), mEntries(0) {}
 		F32 mVersion;
-		U32 mEntries;
+		U32 mEntries; // high water mark of used records
+		U32 mMaxEntries;
+		U32 mIndexSize;
+		U32 mClean; // TRUE if the index was written out on a clean shutdown
 	};
 	struct Entry
 	{
@@ -131,7 +137,7 @@ public:
 	S32 getNumWrites() { return mWriters.size(); }
 	S64 getUsage() { return mTexturesSizeTotal; }
 	S64 getMaxUsage() { return sCacheMaxTexturesSize; }
-	U32 getEntries() { return mHeaderEntriesInfo.mEntries; }
+	U32 getEntries() { return mEntriesInfo ? mEntriesInfo->mEntries : 0; }
 	U32 getMaxEntries() { return sCacheMaxEntries; };
 	BOOL isInCache(const LLUUID& id) ;
 	BOOL isInLocal(const LLUUID& id) ;
@@ -146,37 +152,40 @@ protected:
 	//void setFileAPRPool(apr_pool_t* pool) { mFileAPRPool = pool ; }
 
 private:
+	enum { INDEX_STRIPES = 16 };
+
 	void setDirNames(ELLPath location);
 	void readHeaderCache();
-	void clearCorruptedCache();
+	bool mapHeaderCache();
+	bool createHeaderCache(U32 max_entries);
+	bool resizeHeaderCache(U32 max_entries);
+	void closeHeaderCache(bool clean);
+	void rebuildIndex();
 	void purgeAllTextures(bool purge_directories);
-	void purgeTextures(bool validate);
-	LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
-	void closeHeaderEntriesFile();
-	void readEntriesHeader();
-	void writeEntriesHeader();
-	S32 openAndReadEntry(const LLUUID& id, Entry& entry, bool create);
+	S32 evictEntries(S32 max_count, bool bodies_only);
+	S32 allocateEntry();
+	void freeEntry(S32 idx, S32 body_size);
+	void updateTexturesSize(S32 delta);
+	LLMutex* getIndexMutex(const LLUUID& id) { return mIndexMutex[hashID(id) & (INDEX_STRIPES - 1)]; }
+	static U32 hashID(const LLUUID& id);
+	static S64 getHeaderCacheSize(U32 max_entries, U32 index_size);
+	U32* findIndexSlot(const LLUUID& id);
+	bool insertIndex(const LLUUID& id, S32 idx);
+	void eraseIndexSlot(U32* slot);
 	bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
-	void updateEntryTimeStamp(S32 idx, Entry& entry) ;
-	U32 openAndReadEntries(std::vector<Entry>& entries);
-	void writeEntriesAndClose(const std::vector<Entry>& entries);
-	void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
-	void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
-	void removeEntry(S32 idx, Entry& entry, std::string& filename);
-	void removeCachedTexture(const LLUUID& id) ;
+	void removeEntry(S32 idx, std::string& filename);
 	S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
 	S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
-	void writeUpdatedEntries() ;
-	void updatedHeaderEntriesFile() ;
+	void writeUpdatedEntries(bool wait = false);
 	void lockHeaders() { mHeaderMutex.lock(); }
 	void unlockHeaders() { mHeaderMutex.unlock(); }
 	
 private:
 	// Internal
 	LLMutex mWorkersMutex;
-	LLMutex mHeaderMutex;
+	LLMutex mHeaderMutex; // guards mFreeList, mEntriesInfo->mEntries and mTexturesSizeTotal
 	LLMutex mListMutex;
-	LLAPRFile* mHeaderAPRFile;
+	LLMutex* mIndexMutex[INDEX_STRIPES]; // guard the index slots and the records they point to
 	
 	typedef std::map<handle_t, LLTextureCacheWorker*> handle_map_t;
 	handle_map_t mReaders;
@@ -193,22 +202,19 @@ private:
 	// HEADERS (Include first mip)
 	std::string mHeaderEntriesFileName;
 	std::string mHeaderDataFileName;
-	EntriesInfo mHeaderEntriesInfo;
-	std::set<S32> mFreeList; // deleted entries
-	std::set<LLUUID> mLRU;
-	typedef std::map<LLUUID,S32> id_map_t;
-	id_map_t mHeaderIDMap;
+	LLMappedFile mHeaderMap;
+	EntriesInfo* mEntriesInfo; // NULL when the cache is not available
+	Entry* mEntries;
+	U32* mIndex;
+	U32 mStripeSize;
+	std::vector<S32> mFreeList; // deleted entries
+	U32 mPurgeHand; // next record sampled by evictEntries()
 
 	// BODIES (TEXTURES minus headers)
 	std::string mTexturesDirName;
-	typedef std::map<LLUUID,S32> size_map_t;
-	size_map_t mTexturesSizeMap;
 	S64 mTexturesSizeTotal;
 	LLAtomic32<BOOL> mDoPurge;
 
-	typedef std::map<S32, Entry> idx_entry_map_t;
-	idx_entry_map_t mUpdatedEntryMap;
-
 	// Statics
 	static F32 sHeaderCacheVersion;
 	static U32 sCacheMaxEntries;
@@ -128,6 +128,13 @@ static bool handleSetShaderChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleLogSettingsLookupsChanged(const LLSD& newvalue)
+{
+	gSavedSettings.resetLookupCounts();
+	LLControlGroup::setCountLookups(newvalue.asBoolean());
+	return true;
+}
+
 bool handleRenderTransparentWaterChanged(const LLSD& newvalue)
 {
 	LLWorld::getInstance()->updateWaterObjects();
@@ -664,6 +671,8 @@ void settings_setup_listeners()
 	gSavedSettings.getControl("UpdaterServiceActive")->getSignal()->connect(&toggle_updater_service_active);
 	gSavedSettings.getControl("ForceShowGrid")->getSignal()->connect(boost::bind(&handleForceShowGrid, _2));
 	gSavedSettings.getControl("RenderTransparentWater")->getSignal()->connect(boost::bind(&handleRenderTransparentWaterChanged, _2));
+	gSavedSettings.getControl("LogSettingsLookups")->getSignal()->connect(boost::bind(&handleLogSettingsLookupsChanged, _2));
+	LLControlGroup::setCountLookups(gSavedSettings.getBOOL("LogSettingsLookups"));
 }
 
 #if TEST_CACHED_CONTROL
@@ -189,7 +189,7 @@ void display_update_camera()
 // Write some stats to llinfos
 void display_stats()
 {
-	F32 fps_log_freq = gSavedSettings.getF32("FPSLogFrequency");
+	static LLCachedControl<F32> fps_log_freq(gSavedSettings, "FPSLogFrequency");
 	if (fps_log_freq > 0.f && gRecentFPSTime.getElapsedTimeF32() >= fps_log_freq)
 	{
 		F32 fps = gRecentFrameCount / fps_log_freq;
@@ -197,7 +197,7 @@ void display_stats()
 		gRecentFrameCount = 0;
 		gRecentFPSTime.reset();
 	}
-	F32 mem_log_freq = gSavedSettings.getF32("MemoryLogFrequency");
+	static LLCachedControl<F32> mem_log_freq(gSavedSettings, "MemoryLogFrequency");
 	if (mem_log_freq > 0.f && gRecentMemoryTime.getElapsedTimeF32() >= mem_log_freq)
 	{
 		gMemoryAllocated = LLMemory::getCurrentRSS();
@@ -334,8 +334,10 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 
 	LLImageGL::updateStats(gFrameTimeSeconds);
 	
-	LLVOAvatar::sRenderName = gSavedSettings.getS32("AvatarNameTagMode");
-	LLVOAvatar::sRenderGroupTitles = (gSavedSettings.getBOOL("NameTagShowGroupTitles") && gSavedSettings.getS32("AvatarNameTagMode"));
+	static LLCachedControl<S32> name_tag_mode(gSavedSettings, "AvatarNameTagMode");
+	static LLCachedControl<bool> name_tag_show_group_titles(gSavedSettings, "NameTagShowGroupTitles");
+	LLVOAvatar::sRenderName = name_tag_mode;
+	LLVOAvatar::sRenderGroupTitles = (name_tag_show_group_titles && name_tag_mode);
 	
 	gPipeline.mBackfaceCull = TRUE;
 	gFrameCount++;
@@ -610,10 +612,11 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 		LLDrawable::incrementVisible();
 
 		LLSpatialGroup::sNoDelete = TRUE;
+		static LLCachedControl<bool> use_occlusion(gSavedSettings, "UseOcclusion");
 		LLPipeline::sUseOcclusion = 
 				(!gUseWireframe
 				&& LLFeatureManager::getInstance()->isFeatureAvailable("UseOcclusion") 
-				&& gSavedSettings.getBOOL("UseOcclusion") 
+				&& use_occlusion 
 				&& gGLManager.mHasOcclusionQuery) ? 2 : 0;
 
 		if (LLPipeline::sUseOcclusion && LLPipeline::sRenderDeferred)
@@ -621,11 +624,16 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot)
 			LLPipeline::sUseOcclusion = 3;
 		}
 
-		LLPipeline::sAutoMaskAlphaDeferred = gSavedSettings.getBOOL("RenderAutoMaskAlphaDeferred");
-		LLPipeline::sAutoMaskAlphaNonDeferred = gSavedSettings.getBOOL("RenderAutoMaskAlphaNonDeferred");
-		LLPipeline::sUseFarClip = gSavedSettings.getBOOL("RenderUseFarClip");
-		LLVOAvatar::sMaxVisible = (U32)gSavedSettings.getS32("RenderAvatarMaxVisible");
-		LLPipeline::sDelayVBUpdate = gSavedSettings.getBOOL("RenderDelayVBUpdate");
+		static LLCachedControl<bool> auto_mask_alpha_deferred(gSavedSettings, "RenderAutoMaskAlphaDeferred");
+		static LLCachedControl<bool> auto_mask_alpha_non_deferred(gSavedSettings, "RenderAutoMaskAlphaNonDeferred");
+		static LLCachedControl<bool> use_far_clip(gSavedSettings, "RenderUseFarClip");
+		static LLCachedControl<S32> avatar_max_visible(gSavedSettings, "RenderAvatarMaxVisible");
+		static LLCachedControl<bool> delay_vb_update(gSavedSettings, "RenderDelayVBUpdate");
+		LLPipeline::sAutoMaskAlphaDeferred = auto_mask_alpha_deferred;
+		LLPipeline::sAutoMaskAlphaNonDeferred = auto_mask_alpha_non_deferred;
+		LLPipeline::sUseFarClip = use_far_clip;
+		LLVOAvatar::sMaxVisible = (U32)(S32)avatar_max_visible;
+		LLPipeline::sDelayVBUpdate = delay_vb_update;
 
 		S32 occlusion = LLPipeline::sUseOcclusion;
 		if (gDepthDirty)
@@ -951,7 +959,8 @@ void render_hud_attachments()
 		hud_cam.setAxes(LLVector3(1,0,0), LLVector3(0,1,0), LLVector3(0,0,1));
 		LLViewerCamera::updateFrustumPlanes(hud_cam, TRUE);
 
-		bool render_particles = gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_PARTICLES) && gSavedSettings.getBOOL("RenderHUDParticles");
+		static LLCachedControl<bool> render_hud_particles(gSavedSettings, "RenderHUDParticles");
+		bool render_particles = gPipeline.hasRenderType(LLPipeline::RENDER_TYPE_PARTICLES) && render_hud_particles;
 		
 		//only render hud objects
 		gPipeline.pushRenderTypeMask();
@@ -1277,7 +1286,8 @@ void render_ui_3d()
 	// Debugging stuff goes before the UI.
 
 	// Coordinate axes
-	if (gSavedSettings.getBOOL("ShowAxes"))
+	static LLCachedControl<bool> show_axes(gSavedSettings, "ShowAxes");
+	if (show_axes)
 	{
 		draw_axes();
 	}
@@ -1335,7 +1345,8 @@ void render_ui_2d()
 	}
 	
 
-	if (gSavedSettings.getBOOL("RenderUIBuffer"))
+	static LLCachedControl<bool> render_ui_buffer(gSavedSettings, "RenderUIBuffer");
+	if (render_ui_buffer)
 	{
 		if (LLUI::sDirty)
 		{
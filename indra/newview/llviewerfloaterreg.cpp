@@ -30,6 +30,8 @@
 #include "llfloaterreg.h"
 
 #include "llviewerfloaterreg.h"
+#include "llcallbacklist.h"
+#include "llviewercontrol.h"
 
 #include "llcompilequeue.h"
 #include "llcallfloater.h"
@@ -122,6 +124,11 @@
 #include "llscriptfloater.h"
 // *NOTE: Please add files in alphabetical order to keep merges easy.
 
+static const std::string FLOATER_USAGE_FILE("floater_usage.xml");
+// A floater type has to have been opened this often, recently, to be prebuilt
+static const F32 PREBUILD_MIN_USES = 2.f;
+// Time spent prebuilding per slice, beyond the first floater
+static const F32 PREBUILD_SLICE_TIME = 0.01f;
 
 void LLViewerFloaterReg::registerFloaters()
 {
@@ -258,3 +265,43 @@ void LLViewerFloaterReg::registerFloaters()
 	
 	LLFloaterReg::registerControlVariables(); // Make sure visibility and rect controls get preserved when saving
 }
+
+//static
+void LLViewerFloaterReg::startPrebuild()
+{
+	LLFloaterReg::loadUsage(gDirUtilp->getExpandedFilename(LL_PATH_PER_SL_ACCOUNT, FLOATER_USAGE_FILE));
+
+	U32 max_floaters = gSavedSettings.getU32("FloaterPrebuildCount");
+	if (max_floaters > 0)
+	{
+		LLFloaterReg::queuePrebuild(max_floaters, PREBUILD_MIN_USES);
+		gIdleCallbacks.addFunction(idlePrebuild, NULL);
+	}
+}
+
+//static
+void LLViewerFloaterReg::saveUsage()
+{
+	if (gDirUtilp->getLindenUserDir().empty())
+	{
+		return;
+	}
+	LLFloaterReg::saveUsage(gDirUtilp->getExpandedFilename(LL_PATH_PER_SL_ACCOUNT, FLOATER_USAGE_FILE));
+}
+
+//static
+void LLViewerFloaterReg::idlePrebuild(void*)
+{
+	// One slice every so often, so the hitches don't pile up into one
+	static LLFrameTimer slice_timer;
+	static LLCachedControl<F32> prebuild_interval(gSavedSettings, "FloaterPrebuildInterval");
+	if (slice_timer.getElapsedTimeF32() < prebuild_interval)
+	{
+		return;
+	}
+	if (!LLFloaterReg::prebuildInstances(PREBUILD_SLICE_TIME))
+	{
+		gIdleCallbacks.deleteFunction(idlePrebuild, NULL);
+	}
+	slice_timer.reset();
+}
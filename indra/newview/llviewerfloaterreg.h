@@ -31,6 +31,14 @@ class LLViewerFloaterReg
 {
 public:
 	static void registerFloaters();
+
+	// Loads last sessions' floater usage and starts prebuilding the most used
+	// floaters at idle time. Call once logged in.
+	static void startPrebuild();
+	static void saveUsage();
+
+private:
+	static void idlePrebuild(void*);
 };
 
 
@@ -782,99 +782,33 @@ BOOL LLViewerJointMesh::updateLOD(F32 pixel_area, BOOL activate)
 	return (valid != activate);
 }
 
-// static
-void LLViewerJointMesh::updateGeometryOriginal(LLFace *mFace, LLPolyMesh *mMesh)
+void LLViewerJointMesh::updateGeometry(skinning_func_t func)
 {
-	LLStrider<LLVector3> o_vertices;
-	LLStrider<LLVector3> o_normals;
+	LLSkinningData data;
 
-	//get vertex and normal striders
-	LLVertexBuffer *buffer = mFace->mVertexBuffer;
-	buffer->getVertexStrider(o_vertices,  0);
-	buffer->getNormalStrider(o_normals,   0);
-
-	F32 last_weight = F32_MAX;
-	LLMatrix4 gBlendMat;
-	LLMatrix3 gBlendRotMat;
-
-	const F32* weights = mMesh->getWeights();
-	const LLVector3* coords = mMesh->getCoords();
-	const LLVector3* normals = mMesh->getNormals();
-	for (U32 index = 0; index < mMesh->getNumVertices(); index++)
+	LLDynamicArray<LLJointRenderData*>& joint_data = mMesh->getReferenceMesh()->mJointRenderData;
+	llassert(joint_data.count() <= LL_MAX_SKIN_JOINT_ENTRIES);
+	data.mNumJoints = joint_data.count();
+	for (S32 j = 0; j < data.mNumJoints; ++j)
 	{
-		U32 bidx = index + mMesh->mFaceVertexOffset;
-		
-		// blend by first matrix
-		F32 w = weights[index]; 
-		
-		// Maybe we don't have to change gBlendMat.
-		// Profiles of a single-avatar scene on a Mac show this to be a very
-		// common case.  JC
-		if (w == last_weight)
-		{
-			o_vertices[bidx] = coords[index] * gBlendMat;
-			o_normals[bidx] = normals[index] * gBlendRotMat;
-			continue;
-		}
-		
-		last_weight = w;
-
-		S32 joint = llfloor(w);
-		w -= joint;
-		
-		// No lerp required in this case.
-		if (w == 1.0f)
-		{
-			gBlendMat = gJointMatUnaligned[joint+1];
-			o_vertices[bidx] = coords[index] * gBlendMat;
-			gBlendRotMat = gJointRotUnaligned[joint+1];
-			o_normals[bidx] = normals[index] * gBlendRotMat;
-			continue;
-		}
-		
-		// Try to keep all the accesses to the matrix data as close
-		// together as possible.  This function is a hot spot on the
-		// Mac. JC
-		LLMatrix4 &m0 = gJointMatUnaligned[joint+1];
-		LLMatrix4 &m1 = gJointMatUnaligned[joint+0];
-		
-		gBlendMat.mMatrix[VX][VX] = lerp(m1.mMatrix[VX][VX], m0.mMatrix[VX][VX], w);
-		gBlendMat.mMatrix[VX][VY] = lerp(m1.mMatrix[VX][VY], m0.mMatrix[VX][VY], w);
-		gBlendMat.mMatrix[VX][VZ] = lerp(m1.mMatrix[VX][VZ], m0.mMatrix[VX][VZ], w);
-
-		gBlendMat.mMatrix[VY][VX] = lerp(m1.mMatrix[VY][VX], m0.mMatrix[VY][VX], w);
-		gBlendMat.mMatrix[VY][VY] = lerp(m1.mMatrix[VY][VY], m0.mMatrix[VY][VY], w);
-		gBlendMat.mMatrix[VY][VZ] = lerp(m1.mMatrix[VY][VZ], m0.mMatrix[VY][VZ], w);
-
-		gBlendMat.mMatrix[VZ][VX] = lerp(m1.mMatrix[VZ][VX], m0.mMatrix[VZ][VX], w);
-		gBlendMat.mMatrix[VZ][VY] = lerp(m1.mMatrix[VZ][VY], m0.mMatrix[VZ][VY], w);
-		gBlendMat.mMatrix[VZ][VZ] = lerp(m1.mMatrix[VZ][VZ], m0.mMatrix[VZ][VZ], w);
+		data.mWorldMatrices[j] = joint_data[j]->mWorldMatrix;
+		data.mPivots[j] = joint_data[j]->mSkinJoint ?
+			joint_data[j]->mSkinJoint->mRootToJointSkinOffset
+			: joint_data[j+1]->mSkinJoint->mRootToParentJointSkinOffset;
+	}
 
-		gBlendMat.mMatrix[VW][VX] = lerp(m1.mMatrix[VW][VX], m0.mMatrix[VW][VX], w);
-		gBlendMat.mMatrix[VW][VY] = lerp(m1.mMatrix[VW][VY], m0.mMatrix[VW][VY], w);
-		gBlendMat.mMatrix[VW][VZ] = lerp(m1.mMatrix[VW][VZ], m0.mMatrix[VW][VZ], w);
+	data.mNumVertices = mMesh->getNumVertices();
+	data.mWeights = mMesh->getWeights();
+	data.mCoords = mMesh->getCoords();
+	data.mNormals = mMesh->getNormals();
 
-		o_vertices[bidx] = coords[index] * gBlendMat;
-		
-		LLMatrix3 &n0 = gJointRotUnaligned[joint+1];
-		LLMatrix3 &n1 = gJointRotUnaligned[joint+0];
-		
-		gBlendRotMat.mMatrix[VX][VX] = lerp(n1.mMatrix[VX][VX], n0.mMatrix[VX][VX], w);
-		gBlendRotMat.mMatrix[VX][VY] = lerp(n1.mMatrix[VX][VY], n0.mMatrix[VX][VY], w);
-		gBlendRotMat.mMatrix[VX][VZ] = lerp(n1.mMatrix[VX][VZ], n0.mMatrix[VX][VZ], w);
-
-		gBlendRotMat.mMatrix[VY][VX] = lerp(n1.mMatrix[VY][VX], n0.mMatrix[VY][VX], w);
-		gBlendRotMat.mMatrix[VY][VY] = lerp(n1.mMatrix[VY][VY], n0.mMatrix[VY][VY], w);
-		gBlendRotMat.mMatrix[VY][VZ] = lerp(n1.mMatrix[VY][VZ], n0.mMatrix[VY][VZ], w);
+	LLVertexBuffer *buffer = mFace->mVertexBuffer;
+	buffer->getVertexStrider(data.mOutVertices, mMesh->mFaceVertexOffset);
+	buffer->getNormalStrider(data.mOutNormals, mMesh->mFaceVertexOffset);
 
-		gBlendRotMat.mMatrix[VZ][VX] = lerp(n1.mMatrix[VZ][VX], n0.mMatrix[VZ][VX], w);
-		gBlendRotMat.mMatrix[VZ][VY] = lerp(n1.mMatrix[VZ][VY], n0.mMatrix[VZ][VY], w);
-		gBlendRotMat.mMatrix[VZ][VZ] = lerp(n1.mMatrix[VZ][VZ], n0.mMatrix[VZ][VZ], w);
-		
-		o_normals[bidx] = normals[index] * gBlendRotMat;
-	}
+	func(data);
 
-	buffer->setBuffer(0);
+	//setBuffer(0) called in LLVOAvatar::renderSkinned
 }
 
 const U32 UPDATE_GEOMETRY_CALL_MASK			= 0x1FFF; // 8K samples before overflow
@@ -893,7 +827,7 @@ static BOOL sVectorizePerfTest 				= FALSE;
 static U32 sVectorizeProcessor 				= 0;
 
 //static
-void (*LLViewerJointMesh::sUpdateGeometryFunc)(LLFace* face, LLPolyMesh* mesh);
+skinning_func_t LLViewerJointMesh::sUpdateGeometryFunc = &ll_skin_original;
 
 //static
 void LLViewerJointMesh::updateVectorize()
@@ -906,7 +840,8 @@ void LLViewerJointMesh::updateVectorize()
 	std::string vp;
 	switch(sVectorizeProcessor)
 	{
-		case 2: vp = "SSE2"; break;					// *TODO: replace the magic #s
+		case 3: vp = "AVX2"; break;					// *TODO: replace the magic #s
+		case 2: vp = "SSE2"; break;
 		case 1: vp = "SSE"; break;
 		default: vp = "COMPILER DEFAULT"; break;
 	}
@@ -917,20 +852,23 @@ void LLViewerJointMesh::updateVectorize()
 	{
 		switch(sVectorizeProcessor)
 		{
+			case 3:
+				sUpdateGeometryFunc = &ll_skin_avx2;
+				break;
 			case 2:
-				sUpdateGeometryFunc = &updateGeometrySSE2;
+				sUpdateGeometryFunc = &ll_skin_sse2;
 				break;
 			case 1:
-				sUpdateGeometryFunc = &updateGeometrySSE;
+				sUpdateGeometryFunc = &ll_skin_sse;
 				break;
 			default:
-				sUpdateGeometryFunc = &updateGeometryVectorized;
+				sUpdateGeometryFunc = &ll_skin_vectorized;
 				break;
 		}
 	}
 	else
 	{
-		sUpdateGeometryFunc = &updateGeometryOriginal;
+		sUpdateGeometryFunc = &ll_skin_original;
 	}
 }
 
@@ -950,9 +888,7 @@ void LLViewerJointMesh::updateJointGeometry()
 	{
 		// Once we've measured performance, just run the specified
 		// code version.
-		if(sUpdateGeometryFunc == updateGeometryOriginal)
-			uploadJointMatrices();
-		sUpdateGeometryFunc(mFace, mMesh);
+		updateGeometry(sUpdateGeometryFunc);
 	}
 	else
 	{
@@ -962,15 +898,12 @@ void LLViewerJointMesh::updateJointGeometry()
 		
 		if (sUpdateGeometryCallPointer)
 		{
-			if(sUpdateGeometryFunc == updateGeometryOriginal)
-				uploadJointMatrices();
 			// call accelerated version for this processor
-			sUpdateGeometryFunc(mFace, mMesh);
+			updateGeometry(sUpdateGeometryFunc);
 		}
 		else
 		{
-			uploadJointMatrices();
-			updateGeometryOriginal(mFace, mMesh);
+			updateGeometry(&ll_skin_original);
 		}
 	
 		sUpdateGeometryElapsedTime += ug_timer.getElapsedTimeF64();
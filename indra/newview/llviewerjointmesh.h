@@ -30,6 +30,7 @@
 #include "llviewerjoint.h"
 #include "llviewertexture.h"
 #include "llpolymesh.h"
+#include "llviewerskinning.h"
 #include "v4color.h"
 
 class LLDrawable;
@@ -148,18 +149,12 @@ public:
 private:
 	// Avatar vertex skinning is a significant performance issue on computers
 	// with avatar vertex programs turned off (for example, most Macs).  We
-	// therefore have custom versions that use SIMD instructions.
-	//
-	// These functions require compiler options for SSE2, SSE, or neither, and
-	// hence are contained in separate individual .cpp files.  JC
-	static void updateGeometryOriginal(LLFace* face, LLPolyMesh* mesh);
-	// generic vector code, used for Altivec
-	static void updateGeometryVectorized(LLFace* face, LLPolyMesh* mesh);
-	static void updateGeometrySSE(LLFace* face, LLPolyMesh* mesh);
-	static void updateGeometrySSE2(LLFace* face, LLPolyMesh* mesh);
+	// therefore have custom versions that use SIMD instructions, see
+	// llviewerskinning.h.  JC
+	void updateGeometry(skinning_func_t func);
 
 	// Use a fuction pointer to indicate which version we are running.
-	static void (*sUpdateGeometryFunc)(LLFace* face, LLPolyMesh* mesh);
+	static skinning_func_t sUpdateGeometryFunc;
 
 private:
 	// Allocate skin data
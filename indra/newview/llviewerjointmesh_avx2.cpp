@@ -0,0 +1,268 @@
+/**
+ * @file llviewerjointmesh_avx2.cpp
+ * @brief AVX2/FMA joint skinning code, eight vertices at a time, only used
+ * when video card does not support avatar vertex programs.
+ *
+ * *NOTE: See llv4math.h for notes on SSE/Altivec vector code.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+//-----------------------------------------------------------------------------
+// Header Files
+//-----------------------------------------------------------------------------
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llviewerskinning.h"
+
+// library includes
+#include "llv4math.h"		// for LL_VECTORIZE
+#include "m3math.h"
+#include "m4math.h"
+#include "v3math.h"
+
+// Unlike the SSE files this one is built with the default code generation.
+// Only the functions below are compiled for AVX2, so nothing that runs
+// before main() (see llv4math.h) or on other CPUs picks up AVX instructions.
+// Callers check LLCPUInfo::hasAVX2() and hasFMA() first.
+#if LL_VECTORIZE && ((LL_MSVC && _MSC_VER >= 1700) || defined(__clang__) || GCC_VERSION >= 40900)
+#define LL_SKIN_AVX2 1
+#endif
+
+#if LL_SKIN_AVX2
+
+#include <immintrin.h>
+
+#if LL_GNUC
+#define LL_AVX2_FUNC __attribute__((target("avx2,fma")))
+#else
+#define LL_AVX2_FUNC
+#endif
+
+const U32 SKIN_BLOCK_SIZE = 8;	// vertices per iteration, one per lane
+
+// Eight LLVector3 into one register each of x, y and z
+static inline LL_AVX2_FUNC void load_block(const F32* p, __m256& x, __m256& y, __m256& z)
+{
+	__m256 m03 = _mm256_castps128_ps256(_mm_loadu_ps(p));
+	__m256 m14 = _mm256_castps128_ps256(_mm_loadu_ps(p + 4));
+	__m256 m25 = _mm256_castps128_ps256(_mm_loadu_ps(p + 8));
+	m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(p + 12), 1);
+	m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(p + 16), 1);
+	m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(p + 20), 1);
+
+	__m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+	__m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+	x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+// The reverse of load_block()
+static inline LL_AVX2_FUNC void store_block(F32* p, __m256 x, __m256 y, __m256 z)
+{
+	__m256 rxy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 ryz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	__m256 rzx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+	__m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+	__m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+
+	_mm_storeu_ps(p, _mm256_castps256_ps128(r03));
+	_mm_storeu_ps(p + 4, _mm256_castps256_ps128(r14));
+	_mm_storeu_ps(p + 8, _mm256_castps256_ps128(r25));
+	_mm_storeu_ps(p + 12, _mm256_extractf128_ps(r03, 1));
+	_mm_storeu_ps(p + 16, _mm256_extractf128_ps(r14, 1));
+	_mm_storeu_ps(p + 20, _mm256_extractf128_ps(r25, 1));
+}
+
+// The first three floats of v
+static inline LL_AVX2_FUNC void store_vector3(LLStrider<LLVector3>& out, U32 index, __m128 v)
+{
+	F32* dst = out[index].mV;
+	_mm_storel_pi((__m64*)dst, v);
+	_mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+}
+
+static inline LL_AVX2_FUNC void write_block(LLStrider<LLVector3>& out, U32 index, U32 count,
+											__m256 x, __m256 y, __m256 z)
+{
+	if (count == SKIN_BLOCK_SIZE && out.getSkip() == sizeof(LLVector3))
+	{
+		store_block(out[index].mV, x, y, z);
+		return;
+	}
+
+	// Interleaved vertex buffer, or the last few vertices.  Vertex i ends
+	// up in half i / 4 of register i % 4.  Written out one by one without a
+	// loop, so the registers don't go through the stack.
+	__m256 xy_lo = _mm256_unpacklo_ps(x, y);
+	__m256 xy_hi = _mm256_unpackhi_ps(x, y);
+	__m256 zz_lo = _mm256_unpacklo_ps(z, z);
+	__m256 zz_hi = _mm256_unpackhi_ps(z, z);
+	__m256 v04 = _mm256_shuffle_ps(xy_lo, zz_lo, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 v15 = _mm256_shuffle_ps(xy_lo, zz_lo, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 v26 = _mm256_shuffle_ps(xy_hi, zz_hi, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 v37 = _mm256_shuffle_ps(xy_hi, zz_hi, _MM_SHUFFLE(3, 2, 3, 2));
+
+	store_vector3(out, index, _mm256_castps256_ps128(v04));
+	if (count > 1) store_vector3(out, index + 1, _mm256_castps256_ps128(v15));
+	if (count > 2) store_vector3(out, index + 2, _mm256_castps256_ps128(v26));
+	if (count > 3) store_vector3(out, index + 3, _mm256_castps256_ps128(v37));
+	if (count > 4) store_vector3(out, index + 4, _mm256_extractf128_ps(v04, 1));
+	if (count > 5) store_vector3(out, index + 5, _mm256_extractf128_ps(v15, 1));
+	if (count > 6) store_vector3(out, index + 6, _mm256_extractf128_ps(v26, 1));
+	if (count > 7) store_vector3(out, index + 7, _mm256_extractf128_ps(v37, 1));
+}
+
+// One blend matrix element for each lane: element offset of joint matrix
+// j + 1 lerped with joint matrix j by fraction
+static inline LL_AVX2_FUNC __m256 blend_element(const F32* table, S32 offset, __m256i joint_offsets, __m256 fraction)
+{
+	__m256 a = _mm256_i32gather_ps(table + offset, joint_offsets, 4);
+	__m256 b = _mm256_i32gather_ps(table + 16 + offset, joint_offsets, 4);
+	return _mm256_fmadd_ps(fraction, _mm256_sub_ps(b, a), a);
+}
+
+LL_AVX2_FUNC void ll_skin_avx2(LLSkinningData& data)
+{
+	// Joint matrices with the pivots applied, 16 floats apart.  One extra
+	// entry, read (with no weight) by vertices bound to the last joint.
+	LLMatrix4 joint_mat[LL_MAX_SKIN_JOINT_ENTRIES + 1];
+	for (S32 j = 0; j < data.mNumJoints; ++j)
+	{
+		joint_mat[j] = *data.mWorldMatrices[j];
+		joint_mat[j].translate(data.mPivots[j] * joint_mat[j].getMat3());
+	}
+	if (data.mNumJoints > 0)
+	{
+		joint_mat[data.mNumJoints] = joint_mat[data.mNumJoints - 1];
+	}
+	const F32* table = joint_mat[0].mMatrix[0];
+
+	// The blend matrix for each lane, row major, translation last.
+	// Neighbouring vertices mostly share a weight, so when a block does
+	// the matrix is blended once and broadcast, and kept for the next block.
+	__m256 m[12];
+	F32 block_weight = F32_MAX;
+
+	F32 pad_weights[SKIN_BLOCK_SIZE];
+	LLVector3 pad_coords[SKIN_BLOCK_SIZE];
+	LLVector3 pad_normals[SKIN_BLOCK_SIZE];
+
+	for (U32 index = 0; index < data.mNumVertices; index += SKIN_BLOCK_SIZE)
+	{
+		const U32 count = llmin(data.mNumVertices - index, SKIN_BLOCK_SIZE);
+		const F32* weights = data.mWeights + index;
+		const LLVector3* coords = data.mCoords + index;
+		const LLVector3* normals = data.mNormals + index;
+		if (count < SKIN_BLOCK_SIZE)
+		{
+			// Fill the rest of the last block with copies of its last vertex
+			for (U32 i = 0; i < SKIN_BLOCK_SIZE; ++i)
+			{
+				U32 src = llmin(i, count - 1);
+				pad_weights[i] = weights[src];
+				pad_coords[i] = coords[src];
+				pad_normals[i] = normals[src];
+			}
+			weights = pad_weights;
+			coords = pad_coords;
+			normals = pad_normals;
+		}
+
+		__m256 w = _mm256_loadu_ps(weights);
+		if (_mm256_movemask_ps(_mm256_cmp_ps(w, _mm256_set1_ps(weights[0]), _CMP_EQ_OQ)) == 0xff)
+		{
+			if (weights[0] != block_weight)
+			{
+				block_weight = weights[0];
+				S32 joint = llfloor(block_weight);
+				F32 fraction = block_weight - joint;
+				const LLMatrix4& m0 = joint_mat[joint];
+				const LLMatrix4& m1 = joint_mat[joint + 1];
+				for (S32 row = 0; row < 4; ++row)
+				{
+					for (S32 col = 0; col < 3; ++col)
+					{
+						m[row * 3 + col] = _mm256_set1_ps(lerp(m0.mMatrix[row][col], m1.mMatrix[row][col], fraction));
+					}
+				}
+			}
+		}
+		else
+		{
+			block_weight = F32_MAX;
+			__m256 joints = _mm256_floor_ps(w);
+			__m256 fraction = _mm256_sub_ps(w, joints);
+			if (_mm256_movemask_ps(_mm256_cmp_ps(joints, _mm256_set1_ps(floorf(weights[0])), _CMP_EQ_OQ)) == 0xff)
+			{
+				// Same pair of joints, only the fractions differ
+				const LLMatrix4& m0 = joint_mat[llfloor(weights[0])];
+				const LLMatrix4& m1 = (&m0)[1];
+				for (S32 row = 0; row < 4; ++row)
+				{
+					for (S32 col = 0; col < 3; ++col)
+					{
+						__m256 a = _mm256_broadcast_ss(&m0.mMatrix[row][col]);
+						__m256 b = _mm256_broadcast_ss(&m1.mMatrix[row][col]);
+						m[row * 3 + col] = _mm256_fmadd_ps(fraction, _mm256_sub_ps(b, a), a);
+					}
+				}
+			}
+			else
+			{
+				__m256i joint_offsets = _mm256_slli_epi32(_mm256_cvttps_epi32(joints), 4);
+				for (S32 row = 0; row < 4; ++row)
+				{
+					for (S32 col = 0; col < 3; ++col)
+					{
+						m[row * 3 + col] = blend_element(table, row * 4 + col, joint_offsets, fraction);
+					}
+				}
+			}
+		}
+
+		__m256 x, y, z;
+		load_block(coords[0].mV, x, y, z);
+		__m256 vx = _mm256_fmadd_ps(x, m[0], _mm256_fmadd_ps(y, m[3], _mm256_fmadd_ps(z, m[6], m[9])));
+		__m256 vy = _mm256_fmadd_ps(x, m[1], _mm256_fmadd_ps(y, m[4], _mm256_fmadd_ps(z, m[7], m[10])));
+		__m256 vz = _mm256_fmadd_ps(x, m[2], _mm256_fmadd_ps(y, m[5], _mm256_fmadd_ps(z, m[8], m[11])));
+		write_block(data.mOutVertices, index, count, vx, vy, vz);
+
+		load_block(normals[0].mV, x, y, z);
+		vx = _mm256_fmadd_ps(x, m[0], _mm256_fmadd_ps(y, m[3], _mm256_mul_ps(z, m[6])));
+		vy = _mm256_fmadd_ps(x, m[1], _mm256_fmadd_ps(y, m[4], _mm256_mul_ps(z, m[7])));
+		vz = _mm256_fmadd_ps(x, m[2], _mm256_fmadd_ps(y, m[5], _mm256_mul_ps(z, m[8])));
+		write_block(data.mOutNormals, index, count, vx, vy, vz);
+	}
+}
+
+#else
+
+void ll_skin_avx2(LLSkinningData& data)
+{
+	ll_skin_sse2(data);
+}
+
+#endif
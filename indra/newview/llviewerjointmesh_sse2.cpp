@@ -37,15 +37,9 @@
 
 #include "llviewerprecompiledheaders.h"
 
-#include "llviewerjointmesh.h"
-
-// project includes
-#include "llface.h"
-#include "llpolymesh.h"
+#include "llviewerskinning.h"
 
 // library includes
-#include "lldarray.h"
-#include "llstrider.h"
 #include "llv4math.h"		// for LL_VECTORIZE
 #include "llv4matrix3.h"
 #include "llv4matrix4.h"
@@ -67,55 +61,46 @@ inline void matrix_translate(LLV4Matrix4& m, const LLMatrix4* w, const LLVector3
 	m.mV[VW] = _mm_add_ps(m.mV[VW], _mm_mul_ps(_mm_set1_ps(j.mV[VZ]), m.mV[VZ]));
 }
 
-// static
-void LLViewerJointMesh::updateGeometrySSE2(LLFace *face, LLPolyMesh *mesh)
+void ll_skin_sse2(LLSkinningData& data)
 {
-	// This cannot be a file-level static because it will be initialized
-	// before main() using SSE code, which will crash on non-SSE processors.
-	static LLV4Matrix4	sJointMat[32];
-	LLDynamicArray<LLJointRenderData*>& joint_data = mesh->getReferenceMesh()->mJointRenderData;
+	// One extra entry, read (with no weight) by vertices bound to the last joint
+	LLV4Matrix4			joint_mat[LL_MAX_SKIN_JOINT_ENTRIES + 1];
 
 	//upload joint pivots/matrices
-	for(S32 j = 0, jend = joint_data.count(); j < jend ; ++j )
+	for (S32 j = 0; j < data.mNumJoints; ++j)
+	{
+		matrix_translate(joint_mat[j], data.mWorldMatrices[j], data.mPivots[j]);
+	}
+	if (data.mNumJoints > 0)
 	{
-		matrix_translate(sJointMat[j], joint_data[j]->mWorldMatrix,
-			joint_data[j]->mSkinJoint ?
-				joint_data[j]->mSkinJoint->mRootToJointSkinOffset
-				: joint_data[j+1]->mSkinJoint->mRootToParentJointSkinOffset);
+		joint_mat[data.mNumJoints] = joint_mat[data.mNumJoints - 1];
 	}
 
 	F32					weight		= F32_MAX;
 	LLV4Matrix4			blend_mat;
 
-	LLStrider<LLVector3> o_vertices;
-	LLStrider<LLVector3> o_normals;
-
-	LLVertexBuffer *buffer = face->mVertexBuffer;
-	buffer->getVertexStrider(o_vertices,  mesh->mFaceVertexOffset);
-	buffer->getNormalStrider(o_normals,   mesh->mFaceVertexOffset);
-
-	const F32*			weights			= mesh->getWeights();
-	const LLVector3*	coords			= mesh->getCoords();
-	const LLVector3*	normals			= mesh->getNormals();
-	for (U32 index = 0, index_end = mesh->getNumVertices(); index < index_end; ++index)
+	const F32*			weights			= data.mWeights;
+	const LLVector3*	coords			= data.mCoords;
+	const LLVector3*	normals			= data.mNormals;
+	LLStrider<LLVector3>& o_vertices	= data.mOutVertices;
+	LLStrider<LLVector3>& o_normals		= data.mOutNormals;
+	for (U32 index = 0, index_end = data.mNumVertices; index < index_end; ++index)
 	{
 		if( weight != weights[index])
 		{
 			S32 joint = llfloor(weight = weights[index]);
-			blend_mat.lerp(sJointMat[joint], sJointMat[joint+1], weight - joint);
+			blend_mat.lerp(joint_mat[joint], joint_mat[joint+1], weight - joint);
 		}
 		blend_mat.multiply(coords[index], o_vertices[index]);
 		((LLV4Matrix3)blend_mat).multiply(normals[index], o_normals[index]);
 	}
-	
-	//setBuffer(0) called in LLVOAvatar::renderSkinned
 }
 
 #else
 
-void LLViewerJointMesh::updateGeometrySSE2(LLFace *face, LLPolyMesh *mesh)
+void ll_skin_sse2(LLSkinningData& data)
 {
-	LLViewerJointMesh::updateGeometryVectorized(face, mesh);
+	ll_skin_vectorized(data);
 }
 
 #endif
@@ -32,10 +32,8 @@
 //-----------------------------------------------------------------------------
 #include "llviewerprecompiledheaders.h"
 
-#include "llviewerjointmesh.h"
+#include "llviewerskinning.h"
 
-#include "llface.h"
-#include "llpolymesh.h"
 #include "llv4math.h"
 #include "llv4matrix3.h"
 #include "llv4matrix4.h"
@@ -43,53 +41,39 @@
 // Generic vectorized code, uses compiler defaults, works well for Altivec
 // on PowerPC.
 
-// static
-void LLViewerJointMesh::updateGeometryVectorized(LLFace *face, LLPolyMesh *mesh)
+void ll_skin_vectorized(LLSkinningData& data)
 {
-	static LLV4Matrix4	sJointMat[32];
-	LLDynamicArray<LLJointRenderData*>& joint_data = mesh->getReferenceMesh()->mJointRenderData;
-	S32 j, joint_num, joint_end = joint_data.count();
-	LLV4Vector3 pivot;
+	// One extra entry, read (with no weight) by vertices bound to the last joint
+	LLV4Matrix4			joint_mat[LL_MAX_SKIN_JOINT_ENTRIES + 1];
+	LLV4Vector3			pivot;
 
 	//upload joint pivots/matrices
-	for(j = joint_num = 0; joint_num < joint_end ; ++joint_num )
+	for (S32 j = 0; j < data.mNumJoints; ++j)
 	{
-		LLSkinJoint *sj;
-		const LLMatrix4 *	wm = joint_data[joint_num]->mWorldMatrix;
-		if (NULL == (sj = joint_data[joint_num]->mSkinJoint))
-		{
-				sj = joint_data[++joint_num]->mSkinJoint;
-				((LLV4Matrix3)(sJointMat[j] = *wm)).multiply(sj->mRootToParentJointSkinOffset, pivot);
-				sJointMat[j++].translate(pivot);
-				wm = joint_data[joint_num]->mWorldMatrix;
-		}
-		((LLV4Matrix3)(sJointMat[j] = *wm)).multiply(sj->mRootToJointSkinOffset, pivot);
-		sJointMat[j++].translate(pivot);
+		((LLV4Matrix3)(joint_mat[j] = *data.mWorldMatrices[j])).multiply(data.mPivots[j], pivot);
+		joint_mat[j].translate(pivot);
+	}
+	if (data.mNumJoints > 0)
+	{
+		joint_mat[data.mNumJoints] = joint_mat[data.mNumJoints - 1];
 	}
 
 	F32					weight		= F32_MAX;
 	LLV4Matrix4			blend_mat;
 
-	LLStrider<LLVector3> o_vertices;
-	LLStrider<LLVector3> o_normals;
-
-	LLVertexBuffer *buffer = face->mVertexBuffer;
-	buffer->getVertexStrider(o_vertices,  mesh->mFaceVertexOffset);
-	buffer->getNormalStrider(o_normals,   mesh->mFaceVertexOffset);
-
-	const F32*			weights			= mesh->getWeights();
-	const LLVector3*	coords			= mesh->getCoords();
-	const LLVector3*	normals			= mesh->getNormals();
-	for (U32 index = 0, index_end = mesh->getNumVertices(); index < index_end; ++index)
+	const F32*			weights			= data.mWeights;
+	const LLVector3*	coords			= data.mCoords;
+	const LLVector3*	normals			= data.mNormals;
+	LLStrider<LLVector3>& o_vertices	= data.mOutVertices;
+	LLStrider<LLVector3>& o_normals		= data.mOutNormals;
+	for (U32 index = 0, index_end = data.mNumVertices; index < index_end; ++index)
 	{
 		if( weight != weights[index])
 		{
 			S32 joint = llfloor(weight = weights[index]);
-			blend_mat.lerp(sJointMat[joint], sJointMat[joint+1], weight - joint);
+			blend_mat.lerp(joint_mat[joint], joint_mat[joint+1], weight - joint);
 		}
 		blend_mat.multiply(coords[index], o_vertices[index]);
 		((LLV4Matrix3)blend_mat).multiply(normals[index], o_normals[index]);
 	}
-
-	buffer->setBuffer(0);
 }
@@ -742,6 +742,7 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 				objectp->idleUpdate(agent, world, frame_time);
 			}
 		}
+		LLVOAvatar::finishIdleUpdates();
 	}
 	else
 	{
@@ -759,6 +760,7 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 				num_active_objects++;
 			}
 		}
+		LLVOAvatar::finishIdleUpdates();
 		for (std::vector<LLViewerObject*>::iterator kill_iter = kill_list.begin();
 			kill_iter != kill_list.end(); kill_iter++)
 		{
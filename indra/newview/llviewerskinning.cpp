@@ -0,0 +1,132 @@
+/**
+ * @file llviewerskinning.cpp
+ * @brief Software avatar skinning, plain C++ version.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llviewerskinning.h"
+
+#include "m3math.h"
+
+void ll_skin_original(LLSkinningData& data)
+{
+	// One extra entry, read (with no weight) by vertices bound to the last joint
+	LLMatrix4 joint_mat[LL_MAX_SKIN_JOINT_ENTRIES + 1];
+	LLMatrix3 joint_rot[LL_MAX_SKIN_JOINT_ENTRIES + 1];
+
+	//add pivot point into transform
+	for (S32 j = 0; j < data.mNumJoints; j++)
+	{
+		joint_mat[j] = *data.mWorldMatrices[j];
+		joint_rot[j] = joint_mat[j].getMat3();
+		joint_mat[j].translate(data.mPivots[j] * joint_rot[j]);
+	}
+	if (data.mNumJoints > 0)
+	{
+		joint_mat[data.mNumJoints] = joint_mat[data.mNumJoints - 1];
+		joint_rot[data.mNumJoints] = joint_rot[data.mNumJoints - 1];
+	}
+
+	F32 last_weight = F32_MAX;
+	LLMatrix4 gBlendMat;
+	LLMatrix3 gBlendRotMat;
+
+	const F32* weights = data.mWeights;
+	const LLVector3* coords = data.mCoords;
+	const LLVector3* normals = data.mNormals;
+	LLStrider<LLVector3>& o_vertices = data.mOutVertices;
+	LLStrider<LLVector3>& o_normals = data.mOutNormals;
+	for (U32 index = 0; index < data.mNumVertices; index++)
+	{
+		// blend by first matrix
+		F32 w = weights[index];
+
+		// Maybe we don't have to change gBlendMat.
+		// Profiles of a single-avatar scene on a Mac show this to be a very
+		// common case.  JC
+		if (w == last_weight)
+		{
+			o_vertices[index] = coords[index] * gBlendMat;
+			o_normals[index] = normals[index] * gBlendRotMat;
+			continue;
+		}
+
+		last_weight = w;
+
+		S32 joint = llfloor(w);
+		w -= joint;
+
+		// No lerp required in this case.
+		if (w == 1.0f)
+		{
+			gBlendMat = joint_mat[joint+1];
+			o_vertices[index] = coords[index] * gBlendMat;
+			gBlendRotMat = joint_rot[joint+1];
+			o_normals[index] = normals[index] * gBlendRotMat;
+			continue;
+		}
+
+		// Try to keep all the accesses to the matrix data as close
+		// together as possible.  This function is a hot spot on the
+		// Mac. JC
+		LLMatrix4 &m0 = joint_mat[joint+1];
+		LLMatrix4 &m1 = joint_mat[joint+0];
+
+		gBlendMat.mMatrix[VX][VX] = lerp(m1.mMatrix[VX][VX], m0.mMatrix[VX][VX], w);
+		gBlendMat.mMatrix[VX][VY] = lerp(m1.mMatrix[VX][VY], m0.mMatrix[VX][VY], w);
+		gBlendMat.mMatrix[VX][VZ] = lerp(m1.mMatrix[VX][VZ], m0.mMatrix[VX][VZ], w);
+
+		gBlendMat.mMatrix[VY][VX] = lerp(m1.mMatrix[VY][VX], m0.mMatrix[VY][VX], w);
+		gBlendMat.mMatrix[VY][VY] = lerp(m1.mMatrix[VY][VY], m0.mMatrix[VY][VY], w);
+		gBlendMat.mMatrix[VY][VZ] = lerp(m1.mMatrix[VY][VZ], m0.mMatrix[VY][VZ], w);
+
+		gBlendMat.mMatrix[VZ][VX] = lerp(m1.mMatrix[VZ][VX], m0.mMatrix[VZ][VX], w);
+		gBlendMat.mMatrix[VZ][VY] = lerp(m1.mMatrix[VZ][VY], m0.mMatrix[VZ][VY], w);
+		gBlendMat.mMatrix[VZ][VZ] = lerp(m1.mMatrix[VZ][VZ], m0.mMatrix[VZ][VZ], w);
+
+		gBlendMat.mMatrix[VW][VX] = lerp(m1.mMatrix[VW][VX], m0.mMatrix[VW][VX], w);
+		gBlendMat.mMatrix[VW][VY] = lerp(m1.mMatrix[VW][VY], m0.mMatrix[VW][VY], w);
+		gBlendMat.mMatrix[VW][VZ] = lerp(m1.mMatrix[VW][VZ], m0.mMatrix[VW][VZ], w);
+
+		o_vertices[index] = coords[index] * gBlendMat;
+
+		LLMatrix3 &n0 = joint_rot[joint+1];
+		LLMatrix3 &n1 = joint_rot[joint+0];
+
+		gBlendRotMat.mMatrix[VX][VX] = lerp(n1.mMatrix[VX][VX], n0.mMatrix[VX][VX], w);
+		gBlendRotMat.mMatrix[VX][VY] = lerp(n1.mMatrix[VX][VY], n0.mMatrix[VX][VY], w);
+		gBlendRotMat.mMatrix[VX][VZ] = lerp(n1.mMatrix[VX][VZ], n0.mMatrix[VX][VZ], w);
+
+		gBlendRotMat.mMatrix[VY][VX] = lerp(n1.mMatrix[VY][VX], n0.mMatrix[VY][VX], w);
+		gBlendRotMat.mMatrix[VY][VY] = lerp(n1.mMatrix[VY][VY], n0.mMatrix[VY][VY], w);
+		gBlendRotMat.mMatrix[VY][VZ] = lerp(n1.mMatrix[VY][VZ], n0.mMatrix[VY][VZ], w);
+
+		gBlendRotMat.mMatrix[VZ][VX] = lerp(n1.mMatrix[VZ][VX], n0.mMatrix[VZ][VX], w);
+		gBlendRotMat.mMatrix[VZ][VY] = lerp(n1.mMatrix[VZ][VY], n0.mMatrix[VZ][VY], w);
+		gBlendRotMat.mMatrix[VZ][VZ] = lerp(n1.mMatrix[VZ][VZ], n0.mMatrix[VZ][VZ], w);
+
+		o_normals[index] = normals[index] * gBlendRotMat;
+	}
+}
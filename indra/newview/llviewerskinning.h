@@ -0,0 +1,82 @@
+/**
+ * @file llviewerskinning.h
+ * @brief Software avatar skinning functions.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVIEWERSKINNING_H
+#define LL_LLVIEWERSKINNING_H
+
+#include "llstrider.h"
+#include "m4math.h"
+#include "v3math.h"
+
+// LLPolyMesh::mJointRenderData never has more entries than this
+const S32 LL_MAX_SKIN_JOINT_ENTRIES = 32;
+
+// What the software skinning functions work on.  LLViewerJointMesh fills
+// this in from its LLFace and LLPolyMesh, which keeps the functions free of
+// both so they can be run and timed outside the viewer
+// (see integration_tests/llskinning_bench).
+struct LLSkinningData
+{
+	LLSkinningData()
+	:	mNumJoints(0),
+		mNumVertices(0),
+		mWeights(NULL),
+		mCoords(NULL),
+		mNormals(NULL)
+	{
+	}
+
+	// One entry per LLPolyMesh::mJointRenderData entry: the joint's world
+	// matrix and the skin offset of its pivot.  Entries without a skin joint
+	// are the parent of the next entry and use its parent skin offset.
+	S32					mNumJoints;
+	const LLMatrix4*	mWorldMatrices[LL_MAX_SKIN_JOINT_ENTRIES];
+	LLVector3			mPivots[LL_MAX_SKIN_JOINT_ENTRIES];
+
+	// A weight is a joint entry index plus the amount of the next entry to
+	// blend in.
+	U32					mNumVertices;
+	const F32*			mWeights;
+	const LLVector3*	mCoords;
+	const LLVector3*	mNormals;
+
+	LLStrider<LLVector3> mOutVertices;
+	LLStrider<LLVector3> mOutNormals;
+};
+
+typedef void (*skinning_func_t)(LLSkinningData& data);
+
+// Each of these needs the compiler options for its instruction set, and so
+// is in its own .cpp file.  All of them give the same results to within
+// rounding.  The SIMD versions fall back to the next simpler one when they
+// aren't built, so only the CPU needs checking before calling them.
+void ll_skin_original(LLSkinningData& data);	// llviewerskinning.cpp
+void ll_skin_vectorized(LLSkinningData& data);	// llviewerjointmesh_vec.cpp, used for Altivec
+void ll_skin_sse(LLSkinningData& data);			// llviewerjointmesh_sse.cpp
+void ll_skin_sse2(LLSkinningData& data);		// llviewerjointmesh_sse2.cpp
+void ll_skin_avx2(LLSkinningData& data);		// llviewerjointmesh_avx2.cpp, needs AVX2 and FMA
+
+#endif // LL_LLVIEWERSKINNING_H
@@ -46,8 +46,10 @@
 #include "llagentcamera.h"
 #include "llagentwearables.h"
 #include "llanimationstates.h"
+#include "llappviewer.h"
 #include "llavatarnamecache.h"
 #include "llavatarpropertiesprocessor.h"
+#include "llavatarupdatethread.h"
 #include "llviewercontrol.h"
 #include "llcallingcard.h"		// IDEVO for LLAvatarTracker
 #include "lldrawpoolavatar.h"
@@ -628,6 +630,7 @@ F32 LLVOAvatar::sUnbakedUpdateTime = 0.f;
 F32 LLVOAvatar::sGreyTime = 0.f;
 F32 LLVOAvatar::sGreyUpdateTime = 0.f;
 LLSD LLVOAvatar::sClientInfo;
+std::vector<LLPointer<LLVOAvatar> > LLVOAvatar::sQueuedAvatars;
 //-----------------------------------------------------------------------------
 // Helper functions
 //-----------------------------------------------------------------------------
@@ -740,6 +743,11 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mTimeLast = 0.0f;
 	mSpeedAccum = 0.0f;
 
+	mAnimationQueued = FALSE;
+	mDeferVisualParamUpdates = FALSE;
+	mVisualParamsDirty = FALSE;
+	mAnimationUpdateType = LLCharacter::NORMAL_UPDATE;
+
 	mRippleTimeLast = 0.f;
 
 	mInAir = FALSE;
@@ -2333,11 +2341,24 @@ BOOL LLVOAvatar::idleUpdate(LLAgent &agent, LLWorld &world, const F64 &time)
 	LLVector3 root_pos_last = mRoot.getWorldPosition();
 	BOOL detailed_update = updateCharacter(agent);
 
-	if (gNoRender)
+	if (mAnimationQueued)
 	{
+		// the rest waits for finishIdleUpdates()
+		mQueuedRootPosLast = root_pos_last;
 		return TRUE;
 	}
 
+	finishIdleUpdate(detailed_update, root_pos_last);
+	return TRUE;
+}
+
+void LLVOAvatar::finishIdleUpdate(BOOL detailed_update, const LLVector3& root_pos_last)
+{
+	if (gNoRender)
+	{
+		return;
+	}
+
 	static LLUICachedControl<bool> visualizers_in_calls("ShowVoiceVisualizersInCalls", false);
 	bool voice_enabled = (visualizers_in_calls || LLVoiceClient::getInstance()->inProximalChannel()) &&
 						 LLVoiceClient::getInstance()->getVoiceEnabled(mID);
@@ -2355,7 +2376,74 @@ BOOL LLVOAvatar::idleUpdate(LLAgent &agent, LLWorld &world, const F64 &time)
 	
 	idleUpdateNameTag( root_pos_last );
 	idleUpdateRenderCost();
+}
+
+static LLFastTimer::DeclareTimer FTM_AVATAR_ANIMATION_JOBS("Avatar Animation Jobs");
+
+//static
+void LLVOAvatar::finishIdleUpdates()
+{
+	if (sQueuedAvatars.empty())
+	{
+		return;
+	}
+
+	LLAvatarUpdateThread::avatar_list_t avatars;
+	avatars.reserve(sQueuedAvatars.size());
+	for (std::vector<LLPointer<LLVOAvatar> >::iterator iter = sQueuedAvatars.begin();
+		 iter != sQueuedAvatars.end(); ++iter)
+	{
+		LLVOAvatar* avatarp = *iter;
+		if (!avatarp->isDead())
+		{
+			avatars.push_back(avatarp);
+		}
+	}
+
+	{
+		LLFastTimer t(FTM_AVATAR_ANIMATION_JOBS);
+		LLAppViewer::getAvatarUpdateThread()->updateAvatars(avatars);
+	}
+
+	for (std::vector<LLPointer<LLVOAvatar> >::iterator iter = sQueuedAvatars.begin();
+		 iter != sQueuedAvatars.end(); ++iter)
+	{
+		LLVOAvatar* avatarp = *iter;
+		avatarp->mAnimationQueued = FALSE;
+		if (!avatarp->isDead())
+		{
+			LLFastTimer t(FTM_AVATAR_UPDATE);
+			BOOL detailed_update = avatarp->finishCharacterUpdate();
+			avatarp->finishIdleUpdate(detailed_update, avatarp->mQueuedRootPosLast);
+		}
+	}
+	sQueuedAvatars.clear();
+}
+
+// Runs on a worker thread.  Motions move this avatar's joints and set its
+// visual param weights; applying the params reaches the mesh and the
+// global avatar state, so that waits for finishCharacterUpdate().
+void LLVOAvatar::evaluateAnimation()
+{
+	mDeferVisualParamUpdates = TRUE;
+	evaluateMotions(mAnimationUpdateType);
+	mDeferVisualParamUpdates = FALSE;
+	mRoot.updateWorldMatrixChildren();
+}
 
+// Self is left on the main thread since its motions talk to the agent and
+// the UI.  An avatar sitting on an attachment follows the joints of the
+// wearer, which may be moving at the same time on another thread.
+BOOL LLVOAvatar::canAnimateOffThread()
+{
+	if (isSelf() || mIsDummy || !LLAppViewer::getAvatarUpdateThread())
+	{
+		return FALSE;
+	}
+	if (mIsSitting && getParent() && ((LLViewerObject*)getRoot())->isAttachment())
+	{
+		return FALSE;
+	}
 	return TRUE;
 }
 
@@ -3635,10 +3723,39 @@ BOOL LLVOAvatar::updateCharacter(LLAgent &agent)
 	mSpeed = speed;
 
 	// update animations
+	LLCharacter::e_update_t update_type = LLCharacter::NORMAL_UPDATE;
 	if (mSpecialRenderMode == 1) // Animation Preview
-		updateMotions(LLCharacter::FORCE_UPDATE);
+		update_type = LLCharacter::FORCE_UPDATE;
+
+	if (canAnimateOffThread())
+	{
+		if (prepareMotions())
+		{
+			// evaluated with the others in finishIdleUpdates()
+			mAnimationUpdateType = update_type;
+			mAnimationQueued = TRUE;
+			sQueuedAvatars.push_back(this);
+			return TRUE;
+		}
+	}
 	else
-		updateMotions(LLCharacter::NORMAL_UPDATE);
+	{
+		updateMotions(update_type);
+	}
+
+	return finishCharacterUpdate();
+}
+
+BOOL LLVOAvatar::finishCharacterUpdate()
+{
+	LLVector3 normal;
+
+	if (mVisualParamsDirty)
+	{
+		// requested by a motion in evaluateAnimation()
+		mVisualParamsDirty = FALSE;
+		updateVisualParams();
+	}
 
 	// update head position
 	updateHeadOffset();
@@ -5482,6 +5599,12 @@ void LLVOAvatar::updateVisualParams()
 		return;
 	}
 
+	if (mDeferVisualParamUpdates)
+	{
+		mVisualParamsDirty = TRUE;
+		return;
+	}
+
 	setSex( (getVisualParamWeight( "male" ) > 0.5f) ? SEX_MALE : SEX_FEMALE );
 
 	LLCharacter::updateVisualParams();
@@ -204,6 +204,25 @@ private:
 	//--------------------------------------------------------------------
 public:
 	virtual BOOL 	updateCharacter(LLAgent &agent);
+	// With an avatar update thread, idleUpdate() stops at the animation step
+	// for avatars whose motions can be evaluated off the main thread.
+	// finishIdleUpdates() evaluates all of them in parallel, then finishes
+	// their idle updates.  Call it every frame after the idleUpdate() pass.
+	static void		finishIdleUpdates();
+	void			evaluateAnimation(); // may run on a worker thread
+private:
+	BOOL			canAnimateOffThread();
+	BOOL			finishCharacterUpdate();
+	void			finishIdleUpdate(BOOL detailed_update, const LLVector3& root_pos_last);
+	BOOL			mAnimationQueued;
+	// While evaluateAnimation() runs, updateVisualParams() only sets
+	// mVisualParamsDirty and finishCharacterUpdate() applies them
+	BOOL			mDeferVisualParamUpdates;
+	BOOL			mVisualParamsDirty;
+	LLCharacter::e_update_t mAnimationUpdateType;
+	LLVector3		mQueuedRootPosLast;
+	static std::vector<LLPointer<LLVOAvatar> > sQueuedAvatars;
+public:
 	void 			idleUpdateVoiceVisualizer(bool voice_enabled);
 	void 			idleUpdateMisc(bool detailed_update);
 	virtual void	idleUpdateAppearanceAnimation();
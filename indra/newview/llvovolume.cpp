@@ -77,6 +77,7 @@ F32 LLVOVolume::sLODFactor = 1.f;
 F32	LLVOVolume::sLODSlopDistanceFactor = 0.5f; //Changing this to zero, effectively disables the LOD transition slop 
 F32 LLVOVolume::sDistanceFactor = 1.0f;
 S32 LLVOVolume::sNumLODChanges = 0;
+std::vector<LLPointer<LLVOVolume> > LLVOVolume::sPendingVolumeBuilds;
 LLPointer<LLObjectMediaDataClient> LLVOVolume::sObjectMediaClient = NULL;
 LLPointer<LLObjectMediaNavigateClient> LLVOVolume::sObjectMediaNavigateClient = NULL;
 
@@ -200,6 +201,7 @@ LLVOVolume::LLVOVolume(const LLUUID &id, const LLPCode pcode, LLViewerRegion *re
 	mNumFaces = 0;
 	mLODChanged = FALSE;
 	mSculptChanged = FALSE;
+	mVolumeBuildPending = FALSE;
 	mSpotLightPriority = 0.f;
 
 	mMediaImplList.resize(getNumTEs());
@@ -277,6 +279,7 @@ void LLVOVolume::cleanupClass()
 {
     sObjectMediaClient = NULL;
     sObjectMediaNavigateClient = NULL;
+	sPendingVolumeBuilds.clear();
 }
 
 U32 LLVOVolume::processUpdateMessage(LLMessageSystem *mesgsys,
@@ -790,7 +793,8 @@ void LLVOVolume::updateTextureVirtualSize()
 			S32 texture_discard = mSculptTexture->getDiscardLevel(); //try to match the texture
 			S32 current_discard = getVolume() ? getVolume()->getSculptLevel() : -2 ;
 
-			if (texture_discard >= 0 && //texture has some data available
+			if (!mVolumeBuildPending && //not waiting for the build thread
+				texture_discard >= 0 && //texture has some data available
 				(texture_discard < current_discard || //texture has more data than last rebuild
 				current_discard < 0)) //no previous rebuild
 			{
@@ -945,7 +949,22 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &volume_params, const S32 detail
 		}
 	}
 	
-	if ((LLPrimitive::setVolume(volume_params, mLOD, (mVolumeImpl && mVolumeImpl->isVolumeUnique()))) || mSculptChanged)
+	bool unique = mVolumeImpl && mVolumeImpl->isVolumeUnique();
+	S32 lod = unique ? mLOD : getAvailableLOD(volume_params);
+	BOOL changed = LLPrimitive::setVolume(volume_params, lod, unique);
+	if (lod != mLOD)
+	{
+		// Built from the LOD group the line above may just have made
+		getVolumeManager()->requestVolume(volume_params, mLOD, getVolumeBuildPriority());
+		addPendingVolumeBuild();
+	}
+	else if (isSculpted() && getVolumeManager()->isSculptPending(getVolume()))
+	{
+		// Read from the volume cache
+		addPendingVolumeBuild();
+	}
+
+	if (changed || mSculptChanged)
 	{
 		mFaceMappingChanged = TRUE;
 		
@@ -1040,6 +1059,12 @@ void LLVOVolume::sculpt()
 
 		if (current_discard == discard_level)  // no work to do here
 			return;
+
+		if (current_discard >= 0 && (discard_level < 0 || discard_level > current_discard))
+		{
+			// Already sculpted from better data, e.g. out of the volume cache
+			return;
+		}
 		
 		if(!raw_image)
 		{
@@ -1067,16 +1092,160 @@ void LLVOVolume::sculpt()
 				mSculptTexture->updateBindStatsForTester() ;
 			}
 		}
-		getVolume()->sculpt(sculpt_width, sculpt_height, sculpt_components, sculpt_data, discard_level);
 
-		//notify rebuild any other VOVolumes that reference this sculpty volume
-		for (S32 i = 0; i < mSculptTexture->getNumVolumes(); ++i)
+		LLVolumeMgr* volume_mgr = getVolumeManager();
+		if (volume_mgr->isCacheReadPending(getVolume()))
+		{
+			// Back here once the volume cache had its say
+			addPendingVolumeBuild();
+			return;
+		}
+		if (sculpt_data && volume_mgr->getBuildThread())
 		{
-			LLVOVolume* volume = (*(mSculptTexture->getVolumeList()))[i];
-			if (volume != this && volume->getVolume() == getVolume())
+			if (current_discard == -2)
 			{
-				gPipeline.markRebuild(volume->mDrawable, LLDrawable::REBUILD_GEOMETRY, FALSE);
+				// Show the placeholder until the sculpt is built
+				getVolume()->sculpt(0, 0, 0, NULL, -1);
+				markSharedSculptRebuild();
 			}
+			volume_mgr->requestSculpt(getVolume(), sculpt_width, sculpt_height, sculpt_components, sculpt_data,
+									  discard_level, getVolumeBuildPriority());
+			addPendingVolumeBuild();
+			return;
+		}
+
+		if (sculpt_data)
+		{
+			// Sculpts on the spot unless the volume cache has it
+			volume_mgr->requestSculpt(getVolume(), sculpt_width, sculpt_height, sculpt_components, sculpt_data,
+									  discard_level, getVolumeBuildPriority());
+		}
+		else
+		{
+			getVolume()->sculpt(sculpt_width, sculpt_height, sculpt_components, sculpt_data, discard_level);
+		}
+		markSharedSculptRebuild();
+	}
+}
+
+//notify rebuild any other VOVolumes that reference this sculpty volume
+void LLVOVolume::markSharedSculptRebuild()
+{
+	if (mSculptTexture.isNull())
+	{
+		return;
+	}
+	for (S32 i = 0; i < mSculptTexture->getNumVolumes(); ++i)
+	{
+		LLVOVolume* volume = (*(mSculptTexture->getVolumeList()))[i];
+		if (volume != this && volume->getVolume() == getVolume())
+		{
+			gPipeline.markRebuild(volume->mDrawable, LLDrawable::REBUILD_GEOMETRY, FALSE);
+		}
+	}
+}
+
+S32 LLVOVolume::getAvailableLOD(const LLVolumeParams& volume_params)
+{
+	LLVolumeMgr* volume_mgr = getVolumeManager();
+	if (mLOD == 0 || !volume_mgr->getBuildThread() ||
+		volume_mgr->requestVolume(volume_params, mLOD, getVolumeBuildPriority()))
+	{
+		return mLOD;
+	}
+
+	// Keep the LOD we have if the shape did not change
+	LLVolume* volume = getVolume();
+	if (volume && volume->getParams() == volume_params)
+	{
+		for (S32 lod = 0; lod < LLVolumeLODGroup::NUM_LODS; ++lod)
+		{
+			if (LLVolumeLODGroup::getVolumeScaleFromDetail(lod) == volume->getDetail())
+			{
+				return lod;
+			}
+		}
+	}
+
+	// The lowest LOD is cheap enough to build on the spot
+	return 0;
+}
+
+U32 LLVOVolume::getVolumeBuildPriority() const
+{
+	// Bigger on screen first
+	return LLQueuedThread::PRIORITY_NORMAL +
+		llclamp((U32)getPixelArea(), (U32)0, (U32)LLQueuedThread::PRIORITY_LOWBITS);
+}
+
+BOOL LLVOVolume::isVolumeBuildPending()
+{
+	LLVolume* volume = getVolume();
+	if (!volume)
+	{
+		return FALSE;
+	}
+	LLVolumeMgr* volume_mgr = getVolumeManager();
+	if (volume_mgr->isSculptPending(volume))
+	{
+		return TRUE;
+	}
+	return !isSculpted() &&
+		volume->getDetail() != LLVolumeLODGroup::getVolumeScaleFromDetail(mLOD) &&
+		!volume_mgr->requestVolume(volume->getParams(), mLOD, getVolumeBuildPriority());
+}
+
+void LLVOVolume::addPendingVolumeBuild()
+{
+	if (!mVolumeBuildPending)
+	{
+		mVolumeBuildPending = TRUE;
+		sPendingVolumeBuilds.push_back(this);
+	}
+}
+
+void LLVOVolume::finishVolumeBuild()
+{
+	if (isSculpted())
+	{
+		mSculptChanged = TRUE;
+		markSharedSculptRebuild();
+	}
+	else
+	{
+		mLODChanged = TRUE;
+	}
+	gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_VOLUME, FALSE);
+}
+
+//static
+void LLVOVolume::updateVolumeBuilds()
+{
+	LLVolumeMgr* volume_mgr = getVolumeManager();
+	// Also writes the volume cache files without a build thread
+	if (volume_mgr->updateBuilds() == 0)
+	{
+		return;
+	}
+
+	std::vector<LLPointer<LLVOVolume> > pending;
+	pending.swap(sPendingVolumeBuilds);
+	for (std::vector<LLPointer<LLVOVolume> >::iterator iter = pending.begin();
+		 iter != pending.end(); ++iter)
+	{
+		LLVOVolume* vobj = *iter;
+		vobj->mVolumeBuildPending = FALSE;
+		if (vobj->isDead() || vobj->mDrawable.isNull())
+		{
+			continue;
+		}
+		if (vobj->isVolumeBuildPending())
+		{
+			vobj->addPendingVolumeBuild();
+		}
+		else
+		{
+			vobj->finishVolumeBuild();
 		}
 	}
 }
@@ -2904,6 +3073,7 @@ U32 LLVOVolume::getRenderCost(std::set<LLUUID> &textures) const
 void LLVOVolume::preUpdateGeom()
 {
 	sNumLODChanges = 0;
+	updateVolumeBuilds();
 }
 
 void LLVOVolume::parameterChanged(U16 param_type, bool local_origin)
@@ -81,6 +81,8 @@ public:
 	static		void	initClass();
 	static		void	cleanupClass();
 	static		void	preUpdateGeom();
+	// Rebuilds the objects whose LODs or sculpts the volume build thread finished
+	static		void	updateVolumeBuilds();
 	
 	enum 
 	{
@@ -178,6 +180,7 @@ public:
 				void	updateSculptTexture();
 				void    setIndexInTex(S32 index) { mIndexInTex = index ;}
 				void	sculpt();
+				void	markSharedSculptRebuild();
 				void	updateRelativeXform();
 	/*virtual*/ BOOL	updateGeometry(LLDrawable *drawable);
 	/*virtual*/ void	updateFaceSize(S32 idx);
@@ -283,6 +286,16 @@ protected:
 	void cleanUpMediaImpls();
 	void addMediaImpl(LLViewerMediaImpl* media_impl, S32 texture_index) ;
 	void removeMediaImpl(S32 texture_index) ;
+
+protected:
+	// mLOD, or a LOD of volume_params that is already built while mLOD is
+	// built on the volume build thread
+	S32		getAvailableLOD(const LLVolumeParams& volume_params);
+	U32		getVolumeBuildPriority() const;
+	BOOL	isVolumeBuildPending();
+	void	addPendingVolumeBuild();
+	void	finishVolumeBuild();
+
 public:
 	LLViewerTextureAnim *mTextureAnimp;
 	U8 mTexAnimMode;
@@ -294,6 +307,7 @@ private:
 	S32			mLOD;
 	BOOL		mLODChanged;
 	BOOL		mSculptChanged;
+	BOOL		mVolumeBuildPending;	// in sPendingVolumeBuilds
 	F32			mSpotLightPriority;
 	LLMatrix4	mRelativeXform;
 	LLMatrix3	mRelativeXformInvTrans;
@@ -319,6 +333,7 @@ public:
 
 protected:
 	static S32 sNumLODChanges;
+	static std::vector<LLPointer<LLVOVolume> > sPendingVolumeBuilds;
 	
 	friend class LLVolumeImplFlexible;
 };
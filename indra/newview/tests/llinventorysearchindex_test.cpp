@@ -0,0 +1,300 @@
+/**
+ * @file llinventorysearchindex_test.cpp
+ * @brief LLInventorySearchIndex unit tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llinventorysearchindex.h"
+#include "llformat.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct inventorysearchindex_test
+	{
+		typedef LLInventorySearchIndex::Item Item;
+
+		// The index resets the slots of its items when it goes, so it goes first
+		std::vector<Item> mItems;
+		std::vector<std::string> mLabels;
+		LLInventorySearchIndex mIndex;
+
+		inventorysearchindex_test()
+		{
+			// Items never move once indexed
+			mItems.reserve(1024);
+		}
+
+		Item* addItem(const std::string& label)
+		{
+			mItems.push_back(Item());
+			mLabels.push_back(label);
+			mIndex.setLabel(&mItems.back(), label);
+			return &mItems.back();
+		}
+
+		void setLabel(S32 i, const std::string& label)
+		{
+			mLabels[i] = label;
+			mIndex.setLabel(&mItems[i], label);
+		}
+
+		// What the inventory filter does with a result: an item is only
+		// rejected when its slot was searched and cleared
+		bool mayMatch(S32 i, const LLInventorySearchIndex::match_slots_t& slots) const
+		{
+			const S32 slot = mItems[i].getSearchIndexSlot();
+			return slot < 0 || slot >= (S32)slots.size() || slots[slot];
+		}
+
+		// Every item whose label contains substring must survive slots
+		void ensureNoFalseNegative(const std::string& msg, const std::string& substring,
+								   const LLInventorySearchIndex::match_slots_t& slots) const
+		{
+			for (S32 i = 0; i < (S32)mItems.size(); ++i)
+			{
+				if (mLabels[i].find(substring) != std::string::npos)
+				{
+					ensure(msg + ": " + mLabels[i] + " kept for " + substring, mayMatch(i, slots));
+				}
+			}
+		}
+
+		S32 countMatches(const LLInventorySearchIndex::match_slots_t& slots) const
+		{
+			S32 count = 0;
+			for (S32 i = 0; i < (S32)mItems.size(); ++i)
+			{
+				if (mayMatch(i, slots))
+				{
+					++count;
+				}
+			}
+			return count;
+		}
+	};
+
+	typedef test_group<inventorysearchindex_test> inventorysearchindex_t;
+	typedef inventorysearchindex_t::object inventorysearchindex_object_t;
+	tut::inventorysearchindex_t tut_inventorysearchindex("LLInventorySearchIndex");
+
+	template<> template<>
+	void inventorysearchindex_object_t::test<1>()
+	{
+		// findMatches() keeps the labels holding every trigram of the substring
+		addItem("RED SHIRT");
+		addItem("BLUE SHIRT");
+		addItem("RED PANTS");
+		addItem("SHIRRED");
+
+		LLInventorySearchIndex::match_slots_t slots;
+		ensure("lookup", mIndex.findMatches("SHIRT", slots));
+		ensure_equals("one flag per slot", slots.size(), (size_t)4);
+		ensure("red shirt", mayMatch(0, slots));
+		ensure("blue shirt", mayMatch(1, slots));
+		ensure("red pants", !mayMatch(2, slots));
+		ensure("shirred has SHI and HIR but not IRT", !mayMatch(3, slots));
+
+		slots.clear();
+		ensure("lookup across words", mIndex.findMatches("RED S", slots));
+		ensure_equals("red s", countMatches(slots), 1);
+		ensure("red shirt matches red s", mayMatch(0, slots));
+
+		slots.clear();
+		ensure("missing trigram", mIndex.findMatches("XYZ", slots));
+		ensure_equals("missing trigram size", slots.size(), (size_t)4);
+		ensure_equals("missing trigram matches nothing", countMatches(slots), 0);
+
+		// Every substring of every label is found
+		for (S32 i = 0; i < (S32)mLabels.size(); ++i)
+		{
+			const std::string& label = mLabels[i];
+			for (size_t start = 0; start < label.size(); ++start)
+			{
+				for (size_t length = LLInventorySearchIndex::MIN_SUBSTRING_LENGTH; start + length <= label.size(); ++length)
+				{
+					const std::string substring = label.substr(start, length);
+					slots.clear();
+					ensure("substring lookup", mIndex.findMatches(substring, slots));
+					ensureNoFalseNegative("substring", substring, slots);
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void inventorysearchindex_object_t::test<2>()
+	{
+		// Passing the result for a prefix narrows it as characters are appended
+		addItem("RED SHIRT");
+		addItem("RED PANTS");
+		addItem("REDWOOD");
+		addItem("BLUE SHIRT");
+
+		const std::string typed = "RED PANTS";
+		LLInventorySearchIndex::match_slots_t slots;
+		S32 last_count = (S32)mItems.size();
+		for (size_t length = LLInventorySearchIndex::MIN_SUBSTRING_LENGTH; length <= typed.size(); ++length)
+		{
+			const std::string substring = typed.substr(0, length);
+			ensure("narrowing lookup", mIndex.findMatches(substring, slots));
+			ensureNoFalseNegative("narrowing", substring, slots);
+			const S32 count = countMatches(slots);
+			ensure("never widens", count <= last_count);
+			last_count = count;
+		}
+		ensure_equals("red pants left", last_count, 1);
+		ensure("red pants", mayMatch(1, slots));
+
+		// A slot cleared for the prefix stays cleared
+		slots.clear();
+		ensure("prefix", mIndex.findMatches("BLU", slots));
+		ensure("extended", mIndex.findMatches("BLUE SHIRT", slots));
+		ensure("red shirt was cleared by the prefix", !mayMatch(0, slots));
+		ensure("blue shirt", mayMatch(3, slots));
+	}
+
+	template<> template<>
+	void inventorysearchindex_object_t::test<3>()
+	{
+		// Slots handed out after a lookup are past the end of its result
+		addItem("RED SHIRT");
+		addItem("RED PANTS");
+
+		LLInventorySearchIndex::match_slots_t slots;
+		ensure("first lookup", mIndex.findMatches("SHI", slots));
+		ensure_equals("searched slots", slots.size(), (size_t)2);
+
+		Item* added = addItem("GREEN SHIRT");
+		ensure("new slot past the result", added->getSearchIndexSlot() >= (S32)slots.size());
+		ensure("new item not rejected before the next lookup", mayMatch(2, slots));
+
+		// A relabel takes a new slot too, and drops the old one
+		const S32 old_slot = mItems[1].getSearchIndexSlot();
+		setLabel(1, "RED SHIRT TOO");
+		ensure("relabel takes a new slot", mItems[1].getSearchIndexSlot() > old_slot);
+		ensure("relabelled item not rejected", mayMatch(1, slots));
+
+		// Narrowing picks the new slots up
+		ensure("narrowing lookup", mIndex.findMatches("SHIRT", slots));
+		ensureNoFalseNegative("after adding", "SHIRT", slots);
+		ensure_equals("all shirts", countMatches(slots), 3);
+
+		// Unchanged labels keep their slot
+		const S32 slot = mItems[0].getSearchIndexSlot();
+		setLabel(0, "RED SHIRT");
+		ensure_equals("same label keeps its slot", mItems[0].getSearchIndexSlot(), slot);
+
+		mIndex.removeItem(&mItems[2]);
+		ensure_equals("removed", mItems[2].getSearchIndexSlot(), -1);
+		slots.clear();
+		ensure("lookup after remove", mIndex.findMatches("SHIRT", slots));
+		ensure("others still found", mayMatch(0, slots) && mayMatch(1, slots));
+		slots.clear();
+		ensure("lookup of the removed label", mIndex.findMatches("GREEN", slots));
+		ensure("indexed items don't match it", !mayMatch(0, slots) && !mayMatch(1, slots));
+	}
+
+	template<> template<>
+	void inventorysearchindex_object_t::test<4>()
+	{
+		// Compaction renumbers the slots and changes the epoch
+		const S32 COUNT = 600;
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			addItem(llformat("ITEM %d", i));
+		}
+		// More dead slots than live ones compacts
+		const U32 epoch = mIndex.getEpoch();
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			setLabel(i, llformat("OTHER %d", i));
+		}
+		ensure("not compacted yet", mIndex.getEpoch() == epoch);
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			setLabel(i, llformat("RENAMED %d", i));
+		}
+		ensure("compacted", mIndex.getEpoch() != epoch);
+
+		std::vector<bool> used(COUNT * 2, false);
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			const S32 slot = mItems[i].getSearchIndexSlot();
+			ensure("slot in range", slot >= 0 && slot < COUNT * 2);
+			ensure("slot unique", !used[slot]);
+			used[slot] = true;
+		}
+
+		LLInventorySearchIndex::match_slots_t slots;
+		ensure("lookup after compaction", mIndex.findMatches("RENAMED 12", slots));
+		ensureNoFalseNegative("after compaction", "RENAMED 12", slots);
+		ensure_equals("renamed 12x", countMatches(slots), 1 + 10);
+		slots.clear();
+		ensure("old labels", mIndex.findMatches("OTHER", slots));
+		ensure_equals("old labels gone", countMatches(slots), 0);
+
+		// clear() forgets every item
+		const U32 cleared_epoch = mIndex.getEpoch();
+		mIndex.clear();
+		ensure("clear changes the epoch", mIndex.getEpoch() != cleared_epoch);
+		ensure_equals("clear resets slots", mItems[0].getSearchIndexSlot(), -1);
+		ensure_equals("clear resets every slot", mItems[COUNT - 1].getSearchIndexSlot(), -1);
+		slots.clear();
+		ensure("lookup after clear", mIndex.findMatches("REN", slots));
+		ensure("nothing indexed", slots.empty());
+	}
+
+	template<> template<>
+	void inventorysearchindex_object_t::test<5>()
+	{
+		// Labels and substrings shorter than a trigram
+		addItem("");
+		addItem("A");
+		addItem("AB");
+		addItem("ABC");
+		addItem("XABCX");
+
+		LLInventorySearchIndex::match_slots_t slots(1, 1);
+		ensure("short substring can't be looked up", !mIndex.findMatches("AB", slots));
+		ensure("slots left alone", slots.size() == 1 && slots[0]);
+		ensure("empty substring can't be looked up", !mIndex.findMatches("", slots));
+
+		slots.clear();
+		ensure("trigram lookup", mIndex.findMatches("ABC", slots));
+		ensureNoFalseNegative("short labels", "ABC", slots);
+		ensure("empty label can't match", !mayMatch(0, slots));
+		ensure("one byte label can't match", !mayMatch(1, slots));
+		ensure("two byte label can't match", !mayMatch(2, slots));
+		ensure_equals("three byte label and longer", countMatches(slots), 2);
+
+		// A short label that grows is indexed again
+		setLabel(2, "ABCD");
+		slots.clear();
+		ensure("grown label lookup", mIndex.findMatches("BCD", slots));
+		ensure("grown label", mayMatch(2, slots));
+	}
+}
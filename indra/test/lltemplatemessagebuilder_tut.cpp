@@ -32,8 +32,10 @@
 #include "llapr.h"
 #include "llmessagetemplate.h"
 #include "llquaternion.h"
+#include "llrand.h"
 #include "lltemplatemessagebuilder.h"
 #include "lltemplatemessagereader.h"
+#include "lltimer.h"
 #include "llversionserver.h"
 #include "message_prehash.h"
 #include "u64.h"
@@ -105,7 +107,9 @@ namespace tut
 		{
 			numberMap[1] = &messageTemplate;
 			const U32 bufferSize = 1024;
-			U8 buffer[bufferSize];
+			// the reader reads the variables in place, so the buffer
+			// has to outlive it
+			static U8 buffer[bufferSize];
 			// zero out the packet ID field
 			memset(buffer, 0, LL_PACKET_ID_SIZE);
 			U32 builtSize = builder->buildMessage(buffer, bufferSize, offset);
@@ -116,6 +120,97 @@ namespace tut
 			return reader;
 		}
 
+		// Zero codes in, body only, the way LLMessageSystem::zeroCode() does
+		static void zeroCode(const std::vector<U8>& in, std::vector<U8>& out)
+		{
+			out.assign(in.begin(), in.begin() + LL_PACKET_ID_SIZE);
+			out[0] |= LL_ZERO_CODE_FLAG;
+			U32 i = LL_PACKET_ID_SIZE;
+			while (i < in.size())
+			{
+				if (in[i])
+				{
+					out.push_back(in[i++]);
+					continue;
+				}
+				U8 count = 0;
+				while (i < in.size() && !in[i] && count < 255)
+				{
+					++count;
+					++i;
+				}
+				out.push_back(0);
+				out.push_back(count);
+			}
+		}
+
+		// The byte at a time expansion LLMessageSystem::zeroCodeExpand()
+		// used to do, for checking and timing the current one against.
+		// Returns the expanded size or -1.
+		static S32 referenceZeroCodeExpand(const U8* inptr, S32 count, U8* out, S32 out_size)
+		{
+			U8* outptr = out;
+			for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+			{
+				count--;
+				*outptr++ = *inptr++;
+			}
+			while (count--)
+			{
+				if (outptr > out + out_size - 1)
+				{
+					return -1;
+				}
+				if (!((*outptr++ = *inptr++)))
+				{
+					while (((count--)) && (!(*inptr)))
+					{
+						*outptr++ = *inptr++;
+						if (outptr > out + out_size - 256)
+						{
+							return -1;
+						}
+						memset(outptr,0,255);
+						outptr += 255;
+					}
+					if (count < 0)
+					{
+						break;
+					}
+					if (outptr > out + out_size - *inptr)
+					{
+						return -1;
+					}
+					memset(outptr,0,(*inptr) - 1);
+					outptr += ((*inptr) - 1);
+					inptr++;
+				}
+			}
+			return (S32)(outptr - out);
+		}
+
+		// A packet like ObjectUpdate: long runs of zeros between the values
+		static void randomBody(std::vector<U8>& packet, S32 size)
+		{
+			packet.assign(size, 0);
+			for (S32 i = LL_PACKET_ID_SIZE; i < size; )
+			{
+				S32 run = 1 + ll_rand(ll_rand(8) ? 12 : 600);
+				if (ll_rand(2))
+				{
+					for (S32 j = i; j < i + run && j < size; ++j)
+					{
+						packet[j] = (U8)(1 + ll_rand(255));
+					}
+				}
+				i += run;
+			}
+		}
+
+		static void noopHandler(LLMessageSystem*, void**)
+		{
+		}
+
 	};
 	
 	typedef test_group<LLTemplateMessageBuilderTestData>	LLTemplateMessageBuilderTestGroup;
@@ -966,5 +1061,270 @@ namespace tut
 		ensure_equals("Ensure unchanged buffer ", strlen(outBuffer), 0);
 		delete reader;
 	}
-}
 
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<46>()
+		// zero code expansion
+	{
+		// header, 7, 3 zeros, 9, 258 zeros, 0 at the end of the packet
+		const U8 in[] = { LL_ZERO_CODE_FLAG, 0, 0, 0, 1, 0,   7,   0, 3,   9,   0, 0, 2,   0 };
+		U8 out[MAX_BUFFER_SIZE];
+		memset(out, 0xaa, sizeof(out));
+		S32 size = LLMessageSystem::zeroCodeExpandBuffer(in, sizeof(in), out, sizeof(out));
+		ensure_equals("Ensure expanded size", size, LL_PACKET_ID_SIZE + 1 + 3 + 1 + 258 + 1);
+		ensure("Ensure header", memcmp(in, out, LL_PACKET_ID_SIZE) == 0);
+		ensure_equals("Ensure literal", (S32)out[6], 7);
+		ensure_equals("Ensure zero run", (S32)(out[7] | out[8] | out[9]), 0);
+		ensure_equals("Ensure literal after run", (S32)out[10], 9);
+		for (S32 i = 11; i < size; ++i)
+		{
+			ensure_equals("Ensure long zero run", (S32)out[i], 0);
+		}
+		ensure_equals("Ensure nothing past end", (S32)out[size], 0xaa);
+
+		ensure_equals("Ensure overflow fails", 
+					  LLMessageSystem::zeroCodeExpandBuffer(in, sizeof(in), out, 100), -1);
+		ensure_equals("Ensure short packet fails", 
+					  LLMessageSystem::zeroCodeExpandBuffer(in, 3, out, sizeof(out)), -1);
+	}
+
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<47>()
+		// zero code expansion matches the byte at a time version
+	{
+		std::vector<U8> packet, coded;
+		U8 out[MAX_BUFFER_SIZE];
+		U8 ref[MAX_BUFFER_SIZE];
+		for (S32 i = 0; i < 500; ++i)
+		{
+			randomBody(packet, LL_PACKET_ID_SIZE + 1 + ll_rand(MTUBYTES));
+			zeroCode(packet, coded);
+			coded[0] &= ~LL_ZERO_CODE_FLAG;
+			S32 size = LLMessageSystem::zeroCodeExpandBuffer(&coded[0], coded.size(), out, sizeof(out));
+			S32 ref_size = referenceZeroCodeExpand(&coded[0], coded.size(), ref, sizeof(ref));
+			ensure_equals("Ensure same size", size, ref_size);
+			ensure_equals("Ensure original size", size, (S32)packet.size());
+			ensure("Ensure same data", memcmp(out, ref, size) == 0);
+			ensure("Ensure original data", memcmp(out, &packet[0], size) == 0);
+		}
+	}
+
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<48>()
+		// repeated blocks and variable data read in place, and copied back
+	{
+		LLMessageTemplate messageTemplate = defaultTemplate();
+		messageTemplate.addBlock(defaultBlock(MVT_U32, 4, MBT_SINGLE));
+		LLMessageBlock* block = createBlock(_PREHASH_Test1, MVT_U16, 2);
+		block->addVariable(_PREHASH_Test1, MVT_VARIABLE, 1);
+		messageTemplate.addBlock(block);
+
+		LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+		builder->addU32(_PREHASH_Test0, 0xdeadbeef);
+		const char* strings[] = { "one", "", "three" };
+		for (U16 i = 0; i < 3; ++i)
+		{
+			builder->nextBlock(_PREHASH_Test1);
+			builder->addU16(_PREHASH_Test0, i + 100);
+			builder->addString(_PREHASH_Test1, strings[i]);
+		}
+		LLTemplateMessageReader* reader = setReader(messageTemplate, builder);
+
+		for (S32 pass = 0; pass < 2; ++pass)
+		{
+			U32 outU32;
+			reader->getU32(_PREHASH_Test0, _PREHASH_Test0, outU32);
+			ensure_equals("Ensure single block value", outU32, 0xdeadbeef);
+			ensure_equals("Ensure repeat count", reader->getNumberOfBlocks(_PREHASH_Test1), 3);
+			ensure_equals("Ensure missing block", reader->getNumberOfBlocks(_PREHASH_Test2), 0);
+			for (S32 i = 0; i < 3; ++i)
+			{
+				U16 outU16;
+				std::string outString;
+				reader->getU16(_PREHASH_Test1, _PREHASH_Test0, outU16, i);
+				reader->getString(_PREHASH_Test1, _PREHASH_Test1, outString, i);
+				ensure_equals("Ensure repeated value", (S32)outU16, i + 100);
+				ensure_equals("Ensure repeated string", outString, std::string(strings[i]));
+				ensure_equals("Ensure variable size", 
+							  reader->getSize(_PREHASH_Test1, i, _PREHASH_Test1), 
+							  (S32)strlen(strings[i]) + 1);
+			}
+			ensure_equals("Ensure block past repeat count", 
+						  reader->getSize(_PREHASH_Test1, 3, _PREHASH_Test1), 
+						  LL_BLOCK_NOT_IN_MESSAGE);
+			ensure_equals("Ensure unknown variable", 
+						  reader->getSize(_PREHASH_Test0, _PREHASH_Test2), 
+						  LL_VARIABLE_NOT_IN_BLOCK);
+
+			// the second pass reads the message rebuilt from the first
+			builder = new LLTemplateMessageBuilder(nameMap);
+			builder->newMessage(_PREHASH_TestMessage);
+			reader->copyToBuilder(*builder);
+			delete reader;
+			reader = setReader(messageTemplate, builder);
+		}
+		delete reader;
+	}
+
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<49>()
+		// variable data running past the end of the packet reads as empty
+	{
+		LLMessageTemplate messageTemplate = defaultTemplate();
+		messageTemplate.addBlock(defaultBlock(MVT_U32, 4, MBT_SINGLE));
+		messageTemplate.addBlock(createBlock(_PREHASH_Test1, MVT_VARIABLE, 1, MBT_SINGLE));
+		LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+		builder->addU32(_PREHASH_Test0, 0xbbbbbbbb);
+		builder->nextBlock(_PREHASH_Test1);
+		builder->addString(_PREHASH_Test0, "a string longer than what arrives");
+		const U32 bufferSize = 1024;
+		U8 buffer[bufferSize];
+		memset(buffer, 0, LL_PACKET_ID_SIZE);
+		U32 builtSize = builder->buildMessage(buffer, bufferSize, 0);
+		delete builder;
+
+		numberMap[1] = &messageTemplate;
+		LLTemplateMessageReader* reader = new LLTemplateMessageReader(numberMap);
+		reader->validateMessage(buffer, builtSize - 10, LLHost());
+		reader->readMessage(buffer, LLHost());
+		U32 outValue;
+		reader->getU32(_PREHASH_Test0, _PREHASH_Test0, outValue);
+		ensure_equals("Ensure present value", outValue, 0xbbbbbbbb);
+		ensure_equals("Ensure truncated data is empty", 
+					  reader->getSize(_PREHASH_Test1, _PREHASH_Test0), 0);
+		delete reader;
+	}
+
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<50>()
+		// Benchmark: zero code expansion and decoding of a capture
+	{
+		// Replays the capture named by LL_MESSAGE_CAPTURE (see 
+		// LLMessageSystem::startPacketCapture()) for expansion, or a
+		// generated one in the same format with ObjectUpdate like packets
+		// that are also decoded. Informational only, timings vary too 
+		// much between machines to assert on.
+		LLMessageTemplate messageTemplate = defaultTemplate();
+		messageTemplate.addBlock(defaultBlock(MVT_U32, 4, MBT_SINGLE));
+		LLMessageBlock* block = createBlock(_PREHASH_Test1, MVT_U32, 4);
+		block->addVariable(_PREHASH_Test1, MVT_LLUUID, 16);
+		block->addVariable(_PREHASH_Test2, MVT_VARIABLE, 1);
+		messageTemplate.addBlock(block);
+		messageTemplate.setHandlerFunc(noopHandler, NULL);
+		numberMap[1] = &messageTemplate;
+
+		std::string filename;
+		const char* capture = getenv("LL_MESSAGE_CAPTURE");
+		bool generated = !capture || !*capture;
+		if (generated)
+		{
+			filename = "llmessagecapture.tmp";
+			LLFILE* fp = LLFile::fopen(filename, "wb");
+			ensure("Ensure capture created", fp != NULL);
+			std::vector<U8> packet, coded;
+			for (S32 i = 0; i < 1000; ++i)
+			{
+				LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+				builder->addU32(_PREHASH_Test0, i);
+				for (S32 b = 0; b < 8; ++b)
+				{
+					std::vector<U8> data;
+					randomBody(data, 120);
+					builder->nextBlock(_PREHASH_Test1);
+					builder->addU32(_PREHASH_Test0, b);
+					builder->addUUID(_PREHASH_Test1, LLUUID::null);
+					builder->addBinaryData(_PREHASH_Test2, &data[0], 120);
+				}
+				packet.resize(MAX_BUFFER_SIZE);
+				memset(&packet[0], 0, LL_PACKET_ID_SIZE);
+				packet.resize(builder->buildMessage(&packet[0], MAX_BUFFER_SIZE, 0));
+				delete builder;
+				zeroCode(packet, coded);
+
+				U32 size = htonl(coded.size());
+				fwrite(&size, sizeof(size), 1, fp);
+				fwrite(&coded[0], coded.size(), 1, fp);
+			}
+			fclose(fp);
+		}
+		else
+		{
+			filename = capture;
+		}
+
+		std::vector<std::vector<U8> > packets;
+		LLFILE* fp = LLFile::fopen(filename, "rb");
+		ensure("Ensure capture opened", fp != NULL);
+		std::vector<U8> packet;
+		while (LLMessageSystem::readCapturedPacket(fp, packet))
+		{
+			if (packet.size() > LL_PACKET_ID_SIZE && (packet[0] & LL_ZERO_CODE_FLAG))
+			{
+				packet[0] &= ~LL_ZERO_CODE_FLAG;
+				packets.push_back(packet);
+			}
+		}
+		fclose(fp);
+		if (generated)
+		{
+			LLFile::remove(filename);
+		}
+		if (packets.empty())
+		{
+			skip("no zero coded packets in the capture");
+		}
+
+		const S32 loops = 20;
+		static U8 out[MAX_BUFFER_SIZE];
+		LLTimer timer;
+		F64 reference_time = 0.0;
+		F64 expand_time = 0.0;
+		F64 decode_time = 0.0;
+		S64 bytes = 0;
+		LLTemplateMessageReader reader(numberMap);
+		for (S32 l = 0; l < loops; ++l)
+		{
+			timer.reset();
+			for (U32 i = 0; i < packets.size(); ++i)
+			{
+				referenceZeroCodeExpand(&packets[i][0], packets[i].size(), out, MAX_BUFFER_SIZE);
+			}
+			reference_time += timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (U32 i = 0; i < packets.size(); ++i)
+			{
+				bytes += LLMessageSystem::zeroCodeExpandBuffer(&packets[i][0], packets[i].size(), out, MAX_BUFFER_SIZE);
+			}
+			expand_time += timer.getElapsedTimeF64();
+
+			if (generated)
+			{
+				timer.reset();
+				for (U32 i = 0; i < packets.size(); ++i)
+				{
+					S32 size = LLMessageSystem::zeroCodeExpandBuffer(&packets[i][0], packets[i].size(), out, MAX_BUFFER_SIZE);
+					reader.clearMessage();
+					reader.validateMessage(out, size, LLHost());
+					reader.readMessage(out, LLHost());
+					for (S32 b = 0; b < reader.getNumberOfBlocks(_PREHASH_Test1); ++b)
+					{
+						U8 data[120];
+						reader.getBinaryData(_PREHASH_Test1, _PREHASH_Test2, data, 0, b, sizeof(data));
+					}
+				}
+				decode_time += timer.getElapsedTimeF64();
+			}
+		}
+
+		llinfos << "Zero code expansion of " << packets.size() << " packets, "
+				<< bytes / loops << " bytes: byte at a time "
+				<< reference_time * 1000.0 / loops << " ms, word at a time "
+				<< expand_time * 1000.0 / loops << " ms" << llendl;
+		if (generated)
+		{
+			llinfos << "Expansion and decoding of " << packets.size() << " packets "
+					<< decode_time * 1000.0 / loops << " ms" << llendl;
+		}
+	}
+}